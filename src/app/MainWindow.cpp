@@ -48,7 +48,8 @@ static bool IsWhitespaceOnly(const std::wstring& text) {
 // Constructor
 //------------------------------------------------------------------------------
 MainWindow::MainWindow()
-    : m_settingsManager(std::make_unique<SettingsManager>())
+    : m_scheduler(std::make_unique<TaskScheduler>())
+    , m_settingsManager(std::make_unique<SettingsManager>())
     , m_dialogManager(std::make_unique<DialogManager>())
     , m_findBar(std::make_unique<FindBar>())
     , m_lineNumbersGutter(std::make_unique<LineNumbersGutter>())
@@ -59,6 +60,7 @@ MainWindow::MainWindow()
     , m_noteStore(std::make_unique<NoteStore>())
     , m_hotkeyManager(std::make_unique<GlobalHotkeyManager>())
 {
+    FileIO::SetDecodeScheduler(m_scheduler.get());
 }
 
 //------------------------------------------------------------------------------
@@ -184,11 +186,24 @@ int MainWindow::Run() {
             continue;
         }
         
+        // Check for Find in Files window messages
+        if (m_findInFilesWindow && m_findInFilesWindow->IsDialogMessage(&msg)) {
+            continue;
+        }
+        
         // Check for dialog messages
         if (m_dialogManager->IsDialogMessage(&msg)) {
             continue;
         }
         
+        // Esc cancels a file that is still loading into the active tab
+        if (msg.message == WM_KEYDOWN && msg.wParam == VK_ESCAPE && m_documentManager &&
+            m_documentManager->IsLoading(m_documentManager->GetActiveTabId()) &&
+            (msg.hwnd == m_hwnd || IsChild(m_hwnd, msg.hwnd))) {
+            CancelActiveFileLoad();
+            continue;
+        }
+        
         // Translate accelerators only when the main window or its children have focus.
         // Sub-windows (NoteListWindow, CaptureWindow, etc.) are independent top-level
         // windows and need to receive their own keyboard messages (DEL, Ctrl+A, etc.)
@@ -321,6 +336,30 @@ LRESULT MainWindow::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam) {
             }
             return 0;
 
+        case WM_APP_PREFETCHDONE:
+            // Restored tab content read by the prefetch thread (lParam is an
+            // allocated PendingContentResult; the document manager owns it)
+            if (lParam) {
+                auto* result = reinterpret_cast<PendingContentResult*>(lParam);
+                if (m_documentManager) {
+                    m_documentManager->OnPrefetchComplete(result);
+                } else {
+                    delete result;
+                }
+            }
+            return 0;
+
+        case WM_APP_FILELOAD:
+            // Chunk or completion of an asynchronous file open (lParam is an
+            // allocated FileLoadUpdate; the handler owns it)
+            OnFileLoadUpdate(reinterpret_cast<FileLoadUpdate*>(lParam));
+            return 0;
+
+        case WM_APP_RUNTASKS:
+            // Continuations queued by background tasks
+            m_scheduler->RunUiContinuations();
+            return 0;
+
         case WM_DPICHANGED: {
             // Top-level window receives this when moved to a monitor with different DPI
             UINT newDpi = HIWORD(wParam);
@@ -365,6 +404,10 @@ void MainWindow::OnCreate() {
     BOOL useDarkTitleBar = TRUE;
     DwmSetWindowAttribute(m_hwnd, DWMWA_USE_IMMERSIVE_DARK_MODE, &useDarkTitleBar, sizeof(useDarkTitleBar));
     
+    // Continuations from background tasks run on this thread
+    HWND hwnd = m_hwnd;
+    m_scheduler->SetUiWakeCallback([hwnd]() { PostMessageW(hwnd, WM_APP_RUNTASKS, 0, 0); });
+    
     // Create status bar
     CreateStatusBar();
     
@@ -377,6 +420,7 @@ void MainWindow::OnCreate() {
     
     // Initialize document manager (creates per-tab editors internally)
     m_documentManager->Initialize(m_hwnd, m_hInstance, m_tabBar.get(), m_settingsManager.get());
+    m_documentManager->SetLargeFileViewCallback(OnLargeFileViewState, this);
     
     // Set up tab bar callbacks
     m_tabBar->SetCallback([this](TabNotification notification, int tabId) {
@@ -449,6 +493,7 @@ void MainWindow::OnCreate() {
     if (!m_findBar->Create(m_hwnd, m_hInstance, m_editor)) {
         MessageBoxW(m_hwnd, L"Failed to create find bar.", L"Error", MB_OK | MB_ICONERROR);
     }
+    m_findBar->SetFindAllHandler(OnFindBarFindAll, this);
     
     // Initialize dialog manager
     m_dialogManager->Initialize(m_hwnd, m_hInstance, m_editor, 
@@ -522,7 +567,10 @@ void MainWindow::OnDestroy() {
     KillTimer(m_hwnd, TIMER_REALSAVE);
     KillTimer(m_hwnd, TIMER_UPDATECHECK);
     
-    // Save session before destroying
+    // Stop background session prefetch, then save session before destroying
+    if (m_documentManager) {
+        m_documentManager->CancelPrefetch();
+    }
     SaveSession();
     
     // Clean up system tray
@@ -538,6 +586,11 @@ void MainWindow::OnDestroy() {
         AutoSaveCurrentNote();
     }
     
+    // Write out everything the note store still has queued
+    if (m_noteStore) {
+        m_noteStore->Shutdown();
+    }
+    
     // Unregister global hotkey
     if (m_hotkeyManager) {
         m_hotkeyManager->Unregister();
@@ -553,6 +606,9 @@ void MainWindow::OnDestroy() {
         m_characterMap->Close();
     }
     
+    // Stop a running Find in Files search
+    m_findInFilesWindow.reset();
+    
     // Save window position
     WINDOWPLACEMENT wp = {};
     wp.length = sizeof(wp);
@@ -576,6 +632,16 @@ void MainWindow::OnDestroy() {
     // Save settings
     (void)m_settingsManager->Save();
     
+    // Let running background tasks finish and drop the queued ones
+    FileIO::SetDecodeScheduler(nullptr);
+    m_scheduler->Shutdown();
+    
+    // Performance trace requested with --trace
+    if (!m_traceOutputPath.empty()) {
+        std::wstring error;
+        (void)WriteTraceFiles(m_traceOutputPath, error);
+    }
+    
     // Clean up - DocumentManager owns all editors, will clean up on destruction
     m_editor = nullptr;
     
@@ -613,7 +679,7 @@ void MainWindow::OnClose() {
         auto ids = m_documentManager->GetAllTabIds();
         for (int id : ids) {
             auto* doc = m_documentManager->GetDocument(id);
-            if (doc && doc->isModified && !(doc->isNewFile && doc->editor && IsWhitespaceOnly(doc->editor->GetText()))) {
+            if (doc && doc->isModified && !(doc->isNewFile && IsWhitespaceOnly(m_documentManager->GetDocumentText(id)))) {
                 if (!settings.promptSaveOnClose) {
                     // Skip the dialog - just discard changes
                     continue;
@@ -701,6 +767,8 @@ void MainWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
         case IDM_EDIT_FINDNEXT:  OnEditFindNext(); break;
         case IDM_EDIT_REPLACE:   OnEditReplace(); break;
         case IDM_EDIT_GOTO:      OnEditGoTo(); break;
+        case IDM_EDIT_FINDINFILES: OnEditFindInFiles(); break;
+        case IDM_EDIT_FINDINTABS: OnEditFindInTabs(); break;
         case IDM_EDIT_DATETIME:  OnEditDateTime(); break;
         
         // Format menu
@@ -726,6 +794,10 @@ void MainWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
         case IDM_ENCODING_UTF16LE:  OnEncodingChange(TextEncoding::UTF16_LE); break;
         case IDM_ENCODING_UTF16BE:  OnEncodingChange(TextEncoding::UTF16_BE); break;
         case IDM_ENCODING_ANSI:     OnEncodingChange(TextEncoding::ANSI); break;
+        case IDM_ENCODING_CP1251:   OnEncodingChange(TextEncoding::Windows1251); break;
+        case IDM_ENCODING_CP1252:   OnEncodingChange(TextEncoding::Windows1252); break;
+        case IDM_ENCODING_SHIFTJIS: OnEncodingChange(TextEncoding::ShiftJIS); break;
+        case IDM_ENCODING_GB18030:  OnEncodingChange(TextEncoding::GB18030); break;
         
         // Reopen with encoding
         case IDM_ENCODING_REOPEN_UTF8:    OnReopenWithEncoding(TextEncoding::UTF8); break;
@@ -733,6 +805,10 @@ void MainWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
         case IDM_ENCODING_REOPEN_UTF16LE: OnReopenWithEncoding(TextEncoding::UTF16_LE); break;
         case IDM_ENCODING_REOPEN_UTF16BE: OnReopenWithEncoding(TextEncoding::UTF16_BE); break;
         case IDM_ENCODING_REOPEN_ANSI:    OnReopenWithEncoding(TextEncoding::ANSI); break;
+        case IDM_ENCODING_REOPEN_CP1251:  OnReopenWithEncoding(TextEncoding::Windows1251); break;
+        case IDM_ENCODING_REOPEN_CP1252:  OnReopenWithEncoding(TextEncoding::Windows1252); break;
+        case IDM_ENCODING_REOPEN_SHIFTJIS: OnReopenWithEncoding(TextEncoding::ShiftJIS); break;
+        case IDM_ENCODING_REOPEN_GB18030: OnReopenWithEncoding(TextEncoding::GB18030); break;
         
         // Help menu
         case IDM_HELP_ABOUT: OnHelpAbout(); break;
@@ -760,8 +836,10 @@ void MainWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
         case IDM_EDIT_LOWERCASE:         OnEditLowercase(); break;
         case IDM_EDIT_SORTLINES_ASC:     OnEditSortLines(true); break;
         case IDM_EDIT_SORTLINES_DESC:    OnEditSortLines(false); break;
+        case IDM_EDIT_SORTLINES_CUSTOM:  OnEditSortLinesCustom(); break;
         case IDM_EDIT_TRIMWHITESPACE:    OnEditTrimWhitespace(); break;
         case IDM_EDIT_REMOVEDUPLICATES:  OnEditRemoveDuplicateLines(); break;
+        case IDM_EDIT_DEDUPELINES_CUSTOM: OnEditDedupeLinesCustom(); break;
         
         // Edit menu (additional 2)
         case IDM_EDIT_TITLECASE:         OnEditTitleCase(); break;
@@ -807,6 +885,7 @@ void MainWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
         case IDM_TOOLS_INSERTFILEPATH:   OnToolsInsertFilePath(); break;
         case IDM_TOOLS_CONVERTEOL_SEL:   OnToolsConvertEolSelection(); break;
         case IDM_TOOLS_CHECKSUM:         OnToolsChecksum(); break;
+        case IDM_TOOLS_DUMPTRACE:        OnToolsDumpTrace(); break;
         case IDM_TOOLS_RUNSELECTION:     OnToolsRunSelection(); break;
         case IDM_TOOLS_CHARMAP:          OnToolsCharacterMap(); break;
         case IDM_TOOLS_CLIPHISTORY:      OnToolsClipboardHistory(); break;
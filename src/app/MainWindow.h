@@ -24,6 +24,8 @@
 #include "CaptureWindow.h"
 #include "NoteListWindow.h"
 #include "FindBar.h"
+#include "FindInFilesWindow.h"
+#include "TaskScheduler.h"
 #include "LineNumbersGutter.h"
 #include "TabBar.h"
 #include "DocumentManager.h"
@@ -31,6 +33,9 @@
 #include "PrintPreviewWindow.h"
 #include "CharacterMap.h"
 #include "ClipboardHistory.h"
+#include "LineTransform.h"
+#include "LineSort.h"
+#include "LineDedupe.h"
 
 namespace QNote {
 
@@ -57,6 +62,9 @@ public:
     // Get window handle
     [[nodiscard]] HWND GetHandle() const noexcept { return m_hwnd; }
     
+    // Write the performance trace here when the window closes (--trace)
+    void SetTraceOutputPath(const std::wstring& path) { m_traceOutputPath = path; }
+    
 private:
     // Window procedure
     static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -113,6 +121,13 @@ private:
     void OnEditReplace();
     void OnEditGoTo();
     void OnEditDateTime();
+    void OnEditFindInFiles();
+    void OnEditFindInTabs();
+    bool EnsureFindInFilesWindow();
+    void SearchOpenTabs(const std::wstring& pattern, const FindOptions& options);
+    static void OnFindBarFindAll(void* userData, const std::wstring& text, const FindOptions& options);
+    void OpenFindInFilesHit(const std::wstring& filePath, int line, int column, int length);
+    void OpenTabSearchHit(int tabId, int line, int column, int length);
     
     // Format operations
     void OnFormatWordWrap();
@@ -152,13 +167,19 @@ private:
     void OnEditLowercase();
     void OnEditTitleCase();
     void OnEditSortLines(bool ascending);
+    void OnEditSortLinesCustom();
     void OnEditTrimWhitespace();
     void OnEditRemoveDuplicateLines();
+    void OnEditDedupeLinesCustom();
     void OnEditReverseLines();
     void OnEditReverseSelection();
     void OnEditNumberLines();
     void OnEditToggleComment();
     
+    // Run a line pipeline over the selection (or whole document) and apply
+    // the result as a single minimal, undoable replacement
+    void ApplyLinePipeline(const LinePipeline& pipeline, bool useSelection);
+    
     // Bookmark operations
     void OnEditToggleBookmark();
     void OnEditNextBookmark();
@@ -192,12 +213,16 @@ private:
     void OnToolsRunSelection();
     void OnToolsCharacterMap();
     void OnToolsClipboardHistory();
+    void OnToolsDumpTrace();
+    bool WriteTraceFiles(const std::wstring& jsonPath, std::wstring& errorMessage);
     
     // Tools dialog procs
     static INT_PTR CALLBACK AutoSaveDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
     static INT_PTR CALLBACK SplitLinesDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
     static INT_PTR CALLBACK ConvertEolDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
     static INT_PTR CALLBACK RunOutputDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
+    static INT_PTR CALLBACK SortLinesDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
+    static INT_PTR CALLBACK DedupeLinesDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam);
     
     // Notes operations
     void OnNotesNew();
@@ -222,6 +247,20 @@ private:
     void UpdateRecentFilesMenu();
     bool PromptSaveChanges();
     bool LoadFile(const std::wstring& filePath);
+    bool OpenFileInNewTab(const std::wstring& filePath);
+    
+    // Asynchronous file open (files above DocumentManager::ASYNC_LOAD_THRESHOLD)
+    bool BeginAsyncLoad(const std::wstring& filePath);
+    void OnFileLoadUpdate(FileLoadUpdate* update);
+    void CancelActiveFileLoad();
+    
+    // Read-only viewer for files above AppSettings::largeFileViewerMB
+    bool OpenLargeFileView(const std::wstring& filePath);
+    [[nodiscard]] LargeFileView* GetActiveLargeFileView() const;
+    static void OnLargeFileViewState(void* userData);
+    static bool OnLargeFileViewFind(void* userData, const std::wstring& text,
+                                    const FindOptions& options, bool forward);
+    
     bool SaveFile(const std::wstring& filePath);
     void NewDocument();
     
@@ -274,10 +313,12 @@ private:
     HACCEL m_hAccel = nullptr;
     
     // Core components
+    std::unique_ptr<TaskScheduler> m_scheduler;  // Background work for every subsystem
     std::unique_ptr<SettingsManager> m_settingsManager;
     Editor* m_editor = nullptr;  // Points to active tab's editor (owned by DocumentManager)
     std::unique_ptr<DialogManager> m_dialogManager;
     std::unique_ptr<FindBar> m_findBar;
+    std::unique_ptr<FindInFilesWindow> m_findInFilesWindow;  // Created on first use
     std::unique_ptr<LineNumbersGutter> m_lineNumbersGutter;
     std::unique_ptr<TabBar> m_tabBar;
     std::unique_ptr<DocumentManager> m_documentManager;
@@ -300,6 +341,9 @@ private:
     std::wstring m_currentFile;
     bool m_isNewFile = true;
     
+    // Performance trace written on exit (empty = none)
+    std::wstring m_traceOutputPath;
+    
     // Print settings
     PAGESETUPDLGW m_pageSetup = {};
     
@@ -319,6 +363,10 @@ private:
     FILETIME m_lastWriteTime = {};
     bool m_ignoreNextFileChange = false;
     
+    // Last options used by Sort Lines / Duplicate Lines (Custom)
+    LineSortOptions m_sortOptions;
+    LineDedupeOptions m_dedupeOptions;
+    
     // Status bar parts widths
     static constexpr int STATUS_PARTS = 5;
     int m_statusPartWidths[STATUS_PARTS] = { 200, 100, 80, 60, -1 };
@@ -332,6 +380,9 @@ private:
     // File change monitoring interval (ms) - every 2 seconds
     static constexpr UINT FILEWATCH_INTERVAL = 2000;
     
+    // Restored tabs read in the background after session restore
+    static constexpr size_t SESSION_PREFETCH_TABS = 4;
+    
     // Window class name
     static constexpr wchar_t WINDOW_CLASS[] = L"QNoteMainWindow";
 };
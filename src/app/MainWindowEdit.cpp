@@ -5,9 +5,7 @@
 
 #include "MainWindow.h"
 #include "resource.h"
-#include <sstream>
 #include <algorithm>
-#include <set>
 
 namespace QNote {
 
@@ -30,6 +28,10 @@ void MainWindow::OnEditCut() {
 }
 
 void MainWindow::OnEditCopy() {
+    if (LargeFileView* view = GetActiveLargeFileView()) {
+        view->Copy();
+        return;
+    }
     if (!m_editor) return;
     m_editor->Copy();
 }
@@ -72,6 +74,16 @@ void MainWindow::OnEditReplace() {
 
 void MainWindow::OnEditGoTo() {
     if (!m_editor) return;
+    
+    // The Go To dialog takes an int; larger line numbers are clamped
+    if (LargeFileView* view = GetActiveLargeFileView()) {
+        uint64_t lineCount = view->GetLineCount();
+        int lineNumber = static_cast<int>((std::min<uint64_t>)(view->GetCurrentLine() + 1, INT_MAX));
+        if (m_dialogManager->ShowGoToDialog(lineNumber) && lineNumber > 0 && lineCount > 0) {
+            view->GoToLine(static_cast<uint64_t>(lineNumber - 1));
+        }
+        return;
+    }
     int lineNumber = m_editor->GetCurrentLine() + 1;
     
     if (m_dialogManager->ShowGoToDialog(lineNumber)) {
@@ -79,6 +91,79 @@ void MainWindow::OnEditGoTo() {
     }
 }
 
+//------------------------------------------------------------------------------
+// Edit -> Find in Files.  The window is created on first use; the selection
+// (if on one line) and the current file's folder prefill the fields.
+//------------------------------------------------------------------------------
+bool MainWindow::EnsureFindInFilesWindow() {
+    if (m_findInFilesWindow) return true;
+
+    auto window = std::make_unique<FindInFilesWindow>();
+    if (!window->Create(m_hInstance, m_hwnd, *m_scheduler)) return false;
+    window->SetOpenCallback([this](const std::wstring& filePath, int line, int column, int length) {
+        OpenFindInFilesHit(filePath, line, column, length);
+    });
+    window->SetTabCallbacks(
+        [this]() { return m_documentManager->GetSearchSources(); },
+        [this](int tabId, int line, int column, int length) {
+            OpenTabSearchHit(tabId, line, column, length);
+        });
+    m_findInFilesWindow = std::move(window);
+    return true;
+}
+
+void MainWindow::OnEditFindInFiles() {
+    if (!EnsureFindInFilesWindow()) return;
+
+    std::wstring pattern;
+    if (m_editor && !GetActiveLargeFileView()) {
+        pattern = m_editor->GetSelectedText();
+        if (pattern.find_first_of(L"\r\n") != std::wstring::npos) pattern.clear();
+    }
+
+    std::wstring folder;
+    if (!m_isNewFile && !m_currentFile.empty()) {
+        size_t slash = m_currentFile.find_last_of(L"\\/");
+        if (slash != std::wstring::npos) folder = m_currentFile.substr(0, slash);
+    }
+
+    m_findInFilesWindow->Show(pattern, folder);
+}
+
+//------------------------------------------------------------------------------
+// Search every open tab for the selection, or the find bar text
+//------------------------------------------------------------------------------
+void MainWindow::OnEditFindInTabs() {
+    std::wstring pattern;
+    if (m_editor && !GetActiveLargeFileView()) {
+        pattern = m_editor->GetSelectedText();
+        if (pattern.find_first_of(L"\r\n") != std::wstring::npos) pattern.clear();
+    }
+    if (pattern.empty() && m_findBar) {
+        pattern = m_findBar->GetSearchText();
+    }
+
+    SearchOpenTabs(pattern, m_findBar ? m_findBar->GetOptions() : FindOptions{});
+}
+
+void MainWindow::SearchOpenTabs(const std::wstring& pattern, const FindOptions& options) {
+    if (!EnsureFindInFilesWindow()) return;
+
+    TextSearchOptions searchOptions;
+    searchOptions.matchCase = options.matchCase;
+    searchOptions.wholeWord = options.wholeWord;
+    searchOptions.useRegex = options.useRegex;
+    m_findInFilesWindow->SearchOpenDocuments(pattern, searchOptions);
+}
+
+// Find bar "All" button
+void MainWindow::OnFindBarFindAll(void* userData, const std::wstring& text, const FindOptions& options) {
+    MainWindow* self = static_cast<MainWindow*>(userData);
+    if (self) {
+        self->SearchOpenTabs(text, options);
+    }
+}
+
 void MainWindow::OnEditDateTime() {
     if (!m_editor) return;
     m_editor->InsertDateTime();
@@ -138,120 +223,201 @@ void MainWindow::OnEditLowercase() {
 }
 
 //------------------------------------------------------------------------------
-// Edit -> Sort Lines (ascending or descending)
+// Run a line pipeline and apply its output as one minimal replacement.
+// With useSelection the pipeline sees the selected text when there is a
+// selection; otherwise it always sees the whole document.
 //------------------------------------------------------------------------------
-void MainWindow::OnEditSortLines(bool ascending) {
+void MainWindow::ApplyLinePipeline(const LinePipeline& pipeline, bool useSelection) {
     if (!m_editor) return;
-    std::wstring text = m_editor->GetText();
+
+    DWORD selStart = 0, selEnd = 0;
+    m_editor->GetSelection(selStart, selEnd);
+    if (selStart > selEnd) std::swap(selStart, selEnd);
+    bool hasSelection = useSelection && selStart != selEnd;
+
+    std::wstring text = hasSelection ? m_editor->GetSelectedText() : m_editor->GetText();
     if (text.empty()) return;
-    
-    // Split into lines
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        // Remove trailing \r if present
-        if (!line.empty() && line.back() == L'\r') {
-            line.pop_back();
-        }
-        lines.push_back(line);
-    }
-    
-    // Sort
-    if (ascending) {
-        std::sort(lines.begin(), lines.end(), [](const std::wstring& a, const std::wstring& b) {
-            return _wcsicmp(a.c_str(), b.c_str()) < 0;
-        });
-    } else {
-        std::sort(lines.begin(), lines.end(), [](const std::wstring& a, const std::wstring& b) {
-            return _wcsicmp(a.c_str(), b.c_str()) > 0;
-        });
+
+    std::wstring result = pipeline.Run(text);
+    TextEdit edit = ComputeMinimalEdit(text, result);
+    if (edit.IsNoOp()) return;
+
+    // Replace only the changed span so the undo checkpoint and the
+    // RichEdit reflow cover as little text as possible
+    DWORD base = hasSelection ? selStart : 0;
+    DWORD editStart = base + static_cast<DWORD>(edit.start);
+    m_editor->PushUndoCheckpoint(EditAction::Other);
+    m_editor->SetSelection(editStart, editStart + static_cast<DWORD>(edit.removeLength));
+    m_editor->ReplaceSelection(edit.insert);
+
+    if (hasSelection) {
+        // Keep the transformed block selected
+        DWORD caret = 0, unused = 0;
+        m_editor->GetSelection(unused, caret);
+        size_t suffix = text.size() - edit.start - edit.removeLength;
+        m_editor->SetSelection(selStart, caret + static_cast<DWORD>(suffix));
     }
-    
-    // Rejoin with \r\n (RichEdit uses \r internally, but SetText handles it)
-    std::wstring result;
-    result.reserve(text.size());
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) {
-            result += L"\r\n";
+}
+
+//------------------------------------------------------------------------------
+// Edit -> Sort Lines (ascending or descending)
+//------------------------------------------------------------------------------
+void MainWindow::OnEditSortLines(bool ascending) {
+    LineSortOptions options;
+    options.descending = !ascending;
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Sort(options, m_scheduler.get()));
+    ApplyLinePipeline(pipeline, false);
+}
+
+//------------------------------------------------------------------------------
+// Edit -> Sort Lines (Custom): key, order and uniqueness options
+//------------------------------------------------------------------------------
+INT_PTR CALLBACK MainWindow::SortLinesDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+        case WM_INITDIALOG: {
+            SetWindowLongPtrW(hDlg, DWLP_USER, lParam);
+            const auto* options = reinterpret_cast<const LineSortOptions*>(lParam);
+            CheckDlgButton(hDlg, IDC_SORT_DESCENDING, options->descending ? BST_CHECKED : BST_UNCHECKED);
+            CheckDlgButton(hDlg, IDC_SORT_CASESENSITIVE, options->caseSensitive ? BST_CHECKED : BST_UNCHECKED);
+            CheckDlgButton(hDlg, IDC_SORT_NATURAL, options->natural ? BST_CHECKED : BST_UNCHECKED);
+            CheckDlgButton(hDlg, IDC_SORT_UNIQUE, options->unique ? BST_CHECKED : BST_UNCHECKED);
+            SetDlgItemInt(hDlg, IDC_SORT_COLUMN, static_cast<UINT>(options->column), FALSE);
+            if (options->delimiter == L'\t') {
+                SetDlgItemTextW(hDlg, IDC_SORT_DELIMITER, L"\\t");
+            } else if (options->delimiter != 0) {
+                wchar_t delim[2] = { options->delimiter, L'\0' };
+                SetDlgItemTextW(hDlg, IDC_SORT_DELIMITER, delim);
+            }
+            SendDlgItemMessageW(hDlg, IDC_SORT_DELIMITER, EM_LIMITTEXT, 2, 0);
+            return TRUE;
         }
+        case WM_COMMAND:
+            switch (LOWORD(wParam)) {
+                case IDOK: {
+                    auto* options = reinterpret_cast<LineSortOptions*>(GetWindowLongPtrW(hDlg, DWLP_USER));
+                    BOOL success = FALSE;
+                    int column = static_cast<int>(GetDlgItemInt(hDlg, IDC_SORT_COLUMN, &success, FALSE));
+                    if (!success || column > 999) {
+                        MessageBoxW(hDlg, L"Please enter a column between 0 and 999.",
+                                    L"QNote", MB_OK | MB_ICONWARNING);
+                        return TRUE;
+                    }
+                    
+                    // Single character, or "\t" for tab
+                    wchar_t delim[3] = {};
+                    GetDlgItemTextW(hDlg, IDC_SORT_DELIMITER, delim, 3);
+                    wchar_t delimiter = delim[0];
+                    if (delim[0] == L'\\' && delim[1] == L't') {
+                        delimiter = L'\t';
+                    } else if (delim[0] != L'\0' && delim[1] != L'\0') {
+                        MessageBoxW(hDlg, L"The column separator must be a single character (or \\t for tab).",
+                                    L"QNote", MB_OK | MB_ICONWARNING);
+                        return TRUE;
+                    }
+                    
+                    options->descending = IsDlgButtonChecked(hDlg, IDC_SORT_DESCENDING) == BST_CHECKED;
+                    options->caseSensitive = IsDlgButtonChecked(hDlg, IDC_SORT_CASESENSITIVE) == BST_CHECKED;
+                    options->natural = IsDlgButtonChecked(hDlg, IDC_SORT_NATURAL) == BST_CHECKED;
+                    options->unique = IsDlgButtonChecked(hDlg, IDC_SORT_UNIQUE) == BST_CHECKED;
+                    options->column = column;
+                    options->delimiter = delimiter;
+                    EndDialog(hDlg, IDOK);
+                    return TRUE;
+                }
+                case IDCANCEL:
+                    EndDialog(hDlg, IDCANCEL);
+                    return TRUE;
+            }
+            break;
     }
+    return FALSE;
+}
+
+void MainWindow::OnEditSortLinesCustom() {
+    if (!m_editor) return;
+    LineSortOptions options = m_sortOptions;
+    INT_PTR result = DialogBoxParamW(m_hInstance, MAKEINTRESOURCEW(IDD_SORTLINES),
+                                      m_hwnd, SortLinesDlgProc, reinterpret_cast<LPARAM>(&options));
+    if (result != IDOK) return;
+    m_sortOptions = options;
     
-    m_editor->SelectAll();
-    m_editor->ReplaceSelection(result);
+    // Operate on selection if present, otherwise on whole document
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Sort(options, m_scheduler.get()));
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
 // Edit -> Trim Trailing Whitespace
 //------------------------------------------------------------------------------
 void MainWindow::OnEditTrimWhitespace() {
-    if (!m_editor) return;
-    std::wstring text = m_editor->GetText();
-    if (text.empty()) return;
-    
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') {
-            line.pop_back();
-        }
-        // Trim trailing whitespace
-        size_t end = line.find_last_not_of(L" \t");
-        if (end != std::wstring::npos) {
-            line = line.substr(0, end + 1);
-        } else if (!line.empty()) {
-            line.clear();  // Line was all whitespace
-        }
-        lines.push_back(line);
-    }
-    
-    std::wstring result;
-    result.reserve(text.size());
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) {
-            result += L"\r\n";
-        }
-    }
-    
-    m_editor->SelectAll();
-    m_editor->ReplaceSelection(result);
+    LinePipeline pipeline;
+    pipeline.Map(LineTransforms::TrimTrailingWhitespace());
+    ApplyLinePipeline(pipeline, false);
 }
 
 //------------------------------------------------------------------------------
 // Edit -> Remove Duplicate Lines
 //------------------------------------------------------------------------------
 void MainWindow::OnEditRemoveDuplicateLines() {
-    if (!m_editor) return;
-    std::wstring text = m_editor->GetText();
-    if (text.empty()) return;
-    
-    std::vector<std::wstring> lines;
-    std::set<std::wstring> seen;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') {
-            line.pop_back();
-        }
-        if (seen.insert(line).second) {
-            lines.push_back(line);
-        }
-    }
-    
-    std::wstring result;
-    result.reserve(text.size());
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) {
-            result += L"\r\n";
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Dedupe(LineDedupeOptions{}));
+    ApplyLinePipeline(pipeline, false);
+}
+
+//------------------------------------------------------------------------------
+// Edit -> Duplicate Lines (Custom): remove, show or count duplicates
+//------------------------------------------------------------------------------
+INT_PTR CALLBACK MainWindow::DedupeLinesDlgProc(HWND hDlg, UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+        case WM_INITDIALOG: {
+            SetWindowLongPtrW(hDlg, DWLP_USER, lParam);
+            const auto* options = reinterpret_cast<const LineDedupeOptions*>(lParam);
+            int mode = IDC_DEDUPE_REMOVE;
+            if (options->mode == DedupeMode::ShowDuplicates) mode = IDC_DEDUPE_SHOW;
+            else if (options->mode == DedupeMode::CountOccurrences) mode = IDC_DEDUPE_COUNT;
+            CheckRadioButton(hDlg, IDC_DEDUPE_REMOVE, IDC_DEDUPE_COUNT, mode);
+            CheckDlgButton(hDlg, IDC_DEDUPE_IGNORECASE, options->ignoreCase ? BST_CHECKED : BST_UNCHECKED);
+            CheckDlgButton(hDlg, IDC_DEDUPE_IGNORESPACE, options->ignoreWhitespace ? BST_CHECKED : BST_UNCHECKED);
+            return TRUE;
         }
+        case WM_COMMAND:
+            switch (LOWORD(wParam)) {
+                case IDOK: {
+                    auto* options = reinterpret_cast<LineDedupeOptions*>(GetWindowLongPtrW(hDlg, DWLP_USER));
+                    options->mode = DedupeMode::RemoveDuplicates;
+                    if (IsDlgButtonChecked(hDlg, IDC_DEDUPE_SHOW) == BST_CHECKED) {
+                        options->mode = DedupeMode::ShowDuplicates;
+                    } else if (IsDlgButtonChecked(hDlg, IDC_DEDUPE_COUNT) == BST_CHECKED) {
+                        options->mode = DedupeMode::CountOccurrences;
+                    }
+                    options->ignoreCase = IsDlgButtonChecked(hDlg, IDC_DEDUPE_IGNORECASE) == BST_CHECKED;
+                    options->ignoreWhitespace = IsDlgButtonChecked(hDlg, IDC_DEDUPE_IGNORESPACE) == BST_CHECKED;
+                    EndDialog(hDlg, IDOK);
+                    return TRUE;
+                }
+                case IDCANCEL:
+                    EndDialog(hDlg, IDCANCEL);
+                    return TRUE;
+            }
+            break;
     }
+    return FALSE;
+}
+
+void MainWindow::OnEditDedupeLinesCustom() {
+    if (!m_editor) return;
+    LineDedupeOptions options = m_dedupeOptions;
+    INT_PTR result = DialogBoxParamW(m_hInstance, MAKEINTRESOURCEW(IDD_DEDUPELINES),
+                                      m_hwnd, DedupeLinesDlgProc, reinterpret_cast<LPARAM>(&options));
+    if (result != IDOK) return;
+    m_dedupeOptions = options;
     
-    m_editor->SelectAll();
-    m_editor->ReplaceSelection(result);
+    // Operate on selection if present, otherwise on whole document
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Dedupe(options));
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
@@ -278,45 +444,12 @@ void MainWindow::OnEditTitleCase() {
 }
 
 //------------------------------------------------------------------------------
-// Edit -> Reverse Lines
+// Edit -> Reverse Lines (selection if present, otherwise whole document)
 //------------------------------------------------------------------------------
 void MainWindow::OnEditReverseLines() {
-    if (!m_editor) return;
-    // Operate on selection if present, otherwise whole document
-    bool hasSelection = false;
-    DWORD selStart, selEnd;
-    m_editor->GetSelection(selStart, selEnd);
-    hasSelection = (selStart != selEnd);
-
-    std::wstring text = hasSelection ? m_editor->GetSelectedText() : m_editor->GetText();
-    if (text.empty()) return;
-
-    // Split into lines
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        lines.push_back(line);
-    }
-
-    // Reverse
-    std::reverse(lines.begin(), lines.end());
-
-    // Rejoin
-    std::wstring result;
-    result.reserve(text.size());
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) result += L"\r\n";
-    }
-
-    if (hasSelection) {
-        m_editor->ReplaceSelection(result);
-    } else {
-        m_editor->SelectAll();
-        m_editor->ReplaceSelection(result);
-    }
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Reverse());
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
@@ -332,45 +465,12 @@ void MainWindow::OnEditReverseSelection() {
 }
 
 //------------------------------------------------------------------------------
-// Edit -> Number Lines
+// Edit -> Number Lines (selection if present, otherwise whole document)
 //------------------------------------------------------------------------------
 void MainWindow::OnEditNumberLines() {
-    if (!m_editor) return;
-    // Operate on selection if present, otherwise whole document
-    bool hasSelection = false;
-    DWORD selStart, selEnd;
-    m_editor->GetSelection(selStart, selEnd);
-    hasSelection = (selStart != selEnd);
-
-    std::wstring text = hasSelection ? m_editor->GetSelectedText() : m_editor->GetText();
-    if (text.empty()) return;
-
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        lines.push_back(line);
-    }
-
-    // Determine padding width
-    int width = static_cast<int>(std::to_wstring(lines.size()).size());
-
-    std::wstring result;
-    result.reserve(text.size());
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::wstring num = std::to_wstring(i + 1);
-        while (static_cast<int>(num.size()) < width) num = L" " + num;
-        result += num + L": " + lines[i];
-        if (i < lines.size() - 1) result += L"\r\n";
-    }
-
-    if (hasSelection) {
-        m_editor->ReplaceSelection(result);
-    } else {
-        m_editor->SelectAll();
-        m_editor->ReplaceSelection(result);
-    }
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::NumberLines());
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
@@ -402,78 +502,21 @@ void MainWindow::OnEditToggleComment() {
         }
     }
 
-    // Get selected text or current line
-    bool hasSelection = false;
+    // Operate on the selection, or select the current line
     DWORD selStart, selEnd;
     m_editor->GetSelection(selStart, selEnd);
-    hasSelection = (selStart != selEnd);
-
-    std::wstring text;
-    if (hasSelection) {
-        text = m_editor->GetSelectedText();
-    } else {
-        // Select current line
+    if (selStart == selEnd) {
         int line = m_editor->GetCurrentLine();
         int lineStart = m_editor->GetLineIndex(line);
         int lineLen = m_editor->GetLineLength(line);
+        if (lineLen <= 0) return;
         m_editor->SetSelection(static_cast<DWORD>(lineStart),
                                static_cast<DWORD>(lineStart + lineLen));
-        text = m_editor->GetSelectedText();
-    }
-
-    if (text.empty()) return;
-
-    // Split into lines
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        lines.push_back(line);
-    }
-
-    // Check if all non-empty lines are already commented
-    std::wstring trimmedPrefix = commentPrefix;
-    // Remove trailing space for matching
-    while (!trimmedPrefix.empty() && trimmedPrefix.back() == L' ')
-        trimmedPrefix.pop_back();
-
-    bool allCommented = true;
-    for (const auto& l : lines) {
-        // Skip blank lines
-        size_t first = l.find_first_not_of(L" \t");
-        if (first == std::wstring::npos) continue;
-        if (l.substr(first, commentPrefix.size()) != commentPrefix &&
-            l.substr(first, trimmedPrefix.size()) != trimmedPrefix) {
-            allCommented = false;
-            break;
-        }
-    }
-
-    std::wstring result;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        if (allCommented) {
-            // Uncomment
-            size_t first = lines[i].find_first_not_of(L" \t");
-            if (first != std::wstring::npos) {
-                if (lines[i].substr(first, commentPrefix.size()) == commentPrefix) {
-                    lines[i].erase(first, commentPrefix.size());
-                } else if (lines[i].substr(first, trimmedPrefix.size()) == trimmedPrefix) {
-                    lines[i].erase(first, trimmedPrefix.size());
-                }
-            }
-        } else {
-            // Comment
-            size_t first = lines[i].find_first_not_of(L" \t");
-            if (first != std::wstring::npos) {
-                lines[i].insert(first, commentPrefix);
-            }
-        }
-        result += lines[i];
-        if (i < lines.size() - 1) result += L"\r\n";
     }
 
-    m_editor->ReplaceSelection(result);
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::ToggleComment(commentPrefix));
+    ApplyLinePipeline(pipeline, true);
 }
 
 } // namespace QNote
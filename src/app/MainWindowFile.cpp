@@ -48,18 +48,7 @@ void MainWindow::OnDropFiles(HDROP hDrop) {
                 }
             }
             
-            FileReadResult result = FileIO::ReadFile(filePath);
-            if (result.success) {
-                m_documentManager->OpenDocument(
-                    filePath, result.content, result.detectedEncoding, result.detectedLineEnding);
-                UpdateActiveEditor();
-                m_currentFile = filePath;
-                m_isNewFile = false;
-                m_isNoteMode = false;
-                m_currentNoteId.clear();
-                m_settingsManager->AddRecentFile(filePath);
-                UpdateRecentFilesMenu();
-            }
+            (void)OpenFileInNewTab(filePath);
         }
     }
     
@@ -100,27 +89,57 @@ void MainWindow::OnFileOpen() {
             LoadFile(filePath);
         } else {
             // Open in new tab
-            FileReadResult result = FileIO::ReadFile(filePath);
-            if (result.success) {
-                int tabId = m_documentManager->OpenDocument(
-                    filePath, result.content, result.detectedEncoding, result.detectedLineEnding);
-                if (tabId >= 0) {
-                    UpdateActiveEditor();
-                    m_currentFile = filePath;
-                    m_isNewFile = false;
-                    m_isNoteMode = false;
-                    m_currentNoteId.clear();
-                    m_settingsManager->AddRecentFile(filePath);
-                    UpdateRecentFilesMenu();
-                    UpdateTitle();
-                    UpdateStatusBar();
-                }
-            } else {
-                MessageBoxW(m_hwnd, result.errorMessage.c_str(), L"Error Opening File",
-                            MB_OK | MB_ICONERROR);
-            }
+            (void)OpenFileInNewTab(filePath);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Open a Find in Files hit: switch to (or open) the file, then select the
+// match.  A file that is still streaming in is only brought to the front.
+//------------------------------------------------------------------------------
+void MainWindow::OpenFindInFilesHit(const std::wstring& filePath, int line, int column, int length) {
+    int existingTab = m_documentManager->FindDocumentByPath(filePath);
+    if (existingTab >= 0) {
+        OnTabSelected(existingTab);
+    } else {
+        auto* activeDoc = m_documentManager->GetActiveDocument();
+        if (activeDoc && activeDoc->isNewFile && !activeDoc->isModified &&
+            m_editor && IsWhitespaceOnly(m_editor->GetText())) {
+            if (!LoadFile(filePath)) return;
+        } else if (!OpenFileInNewTab(filePath)) {
+            return;
         }
     }
+
+    SetForegroundWindow(m_hwnd);
+    if (m_documentManager->IsLoading(m_documentManager->GetActiveTabId())) return;
+
+    if (LargeFileView* view = GetActiveLargeFileView()) {
+        view->GoToLine(static_cast<uint64_t>(line));
+    } else if (m_editor && line < m_editor->GetLineCount()) {
+        DWORD start = static_cast<DWORD>(m_editor->GetLineIndex(line) + column);
+        m_editor->SetSelection(start, start + static_cast<DWORD>(length));
+        SetFocus(m_editor->GetHandle());
+    }
+}
+
+//------------------------------------------------------------------------------
+// Switch to a tab from the open-documents search and select the hit.  The
+// tab may have been closed or edited since the search ran.
+//------------------------------------------------------------------------------
+void MainWindow::OpenTabSearchHit(int tabId, int line, int column, int length) {
+    if (!m_documentManager->GetDocument(tabId)) return;
+
+    OnTabSelected(tabId);
+    SetForegroundWindow(m_hwnd);
+    if (m_documentManager->IsLoading(tabId) || GetActiveLargeFileView()) return;
+
+    if (m_editor && line < m_editor->GetLineCount()) {
+        DWORD start = static_cast<DWORD>(m_editor->GetLineIndex(line) + column);
+        m_editor->SetSelection(start, start + static_cast<DWORD>(length));
+        SetFocus(m_editor->GetHandle());
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -199,20 +218,7 @@ void MainWindow::OnFileOpenRecent(int index) {
             m_editor && IsWhitespaceOnly(m_editor->GetText())) {
             LoadFile(filePath);
         } else {
-            FileReadResult result = FileIO::ReadFile(filePath);
-            if (result.success) {
-                m_documentManager->OpenDocument(
-                    filePath, result.content, result.detectedEncoding, result.detectedLineEnding);
-                UpdateActiveEditor();
-                m_currentFile = filePath;
-                m_isNewFile = false;
-                m_isNoteMode = false;
-                m_currentNoteId.clear();
-                m_settingsManager->AddRecentFile(filePath);
-                UpdateRecentFilesMenu();
-                UpdateTitle();
-                UpdateStatusBar();
-            }
+            (void)OpenFileInNewTab(filePath);
         }
     }
 }
@@ -275,24 +281,23 @@ bool MainWindow::PromptSaveChanges() {
 // Load file
 //------------------------------------------------------------------------------
 bool MainWindow::LoadFile(const std::wstring& filePath) {
-    // Check file size to decide between normal and streamed read
-    FileReadResult result;
-    {
-        HandleGuard hf(CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
-            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
-        LARGE_INTEGER fsize = {};
-        bool isLarge = (hf.valid() && GetFileSizeEx(hf.get(), &fsize) &&
-                        fsize.QuadPart > 100LL * 1024 * 1024);
-        // Close the probe handle before reading
-        hf = HandleGuard();
-
-        if (isLarge) {
-            result = FileIO::ReadFileLarge(filePath, m_hwndStatus);
-        } else {
-            result = FileIO::ReadFile(filePath);
-        }
+    // Very large files are shown read-only without loading them
+    if (m_documentManager && m_documentManager->UsesLargeFileViewer(filePath)) {
+        return OpenLargeFileView(filePath);
+    }
+    
+    // The tab becomes an ordinary editor again
+    if (m_documentManager) {
+        m_documentManager->DetachLargeFileView(m_documentManager->GetActiveTabId());
+        UpdateActiveEditor();
     }
     
+    // Large files stream in on a worker thread so the UI never blocks
+    if (m_documentManager && FileIO::GetFileSizeBytes(filePath) > DocumentManager::ASYNC_LOAD_THRESHOLD) {
+        return BeginAsyncLoad(filePath);
+    }
+    
+    FileReadResult result = FileIO::ReadFile(filePath);
     if (!result.success) {
         MessageBoxW(m_hwnd, result.errorMessage.c_str(), L"Error Opening File", 
                     MB_OK | MB_ICONERROR);
@@ -309,6 +314,7 @@ bool MainWindow::LoadFile(const std::wstring& filePath) {
     }
     m_editor->SetEncoding(result.detectedEncoding);
     m_editor->SetLineEnding(result.detectedLineEnding);
+    m_editor->SetMixedLineEndings(result.mixedLineEndings);
     m_editor->SetModified(false);
     
     m_currentFile = filePath;
@@ -328,6 +334,7 @@ bool MainWindow::LoadFile(const std::wstring& filePath) {
             doc->isNoteMode = false;
             doc->noteId.clear();
         }
+        m_documentManager->SetDocumentRawBytes(activeTab, std::move(result.rawBytes));
     }
     
     // Add to recent files
@@ -347,11 +354,220 @@ bool MainWindow::LoadFile(const std::wstring& filePath) {
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Open a file in a new tab (large files stream in asynchronously)
+//------------------------------------------------------------------------------
+bool MainWindow::OpenFileInNewTab(const std::wstring& filePath) {
+    if (FileIO::GetFileSizeBytes(filePath) > DocumentManager::ASYNC_LOAD_THRESHOLD ||
+        m_documentManager->UsesLargeFileViewer(filePath)) {
+        OnTabNew();
+        int tabId = m_documentManager->GetActiveTabId();
+        if (LoadFile(filePath)) return true;
+        // Don't leave the tab opened for the file behind empty
+        OnTabCloseRequested(tabId);
+        return false;
+    }
+    
+    FileReadResult result = FileIO::ReadFile(filePath);
+    if (!result.success) {
+        MessageBoxW(m_hwnd, result.errorMessage.c_str(), L"Error Opening File",
+                    MB_OK | MB_ICONERROR);
+        return false;
+    }
+    
+    int tabId = m_documentManager->OpenDocument(
+        filePath, result.content, result.detectedEncoding, result.detectedLineEnding);
+    if (tabId < 0) return false;
+    m_documentManager->SetDocumentRawBytes(tabId, std::move(result.rawBytes));
+    
+    UpdateActiveEditor();
+    m_editor->SetMixedLineEndings(result.mixedLineEndings);
+    m_currentFile = filePath;
+    m_isNewFile = false;
+    m_isNoteMode = false;
+    m_currentNoteId.clear();
+    m_settingsManager->AddRecentFile(filePath);
+    UpdateRecentFilesMenu();
+    UpdateTitle();
+    UpdateStatusBar();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Start streaming a large file into the active tab.  The first chunk is
+// shown as soon as it is decoded; the rest is appended as it arrives.
+//------------------------------------------------------------------------------
+bool MainWindow::BeginAsyncLoad(const std::wstring& filePath) {
+    int tabId = m_documentManager->GetActiveTabId();
+    m_documentManager->SetDocumentFilePath(tabId, filePath);
+    if (auto* doc = m_documentManager->GetActiveDocument()) {
+        doc->isNewFile = false;
+        doc->isNoteMode = false;
+        doc->noteId.clear();
+    }
+    
+    if (!m_documentManager->BeginFileLoad(tabId, filePath)) {
+        MessageBoxW(m_hwnd, L"The file could not be opened.", L"Error Opening File",
+                    MB_OK | MB_ICONERROR);
+        return false;
+    }
+    
+    m_currentFile = filePath;
+    m_isNewFile = false;
+    m_isNoteMode = false;
+    m_currentNoteId.clear();
+    
+    UpdateTitle();
+    UpdateStatusBar();
+    SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_POSITION,
+                 reinterpret_cast<LPARAM>(L"Loading...  (Esc to cancel)"));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Show a very large file in the active tab's read-only viewer.  The file is
+// memory-mapped and indexed in the background instead of being decoded
+// into the editor.
+//------------------------------------------------------------------------------
+bool MainWindow::OpenLargeFileView(const std::wstring& filePath) {
+    int tabId = m_documentManager->GetActiveTabId();
+    std::wstring errorMessage;
+    if (!m_documentManager->AttachLargeFileView(tabId, filePath, errorMessage)) {
+        MessageBoxW(m_hwnd, errorMessage.c_str(), L"Error Opening File", MB_OK | MB_ICONERROR);
+        return false;
+    }
+    
+    m_documentManager->SetDocumentFilePath(tabId, filePath);
+    if (auto* doc = m_documentManager->GetActiveDocument()) {
+        doc->isNewFile = false;
+        doc->isNoteMode = false;
+        doc->noteId.clear();
+    }
+    
+    m_currentFile = filePath;
+    m_isNewFile = false;
+    m_isNoteMode = false;
+    m_currentNoteId.clear();
+    
+    m_settingsManager->AddRecentFile(filePath);
+    UpdateRecentFilesMenu();
+    
+    UpdateActiveEditor();
+    UpdateTitle();
+    UpdateStatusBar();
+    StartFileMonitoring();
+    m_editor->SetFocus();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Find bar search in the large file viewer (plain text only)
+//------------------------------------------------------------------------------
+bool MainWindow::OnLargeFileViewFind(void* userData, const std::wstring& text,
+                                     const FindOptions& options, bool forward) {
+    MainWindow* self = static_cast<MainWindow*>(userData);
+    LargeFileView* view = self ? self->GetActiveLargeFileView() : nullptr;
+    if (!view) return false;
+    
+    if (options.useRegex || options.wholeWord) {
+        SendMessageW(self->m_hwndStatus, SB_SETTEXTW, SB_PART_COUNTS,
+                     reinterpret_cast<LPARAM>(L"Regex and whole word are not available for large files"));
+        return false;
+    }
+    return view->Find(text, options.matchCase, !forward);
+}
+
+//------------------------------------------------------------------------------
+// The large file viewer's current line or index progress changed
+//------------------------------------------------------------------------------
+void MainWindow::OnLargeFileViewState(void* userData) {
+    MainWindow* self = static_cast<MainWindow*>(userData);
+    if (self) {
+        self->UpdateStatusBar();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Viewer of the active tab, or null when it is shown in the editor
+//------------------------------------------------------------------------------
+LargeFileView* MainWindow::GetActiveLargeFileView() const {
+    if (!m_documentManager) return nullptr;
+    return m_documentManager->GetLargeFileView(m_documentManager->GetActiveTabId());
+}
+
+//------------------------------------------------------------------------------
+// WM_APP_FILELOAD: a chunk or the completion of an asynchronous load
+//------------------------------------------------------------------------------
+void MainWindow::OnFileLoadUpdate(FileLoadUpdate* rawUpdate) {
+    std::unique_ptr<FileLoadUpdate> update(rawUpdate);
+    if (!update || !m_documentManager) return;
+    if (!m_documentManager->ApplyFileLoadUpdate(*update)) return;
+    
+    bool isActive = (update->tabId == m_documentManager->GetActiveTabId());
+    
+    if (!update->done) {
+        if (isActive) {
+            int pct = update->totalBytes > 0
+                ? static_cast<int>(update->bytesRead * 100 / update->totalBytes) : 100;
+            wchar_t buf[80];
+            swprintf_s(buf, L"Loading... %d%%  (Esc to cancel)", pct);
+            SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_POSITION, reinterpret_cast<LPARAM>(buf));
+            if (m_lineNumbersGutter && m_lineNumbersGutter->IsVisible()) {
+                m_lineNumbersGutter->Update();
+            }
+        }
+        return;
+    }
+    
+    if (!update->success) {
+        MessageBoxW(m_hwnd, update->errorMessage.c_str(), L"Error Opening File",
+                    MB_OK | MB_ICONERROR);
+        OnTabCloseRequested(update->tabId);
+        return;
+    }
+    
+    const DocumentState* doc = m_documentManager->GetDocument(update->tabId);
+    if (doc) {
+        m_settingsManager->AddRecentFile(doc->filePath);
+        UpdateRecentFilesMenu();
+    }
+    
+    if (isActive) {
+        UpdateTitle();
+        UpdateStatusBar();
+        StartFileMonitoring();
+        if (m_lineNumbersGutter && m_lineNumbersGutter->IsVisible()) {
+            m_lineNumbersGutter->Update();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Esc while the active tab is loading: abandon the load and the tab
+//------------------------------------------------------------------------------
+void MainWindow::CancelActiveFileLoad() {
+    if (!m_documentManager) return;
+    int tabId = m_documentManager->GetActiveTabId();
+    if (!m_documentManager->IsLoading(tabId)) return;
+    
+    m_documentManager->CancelFileLoad(tabId);
+    OnTabCloseRequested(tabId);
+    SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_POSITION,
+                 reinterpret_cast<LPARAM>(L"Loading cancelled"));
+}
+
 //------------------------------------------------------------------------------
 // Save file
 //------------------------------------------------------------------------------
 bool MainWindow::SaveFile(const std::wstring& filePath) {
     if (!m_editor) return false;
+    
+    // Never write a partially loaded or viewer-only file back to disk
+    if (m_documentManager && (m_documentManager->IsLoading(m_documentManager->GetActiveTabId()) ||
+                              GetActiveLargeFileView())) {
+        MessageBeep(MB_ICONWARNING);
+        return false;
+    }
     std::wstring text = m_editor->GetText();
     
     FileWriteResult result = FileIO::WriteFile(
@@ -368,6 +584,12 @@ bool MainWindow::SaveFile(const std::wstring& filePath) {
     }
     
     m_editor->SetModified(false);
+    m_editor->SetMixedLineEndings(false);
+    
+    // The file on disk no longer matches the cached bytes
+    if (m_documentManager) {
+        m_documentManager->SetDocumentRawBytes(m_documentManager->GetActiveTabId(), nullptr);
+    }
     
     // Delete auto-save backup on successful save
     DeleteAutoSaveBackup();
@@ -392,6 +614,7 @@ void MainWindow::NewDocument() {
     // Reset the document state in the DocumentManager (text, path, title, etc.)
     if (m_documentManager) {
         m_documentManager->ResetActiveDocument();
+        UpdateActiveEditor();
     }
     
     m_currentFile.clear();
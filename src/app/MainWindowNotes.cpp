@@ -60,11 +60,15 @@ void MainWindow::OnNotesImport() {
             InitializeNoteStore();
         }
         
-        size_t countBefore = m_noteStore->GetNoteCount();
-        if (m_noteStore->ImportNotes(filePath)) {
-            size_t added = m_noteStore->GetNoteCount() - countBefore;
-            std::wstring msg = L"Successfully imported " + std::to_wstring(added) + L" new notes.";
+        NoteImportResult result = m_noteStore->ImportNotes(filePath);
+        if (!result.failed) {
+            std::wstring msg = L"Successfully imported " + std::to_wstring(result.imported) + L" new notes.";
             MessageBoxW(m_hwnd, msg.c_str(), L"Import Complete", MB_OK | MB_ICONINFORMATION);
+        } else if (result.imported > 0) {
+            // Notes read before the bad part of the file were kept
+            std::wstring msg = L"Imported " + std::to_wstring(result.imported) +
+                               L" notes; the file was cut short or malformed.";
+            MessageBoxW(m_hwnd, msg.c_str(), L"Import Incomplete", MB_OK | MB_ICONWARNING);
         } else {
             MessageBoxW(m_hwnd, L"Failed to import notes. The file may be invalid.", L"Import Error", MB_OK | MB_ICONERROR);
         }
@@ -77,7 +81,11 @@ void MainWindow::OnNotesImport() {
 void MainWindow::InitializeNoteStore() {
     // Initialize the note store
     if (m_noteStore) {
+        m_noteStore->SetPackedStorage(m_settingsManager->GetSettings().notePackedStorage);
         (void)m_noteStore->Initialize();
+        
+        // Ranked note search; the index is built in the background
+        m_noteStore->StartSearchIndex(*m_scheduler);
     }
     
     // Create capture window
@@ -90,7 +98,7 @@ void MainWindow::InitializeNoteStore() {
     
     // Create note list window
     m_noteListWindow = std::make_unique<NoteListWindow>();
-    (void)m_noteListWindow->Create(m_hInstance, m_hwnd, m_noteStore.get());
+    (void)m_noteListWindow->Create(m_hInstance, m_hwnd, m_noteStore.get(), *m_scheduler);
     // Set callback for opening notes
     m_noteListWindow->SetOpenCallback([this](const NoteSummary& summary) {
         LoadNoteIntoEditor(summary);
@@ -115,10 +123,11 @@ void MainWindow::AutoSaveCurrentNote() {
         Note newNote = m_noteStore->CreateNote(content);
         m_currentNoteId = newNote.id;
     } else {
-        // Update existing note
-        auto existingNote = m_noteStore->GetNote(m_currentNoteId);
+        // Update existing note; the summary is enough, so no content is read
+        auto existingNote = m_noteStore->GetNoteSummary(m_currentNoteId);
         if (existingNote) {
-            Note updated = *existingNote;
+            Note updated;
+            static_cast<NoteSummary&>(updated) = *existingNote;
             updated.content = content;
             (void)m_noteStore->UpdateNote(updated);
         }
@@ -203,16 +203,10 @@ void MainWindow::OnFilePrint() {
             if (!tab.selected) continue;
 
             auto* doc = m_documentManager->GetDocument(tab.tabId);
-            if (!doc || !doc->editor) continue;
+            if (!doc) continue;
 
-            // Save the active editor state before reading other tabs
-            std::wstring tabText;
-            if (tab.tabId == m_documentManager->GetActiveTabId()) {
-                tabText = doc->editor->GetText();
-            } else {
-                // For non-active tabs, use the stored content
-                tabText = doc->editor->GetText();
-            }
+            // Inactive tabs may be hibernated; read through the manager
+            std::wstring tabText = m_documentManager->GetDocumentText(tab.tabId);
 
             if (tabText.empty()) continue;
 
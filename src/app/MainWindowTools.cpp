@@ -5,9 +5,9 @@
 
 #include "MainWindow.h"
 #include "resource.h"
+#include "Trace.h"
 #include <CommCtrl.h>
 #include <shellapi.h>
-#include <sstream>
 #include <algorithm>
 #include <wincrypt.h>
 #include <objbase.h>
@@ -363,53 +363,9 @@ void MainWindow::OnToolsSplitLines() {
     if (result != IDOK) return;
     
     // Operate on selection if present, otherwise on whole document
-    bool hasSelection = false;
-    DWORD selStart, selEnd;
-    m_editor->GetSelection(selStart, selEnd);
-    hasSelection = (selStart != selEnd);
-    
-    std::wstring text = hasSelection ? m_editor->GetSelectedText() : m_editor->GetText();
-    if (text.empty()) return;
-    
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        
-        // Split this line if it exceeds maxWidth
-        while (static_cast<int>(line.size()) > maxWidth) {
-            // Try to break at a space
-            int breakPos = maxWidth;
-            for (int i = maxWidth - 1; i > 0; --i) {
-                if (line[i] == L' ' || line[i] == L'\t') {
-                    breakPos = i + 1;
-                    break;
-                }
-            }
-            lines.push_back(line.substr(0, breakPos));
-            line = line.substr(breakPos);
-            // Trim leading spaces from the continuation
-            size_t firstNonSpace = line.find_first_not_of(L' ');
-            if (firstNonSpace != std::wstring::npos && firstNonSpace > 0) {
-                line = line.substr(firstNonSpace);
-            }
-        }
-        lines.push_back(line);
-    }
-    
-    std::wstring resultText;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        resultText += lines[i];
-        if (i < lines.size() - 1) resultText += L"\r\n";
-    }
-    
-    if (hasSelection) {
-        m_editor->ReplaceSelection(resultText);
-    } else {
-        m_editor->SelectAll();
-        m_editor->ReplaceSelection(resultText);
-    }
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::WrapAt(maxWidth));
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
@@ -443,49 +399,10 @@ void MainWindow::OnToolsTabsToSpaces() {
 // Tools -> Spaces to Tabs
 //------------------------------------------------------------------------------
 void MainWindow::OnToolsSpacesToTabs() {
-    if (!m_editor) return;
-    std::wstring text = m_editor->GetText();
-    if (text.empty()) return;
-    
-    int tabSize = m_settingsManager->GetSettings().tabSize;
-    std::wstring spaces(tabSize, L' ');
-    
     // Replace leading spaces with tabs on each line
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        
-        std::wstring newLine;
-        size_t i = 0;
-        // Convert leading spaces to tabs
-        while (i + tabSize <= line.size()) {
-            bool allSpaces = true;
-            for (int j = 0; j < tabSize; ++j) {
-                if (line[i + j] != L' ') { allSpaces = false; break; }
-            }
-            if (allSpaces) {
-                newLine += L'\t';
-                i += tabSize;
-            } else {
-                break;
-            }
-        }
-        newLine += line.substr(i);
-        lines.push_back(newLine);
-    }
-    
-    std::wstring result;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) result += L"\r\n";
-    }
-    
-    if (result != text) {
-        m_editor->SelectAll();
-        m_editor->ReplaceSelection(result);
-    }
+    LinePipeline pipeline;
+    pipeline.Map(LineTransforms::LeadingSpacesToTabs(m_settingsManager->GetSettings().tabSize));
+    ApplyLinePipeline(pipeline, false);
 }
 
 //------------------------------------------------------------------------------
@@ -570,57 +487,23 @@ void MainWindow::OnToolsWordCount() {
 // Tools -> Remove Blank Lines
 //------------------------------------------------------------------------------
 void MainWindow::OnToolsRemoveBlankLines() {
-    if (!m_editor) return;
-    std::wstring text = m_editor->GetText();
-    if (text.empty()) return;
-    
-    std::vector<std::wstring> lines;
-    std::wistringstream stream(text);
-    std::wstring line;
-    while (std::getline(stream, line)) {
-        if (!line.empty() && line.back() == L'\r') line.pop_back();
-        // Keep the line only if it's not blank
-        if (line.find_first_not_of(L" \t") != std::wstring::npos) {
-            lines.push_back(line);
-        }
-    }
-    
-    std::wstring result;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        result += lines[i];
-        if (i < lines.size() - 1) result += L"\r\n";
-    }
-    
-    m_editor->SelectAll();
-    m_editor->ReplaceSelection(result);
+    LinePipeline pipeline;
+    pipeline.Map(LineTransforms::RemoveBlankLines());
+    ApplyLinePipeline(pipeline, false);
 }
 
 //------------------------------------------------------------------------------
-// Tools -> Join Lines
+// Tools -> Join Lines (selection only)
 //------------------------------------------------------------------------------
 void MainWindow::OnToolsJoinLines() {
     if (!m_editor) return;
-    std::wstring sel = m_editor->GetSelectedText();
-    if (sel.empty()) return;
-    
-    std::wstring result;
-    result.reserve(sel.size());
-    bool lastWasNewline = false;
-    for (size_t i = 0; i < sel.size(); ++i) {
-        wchar_t ch = sel[i];
-        if (ch == L'\r') continue; // skip CR
-        if (ch == L'\n') {
-            if (!lastWasNewline) {
-                result += L' '; // replace first newline with space
-            }
-            lastWasNewline = true;
-        } else {
-            lastWasNewline = false;
-            result += ch;
-        }
-    }
-    
-    m_editor->ReplaceSelection(result);
+    DWORD selStart, selEnd;
+    m_editor->GetSelection(selStart, selEnd);
+    if (selStart == selEnd) return;
+
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::JoinWithSpaces());
+    ApplyLinePipeline(pipeline, true);
 }
 
 //------------------------------------------------------------------------------
@@ -1247,6 +1130,103 @@ void MainWindow::OnToolsCharacterMap() {
         });
 }
 
+//------------------------------------------------------------------------------
+// Hidden command (Ctrl+Alt+Shift+T): the first press starts performance
+// tracing, the next writes a Chrome trace to %TEMP% and shows the slowest
+// operations
+//------------------------------------------------------------------------------
+void MainWindow::OnToolsDumpTrace() {
+    if (!Trace::IsEnabled()) {
+        Trace::Clear();
+        Trace::SetEnabled(true);
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_COUNTS,
+                     reinterpret_cast<LPARAM>(L"Tracing on - press Ctrl+Alt+Shift+T again to save"));
+        return;
+    }
+    Trace::SetEnabled(false);
+
+    wchar_t tempDir[MAX_PATH];
+    DWORD tempLen = GetTempPathW(MAX_PATH, tempDir);
+    if (tempLen == 0 || tempLen >= MAX_PATH) return;
+
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    wchar_t fileName[64];
+    swprintf_s(fileName, L"QNote-trace-%04d%02d%02d-%02d%02d%02d.json",
+               st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+    std::wstring jsonPath = std::wstring(tempDir) + fileName;
+
+    std::wstring error;
+    if (!WriteTraceFiles(jsonPath, error)) {
+        MessageBoxW(m_hwnd, error.c_str(), L"Performance Trace", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    std::wstring message = Trace::FormatSummary();
+    if (m_noteStore) {
+        NoteContentCacheStats cache = m_noteStore->GetContentCacheStats();
+        wchar_t cacheLine[160];
+        swprintf_s(cacheLine, L"\r\nNote cache: %llu hits / %llu misses, %zu notes, %zu of %zu KB\r\n",
+                   static_cast<unsigned long long>(cache.hits), static_cast<unsigned long long>(cache.misses),
+                   cache.entries, cache.bytes / 1024, cache.capacityBytes / 1024);
+        message += cacheLine;
+        
+        NoteWriteQueueStats writes = m_noteStore->GetWriteQueueStats();
+        uint64_t bytesWritten = writes.contentBytesWritten + writes.indexBytesWritten;
+        double amplification = writes.bytesChanged > 0
+            ? static_cast<double>(bytesWritten) / static_cast<double>(writes.bytesChanged) : 0.0;
+        wchar_t writeLine[256];
+        swprintf_s(writeLine, L"Note writer: %llu written, %llu coalesced, %llu unchanged, %llu failed, "
+                              L"flushed %llu of %llu\r\n"
+                              L"Note writes: %llu KB for %llu KB changed (amplification %.1fx)\r\n",
+                   static_cast<unsigned long long>(writes.written), static_cast<unsigned long long>(writes.coalesced),
+                   static_cast<unsigned long long>(writes.unchanged), static_cast<unsigned long long>(writes.failed),
+                   static_cast<unsigned long long>(writes.flushedGeneration),
+                   static_cast<unsigned long long>(writes.queuedGeneration),
+                   static_cast<unsigned long long>(bytesWritten / 1024),
+                   static_cast<unsigned long long>(writes.bytesChanged / 1024), amplification);
+        message += writeLine;
+    }
+    message += L"\r\nTrace saved to:\r\n" + jsonPath + L"\r\n(open it in chrome://tracing or ui.perfetto.dev)";
+    MessageBoxW(m_hwnd, message.c_str(), L"Performance Trace", MB_OK | MB_ICONINFORMATION);
+}
+
+//------------------------------------------------------------------------------
+// Write the Chrome trace JSON and, next to it, a .summary.txt (UTF-8)
+//------------------------------------------------------------------------------
+bool MainWindow::WriteTraceFiles(const std::wstring& jsonPath, std::wstring& errorMessage) {
+    auto writeBytes = [&errorMessage](const std::wstring& path, const std::string& bytes) {
+        HandleGuard hFile(CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr,
+                                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!hFile.valid()) {
+            errorMessage = L"Could not create " + path;
+            return false;
+        }
+        DWORD written = 0;
+        if (!::WriteFile(hFile.get(), bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr) ||
+            written != bytes.size()) {
+            errorMessage = L"Could not write " + path;
+            return false;
+        }
+        return true;
+    };
+
+    try {
+        if (!writeBytes(jsonPath, Trace::FormatChromeTrace())) return false;
+
+        std::wstring summary = Trace::FormatSummary(25);
+        int len = WideCharToMultiByte(CP_UTF8, 0, summary.c_str(), static_cast<int>(summary.size()),
+                                      nullptr, 0, nullptr, nullptr);
+        std::string utf8(static_cast<size_t>(len), '\0');
+        WideCharToMultiByte(CP_UTF8, 0, summary.c_str(), static_cast<int>(summary.size()),
+                            utf8.data(), len, nullptr, nullptr);
+        return writeBytes(jsonPath + L".summary.txt", utf8);
+    } catch (const std::bad_alloc&) {
+        errorMessage = L"Not enough memory to write the trace.";
+        return false;
+    }
+}
+
 //------------------------------------------------------------------------------
 // Tools -> Clipboard History
 //------------------------------------------------------------------------------
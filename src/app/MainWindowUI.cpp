@@ -10,6 +10,7 @@
 #include <functional>
 #include <sstream>
 #include <set>
+#include <algorithm>
 #include <winhttp.h>
 
 #pragma comment(lib, "winhttp.lib")
@@ -64,6 +65,8 @@ void MainWindow::LoadKeyboardShortcuts() {
         { L"EditFindNext",     IDM_EDIT_FINDNEXT },
         { L"EditReplace",      IDM_EDIT_REPLACE },
         { L"EditGoTo",         IDM_EDIT_GOTO },
+        { L"EditFindInFiles",  IDM_EDIT_FINDINFILES },
+        { L"EditFindInTabs",   IDM_EDIT_FINDINTABS },
         { L"EditDateTime",     IDM_EDIT_DATETIME },
         // Text Operations
         { L"EditUppercase",    IDM_EDIT_UPPERCASE },
@@ -86,6 +89,8 @@ void MainWindow::LoadKeyboardShortcuts() {
         { L"NextBookmark",     IDM_EDIT_NEXTBOOKMARK },
         { L"PrevBookmark",     IDM_EDIT_PREVBOOKMARK },
         { L"ClearBookmarks",   IDM_EDIT_CLEARBOOKMARKS },
+        // Diagnostics
+        { L"ToolsDumpTrace",   IDM_TOOLS_DUMPTRACE },
     };
     
     std::vector<ACCEL> accels;
@@ -177,6 +182,8 @@ void MainWindow::CreateDefaultShortcutsFile(const std::wstring& path) {
     content += L"EditFindNext=F3\r\n";
     content += L"EditReplace=Ctrl+H\r\n";
     content += L"EditGoTo=Ctrl+G\r\n";
+    content += L"EditFindInFiles=Ctrl+Shift+H\r\n";
+    content += L"EditFindInTabs=Ctrl+Alt+F\r\n";
     content += L"EditDateTime=F5\r\n";
     content += L"\r\n";
     content += L"; --- Text Operations ---\r\n";
@@ -549,6 +556,31 @@ void MainWindow::UpdateStatusBar() {
     }
     if (!m_editor) return;
     
+    // Large file viewer: line position and indexing progress
+    if (LargeFileView* view = GetActiveLargeFileView()) {
+        wchar_t posText[128];
+        swprintf_s(posText, L"Ln %llu  |  Read-only",
+                   static_cast<unsigned long long>(view->GetCurrentLine() + 1));
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_POSITION, reinterpret_cast<LPARAM>(posText));
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_ENCODING,
+                     reinterpret_cast<LPARAM>(EncodingToString(view->GetEncoding())));
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_EOL,
+                     reinterpret_cast<LPARAM>(LineEndingToString(view->GetLineEnding())));
+        
+        wchar_t zoomText[32];
+        swprintf_s(zoomText, L"%d%%", m_settingsManager->GetSettings().zoomLevel);
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_ZOOM, reinterpret_cast<LPARAM>(zoomText));
+        
+        wchar_t countText[64];
+        if (view->IsIndexComplete()) {
+            swprintf_s(countText, L"%llu lines", static_cast<unsigned long long>(view->GetLineCount()));
+        } else {
+            swprintf_s(countText, L"Indexing... %d%%", view->GetIndexPercent());
+        }
+        SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_COUNTS, reinterpret_cast<LPARAM>(countText));
+        return;
+    }
+    
     // Line and column
     int line = m_editor->GetCurrentLine() + 1;
     int column = m_editor->GetCurrentColumn() + 1;
@@ -570,8 +602,10 @@ void MainWindow::UpdateStatusBar() {
     const wchar_t* encodingText = EncodingToString(m_editor->GetEncoding());
     SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_ENCODING, reinterpret_cast<LPARAM>(encodingText));
     
-    // Line ending
-    const wchar_t* eolText = LineEndingToString(m_editor->GetLineEnding());
+    // Line ending (flag files that mix CRLF, LF and CR; saving unifies them)
+    wchar_t eolText[32];
+    swprintf_s(eolText, m_editor->HasMixedLineEndings() ? L"%s (mixed)" : L"%s",
+               LineEndingToString(m_editor->GetLineEnding()));
     SendMessageW(m_hwndStatus, SB_SETTEXTW, SB_PART_EOL, reinterpret_cast<LPARAM>(eolText));
     
     // Zoom
@@ -628,6 +662,10 @@ void MainWindow::UpdateMenuState() {
     EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_UTF16LE, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
     EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_UTF16BE, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
     EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_ANSI, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_CP1251, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_CP1252, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_SHIFTJIS, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
+    EnableMenuItem(hMenu, IDM_ENCODING_REOPEN_GB18030, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
     
     // Format menu state
     CheckMenuItem(hMenu, IDM_FORMAT_WORDWRAP, 
@@ -670,6 +708,14 @@ void MainWindow::UpdateMenuState() {
                   MF_BYCOMMAND | (enc == TextEncoding::UTF16_BE ? MF_CHECKED : MF_UNCHECKED));
     CheckMenuItem(hMenu, IDM_ENCODING_ANSI, 
                   MF_BYCOMMAND | (enc == TextEncoding::ANSI ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hMenu, IDM_ENCODING_CP1251,
+                  MF_BYCOMMAND | (enc == TextEncoding::Windows1251 ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hMenu, IDM_ENCODING_CP1252,
+                  MF_BYCOMMAND | (enc == TextEncoding::Windows1252 ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hMenu, IDM_ENCODING_SHIFTJIS,
+                  MF_BYCOMMAND | (enc == TextEncoding::ShiftJIS ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hMenu, IDM_ENCODING_GB18030,
+                  MF_BYCOMMAND | (enc == TextEncoding::GB18030 ? MF_CHECKED : MF_UNCHECKED));
     
     // Tools menu state
     EnableMenuItem(hMenu, IDM_TOOLS_COPYFILEPATH, MF_BYCOMMAND | (hasFile ? MF_ENABLED : MF_GRAYED));
@@ -810,10 +856,18 @@ void MainWindow::ResizeControls() {
     int contentTop = topOffset + tabBarHeight + findBarHeight;
     int contentHeight = rc.bottom - statusHeight - contentTop;
     
-    // Position line numbers gutter
-    if (m_lineNumbersGutter && m_lineNumbersGutter->IsVisible()) {
-        gutterWidth = m_lineNumbersGutter->GetWidth();
-        m_lineNumbersGutter->Resize(0, contentTop, contentHeight);
+    // Position line numbers gutter (the large file viewer draws its own)
+    LargeFileView* largeView = GetActiveLargeFileView();
+    bool showGutter = m_lineNumbersGutter && m_lineNumbersGutter->IsVisible();
+    if (largeView) {
+        largeView->SetShowLineNumbers(showGutter);
+    }
+    if (showGutter) {
+        ShowWindow(m_lineNumbersGutter->GetHandle(), largeView ? SW_HIDE : SW_SHOW);
+        if (!largeView) {
+            gutterWidth = m_lineNumbersGutter->GetWidth();
+            m_lineNumbersGutter->Resize(0, contentTop, contentHeight);
+        }
     }
     
     // Position editor next to gutter
@@ -840,7 +894,10 @@ void MainWindow::UpdateActiveEditor() {
     m_editor->SetScrollCallback(OnEditorScroll, this);
     
     // Update sub-component editor references
-    if (m_findBar) m_findBar->SetEditor(m_editor);
+    if (m_findBar) {
+        m_findBar->SetEditor(m_editor);
+        m_findBar->SetFindHandler(GetActiveLargeFileView() ? OnLargeFileViewFind : nullptr, this);
+    }
     if (m_lineNumbersGutter) m_lineNumbersGutter->SetEditor(m_editor);
     if (m_dialogManager) m_dialogManager->SetEditor(m_editor);
     
@@ -883,7 +940,7 @@ void MainWindow::SaveSession() {
     // Don't save session if there's only one empty untitled tab
     if (ids.size() == 1) {
         auto* doc = m_documentManager->GetDocument(ids[0]);
-        if (doc && doc->isNewFile && !doc->isModified && IsWhitespaceOnly(doc->editor ? doc->editor->GetText() : L"")) {
+        if (doc && doc->isNewFile && !doc->isModified && IsWhitespaceOnly(m_documentManager->GetDocumentText(ids[0]))) {
             return;
         }
     }
@@ -923,6 +980,7 @@ void MainWindow::SaveSession() {
         writeInt(L"FirstVisibleLine", doc->firstVisibleLine);
         writeInt(L"IsNoteMode", doc->isNoteMode ? 1 : 0);
         writeStr(L"NoteId", doc->noteId);
+        writeStr(L"LastActivated", std::to_wstring(doc->lastActivated));
         
         // Save bookmarks as comma-separated line numbers
         std::wstring bmStr;
@@ -936,8 +994,8 @@ void MainWindow::SaveSession() {
         
         // For untitled or modified tabs, save content to sidecar file
         if (doc->isNewFile || doc->isModified) {
-            // Get the latest text from the document's editor
-            std::wstring textToSave = doc->editor ? doc->editor->GetText() : L"";
+            // Get the latest text from the document's editor or hibernation snapshot
+            std::wstring textToSave = m_documentManager->GetDocumentText(ids[i]);
             std::wstring contentPath = sessionDir + L"session_tab" + std::to_wstring(i) + L".txt";
             (void)FileIO::WriteFile(contentPath, textToSave, TextEncoding::UTF8, LineEnding::LF);
             writeInt(L"HasSavedContent", 1);
@@ -964,179 +1022,106 @@ void MainWindow::LoadSession() {
         return;
     }
     
+    // Restored tabs start as placeholders; their content is read on first
+    // activation (or by the background prefetch), so startup cost does not
+    // grow with the size or number of restored documents.
+    int initialTabId = m_documentManager->GetActiveTabId();
+    int activeTabId = -1;
+    std::vector<std::pair<unsigned long long, int>> prefetchOrder;
+    
     for (int i = 0; i < tabCount; i++) {
         std::wstring section = L"Tab" + std::to_wstring(i);
         wchar_t buf[4096] = {};
         
+        DocumentState doc;
+        
         GetPrivateProfileStringW(section.c_str(), L"FilePath", L"", buf, 4096, sessionPath.c_str());
-        std::wstring filePath = buf;
+        doc.filePath = buf;
         
         GetPrivateProfileStringW(section.c_str(), L"CustomTitle", L"", buf, 4096, sessionPath.c_str());
-        std::wstring customTitle = buf;
+        doc.customTitle = buf;
         
-        bool isNewFile = GetPrivateProfileIntW(section.c_str(), L"IsNewFile", 1, sessionPath.c_str()) != 0;
-        bool isPinned = GetPrivateProfileIntW(section.c_str(), L"IsPinned", 0, sessionPath.c_str()) != 0;
-        auto encoding = static_cast<TextEncoding>(GetPrivateProfileIntW(section.c_str(), L"Encoding", 1, sessionPath.c_str()));
-        auto lineEnding = static_cast<LineEnding>(GetPrivateProfileIntW(section.c_str(), L"LineEnding", 0, sessionPath.c_str()));
-        DWORD cursorStart = static_cast<DWORD>(GetPrivateProfileIntW(section.c_str(), L"CursorStart", 0, sessionPath.c_str()));
-        DWORD cursorEnd = static_cast<DWORD>(GetPrivateProfileIntW(section.c_str(), L"CursorEnd", 0, sessionPath.c_str()));
-        int firstVisibleLine = GetPrivateProfileIntW(section.c_str(), L"FirstVisibleLine", 0, sessionPath.c_str());
-        bool isNoteMode = GetPrivateProfileIntW(section.c_str(), L"IsNoteMode", 0, sessionPath.c_str()) != 0;
+        doc.isNewFile = GetPrivateProfileIntW(section.c_str(), L"IsNewFile", 1, sessionPath.c_str()) != 0;
+        doc.isPinned = GetPrivateProfileIntW(section.c_str(), L"IsPinned", 0, sessionPath.c_str()) != 0;
+        doc.encoding = static_cast<TextEncoding>(GetPrivateProfileIntW(section.c_str(), L"Encoding", 1, sessionPath.c_str()));
+        doc.lineEnding = static_cast<LineEnding>(GetPrivateProfileIntW(section.c_str(), L"LineEnding", 0, sessionPath.c_str()));
+        doc.cursorStart = static_cast<DWORD>(GetPrivateProfileIntW(section.c_str(), L"CursorStart", 0, sessionPath.c_str()));
+        doc.cursorEnd = static_cast<DWORD>(GetPrivateProfileIntW(section.c_str(), L"CursorEnd", 0, sessionPath.c_str()));
+        doc.firstVisibleLine = GetPrivateProfileIntW(section.c_str(), L"FirstVisibleLine", 0, sessionPath.c_str());
+        doc.isNoteMode = GetPrivateProfileIntW(section.c_str(), L"IsNoteMode", 0, sessionPath.c_str()) != 0;
+        // A 64-bit tick count; GetPrivateProfileIntW would truncate it
+        GetPrivateProfileStringW(section.c_str(), L"LastActivated", L"0", buf, 4096, sessionPath.c_str());
+        doc.lastActivated = _wcstoui64(buf, nullptr, 10);
         
         GetPrivateProfileStringW(section.c_str(), L"NoteId", L"", buf, 4096, sessionPath.c_str());
-        std::wstring noteId = buf;
+        doc.noteId = buf;
         
         // Parse bookmarks
         GetPrivateProfileStringW(section.c_str(), L"Bookmarks", L"", buf, 4096, sessionPath.c_str());
-        std::set<int> bookmarks;
         {
             std::wstring bmStr = buf;
             std::wistringstream bmStream(bmStr);
             std::wstring token;
             while (std::getline(bmStream, token, L',')) {
                 if (!token.empty()) {
-                    try { bookmarks.insert(std::stoi(token)); } catch (...) {}
+                    try { doc.bookmarks.insert(std::stoi(token)); } catch (...) {}
                 }
             }
         }
         
         bool hasSavedContent = GetPrivateProfileIntW(section.c_str(), L"HasSavedContent", 0, sessionPath.c_str()) != 0;
-        bool isModified = GetPrivateProfileIntW(section.c_str(), L"IsModified", 0, sessionPath.c_str()) != 0;
+        doc.isModified = GetPrivateProfileIntW(section.c_str(), L"IsModified", 0, sessionPath.c_str()) != 0;
         
-        std::wstring content;
-        std::wstring cleanContent;  // The on-disk version (for modified detection)
+        // File-based tabs whose file has disappeared are dropped
+        bool fileBacked = !doc.isNewFile && !doc.filePath.empty();
+        if (fileBacked && GetFileAttributesW(doc.filePath.c_str()) == INVALID_FILE_ATTRIBUTES) continue;
         
-        if (!isNewFile && !filePath.empty()) {
-            // File-based tab: re-read from disk
-            if (GetFileAttributesW(filePath.c_str()) == INVALID_FILE_ATTRIBUTES) continue;
-            FileReadResult readResult = FileIO::ReadFile(filePath);
-            if (!readResult.success) continue;
-            cleanContent = readResult.content;
-            encoding = readResult.detectedEncoding;
-            lineEnding = readResult.detectedLineEnding;
-            
-            // If the tab had unsaved modifications, load from sidecar instead
-            if (hasSavedContent && isModified) {
-                std::wstring contentPath = sessionDir + L"session_tab" + std::to_wstring(i) + L".txt";
-                FileReadResult sidecarResult = FileIO::ReadFile(contentPath);
-                content = sidecarResult.success ? sidecarResult.content : cleanContent;
-            } else {
-                content = cleanContent;
+        // Move the sidecar out of the session_tabN namespace: the document
+        // owns it until its content is read, and SaveSession rewrites
+        // session_tabN files on exit.
+        std::wstring sidecarPath;
+        std::wstring contentPath = sessionDir + L"session_tab" + std::to_wstring(i) + L".txt";
+        if (hasSavedContent && (!fileBacked || doc.isModified)) {
+            std::wstring pendingPath = sessionDir + L"session_pending" + std::to_wstring(i) + L".txt";
+            if (MoveFileExW(contentPath.c_str(), pendingPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+                sidecarPath = pendingPath;
             }
-        } else if (hasSavedContent) {
-            // Untitled/modified: read from sidecar
-            std::wstring contentPath = sessionDir + L"session_tab" + std::to_wstring(i) + L".txt";
-            FileReadResult readResult = FileIO::ReadFile(contentPath);
-            if (readResult.success) content = readResult.content;
-            cleanContent = isNewFile ? L"" : content;
         }
         
-        if (i == 0) {
-            // Reuse the initial empty tab created in OnCreate
-            int tabId = m_documentManager->GetActiveTabId();
-            auto* doc = m_documentManager->GetActiveDocument();
-            if (doc) {
-                doc->filePath = filePath;
-                doc->customTitle = customTitle;
-                doc->isNewFile = isNewFile;
-                doc->isPinned = isPinned;
-                doc->encoding = encoding;
-                doc->lineEnding = lineEnding;
-                doc->cursorStart = cursorStart;
-                doc->cursorEnd = cursorEnd;
-                doc->firstVisibleLine = firstVisibleLine;
-                doc->isNoteMode = isNoteMode;
-                doc->noteId = noteId;
-                doc->isModified = isModified;
-                doc->bookmarks = bookmarks;
-                
-                m_tabBar->SetTabTitle(tabId, doc->GetDisplayTitle());
-                if (!filePath.empty()) m_tabBar->SetTabFilePath(tabId, filePath);
-                if (isPinned) m_tabBar->SetTabPinned(tabId, true);
-                if (doc->isModified) m_tabBar->SetTabModified(tabId, true);
-                
-                // Use the document's own editor (per-tab)
-                if (doc->editor) {
-                    doc->editor->SetText(content);
-                    doc->editor->SetEncoding(encoding);
-                    doc->editor->SetLineEnding(lineEnding);
-                    doc->editor->SetModified(doc->isModified);
-                    doc->editor->SetBookmarks(bookmarks);
-                }
-                // Use the editor's normalized text as cleanText so that
-                // the modified-state comparison works correctly. RichEdit
-                // normalizes line endings (e.g. \r\n -> \r), so we must
-                // read back through the editor rather than using the raw
-                // file content which may have different line endings.
-                if (!doc->isModified && doc->editor) {
-                    doc->cleanTextHash = std::hash<std::wstring>{}(doc->editor->GetText());
-                } else if (doc->editor) {
-                    // For modified docs, temporarily load clean content to
-                    // get the normalized form, then restore modified content
-                    doc->editor->SetText(cleanContent);
-                    doc->cleanTextHash = std::hash<std::wstring>{}(doc->editor->GetText());
-                    doc->editor->SetText(content);
-                    doc->editor->SetModified(true);
-                } else {
-                    doc->cleanTextHash = std::hash<std::wstring>{}(cleanContent);
-                }
-                
-                m_currentFile = filePath;
-                m_isNewFile = isNewFile;
-                m_isNoteMode = isNoteMode;
-                m_currentNoteId = noteId;
-            }
-        } else {
-            int tabId = m_documentManager->OpenDocument(filePath, content, encoding, lineEnding);
-            auto* doc = m_documentManager->GetDocument(tabId);
-            if (doc) {
-                doc->customTitle = customTitle;
-                doc->isNewFile = isNewFile;
-                doc->isPinned = isPinned;
-                doc->cursorStart = cursorStart;
-                doc->cursorEnd = cursorEnd;
-                doc->firstVisibleLine = firstVisibleLine;
-                doc->isNoteMode = isNoteMode;
-                doc->noteId = noteId;
-                doc->bookmarks = bookmarks;
-                
-                // OpenDocument() already set cleanText from editor->GetText()
-                // which is correctly normalized for RichEdit. Only override
-                // it for modified docs where cleanContent differs from what
-                // was loaded into the editor.
-                if (isModified && doc->editor) {
-                    doc->editor->SetText(cleanContent);
-                    doc->cleanTextHash = std::hash<std::wstring>{}(doc->editor->GetText());
-                    doc->editor->SetText(content);
-                    doc->editor->SetModified(true);
-                } else if (!isModified && doc->editor) {
-                    doc->cleanTextHash = std::hash<std::wstring>{}(doc->editor->GetText());
-                }
-                
-                doc->isModified = isModified;
-                if (doc->editor) {
-                    doc->editor->SetBookmarks(bookmarks);
-                    doc->editor->SetModified(doc->isModified);
-                }
-                if (doc->isModified) {
-                    m_tabBar->SetTabModified(tabId, true);
-                }
-                if (!customTitle.empty()) m_tabBar->SetTabTitle(tabId, customTitle);
-                if (isPinned) m_tabBar->SetTabPinned(tabId, true);
-            }
-        }
+        unsigned long long lastActivated = doc.lastActivated;
+        int tabId = m_documentManager->AddPlaceholderDocument(std::move(doc), sidecarPath);
+        if (tabId < 0) continue;
+        
+        if (i == activeIndex) activeTabId = tabId;
+        prefetchOrder.emplace_back(lastActivated, tabId);
     }
     
-    // Switch to the previously active tab
-    auto ids = m_documentManager->GetAllTabIds();
-    if (activeIndex >= 0 && activeIndex < static_cast<int>(ids.size())) {
-        OnTabSelected(ids[activeIndex]);
+    if (!prefetchOrder.empty()) {
+        if (activeTabId < 0) activeTabId = prefetchOrder.front().second;
+        
+        // Switch to the previously active tab (reads its content now), then
+        // drop the empty tab created in OnCreate
+        OnTabSelected(activeTabId);
+        if (initialTabId >= 0 && initialTabId != activeTabId) {
+            m_documentManager->CloseDocument(initialTabId);
+        }
+        
+        // Prefetch the most recently used tabs in the background
+        std::sort(prefetchOrder.begin(), prefetchOrder.end(),
+                  [](const auto& a, const auto& b) { return a.first > b.first; });
+        std::vector<int> prefetchIds;
+        for (const auto& entry : prefetchOrder) {
+            if (entry.second == activeTabId) continue;
+            prefetchIds.push_back(entry.second);
+            if (prefetchIds.size() >= SESSION_PREFETCH_TABS) break;
+        }
+        m_documentManager->PrefetchPendingDocuments(prefetchIds);
     }
     
     // Start monitoring the restored file
     StartFileMonitoring();
     
-    // Clean up sidecar files
+    // Clean up sidecar files that were not claimed by a restored tab
     for (int i = 0; i < tabCount; i++) {
         std::wstring contentPath = sessionDir + L"session_tab" + std::to_wstring(i) + L".txt";
         DeleteFileW(contentPath.c_str());
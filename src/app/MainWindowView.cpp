@@ -161,6 +161,20 @@ void MainWindow::OnReopenWithEncoding(TextEncoding encoding) {
     
     if (!m_editor) return;
     
+    // The large file viewer re-indexes the mapped bytes
+    if (LargeFileView* view = GetActiveLargeFileView()) {
+        view->SetEncoding(encoding);
+        m_editor->SetEncoding(encoding);
+        m_editor->SetLineEnding(view->GetLineEnding());
+        if (auto* doc = m_documentManager->GetActiveDocument()) {
+            doc->encoding = encoding;
+            doc->lineEnding = view->GetLineEnding();
+        }
+        UpdateTitle();
+        UpdateStatusBar();
+        return;
+    }
+    
     if (m_editor->IsModified()) {
         int result = MessageBoxW(m_hwnd, 
             L"The file has unsaved changes. Reopening with a different encoding will discard them.\nContinue?",
@@ -168,12 +182,40 @@ void MainWindow::OnReopenWithEncoding(TextEncoding encoding) {
         if (result != IDYES) return;
     }
     
-    m_ignoreNextFileChange = true;
-    FileReadResult result = FileIO::ReadFileWithEncoding(m_currentFile, encoding);
+    // Re-decode the cached bytes when the file is unchanged on disk;
+    // otherwise read it again
+    FileReadResult result;
+    std::shared_ptr<RawFileBytes> rawBytes;
+    if (m_documentManager) {
+        int activeTab = m_documentManager->GetActiveTabId();
+        m_documentManager->CancelFileLoad(activeTab);
+        rawBytes = m_documentManager->GetDocumentRawBytes(activeTab);
+        
+        // Large files are decoded on a worker and stream back in like an
+        // open, so the window keeps responding
+        ULONGLONG size = rawBytes ? rawBytes->data.size() : FileIO::GetFileSizeBytes(m_currentFile);
+        if (size > DocumentManager::ASYNC_LOAD_THRESHOLD) {
+            if (!m_documentManager->BeginFileReopen(activeTab, encoding)) {
+                MessageBoxW(m_hwnd, L"The file could not be reopened.", L"Error Reopening File",
+                            MB_OK | MB_ICONERROR);
+                return;
+            }
+            UpdateTitle();
+            UpdateStatusBar();
+            return;
+        }
+    }
+    if (rawBytes && rawBytes->MatchesFile(m_currentFile)) {
+        result = FileIO::DecodeFile(rawBytes, encoding);
+    } else {
+        m_ignoreNextFileChange = true;
+        result = FileIO::ReadFileWithEncoding(m_currentFile, encoding);
+    }
     if (result.success) {
         m_editor->SetText(result.content);
         m_editor->SetEncoding(encoding);
         m_editor->SetLineEnding(result.detectedLineEnding);
+        m_editor->SetMixedLineEndings(result.mixedLineEndings);
         m_editor->SetModified(false);
         m_editor->SetSelection(0, 0);
         
@@ -185,6 +227,8 @@ void MainWindow::OnReopenWithEncoding(TextEncoding encoding) {
                 doc->lineEnding = result.detectedLineEnding;
             }
             m_documentManager->SetDocumentModified(m_documentManager->GetActiveTabId(), false);
+            m_documentManager->SetDocumentRawBytes(m_documentManager->GetActiveTabId(),
+                                                   std::move(result.rawBytes));
         }
         
         StartFileMonitoring();
@@ -23,6 +23,7 @@
 #include <objbase.h>
 #include "MainWindow.h"
 #include "Editor.h"
+#include "Trace.h"
 
 // Enable visual styles
 #pragma comment(linker,"\"/manifestdependency:type='win32' \
@@ -79,12 +80,13 @@ struct CommandLineArgs {
     std::wstring filePath;
     int posX = CW_USEDEFAULT;
     int posY = CW_USEDEFAULT;
+    std::wstring traceFile;     // --trace: record a performance trace, write it here on exit
 };
 
 //------------------------------------------------------------------------------
 // Parse command line to get the file to open and optional position
 // Handles IFEO redirect where first arg is notepad.exe
-// Supports: QNote.exe [file] [--pos X,Y]
+// Supports: QNote.exe [file] [--pos X,Y] [--trace out.json]
 //------------------------------------------------------------------------------
 static CommandLineArgs ParseCommandLine() {
     CommandLineArgs result;
@@ -122,12 +124,18 @@ static CommandLineArgs ParseCommandLine() {
                 i++; // skip the value arg
                 continue;
             }
+            if (arg == L"--trace" && i + 1 < argc) {
+                result.traceFile = argv[i + 1];
+                if (i == fileArgIndex) fileArgIndex = i + 2;
+                i++;
+                continue;
+            }
         }
         
         if (argc > fileArgIndex) {
             // Get the file path (skip --pos and its value)
             std::wstring candidate = argv[fileArgIndex];
-            if (candidate != L"--pos") {
+            if (candidate != L"--pos" && candidate != L"--trace") {
                 filePath = candidate;
             }
         }
@@ -237,6 +245,12 @@ int WINAPI wWinMain(
     // Create and run main window
     QNote::MainWindow mainWindow;
     
+    QNote::Trace::SetThreadName("UI");
+    if (!args.traceFile.empty()) {
+        QNote::Trace::SetEnabled(true);
+        mainWindow.SetTraceOutputPath(args.traceFile);
+    }
+    
     if (!mainWindow.Create(hInstance, nCmdShow, args.filePath, args.posX, args.posY)) {
         CoUninitialize();
         return 1;
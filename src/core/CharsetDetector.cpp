@@ -0,0 +1,435 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// CharsetDetector.cpp - Statistical code page detection for non-Unicode text
+//==============================================================================
+
+#include "CharsetDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace QNote {
+
+namespace {
+
+// Bytes read per sample window
+constexpr size_t SAMPLE_BYTES = 4096;
+
+// Extra windows spread over the input when the prefix, middle and suffix
+// hold fewer than MIN_EVIDENCE non-ASCII bytes
+constexpr size_t EXTRA_WINDOWS = 8;
+constexpr size_t MIN_EVIDENCE = 64;
+
+// Non-ASCII bytes of evidence at which the confidences saturate
+constexpr double EVIDENCE_CAP = 16.0;
+
+constexpr int MAX_CLASSES = 8;
+
+// Classes shared by every model: ASCII letters and all other ASCII bytes.
+// Transitions between two ASCII classes say nothing about the code page
+// and are not scored.
+constexpr uint8_t CLASS_ASCII_LETTER = 0;
+constexpr uint8_t CLASS_ASCII_OTHER = 1;
+
+//------------------------------------------------------------------------------
+// First-order model over character classes.  'weight' rows are relative
+// frequencies of the next class given the previous one; 'size' is the
+// number of distinct byte sequences in a class, which are taken as equally
+// likely, so every model assigns a probability to the same bytes and the
+// log-likelihoods can be compared.
+//------------------------------------------------------------------------------
+struct PairModel {
+    int classes;
+    double size[MAX_CLASSES];
+    double weight[MAX_CLASSES][MAX_CLASSES];
+};
+
+using PairCounts = uint32_t[MAX_CLASSES][MAX_CLASSES];
+
+//------------------------------------------------------------------------------
+// Single-byte code pages.  Classes: ASCII letter, ASCII other, common
+// lowercase letter, other lowercase letter, uppercase letter, common
+// punctuation, rare symbol, byte undefined in the code page.  Case matters:
+// multi-byte text read as a single-byte code page flips case mid-word all
+// the time, real text almost never does.
+//------------------------------------------------------------------------------
+enum SingleByteClass : uint8_t {
+    SB_LOWER_COMMON = 2,
+    SB_LOWER,
+    SB_UPPER,
+    SB_SYMBOL,
+    SB_RARE,
+    SB_INVALID,
+    SB_CLASSES
+};
+
+using ByteClassTable = std::array<uint8_t, 256>;
+
+struct ByteList {
+    const uint8_t* bytes;
+    size_t count;
+
+    template <size_t N>
+    constexpr ByteList(const uint8_t (&list)[N]) : bytes(list), count(N) {}
+};
+
+//------------------------------------------------------------------------------
+// 0xC0-0xDF are uppercase and 0xE0-0xFF lowercase letters in both code
+// pages; the lists override that and mark the scattered letters below 0xC0.
+// Anything else above 0x7F is a rare symbol.  Later lists win (e.g. 1252's
+// multiplication and division signs inside the letter range are symbols).
+//------------------------------------------------------------------------------
+constexpr ByteClassTable MakeTable(ByteList lower, ByteList upper, ByteList common,
+                                   ByteList symbols, ByteList invalid) {
+    ByteClassTable table{};
+    for (int b = 0; b < 256; b++) {
+        bool asciiLetter = (b >= 'A' && b <= 'Z') || (b >= 'a' && b <= 'z');
+        table[b] = (b < 0x80)  ? (asciiLetter ? CLASS_ASCII_LETTER : CLASS_ASCII_OTHER)
+                 : (b >= 0xE0) ? static_cast<uint8_t>(SB_LOWER)
+                 : (b >= 0xC0) ? static_cast<uint8_t>(SB_UPPER)
+                               : static_cast<uint8_t>(SB_RARE);
+    }
+    for (size_t i = 0; i < lower.count; i++) table[lower.bytes[i]] = SB_LOWER;
+    for (size_t i = 0; i < upper.count; i++) table[upper.bytes[i]] = SB_UPPER;
+    for (size_t i = 0; i < common.count; i++) table[common.bytes[i]] = SB_LOWER_COMMON;
+    for (size_t i = 0; i < symbols.count; i++) table[symbols.bytes[i]] = SB_SYMBOL;
+    for (size_t i = 0; i < invalid.count; i++) table[invalid.bytes[i]] = SB_INVALID;
+    return table;
+}
+
+// Windows-1252: accented letters seldom come two in a row
+constexpr uint8_t CP1252_LOWER[] = { 0x9A, 0x9C, 0x9E, 0xAA, 0xBA };
+constexpr uint8_t CP1252_UPPER[] = { 0x8A, 0x8C, 0x8E, 0x9F };
+constexpr uint8_t CP1252_COMMON[] = {
+    0xDF, 0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB,
+    0xED, 0xEE, 0xEF, 0xF1, 0xF3, 0xF4, 0xF5, 0xF6, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC
+};
+constexpr uint8_t CP1252_SYMBOLS[] = {
+    0x80, 0x85, 0x91, 0x92, 0x93, 0x94, 0x96, 0x97, 0xA0, 0xA1, 0xA3, 0xA7, 0xA9,
+    0xAB, 0xAE, 0xB0, 0xB4, 0xB7, 0xBB, 0xBF, 0xD7, 0xF7
+};
+constexpr uint8_t CP1252_INVALID[] = { 0x81, 0x8D, 0x8F, 0x90, 0x9D };
+
+// Windows-1251: whole words are Cyrillic, so letters follow letters.  The
+// Ukrainian and Belarusian letters count; the Serbian and Macedonian ones
+// in 0x80-0x9F are rare enough to be symbols.
+constexpr uint8_t CP1251_LOWER[] = { 0xA2, 0xB3, 0xB4, 0xB8, 0xBA, 0xBC, 0xBE, 0xBF };
+constexpr uint8_t CP1251_UPPER[] = { 0xA1, 0xA3, 0xA5, 0xA8, 0xAA, 0xAF, 0xB2, 0xBD };
+constexpr uint8_t CP1251_COMMON[] = {
+    0xE0, 0xE2, 0xE4, 0xE5, 0xE8, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF2, 0xF3
+};
+constexpr uint8_t CP1251_SYMBOLS[] = {
+    0x85, 0x91, 0x92, 0x93, 0x94, 0x96, 0x97, 0xA0, 0xA7, 0xA9, 0xAB, 0xAE, 0xB0, 0xB9, 0xBB
+};
+constexpr uint8_t CP1251_INVALID[] = { 0x98 };
+
+constexpr ByteClassTable CP1252_TABLE = MakeTable(CP1252_LOWER, CP1252_UPPER, CP1252_COMMON,
+                                                  CP1252_SYMBOLS, CP1252_INVALID);
+constexpr ByteClassTable CP1251_TABLE = MakeTable(CP1251_LOWER, CP1251_UPPER, CP1251_COMMON,
+                                                  CP1251_SYMBOLS, CP1251_INVALID);
+
+// Constant-initialized, so no thread can see the models half built
+constexpr PairModel MakeSingleByteModel(const ByteClassTable& table,
+                                        const double (&weight)[SB_CLASSES][SB_CLASSES]) {
+    PairModel model = {};
+    model.classes = SB_CLASSES;
+    for (int b = 0; b < 256; b++) model.size[table[b]] += 1.0;
+    for (int p = 0; p < SB_CLASSES; p++) {
+        for (int c = 0; c < SB_CLASSES; c++) model.weight[p][c] = weight[p][c];
+    }
+    return model;
+}
+
+//                                      ->  A     O     LC    L     U     S     R     X
+constexpr double CP1252_WEIGHTS[SB_CLASSES][SB_CLASSES] = {
+    /* ASCII letter  */                 { 800,  170,  25,   2,    1,    2,    0.2,  0.01 },
+    /* ASCII other   */                 { 600,  380,  3,    1,    3,    12,   0.5,  0.01 },
+    /* common lower  */                 { 700,  250,  15,   2,    1,    5,    0.5,  0.01 },
+    /* lower         */                 { 700,  250,  15,   5,    1,    5,    0.5,  0.01 },
+    /* upper         */                 { 600,  300,  10,   2,    30,   5,    0.5,  0.01 },
+    /* symbol        */                 { 300,  600,  10,   3,    10,   40,   1,    0.01 },
+    /* rare          */                 { 300,  500,  20,   20,   20,   50,   100,  1    },
+    /* invalid       */                 { 300,  500,  20,   20,   20,   50,   100,  10   },
+};
+
+constexpr double CP1251_WEIGHTS[SB_CLASSES][SB_CLASSES] = {
+    /* ASCII letter  */                 { 850,  140,  3,    2,    2,    2,    0.2,  0.01 },
+    /* ASCII other   */                 { 250,  450,  110,  60,   60,   12,   0.5,  0.01 },
+    /* common lower  */                 { 3,    180,  530,  280,  2,    5,    0.3,  0.01 },
+    /* lower         */                 { 3,    200,  540,  250,  2,    5,    0.3,  0.01 },
+    /* upper         */                 { 5,    60,   600,  300,  60,   3,    0.3,  0.01 },
+    /* symbol        */                 { 60,   600,  60,   40,   100,  50,   1,    0.01 },
+    /* rare          */                 { 300,  500,  20,   20,   20,   50,   100,  1    },
+    /* invalid       */                 { 300,  500,  20,   20,   20,   50,   100,  10   },
+};
+
+constexpr PairModel CP1252_MODEL = MakeSingleByteModel(CP1252_TABLE, CP1252_WEIGHTS);
+constexpr PairModel CP1251_MODEL = MakeSingleByteModel(CP1251_TABLE, CP1251_WEIGHTS);
+
+//------------------------------------------------------------------------------
+// Shift-JIS.  Classes: ASCII letter, ASCII other, kana, JIS level 1/2 kanji,
+// JIS punctuation and full-width forms, half-width katakana, other valid
+// double-byte characters, invalid byte.
+//------------------------------------------------------------------------------
+enum ShiftJISClass : uint8_t {
+    SJ_KANA = 2,
+    SJ_KANJI,
+    SJ_SYMBOL,
+    SJ_HALF_KANA,
+    SJ_RARE,
+    SJ_INVALID,
+    SJ_CLASSES
+};
+
+//                                          ->  A     O     kana  kanji sym   hkana rare  X
+constexpr PairModel SHIFT_JIS_MODEL = {
+    SJ_CLASSES,
+    { 52, 76, 169, 6580, 264, 63, 4267, 1 },
+    {
+        /* ASCII letter */                  { 800,  180,  5,    5,    8,    0.5,  0.2,  0.01 },
+        /* ASCII other  */                  { 400,  450,  40,   60,   40,   1,    0.5,  0.01 },
+        /* kana         */                  { 10,   40,   600,  220,  120,  0.5,  0.5,  0.01 },
+        /* kanji        */                  { 10,   40,   450,  380,  110,  0.5,  0.5,  0.01 },
+        /* symbol       */                  { 40,   120,  250,  300,  280,  1,    1,    0.01 },
+        /* half kana    */                  { 30,   150,  5,    5,    10,   800,  1,    0.1  },
+        /* rare         */                  { 100,  300,  150,  150,  150,  10,   100,  1    },
+        /* invalid      */                  { 200,  400,  50,   50,   50,   50,   50,   10   },
+    }
+};
+
+// Class and length of the character at p[0]; length 0 if it is cut off
+uint8_t ClassifyShiftJIS(const uint8_t* p, size_t remaining, size_t& length) noexcept {
+    uint8_t lead = p[0];
+    length = 1;
+    if (lead >= 0xA1 && lead <= 0xDF) return SJ_HALF_KANA;
+    if (!((lead >= 0x81 && lead <= 0x9F) || (lead >= 0xE0 && lead <= 0xFC))) return SJ_INVALID;
+    if (remaining < 2) {
+        length = 0;
+        return SJ_INVALID;
+    }
+
+    uint8_t trail = p[1];
+    if (!((trail >= 0x40 && trail <= 0x7E) || (trail >= 0x80 && trail <= 0xFC))) return SJ_INVALID;
+    length = 2;
+    if (lead == 0x81) return SJ_SYMBOL;
+    if (lead == 0x82) {
+        if (trail >= 0x9F && trail <= 0xF1) return SJ_KANA;      // Hiragana
+        if (trail >= 0x4F && trail <= 0x9A) return SJ_SYMBOL;    // Full-width digits and letters
+        return SJ_RARE;
+    }
+    if (lead == 0x83) {
+        return (trail <= 0x96) ? SJ_KANA : SJ_RARE;              // Katakana, then Greek
+    }
+    if ((lead >= 0x88 && lead <= 0x9F) || (lead >= 0xE0 && lead <= 0xEA)) return SJ_KANJI;
+    return SJ_RARE;
+}
+
+//------------------------------------------------------------------------------
+// GB18030.  Classes: ASCII letter, ASCII other, GB2312 hanzi, GB2312
+// punctuation and full-width forms, other two-byte characters, four-byte
+// sequences, invalid byte.
+//------------------------------------------------------------------------------
+enum GB18030Class : uint8_t {
+    GB_HANZI = 2,
+    GB_SYMBOL,
+    GB_RARE,
+    GB_FOUR_BYTE,
+    GB_INVALID,
+    GB_CLASSES
+};
+
+//                                          ->  A     O     hanzi sym   rare  4byte X
+constexpr PairModel GB18030_MODEL = {
+    GB_CLASSES,
+    { 52, 76, 6768, 846, 16326, 1587600, 1 },
+    {
+        /* ASCII letter */                  { 800,  180,  10,   8,    0.5,  0.05, 0.01 },
+        /* ASCII other  */                  { 400,  450,  100,  40,   1,    0.1,  0.01 },
+        /* hanzi        */                  { 10,   50,   800,  140,  3,    0.2,  0.01 },
+        /* symbol       */                  { 40,   150,  600,  200,  2,    0.2,  0.01 },
+        /* rare         */                  { 50,   200,  400,  100,  200,  5,    0.1  },
+        /* four-byte    */                  { 50,   200,  300,  100,  100,  200,  0.1  },
+        /* invalid      */                  { 200,  400,  50,   50,   50,   50,   10   },
+    }
+};
+
+uint8_t ClassifyGB18030(const uint8_t* p, size_t remaining, size_t& length) noexcept {
+    uint8_t lead = p[0];
+    length = 1;
+    if (lead == 0x80 || lead == 0xFF) return GB_INVALID;
+    if (remaining < 2) {
+        length = 0;
+        return GB_INVALID;
+    }
+
+    uint8_t second = p[1];
+    if (second >= 0x30 && second <= 0x39) {
+        if (remaining < 4) {
+            length = 0;
+            return GB_INVALID;
+        }
+        if (p[2] >= 0x81 && p[2] <= 0xFE && p[3] >= 0x30 && p[3] <= 0x39) {
+            length = 4;
+            return GB_FOUR_BYTE;
+        }
+        return GB_INVALID;
+    }
+    if (second < 0x40 || second == 0x7F || second == 0xFF) return GB_INVALID;
+    length = 2;
+    if (lead >= 0xB0 && lead <= 0xF7 && second >= 0xA1) return GB_HANZI;
+    if (lead >= 0xA1 && lead <= 0xA9 && second >= 0xA1) return GB_SYMBOL;
+    return GB_RARE;
+}
+
+uint8_t AsciiClass(uint8_t b) noexcept {
+    return ((b | 0x20) >= 'a' && (b | 0x20) <= 'z') ? CLASS_ASCII_LETTER : CLASS_ASCII_OTHER;
+}
+
+// Record one class transition unless both sides are ASCII
+inline void Count(PairCounts& counts, uint8_t& previous, uint8_t current) noexcept {
+    if (previous > CLASS_ASCII_OTHER || current > CLASS_ASCII_OTHER) {
+        counts[previous][current]++;
+    }
+    previous = current;
+}
+
+//------------------------------------------------------------------------------
+// Accumulate class transitions for one window
+//------------------------------------------------------------------------------
+void CountSingleByte(const uint8_t* p, size_t size, const ByteClassTable& table, PairCounts& counts) noexcept {
+    uint8_t previous = CLASS_ASCII_OTHER;
+    for (size_t i = 0; i < size; i++) {
+        Count(counts, previous, table[p[i]]);
+    }
+}
+
+template <typename Classify>
+void CountMultiByte(const uint8_t* p, size_t size, Classify classify, PairCounts& counts) noexcept {
+    uint8_t previous = CLASS_ASCII_OTHER;
+    size_t i = 0;
+    while (i < size) {
+        if (p[i] < 0x80) {
+            Count(counts, previous, AsciiClass(p[i]));
+            i++;
+            continue;
+        }
+        size_t length = 0;
+        uint8_t cls = classify(p + i, size - i, length);
+        if (length == 0) break;             // Character cut off by the window
+        Count(counts, previous, cls);
+        i += length;
+    }
+}
+
+// Log2-likelihood of the counted transitions under a model
+double Score(const PairModel& model, const PairCounts& counts) noexcept {
+    double total = 0.0;
+    for (int p = 0; p < model.classes; p++) {
+        double rowSum = 0.0;
+        for (int c = 0; c < model.classes; c++) rowSum += model.weight[p][c];
+        for (int c = 0; c < model.classes; c++) {
+            if (counts[p][c] == 0) continue;
+            total += counts[p][c] * (std::log2(model.weight[p][c] / rowSum) - std::log2(model.size[c]));
+        }
+    }
+    return total;
+}
+
+//------------------------------------------------------------------------------
+// Window starting at or after 'begin'.  Windows after the first start just
+// past a byte below 0x30, which is never the second half of a Shift-JIS or
+// GB18030 character, so multi-byte models start in sync.
+//------------------------------------------------------------------------------
+void Window(const uint8_t* data, size_t size, size_t begin, size_t& start, size_t& end) noexcept {
+    start = (std::min)(begin, size);
+    end = (std::min)(size, start + SAMPLE_BYTES);
+    if (start == 0) return;
+    for (size_t i = start; i < end; i++) {
+        if (data[i] < 0x30) {
+            start = i + 1;
+            return;
+        }
+    }
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Code page numbers
+//------------------------------------------------------------------------------
+uint32_t CharsetCodePage(Charset charset) noexcept {
+    switch (charset) {
+        case Charset::Windows1251: return 1251;
+        case Charset::ShiftJIS:    return 932;
+        case Charset::GB18030:     return 54936;
+        case Charset::Windows1252:
+        default:                   return 1252;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Sample, score every model, and rank
+//------------------------------------------------------------------------------
+CharsetDetection DetectCharset(const uint8_t* data, size_t size) noexcept {
+    PairCounts counts[CHARSET_COUNT] = {};
+    CharsetDetection result;
+
+    auto sample = [&](size_t begin) {
+        size_t start, end;
+        Window(data, size, begin, start, end);
+        if (start >= end) return;
+        const uint8_t* p = data + start;
+        size_t length = end - start;
+
+        result.sampledBytes += length;
+        for (size_t i = 0; i < length; i++) result.highBytes += (p[i] >= 0x80);
+
+        CountSingleByte(p, length, CP1252_TABLE, counts[static_cast<size_t>(Charset::Windows1252)]);
+        CountSingleByte(p, length, CP1251_TABLE, counts[static_cast<size_t>(Charset::Windows1251)]);
+        CountMultiByte(p, length, ClassifyShiftJIS, counts[static_cast<size_t>(Charset::ShiftJIS)]);
+        CountMultiByte(p, length, ClassifyGB18030, counts[static_cast<size_t>(Charset::GB18030)]);
+    };
+
+    if (data && size > 0) {
+        if (size <= 3 * SAMPLE_BYTES) {
+            for (size_t begin = 0; begin < size; begin += SAMPLE_BYTES) sample(begin);
+        } else {
+            sample(0);
+            sample(size / 2 - SAMPLE_BYTES / 2);
+            sample(size - SAMPLE_BYTES);
+            if (result.highBytes < MIN_EVIDENCE) {
+                for (size_t k = 0; k < EXTRA_WINDOWS; k++) {
+                    sample(size / EXTRA_WINDOWS * k + size / (2 * EXTRA_WINDOWS));
+                }
+            }
+        }
+    }
+
+    const PairModel* models[CHARSET_COUNT] = { &CP1252_MODEL, &CP1251_MODEL,
+                                               &SHIFT_JIS_MODEL, &GB18030_MODEL };
+    double bitsPerByte[CHARSET_COUNT];
+    double best = -HUGE_VAL;
+    for (size_t i = 0; i < CHARSET_COUNT; i++) {
+        bitsPerByte[i] = result.highBytes ? Score(*models[i], counts[i]) / result.highBytes : 0.0;
+        best = (std::max)(best, bitsPerByte[i]);
+    }
+
+    // Softmax over the per-byte likelihoods, as if EVIDENCE_CAP bytes had
+    // been seen at most, so a few bytes cannot produce certainty
+    double evidence = (std::min)(static_cast<double>(result.highBytes), EVIDENCE_CAP);
+    double sum = 0.0;
+    for (size_t i = 0; i < CHARSET_COUNT; i++) {
+        result.ranked[i].charset = static_cast<Charset>(i);
+        result.ranked[i].confidence = std::exp2(evidence * (bitsPerByte[i] - best));
+        sum += result.ranked[i].confidence;
+    }
+    for (auto& score : result.ranked) score.confidence /= sum;
+
+    std::sort(result.ranked.begin(), result.ranked.end(),
+              [](const CharsetScore& a, const CharsetScore& b) {
+                  return a.confidence != b.confidence ? a.confidence > b.confidence
+                                                      : a.charset < b.charset;
+              });
+    return result;
+}
+
+} // namespace QNote
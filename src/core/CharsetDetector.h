@@ -0,0 +1,57 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// CharsetDetector.h - Statistical code page detection for non-Unicode text
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Legacy code pages the detector can tell apart
+//------------------------------------------------------------------------------
+enum class Charset {
+    Windows1252,    // Western European
+    Windows1251,    // Cyrillic
+    ShiftJIS,       // Japanese (code page 932)
+    GB18030         // Simplified Chinese (superset of GBK/GB2312)
+};
+
+constexpr size_t CHARSET_COUNT = 4;
+
+// Windows code page number for a charset
+[[nodiscard]] uint32_t CharsetCodePage(Charset charset) noexcept;
+
+struct CharsetScore {
+    Charset charset = Charset::Windows1252;
+    double confidence = 0.0;               // 0..1; the scores sum to 1
+};
+
+//------------------------------------------------------------------------------
+// Detection result: every candidate, most likely first
+//------------------------------------------------------------------------------
+struct CharsetDetection {
+    std::array<CharsetScore, CHARSET_COUNT> ranked;
+    size_t sampledBytes = 0;
+    size_t highBytes = 0;                  // Bytes >= 0x80 in the samples (the evidence)
+
+    [[nodiscard]] const CharsetScore& Best() const noexcept { return ranked[0]; }
+};
+
+//------------------------------------------------------------------------------
+// Rank the candidate code pages for 'data', which should not be valid UTF-8.
+// Only a bounded prefix, middle and suffix are read (a few more windows if
+// those hold little non-ASCII text), so the cost does not depend on the
+// size of the input.  Each candidate scores the samples with a first-order
+// model of character-class pairs ("Cyrillic letter after Cyrillic letter",
+// "kanji after hiragana", ...) and the log-likelihoods are turned into
+// confidences.
+//------------------------------------------------------------------------------
+[[nodiscard]] CharsetDetection DetectCharset(const uint8_t* data, size_t size) noexcept;
+
+} // namespace QNote
@@ -4,12 +4,16 @@
 //==============================================================================
 
 #include "FileIO.h"
+#include "CharsetDetector.h"
+#include "Trace.h"
 #include <commdlg.h>
 #include <shobjidl.h>
 #include <algorithm>
 
 namespace QNote {
 
+std::atomic<TaskScheduler*> FileIO::s_decodeScheduler{ nullptr };
+
 //------------------------------------------------------------------------------
 // BOM (Byte Order Mark) signatures
 //------------------------------------------------------------------------------
@@ -20,17 +24,28 @@ static const uint8_t BOM_UTF16_BE[] = { 0xFE, 0xFF };
 //------------------------------------------------------------------------------
 // Check if data starts with BOM
 //------------------------------------------------------------------------------
-static bool StartsWith(const std::vector<uint8_t>& data, const uint8_t* bom, size_t bomSize) {
-    if (data.size() < bomSize) return false;
-    return memcmp(data.data(), bom, bomSize) == 0;
+static bool StartsWith(const uint8_t* data, size_t size, const uint8_t* bom, size_t bomSize) {
+    if (size < bomSize) return false;
+    return memcmp(data, bom, bomSize) == 0;
 }
 
 //------------------------------------------------------------------------------
-// Check if data appears to be valid UTF-8
+// Check if data appears to be valid UTF-8.  ASCII is skipped eight bytes at
+// a time.
 //------------------------------------------------------------------------------
-static bool IsValidUTF8(const std::vector<uint8_t>& data) {
+static bool IsValidUTF8(const uint8_t* data, size_t size) {
     size_t i = 0;
-    while (i < data.size()) {
+    while (i < size) {
+        // Fast path: eight ASCII bytes
+        if (i + 8 <= size) {
+            uint64_t block;
+            memcpy(&block, data + i, sizeof(block));
+            if ((block & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        
         uint8_t c = data[i];
         int bytesNeeded = 0;
         
@@ -52,7 +67,7 @@ static bool IsValidUTF8(const std::vector<uint8_t>& data) {
         // Check continuation bytes
         for (int j = 0; j < bytesNeeded; j++) {
             i++;
-            if (i >= data.size()) return false;
+            if (i >= size) return false;
             if ((data[i] & 0xC0) != 0x80) return false;
         }
         i++;
@@ -60,17 +75,31 @@ static bool IsValidUTF8(const std::vector<uint8_t>& data) {
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Length of a prefix of a file without the UTF-8 sequence its end cuts off,
+// so a probe can be validated as if it ended on a character boundary
+//------------------------------------------------------------------------------
+static size_t TrimCutUTF8Tail(const uint8_t* data, size_t size) {
+    for (size_t back = 1; back <= 4 && back <= size; back++) {
+        uint8_t c = data[size - back];
+        if ((c & 0xC0) == 0x80) continue;
+        size_t needed = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        return back < needed ? size - back : size;
+    }
+    return size;
+}
+
 //------------------------------------------------------------------------------
 // Check if data appears to be UTF-16 (look for null bytes in expected positions)
 //------------------------------------------------------------------------------
-static bool LooksLikeUTF16(const std::vector<uint8_t>& data, bool& littleEndian) {
-    if (data.size() < 2) return false;
+static bool LooksLikeUTF16(const uint8_t* data, size_t size, bool& littleEndian) {
+    if (size < 2) return false;
     
     // Count null bytes in odd/even positions
     size_t nullOdd = 0;  // Null bytes at odd positions (UTF-16 LE for ASCII)
     size_t nullEven = 0; // Null bytes at even positions (UTF-16 BE for ASCII)
     
-    size_t checkSize = std::min(data.size(), size_t(1024));
+    size_t checkSize = std::min(size, size_t(1024));
     for (size_t i = 0; i < checkSize; i++) {
         if (data[i] == 0) {
             if (i % 2 == 0) nullEven++;
@@ -91,75 +120,102 @@ static bool LooksLikeUTF16(const std::vector<uint8_t>& data, bool& littleEndian)
     return false;
 }
 
+//------------------------------------------------------------------------------
+// Encoding for a detected legacy charset
+//------------------------------------------------------------------------------
+static TextEncoding EncodingForCharset(Charset charset) {
+    switch (charset) {
+        case Charset::Windows1251: return TextEncoding::Windows1251;
+        case Charset::ShiftJIS:    return TextEncoding::ShiftJIS;
+        case Charset::GB18030:     return TextEncoding::GB18030;
+        case Charset::Windows1252:
+        default:                   return TextEncoding::Windows1252;
+    }
+}
+
 //------------------------------------------------------------------------------
 // Detect encoding from raw bytes
 //------------------------------------------------------------------------------
 TextEncoding FileIO::DetectEncoding(const std::vector<uint8_t>& data) {
-    if (data.empty()) {
+    return DetectEncoding(data.data(), data.size());
+}
+
+TextEncoding FileIO::DetectEncoding(const uint8_t* data, size_t size) {
+    // A guess needs this many non-ASCII bytes and this confidence to beat
+    // the ANSI code page
+    static constexpr size_t CHARSET_MIN_HIGH_BYTES = 4;
+    static constexpr double CHARSET_MIN_CONFIDENCE = 0.6;
+    
+    if (size == 0) {
         return TextEncoding::UTF8;
     }
     
     // Check for BOM first
-    if (StartsWith(data, BOM_UTF8, sizeof(BOM_UTF8))) {
+    if (StartsWith(data, size, BOM_UTF8, sizeof(BOM_UTF8))) {
         return TextEncoding::UTF8_BOM;
     }
-    if (StartsWith(data, BOM_UTF16_LE, sizeof(BOM_UTF16_LE))) {
+    if (StartsWith(data, size, BOM_UTF16_LE, sizeof(BOM_UTF16_LE))) {
         return TextEncoding::UTF16_LE;
     }
-    if (StartsWith(data, BOM_UTF16_BE, sizeof(BOM_UTF16_BE))) {
+    if (StartsWith(data, size, BOM_UTF16_BE, sizeof(BOM_UTF16_BE))) {
         return TextEncoding::UTF16_BE;
     }
     
     // Check for UTF-16 without BOM (look for pattern of null bytes)
     bool littleEndian = false;
-    if (LooksLikeUTF16(data, littleEndian)) {
+    if (LooksLikeUTF16(data, size, littleEndian)) {
         return littleEndian ? TextEncoding::UTF16_LE : TextEncoding::UTF16_BE;
     }
     
-    // Check if valid UTF-8
-    if (IsValidUTF8(data)) {
-        // Check if it contains any high bytes (non-ASCII)
-        bool hasHighBytes = false;
-        for (uint8_t byte : data) {
-            if (byte >= 0x80) {
-                hasHighBytes = true;
-                break;
-            }
-        }
-        // If it's pure ASCII, treat as UTF-8 (compatible with ANSI)
-        // If it has high bytes that form valid UTF-8 sequences, it's UTF-8
+    // Pure ASCII and valid UTF-8 are both read as UTF-8.  Every byte is
+    // checked: a legacy file whose only non-ASCII bytes were missed would be
+    // decoded to U+FFFD and saved that way.
+    if (IsValidUTF8(data, size)) {
         return TextEncoding::UTF8;
     }
     
-    // If not valid UTF-8, assume ANSI (Windows-1252 or current code page)
+    // Not UTF-8: rank the legacy code pages.  A weak guess, or one that
+    // matches the ANSI code page anyway, stays ANSI.
+    CharsetDetection detection = DetectCharset(data, size);
+    const CharsetScore& best = detection.Best();
+    if (detection.highBytes >= CHARSET_MIN_HIGH_BYTES &&
+        best.confidence >= CHARSET_MIN_CONFIDENCE &&
+        CharsetCodePage(best.charset) != GetACP()) {
+        return EncodingForCharset(best.charset);
+    }
     return TextEncoding::ANSI;
 }
 
+//------------------------------------------------------------------------------
+// Code page passed to MultiByteToWideChar / WideCharToMultiByte
+//------------------------------------------------------------------------------
+UINT FileIO::GetCodePage(TextEncoding encoding) noexcept {
+    switch (encoding) {
+        case TextEncoding::UTF8:
+        case TextEncoding::UTF8_BOM:    return CP_UTF8;
+        case TextEncoding::Windows1251: return 1251;
+        case TextEncoding::Windows1252: return 1252;
+        case TextEncoding::ShiftJIS:    return 932;
+        case TextEncoding::GB18030:     return 54936;
+        case TextEncoding::ANSI:
+        default:                        return CP_ACP;
+    }
+}
+
 //------------------------------------------------------------------------------
 // Detect line ending type from text
 //------------------------------------------------------------------------------
 LineEnding FileIO::DetectLineEnding(const std::wstring& text) {
-    size_t crlfCount = 0;
-    size_t lfCount = 0;
-    size_t crCount = 0;
-    
-    for (size_t i = 0; i < text.size(); i++) {
-        if (text[i] == L'\r') {
-            if (i + 1 < text.size() && text[i + 1] == L'\n') {
-                crlfCount++;
-                i++; // Skip the LF
-            } else {
-                crCount++;
-            }
-        } else if (text[i] == L'\n') {
-            lfCount++;
-        }
-    }
-    
-    // Determine predominant line ending
-    if (crlfCount >= lfCount && crlfCount >= crCount) {
+    return PredominantLineEnding(CountLineEndings(text));
+}
+
+//------------------------------------------------------------------------------
+// Most common line ending (CRLF wins ties, then LF)
+//------------------------------------------------------------------------------
+LineEnding FileIO::PredominantLineEnding(const LineEndingCounts& counts) noexcept {
+    if (counts.crlf >= counts.lf && counts.crlf >= counts.cr) {
         return LineEnding::CRLF;
-    } else if (lfCount >= crlfCount && lfCount >= crCount) {
+    } else if (counts.lf >= counts.crlf && counts.lf >= counts.cr) {
         return LineEnding::LF;
     } else {
         return LineEnding::CR;
@@ -170,12 +226,15 @@ LineEnding FileIO::DetectLineEnding(const std::wstring& text) {
 // Decode bytes to wstring based on encoding
 //------------------------------------------------------------------------------
 std::wstring FileIO::DecodeToWString(const std::vector<uint8_t>& data, TextEncoding encoding) {
-    if (data.empty()) {
+    return DecodeBytes(data.data(), data.size(), encoding);
+}
+
+std::wstring FileIO::DecodeBytes(const uint8_t* data, size_t size, TextEncoding encoding) {
+    if (size == 0) {
         return L"";
     }
     
-    const uint8_t* start = data.data();
-    size_t size = data.size();
+    const uint8_t* start = data;
     
     // Skip BOM if present
     if (encoding == TextEncoding::UTF8_BOM && size >= 3) {
@@ -193,6 +252,13 @@ std::wstring FileIO::DecodeToWString(const std::vector<uint8_t>& data, TextEncod
         return L"";
     }
     
+    // Large inputs are split across the scheduler's workers
+    static constexpr size_t PARALLEL_DECODE_MIN_BYTES = 8 * 1024 * 1024;
+    TaskScheduler* scheduler = s_decodeScheduler.load();
+    if (size >= PARALLEL_DECODE_MIN_BYTES && scheduler) {
+        return DecodeParallel(start, size, encoding, *scheduler);
+    }
+    
     switch (encoding) {
         case TextEncoding::UTF16_LE: {
             // Direct copy for UTF-16 LE (native Windows encoding)
@@ -229,14 +295,15 @@ std::wstring FileIO::DecodeToWString(const std::vector<uint8_t>& data, TextEncod
         
         case TextEncoding::ANSI:
         default: {
-            // Convert ANSI to UTF-16 using current code page
-            int wideLen = MultiByteToWideChar(CP_ACP, 0,
+            // Convert ANSI (current code page) or a legacy code page to UTF-16
+            const UINT codePage = GetCodePage(encoding);
+            int wideLen = MultiByteToWideChar(codePage, 0,
                 reinterpret_cast<const char*>(start), static_cast<int>(size), nullptr, 0);
             if (wideLen == 0) {
                 return L"";
             }
             std::wstring result(wideLen, L'\0');
-            MultiByteToWideChar(CP_ACP, 0,
+            MultiByteToWideChar(codePage, 0,
                 reinterpret_cast<const char*>(start), static_cast<int>(size),
                 result.data(), wideLen);
             return result;
@@ -298,11 +365,12 @@ std::vector<uint8_t> FileIO::EncodeFromWString(const std::wstring& text, TextEnc
         
         case TextEncoding::ANSI:
         default: {
-            int ansiLen = WideCharToMultiByte(CP_ACP, 0, text.c_str(),
+            const UINT codePage = GetCodePage(encoding);
+            int ansiLen = WideCharToMultiByte(codePage, 0, text.c_str(),
                 static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
             if (ansiLen > 0) {
                 result.resize(ansiLen);
-                WideCharToMultiByte(CP_ACP, 0, text.c_str(), static_cast<int>(text.size()),
+                WideCharToMultiByte(codePage, 0, text.c_str(), static_cast<int>(text.size()),
                     reinterpret_cast<char*>(result.data()), ansiLen, nullptr, nullptr);
             }
             break;
@@ -316,6 +384,15 @@ std::vector<uint8_t> FileIO::EncodeFromWString(const std::wstring& text, TextEnc
 // Read a file with automatic encoding detection
 //------------------------------------------------------------------------------
 FileReadResult FileIO::ReadFile(const std::wstring& filePath) {
+    return ReadWholeFile(filePath, true);
+}
+
+FileReadResult FileIO::ReadFileInBackground(const std::wstring& filePath) {
+    return ReadWholeFile(filePath, false);
+}
+
+FileReadResult FileIO::ReadWholeFile(const std::wstring& filePath, bool pumpMessages) {
+    QNOTE_TRACE_SCOPE("FileIO::ReadFile");
     FileReadResult result;
     
     // Open file for reading
@@ -337,30 +414,27 @@ FileReadResult FileIO::ReadFile(const std::wstring& filePath) {
     // For files >100MB, delegate to the chunked reader for UI responsiveness
     static constexpr LONGLONG LARGE_THRESHOLD = 100LL * 1024 * 1024;
     if (fileSize.QuadPart > LARGE_THRESHOLD) {
-        return ReadFileLarge(filePath);
+        return ReadFileChunked(filePath, nullptr, pumpMessages);
     }
     
-    // Read file contents
-    std::vector<uint8_t> data;
-    if (fileSize.QuadPart > 0) {
-        data.resize(static_cast<size_t>(fileSize.QuadPart));
-        DWORD bytesRead = 0;
-        if (!::ReadFile(hFile.get(), data.data(), static_cast<DWORD>(data.size()), &bytesRead, nullptr)) {
-            result.errorMessage = FormatLastError(GetLastError());
-            return result;
-        }
-        data.resize(bytesRead);
+    // Read file contents (kept for re-decoding by the caller)
+    auto raw = std::make_shared<RawFileBytes>();
+    if (!ReadRawBytes(hFile.get(), fileSize.QuadPart, *raw, result.errorMessage)) {
+        return result;
     }
     
     // Detect encoding
-    result.detectedEncoding = DetectEncoding(data);
+    result.detectedEncoding = DetectEncoding(raw->data);
     
     // Decode to wstring
-    result.content = DecodeToWString(data, result.detectedEncoding);
+    result.content = DecodeToWString(raw->data, result.detectedEncoding);
     
     // Detect line endings
-    result.detectedLineEnding = DetectLineEnding(result.content);
+    LineEndingCounts eolCounts = CountLineEndings(result.content);
+    result.detectedLineEnding = PredominantLineEnding(eolCounts);
+    result.mixedLineEndings = eolCounts.IsMixed();
     
+    result.rawBytes = std::move(raw);
     result.success = true;
     return result;
 }
@@ -371,64 +445,105 @@ FileReadResult FileIO::ReadFile(const std::wstring& filePath) {
 FileReadResult FileIO::ReadFileWithEncoding(const std::wstring& filePath, TextEncoding encoding) {
     FileReadResult result;
     
-    // Open file for reading
+    // One read of the raw bytes, then a (parallel) decode with the forced
+    // encoding.  The bytes are returned so further re-decodes skip the disk.
+    std::shared_ptr<RawFileBytes> raw = ReadRawFile(filePath, result.errorMessage);
+    if (!raw) {
+        return result;
+    }
+    return DecodeFile(raw, encoding);
+}
+
+//------------------------------------------------------------------------------
+// Read a whole file's bytes
+//------------------------------------------------------------------------------
+std::shared_ptr<RawFileBytes> FileIO::ReadRawFile(const std::wstring& filePath, std::wstring& errorMessage) {
     HandleGuard hFile(CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
-        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
-    
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
     if (!hFile.valid()) {
-        result.errorMessage = FormatLastError(GetLastError());
-        return result;
+        errorMessage = FormatLastError(GetLastError());
+        return nullptr;
     }
     
-    // Get file size
     LARGE_INTEGER fileSize;
     if (!GetFileSizeEx(hFile.get(), &fileSize)) {
-        result.errorMessage = FormatLastError(GetLastError());
+        errorMessage = FormatLastError(GetLastError());
+        return nullptr;
+    }
+    
+    auto raw = std::make_shared<RawFileBytes>();
+    if (!ReadRawBytes(hFile.get(), fileSize.QuadPart, *raw, errorMessage)) {
+        return nullptr;
+    }
+    return raw;
+}
+
+//------------------------------------------------------------------------------
+// Decode previously read bytes with a specific encoding
+//------------------------------------------------------------------------------
+FileReadResult FileIO::DecodeFile(const std::shared_ptr<RawFileBytes>& rawBytes, TextEncoding encoding) {
+    QNOTE_TRACE_SCOPE("FileIO::DecodeFile");
+    FileReadResult result;
+    if (!rawBytes) {
+        result.errorMessage = L"No file data to decode";
         return result;
     }
     
-    // For large files (>100 MB), use the chunked reader to stay responsive.
-    // The forced encoding is applied by temporarily setting the result and
-    // letting ReadFileLarge detect line endings from the probe data.
-    static constexpr LONGLONG LARGE_THRESHOLD = 100LL * 1024 * 1024;
-    if (fileSize.QuadPart > LARGE_THRESHOLD) {
-        // Close our handle before ReadFileLarge opens its own
-        hFile = HandleGuard();
-        FileReadResult lr = ReadFileLarge(filePath);
-        // Override detected encoding with the forced one and re-decode
-        // if encodings differ.  For truly large files, we re-read via
-        // ReadFileLarge which always does streamed decode \u2013 the caller
-        // already expects this to be slow.
-        if (lr.success && lr.detectedEncoding != encoding) {
-            lr = ReadFileLarge(filePath);
-            // ReadFileLarge always detects encoding; we simply overwrite.
-            lr.detectedEncoding = encoding;
-        }
-        return lr;
+    try {
+        result.content = DecodeToWString(rawBytes->data, encoding);
+    } catch (const std::bad_alloc&) {
+        result.errorMessage = L"Not enough memory to open this file";
+        return result;
     }
+    result.detectedEncoding = encoding;
+    LineEndingCounts eolCounts = CountLineEndings(result.content);
+    result.detectedLineEnding = PredominantLineEnding(eolCounts);
+    result.mixedLineEndings = eolCounts.IsMixed();
+    result.rawBytes = rawBytes;
+    result.success = true;
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Read a whole open file.  ::ReadFile takes a DWORD count, so files over
+// 4 GB are read in pieces.
+//------------------------------------------------------------------------------
+bool FileIO::ReadRawBytes(HANDLE hFile, LONGLONG size, RawFileBytes& raw, std::wstring& errorMessage) {
+    static constexpr DWORD READ_PIECE = 64 * 1024 * 1024;
     
-    std::vector<uint8_t> data;
-    if (fileSize.QuadPart > 0) {
-        try {
-            data.resize(static_cast<size_t>(fileSize.QuadPart));
-        } catch (const std::bad_alloc&) {
-            result.errorMessage = L"Not enough memory to open this file";
-            return result;
-        }
+    try {
+        raw.data.resize(static_cast<size_t>(size));
+    } catch (const std::bad_alloc&) {
+        errorMessage = L"Not enough memory to open this file";
+        return false;
+    }
+    
+    size_t total = 0;
+    while (total < raw.data.size()) {
+        DWORD toRead = static_cast<DWORD>((std::min)(raw.data.size() - total, size_t(READ_PIECE)));
         DWORD bytesRead = 0;
-        if (!::ReadFile(hFile.get(), data.data(), static_cast<DWORD>(data.size()), &bytesRead, nullptr)) {
-            result.errorMessage = FormatLastError(GetLastError());
-            return result;
+        if (!::ReadFile(hFile, raw.data.data() + total, toRead, &bytesRead, nullptr)) {
+            errorMessage = FormatLastError(GetLastError());
+            return false;
         }
-        data.resize(bytesRead);
+        if (bytesRead == 0) break;  // File shrank while reading
+        total += bytesRead;
     }
+    raw.data.resize(total);
     
-    // Use the forced encoding
-    result.detectedEncoding = encoding;
-    result.content = DecodeToWString(data, encoding);
-    result.detectedLineEnding = DetectLineEnding(result.content);
-    result.success = true;
-    return result;
+    raw.fileSize = static_cast<ULONGLONG>(size);
+    GetFileTime(hFile, nullptr, nullptr, &raw.lastWriteTime);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Check that the file on disk still matches cached raw bytes
+//------------------------------------------------------------------------------
+bool RawFileBytes::MatchesFile(const std::wstring& filePath) const {
+    WIN32_FILE_ATTRIBUTE_DATA fad = {};
+    if (!GetFileAttributesExW(filePath.c_str(), GetFileExInfoStandard, &fad)) return false;
+    ULONGLONG size = (static_cast<ULONGLONG>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+    return size == fileSize && CompareFileTime(&fad.ftLastWriteTime, &lastWriteTime) == 0;
 }
 
 //------------------------------------------------------------------------------
@@ -476,6 +591,43 @@ static size_t FindUTF16SafeBoundary(const uint8_t* data, size_t size, bool littl
     return size;
 }
 
+//------------------------------------------------------------------------------
+// Code pages with lead bytes (Shift-JIS, GBK/GB18030, ...) cannot be cut at
+// any offset.  Bytes below 0x30 are never part of a multi-byte character in
+// them, so cut just after the last one.  Single-byte code pages cut anywhere.
+//------------------------------------------------------------------------------
+static size_t FindCodePageSafeBoundary(const uint8_t* data, size_t size, UINT codePage) {
+    static constexpr size_t MAX_BACKTRACK = 64 * 1024;
+
+    CPINFO info = {};
+    if (!GetCPInfo(codePage, &info) || info.MaxCharSize == 1) return size;
+
+    size_t floor = (size > MAX_BACKTRACK) ? size - MAX_BACKTRACK : 0;
+    for (size_t i = size; i > floor; i--) {
+        if (data[i - 1] < 0x30) return i;
+    }
+    return size;  // no separator nearby; accept a possible split
+}
+
+// Leading bytes of [data, data + size) that decode to whole characters
+static size_t FindSafeBoundary(const uint8_t* data, size_t size, TextEncoding encoding) {
+    switch (encoding) {
+        case TextEncoding::UTF8:
+        case TextEncoding::UTF8_BOM:
+            return FindUTF8SafeBoundary(data, size);
+        case TextEncoding::UTF16_LE:
+            return FindUTF16SafeBoundary(data, size, true);
+        case TextEncoding::UTF16_BE:
+            return FindUTF16SafeBoundary(data, size, false);
+        default:
+            return FindCodePageSafeBoundary(data, size, FileIO::GetCodePage(encoding));
+    }
+}
+
+// Streamed reads: a small first chunk (the first screenful, fast), then 8 MB
+static constexpr DWORD FIRST_CHUNK_SIZE = 256 * 1024;
+static constexpr DWORD CHUNK_SIZE = 8 * 1024 * 1024;
+
 //------------------------------------------------------------------------------
 // Append decoded wide chars from a raw byte span
 //------------------------------------------------------------------------------
@@ -512,12 +664,13 @@ void FileIO::AppendDecoded(std::wstring& out, const uint8_t* data, size_t size,
         }
         case TextEncoding::ANSI:
         default: {
-            int wideLen = MultiByteToWideChar(CP_ACP, 0,
+            const UINT codePage = GetCodePage(encoding);
+            int wideLen = MultiByteToWideChar(codePage, 0,
                 reinterpret_cast<const char*>(data), static_cast<int>(size), nullptr, 0);
             if (wideLen > 0) {
                 size_t oldSize = out.size();
                 out.resize(oldSize + wideLen);
-                MultiByteToWideChar(CP_ACP, 0,
+                MultiByteToWideChar(codePage, 0,
                     reinterpret_cast<const char*>(data), static_cast<int>(size),
                     out.data() + oldSize, wideLen);
             }
@@ -526,13 +679,164 @@ void FileIO::AppendDecoded(std::wstring& out, const uint8_t* data, size_t size,
     }
 }
 
+//------------------------------------------------------------------------------
+void FileIO::SetDecodeScheduler(TaskScheduler* scheduler) noexcept {
+    s_decodeScheduler.store(scheduler);
+}
+
+//------------------------------------------------------------------------------
+// Decode a BOM-less span on the scheduler.  Chunk boundaries are moved
+// back to character boundaries, each chunk's output length is measured in
+// parallel, and then every chunk decodes straight into its slot of the
+// result, so the text is never copied twice.
+//------------------------------------------------------------------------------
+std::wstring FileIO::DecodeParallel(const uint8_t* data, size_t size, TextEncoding encoding,
+                                   TaskScheduler& scheduler) {
+    static constexpr size_t MIN_CHUNK_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t MAX_CHUNK_BYTES = 1024 * 1024 * 1024;  // MultiByteToWideChar takes int
+    
+    const bool utf16 = (encoding == TextEncoding::UTF16_LE || encoding == TextEncoding::UTF16_BE);
+    const bool utf8 = (encoding == TextEncoding::UTF8 || encoding == TextEncoding::UTF8_BOM);
+    const UINT codePage = GetCodePage(encoding);
+    
+    size_t chunks = (std::min)(scheduler.GetWorkerCount(), size / MIN_CHUNK_BYTES);
+    chunks = (std::max)({ chunks, size_t(1), (size + MAX_CHUNK_BYTES - 1) / MAX_CHUNK_BYTES });
+    
+    std::vector<size_t> bounds(chunks + 1);
+    bounds[chunks] = size;
+    for (size_t k = 1; k < chunks; k++) {
+        size_t b = size / chunks * k;
+        if (utf16) {
+            b = FindUTF16SafeBoundary(data, b, encoding == TextEncoding::UTF16_LE);
+        } else if (utf8) {
+            b = FindUTF8SafeBoundary(data, b);
+        } else {
+            b = FindCodePageSafeBoundary(data, b, codePage);
+        }
+        bounds[k] = (std::max)(b, bounds[k - 1]);
+    }
+    
+    // Run fn(k) for every chunk; the file is being opened, so the user waits
+    auto forEachChunk = [chunks, &scheduler](const std::function<void(size_t)>& fn) {
+        scheduler.ParallelFor(chunks, fn, TaskPriority::High);
+    };
+    
+    // Phase 1: output length of each chunk
+    std::vector<size_t> offsets(chunks + 1, 0);
+    forEachChunk([&](size_t k) {
+        size_t len = bounds[k + 1] - bounds[k];
+        if (utf16) {
+            offsets[k + 1] = len / 2;
+        } else if (len > 0) {
+            offsets[k + 1] = static_cast<size_t>(MultiByteToWideChar(codePage, 0,
+                reinterpret_cast<const char*>(data + bounds[k]), static_cast<int>(len), nullptr, 0));
+        }
+    });
+    for (size_t k = 0; k < chunks; k++) offsets[k + 1] += offsets[k];
+    
+    // Phase 2: decode each chunk in place
+    std::wstring result(offsets[chunks], L'\0');
+    forEachChunk([&](size_t k) {
+        const uint8_t* src = data + bounds[k];
+        size_t len = bounds[k + 1] - bounds[k];
+        wchar_t* dst = result.data() + offsets[k];
+        size_t charCount = offsets[k + 1] - offsets[k];
+        if (charCount == 0) return;
+        
+        if (encoding == TextEncoding::UTF16_LE) {
+            memcpy(dst, src, charCount * 2);
+        } else if (encoding == TextEncoding::UTF16_BE) {
+            for (size_t i = 0; i < charCount; i++) {
+                dst[i] = static_cast<wchar_t>((src[i * 2] << 8) | src[i * 2 + 1]);
+            }
+        } else {
+            MultiByteToWideChar(codePage, 0, reinterpret_cast<const char*>(src),
+                static_cast<int>(len), dst, static_cast<int>(charCount));
+        }
+    });
+    return result;
+}
+
 //------------------------------------------------------------------------------
 // Stream-read a large file in chunks (supports >3 GB files)
-// Reads the file in 8 MB I/O chunks and decodes each chunk immediately so we
-// never hold the entire raw byte buffer in memory at once.  The message queue
-// is pumped between chunks so the UI thread stays responsive.
 //------------------------------------------------------------------------------
 FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStatus) {
+    return ReadFileChunked(filePath, hwndStatus, true);
+}
+
+//------------------------------------------------------------------------------
+// Collects the chunks produced by ReadFileStreamed into one string.  With
+// 'pumpMessages' the message queue is pumped between chunks so the UI thread
+// stays responsive; a worker must not, as it would dispatch its own
+// thread's messages in the middle of its task.
+//------------------------------------------------------------------------------
+FileReadResult FileIO::ReadFileChunked(const std::wstring& filePath, HWND hwndStatus,
+                                       bool pumpMessages) {
+    QNOTE_TRACE_SCOPE("FileIO::ReadFileLarge");
+    std::wstring content;
+    std::wstring allocError;
+    bool reserved = false;
+    int lastPercent = -1;
+
+    FileReadResult result = ReadFileStreamed(filePath,
+        [&](std::wstring& chunk, const FileReadProgress& progress) {
+            // Pre-allocate once the encoding is known
+            if (!reserved) {
+                reserved = true;
+                try {
+                    size_t estimatedChars = static_cast<size_t>(progress.totalBytes);
+                    if (progress.encoding == TextEncoding::UTF16_LE ||
+                        progress.encoding == TextEncoding::UTF16_BE)
+                        estimatedChars /= 2;  // else: upper bound for ASCII-heavy text
+                    content.reserve(estimatedChars);
+                } catch (const std::bad_alloc&) {
+                    allocError = L"Not enough memory to open this file";
+                    return false;
+                }
+            }
+            content.append(chunk);
+
+            // Update progress in status bar
+            int pct = progress.totalBytes > 0
+                ? static_cast<int>(progress.bytesRead * 100 / progress.totalBytes) : 100;
+            if (hwndStatus && pct != lastPercent) {
+                lastPercent = pct;
+                wchar_t buf[80];
+                double mb = static_cast<double>(progress.bytesRead) / (1024.0 * 1024.0);
+                double totalMb = static_cast<double>(progress.totalBytes) / (1024.0 * 1024.0);
+                swprintf_s(buf, L"Loading... %d%%  (%.0f / %.0f MB)", pct, mb, totalMb);
+                SendMessageW(hwndStatus, SB_SETTEXTW, 0, reinterpret_cast<LPARAM>(buf));
+            }
+
+            // Pump the message queue so the UI stays responsive
+            if (pumpMessages) {
+                MSG msg;
+                while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                    TranslateMessage(&msg);
+                    DispatchMessageW(&msg);
+                }
+            }
+            return true;
+        });
+
+    if (!allocError.empty()) {
+        result.success = false;
+        result.errorMessage = allocError;
+    }
+    if (result.success) {
+        result.content = std::move(content);
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Read a file chunk by chunk on the calling thread.
+// Reads in 8 MB I/O chunks (the first one smaller) and decodes each chunk
+// immediately so the raw bytes are never all held in memory at once.
+//------------------------------------------------------------------------------
+FileReadResult FileIO::ReadFileStreamed(const std::wstring& filePath, const FileChunkCallback& onChunk,
+                                        RawFileBytes* keepBytes) {
+    QNOTE_TRACE_SCOPE("FileIO::ReadFileStreamed");
     FileReadResult result;
 
     // Open with sequential-scan hint for better read-ahead caching
@@ -550,6 +854,18 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
         return result;
     }
 
+    // Room for the whole file up front, or the bytes are not kept at all
+    if (keepBytes) {
+        try {
+            keepBytes->data.clear();
+            keepBytes->data.reserve(static_cast<size_t>(fileSize.QuadPart));
+            keepBytes->fileSize = static_cast<ULONGLONG>(fileSize.QuadPart);
+            GetFileTime(hFile.get(), nullptr, nullptr, &keepBytes->lastWriteTime);
+        } catch (const std::bad_alloc&) {
+            keepBytes = nullptr;
+        }
+    }
+
     // ---- Detect encoding from the first 64 KB ----
     static constexpr DWORD PROBE_SIZE = 64 * 1024;
     std::vector<uint8_t> probe(
@@ -563,7 +879,12 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
         }
         probe.resize(bytesRead);
     }
-    result.detectedEncoding = DetectEncoding(probe);
+    // The probe may end inside a character; that is no reason to rule out UTF-8
+    size_t probeSize = probe.size();
+    if (static_cast<LONGLONG>(probeSize) < fileSize.QuadPart) {
+        probeSize = TrimCutUTF8Tail(probe.data(), probeSize);
+    }
+    result.detectedEncoding = DetectEncoding(probe.data(), probeSize);
 
     // Detect line ending from the probe text so we don't have to scan the
     // entire (potentially multi-GB) decoded string later.
@@ -593,28 +914,15 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
         LARGE_INTEGER pos;
         pos.QuadPart = dataStart;
         SetFilePointerEx(hFile.get(), pos, nullptr, FILE_BEGIN);
+        if (keepBytes) {
+            keepBytes->data.insert(keepBytes->data.end(), probe.begin(), probe.begin() + dataStart);
+        }
     }
     probe.clear();  // free early
 
-    // ---- Pre-allocate the result wstring ----
-    LONGLONG totalBytesToRead = fileSize.QuadPart - dataStart;
-    try {
-        size_t estimatedChars;
-        if (result.detectedEncoding == TextEncoding::UTF16_LE ||
-            result.detectedEncoding == TextEncoding::UTF16_BE)
-            estimatedChars = static_cast<size_t>(totalBytesToRead / 2);
-        else
-            estimatedChars = static_cast<size_t>(totalBytesToRead); // upper bound for ASCII-heavy
-        result.content.reserve(estimatedChars);
-    } catch (const std::bad_alloc&) {
-        result.errorMessage = L"Not enough memory to open this file";
-        return result;
-    }
-
     // ---- Chunked read + decode ----
-    static constexpr DWORD CHUNK_SIZE = 8 * 1024 * 1024; // 8 MB I/O chunks
-
     std::vector<uint8_t> chunkBuf;
+    std::wstring decoded;
     try {
         chunkBuf.resize(CHUNK_SIZE);
     } catch (const std::bad_alloc&) {
@@ -622,14 +930,20 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
         return result;
     }
 
+    FileReadProgress progress;
+    progress.encoding = result.detectedEncoding;
+    progress.lineEnding = result.detectedLineEnding;
+    progress.totalBytes = fileSize.QuadPart - dataStart;
+
     std::vector<uint8_t> carry;  // leftover bytes from an incomplete char sequence
     LONGLONG totalRead = 0;
-    int lastPercent = -1;
+    DWORD chunkLimit = FIRST_CHUNK_SIZE;
 
-    while (totalRead < totalBytesToRead) {
+    while (totalRead < progress.totalBytes) {
         DWORD toRead = static_cast<DWORD>(
-            (std::min)(static_cast<LONGLONG>(CHUNK_SIZE - static_cast<LONGLONG>(carry.size())),
-                       totalBytesToRead - totalRead));
+            (std::min)(static_cast<LONGLONG>(chunkLimit - static_cast<LONGLONG>(carry.size())),
+                       progress.totalBytes - totalRead));
+        chunkLimit = CHUNK_SIZE;
 
         // Place carry bytes at the front of the working buffer
         size_t carrySize = carry.size();
@@ -644,52 +958,92 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
             return result;
         }
         if (bytesRead == 0) break; // EOF
+        if (keepBytes) {
+            keepBytes->data.insert(keepBytes->data.end(), chunkBuf.data() + carrySize,
+                                   chunkBuf.data() + carrySize + bytesRead);
+        }
 
         totalRead += bytesRead;
         size_t available = carrySize + bytesRead;
-        bool isLastChunk = (totalRead >= totalBytesToRead);
+        bool isLastChunk = (totalRead >= progress.totalBytes);
 
         // Find the safe boundary so we never split a multi-byte character
         size_t decodable = available;
         if (!isLastChunk) {
-            switch (result.detectedEncoding) {
-                case TextEncoding::UTF8:
-                case TextEncoding::UTF8_BOM:
-                case TextEncoding::ANSI:   // ANSI is single-byte, but this is harmless
-                    decodable = FindUTF8SafeBoundary(chunkBuf.data(), available);
-                    break;
-                case TextEncoding::UTF16_LE:
-                    decodable = FindUTF16SafeBoundary(chunkBuf.data(), available, true);
-                    break;
-                case TextEncoding::UTF16_BE:
-                    decodable = FindUTF16SafeBoundary(chunkBuf.data(), available, false);
-                    break;
-            }
+            decodable = FindSafeBoundary(chunkBuf.data(), available, result.detectedEncoding);
             if (decodable < available) {
                 carry.assign(chunkBuf.data() + decodable,
                              chunkBuf.data() + available);
             }
         }
 
-        // Decode this chunk and append to the result string
-        AppendDecoded(result.content, chunkBuf.data(), decodable, result.detectedEncoding);
+        // Decode this chunk and hand it to the caller
+        decoded.clear();
+        AppendDecoded(decoded, chunkBuf.data(), decodable, result.detectedEncoding);
+        progress.bytesRead = totalRead;
+        if (!onChunk(decoded, progress)) {
+            result.cancelled = true;
+            return result;
+        }
+    }
+
+    result.success = true;
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Decode bytes already in memory chunk by chunk, as ReadFileStreamed() does
+// with a file.  A BOM matching the encoding is skipped; the line ending is
+// detected from the first chunk.
+//------------------------------------------------------------------------------
+FileReadResult FileIO::DecodeStreamed(const RawFileBytes& rawBytes, TextEncoding encoding,
+                                      const FileChunkCallback& onChunk) {
+    QNOTE_TRACE_SCOPE("FileIO::DecodeStreamed");
+    FileReadResult result;
+    result.detectedEncoding = encoding;
+
+    const uint8_t* data = rawBytes.data.data();
+    const size_t size = rawBytes.data.size();
+    size_t start = 0;
+    if (encoding == TextEncoding::UTF8_BOM && StartsWith(data, size, BOM_UTF8, sizeof(BOM_UTF8))) {
+        start = sizeof(BOM_UTF8);
+    } else if ((encoding == TextEncoding::UTF16_LE || encoding == TextEncoding::UTF16_BE) &&
+               (StartsWith(data, size, BOM_UTF16_LE, sizeof(BOM_UTF16_LE)) ||
+                StartsWith(data, size, BOM_UTF16_BE, sizeof(BOM_UTF16_BE)))) {
+        start = sizeof(BOM_UTF16_LE);
+    }
+
+    FileReadProgress progress;
+    progress.encoding = encoding;
+    progress.totalBytes = static_cast<long long>(size - start);
+
+    std::wstring decoded;
+    size_t pos = start;
+    size_t chunkLimit = FIRST_CHUNK_SIZE;
+    bool firstChunk = true;
+    while (pos < size) {
+        size_t available = (std::min)(size - pos, chunkLimit);
+        chunkLimit = CHUNK_SIZE;
 
-        // Update progress in status bar
-        int pct = static_cast<int>(totalRead * 100 / totalBytesToRead);
-        if (hwndStatus && pct != lastPercent) {
-            lastPercent = pct;
-            wchar_t buf[80];
-            double mb = static_cast<double>(totalRead) / (1024.0 * 1024.0);
-            double totalMb = static_cast<double>(totalBytesToRead) / (1024.0 * 1024.0);
-            swprintf_s(buf, L"Loading... %d%%  (%.0f / %.0f MB)", pct, mb, totalMb);
-            SendMessageW(hwndStatus, SB_SETTEXTW, 0, reinterpret_cast<LPARAM>(buf));
+        // Never split a character between chunks
+        size_t decodable = available;
+        if (pos + available < size) {
+            decodable = FindSafeBoundary(data + pos, available, encoding);
+            if (decodable == 0) decodable = available;
         }
 
-        // Pump the message queue so the UI stays responsive
-        MSG msg;
-        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
-            TranslateMessage(&msg);
-            DispatchMessageW(&msg);
+        decoded.clear();
+        AppendDecoded(decoded, data + pos, decodable, encoding);
+        if (firstChunk) {
+            firstChunk = false;
+            result.detectedLineEnding = DetectLineEnding(decoded);
+            progress.lineEnding = result.detectedLineEnding;
+        }
+        pos += decodable;
+        progress.bytesRead = static_cast<long long>(pos - start);
+        if (!onChunk(decoded, progress)) {
+            result.cancelled = true;
+            return result;
         }
     }
 
@@ -702,14 +1056,24 @@ FileReadResult FileIO::ReadFileLarge(const std::wstring& filePath, HWND hwndStat
 //------------------------------------------------------------------------------
 FileWriteResult FileIO::WriteFile(const std::wstring& filePath, const std::wstring& content,
                                    TextEncoding encoding, LineEnding lineEnding) {
+    QNOTE_TRACE_SCOPE("FileIO::WriteFile");
     FileWriteResult result;
     
-    // Convert line endings in the content
-    std::wstring normalizedContent = NormalizeToLF(content);
-    std::wstring outputContent = ConvertLineEndings(normalizedContent, lineEnding);
-    
-    // Encode to bytes
-    std::vector<uint8_t> data = EncodeFromWString(outputContent, encoding);
+    // Convert line endings in one pass; text that already uses the target
+    // ending is encoded as is, without a copy
+    std::vector<uint8_t> data;
+    LineEndingCounts eolCounts = CountLineEndings(content);
+    size_t matching = (lineEnding == LineEnding::LF) ? eolCounts.lf
+                    : (lineEnding == LineEnding::CR) ? eolCounts.cr
+                    : eolCounts.crlf;
+    if (matching == eolCounts.Total()) {
+        data = EncodeFromWString(content, encoding);
+    } else {
+        std::wstring_view newline = LineEndingSequence(lineEnding);
+        std::wstring converted(ConvertedLength(eolCounts, content.size(), newline), L'\0');
+        WriteConvertedLineEndings(content, newline, converted.data());
+        data = EncodeFromWString(converted, encoding);
+    }
     
     // Open file for writing
     HandleGuard hFile(CreateFileW(filePath.c_str(), GENERIC_WRITE, 0,
@@ -738,39 +1102,30 @@ FileWriteResult FileIO::WriteFile(const std::wstring& filePath, const std::wstri
 }
 
 //------------------------------------------------------------------------------
-// Convert line endings in text
+// Characters written for a line ending
 //------------------------------------------------------------------------------
-std::wstring FileIO::ConvertLineEndings(const std::wstring& text, LineEnding targetEnding) {
-    std::wstring result;
-    result.reserve(text.size() + text.size() / 20); // Reserve extra space for potential CRLF
-    
-    const wchar_t* newLine;
-    size_t newLineLen;
-    switch (targetEnding) {
-        case LineEnding::CRLF: newLine = L"\r\n"; newLineLen = 2; break;
-        case LineEnding::LF:   newLine = L"\n";   newLineLen = 1; break;
-        case LineEnding::CR:   newLine = L"\r";   newLineLen = 1; break;
-        default: newLine = L"\r\n"; newLineLen = 2; break;
+std::wstring_view FileIO::LineEndingSequence(LineEnding ending) noexcept {
+    switch (ending) {
+        case LineEnding::LF: return L"\n";
+        case LineEnding::CR: return L"\r";
+        case LineEnding::CRLF:
+        default:             return L"\r\n";
     }
-    
-    size_t start = 0;
-    for (size_t i = 0; i < text.size(); i++) {
-        if (text[i] == L'\r') {
-            result.append(text, start, i - start);
-            result.append(newLine, newLineLen);
-            // Skip LF if it follows CR (CRLF sequence)
-            if (i + 1 < text.size() && text[i + 1] == L'\n') {
-                i++;
-            }
-            start = i + 1;
-        } else if (text[i] == L'\n') {
-            result.append(text, start, i - start);
-            result.append(newLine, newLineLen);
-            start = i + 1;
-        }
+}
+
+//------------------------------------------------------------------------------
+// Convert line endings in text.  The output size is computed up front so the
+// result is allocated once.
+//------------------------------------------------------------------------------
+std::wstring FileIO::ConvertLineEndings(const std::wstring& text, LineEnding targetEnding) {
+    std::wstring_view newline = LineEndingSequence(targetEnding);
+    LineEndingCounts counts = CountLineEndings(text);
+    if (counts.Total() == 0) {
+        return text;
     }
-    result.append(text, start, text.size() - start);
     
+    std::wstring result(ConvertedLength(counts, text.size(), newline), L'\0');
+    WriteConvertedLineEndings(text, newline, result.data());
     return result;
 }
 
@@ -778,23 +1133,8 @@ std::wstring FileIO::ConvertLineEndings(const std::wstring& text, LineEnding tar
 // Normalize line endings to LF for internal use
 //------------------------------------------------------------------------------
 std::wstring FileIO::NormalizeToLF(const std::wstring& text) {
-    std::wstring result;
-    result.reserve(text.size());
-    
-    size_t start = 0;
-    for (size_t i = 0; i < text.size(); i++) {
-        if (text[i] == L'\r') {
-            result.append(text, start, i - start);
-            result += L'\n';
-            // Skip LF if it follows CR (CRLF sequence)
-            if (i + 1 < text.size() && text[i + 1] == L'\n') {
-                i++;
-            }
-            start = i + 1;
-        }
-    }
-    result.append(text, start, text.size() - start);
-    
+    std::wstring result = text;
+    ConvertLineEndingsInPlace(result, L"\n");
     return result;
 }
 
@@ -812,6 +1152,12 @@ std::wstring FileIO::GetFileName(const std::wstring& filePath) {
 //------------------------------------------------------------------------------
 // Format error message from GetLastError
 //------------------------------------------------------------------------------
+ULONGLONG FileIO::GetFileSizeBytes(const std::wstring& filePath) {
+    WIN32_FILE_ATTRIBUTE_DATA fad = {};
+    if (!GetFileAttributesExW(filePath.c_str(), GetFileExInfoStandard, &fad)) return 0;
+    return (static_cast<ULONGLONG>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+}
+
 std::wstring FileIO::FormatLastError(DWORD errorCode) {
     wchar_t* buffer = nullptr;
     DWORD size = FormatMessageW(
@@ -12,13 +12,31 @@
 #define NOMINMAX
 #endif
 #include <Windows.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <string_view>
 #include "Settings.h"
+#include "LineEndingScan.h"
+#include "TaskScheduler.h"
 
 namespace QNote {
 
+//------------------------------------------------------------------------------
+// Raw bytes of a file as read from disk, kept so the document can be decoded
+// again (Reopen with Encoding) without touching the disk
+//------------------------------------------------------------------------------
+struct RawFileBytes {
+    std::vector<uint8_t> data;
+    ULONGLONG fileSize = 0;
+    FILETIME lastWriteTime = {};
+    
+    // True if the file on disk has not changed since these bytes were read
+    [[nodiscard]] bool MatchesFile(const std::wstring& filePath) const;
+};
+
 //------------------------------------------------------------------------------
 // File read result structure
 //------------------------------------------------------------------------------
@@ -28,8 +46,24 @@ struct FileReadResult {
     std::wstring errorMessage;
     TextEncoding detectedEncoding = TextEncoding::UTF8;
     LineEnding detectedLineEnding = LineEnding::CRLF;
+    bool mixedLineEndings = false;         // More than one kind of line break was found
+    bool cancelled = false;                // Streamed read stopped by its callback
+    std::shared_ptr<RawFileBytes> rawBytes; // Source bytes (ReadFile/ReadFileWithEncoding only)
+};
+
+//------------------------------------------------------------------------------
+// Progress reported with each chunk of a streamed read
+//------------------------------------------------------------------------------
+struct FileReadProgress {
+    TextEncoding encoding = TextEncoding::UTF8;
+    LineEnding lineEnding = LineEnding::CRLF;
+    long long bytesRead = 0;
+    long long totalBytes = 0;
 };
 
+// Receives each decoded chunk (may be moved from); return false to cancel
+using FileChunkCallback = std::function<bool(std::wstring& chunk, const FileReadProgress& progress)>;
+
 //------------------------------------------------------------------------------
 // File write result structure
 //------------------------------------------------------------------------------
@@ -43,17 +77,45 @@ struct FileWriteResult {
 //------------------------------------------------------------------------------
 class FileIO {
 public:
-    // Read a file with automatic encoding detection
+    // Read a file with automatic encoding detection.  Files over 100 MB go
+    // through ReadFileLarge(), which pumps the calling thread's messages.
     [[nodiscard]] static FileReadResult ReadFile(const std::wstring& filePath);
     
+    // Same as ReadFile(), but never pumps messages: for worker threads
+    [[nodiscard]] static FileReadResult ReadFileInBackground(const std::wstring& filePath);
+    
     // Read a file forcing a specific encoding (for "Reopen with Encoding")
     [[nodiscard]] static FileReadResult ReadFileWithEncoding(const std::wstring& filePath, TextEncoding encoding);
     
+    // Decode previously read bytes with a specific encoding (no disk access).
+    // Large inputs are decoded in parallel chunks.
+    [[nodiscard]] static FileReadResult DecodeFile(const std::shared_ptr<RawFileBytes>& rawBytes,
+                                                   TextEncoding encoding);
+    
+    // Read a whole file without decoding it; null (with 'errorMessage') on failure
+    [[nodiscard]] static std::shared_ptr<RawFileBytes> ReadRawFile(const std::wstring& filePath,
+                                                                   std::wstring& errorMessage);
+    
     // Stream-read a large file in chunks without freezing (supports files >3GB).
     // Reads and decodes in 8MB chunks, pumping the message queue between chunks
     // so the UI stays responsive.  Never buffers the entire raw file in memory.
     [[nodiscard]] static FileReadResult ReadFileLarge(const std::wstring& filePath, HWND hwndStatus = nullptr);
     
+    // Read and decode a file chunk by chunk, handing each decoded chunk to
+    // 'onChunk' instead of accumulating it.  No message pumping, so it is
+    // safe on a worker thread.  The first chunk is small so callers can show
+    // the start of the file quickly.  The returned result has no content.
+    // With 'keepBytes' the file's bytes are collected there as well, for a
+    // later re-decode; if they do not fit in memory it is left empty.
+    [[nodiscard]] static FileReadResult ReadFileStreamed(const std::wstring& filePath,
+                                                         const FileChunkCallback& onChunk,
+                                                         RawFileBytes* keepBytes = nullptr);
+    
+    // ReadFileStreamed() over bytes already read, with a forced encoding
+    // (Reopen with Encoding of a large file, on a worker thread)
+    [[nodiscard]] static FileReadResult DecodeStreamed(const RawFileBytes& rawBytes, TextEncoding encoding,
+                                                       const FileChunkCallback& onChunk);
+    
     // Write a file with specified encoding and line endings
     [[nodiscard]] static FileWriteResult WriteFile(const std::wstring& filePath,
                                      const std::wstring& content,
@@ -62,10 +124,27 @@ public:
     
     // Detect encoding from raw bytes
     [[nodiscard]] static TextEncoding DetectEncoding(const std::vector<uint8_t>& data);
+    [[nodiscard]] static TextEncoding DetectEncoding(const uint8_t* data, size_t size);
+    
+    // Decode raw file bytes (a BOM matching the encoding is skipped)
+    [[nodiscard]] static std::wstring DecodeBytes(const uint8_t* data, size_t size, TextEncoding encoding);
+    
+    // Scheduler that large decodes are split across; without one they run
+    // on the calling thread.  Cleared before the scheduler shuts down.
+    static void SetDecodeScheduler(TaskScheduler* scheduler) noexcept;
+    
+    // Windows code page for an encoding other than UTF-16 (CP_ACP for ANSI)
+    [[nodiscard]] static UINT GetCodePage(TextEncoding encoding) noexcept;
     
     // Detect line ending type from text
     [[nodiscard]] static LineEnding DetectLineEnding(const std::wstring& text);
     
+    // Most common ending in counts from CountLineEndings()
+    [[nodiscard]] static LineEnding PredominantLineEnding(const LineEndingCounts& counts) noexcept;
+    
+    // Characters written for a line ending ("\r\n", "\n" or "\r")
+    [[nodiscard]] static std::wstring_view LineEndingSequence(LineEnding ending) noexcept;
+    
     // Convert line endings in text
     [[nodiscard]] static std::wstring ConvertLineEndings(const std::wstring& text, LineEnding targetEnding);
     
@@ -75,6 +154,9 @@ public:
     // Get file name from path
     [[nodiscard]] static std::wstring GetFileName(const std::wstring& filePath);
     
+    // Size of a file in bytes (0 if it cannot be queried)
+    [[nodiscard]] static ULONGLONG GetFileSizeBytes(const std::wstring& filePath);
+    
     // Show Open File dialog
     [[nodiscard]] static bool ShowOpenDialog(HWND parent, std::wstring& outPath);
     
@@ -82,18 +164,34 @@ public:
     [[nodiscard]] static bool ShowSaveDialog(HWND parent, std::wstring& outPath, TextEncoding& outEncoding,
                                const std::wstring& currentPath = L"");
     
+    // Format error message from GetLastError
+    [[nodiscard]] static std::wstring FormatLastError(DWORD errorCode);
+    
 private:
+    // ReadFile() and ReadFileInBackground()
+    static FileReadResult ReadWholeFile(const std::wstring& filePath, bool pumpMessages);
+    
+    // Collect ReadFileStreamed() chunks into one string (ReadFileLarge())
+    static FileReadResult ReadFileChunked(const std::wstring& filePath, HWND hwndStatus,
+                                          bool pumpMessages);
+    
     // Decode bytes to wstring based on encoding
     static std::wstring DecodeToWString(const std::vector<uint8_t>& data, TextEncoding encoding);
     
-    // Append decoded wide chars from a raw-byte span (used by ReadFileLarge)
+    // Decode a BOM-less span, splitting it across worker threads when large
+    static std::wstring DecodeParallel(const uint8_t* data, size_t size, TextEncoding encoding,
+                                       TaskScheduler& scheduler);
+    
+    // Read a whole open file into 'raw' (with its size and write time)
+    static bool ReadRawBytes(HANDLE hFile, LONGLONG size, RawFileBytes& raw, std::wstring& errorMessage);
+    
+    // Append decoded wide chars from a raw-byte span (used by ReadFileStreamed)
     static void AppendDecoded(std::wstring& out, const uint8_t* data, size_t size, TextEncoding encoding);
     
     // Encode wstring to bytes based on encoding
     static std::vector<uint8_t> EncodeFromWString(const std::wstring& text, TextEncoding encoding);
     
-    // Format error message from GetLastError
-    static std::wstring FormatLastError(DWORD errorCode);
+    static std::atomic<TaskScheduler*> s_decodeScheduler;
 };
 
 //------------------------------------------------------------------------------
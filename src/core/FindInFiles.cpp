@@ -0,0 +1,458 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// FindInFiles.cpp - Parallel search of a directory tree implementation
+//==============================================================================
+
+#include "FindInFiles.h"
+#include "FileIO.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <functional>
+
+namespace QNote {
+
+namespace {
+
+// Files below this size are read with one ReadFile instead of being mapped
+constexpr uint64_t MAP_THRESHOLD = 64 * 1024;
+
+// Bytes checked for NUL when deciding whether a file is binary
+constexpr size_t BINARY_PROBE_BYTES = 8192;
+
+// Hits kept per file; the rest of the file is not listed
+constexpr size_t MAX_HITS_PER_FILE = 1000;
+
+//------------------------------------------------------------------------------
+// Split a ';' or ',' separated glob list, trimming spaces
+//------------------------------------------------------------------------------
+std::vector<std::wstring> SplitGlobs(const std::wstring& list) {
+    std::vector<std::wstring> globs;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find_first_of(L";,", start);
+        if (end == std::wstring::npos) end = list.size();
+        size_t first = start;
+        size_t last = end;
+        while (first < last && iswspace(list[first])) first++;
+        while (last > first && iswspace(list[last - 1])) last--;
+        if (last > first) {
+            std::wstring glob = list.substr(first, last - first);
+            std::replace(glob.begin(), glob.end(), L'/', L'\\');
+            globs.push_back(std::move(glob));
+        }
+        start = end + 1;
+    }
+    return globs;
+}
+
+wchar_t FoldCase(wchar_t ch) noexcept {
+    return static_cast<wchar_t>(std::towlower(static_cast<wint_t>(ch)));
+}
+
+//------------------------------------------------------------------------------
+// Case-insensitive '*' / '?' match (iterative, backtracks to the last '*')
+//------------------------------------------------------------------------------
+bool GlobMatch(std::wstring_view glob, std::wstring_view text) noexcept {
+    size_t g = 0, t = 0;
+    size_t starG = std::wstring_view::npos, starT = 0;
+    while (t < text.size()) {
+        if (g < glob.size() && (glob[g] == L'?' || FoldCase(glob[g]) == FoldCase(text[t]))) {
+            g++;
+            t++;
+        } else if (g < glob.size() && glob[g] == L'*') {
+            starG = g++;
+            starT = t;
+        } else if (starG != std::wstring_view::npos) {
+            g = starG + 1;
+            t = ++starT;
+        } else {
+            return false;
+        }
+    }
+    while (g < glob.size() && glob[g] == L'*') g++;
+    return g == glob.size();
+}
+
+//------------------------------------------------------------------------------
+// Raw-byte prefilters.  For encodings where ASCII is stored as single bytes,
+// a file that does not contain an ASCII pattern byte-for-byte cannot
+// contain it once decoded.
+//------------------------------------------------------------------------------
+bool ContainsBytes(const uint8_t* data, size_t size, const std::string& needle) {
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + size;
+    std::boyer_moore_horspool_searcher searcher(needle.begin(), needle.end());
+    return std::search(begin, end, searcher) != end;
+}
+
+bool ContainsBytesNoCase(const uint8_t* data, size_t size, const std::string& lowerNeedle) {
+    const size_t n = lowerNeedle.size();
+    if (size < n) return false;
+    const uint8_t first = static_cast<uint8_t>(lowerNeedle[0]);
+    const uint8_t firstUpper = (first >= 'a' && first <= 'z') ? static_cast<uint8_t>(first - 32) : first;
+    const size_t last = size - n;
+    for (size_t i = 0; i <= last; i++) {
+        if (data[i] != first && data[i] != firstUpper) continue;
+        size_t k = 1;
+        while (k < n) {
+            uint8_t c = data[i + k];
+            if (c >= 'A' && c <= 'Z') c = static_cast<uint8_t>(c + 32);
+            if (c != static_cast<uint8_t>(lowerNeedle[k])) break;
+            k++;
+        }
+        if (k == n) return true;
+    }
+    return false;
+}
+
+bool IsAsciiCompatible(TextEncoding encoding) noexcept {
+    return encoding != TextEncoding::UTF16_LE && encoding != TextEncoding::UTF16_BE;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+FindInFilesSearch::~FindInFilesSearch() {
+    Cancel();
+}
+
+//------------------------------------------------------------------------------
+// Validate the query and queue the root folder
+//------------------------------------------------------------------------------
+bool FindInFilesSearch::Start(const FindInFilesQuery& query, NotifyCallback notify,
+                              std::wstring& errorMessage) {
+    if (m_tasks) {
+        errorMessage = L"A search is already running.";
+        return false;
+    }
+
+    m_query = query;
+    while (m_query.directory.size() > 3 &&
+           (m_query.directory.back() == L'\\' || m_query.directory.back() == L'/')) {
+        m_query.directory.pop_back();
+    }
+
+    DWORD attributes = GetFileAttributesW(m_query.directory.c_str());
+    if (m_query.directory.empty() || attributes == INVALID_FILE_ATTRIBUTES ||
+        !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        errorMessage = L"The folder does not exist: " + m_query.directory;
+        return false;
+    }
+
+    if (m_query.pattern.empty()) {
+        errorMessage = L"Enter text to find.";
+        return false;
+    }
+    if (!m_matcher.Compile(m_query.pattern, m_query.options)) {
+        errorMessage = L"The regular expression is not valid.";
+        return false;
+    }
+
+    // Raw-byte prefilter for plain ASCII patterns
+    m_asciiNeedle.clear();
+    if (!m_query.options.useRegex) {
+        bool ascii = std::all_of(m_query.pattern.begin(), m_query.pattern.end(),
+                                 [](wchar_t c) { return c > 0 && c < 0x80; });
+        if (ascii) {
+            for (wchar_t c : m_query.pattern) {
+                char b = static_cast<char>(c);
+                if (!m_query.options.matchCase && b >= 'A' && b <= 'Z') b = static_cast<char>(b + 32);
+                m_asciiNeedle += b;
+            }
+        }
+    }
+
+    m_includeGlobs = SplitGlobs(m_query.include);
+    m_excludeGlobs = SplitGlobs(m_query.exclude);
+    m_notify = std::move(notify);
+
+    m_tasks = std::make_shared<TaskGroup>();
+    m_token = CancellationToken::Create();
+
+    WorkItem root;
+    root.path = m_query.directory;
+    root.isDirectory = true;
+    if (!Push(std::move(root))) {
+        errorMessage = L"Could not start the search.";
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop the queued items and wait for the ones being worked on.  The search
+// counts as finished, so the window stops waiting for it.
+//------------------------------------------------------------------------------
+void FindInFilesSearch::Cancel() noexcept {
+    m_cancel = true;
+    m_token.Cancel();
+    if (m_tasks) {
+        m_tasks->Close();
+    }
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_finished = true;
+}
+
+//------------------------------------------------------------------------------
+// Results found since the last call
+//------------------------------------------------------------------------------
+std::vector<FindInFilesFileResult> FindInFilesSearch::TakeResults() {
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    std::vector<FindInFilesFileResult> results;
+    results.swap(m_results);
+    m_notifyPending = false;
+    return results;
+}
+
+bool FindInFilesSearch::IsFinished() const {
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    return m_finished;
+}
+
+FindInFilesStats FindInFilesSearch::GetStats() const {
+    FindInFilesStats stats;
+    stats.filesSearched = m_filesSearched.load();
+    stats.filesSkipped = m_filesSkipped.load();
+    stats.bytesSearched = m_bytesSearched.load();
+    stats.hits = std::min(m_hitCount.load(), m_query.maxHits);
+    stats.truncated = m_limitReached.load();
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    stats.filesMatched = m_filesMatched;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+// Queue one directory or file.  Queued from a task it goes on that worker's
+// own queue: the worker takes its newest item (depth first, warm caches)
+// and thieves the oldest, which near the root are the largest subtrees.
+// Tasks hold the group, not this object, so Cancel() can close it.
+//------------------------------------------------------------------------------
+bool FindInFilesSearch::Push(WorkItem&& item) {
+    m_pendingItems.fetch_add(1);
+    auto task = [this, tasks = m_tasks, item = std::move(item)]() {
+        tasks->Run([this, &item]() { RunItem(item); });
+    };
+    if (m_scheduler.Submit(std::move(task), TaskPriority::Normal, m_token)) {
+        return true;
+    }
+    if (m_pendingItems.fetch_sub(1) == 1) {
+        Publish(FindInFilesFileResult{}, true);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// One item's task.  The search is over when no item is queued or in
+// progress; items left once it stops are skipped.
+//------------------------------------------------------------------------------
+void FindInFilesSearch::RunItem(const WorkItem& item) {
+    if (!ShouldStop()) {
+        try {
+            if (item.isDirectory) {
+                ScanDirectory(item.path);
+            } else {
+                SearchFile(item);
+            }
+        } catch (const std::bad_alloc&) {
+            m_filesSkipped.fetch_add(1);
+        }
+    }
+
+    if (m_pendingItems.fetch_sub(1) == 1) {
+        Publish(FindInFilesFileResult{}, true);
+    }
+}
+
+//------------------------------------------------------------------------------
+// List one directory, queueing subdirectories and candidate files
+//------------------------------------------------------------------------------
+void FindInFilesSearch::ScanDirectory(const std::wstring& directory) {
+    std::wstring searchPath = directory;
+    if (searchPath.back() != L'\\') searchPath += L'\\';
+    const size_t prefixLength = searchPath.size();
+    searchPath += L'*';
+
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileExW(searchPath.c_str(), FindExInfoBasic, &findData,
+                                    FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) return;
+
+    searchPath.resize(prefixLength);
+    do {
+        if (ShouldStop()) break;
+
+        const wchar_t* name = findData.cFileName;
+        if (name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0'))) continue;
+        // Junctions and symlinks could loop back into the tree
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+
+        WorkItem child;
+        child.path = searchPath + name;
+        const std::wstring fileName(name);
+
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (!m_query.recursive || IsExcluded(child.path, fileName)) continue;
+            child.isDirectory = true;
+            (void)Push(std::move(child));
+            continue;
+        }
+
+        if (!IsIncluded(child.path, fileName) || IsExcluded(child.path, fileName)) continue;
+
+        child.size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+        if (child.size > m_query.maxFileBytes) {
+            m_filesSkipped.fetch_add(1);
+            continue;
+        }
+        (void)Push(std::move(child));
+    } while (FindNextFileW(hFind, &findData));
+
+    FindClose(hFind);
+}
+
+//------------------------------------------------------------------------------
+// Read one file, prefilter its bytes, decode and search it
+//------------------------------------------------------------------------------
+void FindInFilesSearch::SearchFile(const WorkItem& item) {
+    QNOTE_TRACE_SCOPE("FindInFiles::SearchFile");
+    HandleGuard hFile(CreateFileW(item.path.c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    LARGE_INTEGER fileSize;
+    if (!hFile.valid() || !GetFileSizeEx(hFile.get(), &fileSize) ||
+        static_cast<uint64_t>(fileSize.QuadPart) > m_query.maxFileBytes) {
+        m_filesSkipped.fetch_add(1);
+        return;
+    }
+
+    const size_t size = static_cast<size_t>(fileSize.QuadPart);
+    m_filesSearched.fetch_add(1);
+    if (size == 0) return;
+
+    // Small files: one read into a per-thread buffer.  Larger: map the file.
+    thread_local std::vector<uint8_t> readBuffer;
+    HandleGuard hMapping(nullptr);
+    const uint8_t* data = nullptr;
+    const void* view = nullptr;
+
+    if (size < MAP_THRESHOLD) {
+        readBuffer.resize(size);
+        DWORD bytesRead = 0;
+        if (!::ReadFile(hFile.get(), readBuffer.data(), static_cast<DWORD>(size), &bytesRead, nullptr) ||
+            bytesRead != size) {
+            m_filesSkipped.fetch_add(1);
+            return;
+        }
+        data = readBuffer.data();
+    } else {
+        hMapping = HandleGuard(CreateFileMappingW(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        if (!hMapping.valid()) {
+            m_filesSkipped.fetch_add(1);
+            return;
+        }
+        view = MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            m_filesSkipped.fetch_add(1);
+            return;
+        }
+        data = static_cast<const uint8_t*>(view);
+    }
+
+    struct ViewGuard {
+        const void* view;
+        ~ViewGuard() { if (view) UnmapViewOfFile(view); }
+    } viewGuard{ view };
+
+    m_bytesSearched.fetch_add(size);
+
+    TextEncoding encoding = FileIO::DetectEncoding(data, size);
+    if (IsAsciiCompatible(encoding)) {
+        if (std::memchr(data, 0, std::min(size, BINARY_PROBE_BYTES))) {
+            m_filesSkipped.fetch_add(1);
+            return;
+        }
+        if (!m_asciiNeedle.empty()) {
+            bool found = m_query.options.matchCase ? ContainsBytes(data, size, m_asciiNeedle)
+                                                   : ContainsBytesNoCase(data, size, m_asciiNeedle);
+            if (!found) return;
+        }
+    }
+
+    std::wstring text = FileIO::DecodeBytes(data, size, encoding);
+    SearchText(item.path, text);
+}
+
+//------------------------------------------------------------------------------
+// Collect the hits in one decoded file
+//------------------------------------------------------------------------------
+void FindInFilesSearch::SearchText(const std::wstring& filePath, std::wstring_view text) {
+    FindInFilesFileResult result;
+    result.filePath = filePath;
+
+    (void)CollectLineHits(m_matcher, text, MAX_HITS_PER_FILE, false, result.hits, &m_cancel);
+    if (result.hits.empty()) return;
+
+    if (m_hitCount.fetch_add(result.hits.size()) + result.hits.size() >= m_query.maxHits) {
+        m_limitReached = true;
+    }
+    Publish(std::move(result), false);
+}
+
+//------------------------------------------------------------------------------
+// Hand results to the UI.  Only the first batch after a TakeResults() call
+// (and the end of the search) notifies, so a fast search does not flood
+// the window's message queue.
+//------------------------------------------------------------------------------
+void FindInFilesSearch::Publish(FindInFilesFileResult&& result, bool finished) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        if (!result.hits.empty()) {
+            m_results.push_back(std::move(result));
+            m_filesMatched++;
+        }
+        if (finished) m_finished = true;
+        if (!m_notifyPending && (finished || !m_results.empty())) {
+            m_notifyPending = true;
+            notify = true;
+        }
+    }
+    if (notify && m_notify) {
+        m_notify();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Glob filters
+//------------------------------------------------------------------------------
+bool FindInFilesSearch::MatchesAny(const std::vector<std::wstring>& globs,
+                                   std::wstring_view relativePath, std::wstring_view name) {
+    for (const auto& glob : globs) {
+        bool pathGlob = glob.find(L'\\') != std::wstring::npos;
+        if (GlobMatch(glob, pathGlob ? relativePath : name)) return true;
+    }
+    return false;
+}
+
+std::wstring_view FindInFilesSearch::RelativePath(const std::wstring& path) const noexcept {
+    size_t prefix = m_query.directory.size();
+    if (prefix > 0 && m_query.directory.back() != L'\\') prefix++;
+    std::wstring_view relative(path);
+    relative.remove_prefix(std::min(relative.size(), prefix));
+    return relative;
+}
+
+bool FindInFilesSearch::IsIncluded(const std::wstring& path, const std::wstring& name) const {
+    return m_includeGlobs.empty() || MatchesAny(m_includeGlobs, RelativePath(path), name);
+}
+
+bool FindInFilesSearch::IsExcluded(const std::wstring& path, const std::wstring& name) const {
+    return !m_excludeGlobs.empty() && MatchesAny(m_excludeGlobs, RelativePath(path), name);
+}
+
+} // namespace QNote
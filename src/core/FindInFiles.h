@@ -0,0 +1,147 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// FindInFiles.h - Parallel search of a directory tree
+//==============================================================================
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TaskScheduler.h"
+#include "TextSearch.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// What to search for and where.  Glob lists are separated by ';' or ',' and
+// use '*' and '?'; a glob containing a path separator is matched against
+// the path relative to 'directory', any other against the file name.
+//------------------------------------------------------------------------------
+struct FindInFilesQuery {
+    std::wstring directory;
+    std::wstring pattern;
+    TextSearchOptions options;
+    std::wstring include;                  // Files to search (empty: all)
+    std::wstring exclude;                  // Files and folders to skip
+    bool recursive = true;
+    uint64_t maxFileBytes = 64ULL * 1024 * 1024;
+    size_t maxHits = 100000;               // The search stops after this many hits
+};
+
+// One match (see TextLineHit)
+using FindInFilesHit = TextLineHit;
+
+struct FindInFilesFileResult {
+    std::wstring filePath;
+    std::vector<FindInFilesHit> hits;
+};
+
+struct FindInFilesStats {
+    size_t filesSearched = 0;
+    size_t filesMatched = 0;
+    size_t filesSkipped = 0;               // Binary, too large or unreadable
+    size_t hits = 0;
+    uint64_t bytesSearched = 0;
+    bool truncated = false;                // Stopped at maxHits
+};
+
+//------------------------------------------------------------------------------
+// A running search.  Every directory and file is a task on the scheduler;
+// a worker queues what it lists on its own queue and idle workers steal
+// from it, so one huge folder is spread over every worker.  Tasks run at
+// normal priority, so a long search does not hold up opening files.
+// Files are read through a mapping (small ones with one ReadFile), the
+// encoding is detected with FileIO::DetectEncoding, and ASCII patterns are
+// looked for in the raw bytes before anything is decoded.
+//
+// Results collect in a queue drained with TakeResults().  'notify' is
+// called on a worker thread when results are waiting and the previous
+// notification has been consumed, and once more when the search ends;
+// it typically posts a message to the window that shows the results.
+//------------------------------------------------------------------------------
+class FindInFilesSearch {
+public:
+    using NotifyCallback = std::function<void()>;
+
+    explicit FindInFilesSearch(TaskScheduler& scheduler) : m_scheduler(scheduler) {}
+    ~FindInFilesSearch();
+
+    FindInFilesSearch(const FindInFilesSearch&) = delete;
+    FindInFilesSearch& operator=(const FindInFilesSearch&) = delete;
+
+    // Start searching (once per object); false (with a message) if the pattern or folder is invalid
+    [[nodiscard]] bool Start(const FindInFilesQuery& query, NotifyCallback notify,
+                             std::wstring& errorMessage);
+
+    // Stop the search and wait for the items being worked on
+    void Cancel() noexcept;
+
+    // Results found since the last call (resets the notification)
+    [[nodiscard]] std::vector<FindInFilesFileResult> TakeResults();
+
+    [[nodiscard]] bool IsFinished() const;
+    [[nodiscard]] bool WasCancelled() const noexcept { return m_cancel.load(); }
+    [[nodiscard]] FindInFilesStats GetStats() const;
+
+private:
+    struct WorkItem {
+        std::wstring path;
+        bool isDirectory = false;
+        uint64_t size = 0;
+    };
+
+    [[nodiscard]] bool Push(WorkItem&& item);
+    void RunItem(const WorkItem& item);
+
+    void ScanDirectory(const std::wstring& directory);
+    void SearchFile(const WorkItem& item);
+    void SearchText(const std::wstring& filePath, std::wstring_view text);
+    void Publish(FindInFilesFileResult&& result, bool finished);
+
+    [[nodiscard]] bool ShouldStop() const noexcept { return m_cancel.load() || m_limitReached.load(); }
+    [[nodiscard]] std::wstring_view RelativePath(const std::wstring& path) const noexcept;
+    [[nodiscard]] bool IsIncluded(const std::wstring& path, const std::wstring& name) const;
+    [[nodiscard]] bool IsExcluded(const std::wstring& path, const std::wstring& name) const;
+    [[nodiscard]] static bool MatchesAny(const std::vector<std::wstring>& globs,
+                                         std::wstring_view relativePath, std::wstring_view name);
+
+    FindInFilesQuery m_query;
+    TextMatcher m_matcher;
+    std::string m_asciiNeedle;             // Raw-byte prefilter (empty: none)
+    std::vector<std::wstring> m_includeGlobs;
+    std::vector<std::wstring> m_excludeGlobs;
+
+    TaskScheduler& m_scheduler;
+    std::shared_ptr<TaskGroup> m_tasks;
+    CancellationToken m_token;
+    std::atomic<size_t> m_pendingItems{ 0 };   // Queued or being processed
+    std::atomic<size_t> m_hitCount{ 0 };
+    std::atomic<size_t> m_filesSearched{ 0 };
+    std::atomic<size_t> m_filesSkipped{ 0 };
+    std::atomic<uint64_t> m_bytesSearched{ 0 };
+    std::atomic<bool> m_cancel{ false };
+    std::atomic<bool> m_limitReached{ false };
+
+    // Guarded by m_resultMutex
+    mutable std::mutex m_resultMutex;
+    std::vector<FindInFilesFileResult> m_results;
+    size_t m_filesMatched = 0;
+    bool m_notifyPending = false;
+    bool m_finished = false;
+    NotifyCallback m_notify;
+};
+
+} // namespace QNote
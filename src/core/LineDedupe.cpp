@@ -0,0 +1,210 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineDedupe.cpp - Hash-based duplicate line detection implementation
+//==============================================================================
+
+#include "LineDedupe.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <string>
+
+namespace QNote {
+
+namespace {
+
+//------------------------------------------------------------------------------
+// 64-bit hash over the raw code units, consumed 8 bytes per step
+//------------------------------------------------------------------------------
+uint64_t Mix(uint64_t x) noexcept {
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ull;
+    x ^= x >> 32;
+    return x;
+}
+
+uint64_t HashKey(std::wstring_view key) noexcept {
+    const auto* p = reinterpret_cast<const unsigned char*>(key.data());
+    size_t size = key.size() * sizeof(wchar_t);
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ size;
+    while (size >= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        h = Mix(h ^ word) + 0x9E3779B97F4A7C15ull;
+        p += sizeof(word);
+        size -= sizeof(word);
+    }
+    if (size > 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, p, size);
+        h = Mix(h ^ word);
+    }
+    return Mix(h);
+}
+
+//------------------------------------------------------------------------------
+// Build the comparison key for a line.  Returns the line itself when no
+// normalization changes it, otherwise a view of 'scratch'.
+//------------------------------------------------------------------------------
+std::wstring_view NormalizeKey(std::wstring_view line, const LineDedupeOptions& options,
+                               std::wstring& scratch) {
+    if (options.ignoreWhitespace) {
+        size_t first = line.find_first_not_of(L" \t");
+        if (first == std::wstring_view::npos) return {};
+        line = line.substr(first, line.find_last_not_of(L" \t") - first + 1);
+    }
+
+    // Fast path: nothing to fold or collapse
+    bool needsCopy = false;
+    for (size_t i = 0; i < line.size() && !needsCopy; ++i) {
+        wchar_t ch = line[i];
+        if (options.ignoreCase && static_cast<wchar_t>(std::towlower(ch)) != ch) needsCopy = true;
+        if (options.ignoreWhitespace && (ch == L'\t' ||
+            (ch == L' ' && i + 1 < line.size() && (line[i + 1] == L' ' || line[i + 1] == L'\t')))) {
+            needsCopy = true;
+        }
+    }
+    if (!needsCopy) return line;
+
+    scratch.clear();
+    bool inSpace = false;
+    for (wchar_t ch : line) {
+        if (options.ignoreWhitespace && (ch == L' ' || ch == L'\t')) {
+            if (!inSpace) scratch.push_back(L' ');
+            inSpace = true;
+            continue;
+        }
+        inSpace = false;
+        scratch.push_back(options.ignoreCase ? static_cast<wchar_t>(std::towlower(ch)) : ch);
+    }
+    return scratch;
+}
+
+//------------------------------------------------------------------------------
+// Open-addressing table of distinct keys.  Slots hold entry index + 1
+// (0 = empty); entries are appended in first-occurrence order.
+//------------------------------------------------------------------------------
+class KeyTable {
+public:
+    struct Entry {
+        uint64_t hash;
+        std::wstring_view key;
+        uint32_t firstLine;
+        uint32_t count;
+    };
+
+    explicit KeyTable(size_t expected) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < expected + expected / 2 && capacity < INITIAL_CAPACITY_LIMIT) capacity <<= 1;
+        m_slots.assign(capacity, 0);
+    }
+
+    // Count one occurrence of 'key'.  Returns the new entry when the key was
+    // not seen before, so the caller can make its key storage permanent.
+    Entry* Add(std::wstring_view key, uint64_t hash, uint32_t line) {
+        size_t mask = m_slots.size() - 1;
+        for (size_t slot = static_cast<size_t>(hash) & mask; ; slot = (slot + 1) & mask) {
+            uint32_t index = m_slots[slot];
+            if (index == 0) {
+                m_entries.push_back({ hash, key, line, 1 });
+                m_slots[slot] = static_cast<uint32_t>(m_entries.size());
+                if (m_entries.size() * 10 > m_slots.size() * 7) Grow();
+                return &m_entries.back();
+            }
+            Entry& entry = m_entries[index - 1];
+            if (entry.hash == hash && entry.key == key) {
+                ++entry.count;
+                return nullptr;
+            }
+        }
+    }
+
+    [[nodiscard]] const std::vector<Entry>& Entries() const noexcept { return m_entries; }
+
+private:
+    void Grow() {
+        std::vector<uint32_t> slots(m_slots.size() * 2, 0);
+        size_t mask = slots.size() - 1;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            size_t slot = static_cast<size_t>(m_entries[i].hash) & mask;
+            while (slots[slot] != 0) slot = (slot + 1) & mask;
+            slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+        m_slots.swap(slots);
+    }
+
+    static constexpr size_t MIN_CAPACITY = 1024;
+    static constexpr size_t INITIAL_CAPACITY_LIMIT = size_t(1) << 22;  // Grow on demand past this
+
+    std::vector<uint32_t> m_slots;
+    std::vector<Entry> m_entries;
+};
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Deduplicate line views in place
+//------------------------------------------------------------------------------
+void DedupeLines(std::vector<std::wstring_view>& lines, const LineDedupeOptions& options,
+                 TextArena& arena) {
+    if (lines.empty()) return;
+
+    // Normalized keys that differ from their line are kept only for
+    // distinct entries; duplicates are dropped after the lookup
+    TextArena keyArena;
+    std::wstring scratch;
+    KeyTable table(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::wstring_view key = NormalizeKey(lines[i], options, scratch);
+        KeyTable::Entry* added = table.Add(key, HashKey(key), static_cast<uint32_t>(i));
+        if (added && !key.empty() && key.data() == scratch.data()) {
+            added->key = keyArena.Store(key);
+        }
+    }
+
+    const auto& entries = table.Entries();
+    std::vector<std::wstring_view> result;
+    switch (options.mode) {
+        case DedupeMode::RemoveDuplicates:
+            result.reserve(entries.size());
+            for (const auto& entry : entries) result.push_back(lines[entry.firstLine]);
+            break;
+
+        case DedupeMode::ShowDuplicates:
+            for (const auto& entry : entries) {
+                if (entry.count > 1) result.push_back(lines[entry.firstLine]);
+            }
+            break;
+
+        case DedupeMode::CountOccurrences: {
+            uint32_t maxCount = 0;
+            for (const auto& entry : entries) maxCount = (std::max)(maxCount, entry.count);
+            size_t width = std::to_wstring(maxCount).size();
+
+            result.reserve(entries.size());
+            for (const auto& entry : entries) {
+                std::wstring count = std::to_wstring(entry.count);
+                std::wstring pad(width - count.size(), L' ');
+                result.push_back(arena.Concat({ pad, count, L"  ", lines[entry.firstLine] }));
+            }
+            break;
+        }
+    }
+    lines.swap(result);
+}
+
+namespace LineTransforms {
+
+//------------------------------------------------------------------------------
+// Pipeline stage wrapping DedupeLines()
+//------------------------------------------------------------------------------
+LinePipeline::ListFn Dedupe(const LineDedupeOptions& options) {
+    return [options](std::vector<std::wstring_view>& lines, TextArena& arena) {
+        DedupeLines(lines, options, arena);
+    };
+}
+
+} // namespace LineTransforms
+
+} // namespace QNote
@@ -0,0 +1,45 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineDedupe.h - Hash-based duplicate line detection
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <string_view>
+#include <vector>
+#include "LineTransform.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// What to do with duplicated lines
+//------------------------------------------------------------------------------
+enum class DedupeMode {
+    RemoveDuplicates,   // Keep the first occurrence of every line
+    ShowDuplicates,     // Keep only lines that occur more than once (first occurrence)
+    CountOccurrences    // Keep every line once, prefixed with its occurrence count
+};
+
+struct LineDedupeOptions {
+    DedupeMode mode = DedupeMode::RemoveDuplicates;
+    bool ignoreCase = false;
+    bool ignoreWhitespace = false;  // Trim ends and collapse space/tab runs before comparing
+};
+
+//------------------------------------------------------------------------------
+// Deduplicate line views in place.  Lines are hashed a word at a time into
+// an open-addressing table of (hash, key) entries; output keeps the order
+// of first occurrences.  Count mode allocates its prefixed lines in 'arena'.
+//------------------------------------------------------------------------------
+void DedupeLines(std::vector<std::wstring_view>& lines, const LineDedupeOptions& options,
+                 TextArena& arena);
+
+namespace LineTransforms {
+
+// Pipeline stage wrapping DedupeLines()
+[[nodiscard]] LinePipeline::ListFn Dedupe(const LineDedupeOptions& options);
+
+} // namespace LineTransforms
+
+} // namespace QNote
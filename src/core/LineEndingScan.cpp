@@ -0,0 +1,218 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineEndingScan.cpp - Vectorized line-ending counting and conversion
+//==============================================================================
+
+#include "LineEndingScan.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QNOTE_EOLSCAN_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace QNote {
+
+namespace {
+
+// Characters classified per step
+constexpr size_t BLOCK_CHARS = 16;
+
+unsigned CountTrailingZeros(uint32_t value) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+unsigned PopCount(uint32_t value) noexcept {
+#if defined(_MSC_VER)
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    return static_cast<unsigned>((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#else
+    return static_cast<unsigned>(__builtin_popcount(value));
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Bit i of 'cr' / 'lf' is set when p[i] is CR / LF, for BLOCK_CHARS
+// characters.  wchar_t is 16 bits on Windows and 32 bits elsewhere; the
+// compare results are narrowed to one byte per character either way.
+//------------------------------------------------------------------------------
+void ClassifyBlock(const wchar_t* p, uint32_t& cr, uint32_t& lf) noexcept {
+#ifdef QNOTE_EOLSCAN_SSE2
+    const __m128i* v = reinterpret_cast<const __m128i*>(p);
+    if constexpr (sizeof(wchar_t) == 2) {
+        const __m128i crNeedle = _mm_set1_epi16(L'\r');
+        const __m128i lfNeedle = _mm_set1_epi16(L'\n');
+        __m128i a = _mm_loadu_si128(v);
+        __m128i b = _mm_loadu_si128(v + 1);
+        cr = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_packs_epi16(_mm_cmpeq_epi16(a, crNeedle), _mm_cmpeq_epi16(b, crNeedle))));
+        lf = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_packs_epi16(_mm_cmpeq_epi16(a, lfNeedle), _mm_cmpeq_epi16(b, lfNeedle))));
+    } else {
+        const __m128i crNeedle = _mm_set1_epi32(L'\r');
+        const __m128i lfNeedle = _mm_set1_epi32(L'\n');
+        __m128i a = _mm_loadu_si128(v);
+        __m128i b = _mm_loadu_si128(v + 1);
+        __m128i c = _mm_loadu_si128(v + 2);
+        __m128i d = _mm_loadu_si128(v + 3);
+        cr = static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(
+            _mm_packs_epi32(_mm_cmpeq_epi32(a, crNeedle), _mm_cmpeq_epi32(b, crNeedle)),
+            _mm_packs_epi32(_mm_cmpeq_epi32(c, crNeedle), _mm_cmpeq_epi32(d, crNeedle)))));
+        lf = static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(
+            _mm_packs_epi32(_mm_cmpeq_epi32(a, lfNeedle), _mm_cmpeq_epi32(b, lfNeedle)),
+            _mm_packs_epi32(_mm_cmpeq_epi32(c, lfNeedle), _mm_cmpeq_epi32(d, lfNeedle)))));
+    }
+#else
+    cr = 0;
+    lf = 0;
+    for (size_t i = 0; i < BLOCK_CHARS; i++) {
+        cr |= static_cast<uint32_t>(p[i] == L'\r') << i;
+        lf |= static_cast<uint32_t>(p[i] == L'\n') << i;
+    }
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Call onBreak(position) for each CR or LF in the text, in order
+//------------------------------------------------------------------------------
+template <typename OnBreak>
+void ScanBreaks(const wchar_t* text, size_t length, OnBreak&& onBreak) {
+    size_t pos = 0;
+    for (; pos + BLOCK_CHARS <= length; pos += BLOCK_CHARS) {
+        uint32_t cr, lf;
+        ClassifyBlock(text + pos, cr, lf);
+        uint32_t mask = cr | lf;
+        while (mask) {
+            onBreak(pos + CountTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; pos < length; pos++) {
+        if (text[pos] == L'\r' || text[pos] == L'\n') onBreak(pos);
+    }
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Count CR, LF and CR-LF pairs in one pass.  Pairs are found by shifting the
+// CR mask onto the LF mask, carrying the last CR of each block into the next.
+//------------------------------------------------------------------------------
+LineEndingCounts CountLineEndings(std::wstring_view text) noexcept {
+    const wchar_t* p = text.data();
+    const size_t length = text.size();
+    size_t crTotal = 0;
+    size_t lfTotal = 0;
+    size_t pairs = 0;
+    uint32_t carry = 0;                    // 1 if the previous character was CR
+
+    size_t pos = 0;
+    for (; pos + BLOCK_CHARS <= length; pos += BLOCK_CHARS) {
+        uint32_t cr, lf;
+        ClassifyBlock(p + pos, cr, lf);
+        if ((cr | lf) == 0) {
+            carry = 0;
+            continue;
+        }
+        crTotal += PopCount(cr);
+        lfTotal += PopCount(lf);
+        pairs += PopCount(((cr << 1) | carry) & lf);
+        carry = cr >> (BLOCK_CHARS - 1);
+    }
+    for (; pos < length; pos++) {
+        bool isCr = p[pos] == L'\r';
+        bool isLf = p[pos] == L'\n';
+        crTotal += isCr;
+        lfTotal += isLf;
+        pairs += (isLf && carry);
+        carry = isCr;
+    }
+
+    LineEndingCounts counts;
+    counts.crlf = pairs;
+    counts.lf = lfTotal - pairs;
+    counts.cr = crTotal - pairs;
+    return counts;
+}
+
+//------------------------------------------------------------------------------
+// Exact output size of a conversion
+//------------------------------------------------------------------------------
+size_t ConvertedLength(const LineEndingCounts& counts, size_t length, std::wstring_view newline) noexcept {
+    size_t breakChars = counts.crlf * 2 + counts.lf + counts.cr;
+    return length - breakChars + counts.Total() * newline.size();
+}
+
+//------------------------------------------------------------------------------
+// Copy the runs between line breaks with memmove (the output may overlap
+// the input when converting in place) and emit 'newline' for each break
+//------------------------------------------------------------------------------
+size_t WriteConvertedLineEndings(std::wstring_view text, std::wstring_view newline,
+                                 wchar_t* out) noexcept {
+    const wchar_t* p = text.data();
+    const size_t length = text.size();
+    size_t written = 0;
+    size_t runStart = 0;
+
+    ScanBreaks(p, length, [&](size_t pos) {
+        // LF of a CR-LF pair already consumed with its CR
+        if (pos < runStart) return;
+
+        size_t breakLength = (p[pos] == L'\r' && pos + 1 < length && p[pos + 1] == L'\n') ? 2 : 1;
+        size_t run = pos - runStart;
+        if (run) {
+            std::memmove(out + written, p + runStart, run * sizeof(wchar_t));
+            written += run;
+        }
+        for (wchar_t ch : newline) {
+            out[written++] = ch;
+        }
+        runStart = pos + breakLength;
+    });
+
+    size_t tail = length - runStart;
+    if (tail) {
+        std::memmove(out + written, p + runStart, tail * sizeof(wchar_t));
+        written += tail;
+    }
+    return written;
+}
+
+//------------------------------------------------------------------------------
+// Convert a string's line breaks, reusing its buffer unless it must grow
+//------------------------------------------------------------------------------
+void ConvertLineEndingsInPlace(std::wstring& text, std::wstring_view newline) {
+    LineEndingCounts counts = CountLineEndings(text);
+    if (counts.Total() == 0) return;
+
+    // Already uniform in the target style
+    if (newline == L"\r\n" && counts.crlf == counts.Total()) return;
+    if (newline == L"\n" && counts.lf == counts.Total()) return;
+    if (newline == L"\r" && counts.cr == counts.Total()) return;
+
+    // A one-character newline never makes the text longer, so the output
+    // can overwrite the input as it goes
+    size_t newLength = ConvertedLength(counts, text.size(), newline);
+    if (newline.size() <= 1) {
+        WriteConvertedLineEndings(text, newline, text.data());
+        text.resize(newLength);
+        return;
+    }
+
+    std::wstring result(newLength, L'\0');
+    WriteConvertedLineEndings(text, newline, result.data());
+    text.swap(result);
+}
+
+} // namespace QNote
@@ -0,0 +1,51 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineEndingScan.h - Vectorized line-ending counting and conversion
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Line breaks found in a text.  A CR directly followed by LF counts once,
+// as CRLF; 'lf' and 'cr' count the lone ones.
+//------------------------------------------------------------------------------
+struct LineEndingCounts {
+    size_t crlf = 0;
+    size_t lf = 0;
+    size_t cr = 0;
+
+    [[nodiscard]] size_t Total() const noexcept { return crlf + lf + cr; }
+
+    // More than one kind of line break is present
+    [[nodiscard]] bool IsMixed() const noexcept {
+        return (crlf != 0) + (lf != 0) + (cr != 0) > 1;
+    }
+};
+
+// Count the line breaks in 'text', 16 characters per step
+[[nodiscard]] LineEndingCounts CountLineEndings(std::wstring_view text) noexcept;
+
+// Length of 'length' characters of text with 'counts' once every line
+// break is replaced by 'newline'
+[[nodiscard]] size_t ConvertedLength(const LineEndingCounts& counts, size_t length,
+                                     std::wstring_view newline) noexcept;
+
+// Write 'text' with every line break replaced by 'newline' to 'out', which
+// must hold ConvertedLength() characters.  'out' may be text.data() when
+// the text does not grow (newline is one character, or there are no lone
+// CR/LF breaks).  Returns the number of characters written.
+size_t WriteConvertedLineEndings(std::wstring_view text, std::wstring_view newline,
+                                 wchar_t* out) noexcept;
+
+// Replace every line break in 'text' with 'newline'.  The string is
+// rewritten in place unless it has to grow.
+void ConvertLineEndingsInPlace(std::wstring& text, std::wstring_view newline);
+
+} // namespace QNote
@@ -0,0 +1,316 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineIndexCache.cpp - Persistent sidecar files for LineOffsetIndex scans
+//==============================================================================
+
+#include "LineIndexCache.h"
+#include "FileIO.h"
+#include <algorithm>
+#include <cwctype>
+
+namespace QNote {
+
+namespace {
+
+// Sidecars hold one 8-byte checkpoint per 1024 lines; anything this large
+// is not one of ours
+constexpr LONGLONG MAX_SIDECAR_BYTES = 256LL * 1024 * 1024;
+
+// Little-endian field writers for the sidecar format
+void Put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void Put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+void Put64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+// Bounds-checked little-endian reader
+class Reader {
+public:
+    explicit Reader(const std::vector<uint8_t>& data) noexcept : m_data(data) {}
+
+    bool Get16(uint16_t& value) noexcept {
+        if (Remaining() < 2) return false;
+        value = static_cast<uint16_t>(m_data[m_pos] | (m_data[m_pos + 1] << 8));
+        m_pos += 2;
+        return true;
+    }
+
+    bool Get32(uint32_t& value) noexcept {
+        if (Remaining() < 4) return false;
+        value = 0;
+        for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(m_data[m_pos++]) << (i * 8);
+        return true;
+    }
+
+    bool Get64(uint64_t& value) noexcept {
+        if (Remaining() < 8) return false;
+        value = 0;
+        for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(m_data[m_pos++]) << (i * 8);
+        return true;
+    }
+
+    [[nodiscard]] size_t Remaining() const noexcept { return m_data.size() - m_pos; }
+
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_pos = 0;
+};
+
+// Directory part of a path (without the trailing backslash)
+std::wstring GetDirectory(const std::wstring& path) {
+    size_t pos = path.find_last_of(L"\\/");
+    return pos == std::wstring::npos ? std::wstring() : path.substr(0, pos);
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Sidecar file for a path: <cacheDir>\<hash of the lower-case path>.qli
+//------------------------------------------------------------------------------
+std::wstring LineIndexCache::GetSidecarPath(const std::wstring& cacheDir, const std::wstring& filePath) {
+    std::wstring lower = filePath;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); });
+
+    uint64_t hash = HashBytes(reinterpret_cast<const uint8_t*>(lower.data()), 0,
+                              lower.size() * sizeof(wchar_t));
+    wchar_t name[32];
+    swprintf_s(name, L"%016llx.qli", static_cast<unsigned long long>(hash));
+    return cacheDir + L"\\" + name;
+}
+
+//------------------------------------------------------------------------------
+// Read a sidecar
+//------------------------------------------------------------------------------
+bool LineIndexCache::Load(const std::wstring& sidecarPath, LineIndexSnapshot& snapshot) {
+    HandleGuard hFile(CreateFileW(sidecarPath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    if (!hFile.valid()) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile.get(), &size) || size.QuadPart <= 0 || size.QuadPart > MAX_SIDECAR_BYTES) {
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    try {
+        data.resize(static_cast<size_t>(size.QuadPart));
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+
+    DWORD bytesRead = 0;
+    if (!::ReadFile(hFile.get(), data.data(), static_cast<DWORD>(data.size()), &bytesRead, nullptr) ||
+        bytesRead != data.size()) {
+        return false;
+    }
+
+    Reader reader(data);
+    uint32_t magic = 0, version = 0, pathLength = 0, unit = 0;
+    uint16_t newline = 0;
+    if (!reader.Get32(magic) || magic != FILE_MAGIC ||
+        !reader.Get32(version) || version != FILE_VERSION ||
+        !reader.Get32(pathLength) || reader.Remaining() / 2 < pathLength) {
+        return false;
+    }
+
+    try {
+        snapshot.filePath.clear();
+        snapshot.filePath.reserve(pathLength);
+        for (uint32_t i = 0; i < pathLength; i++) {
+            uint16_t ch = 0;
+            reader.Get16(ch);
+            snapshot.filePath.push_back(static_cast<wchar_t>(ch));
+        }
+
+        uint64_t checkpointCount = 0;
+        if (!reader.Get64(snapshot.fileSize) || !reader.Get64(snapshot.lastWriteTime) ||
+            !reader.Get64(snapshot.textStart) || !reader.Get32(unit) || !reader.Get16(newline) ||
+            !reader.Get64(snapshot.scannedBytes) || !reader.Get64(snapshot.newlines) ||
+            !reader.Get64(snapshot.headHash) || !reader.Get64(snapshot.anchorHash) ||
+            !reader.Get64(checkpointCount)) {
+            return false;
+        }
+        if (unit > static_cast<uint32_t>(LineUnit::UTF16BE) ||
+            checkpointCount != reader.Remaining() / 8 || reader.Remaining() % 8 != 0) {
+            return false;
+        }
+        snapshot.unit = static_cast<LineUnit>(unit);
+        snapshot.newline = static_cast<char16_t>(newline);
+
+        snapshot.checkpoints.resize(static_cast<size_t>(checkpointCount));
+        for (uint64_t& checkpoint : snapshot.checkpoints) {
+            reader.Get64(checkpoint);
+        }
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Write a sidecar through a temporary file so a crash never leaves a
+// half-written index behind
+//------------------------------------------------------------------------------
+bool LineIndexCache::Save(const std::wstring& sidecarPath, const LineIndexSnapshot& snapshot) {
+    std::vector<uint8_t> data;
+    try {
+        data.reserve(96 + snapshot.filePath.size() * 2 + snapshot.checkpoints.size() * 8);
+        Put32(data, FILE_MAGIC);
+        Put32(data, FILE_VERSION);
+        Put32(data, static_cast<uint32_t>(snapshot.filePath.size()));
+        for (wchar_t ch : snapshot.filePath) {
+            Put16(data, static_cast<uint16_t>(ch));
+        }
+        Put64(data, snapshot.fileSize);
+        Put64(data, snapshot.lastWriteTime);
+        Put64(data, snapshot.textStart);
+        Put32(data, static_cast<uint32_t>(snapshot.unit));
+        Put16(data, static_cast<uint16_t>(snapshot.newline));
+        Put64(data, snapshot.scannedBytes);
+        Put64(data, snapshot.newlines);
+        Put64(data, snapshot.headHash);
+        Put64(data, snapshot.anchorHash);
+        Put64(data, snapshot.checkpoints.size());
+        for (uint64_t checkpoint : snapshot.checkpoints) {
+            Put64(data, checkpoint);
+        }
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    if (data.size() > static_cast<size_t>(MAX_SIDECAR_BYTES)) {
+        return false;
+    }
+
+    std::wstring tempPath = sidecarPath + L".tmp";
+    {
+        HandleGuard hFile(CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                      CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!hFile.valid()) {
+            return false;
+        }
+
+        DWORD written = 0;
+        if (!WriteFile(hFile.get(), data.data(), static_cast<DWORD>(data.size()), &written, nullptr) ||
+            written != data.size() || !FlushFileBuffers(hFile.get())) {
+            hFile = HandleGuard();
+            DeleteFileW(tempPath.c_str());
+            return false;
+        }
+    }
+
+    if (!MoveFileExW(tempPath.c_str(), sidecarPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(tempPath.c_str());
+        return false;
+    }
+
+    PruneDirectory(GetDirectory(sidecarPath));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Decide how much of a saved snapshot still describes the file.  An
+// unchanged size and write time plus matching head/anchor hashes means the
+// index is complete; a larger file whose old bytes still hash the same is
+// treated as a tail append.
+//------------------------------------------------------------------------------
+LineIndexReuse LineIndexCache::Validate(const LineIndexSnapshot& saved,
+                                        const LineIndexSnapshot& current,
+                                        const uint8_t* data) {
+    if (!data || saved.textStart != current.textStart || saved.unit != current.unit ||
+        saved.newline != current.newline || saved.scannedBytes < saved.textStart ||
+        saved.scannedBytes > saved.fileSize || saved.scannedBytes > current.fileSize ||
+        _wcsicmp(saved.filePath.c_str(), current.filePath.c_str()) != 0) {
+        return LineIndexReuse::None;
+    }
+
+    LineIndexReuse reuse;
+    if (current.fileSize == saved.fileSize && current.lastWriteTime == saved.lastWriteTime) {
+        reuse = LineIndexReuse::Full;
+    } else if (current.fileSize > saved.fileSize) {
+        reuse = LineIndexReuse::Append;
+    } else {
+        return LineIndexReuse::None;
+    }
+
+    LineIndexSnapshot check;
+    check.textStart = saved.textStart;
+    check.scannedBytes = saved.scannedBytes;
+    ComputeFingerprint(check, data);
+    if (check.headHash != saved.headHash || check.anchorHash != saved.anchorHash) {
+        return LineIndexReuse::None;
+    }
+    return reuse;
+}
+
+//------------------------------------------------------------------------------
+// Hash the first and the last FINGERPRINT_BYTES of the scanned range
+//------------------------------------------------------------------------------
+void LineIndexCache::ComputeFingerprint(LineIndexSnapshot& snapshot, const uint8_t* data) {
+    uint64_t begin = snapshot.textStart;
+    uint64_t end = snapshot.scannedBytes;
+    snapshot.headHash = HashBytes(data, begin, std::min(end, begin + FINGERPRINT_BYTES));
+    snapshot.anchorHash = HashBytes(data, end - std::min(end - begin, FINGERPRINT_BYTES), end);
+}
+
+//------------------------------------------------------------------------------
+// FNV-1a, 64-bit
+//------------------------------------------------------------------------------
+uint64_t LineIndexCache::HashBytes(const uint8_t* data, uint64_t begin, uint64_t end) noexcept {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t i = begin; i < end; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+// Keep only the MAX_SIDECARS most recently written sidecars
+//------------------------------------------------------------------------------
+void LineIndexCache::PruneDirectory(const std::wstring& cacheDir) {
+    if (cacheDir.empty()) return;
+
+    struct Entry {
+        std::wstring name;
+        uint64_t writeTime;
+    };
+    std::vector<Entry> entries;
+
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((cacheDir + L"\\*.qli").c_str(), &findData);
+    if (hFind == INVALID_HANDLE_VALUE) return;
+
+    try {
+        do {
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            uint64_t writeTime = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) |
+                                 findData.ftLastWriteTime.dwLowDateTime;
+            entries.push_back({findData.cFileName, writeTime});
+        } while (FindNextFileW(hFind, &findData));
+    } catch (const std::bad_alloc&) {
+        FindClose(hFind);
+        return;
+    }
+    FindClose(hFind);
+
+    if (entries.size() <= MAX_SIDECARS) return;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.writeTime > b.writeTime; });
+    for (size_t i = MAX_SIDECARS; i < entries.size(); i++) {
+        DeleteFileW((cacheDir + L"\\" + entries[i].name).c_str());
+    }
+}
+
+} // namespace QNote
@@ -0,0 +1,91 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineIndexCache.h - Persistent sidecar files for LineOffsetIndex scans
+//==============================================================================
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LineOffsetIndex.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Saved line index of one file: the scan state plus a fingerprint of the
+// file it was taken from
+//------------------------------------------------------------------------------
+struct LineIndexSnapshot {
+    std::wstring filePath;
+    uint64_t fileSize = 0;
+    uint64_t lastWriteTime = 0;            // FILETIME as a 64-bit value
+    uint64_t textStart = 0;                // BOM length
+    LineUnit unit = LineUnit::Byte;
+    char16_t newline = u'\n';
+
+    uint64_t scannedBytes = 0;
+    uint64_t newlines = 0;
+    std::vector<uint64_t> checkpoints;
+
+    uint64_t headHash = 0;                 // Fingerprint of the first bytes of text
+    uint64_t anchorHash = 0;               // Fingerprint of the bytes before scannedBytes
+};
+
+// How much of a saved snapshot can be reused for the current file
+enum class LineIndexReuse {
+    None,       // Rebuild from scratch
+    Full,       // File unchanged: the index is complete
+    Append      // Data was appended: scan only the new tail
+};
+
+//------------------------------------------------------------------------------
+// Sidecar store.  Each indexed file gets one small binary file in the cache
+// directory, named after a hash of its path.  Validation reads only the
+// sidecar and a few KB of the mapped file, never the whole file.
+//------------------------------------------------------------------------------
+class LineIndexCache {
+public:
+    // Sidecar file for 'filePath' inside 'cacheDir'
+    [[nodiscard]] static std::wstring GetSidecarPath(const std::wstring& cacheDir,
+                                                     const std::wstring& filePath);
+
+    // Read a sidecar.  Returns false if it is missing or malformed.
+    [[nodiscard]] static bool Load(const std::wstring& sidecarPath, LineIndexSnapshot& snapshot);
+
+    // Write a sidecar (via a temporary file) and prune old ones
+    static bool Save(const std::wstring& sidecarPath, const LineIndexSnapshot& snapshot);
+
+    // Compare a snapshot with the current file contents.  'current' holds
+    // the file's path, size, write time and format; its scan fields are
+    // ignored.
+    [[nodiscard]] static LineIndexReuse Validate(const LineIndexSnapshot& saved,
+                                                 const LineIndexSnapshot& current,
+                                                 const uint8_t* data);
+
+    // Fill in headHash/anchorHash for a snapshot's scanned range
+    static void ComputeFingerprint(LineIndexSnapshot& snapshot, const uint8_t* data);
+
+private:
+    // FNV-1a over [begin, end)
+    static uint64_t HashBytes(const uint8_t* data, uint64_t begin, uint64_t end) noexcept;
+
+    // Delete the oldest sidecars beyond MAX_SIDECARS
+    static void PruneDirectory(const std::wstring& cacheDir);
+
+    // Bytes hashed at the head of the text and before the end of the scan
+    static constexpr uint64_t FINGERPRINT_BYTES = 64 * 1024;
+
+    static constexpr size_t MAX_SIDECARS = 64;
+    static constexpr uint32_t FILE_MAGIC = 0x494C4E51;  // "QNLI"
+    static constexpr uint32_t FILE_VERSION = 1;
+};
+
+} // namespace QNote
@@ -0,0 +1,379 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineOffsetIndex.cpp - Sparse line-offset index implementation
+//==============================================================================
+
+#include "LineOffsetIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QNOTE_LINEINDEX_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace QNote {
+
+namespace {
+
+// Bytes scanned between publications of index progress
+constexpr uint64_t BUILD_BLOCK_BYTES = 16ULL * 1024 * 1024;
+
+unsigned CountTrailingZeros(uint32_t value) noexcept {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(value));
+#endif
+}
+
+uint16_t ReadUnit(const uint8_t* p, LineUnit unit) noexcept {
+    return unit == LineUnit::UTF16LE ? static_cast<uint16_t>(p[0] | (p[1] << 8))
+                                     : static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+//------------------------------------------------------------------------------
+// Call onNewline(offset) for each newline unit in [pos, end), 32 bytes per
+// step.  Stops early (returning false) when the callback returns false.
+// For UTF-16, 'pos' and 'end' must be on unit boundaries.
+//------------------------------------------------------------------------------
+template <typename OnNewline>
+bool ScanNewlines(const uint8_t* data, uint64_t pos, uint64_t end, LineUnit unit,
+                  char16_t newline, OnNewline&& onNewline) {
+    if (unit == LineUnit::Byte) {
+        const uint8_t nl = static_cast<uint8_t>(newline);
+#ifdef QNOTE_LINEINDEX_SSE2
+        const __m128i needle = _mm_set1_epi8(static_cast<char>(nl));
+        for (; pos + 32 <= end; pos += 32) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, needle))) |
+                            (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(b, needle))) << 16);
+            while (mask) {
+                if (!onNewline(pos + CountTrailingZeros(mask))) return false;
+                mask &= mask - 1;
+            }
+        }
+        for (; pos < end; ++pos) {
+            if (data[pos] == nl && !onNewline(pos)) return false;
+        }
+#else
+        while (pos < end) {
+            const void* hit = std::memchr(data + pos, nl, static_cast<size_t>(end - pos));
+            if (!hit) break;
+            pos = static_cast<uint64_t>(static_cast<const uint8_t*>(hit) - data);
+            if (!onNewline(pos)) return false;
+            ++pos;
+        }
+#endif
+        return true;
+    }
+
+#ifdef QNOTE_LINEINDEX_SSE2
+    // Lanes hold units as loaded (little-endian), so big-endian text is
+    // matched against the byte-swapped terminator
+    uint16_t lane = (unit == LineUnit::UTF16LE) ? static_cast<uint16_t>(newline)
+                                                : static_cast<uint16_t>((newline >> 8) | (newline << 8));
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(lane));
+    for (; pos + 32 <= end; pos += 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 16));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(a, needle))) |
+                        (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(b, needle))) << 16);
+        mask &= 0x55555555u;  // One bit per matching unit
+        while (mask) {
+            if (!onNewline(pos + CountTrailingZeros(mask))) return false;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; pos + 2 <= end; pos += 2) {
+        if (ReadUnit(data + pos, unit) == newline && !onNewline(pos)) return false;
+    }
+    return true;
+}
+
+uint8_t FoldAscii(uint8_t ch) noexcept {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<uint8_t>(ch + ('a' - 'A')) : ch;
+}
+
+uint8_t UpperAscii(uint8_t ch) noexcept {
+    return (ch >= 'a' && ch <= 'z') ? static_cast<uint8_t>(ch - ('a' - 'A')) : ch;
+}
+
+//------------------------------------------------------------------------------
+// One code unit of 'size' bytes in the haystack against one in the needle.
+// Case-insensitive matching folds only units below 0x80; any other unit,
+// including a UTF-16 unit with an ASCII letter in its low byte, must match
+// exactly.  'lowByteFirst' gives the byte order of a two-byte unit as the
+// iterator sees it (reversed for a backward search).
+//------------------------------------------------------------------------------
+template <typename It>
+bool UnitEquals(It text, const uint8_t* needle, uint64_t size, bool matchCase,
+                bool lowByteFirst) noexcept {
+    if (size == 1) {
+        return matchCase ? text[0] == needle[0] : FoldAscii(text[0]) == FoldAscii(needle[0]);
+    }
+    if (text[0] == needle[0] && text[1] == needle[1]) return true;
+    if (matchCase) return false;
+
+    const size_t low = lowByteFirst ? 0 : 1;
+    const size_t high = 1 - low;
+    return text[high] == 0 && needle[high] == 0 && text[low] < 0x80 &&
+           FoldAscii(text[low]) == FoldAscii(needle[low]);
+}
+
+//------------------------------------------------------------------------------
+// Boyer-Moore-Horspool over any random-access byte iterator (reverse
+// iterators search backwards with a reversed needle).  Matches must start
+// a multiple of 'align' bytes from 'first' and are compared a code unit at
+// a time.  Returns 'last' if none.
+//------------------------------------------------------------------------------
+template <typename It>
+It SearchAligned(It first, It last, const std::vector<uint8_t>& needle, bool matchCase,
+                 uint64_t align, bool lowByteFirst) {
+    const size_t m = needle.size();
+
+    // Shift on the raw byte under the window's end.  Case-insensitive, a
+    // letter byte also stands for its other case: the table cannot know
+    // which bytes are the low byte of an ASCII unit, so it is conservative.
+    size_t skip[256];
+    std::fill(std::begin(skip), std::end(skip), m);
+    for (size_t i = 0; i + 1 < m; ++i) {
+        skip[needle[i]] = m - 1 - i;
+        if (!matchCase) {
+            skip[FoldAscii(needle[i])] = m - 1 - i;
+            skip[UpperAscii(needle[i])] = m - 1 - i;
+        }
+    }
+
+    const uint8_t needleTail = matchCase ? needle[m - 1] : FoldAscii(needle[m - 1]);
+    for (It it = first; static_cast<size_t>(last - it) >= m; ) {
+        uint8_t tail = it[m - 1];
+        if ((matchCase ? tail : FoldAscii(tail)) == needleTail &&
+            static_cast<uint64_t>(it - first) % align == 0) {
+            size_t k = 0;
+            while (k < m && UnitEquals(it + k, needle.data() + k, align, matchCase, lowByteFirst)) {
+                k += static_cast<size_t>(align);
+            }
+            if (k >= m) return it;
+        }
+        it += skip[tail];
+    }
+    return last;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+LineOffsetIndex::LineOffsetIndex(const uint8_t* data, uint64_t size, uint64_t start,
+                                 LineUnit unit, char16_t newline)
+    : m_data(data), m_size(size), m_start((std::min)(start, size)), m_unit(unit),
+      m_unitSize(unit == LineUnit::Byte ? 1 : 2), m_newline(newline) {
+    m_textEnd = m_start + (m_size - m_start) / m_unitSize * m_unitSize;
+    m_indexedBytes.store(m_start, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+// Scan the buffer, publishing checkpoints after each block
+//------------------------------------------------------------------------------
+bool LineOffsetIndex::Build(const std::atomic<bool>* cancel) {
+    std::vector<uint64_t> pending;
+    uint64_t newlines = m_newlines.load(std::memory_order_relaxed);
+    uint64_t pos = (std::min)(GetIndexedBytes(), m_textEnd);  // After any restored scan
+
+    while (pos < m_textEnd) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+
+        uint64_t end = (std::min)(pos + BUILD_BLOCK_BYTES, m_textEnd);
+        ScanNewlines(m_data, pos, end, m_unit, m_newline, [&](uint64_t at) {
+            if (++newlines % CHECKPOINT_LINES == 0) pending.push_back(at + m_unitSize);
+            return true;
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_checkpoints.insert(m_checkpoints.end(), pending.begin(), pending.end());
+        }
+        pending.clear();
+        m_newlines.store(newlines, std::memory_order_release);
+        m_indexedBytes.store(end, std::memory_order_release);
+        pos = end;
+    }
+
+    m_indexedBytes.store(m_size, std::memory_order_release);
+    m_complete.store(true, std::memory_order_release);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Seed the index with a saved scan
+//------------------------------------------------------------------------------
+bool LineOffsetIndex::Restore(uint64_t scannedBytes, uint64_t newlines,
+                              std::vector<uint64_t> checkpoints) {
+    if (scannedBytes < m_start || scannedBytes > m_textEnd) return false;
+    if ((scannedBytes - m_start) % m_unitSize != 0) return false;
+    if (checkpoints.size() != newlines / CHECKPOINT_LINES) return false;
+
+    // Checkpoints are line starts: strictly increasing, inside the scan
+    uint64_t previous = m_start;
+    for (uint64_t offset : checkpoints) {
+        if (offset <= previous || offset > scannedBytes) return false;
+        previous = offset;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_checkpoints = std::move(checkpoints);
+    }
+    m_newlines.store(newlines, std::memory_order_release);
+    m_indexedBytes.store(scannedBytes, std::memory_order_release);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Scan state for saving
+//------------------------------------------------------------------------------
+void LineOffsetIndex::GetScanState(uint64_t& scannedBytes, uint64_t& newlines,
+                                   std::vector<uint64_t>& checkpoints) const {
+    scannedBytes = (std::min)(GetIndexedBytes(), m_textEnd);
+    newlines = m_newlines.load(std::memory_order_acquire);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkpoints = m_checkpoints;
+}
+
+//------------------------------------------------------------------------------
+// Lines with a known extent: those ended by a scanned newline, plus the
+// last line once the scan is complete
+//------------------------------------------------------------------------------
+uint64_t LineOffsetIndex::GetLineCount() const noexcept {
+    bool complete = IsComplete();
+    return m_newlines.load(std::memory_order_acquire) + (complete ? 1 : 0);
+}
+
+uint64_t LineOffsetIndex::SearchEnd() const noexcept {
+    return IsComplete() ? m_textEnd : (std::min)(GetIndexedBytes(), m_textEnd);
+}
+
+//------------------------------------------------------------------------------
+// Start of a line: nearest checkpoint, then scan forward
+//------------------------------------------------------------------------------
+uint64_t LineOffsetIndex::LineStart(uint64_t line) const {
+    uint64_t checkpoint = line / CHECKPOINT_LINES;
+    uint64_t pos = m_start;
+    if (checkpoint > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pos = m_checkpoints[static_cast<size_t>(checkpoint - 1)];
+    }
+
+    uint64_t skip = line - checkpoint * CHECKPOINT_LINES;
+    if (skip == 0) return pos;
+    ScanNewlines(m_data, pos, m_textEnd, m_unit, m_newline, [&](uint64_t at) {
+        if (--skip > 0) return true;
+        pos = at + m_unitSize;
+        return false;
+    });
+    return pos;
+}
+
+LineSpan LineOffsetIndex::MakeSpan(uint64_t begin, uint64_t terminator) const {
+    uint64_t end = terminator;
+    if (m_newline == u'\n' && end >= begin + m_unitSize) {
+        const uint8_t* last = m_data + end - m_unitSize;
+        bool cr = (m_unit == LineUnit::Byte) ? (*last == '\r') : (ReadUnit(last, m_unit) == u'\r');
+        if (cr) end -= m_unitSize;
+    }
+    return { begin, end };
+}
+
+//------------------------------------------------------------------------------
+// Fetch consecutive lines with a single forward scan
+//------------------------------------------------------------------------------
+size_t LineOffsetIndex::FetchLines(uint64_t first, size_t count, std::vector<LineSpan>& out) const {
+    out.clear();
+    uint64_t total = GetLineCount();
+    if (first >= total || count == 0) return 0;
+
+    size_t wanted = static_cast<size_t>((std::min)(static_cast<uint64_t>(count), total - first));
+    out.reserve(wanted);
+
+    uint64_t begin = LineStart(first);
+    ScanNewlines(m_data, begin, m_textEnd, m_unit, m_newline, [&](uint64_t at) {
+        out.push_back(MakeSpan(begin, at));
+        begin = at + m_unitSize;
+        return out.size() < wanted;
+    });
+    if (out.size() < wanted) {
+        out.push_back({ begin, m_textEnd });  // Unterminated last line
+    }
+    return out.size();
+}
+
+//------------------------------------------------------------------------------
+// Line containing a byte offset: binary search the checkpoints, then count
+// the newlines in between
+//------------------------------------------------------------------------------
+uint64_t LineOffsetIndex::LineFromOffset(uint64_t offset) const {
+    if (offset < m_start) return 0;
+    if (offset > SearchEnd()) return NPOS;
+
+    uint64_t line = 0;
+    uint64_t pos = m_start;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), offset);
+        size_t index = static_cast<size_t>(it - m_checkpoints.begin());
+        if (index > 0) {
+            line = index * CHECKPOINT_LINES;
+            pos = m_checkpoints[index - 1];
+        }
+    }
+
+    uint64_t end = m_start + (offset - m_start) / m_unitSize * m_unitSize;
+    ScanNewlines(m_data, pos, end, m_unit, m_newline, [&](uint64_t) {
+        ++line;
+        return true;
+    });
+    return line;
+}
+
+//------------------------------------------------------------------------------
+// Byte searches (Boyer-Moore-Horspool, unit aligned)
+//------------------------------------------------------------------------------
+uint64_t LineOffsetIndex::Find(std::string_view needle, uint64_t from, bool matchCase) const {
+    uint64_t end = SearchEnd();
+    from = (std::max)(from, m_start);
+    from = m_start + (from - m_start + m_unitSize - 1) / m_unitSize * m_unitSize;
+    if (needle.empty() || from >= end || end - from < needle.size()) return NPOS;
+
+    const uint8_t* first = m_data + from;
+    const uint8_t* last = m_data + end;
+    const uint8_t* hit = SearchAligned(first, last, std::vector<uint8_t>(needle.begin(), needle.end()),
+                                       matchCase, m_unitSize, m_unit == LineUnit::UTF16LE);
+    return hit == last ? NPOS : static_cast<uint64_t>(hit - m_data);
+}
+
+uint64_t LineOffsetIndex::FindLast(std::string_view needle, uint64_t before, bool matchCase) const {
+    uint64_t end = (std::min)(before, SearchEnd());
+    end = m_start + (end - (std::min)(end, m_start)) / m_unitSize * m_unitSize;
+    if (needle.empty() || end < m_start || end - m_start < needle.size()) return NPOS;
+
+    // Search backwards for the reversed needle; a match's end is unit aligned
+    // exactly when its start is, since the needle is whole units
+    using Rev = std::reverse_iterator<const uint8_t*>;
+    Rev first(m_data + end), last(m_data + m_start);
+    Rev hit = SearchAligned(first, last, std::vector<uint8_t>(needle.rbegin(), needle.rend()),
+                            matchCase, m_unitSize, m_unit == LineUnit::UTF16BE);
+    if (hit == last) return NPOS;
+    return static_cast<uint64_t>(hit.base() - m_data) - needle.size();
+}
+
+} // namespace QNote
@@ -0,0 +1,118 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineOffsetIndex.h - Sparse line-offset index over a byte buffer
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Width and byte order of the code units that newlines are searched in
+//------------------------------------------------------------------------------
+enum class LineUnit {
+    Byte,       // UTF-8 and ANSI code pages
+    UTF16LE,
+    UTF16BE
+};
+
+// Byte range of one line, excluding its terminator
+struct LineSpan {
+    uint64_t begin = 0;
+    uint64_t end = 0;
+};
+
+//------------------------------------------------------------------------------
+// Sparse line-offset index.  Build() scans the buffer for newlines with
+// SIMD compares and records the start of every CHECKPOINT_LINES-th line;
+// any other line is found by scanning forward from the checkpoint before
+// it.  Readers may query the index from another thread while it is being
+// built: lines become available block by block.
+//------------------------------------------------------------------------------
+class LineOffsetIndex {
+public:
+    static constexpr uint64_t CHECKPOINT_LINES = 1024;
+    static constexpr uint64_t NPOS = ~uint64_t(0);
+
+    // 'data' must outlive the index.  Text starts at 'start' (after any BOM).
+    // 'newline' is the line terminator unit: '\n', or '\r' for CR-only text.
+    LineOffsetIndex(const uint8_t* data, uint64_t size, uint64_t start,
+                    LineUnit unit, char16_t newline = u'\n');
+
+    // Prevent copying
+    LineOffsetIndex(const LineOffsetIndex&) = delete;
+    LineOffsetIndex& operator=(const LineOffsetIndex&) = delete;
+
+    // Scan the buffer.  Returns false if 'cancel' was set before the end.
+    bool Build(const std::atomic<bool>* cancel = nullptr);
+
+    // Seed the index with a saved scan of [start, scannedBytes) before
+    // Build(), which then scans only the bytes after it.  Returns false
+    // (leaving the index empty) if the state does not fit this buffer.
+    [[nodiscard]] bool Restore(uint64_t scannedBytes, uint64_t newlines,
+                               std::vector<uint64_t> checkpoints);
+
+    // Scan state for saving with Restore().  Call once Build() has returned.
+    void GetScanState(uint64_t& scannedBytes, uint64_t& newlines,
+                      std::vector<uint64_t>& checkpoints) const;
+
+    [[nodiscard]] bool IsComplete() const noexcept { return m_complete.load(std::memory_order_acquire); }
+
+    // Lines whose extent is known so far (every line once complete)
+    [[nodiscard]] uint64_t GetLineCount() const noexcept;
+
+    // Bytes scanned so far
+    [[nodiscard]] uint64_t GetIndexedBytes() const noexcept { return m_indexedBytes.load(std::memory_order_acquire); }
+    [[nodiscard]] uint64_t GetSize() const noexcept { return m_size; }
+    [[nodiscard]] LineUnit GetUnit() const noexcept { return m_unit; }
+
+    // Byte ranges of up to 'count' lines starting at 'first'.  Returns the
+    // number of lines fetched (0 if 'first' is not indexed yet).
+    size_t FetchLines(uint64_t first, size_t count, std::vector<LineSpan>& out) const;
+
+    // Line containing a byte offset, or NPOS if it is not indexed yet
+    [[nodiscard]] uint64_t LineFromOffset(uint64_t offset) const;
+
+    // Next match of 'needle' (bytes in the buffer's encoding) at or after
+    // 'from', or the last match ending at or before 'before'.  Only the
+    // indexed range is searched.  Case-insensitive matching folds ASCII
+    // letters only: code units of 0x80 and up must match exactly.  Returns
+    // NPOS if there is no match.
+    [[nodiscard]] uint64_t Find(std::string_view needle, uint64_t from, bool matchCase) const;
+    [[nodiscard]] uint64_t FindLast(std::string_view needle, uint64_t before, bool matchCase) const;
+
+private:
+    // Start offset of an indexed line
+    uint64_t LineStart(uint64_t line) const;
+
+    // Span from a line start to the terminator at 'terminator' (CR of a
+    // CRLF pair is dropped)
+    LineSpan MakeSpan(uint64_t begin, uint64_t terminator) const;
+
+    // End of the range that searches and lookups may read
+    uint64_t SearchEnd() const noexcept;
+
+private:
+    const uint8_t* m_data;
+    uint64_t m_size;
+    uint64_t m_start;
+    uint64_t m_textEnd;                    // m_size rounded down to whole units
+    LineUnit m_unit;
+    uint64_t m_unitSize;
+    char16_t m_newline;
+
+    mutable std::mutex m_mutex;            // Guards m_checkpoints
+    std::vector<uint64_t> m_checkpoints;   // [k] = start of line (k + 1) * CHECKPOINT_LINES
+    std::atomic<uint64_t> m_newlines{0};
+    std::atomic<uint64_t> m_indexedBytes{0};
+    std::atomic<bool> m_complete{false};
+};
+
+} // namespace QNote
@@ -0,0 +1,467 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineSort.cpp - Key-based parallel line sorting implementation
+//==============================================================================
+
+#include "LineSort.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cwctype>
+
+namespace QNote {
+
+namespace {
+
+// Below this many lines per chunk, sorting stays on the calling thread
+constexpr size_t PARALLEL_MIN_LINES = 64 * 1024;
+
+// Code units packed into each sort key prefix
+constexpr size_t PREFIX_UNITS = 4;
+
+// Line indices fit in 32 bits: RichEdit text is limited to 2^31 characters
+using LineIndex = uint32_t;
+
+// What the merge sort moves around: the packed key prefix travels with the
+// line so comparisons never leave the array
+struct SortEntry {
+    uint64_t prefix;
+    LineIndex line;
+};
+
+bool IsDigit(wchar_t ch) noexcept {
+    return ch >= L'0' && ch <= L'9';
+}
+
+// towlower() with ASCII, the bulk of most files, kept out of the CRT call
+wchar_t FoldCase(wchar_t ch) noexcept {
+    if (ch < 0x80) return (ch >= L'A' && ch <= L'Z') ? static_cast<wchar_t>(ch + (L'a' - L'A')) : ch;
+    return static_cast<wchar_t>(std::towlower(ch));
+}
+
+//------------------------------------------------------------------------------
+// Return the 1-based field 'column' of a line (empty if missing)
+//------------------------------------------------------------------------------
+std::wstring_view ExtractField(std::wstring_view line, int column, wchar_t delimiter) {
+    if (column <= 0) return line;
+
+    size_t pos = 0;
+    for (int field = 1; pos <= line.size(); ++field) {
+        size_t start = pos;
+        if (delimiter == 0) {
+            start = line.find_first_not_of(L" \t", pos);
+            if (start == std::wstring_view::npos) return {};
+        }
+        size_t end = (delimiter == 0) ? line.find_first_of(L" \t", start)
+                                      : line.find(delimiter, start);
+        if (end == std::wstring_view::npos) end = line.size();
+
+        if (field == column) return line.substr(start, end - start);
+        pos = end + 1;
+    }
+    return {};
+}
+
+//------------------------------------------------------------------------------
+// Append a count so that plain comparison orders counts by value: one code
+// unit below 0xFFFF, otherwise 0xFFFF and then the high and low halves
+//------------------------------------------------------------------------------
+void AppendCount(std::wstring& out, size_t count) {
+    if (count < 0xFFFF) {
+        out.push_back(static_cast<wchar_t>(count));
+        return;
+    }
+    out.push_back(static_cast<wchar_t>(0xFFFF));
+    out.push_back(static_cast<wchar_t>((count >> 16) & 0xFFFF));
+    out.push_back(static_cast<wchar_t>(count & 0xFFFF));
+}
+
+//------------------------------------------------------------------------------
+// Natural order: digit runs compare by numeric value, other characters by
+// code unit.  Equal numbers with more leading zeros sort later.
+//
+// Each digit run is rewritten as '0', the length of its significant digits,
+// the digits and the count of leading zeros, so comparing the encoded keys
+// code unit by code unit gives natural order and digit runs are parsed once
+// per line instead of once per comparison.  The '0' marker compares against
+// any non-digit the same way the run's first digit would.
+//------------------------------------------------------------------------------
+void EncodeNatural(std::wstring_view text, std::wstring& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+        if (!IsDigit(text[i])) {
+            out.push_back(text[i++]);
+            continue;
+        }
+        size_t significant = i;
+        while (significant < text.size() && text[significant] == L'0') ++significant;
+        size_t end = significant;
+        while (end < text.size() && IsDigit(text[end])) ++end;
+
+        out.push_back(L'0');
+        AppendCount(out, end - significant);
+        out.append(text.substr(significant, end - significant));
+        AppendCount(out, significant - i);
+        i = end;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Build the sort key for one line.  The key is copied into the arena only
+// when the field actually contains characters that fold or, for natural
+// order, digits.
+//------------------------------------------------------------------------------
+std::wstring_view MakeKey(std::wstring_view line, const LineSortOptions& options,
+                          TextArena& arena, std::wstring& folded, std::wstring& encoded) {
+    std::wstring_view key = ExtractField(line, options.column, options.delimiter);
+    bool changed = false;
+
+    if (!options.caseSensitive) {
+        size_t firstFold = 0;
+        while (firstFold < key.size() && FoldCase(key[firstFold]) == key[firstFold]) ++firstFold;
+        if (firstFold < key.size()) {
+            folded.assign(key);
+            for (size_t k = firstFold; k < folded.size(); ++k) {
+                folded[k] = FoldCase(folded[k]);
+            }
+            key = folded;
+            changed = true;
+        }
+    }
+
+    if (options.natural && std::any_of(key.begin(), key.end(), IsDigit)) {
+        EncodeNatural(key, encoded);
+        key = encoded;
+        changed = true;
+    }
+    return changed ? arena.Store(key) : key;
+}
+
+//------------------------------------------------------------------------------
+// Number of elements of 'a' among the first 'k' outputs of a stable merge
+// of 'a' and 'b' (the merge path split)
+//------------------------------------------------------------------------------
+template <typename T, typename Less>
+size_t MergeSplit(const T* a, size_t sizeA, const T* b, size_t sizeB, size_t k, const Less& less) {
+    size_t lo = k > sizeB ? k - sizeB : 0;
+    size_t hi = (std::min)(k, sizeA);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        // a[mid] comes out before b[k - mid - 1] unless that is strictly less
+        if (!less(b[k - mid - 1], a[mid])) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+//------------------------------------------------------------------------------
+// Stable merge sort of items[0, n): chunks are sorted on the scheduler's
+// workers, then adjacent runs are merged in rounds.  Each merge is split
+// along its merge path into enough pieces to keep every worker busy, down
+// to the final merge of two halves.
+//------------------------------------------------------------------------------
+template <typename T, typename Less>
+void ParallelStableSort(T* items, size_t n, const Less& less, TaskScheduler* scheduler) {
+    const size_t workers = scheduler ? scheduler->GetWorkerCount() : 0;
+    const size_t chunks = (std::min)(workers, n / PARALLEL_MIN_LINES);
+    if (chunks <= 1) {
+        std::stable_sort(items, items + n, less);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t k = 0; k <= chunks; ++k) bounds[k] = n * k / chunks;
+    scheduler->ParallelFor(chunks, [items, &less, &bounds](size_t k) {
+        std::stable_sort(items + bounds[k], items + bounds[k + 1], less);
+    }, TaskPriority::High);
+
+    // Ping-pong between buffers; an odd run out is copied across as is
+    std::vector<T> buffer(n);
+    T* from = items;
+    T* to = buffer.data();
+    while (bounds.size() > 2) {
+        const size_t runs = bounds.size() - 1;
+        const size_t pairs = runs / 2;
+        const size_t pieces = (workers + pairs - 1) / pairs;
+
+        scheduler->ParallelFor(pairs * pieces + runs % 2,
+                               [from, to, n, &less, &bounds, pieces](size_t task) {
+            const size_t pair = task / pieces;
+            const size_t lo = bounds[2 * pair];
+            if (2 * pair + 1 == bounds.size() - 1) {
+                std::copy(from + lo, from + n, to + lo);
+                return;
+            }
+            const size_t mid = bounds[2 * pair + 1];
+            const size_t hi = bounds[2 * pair + 2];
+
+            const T* a = from + lo;
+            const T* b = from + mid;
+            const size_t piece = task % pieces;
+            const size_t first = (hi - lo) * piece / pieces;
+            const size_t last = (hi - lo) * (piece + 1) / pieces;
+            const size_t firstA = MergeSplit(a, mid - lo, b, hi - mid, first, less);
+            const size_t lastA = MergeSplit(a, mid - lo, b, hi - mid, last, less);
+            std::merge(a + firstA, a + lastA, b + (first - firstA), b + (last - lastA),
+                       to + lo + first, less);
+        }, TaskPriority::High);
+
+        std::vector<size_t> next;
+        next.reserve(pairs + 2);
+        for (size_t k = 0; k < runs; k += 2) next.push_back(bounds[k]);
+        next.push_back(n);
+
+        std::swap(from, to);
+        bounds.swap(next);
+    }
+
+    if (from != items) {
+        scheduler->ParallelFor(chunks, [from, items, n, chunks](size_t k) {
+            std::copy(from + n * k / chunks, from + n * (k + 1) / chunks, items + n * k / chunks);
+        }, TaskPriority::High);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Pack four code units of a key, starting at 'depth', into 16-bit fields of
+// an integer that orders the same way as the key text.  Short keys are
+// padded with zero.  Code units outside 1..0xFFFE are clamped, and packing
+// stops after one, so equal prefixes are only known to mean equal text when
+// 'exact' is set.  Two exact prefixes that are equal and padded belong to
+// equal keys.
+//------------------------------------------------------------------------------
+uint64_t PackPrefix(std::wstring_view key, size_t depth, bool& exact) noexcept {
+    uint64_t prefix = 0;
+    exact = true;
+    for (size_t k = 0; k < PREFIX_UNITS; ++k) {
+        uint64_t unit = 0;
+        if (exact && depth + k < key.size()) {
+            // wchar_t is signed on some platforms
+            int64_t value = static_cast<int64_t>(key[depth + k]);
+            unit = value <= 0 ? 0 : static_cast<uint64_t>((std::min<int64_t>)(value, 0xFFFF));
+            if (unit == 0 || unit == 0xFFFF) exact = false;
+        }
+        prefix = (prefix << 16) | unit;
+    }
+    return prefix;
+}
+
+//------------------------------------------------------------------------------
+// Sorts entries by key, MSD radix style: entries are sorted on their packed
+// prefixes, then each run of equal prefixes is repacked four code units
+// deeper and sorted again until its keys run out.  A run holding a key that
+// its prefix did not describe exactly is sorted on the rest of the key text
+// instead.  Large runs are repacked and sorted across the scheduler's
+// workers; the small runs are shared out between them.
+//------------------------------------------------------------------------------
+class PrefixSorter {
+public:
+    PrefixSorter(std::vector<SortEntry>& entries, const std::vector<std::wstring_view>& keys,
+                 bool descending, TaskScheduler* scheduler) noexcept
+        : m_entries(entries), m_keys(keys), m_descending(descending), m_scheduler(scheduler) {}
+
+    void Sort();
+
+private:
+    struct Run {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+
+    [[nodiscard]] auto ByPrefix() const noexcept {
+        return [descending = m_descending](const SortEntry& x, const SortEntry& y) {
+            return descending ? x.prefix > y.prefix : x.prefix < y.prefix;
+        };
+    }
+
+    // Every key of a run shares its first 'depth' code units
+    [[nodiscard]] auto ByText(size_t depth) const noexcept {
+        return [&keys = m_keys, descending = m_descending, depth](const SortEntry& x,
+                                                                  const SortEntry& y) {
+            int cmp = keys[x.line].substr(depth).compare(keys[y.line].substr(depth));
+            return descending ? cmp > 0 : cmp < 0;
+        };
+    }
+
+    [[nodiscard]] size_t Pieces(size_t count) const noexcept {
+        size_t workers = m_scheduler ? m_scheduler->GetWorkerCount() : 0;
+        return (std::max<size_t>)(1, (std::min)(workers, count / PARALLEL_MIN_LINES));
+    }
+
+    // The keys of a run with exact prefixes are all equal once they run out
+    [[nodiscard]] bool IsFinished(const Run& run) const noexcept {
+        return m_keys[m_entries[run.begin].line].size() < run.depth + PREFIX_UNITS;
+    }
+
+    // Add the runs of equal prefixes in [begin, end), which is sorted on
+    // prefixes packed at 'depth', to the large or the small list
+    void FindRuns(size_t begin, size_t end, size_t depth) {
+        for (size_t i = begin; i < end;) {
+            size_t j = i + 1;
+            while (j < end && m_entries[j].prefix == m_entries[i].prefix) ++j;
+            if (j - i >= PARALLEL_MIN_LINES && m_scheduler) {
+                m_largeRuns.push_back({ i, j, depth });
+            } else if (j - i > 1) {
+                m_smallRuns.push_back({ i, j, depth });
+            }
+            i = j;
+        }
+    }
+
+    // Repack and sort one large run across the workers
+    void RefineLargeRun(const Run& run) {
+        const size_t count = run.end - run.begin;
+        const size_t pieces = Pieces(count);
+        const size_t depth = run.depth + PREFIX_UNITS;
+        std::atomic<bool> inexact{ false };
+        m_scheduler->ParallelFor(pieces, [this, &run, &inexact, count, pieces, depth](size_t k) {
+            const size_t last = run.begin + count * (k + 1) / pieces;
+            for (size_t i = run.begin + count * k / pieces; i < last; ++i) {
+                bool exact;
+                (void)PackPrefix(m_keys[m_entries[i].line], run.depth, exact);
+                if (!exact) inexact.store(true, std::memory_order_relaxed);
+                m_entries[i].prefix = PackPrefix(m_keys[m_entries[i].line], depth, exact);
+            }
+        }, TaskPriority::High);
+
+        SortEntry* first = m_entries.data() + run.begin;
+        SortEntry* last = first + count;
+        if (inexact.load(std::memory_order_relaxed)) {
+            ParallelStableSort(first, count, ByText(run.depth), m_scheduler);
+            return;
+        }
+        if (IsFinished(run)) return;
+        // Long shared prefixes (timestamps, paths) leave runs unsplit
+        if (std::adjacent_find(first, last, [](const SortEntry& x, const SortEntry& y) {
+                return x.prefix != y.prefix;
+            }) != last) {
+            ParallelStableSort(first, count, ByPrefix(), m_scheduler);
+        }
+        FindRuns(run.begin, run.end, depth);
+    }
+
+    // Refine small runs, and the runs they split into, one after another
+    void RefineSmallRuns(std::vector<Run> pending) {
+        while (!pending.empty()) {
+            Run run = pending.back();
+            pending.pop_back();
+            auto first = m_entries.begin() + run.begin;
+            auto last = m_entries.begin() + run.end;
+
+            bool exact = true;
+            for (auto it = first; exact && it != last; ++it) {
+                (void)PackPrefix(m_keys[it->line], run.depth, exact);
+            }
+            if (!exact) {
+                std::stable_sort(first, last, ByText(run.depth));
+                continue;
+            }
+            if (IsFinished(run)) continue;
+
+            const size_t depth = run.depth + PREFIX_UNITS;
+            for (auto it = first; it != last; ++it) {
+                it->prefix = PackPrefix(m_keys[it->line], depth, exact);
+            }
+            std::stable_sort(first, last, ByPrefix());
+            for (size_t i = run.begin; i < run.end;) {
+                size_t j = i + 1;
+                while (j < run.end && m_entries[j].prefix == m_entries[i].prefix) ++j;
+                if (j - i > 1) pending.push_back({ i, j, depth });
+                i = j;
+            }
+        }
+    }
+
+    std::vector<SortEntry>& m_entries;
+    const std::vector<std::wstring_view>& m_keys;
+    bool m_descending;
+    TaskScheduler* m_scheduler;
+    std::vector<Run> m_largeRuns;
+    std::vector<Run> m_smallRuns;
+};
+
+void PrefixSorter::Sort() {
+    ParallelStableSort(m_entries.data(), m_entries.size(), ByPrefix(), m_scheduler);
+    FindRuns(0, m_entries.size(), 0);
+    while (!m_largeRuns.empty()) {
+        Run run = m_largeRuns.back();
+        m_largeRuns.pop_back();
+        RefineLargeRun(run);
+    }
+
+    size_t smallEntries = 0;
+    for (const Run& run : m_smallRuns) smallEntries += run.end - run.begin;
+    const size_t batches = (std::min)(Pieces(smallEntries), m_smallRuns.size());
+    if (batches <= 1) {
+        RefineSmallRuns(std::move(m_smallRuns));
+        return;
+    }
+    m_scheduler->ParallelFor(batches, [this, batches](size_t k) {
+        const size_t runs = m_smallRuns.size();
+        RefineSmallRuns(std::vector<Run>(m_smallRuns.begin() + runs * k / batches,
+                                         m_smallRuns.begin() + runs * (k + 1) / batches));
+    }, TaskPriority::High);
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Sort line views in place
+//------------------------------------------------------------------------------
+void SortLines(std::vector<std::wstring_view>& lines, const LineSortOptions& options,
+               TaskScheduler* scheduler) {
+    if (lines.size() < 2) return;
+
+    // Precompute keys once, in parallel pieces with an arena each;
+    // comparisons then never re-fold, re-split or re-parse digit runs
+    const size_t n = lines.size();
+    size_t pieces = scheduler ? (std::min)(scheduler->GetWorkerCount(), n / PARALLEL_MIN_LINES) : 0;
+    if (pieces == 0) pieces = 1;
+    std::vector<TextArena> keyArenas(pieces);
+    std::vector<std::wstring_view> keys(n);
+    std::vector<SortEntry> entries(n);
+    auto buildKeys = [&](size_t piece) {
+        std::wstring folded, encoded;
+        for (size_t i = n * piece / pieces; i < n * (piece + 1) / pieces; ++i) {
+            keys[i] = MakeKey(lines[i], options, keyArenas[piece], folded, encoded);
+            bool exact;
+            entries[i] = { PackPrefix(keys[i], 0, exact), static_cast<LineIndex>(i) };
+        }
+    };
+    if (pieces > 1) {
+        scheduler->ParallelFor(pieces, buildKeys, TaskPriority::High);
+    } else {
+        buildKeys(0);
+    }
+
+    PrefixSorter(entries, keys, options.descending, scheduler).Sort();
+
+    std::vector<std::wstring_view> sorted;
+    sorted.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        // Stable sort puts the first occurrence of equal keys first
+        if (options.unique && i > 0 && keys[entries[i - 1].line] == keys[entries[i].line]) continue;
+        sorted.push_back(lines[entries[i].line]);
+    }
+    lines.swap(sorted);
+}
+
+namespace LineTransforms {
+
+//------------------------------------------------------------------------------
+// Pipeline stage wrapping SortLines()
+//------------------------------------------------------------------------------
+LinePipeline::ListFn Sort(const LineSortOptions& options, TaskScheduler* scheduler) {
+    return [options, scheduler](std::vector<std::wstring_view>& lines, TextArena&) {
+        SortLines(lines, options, scheduler);
+    };
+}
+
+} // namespace LineTransforms
+
+} // namespace QNote
@@ -0,0 +1,47 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineSort.h - Key-based parallel line sorting
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <string_view>
+#include <vector>
+#include "LineTransform.h"
+#include "TaskScheduler.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Sort options for Sort Lines
+//------------------------------------------------------------------------------
+struct LineSortOptions {
+    bool descending = false;
+    bool caseSensitive = false;
+    bool natural = false;          // Compare digit runs by numeric value ("a2" < "a10")
+    bool unique = false;           // Keep only the first of lines with equal keys
+    int column = 0;                // 1-based field to sort by; 0 = whole line
+    wchar_t delimiter = 0;         // Field separator; 0 = runs of spaces/tabs
+};
+
+//------------------------------------------------------------------------------
+// Sort line views in place.  Sort keys are computed once per line (field
+// extraction, case folding and, for natural order, digit runs encoded so
+// that plain comparison orders them by value), each with a packed 64-bit
+// prefix; line indices are then merge sorted in parallel on 'scheduler'
+// (on the calling thread without one).  The sort is stable: equal keys
+// keep their original order.
+//------------------------------------------------------------------------------
+void SortLines(std::vector<std::wstring_view>& lines, const LineSortOptions& options,
+               TaskScheduler* scheduler = nullptr);
+
+namespace LineTransforms {
+
+// Pipeline stage wrapping SortLines()
+[[nodiscard]] LinePipeline::ListFn Sort(const LineSortOptions& options,
+                                        TaskScheduler* scheduler = nullptr);
+
+} // namespace LineTransforms
+
+} // namespace QNote
@@ -0,0 +1,372 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineTransform.cpp - Line-view pipeline implementation
+//==============================================================================
+
+#include "LineTransform.h"
+#include <algorithm>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Allocate uninitialized space for 'count' characters
+//------------------------------------------------------------------------------
+wchar_t* TextArena::Allocate(size_t count) {
+    if (count == 0) return nullptr;
+    if (m_blocks.empty() || m_capacity - m_used < count) {
+        // Oversized requests get a dedicated block
+        size_t size = (std::max)(count, m_blockChars);
+        m_blocks.push_back(std::make_unique<wchar_t[]>(size));
+        m_capacity = size;
+        m_used = 0;
+    }
+    wchar_t* ptr = m_blocks.back().get() + m_used;
+    m_used += count;
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+// Copy text into the arena
+//------------------------------------------------------------------------------
+std::wstring_view TextArena::Store(std::wstring_view text) {
+    if (text.empty()) return {};
+    wchar_t* dst = Allocate(text.size());
+    std::copy(text.begin(), text.end(), dst);
+    return std::wstring_view(dst, text.size());
+}
+
+//------------------------------------------------------------------------------
+// Concatenate several pieces into one arena-owned view
+//------------------------------------------------------------------------------
+std::wstring_view TextArena::Concat(std::initializer_list<std::wstring_view> parts) {
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    if (total == 0) return {};
+
+    wchar_t* dst = Allocate(total);
+    wchar_t* out = dst;
+    for (const auto& part : parts) {
+        out = std::copy(part.begin(), part.end(), out);
+    }
+    return std::wstring_view(dst, total);
+}
+
+//------------------------------------------------------------------------------
+// Release all storage
+//------------------------------------------------------------------------------
+void TextArena::Clear() noexcept {
+    m_blocks.clear();
+    m_used = 0;
+    m_capacity = 0;
+}
+
+//------------------------------------------------------------------------------
+// Split text into line views
+//------------------------------------------------------------------------------
+LineSet SplitLines(std::wstring_view text) {
+    LineSet set;
+    bool eolFound = false;
+
+    // Count terminators first so the vector is allocated once
+    size_t count = 1;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == L'\n' || (text[i] == L'\r' && (i + 1 >= text.size() || text[i + 1] != L'\n'))) {
+            ++count;
+        }
+    }
+    set.lines.reserve(count);
+
+    size_t lineStart = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        wchar_t ch = text[i];
+        if (ch != L'\r' && ch != L'\n') {
+            ++i;
+            continue;
+        }
+
+        size_t termLen = (ch == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n') ? 2 : 1;
+        if (!eolFound) {
+            set.eol = text.substr(i, termLen);
+            eolFound = true;
+        }
+        set.lines.push_back(text.substr(lineStart, i - lineStart));
+        i += termLen;
+        lineStart = i;
+    }
+
+    if (lineStart < text.size()) {
+        set.lines.push_back(text.substr(lineStart));
+    } else if (!text.empty()) {
+        set.trailingEol = eolFound;
+    }
+    return set;
+}
+
+//------------------------------------------------------------------------------
+// Join lines with the set's terminator
+//------------------------------------------------------------------------------
+std::wstring JoinLines(const LineSet& set) {
+    if (set.lines.empty()) return {};
+
+    size_t total = 0;
+    for (const auto& line : set.lines) total += line.size();
+    size_t separators = set.lines.size() - 1 + (set.trailingEol ? 1 : 0);
+    total += separators * set.eol.size();
+
+    std::wstring result;
+    result.reserve(total);
+    for (size_t i = 0; i < set.lines.size(); ++i) {
+        result.append(set.lines[i]);
+        if (i + 1 < set.lines.size() || set.trailingEol) {
+            result.append(set.eol);
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Smallest single edit between two texts
+//------------------------------------------------------------------------------
+TextEdit ComputeMinimalEdit(std::wstring_view before, std::wstring_view after) {
+    size_t prefix = 0;
+    size_t maxPrefix = (std::min)(before.size(), after.size());
+    while (prefix < maxPrefix && before[prefix] == after[prefix]) ++prefix;
+
+    size_t suffix = 0;
+    size_t maxSuffix = maxPrefix - prefix;
+    while (suffix < maxSuffix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    TextEdit edit;
+    edit.start = prefix;
+    edit.removeLength = before.size() - prefix - suffix;
+    edit.insert = after.substr(prefix, after.size() - prefix - suffix);
+    return edit;
+}
+
+//------------------------------------------------------------------------------
+// Pipeline construction
+//------------------------------------------------------------------------------
+LinePipeline& LinePipeline::Map(LineFn fn) {
+    m_stages.push_back({ std::move(fn), nullptr });
+    return *this;
+}
+
+LinePipeline& LinePipeline::Apply(ListFn fn) {
+    m_stages.push_back({ nullptr, std::move(fn) });
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+// Run stages [first, last) - all Map() stages - in one pass, compacting the
+// line vector in place as lines are dropped
+//------------------------------------------------------------------------------
+void LinePipeline::RunFused(std::vector<std::wstring_view>& lines, size_t first, size_t last,
+                            TextArena& arena) const {
+    std::vector<size_t> counters(last - first, 0);
+    size_t out = 0;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        std::wstring_view line = lines[i];
+        bool keep = true;
+        for (size_t s = first; s < last && keep; ++s) {
+            keep = m_stages[s].map(line, counters[s - first]++, arena);
+        }
+        if (keep) lines[out++] = line;
+    }
+    lines.resize(out);
+}
+
+//------------------------------------------------------------------------------
+// Run all stages on a split line set
+//------------------------------------------------------------------------------
+void LinePipeline::Run(LineSet& set, TextArena& arena) const {
+    size_t s = 0;
+    while (s < m_stages.size()) {
+        if (m_stages[s].apply) {
+            m_stages[s].apply(set.lines, arena);
+            ++s;
+            continue;
+        }
+        size_t end = s;
+        while (end < m_stages.size() && m_stages[end].map) ++end;
+        RunFused(set.lines, s, end, arena);
+        s = end;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Split, run and join
+//------------------------------------------------------------------------------
+std::wstring LinePipeline::Run(std::wstring_view text) const {
+    TextArena arena;
+    LineSet set = SplitLines(text);
+    Run(set, arena);
+    return JoinLines(set);
+}
+
+namespace LineTransforms {
+
+namespace {
+
+bool IsBlank(std::wstring_view line) {
+    return line.find_first_not_of(L" \t") == std::wstring_view::npos;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Strip trailing spaces and tabs
+//------------------------------------------------------------------------------
+LinePipeline::LineFn TrimTrailingWhitespace() {
+    return [](std::wstring_view& line, size_t, TextArena&) {
+        size_t end = line.find_last_not_of(L" \t");
+        line = (end == std::wstring_view::npos) ? std::wstring_view() : line.substr(0, end + 1);
+        return true;
+    };
+}
+
+//------------------------------------------------------------------------------
+// Drop lines that are empty or whitespace-only
+//------------------------------------------------------------------------------
+LinePipeline::LineFn RemoveBlankLines() {
+    return [](std::wstring_view& line, size_t, TextArena&) {
+        return !IsBlank(line);
+    };
+}
+
+//------------------------------------------------------------------------------
+// Replace each leading run of 'tabSize' spaces with a tab
+//------------------------------------------------------------------------------
+LinePipeline::LineFn LeadingSpacesToTabs(int tabSize) {
+    size_t width = static_cast<size_t>((std::max)(tabSize, 1));
+    return [width](std::wstring_view& line, size_t, TextArena& arena) {
+        size_t tabs = 0;
+        while ((tabs + 1) * width <= line.size() &&
+               line.substr(tabs * width, width).find_first_not_of(L' ') == std::wstring_view::npos) {
+            ++tabs;
+        }
+        if (tabs > 0) {
+            std::wstring prefix(tabs, L'\t');
+            line = arena.Concat({ prefix, line.substr(tabs * width) });
+        }
+        return true;
+    };
+}
+
+//------------------------------------------------------------------------------
+// Reverse line order
+//------------------------------------------------------------------------------
+LinePipeline::ListFn Reverse() {
+    return [](std::vector<std::wstring_view>& lines, TextArena&) {
+        std::reverse(lines.begin(), lines.end());
+    };
+}
+
+//------------------------------------------------------------------------------
+// Prefix each line with its right-aligned 1-based number ("  7: text")
+//------------------------------------------------------------------------------
+LinePipeline::ListFn NumberLines() {
+    return [](std::vector<std::wstring_view>& lines, TextArena& arena) {
+        size_t width = std::to_wstring(lines.size()).size();
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::wstring num = std::to_wstring(i + 1);
+            std::wstring pad(width - num.size(), L' ');
+            lines[i] = arena.Concat({ pad, num, L": ", lines[i] });
+        }
+    };
+}
+
+//------------------------------------------------------------------------------
+// Wrap lines longer than maxWidth, breaking after the last space or tab
+//------------------------------------------------------------------------------
+LinePipeline::ListFn WrapAt(int maxWidth) {
+    size_t width = static_cast<size_t>((std::max)(maxWidth, 1));
+    return [width](std::vector<std::wstring_view>& lines, TextArena&) {
+        std::vector<std::wstring_view> wrapped;
+        wrapped.reserve(lines.size());
+        for (std::wstring_view line : lines) {
+            while (line.size() > width) {
+                size_t breakPos = width;
+                for (size_t i = width - 1; i > 0; --i) {
+                    if (line[i] == L' ' || line[i] == L'\t') {
+                        breakPos = i + 1;
+                        break;
+                    }
+                }
+                wrapped.push_back(line.substr(0, breakPos));
+                line = line.substr(breakPos);
+
+                // Trim leading spaces from the continuation
+                size_t firstNonSpace = line.find_first_not_of(L' ');
+                if (firstNonSpace != std::wstring_view::npos) line = line.substr(firstNonSpace);
+            }
+            wrapped.push_back(line);
+        }
+        lines.swap(wrapped);
+    };
+}
+
+//------------------------------------------------------------------------------
+// Join all lines into one, separated by single spaces (empty lines vanish)
+//------------------------------------------------------------------------------
+LinePipeline::ListFn JoinWithSpaces() {
+    return [](std::vector<std::wstring_view>& lines, TextArena& arena) {
+        size_t total = 0;
+        for (const auto& line : lines) total += line.size() + 1;
+
+        std::wstring joined;
+        joined.reserve(total);
+        for (const auto& line : lines) {
+            if (line.empty()) continue;
+            if (!joined.empty()) joined += L' ';
+            joined.append(line);
+        }
+        lines.assign(1, arena.Store(joined));
+    };
+}
+
+//------------------------------------------------------------------------------
+// Comment every non-blank line with 'prefix', or uncomment if all non-blank
+// lines already carry it (with or without its trailing space)
+//------------------------------------------------------------------------------
+LinePipeline::ListFn ToggleComment(std::wstring prefix) {
+    return [prefix = std::move(prefix)](std::vector<std::wstring_view>& lines, TextArena& arena) {
+        std::wstring_view full = prefix;
+        std::wstring_view trimmed = full.substr(0, full.find_last_not_of(L' ') + 1);
+
+        auto startsWith = [](std::wstring_view s, std::wstring_view p) {
+            return s.size() >= p.size() && s.compare(0, p.size(), p) == 0;
+        };
+
+        bool allCommented = true;
+        for (const auto& line : lines) {
+            size_t first = line.find_first_not_of(L" \t");
+            if (first == std::wstring_view::npos) continue;
+            std::wstring_view body = line.substr(first);
+            if (!startsWith(body, full) && !startsWith(body, trimmed)) {
+                allCommented = false;
+                break;
+            }
+        }
+
+        for (auto& line : lines) {
+            size_t first = line.find_first_not_of(L" \t");
+            if (first == std::wstring_view::npos) continue;
+            std::wstring_view indent = line.substr(0, first);
+            std::wstring_view body = line.substr(first);
+            if (allCommented) {
+                size_t strip = startsWith(body, full) ? full.size() : trimmed.size();
+                line = arena.Concat({ indent, body.substr(strip) });
+            } else {
+                line = arena.Concat({ indent, full, body });
+            }
+        }
+    };
+}
+
+} // namespace LineTransforms
+
+} // namespace QNote
@@ -0,0 +1,137 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineTransform.h - Line-view pipeline for Edit/Tools line operations
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies, so it can be reused outside the UI.
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <initializer_list>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// TextArena - bump allocator for text produced by line transforms.
+// Views returned by Store()/Concat() stay valid until Clear() or destruction.
+//------------------------------------------------------------------------------
+class TextArena {
+public:
+    explicit TextArena(size_t blockChars = DEFAULT_BLOCK_CHARS) noexcept
+        : m_blockChars(blockChars) {}
+
+    TextArena(const TextArena&) = delete;
+    TextArena& operator=(const TextArena&) = delete;
+
+    // Copy text into the arena
+    [[nodiscard]] std::wstring_view Store(std::wstring_view text);
+
+    // Concatenate several pieces into one arena-owned view
+    [[nodiscard]] std::wstring_view Concat(std::initializer_list<std::wstring_view> parts);
+
+    // Release all storage
+    void Clear() noexcept;
+
+private:
+    wchar_t* Allocate(size_t count);
+
+    static constexpr size_t DEFAULT_BLOCK_CHARS = 64 * 1024;
+
+    std::vector<std::unique_ptr<wchar_t[]>> m_blocks;
+    size_t m_blockChars;
+    size_t m_used = 0;
+    size_t m_capacity = 0;
+};
+
+//------------------------------------------------------------------------------
+// LineSet - line views over a source text plus what is needed to join them
+//------------------------------------------------------------------------------
+struct LineSet {
+    std::vector<std::wstring_view> lines;  // Lines without terminators
+    std::wstring_view eol = L"\r\n";       // Terminator used when joining
+    bool trailingEol = false;              // Source ended with a terminator
+};
+
+// Split text into line views.  Recognizes \r\n, \n and \r (RichEdit) and
+// reuses the first terminator found when the lines are joined again.
+[[nodiscard]] LineSet SplitLines(std::wstring_view text);
+
+// Join lines with the set's terminator (single allocation)
+[[nodiscard]] std::wstring JoinLines(const LineSet& set);
+
+//------------------------------------------------------------------------------
+// TextEdit - one replacement that turns 'before' into 'after'
+//------------------------------------------------------------------------------
+struct TextEdit {
+    size_t start = 0;                      // Offset in 'before'
+    size_t removeLength = 0;               // Characters of 'before' replaced
+    std::wstring_view insert;              // Replacement (view into 'after')
+
+    [[nodiscard]] bool IsNoOp() const noexcept { return removeLength == 0 && insert.empty(); }
+};
+
+// Smallest single edit (common prefix/suffix trimmed) between two texts
+[[nodiscard]] TextEdit ComputeMinimalEdit(std::wstring_view before, std::wstring_view after);
+
+//------------------------------------------------------------------------------
+// LinePipeline - composable line transforms.
+// Consecutive Map() stages are fused into a single pass over the lines;
+// Apply() stages (sort, reverse, ...) see the whole line list.  New text is
+// allocated in the run's TextArena, unchanged lines stay views of the source.
+//------------------------------------------------------------------------------
+class LinePipeline {
+public:
+    // Rewrite 'line' in place; return false to drop it.  'index' counts the
+    // lines that reached this stage.
+    using LineFn = std::function<bool(std::wstring_view& line, size_t index, TextArena& arena)>;
+
+    // Transform the whole list (may reorder, insert or remove lines)
+    using ListFn = std::function<void(std::vector<std::wstring_view>& lines, TextArena& arena)>;
+
+    LinePipeline& Map(LineFn fn);
+    LinePipeline& Apply(ListFn fn);
+
+    [[nodiscard]] bool IsEmpty() const noexcept { return m_stages.empty(); }
+
+    // Run all stages on a split line set
+    void Run(LineSet& set, TextArena& arena) const;
+
+    // Split, run and join
+    [[nodiscard]] std::wstring Run(std::wstring_view text) const;
+
+private:
+    struct Stage {
+        LineFn map;
+        ListFn apply;
+    };
+
+    void RunFused(std::vector<std::wstring_view>& lines, size_t first, size_t last,
+                  TextArena& arena) const;
+
+    std::vector<Stage> m_stages;
+};
+
+//------------------------------------------------------------------------------
+// Stock transforms used by the Edit and Tools menus
+//------------------------------------------------------------------------------
+namespace LineTransforms {
+
+// Per-line stages
+[[nodiscard]] LinePipeline::LineFn TrimTrailingWhitespace();
+[[nodiscard]] LinePipeline::LineFn RemoveBlankLines();
+[[nodiscard]] LinePipeline::LineFn LeadingSpacesToTabs(int tabSize);
+
+// Whole-list stages (sorting and dedupe live in LineSort.h / LineDedupe.h)
+[[nodiscard]] LinePipeline::ListFn Reverse();
+[[nodiscard]] LinePipeline::ListFn NumberLines();
+[[nodiscard]] LinePipeline::ListFn WrapAt(int maxWidth);
+[[nodiscard]] LinePipeline::ListFn JoinWithSpaces();
+[[nodiscard]] LinePipeline::ListFn ToggleComment(std::wstring prefix);
+
+} // namespace LineTransforms
+
+} // namespace QNote
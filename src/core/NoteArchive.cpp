@@ -0,0 +1,588 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteArchive.cpp - Streaming JSON writer and reader for note export files
+//==============================================================================
+
+#include "NoteArchive.h"
+#include <charconv>
+#include <climits>
+
+namespace QNote {
+
+namespace {
+
+constexpr uint32_t REPLACEMENT_CHAR = 0xFFFD;
+
+bool IsHighSurrogate(uint32_t unit) { return unit >= 0xD800 && unit <= 0xDBFF; }
+bool IsLowSurrogate(uint32_t unit) { return unit >= 0xDC00 && unit <= 0xDFFF; }
+bool IsDigit(int ch) { return ch >= '0' && ch <= '9'; }
+
+// Append a code point as UTF-16 or UTF-32, whichever wchar_t holds
+void AppendCodePoint(std::wstring* out, uint32_t cp) {
+    if (!out) return;
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        out->push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+        out->push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+    } else {
+        out->push_back(static_cast<wchar_t>(cp));
+    }
+}
+
+void AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// NoteArchiveWriter
+//------------------------------------------------------------------------------
+
+NoteArchiveWriter::NoteArchiveWriter(Sink sink)
+    : m_sink(std::move(sink)) {
+    m_buffer.reserve(BUFFER_SIZE + 64);
+    Append("[\n", 2);
+}
+
+bool NoteArchiveWriter::WriteNote(const NoteArchiveRecord& note) {
+    if (m_failed) return false;
+
+    // The comma goes before each note after the first, so the writer never
+    // needs to know which note is last
+    if (m_noteCount > 0) {
+        Append(",\n", 2);
+    }
+    static constexpr char ID[] = "  {\n    \"id\": \"";
+    static constexpr char TITLE[] = "\",\n    \"title\": \"";
+    static constexpr char CONTENT[] = "\",\n    \"content\": \"";
+    static constexpr char CREATED[] = "\",\n    \"createdAt\": ";
+    static constexpr char UPDATED[] = ",\n    \"updatedAt\": ";
+    static constexpr char PINNED[] = ",\n    \"isPinned\": ";
+
+    Append(ID, sizeof(ID) - 1);
+    AppendString(note.id);
+    Append(TITLE, sizeof(TITLE) - 1);
+    AppendString(note.title);
+    Append(CONTENT, sizeof(CONTENT) - 1);
+    AppendString(note.content);
+    Append(CREATED, sizeof(CREATED) - 1);
+    AppendNumber(static_cast<long long>(note.createdAt));
+    Append(UPDATED, sizeof(UPDATED) - 1);
+    AppendNumber(static_cast<long long>(note.updatedAt));
+    Append(PINNED, sizeof(PINNED) - 1);
+    if (note.isPinned) {
+        Append("true\n  }", 8);
+    } else {
+        Append("false\n  }", 9);
+    }
+    m_noteCount++;
+
+    return FlushIfFull();
+}
+
+bool NoteArchiveWriter::Finish() {
+    if (m_failed) return false;
+    Append(m_noteCount > 0 ? "\n]\n" : "]\n", m_noteCount > 0 ? 3 : 2);
+    return FlushBuffer();
+}
+
+void NoteArchiveWriter::Append(const char* text, size_t length) {
+    m_buffer.append(text, length);
+}
+
+//------------------------------------------------------------------------------
+// Escape as JSON and encode as UTF-8 straight into the buffer.  A long note
+// is flushed as it goes instead of growing the buffer to its size.
+//------------------------------------------------------------------------------
+void NoteArchiveWriter::AppendString(const std::wstring& text) {
+    static constexpr char HEX[] = "0123456789abcdef";
+
+    const size_t length = text.size();
+    for (size_t i = 0; i < length; ++i) {
+        uint32_t cp = static_cast<uint32_t>(text[i]);
+        switch (cp) {
+            case '\\': m_buffer.append("\\\\", 2); break;
+            case '"':  m_buffer.append("\\\"", 2); break;
+            case '\n': m_buffer.append("\\n", 2); break;
+            case '\r': m_buffer.append("\\r", 2); break;
+            case '\t': m_buffer.append("\\t", 2); break;
+            case '\b': m_buffer.append("\\b", 2); break;
+            case '\f': m_buffer.append("\\f", 2); break;
+            default:
+                if (cp < 0x20) {
+                    const char escape[] = { '\\', 'u', '0', '0', HEX[cp >> 4], HEX[cp & 0xF] };
+                    m_buffer.append(escape, sizeof(escape));
+                } else if (cp < 0x80) {
+                    m_buffer.push_back(static_cast<char>(cp));
+                } else {
+                    if (IsHighSurrogate(cp) && i + 1 < length &&
+                        IsLowSurrogate(static_cast<uint32_t>(text[i + 1]))) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) +
+                             (static_cast<uint32_t>(text[i + 1]) - 0xDC00);
+                        ++i;
+                    } else if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) {
+                        cp = REPLACEMENT_CHAR;
+                    }
+                    AppendUtf8(m_buffer, cp);
+                }
+                break;
+        }
+        if (m_buffer.size() >= BUFFER_SIZE && !FlushBuffer()) {
+            return;
+        }
+    }
+}
+
+void NoteArchiveWriter::AppendNumber(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    m_buffer.append(digits, static_cast<size_t>(result.ptr - digits));
+}
+
+bool NoteArchiveWriter::FlushIfFull() {
+    return m_buffer.size() < BUFFER_SIZE ? true : FlushBuffer();
+}
+
+bool NoteArchiveWriter::FlushBuffer() {
+    if (m_failed) {
+        m_buffer.clear();
+        return false;
+    }
+    if (!m_buffer.empty()) {
+        if (!m_sink || !m_sink(m_buffer.data(), m_buffer.size())) {
+            m_failed = true;
+        } else {
+            m_bytesWritten += m_buffer.size();
+        }
+        m_buffer.clear();
+    }
+    return !m_failed;
+}
+
+//------------------------------------------------------------------------------
+// NoteArchiveReader
+//------------------------------------------------------------------------------
+
+NoteArchiveReader::NoteArchiveReader(Source source)
+    : m_source(std::move(source)), m_buffer(READ_CHUNK) {
+}
+
+bool NoteArchiveReader::Next(NoteArchiveRecord& note) {
+    if (m_state == State::Start) {
+        if (!OpenArchive()) {
+            m_state = State::Done;
+            return false;
+        }
+        m_state = State::InArray;
+    }
+
+    while (m_state == State::InArray) {
+        int ch = SkipSpace();
+        if (!m_firstElement && ch == ',') {
+            m_pos++;
+            ch = SkipSpace();
+        } else if (!m_firstElement && ch != ']') {
+            return Fail();
+        }
+        m_firstElement = false;
+
+        // Anything after the array is ignored, as the old parser did
+        if (ch == ']') {
+            m_pos++;
+            m_state = State::Done;
+            return false;
+        }
+        if (ch == '{') {
+            m_pos++;
+            if (!ReadNote(note)) return false;
+            if (!note.id.empty()) return true;
+        } else if (!SkipValue()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Input
+//------------------------------------------------------------------------------
+
+int NoteArchiveReader::Peek() {
+    if (m_pos == m_end && !Refill()) return -1;
+    return static_cast<unsigned char>(m_buffer[m_pos]);
+}
+
+int NoteArchiveReader::Get() {
+    int ch = Peek();
+    if (ch >= 0) m_pos++;
+    return ch;
+}
+
+bool NoteArchiveReader::Refill() {
+    if (m_eof) return false;
+
+    size_t bytesRead = 0;
+    if (!m_source || !m_source(m_buffer.data(), m_buffer.size(), bytesRead)) {
+        m_eof = true;
+        m_error = true;
+        return false;
+    }
+    if (bytesRead == 0) {
+        m_eof = true;
+        return false;
+    }
+    m_pos = 0;
+    m_end = bytesRead;
+    m_bytesRead += bytesRead;
+    return true;
+}
+
+int NoteArchiveReader::SkipSpace() {
+    while (true) {
+        int ch = Peek();
+        if (ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r') return ch;
+        m_pos++;
+    }
+}
+
+bool NoteArchiveReader::Expect(char ch) {
+    if (SkipSpace() != ch) return Fail();
+    m_pos++;
+    return true;
+}
+
+bool NoteArchiveReader::Fail() {
+    m_error = true;
+    m_state = State::Done;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Structure
+//------------------------------------------------------------------------------
+
+// Position the reader inside the note array; false if there is none
+bool NoteArchiveReader::OpenArchive() {
+    if (Peek() == 0xEF) {
+        m_pos++;
+        if (Get() != 0xBB || Get() != 0xBF) return Fail();
+    }
+
+    int ch = SkipSpace();
+    if (ch < 0) return false;                      // Empty file: no notes
+    if (ch == '[') {
+        m_pos++;
+        return true;
+    }
+    if (ch != '{') return Fail();
+    m_pos++;
+
+    bool first = true;
+    while (true) {
+        ch = SkipSpace();
+        if (ch == '}') {
+            m_pos++;
+            return false;
+        }
+        if (!first) {
+            if (ch != ',') return Fail();
+            m_pos++;
+            ch = SkipSpace();
+        }
+        first = false;
+
+        if (ch != '"') return Fail();
+        m_pos++;
+        if (!ReadString(&m_key) || !Expect(':')) return false;
+        if (m_key == L"notes") {
+            return Expect('[');
+        }
+        if (!SkipValue()) return false;
+    }
+}
+
+// Read the members of a note object; the opening brace has been read
+bool NoteArchiveReader::ReadNote(NoteArchiveRecord& note) {
+    note.id.clear();
+    note.title.clear();
+    note.content.clear();
+    note.createdAt = 0;
+    note.updatedAt = 0;
+    note.isPinned = false;
+
+    bool first = true;
+    while (true) {
+        int ch = SkipSpace();
+        if (!first && ch == ',') {
+            m_pos++;
+            ch = SkipSpace();
+        } else if (!first && ch != '}') {
+            return Fail();
+        }
+        first = false;
+
+        if (ch == '}') {
+            m_pos++;
+            return true;
+        }
+        if (ch != '"') return Fail();
+        m_pos++;
+        if (!ReadString(&m_key) || !Expect(':')) return false;
+
+        ch = SkipSpace();
+        std::wstring* text = nullptr;
+        time_t* time = nullptr;
+        if (m_key == L"id") text = &note.id;
+        else if (m_key == L"title") text = &note.title;
+        else if (m_key == L"content") text = &note.content;
+        else if (m_key == L"createdAt") time = &note.createdAt;
+        else if (m_key == L"updatedAt") time = &note.updatedAt;
+
+        if (text && ch == '"') {
+            m_pos++;
+            if (!ReadString(text)) return false;
+        } else if (time && (ch == '-' || IsDigit(ch))) {
+            long long value = 0;
+            if (!ReadNumber(value)) return false;
+            *time = static_cast<time_t>(value);
+        } else if (m_key == L"isPinned" && (ch == 't' || ch == 'f')) {
+            m_pos++;
+            if (!ReadLiteral(ch == 't' ? "rue" : "alse")) return false;
+            note.isPinned = (ch == 't');
+        } else if (!SkipValue()) {
+            return false;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Values
+//------------------------------------------------------------------------------
+
+// Read a string whose opening quote has been read, decoding UTF-8 and
+// escapes into 'out' (or skipping it when 'out' is null)
+bool NoteArchiveReader::ReadString(std::wstring* out) {
+    if (out) out->clear();
+
+    while (true) {
+        if (m_pos == m_end && !Refill()) return Fail();
+        const int ch = static_cast<unsigned char>(m_buffer[m_pos++]);
+
+        if (ch == '"') return true;
+        if (ch == '\\') {
+            if (!ReadEscape(out)) return false;
+            continue;
+        }
+        if (ch < 0x80) {
+            if (out) out->push_back(static_cast<wchar_t>(ch));
+            continue;
+        }
+
+        uint32_t cp;
+        int extra;
+        uint32_t minimum;
+        if ((ch & 0xE0) == 0xC0) {
+            cp = ch & 0x1F; extra = 1; minimum = 0x80;
+        } else if ((ch & 0xF0) == 0xE0) {
+            cp = ch & 0x0F; extra = 2; minimum = 0x800;
+        } else if ((ch & 0xF8) == 0xF0) {
+            cp = ch & 0x07; extra = 3; minimum = 0x10000;
+        } else {
+            AppendCodePoint(out, REPLACEMENT_CHAR);
+            continue;
+        }
+
+        // A byte that does not continue the sequence is left for the next
+        // character (it may be the closing quote)
+        bool valid = true;
+        for (int i = 0; i < extra; ++i) {
+            int next = Peek();
+            if (next < 0 || (next & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            m_pos++;
+            cp = (cp << 6) | static_cast<uint32_t>(next & 0x3F);
+        }
+        if (!valid || cp < minimum || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            cp = REPLACEMENT_CHAR;
+        }
+        AppendCodePoint(out, cp);
+    }
+}
+
+// An escape whose backslash has been read.  \u surrogate pairs are joined;
+// a lone surrogate reads as U+FFFD.
+bool NoteArchiveReader::ReadEscape(std::wstring* out) {
+    int ch = Get();
+    if (ch < 0) return Fail();
+    if (ch != 'u') return ReadSimpleEscape(ch, out);
+
+    uint32_t unit = 0;
+    if (!ReadHex4(unit)) return false;
+
+    if (IsHighSurrogate(unit) && Peek() == '\\') {
+        m_pos++;
+        int next = Get();
+        if (next != 'u') {
+            AppendCodePoint(out, REPLACEMENT_CHAR);
+            return next < 0 ? Fail() : ReadSimpleEscape(next, out);
+        }
+        uint32_t low = 0;
+        if (!ReadHex4(low)) return false;
+        if (IsLowSurrogate(low)) {
+            AppendCodePoint(out, 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+            return true;
+        }
+        AppendCodePoint(out, REPLACEMENT_CHAR);
+        unit = low;
+    }
+
+    AppendCodePoint(out, (unit >= 0xD800 && unit <= 0xDFFF) ? REPLACEMENT_CHAR : unit);
+    return true;
+}
+
+// Unknown escapes are kept as written, as JsonUnescape() does
+bool NoteArchiveReader::ReadSimpleEscape(int ch, std::wstring* out) {
+    uint32_t cp;
+    switch (ch) {
+        case '"':  cp = '"'; break;
+        case '\\': cp = '\\'; break;
+        case '/':  cp = '/'; break;
+        case 'b':  cp = '\b'; break;
+        case 'f':  cp = '\f'; break;
+        case 'n':  cp = '\n'; break;
+        case 'r':  cp = '\r'; break;
+        case 't':  cp = '\t'; break;
+        default:
+            AppendCodePoint(out, '\\');
+            if (ch < 0x80) {
+                AppendCodePoint(out, static_cast<uint32_t>(ch));
+            } else {
+                m_pos--;                           // Decode the UTF-8 sequence normally
+            }
+            return true;
+    }
+    AppendCodePoint(out, cp);
+    return true;
+}
+
+bool NoteArchiveReader::ReadHex4(uint32_t& unit) {
+    unit = 0;
+    for (int i = 0; i < 4; ++i) {
+        int ch = Get();
+        uint32_t digit;
+        if (ch >= '0' && ch <= '9') digit = static_cast<uint32_t>(ch - '0');
+        else if (ch >= 'a' && ch <= 'f') digit = static_cast<uint32_t>(ch - 'a' + 10);
+        else if (ch >= 'A' && ch <= 'F') digit = static_cast<uint32_t>(ch - 'A' + 10);
+        else return Fail();
+        unit = (unit << 4) | digit;
+    }
+    return true;
+}
+
+// Integer part of a JSON number, saturated; any fraction or exponent is
+// read and dropped
+bool NoteArchiveReader::ReadNumber(long long& value) {
+    bool negative = false;
+    if (Peek() == '-') {
+        m_pos++;
+        negative = true;
+    }
+    if (!IsDigit(Peek())) return Fail();
+
+    unsigned long long magnitude = 0;
+    const unsigned long long limit = static_cast<unsigned long long>(LLONG_MAX);
+    while (IsDigit(Peek())) {
+        unsigned long long digit = static_cast<unsigned long long>(Get() - '0');
+        magnitude = (magnitude > (limit - digit) / 10) ? limit : magnitude * 10 + digit;
+    }
+    if (Peek() == '.') {
+        m_pos++;
+        while (IsDigit(Peek())) m_pos++;
+    }
+    if (Peek() == 'e' || Peek() == 'E') {
+        m_pos++;
+        if (Peek() == '+' || Peek() == '-') m_pos++;
+        while (IsDigit(Peek())) m_pos++;
+    }
+
+    value = negative ? -static_cast<long long>(magnitude) : static_cast<long long>(magnitude);
+    return true;
+}
+
+bool NoteArchiveReader::ReadLiteral(const char* rest) {
+    for (; *rest; ++rest) {
+        if (Get() != static_cast<unsigned char>(*rest)) return Fail();
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Skip one value of any type without keeping it.  Nesting is counted rather
+// than recursed into, so a deeply nested value cannot overflow the stack.
+//------------------------------------------------------------------------------
+bool NoteArchiveReader::SkipValue() {
+    int depth = 0;
+    do {
+        int ch = SkipSpace();
+        switch (ch) {
+            case '"':
+                m_pos++;
+                if (!ReadString(nullptr)) return false;
+                break;
+            case '{':
+            case '[':
+                m_pos++;
+                if (++depth > MAX_DEPTH) return Fail();
+                break;
+            case '}':
+            case ']':
+                if (depth == 0) return Fail();
+                m_pos++;
+                depth--;
+                break;
+            case ',':
+            case ':':
+                if (depth == 0) return Fail();
+                m_pos++;
+                break;
+            case 't':
+                m_pos++;
+                if (!ReadLiteral("rue")) return false;
+                break;
+            case 'f':
+                m_pos++;
+                if (!ReadLiteral("alse")) return false;
+                break;
+            case 'n':
+                m_pos++;
+                if (!ReadLiteral("ull")) return false;
+                break;
+            default: {
+                if (ch != '-' && !IsDigit(ch)) return Fail();
+                long long ignored = 0;
+                if (!ReadNumber(ignored)) return false;
+                break;
+            }
+        }
+    } while (depth > 0);
+    return true;
+}
+
+} // namespace QNote
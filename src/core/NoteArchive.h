@@ -0,0 +1,135 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteArchive.h - Streaming JSON writer and reader for note export files
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// One note as stored in an export file
+//------------------------------------------------------------------------------
+struct NoteArchiveRecord {
+    std::wstring id;
+    std::wstring title;
+    std::wstring content;
+    time_t createdAt = 0;
+    time_t updatedAt = 0;
+    bool isPinned = false;
+};
+
+//------------------------------------------------------------------------------
+// Writes an export file one note at a time: a UTF-8 JSON array of note
+// objects, laid out as the old whole-file export was.  Output is buffered
+// and handed to 'sink' in chunks of about BUFFER_SIZE bytes, so memory use
+// does not grow with the number of notes.
+//------------------------------------------------------------------------------
+class NoteArchiveWriter {
+public:
+    // Write 'size' bytes; false on failure
+    using Sink = std::function<bool(const char* data, size_t size)>;
+
+    explicit NoteArchiveWriter(Sink sink);
+
+    NoteArchiveWriter(const NoteArchiveWriter&) = delete;
+    NoteArchiveWriter& operator=(const NoteArchiveWriter&) = delete;
+
+    [[nodiscard]] bool WriteNote(const NoteArchiveRecord& note);
+
+    // Close the array and write what is still buffered
+    [[nodiscard]] bool Finish();
+
+    [[nodiscard]] uint64_t GetBytesWritten() const noexcept { return m_bytesWritten; }
+
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+private:
+    void Append(const char* text, size_t length);
+    void AppendString(const std::wstring& text);
+    void AppendNumber(long long value);
+    [[nodiscard]] bool FlushIfFull();
+    [[nodiscard]] bool FlushBuffer();
+
+    Sink m_sink;
+    std::string m_buffer;
+    uint64_t m_bytesWritten = 0;
+    size_t m_noteCount = 0;
+    bool m_failed = false;
+};
+
+//------------------------------------------------------------------------------
+// Pull reader for export files.  Next() parses the archive up to the end of
+// the next note and returns it, reading 'source' in READ_CHUNK pieces, so
+// only one note is in memory at a time.
+//
+// Accepts a JSON array of note objects (optionally after a UTF-8 BOM), or
+// an object whose "notes" member is one, as in the note index.  Unknown
+// members and non-object array elements are skipped; notes without an id
+// are skipped.  Invalid UTF-8 is read as U+FFFD.
+//------------------------------------------------------------------------------
+class NoteArchiveReader {
+public:
+    // Read up to 'capacity' bytes into 'buffer'; 'bytesRead' is 0 at the
+    // end of the input.  False on a read error.
+    using Source = std::function<bool(char* buffer, size_t capacity, size_t& bytesRead)>;
+
+    explicit NoteArchiveReader(Source source);
+
+    NoteArchiveReader(const NoteArchiveReader&) = delete;
+    NoteArchiveReader& operator=(const NoteArchiveReader&) = delete;
+
+    // The next note; false at the end of the archive or on an error.
+    // 'note' is overwritten, so passing the same record each time reuses
+    // its buffers.
+    [[nodiscard]] bool Next(NoteArchiveRecord& note);
+
+    // True if reading stopped on malformed JSON or a read error
+    [[nodiscard]] bool HasError() const noexcept { return m_error; }
+
+    [[nodiscard]] uint64_t GetBytesRead() const noexcept { return m_bytesRead; }
+
+    static constexpr size_t READ_CHUNK = 64 * 1024;
+    static constexpr int MAX_DEPTH = 256;          // Nesting allowed in skipped values
+
+private:
+    enum class State { Start, InArray, Done };
+
+    [[nodiscard]] int Peek();
+    [[nodiscard]] int Get();
+    [[nodiscard]] bool Refill();
+    [[nodiscard]] int SkipSpace();
+    [[nodiscard]] bool Expect(char ch);
+    [[nodiscard]] bool Fail();
+
+    [[nodiscard]] bool OpenArchive();
+    [[nodiscard]] bool ReadNote(NoteArchiveRecord& note);
+    [[nodiscard]] bool ReadString(std::wstring* out);
+    [[nodiscard]] bool ReadEscape(std::wstring* out);
+    [[nodiscard]] bool ReadSimpleEscape(int ch, std::wstring* out);
+    [[nodiscard]] bool ReadHex4(uint32_t& unit);
+    [[nodiscard]] bool ReadNumber(long long& value);
+    [[nodiscard]] bool ReadLiteral(const char* rest);
+    [[nodiscard]] bool SkipValue();
+
+    Source m_source;
+    std::vector<char> m_buffer;
+    size_t m_pos = 0;
+    size_t m_end = 0;
+    bool m_eof = false;
+    bool m_error = false;
+    uint64_t m_bytesRead = 0;
+    State m_state = State::Start;
+    bool m_firstElement = true;
+    std::wstring m_key;
+};
+
+} // namespace QNote
@@ -0,0 +1,199 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteContentCache.cpp - Byte-budgeted, scan-resistant note content cache
+//==============================================================================
+
+#include "NoteContentCache.h"
+
+namespace QNote {
+
+NoteContentCache::NoteContentCache(size_t capacityBytes)
+    : m_capacityBytes(capacityBytes) {
+}
+
+//------------------------------------------------------------------------------
+// Lookup.  A normal read of a probation entry is its second use, so it
+// moves to the main queue; scans leave the order alone.
+//------------------------------------------------------------------------------
+NoteContentPtr NoteContentCache::Find(const std::wstring& id, CacheAccess access) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+
+    Entry& entry = it->second;
+    if (access == CacheAccess::Normal) {
+        if (entry.inMain) {
+            m_main.splice(m_main.begin(), m_main, entry.position);
+        } else {
+            m_probation.erase(entry.position);
+            m_probationBytes -= entry.bytes;
+            m_main.push_front(id);
+            entry.position = m_main.begin();
+            entry.inMain = true;
+            m_mainBytes += entry.bytes;
+        }
+    }
+    return entry.content;
+}
+
+//------------------------------------------------------------------------------
+// Add content after a miss.  Ids remembered from a recent probation
+// eviction go straight to the main queue, unless this is a scan.  An entry
+// that appeared since the miss was written meanwhile and is newer than
+// what the caller read, so it is kept.
+//------------------------------------------------------------------------------
+void NoteContentCache::Insert(const std::wstring& id, NoteContentPtr content, CacheAccess access) {
+    if (!content) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.find(id) != m_entries.end()) return;
+
+    bool wasGhost = Forget(id);
+    bool toMain = wasGhost && access == CacheAccess::Normal;
+    Store(id, std::move(content), toMain);
+}
+
+void NoteContentCache::Update(const std::wstring& id, NoteContentPtr content) {
+    if (!content) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Forget(id);
+    Store(id, std::move(content), true);
+}
+
+void NoteContentCache::Erase(const std::wstring& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Forget(id);
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        Unlink(it->second);
+        m_entries.erase(it);
+    }
+}
+
+void NoteContentCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_probation.clear();
+    m_main.clear();
+    m_ghosts.clear();
+    m_ghostIndex.clear();
+    m_probationBytes = 0;
+    m_mainBytes = 0;
+}
+
+void NoteContentCache::SetCapacity(size_t capacityBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacityBytes = capacityBytes;
+    EvictToCapacity();
+}
+
+NoteContentCacheStats NoteContentCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    NoteContentCacheStats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.entries = m_entries.size();
+    stats.bytes = m_probationBytes + m_mainBytes;
+    stats.probationBytes = m_probationBytes;
+    stats.capacityBytes = m_capacityBytes;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+// Helpers (m_mutex held)
+//------------------------------------------------------------------------------
+
+size_t NoteContentCache::EntryBytes(const std::wstring& id, const std::wstring& content) noexcept {
+    return (id.size() + content.size()) * sizeof(wchar_t) + ENTRY_OVERHEAD_BYTES;
+}
+
+// Insert or replace an entry at the front of its queue
+void NoteContentCache::Store(const std::wstring& id, NoteContentPtr content, bool toMain) {
+    size_t bytes = EntryBytes(id, *content);
+
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        Unlink(it->second);
+        m_entries.erase(it);
+    }
+
+    // Content larger than the whole budget is not worth evicting everything for
+    if (bytes > m_capacityBytes) return;
+
+    Entry entry;
+    entry.content = std::move(content);
+    entry.bytes = bytes;
+    entry.inMain = toMain;
+    if (toMain) {
+        m_main.push_front(id);
+        entry.position = m_main.begin();
+        m_mainBytes += bytes;
+    } else {
+        m_probation.push_front(id);
+        entry.position = m_probation.begin();
+        m_probationBytes += bytes;
+    }
+    m_entries.emplace(id, std::move(entry));
+
+    EvictToCapacity();
+}
+
+void NoteContentCache::Unlink(Entry& entry) {
+    if (entry.inMain) {
+        m_main.erase(entry.position);
+        m_mainBytes -= entry.bytes;
+    } else {
+        m_probation.erase(entry.position);
+        m_probationBytes -= entry.bytes;
+    }
+}
+
+void NoteContentCache::Remember(const std::wstring& id) {
+    m_ghosts.push_front(id);
+    m_ghostIndex[id] = m_ghosts.begin();
+    if (m_ghosts.size() > MAX_GHOSTS) {
+        m_ghostIndex.erase(m_ghosts.back());
+        m_ghosts.pop_back();
+    }
+}
+
+// Drop the id from the ghost list; true if it was there
+bool NoteContentCache::Forget(const std::wstring& id) {
+    auto it = m_ghostIndex.find(id);
+    if (it == m_ghostIndex.end()) return false;
+    m_ghosts.erase(it->second);
+    m_ghostIndex.erase(it);
+    return true;
+}
+
+// Evict oldest probation entries while probation is over its share (or
+// main is empty), otherwise the least recently used main entries
+void NoteContentCache::EvictToCapacity() {
+    const size_t probationLimit = m_capacityBytes / 100 * PROBATION_PERCENT;
+
+    while (m_probationBytes + m_mainBytes > m_capacityBytes) {
+        bool fromProbation = !m_probation.empty() &&
+                             (m_probationBytes > probationLimit || m_main.empty());
+        std::list<std::wstring>& queue = fromProbation ? m_probation : m_main;
+        if (queue.empty()) break;
+
+        std::wstring id = queue.back();
+        auto it = m_entries.find(id);
+        Unlink(it->second);
+        m_entries.erase(it);
+        m_evictions++;
+
+        if (fromProbation) {
+            Remember(id);
+        }
+    }
+}
+
+} // namespace QNote
@@ -0,0 +1,111 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteContentCache.h - Byte-budgeted, scan-resistant note content cache
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace QNote {
+
+// Note content shared between the cache and its readers; never modified
+using NoteContentPtr = std::shared_ptr<const std::wstring>;
+
+//------------------------------------------------------------------------------
+// How a lookup should affect the cache.  Bulk passes over many notes
+// (searching, filtering, export) use Scan so they cannot push out the notes
+// the user is working with.
+//------------------------------------------------------------------------------
+enum class CacheAccess {
+    Normal,
+    Scan
+};
+
+struct NoteContentCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;               // Estimated, including per-entry overhead
+    size_t probationBytes = 0;
+    size_t capacityBytes = 0;
+};
+
+//------------------------------------------------------------------------------
+// 2Q cache keyed by note id, budgeted in bytes.  New content enters a FIFO
+// probation queue; it moves to the main LRU queue when it is read again
+// normally, when it is written, or when it is loaded again soon after being
+// evicted from probation (remembered in a small ghost list of ids).
+// Probation is evicted first once it holds more than its share of the
+// budget, so a scan only ever replaces other probation entries.
+//
+// Safe to use from several threads.  Readers keep the buffers they were
+// given even if the entry is evicted or replaced meanwhile.
+//------------------------------------------------------------------------------
+class NoteContentCache {
+public:
+    explicit NoteContentCache(size_t capacityBytes = DEFAULT_CAPACITY_BYTES);
+
+    NoteContentCache(const NoteContentCache&) = delete;
+    NoteContentCache& operator=(const NoteContentCache&) = delete;
+
+    // Cached content, or null (counted as a miss)
+    [[nodiscard]] NoteContentPtr Find(const std::wstring& id, CacheAccess access = CacheAccess::Normal);
+
+    // Add content read from disk after a miss, unless newer content was
+    // cached meanwhile
+    void Insert(const std::wstring& id, NoteContentPtr content, CacheAccess access = CacheAccess::Normal);
+
+    // Content was just written: cache it as recently used
+    void Update(const std::wstring& id, NoteContentPtr content);
+
+    void Erase(const std::wstring& id);
+    void Clear();
+
+    void SetCapacity(size_t capacityBytes);
+    [[nodiscard]] NoteContentCacheStats GetStats() const;
+
+    static constexpr size_t DEFAULT_CAPACITY_BYTES = 32ULL * 1024 * 1024;
+
+private:
+    struct Entry {
+        NoteContentPtr content;
+        size_t bytes = 0;
+        bool inMain = false;
+        std::list<std::wstring>::iterator position;
+    };
+
+    [[nodiscard]] static size_t EntryBytes(const std::wstring& id, const std::wstring& content) noexcept;
+    void Store(const std::wstring& id, NoteContentPtr content, bool toMain);
+    void Unlink(Entry& entry);
+    void Remember(const std::wstring& id);
+    bool Forget(const std::wstring& id);
+    void EvictToCapacity();
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::wstring, Entry> m_entries;
+    std::list<std::wstring> m_probation;        // FIFO, front = newest
+    std::list<std::wstring> m_main;             // LRU, front = most recent
+    std::list<std::wstring> m_ghosts;           // Ids evicted from probation, front = newest
+    std::unordered_map<std::wstring, std::list<std::wstring>::iterator> m_ghostIndex;
+    size_t m_capacityBytes;
+    size_t m_probationBytes = 0;
+    size_t m_mainBytes = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_evictions = 0;
+
+    static constexpr size_t PROBATION_PERCENT = 25;     // Share of the budget
+    static constexpr size_t MAX_GHOSTS = 512;
+    static constexpr size_t ENTRY_OVERHEAD_BYTES = 128; // Map node, list nodes, control block
+};
+
+} // namespace QNote
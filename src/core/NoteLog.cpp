@@ -0,0 +1,990 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteLog.cpp - Log-structured packed storage for note contents
+//==============================================================================
+
+#include "NoteLog.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <set>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace QNote {
+
+namespace {
+
+// Segment file:  magic, version, segment number, flags (4 bytes each),
+// then records back to back.
+//
+// Record:  magic (4), checksum (4), sequence (8), timestamp (8),
+// key length (4), payload length (4), kind (1), reserved (3), key, payload.
+// The checksum is a CRC-32 of the bytes after the sequence followed by the
+// sequence itself.  All integers are little-endian.
+constexpr uint32_t SEGMENT_MAGIC = 0x534C4E51;     // "QNLS"
+constexpr uint32_t SEGMENT_VERSION = 1;
+constexpr uint32_t SEGMENT_FLAG_COMPACTED = 1;
+constexpr size_t SEGMENT_HEADER_BYTES = 16;
+
+constexpr uint32_t RECORD_MAGIC = 0x524C4E51;      // "QNLR"
+constexpr size_t RECORD_HEADER_BYTES = 36;
+constexpr uint8_t KIND_PUT = 1;
+constexpr uint8_t KIND_REMOVE = 2;
+constexpr uint32_t MAX_KEY_BYTES = 1024;
+constexpr uint32_t MAX_PAYLOAD_BYTES = 1024U * 1024 * 1024;
+
+constexpr wchar_t SEGMENT_EXTENSION[] = L".qnlog";
+
+#ifdef _WIN32
+constexpr wchar_t PATH_SEPARATOR = L'\\';
+#else
+constexpr wchar_t PATH_SEPARATOR = L'/';
+#endif
+
+//------------------------------------------------------------------------------
+// CRC-32 (IEEE 802.3, reflected)
+//------------------------------------------------------------------------------
+constexpr std::array<uint32_t, 256> MakeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> CRC_TABLE = MakeCrcTable();
+
+// Continue a CRC; start with 0
+uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size) noexcept {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void Store32(uint8_t* out, uint32_t value) noexcept {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<uint8_t>(value >> (i * 8));
+}
+
+void Store64(uint8_t* out, uint64_t value) noexcept {
+    for (int i = 0; i < 8; i++) out[i] = static_cast<uint8_t>(value >> (i * 8));
+}
+
+uint32_t Load32(const uint8_t* in) noexcept {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(in[i]) << (i * 8);
+    return value;
+}
+
+uint64_t Load64(const uint8_t* in) noexcept {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(in[i]) << (i * 8);
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// Directory helpers
+//------------------------------------------------------------------------------
+
+#ifndef _WIN32
+// UTF-8 form of a wide path for the POSIX calls
+std::string NarrowPath(const std::wstring& path) {
+    std::string out;
+    out.reserve(path.size());
+    for (wchar_t wc : path) {
+        uint32_t cp = static_cast<uint32_t>(wc);
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return out;
+}
+#endif
+
+bool EnsureDirectory(const std::wstring& directory) {
+#ifdef _WIN32
+    if (CreateDirectoryW(directory.c_str(), nullptr)) return true;
+    DWORD attrs = GetFileAttributesW(directory.c_str());
+    return attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    std::string path = NarrowPath(directory);
+    if (mkdir(path.c_str(), 0755) == 0) return true;
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// Make a newly created file's directory entry durable (NTFS journals it)
+void SyncDirectory([[maybe_unused]] const std::wstring& directory) {
+#ifndef _WIN32
+    int fd = open(NarrowPath(directory).c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+bool RemoveFile(const std::wstring& path) {
+#ifdef _WIN32
+    return DeleteFileW(path.c_str()) != FALSE;
+#else
+    return unlink(NarrowPath(path).c_str()) == 0;
+#endif
+}
+
+// Segment number from a file name such as "0000002a.qnlog"
+bool ParseSegmentName(const std::wstring& name, uint32_t& number) {
+    const size_t extLength = std::size(SEGMENT_EXTENSION) - 1;
+    if (name.size() != 8 + extLength || name.compare(8, extLength, SEGMENT_EXTENSION) != 0) {
+        return false;
+    }
+    number = 0;
+    for (size_t i = 0; i < 8; i++) {
+        wchar_t ch = name[i];
+        uint32_t digit;
+        if (ch >= L'0' && ch <= L'9') digit = ch - L'0';
+        else if (ch >= L'a' && ch <= L'f') digit = ch - L'a' + 10;
+        else return false;
+        number = (number << 4) | digit;
+    }
+    return number != 0;
+}
+
+// Segment numbers present in a directory, ascending
+std::vector<uint32_t> ListSegments(const std::wstring& directory) {
+    std::vector<uint32_t> numbers;
+    uint32_t number = 0;
+#ifdef _WIN32
+    WIN32_FIND_DATAW findData;
+    std::wstring pattern = directory + PATH_SEPARATOR + L"*" + SEGMENT_EXTENSION;
+    HANDLE hFind = FindFirstFileW(pattern.c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            if (ParseSegmentName(findData.cFileName, number)) numbers.push_back(number);
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+    }
+#else
+    if (DIR* dir = opendir(NarrowPath(directory).c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::wstring name(entry->d_name, entry->d_name + std::strlen(entry->d_name));
+            if (ParseSegmentName(name, number)) numbers.push_back(number);
+        }
+        closedir(dir);
+    }
+#endif
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// One open segment file with positional reads and writes
+//------------------------------------------------------------------------------
+class NoteLog::SegmentFile {
+public:
+    SegmentFile(const SegmentFile&) = delete;
+    SegmentFile& operator=(const SegmentFile&) = delete;
+
+    ~SegmentFile() {
+#ifdef _WIN32
+        if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+#else
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+
+    // Open an existing segment, or create an empty one
+    static std::shared_ptr<SegmentFile> Open(const std::wstring& path, bool create) {
+        std::shared_ptr<SegmentFile> file(new SegmentFile());
+#ifdef _WIN32
+        // Shared for deletion so compacted segments can go while a reader
+        // still holds them
+        file->m_handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                     FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                     create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file->m_handle == INVALID_HANDLE_VALUE) return nullptr;
+#else
+        file->m_fd = open(NarrowPath(path).c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+        if (file->m_fd < 0) return nullptr;
+#endif
+        return file;
+    }
+
+    bool ReadAt(uint64_t offset, uint8_t* data, size_t size) const {
+#ifdef _WIN32
+        while (size > 0) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 64 * 1024 * 1024));
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD read = 0;
+            if (!::ReadFile(m_handle, data, chunk, &read, &position) || read == 0) return false;
+            data += read;
+            offset += read;
+            size -= read;
+        }
+#else
+        while (size > 0) {
+            ssize_t read = pread(m_fd, data, size, static_cast<off_t>(offset));
+            if (read <= 0) return false;
+            data += read;
+            offset += static_cast<uint64_t>(read);
+            size -= static_cast<size_t>(read);
+        }
+#endif
+        return true;
+    }
+
+    bool WriteAt(uint64_t offset, const uint8_t* data, size_t size) {
+#ifdef _WIN32
+        while (size > 0) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 64 * 1024 * 1024));
+            OVERLAPPED position = {};
+            position.Offset = static_cast<DWORD>(offset);
+            position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD written = 0;
+            if (!::WriteFile(m_handle, data, chunk, &written, &position) || written == 0) return false;
+            data += written;
+            offset += written;
+            size -= written;
+        }
+#else
+        while (size > 0) {
+            ssize_t written = pwrite(m_fd, data, size, static_cast<off_t>(offset));
+            if (written <= 0) return false;
+            data += written;
+            offset += static_cast<uint64_t>(written);
+            size -= static_cast<size_t>(written);
+        }
+#endif
+        return true;
+    }
+
+    bool Sync() {
+#ifdef _WIN32
+        return FlushFileBuffers(m_handle) != FALSE;
+#else
+        return fsync(m_fd) == 0;
+#endif
+    }
+
+    bool Truncate(uint64_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(size);
+        return SetFilePointerEx(m_handle, position, nullptr, FILE_BEGIN) && SetEndOfFile(m_handle);
+#else
+        return ftruncate(m_fd, static_cast<off_t>(size)) == 0;
+#endif
+    }
+
+    [[nodiscard]] uint64_t Size() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        return GetFileSizeEx(m_handle, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+        struct stat info;
+        return fstat(m_fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+    }
+
+private:
+    SegmentFile() = default;
+
+#ifdef _WIN32
+    HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+//------------------------------------------------------------------------------
+// NoteLog
+//------------------------------------------------------------------------------
+
+NoteLog::NoteLog() = default;
+
+NoteLog::~NoteLog() {
+    Close();
+}
+
+//------------------------------------------------------------------------------
+// Open: load the segment list, replay what the checkpoint does not cover,
+// then start the writer thread
+//------------------------------------------------------------------------------
+bool NoteLog::Open(const std::wstring& directory, const NoteLogCheckpoint& checkpoint,
+                   std::vector<NoteLogChange>& changes, std::wstring& errorMessage) {
+    QNOTE_TRACE_SCOPE("NoteLog::Open");
+    Close();
+    changes.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = directory;
+    if (!EnsureDirectory(directory)) {
+        errorMessage = L"Could not create " + directory;
+        return false;
+    }
+
+    try {
+        m_segments.clear();
+        m_table = checkpoint.table;
+        m_stats = NoteLogStats{};
+        m_nextSegment = std::max<uint32_t>(checkpoint.nextSegment, 1);
+        m_nextSequence = std::max<uint64_t>(checkpoint.nextSequence, 1);
+
+        for (uint32_t number : ListSegments(directory)) {
+            Segment segment;
+            segment.file = SegmentFile::Open(SegmentPath(number), false);
+            if (!segment.file) {
+                errorMessage = L"Could not open " + SegmentPath(number);
+                m_segments.clear();
+                return false;
+            }
+            segment.size = segment.file->Size();
+
+            uint8_t header[SEGMENT_HEADER_BYTES];
+            bool valid = segment.size >= SEGMENT_HEADER_BYTES &&
+                         segment.file->ReadAt(0, header, sizeof(header)) &&
+                         Load32(header) == SEGMENT_MAGIC && Load32(header + 4) == SEGMENT_VERSION &&
+                         Load32(header + 8) == number;
+            if (!valid && number >= checkpoint.nextSegment) {
+                // Created just before a crash; nothing in it was ever durable
+                segment.file.reset();
+                RemoveFile(SegmentPath(number));
+                continue;
+            }
+            segment.compacted = valid && (Load32(header + 12) & SEGMENT_FLAG_COMPACTED);
+            m_segments[number] = std::move(segment);
+            m_nextSegment = std::max(m_nextSegment, number + 1);
+        }
+
+        for (const auto& [key, ref] : m_table) {
+            auto it = m_segments.find(ref.segment);
+            if (it != m_segments.end()) it->second.liveBytes += ref.length;
+        }
+
+        // Records newer than the checkpoint: the tail of its active segment,
+        // then every segment created after it.  An active segment numbered
+        // past nextSegment (it was started during a compaction) is replayed
+        // whole, in order; its records up to 'offset' change nothing.
+        std::unordered_map<std::string, uint64_t> removedAt;
+        std::map<std::string, NoteLogChange> changed;
+        if (checkpoint.segment < checkpoint.nextSegment && m_segments.count(checkpoint.segment)) {
+            Replay(checkpoint.segment, std::max<uint64_t>(checkpoint.offset, SEGMENT_HEADER_BYTES),
+                   removedAt, changed);
+        }
+        for (const auto& entry : m_segments) {
+            if (entry.first >= checkpoint.nextSegment) {
+                Replay(entry.first, SEGMENT_HEADER_BYTES, removedAt, changed);
+            }
+        }
+        for (auto& entry : changed) {
+            changes.push_back(std::move(entry.second));
+        }
+
+        // Keep appending to the newest append segment if it was replayed
+        // (so its end is known to be clean) and still has room
+        m_active = 0;
+        for (auto it = m_segments.rbegin(); it != m_segments.rend(); ++it) {
+            if (it->second.compacted) continue;
+            bool replayed = it->first == checkpoint.segment || it->first >= checkpoint.nextSegment;
+            if (replayed && it->second.size < SEGMENT_TARGET_BYTES) m_active = it->first;
+            break;
+        }
+        if (m_active == 0) {
+            Segment segment;
+            if (!StartSegment(m_nextSegment, false, segment)) {
+                errorMessage = L"Could not create " + SegmentPath(m_nextSegment);
+                m_segments.clear();
+                return false;
+            }
+            m_active = m_nextSegment++;
+            m_segments[m_active] = std::move(segment);
+        }
+    } catch (const std::bad_alloc&) {
+        errorMessage = L"Out of memory while opening the note log";
+        m_segments.clear();
+        return false;
+    }
+
+    m_appendedBytes = 0;
+    m_durableBytes = 0;
+    m_syncRequested = false;
+    m_syncFailed = false;
+    m_stopping = false;
+    m_writer = std::thread(&NoteLog::WriterMain, this);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Flush and stop
+//------------------------------------------------------------------------------
+void NoteLog::Close() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_writer.joinable()) return;
+        m_stopping = true;
+    }
+    m_wakeWriter.notify_all();
+    m_writer.join();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_segments.clear();
+    m_table.clear();
+    m_active = 0;
+    m_durableChanged.notify_all();
+}
+
+bool NoteLog::IsOpen() const noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_active != 0;
+}
+
+//------------------------------------------------------------------------------
+// Appends
+//------------------------------------------------------------------------------
+bool NoteLog::Append(const std::string& key, std::string_view payload, uint64_t timestamp) {
+    return AppendRecord(KIND_PUT, key, payload, timestamp);
+}
+
+bool NoteLog::Remove(const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_table.find(key) == m_table.end()) return true;
+    }
+    return AppendRecord(KIND_REMOVE, key, std::string_view(), 0);
+}
+
+bool NoteLog::AppendRecord(uint8_t kind, const std::string& key, std::string_view payload, uint64_t timestamp) {
+    QNOTE_TRACE_SCOPE("NoteLog::Append");
+    if (key.empty() || key.size() > MAX_KEY_BYTES || payload.size() > MAX_PAYLOAD_BYTES) {
+        return false;
+    }
+
+    // Everything but the sequence can be prepared and checksummed unlocked
+    std::vector<uint8_t> record;
+    try {
+        record.resize(RECORD_HEADER_BYTES + key.size() + payload.size());
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    uint8_t* header = record.data();
+    Store32(header, RECORD_MAGIC);
+    Store64(header + 16, timestamp);
+    Store32(header + 24, static_cast<uint32_t>(key.size()));
+    Store32(header + 28, static_cast<uint32_t>(payload.size()));
+    header[32] = kind;
+    std::copy(key.begin(), key.end(), record.begin() + RECORD_HEADER_BYTES);
+    std::copy(payload.begin(), payload.end(), record.begin() + RECORD_HEADER_BYTES + key.size());
+    uint32_t crc = UpdateCrc(0, record.data() + 16, record.size() - 16);
+    const uint32_t length = static_cast<uint32_t>(record.size());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto active = m_segments.find(m_active);
+    if (active == m_segments.end()) return false;
+
+    // Seal a full segment.  Rare, so its fsync is done right here; it also
+    // makes every earlier append durable.
+    if (active->second.size >= SEGMENT_TARGET_BYTES) {
+        Segment next;
+        if (!active->second.file->Sync() || !StartSegment(m_nextSegment, false, next)) {
+            return false;
+        }
+        m_stats.syncs++;
+        m_durableBytes = m_appendedBytes;
+        m_durableChanged.notify_all();
+        m_active = m_nextSegment++;
+        active = m_segments.emplace(m_active, std::move(next)).first;
+    }
+
+    const uint64_t sequence = m_nextSequence;
+    Store64(header + 8, sequence);
+    crc = UpdateCrc(crc, header + 8, 8);
+    Store32(header + 4, crc);
+
+    Segment& segment = active->second;
+    if (!segment.file->WriteAt(segment.size, record.data(), record.size())) {
+        return false;
+    }
+    m_nextSequence++;
+
+    NoteLogRecordRef ref{ m_active, segment.size, length, sequence };
+    segment.size += length;
+    if (kind == KIND_PUT) {
+        SetLive(key, ref);
+    } else {
+        DropLive(key);
+    }
+
+    m_stats.appends++;
+    if (m_appendedBytes == m_durableBytes) {
+        m_groupStarted = std::chrono::steady_clock::now();
+    }
+    m_appendedBytes += length;
+    m_wakeWriter.notify_one();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Read the current revision of a key
+//------------------------------------------------------------------------------
+bool NoteLog::Read(const std::string& key, std::string& payload) const {
+    NoteLogRecordRef ref;
+    std::shared_ptr<SegmentFile> file;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_table.find(key);
+        if (it == m_table.end()) return false;
+        ref = it->second;
+        auto segment = m_segments.find(ref.segment);
+        if (segment == m_segments.end()) return false;
+        file = segment->second.file;
+    }
+
+    try {
+        std::vector<uint8_t> data(ref.length);
+        if (!file->ReadAt(ref.offset, data.data(), data.size())) return false;
+
+        RecordView record;
+        uint32_t length = 0;
+        if (!ParseRecord(data.data(), data.size(), record, length) || length != ref.length ||
+            record.kind != KIND_PUT || record.key != key) {
+            return false;
+        }
+        payload.assign(record.payload.data(), record.payload.size());
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Join the current group commit and wait for it
+//------------------------------------------------------------------------------
+bool NoteLog::Sync() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_active == 0) return false;
+
+    const uint64_t target = m_appendedBytes;
+    if (m_durableBytes >= target) return true;
+
+    const uint64_t attempts = m_syncAttempts;
+    m_syncRequested = true;
+    m_wakeWriter.notify_all();
+    m_durableChanged.wait(lock, [&]() {
+        return m_durableBytes >= target || m_active == 0 || (m_syncFailed && m_syncAttempts > attempts);
+    });
+    return m_durableBytes >= target;
+}
+
+bool NoteLog::Checkpoint(NoteLogCheckpoint& checkpoint) {
+    QNOTE_TRACE_SCOPE("NoteLog::Checkpoint");
+    for (;;) {
+        if (!Sync()) return false;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_durableBytes != m_appendedBytes) continue;    // Appended meanwhile
+
+        try {
+            checkpoint.segment = m_active;
+            checkpoint.offset = m_segments[m_active].size;
+            // A running compaction's output is not in 'table' yet, so it
+            // must still be replayed when the log is opened
+            checkpoint.nextSegment = m_compacting != 0 ? m_compacting : m_nextSegment;
+            checkpoint.nextSequence = m_nextSequence;
+            checkpoint.table = m_table;
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+        return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Delete dead segments the saved index no longer needs.  A segment is kept
+// while the saved table refers to it, even if the records have since been
+// moved by a compaction.  The checkpoint's own active segment is kept:
+// removal markers after its offset are still needed to replay correctly.
+//------------------------------------------------------------------------------
+void NoteLog::CheckpointSaved(const NoteLogCheckpoint& checkpoint) {
+    std::set<uint32_t> referenced;
+    try {
+        for (const auto& entry : checkpoint.table) {
+            referenced.insert(entry.second.segment);
+        }
+    } catch (const std::bad_alloc&) {
+        return;     // Keep everything until the next checkpoint
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_segments.begin(); it != m_segments.end();) {
+        uint32_t number = it->first;
+        if (number != m_active && number != checkpoint.segment &&
+            number < checkpoint.nextSegment && it->second.liveBytes == 0 &&
+            referenced.count(number) == 0) {
+            it = m_segments.erase(it);
+            RemoveFile(SegmentPath(number));
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool NoteLog::NeedsCheckpoint() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [number, segment] : m_segments) {
+        if (number != m_active && segment.liveBytes == 0) return true;
+    }
+    return false;
+}
+
+void NoteLog::SetSyncLatency(std::chrono::milliseconds latency) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_syncLatency = latency;
+}
+
+NoteLogStats NoteLog::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    NoteLogStats stats = m_stats;
+    stats.segments = m_segments.size();
+    stats.compacting = m_compacting != 0;
+    for (const auto& entry : m_segments) {
+        stats.totalBytes += entry.second.size;
+        stats.liveBytes += entry.second.liveBytes;
+    }
+    return stats;
+}
+
+bool NoteLog::Destroy(const std::wstring& directory) {
+    bool removed = true;
+    for (uint32_t number : ListSegments(directory)) {
+        wchar_t name[32];
+        std::swprintf(name, std::size(name), L"%08x%ls", number, SEGMENT_EXTENSION);
+        removed = RemoveFile(directory + PATH_SEPARATOR + name) && removed;
+    }
+    return removed;
+}
+
+//------------------------------------------------------------------------------
+// Helpers (m_mutex held unless noted)
+//------------------------------------------------------------------------------
+
+std::wstring NoteLog::SegmentPath(uint32_t number) const {
+    wchar_t name[32];
+    std::swprintf(name, std::size(name), L"%08x%ls", number, SEGMENT_EXTENSION);
+    return m_directory + PATH_SEPARATOR + name;
+}
+
+// Create a segment file holding only its header.  Needs no lock.
+bool NoteLog::StartSegment(uint32_t number, bool compacted, Segment& segment) {
+    segment.file = SegmentFile::Open(SegmentPath(number), true);
+    if (!segment.file) return false;
+
+    uint8_t header[SEGMENT_HEADER_BYTES];
+    Store32(header, SEGMENT_MAGIC);
+    Store32(header + 4, SEGMENT_VERSION);
+    Store32(header + 8, number);
+    Store32(header + 12, compacted ? SEGMENT_FLAG_COMPACTED : 0);
+    if (!segment.file->WriteAt(0, header, sizeof(header))) {
+        segment.file.reset();
+        RemoveFile(SegmentPath(number));
+        return false;
+    }
+    SyncDirectory(m_directory);
+
+    segment.size = SEGMENT_HEADER_BYTES;
+    segment.liveBytes = 0;
+    segment.compacted = compacted;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Apply a segment's records from 'from' onward.  A record that fails its
+// checksum ends the segment: it was torn by a crash, and the segment is
+// cut back so appends continue from a clean end.
+//
+// Records written by compaction are copies; they only move the revision
+// they were copied from and never bring back a removed key.
+//------------------------------------------------------------------------------
+void NoteLog::Replay(uint32_t number, uint64_t from, std::unordered_map<std::string, uint64_t>& removedAt,
+                     std::map<std::string, NoteLogChange>& changes) {
+    Segment& segment = m_segments[number];
+    if (from >= segment.size) return;
+
+    std::vector<uint8_t> data(static_cast<size_t>(segment.size - from));
+    if (!segment.file->ReadAt(from, data.data(), data.size())) return;
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        RecordView record;
+        uint32_t length = 0;
+        if (!ParseRecord(data.data() + pos, data.size() - pos, record, length)) break;
+
+        std::string key(record.key);
+        NoteLogRecordRef ref{ number, from + pos, length, record.sequence };
+        m_nextSequence = std::max(m_nextSequence, record.sequence + 1);
+
+        auto current = m_table.find(key);
+        if (segment.compacted) {
+            if (current != m_table.end() && current->second.sequence == record.sequence) {
+                SetLive(key, ref);
+            }
+        } else if (record.kind == KIND_PUT) {
+            auto removed = removedAt.find(key);
+            bool newer = (current == m_table.end() || record.sequence > current->second.sequence) &&
+                         (removed == removedAt.end() || record.sequence > removed->second);
+            if (newer) {
+                SetLive(key, ref);
+                changes[key] = NoteLogChange{ key, false, record.timestamp };
+            }
+        } else {
+            if (current != m_table.end() && record.sequence > current->second.sequence) {
+                DropLive(key);
+                changes[key] = NoteLogChange{ key, true, record.timestamp };
+            }
+            uint64_t& removedSequence = removedAt[key];
+            removedSequence = std::max(removedSequence, record.sequence);
+        }
+        pos += length;
+    }
+
+    if (pos < data.size() && segment.file->Truncate(from + pos)) {
+        segment.size = from + pos;
+    }
+}
+
+void NoteLog::SetLive(const std::string& key, const NoteLogRecordRef& ref) {
+    DropLive(key);
+    m_table[key] = ref;
+    auto segment = m_segments.find(ref.segment);
+    if (segment != m_segments.end()) segment->second.liveBytes += ref.length;
+}
+
+void NoteLog::DropLive(const std::string& key) {
+    auto it = m_table.find(key);
+    if (it == m_table.end()) return;
+    auto segment = m_segments.find(it->second.segment);
+    if (segment != m_segments.end()) segment->second.liveBytes -= it->second.length;
+    m_table.erase(it);
+}
+
+// Validate one record at the start of 'data'
+bool NoteLog::ParseRecord(const uint8_t* data, size_t available, RecordView& record, uint32_t& length) noexcept {
+    if (available < RECORD_HEADER_BYTES || Load32(data) != RECORD_MAGIC) return false;
+
+    uint32_t keyLength = Load32(data + 24);
+    uint32_t payloadLength = Load32(data + 28);
+    if (keyLength == 0 || keyLength > MAX_KEY_BYTES || payloadLength > MAX_PAYLOAD_BYTES) return false;
+
+    uint64_t total = RECORD_HEADER_BYTES + static_cast<uint64_t>(keyLength) + payloadLength;
+    if (total > available) return false;
+
+    uint8_t kind = data[32];
+    if (kind != KIND_PUT && kind != KIND_REMOVE) return false;
+
+    uint32_t crc = UpdateCrc(0, data + 16, static_cast<size_t>(total - 16));
+    crc = UpdateCrc(crc, data + 8, 8);
+    if (crc != Load32(data + 4)) return false;
+
+    const char* body = reinterpret_cast<const char*>(data + RECORD_HEADER_BYTES);
+    record.kind = kind;
+    record.sequence = Load64(data + 8);
+    record.timestamp = Load64(data + 16);
+    record.key = std::string_view(body, keyLength);
+    record.payload = std::string_view(body + keyLength, payloadLength);
+    length = static_cast<uint32_t>(total);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Writer thread: group commit, then compaction when it pays off
+//------------------------------------------------------------------------------
+void NoteLog::WriterMain() {
+    Trace::SetThreadName("Note log writer");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wakeWriter.wait(lock, [this]() {
+            bool pending = m_appendedBytes > m_durableBytes;
+            return m_stopping || (pending && (!m_syncFailed || m_syncRequested));
+        });
+
+        if (m_appendedBytes > m_durableBytes) {
+            // Let further appends join this group unless someone is waiting
+            if (!m_syncRequested && !m_stopping) {
+                m_wakeWriter.wait_until(lock, m_groupStarted + m_syncLatency,
+                                        [this]() { return m_syncRequested || m_stopping; });
+            }
+            SyncPending(lock);
+            if (m_stopping && m_syncFailed) break;
+            if (!m_stopping && !m_syncFailed) CompactIfWorthwhile(lock);
+            continue;
+        }
+        if (m_stopping) break;
+    }
+}
+
+// fsync the active segment outside the lock; appends carry on meanwhile
+void NoteLog::SyncPending(std::unique_lock<std::mutex>& lock) {
+    auto active = m_segments.find(m_active);
+    if (active == m_segments.end()) return;
+
+    std::shared_ptr<SegmentFile> file = active->second.file;
+    const uint64_t target = m_appendedBytes;
+    m_syncRequested = false;
+
+    lock.unlock();
+    bool synced;
+    {
+        QNOTE_TRACE_SCOPE("NoteLog::Sync");
+        synced = file->Sync();
+    }
+    lock.lock();
+
+    m_stats.syncs++;
+    m_syncAttempts++;
+    m_syncFailed = !synced;
+    if (synced) {
+        m_durableBytes = std::max(m_durableBytes, target);
+    }
+    m_durableChanged.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Copy the live records of sealed segments into one new segment once at
+// least half of their bytes (and COMPACT_MIN_DEAD_BYTES) are dead.  Runs
+// unlocked apart from short steps; Sync() requests are served in between.
+//------------------------------------------------------------------------------
+void NoteLog::CompactIfWorthwhile(std::unique_lock<std::mutex>& lock) {
+    uint64_t sealedBytes = 0;
+    uint64_t sealedLive = 0;
+    std::map<uint32_t, std::shared_ptr<SegmentFile>> victims;
+    for (const auto& [number, segment] : m_segments) {
+        if (number == m_active || segment.liveBytes == 0) continue;
+        victims[number] = segment.file;
+        sealedBytes += segment.size;
+        sealedLive += segment.liveBytes;
+    }
+    const uint64_t deadBytes = sealedBytes - sealedLive;
+    if (deadBytes < COMPACT_MIN_DEAD_BYTES || deadBytes < sealedLive) return;
+
+    struct Move {
+        std::string key;
+        NoteLogRecordRef from;
+        NoteLogRecordRef to;
+    };
+    std::vector<Move> moves;
+    try {
+        for (const auto& [key, ref] : m_table) {
+            if (victims.count(ref.segment)) moves.push_back(Move{ key, ref, {} });
+        }
+    } catch (const std::bad_alloc&) {
+        return;
+    }
+    std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) {
+        return a.from.segment != b.from.segment ? a.from.segment < b.from.segment : a.from.offset < b.from.offset;
+    });
+    const uint32_t number = m_nextSegment++;
+    m_compacting = number;
+
+    lock.unlock();
+    QNOTE_TRACE_SCOPE("NoteLog::Compact");
+
+    Segment output;
+    bool ok = StartSegment(number, true, output);
+    std::vector<uint8_t> data;
+    for (size_t i = 0; ok && i < moves.size(); i++) {
+        {
+            std::unique_lock<std::mutex> step(m_mutex);
+            if (m_stopping) {
+                ok = false;
+                break;
+            }
+            if (m_syncRequested && m_appendedBytes > m_durableBytes) {
+                SyncPending(step);
+            }
+        }
+
+        Move& move = moves[i];
+        RecordView record;
+        uint32_t length = 0;
+        try {
+            data.resize(move.from.length);
+        } catch (const std::bad_alloc&) {
+            ok = false;
+            break;
+        }
+        if (!victims[move.from.segment]->ReadAt(move.from.offset, data.data(), data.size()) ||
+            !ParseRecord(data.data(), data.size(), record, length) || record.key != move.key) {
+            continue;   // Unreadable: leave it where it is
+        }
+        if (!output.file->WriteAt(output.size, data.data(), data.size())) {
+            ok = false;
+            break;
+        }
+        move.to = NoteLogRecordRef{ number, output.size, length, move.from.sequence };
+        output.size += length;
+    }
+    ok = ok && output.file->Sync();
+
+    lock.lock();
+    m_compacting = 0;
+    if (!ok) {
+        if (output.file) {
+            output.file.reset();
+            RemoveFile(SegmentPath(number));
+        }
+        return;
+    }
+
+    // Switch every key that was not rewritten meanwhile
+    m_segments[number] = std::move(output);
+    for (const Move& move : moves) {
+        if (move.to.segment == 0) continue;
+        auto it = m_table.find(move.key);
+        if (it != m_table.end() && it->second.segment == move.from.segment &&
+            it->second.offset == move.from.offset) {
+            SetLive(move.key, move.to);
+        }
+    }
+    m_stats.compactions++;
+}
+
+} // namespace QNote
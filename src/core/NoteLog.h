@@ -0,0 +1,191 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteLog.h - Log-structured packed storage for note contents
+//==============================================================================
+
+#pragma once
+
+// Portable: file access uses Win32 on Windows and POSIX elsewhere.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Where the current revision of one key lives
+//------------------------------------------------------------------------------
+struct NoteLogRecordRef {
+    uint32_t segment = 0;
+    uint64_t offset = 0;
+    uint32_t length = 0;           // Whole record, header included
+    uint64_t sequence = 0;
+};
+
+using NoteLogTable = std::unordered_map<std::string, NoteLogRecordRef>;
+
+//------------------------------------------------------------------------------
+// State saved with the note index.  Every segment numbered below
+// nextSegment, apart from the active one, was complete and on disk when the
+// checkpoint was taken; the active segment was on disk up to 'offset'.
+// Opening the log replays only what was written after that.  A compaction
+// still running when the checkpoint is taken keeps nextSegment at its
+// output, so that output is replayed.
+//------------------------------------------------------------------------------
+struct NoteLogCheckpoint {
+    uint32_t segment = 0;          // Active segment
+    uint64_t offset = 0;           // Its durable length
+    uint32_t nextSegment = 1;
+    uint64_t nextSequence = 1;
+    NoteLogTable table;            // Every live key
+};
+
+// A key whose revision was recovered from records newer than the checkpoint
+struct NoteLogChange {
+    std::string key;
+    bool removed = false;
+    uint64_t timestamp = 0;        // time_t of the recovered revision
+};
+
+struct NoteLogStats {
+    size_t segments = 0;
+    uint64_t totalBytes = 0;
+    uint64_t liveBytes = 0;
+    uint64_t appends = 0;
+    uint64_t syncs = 0;            // fsyncs issued; several appends share one
+    uint64_t compactions = 0;
+    bool compacting = false;       // A compaction is copying records
+};
+
+//------------------------------------------------------------------------------
+// Append-only store of key -> payload revisions.  Records go to numbered
+// segment files, each with its own checksum, so a torn write at the end of
+// a segment is detected and cut off when the log is opened.
+//
+// Appends only reach the OS; a background thread makes them durable in
+// groups, at most SyncLatency after the first one of a group (group
+// commit).  Sync() and Checkpoint() wait for the current group.  When most
+// of the bytes in sealed segments are dead, the same thread copies the
+// live records into a fresh segment; the old ones are deleted once a
+// checkpoint that no longer needs them has been saved.
+//
+// All methods are safe to call from several threads.
+//------------------------------------------------------------------------------
+class NoteLog {
+public:
+    NoteLog();
+    ~NoteLog();
+
+    NoteLog(const NoteLog&) = delete;
+    NoteLog& operator=(const NoteLog&) = delete;
+
+    // Open the log in 'directory' (created if missing), starting from the
+    // checkpoint saved with the index.  Keys changed by newer records are
+    // reported in 'changes'.
+    [[nodiscard]] bool Open(const std::wstring& directory, const NoteLogCheckpoint& checkpoint,
+                            std::vector<NoteLogChange>& changes, std::wstring& errorMessage);
+
+    // Make everything durable and stop the background thread
+    void Close() noexcept;
+
+    [[nodiscard]] bool IsOpen() const noexcept;
+
+    // Add a revision, or a removal marker.  Durable after the next group commit.
+    [[nodiscard]] bool Append(const std::string& key, std::string_view payload, uint64_t timestamp);
+    [[nodiscard]] bool Remove(const std::string& key);
+
+    // Current payload of a key; false if missing or its checksum fails
+    [[nodiscard]] bool Read(const std::string& key, std::string& payload) const;
+
+    // Wait until everything appended so far is durable
+    [[nodiscard]] bool Sync();
+
+    // Sync and describe the log for saving with the index
+    [[nodiscard]] bool Checkpoint(NoteLogCheckpoint& checkpoint);
+
+    // The index holding 'checkpoint' is durable: delete segments it no
+    // longer refers to
+    void CheckpointSaved(const NoteLogCheckpoint& checkpoint);
+
+    // True when a new checkpoint would let dead segments be deleted
+    [[nodiscard]] bool NeedsCheckpoint() const;
+
+    void SetSyncLatency(std::chrono::milliseconds latency);
+    [[nodiscard]] NoteLogStats GetStats() const;
+
+    // Delete every segment file in 'directory'
+    static bool Destroy(const std::wstring& directory);
+
+    static constexpr uint64_t SEGMENT_TARGET_BYTES = 4ULL * 1024 * 1024;
+    static constexpr uint64_t COMPACT_MIN_DEAD_BYTES = 1ULL * 1024 * 1024;
+
+private:
+    class SegmentFile;
+
+    struct Segment {
+        std::shared_ptr<SegmentFile> file;
+        uint64_t size = 0;
+        uint64_t liveBytes = 0;
+        bool compacted = false;    // Written by compaction rather than by appends
+    };
+
+    // A record's fields once its checksum has been verified
+    struct RecordView {
+        uint8_t kind = 0;
+        uint64_t sequence = 0;
+        uint64_t timestamp = 0;
+        std::string_view key;
+        std::string_view payload;
+    };
+
+    [[nodiscard]] bool AppendRecord(uint8_t kind, const std::string& key, std::string_view payload,
+                                    uint64_t timestamp);
+    [[nodiscard]] bool StartSegment(uint32_t number, bool compacted, Segment& segment);
+    void Replay(uint32_t number, uint64_t from, std::unordered_map<std::string, uint64_t>& removedAt,
+                std::map<std::string, NoteLogChange>& changes);
+    void SetLive(const std::string& key, const NoteLogRecordRef& ref);
+    void DropLive(const std::string& key);
+    [[nodiscard]] std::wstring SegmentPath(uint32_t number) const;
+
+    void WriterMain();
+    void SyncPending(std::unique_lock<std::mutex>& lock);
+    void CompactIfWorthwhile(std::unique_lock<std::mutex>& lock);
+
+    [[nodiscard]] static bool ParseRecord(const uint8_t* data, size_t available, RecordView& record,
+                                          uint32_t& length) noexcept;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_durableChanged;
+    std::thread m_writer;
+
+    std::wstring m_directory;
+    std::map<uint32_t, Segment> m_segments;
+    NoteLogTable m_table;
+    uint32_t m_active = 0;
+    uint32_t m_nextSegment = 1;
+    uint64_t m_nextSequence = 1;
+    uint32_t m_compacting = 0;     // Output segment of a running compaction
+
+    // Group commit state, counted in bytes appended since Open()
+    uint64_t m_appendedBytes = 0;
+    uint64_t m_durableBytes = 0;
+    std::chrono::steady_clock::time_point m_groupStarted;
+    std::chrono::milliseconds m_syncLatency{ 25 };
+    uint64_t m_syncAttempts = 0;
+    bool m_syncRequested = false;
+    bool m_syncFailed = false;
+    bool m_stopping = false;
+
+    NoteLogStats m_stats;
+};
+
+} // namespace QNote
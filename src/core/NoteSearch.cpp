@@ -0,0 +1,243 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearch.cpp - Cancellable background search over the note store
+//==============================================================================
+
+#include "NoteSearch.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cwctype>
+#include <iterator>
+#include <new>
+#include <unordered_map>
+
+namespace QNote {
+
+namespace {
+
+void ToLowerInPlace(std::wstring& text) {
+    for (auto& ch : text) {
+        ch = static_cast<wchar_t>(std::towlower(ch));
+    }
+}
+
+} // anonymous namespace
+
+NoteSearch::NoteSearch(TaskScheduler& scheduler, ContentLoader loader, RankedSearch ranked,
+                       NotifyCallback notify)
+    : m_scheduler(scheduler), m_loader(std::move(loader)), m_ranked(std::move(ranked)),
+      m_notify(std::move(notify)), m_gate(std::make_shared<TaskGate>()) {
+}
+
+NoteSearch::~NoteSearch() {
+    Stop();
+}
+
+//------------------------------------------------------------------------------
+// Submit the search to the scheduler under a fresh token, cancelling the one
+// it replaces.  If the scheduler takes no more tasks the search runs here.
+//------------------------------------------------------------------------------
+uint64_t NoteSearch::Start(NoteSearchSources sources, const std::wstring& query) {
+    auto request = std::make_shared<Request>();
+    request->sources = std::move(sources);
+    request->query = query;
+    request->lowerQuery = query;
+    ToLowerInPlace(request->lowerQuery);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        request->generation = m_generation.fetch_add(1) + 1;
+        m_results.clear();
+        m_resultsGeneration = request->generation;
+        m_finished = false;
+    }
+
+    CancellationToken token = CancellationToken::Create();
+    {
+        std::lock_guard<std::mutex> lock(m_gate->mutex);
+        m_gate->token.Cancel();
+        m_gate->token = token;
+    }
+
+    // The task holds the gate, not this object, until it has checked its
+    // token: Stop() cancels it and waits for running searches under the gate
+    std::shared_ptr<TaskGate> gate = m_gate;
+    auto task = [this, gate, token, request]() {
+        {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            if (token.IsCancelled()) return;
+            gate->running++;
+        }
+        RunTask(*request);
+        {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            gate->running--;
+        }
+        gate->idle.notify_all();
+    };
+    if (!m_scheduler.Submit(task, TaskPriority::High, token)) {
+        RunTask(*request);
+    }
+    return request->generation;
+}
+
+void NoteSearch::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.fetch_add(1);
+        m_results.clear();
+        m_finished = false;
+    }
+    std::lock_guard<std::mutex> lock(m_gate->mutex);
+    m_gate->token.Cancel();
+}
+
+void NoteSearch::Stop() noexcept {
+    m_generation.fetch_add(1);
+
+    std::unique_lock<std::mutex> lock(m_gate->mutex);
+    m_gate->token.Cancel();
+    m_gate->idle.wait(lock, [this]() { return m_gate->running == 0; });
+}
+
+bool NoteSearch::TakeResults(uint64_t generation, std::vector<NoteSearchMatch>& matches,
+                             bool& finished) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_notifyPending = false;
+    matches.clear();
+    finished = false;
+
+    if (generation != m_generation.load() || generation != m_resultsGeneration) {
+        m_results.clear();
+        return false;
+    }
+    matches.swap(m_results);
+    finished = m_finished;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Run one search on a worker
+//------------------------------------------------------------------------------
+void NoteSearch::RunTask(const Request& request) {
+    try {
+        RunSearch(request);
+    } catch (const std::bad_alloc&) {
+        // Report what was found so far as the whole result
+        std::vector<NoteSearchMatch> none;
+        Publish(request.generation, none, true);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Ranked matches first, then every other source in order until done or
+// replaced
+//------------------------------------------------------------------------------
+void NoteSearch::RunSearch(const Request& request) {
+    QNOTE_TRACE_SCOPE("NoteSearch::RunSearch");
+
+    std::vector<NoteSearchMatch> batch;
+    std::wstring buffer;
+    bool published = false;
+    auto lastPublish = std::chrono::steady_clock::now();
+
+    const size_t count = request.sources ? request.sources->size() : 0;
+    std::vector<bool> listed;              // Sources the ranked search returned
+    std::vector<NoteRankedHit> hits;
+    if (m_ranked && count > 0 && !request.query.empty() &&
+        m_ranked(request.query, RANKED_LIMIT, hits) && !hits.empty()) {
+        std::unordered_map<std::wstring, size_t> positions;
+        positions.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            positions.emplace((*request.sources)[i].id, i);
+        }
+
+        listed.assign(count, false);
+        for (auto& hit : hits) {
+            auto it = positions.find(hit.id);
+            if (it == positions.end() || listed[it->second]) continue;
+            listed[it->second] = true;
+            batch.push_back({ it->second, std::move(hit.snippet) });
+        }
+        if (!IsCurrent(request.generation)) return;
+        if (!batch.empty()) {
+            Publish(request.generation, batch, false);
+            published = true;
+            lastPublish = std::chrono::steady_clock::now();
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!IsCurrent(request.generation)) return;
+        if (!listed.empty() && listed[i]) continue;
+
+        if (Matches((*request.sources)[i], request.lowerQuery, buffer)) {
+            batch.push_back({ i, std::wstring() });
+        }
+
+        // First match right away, then at most one batch per interval
+        if (!batch.empty()) {
+            auto now = std::chrono::steady_clock::now();
+            if (!published || now - lastPublish >= PUBLISH_INTERVAL) {
+                Publish(request.generation, batch, false);
+                published = true;
+                lastPublish = now;
+            }
+        }
+    }
+
+    if (IsCurrent(request.generation)) {
+        Publish(request.generation, batch, true);
+    }
+}
+
+// Same order of checks as NoteStore::FilterSlots: title and preview need no
+// disk access, and short notes are wholly in their preview
+bool NoteSearch::Matches(const NoteSearchSource& source, const std::wstring& lowerQuery,
+                         std::wstring& buffer) const {
+    if (lowerQuery.empty()) return true;
+
+    if (source.lowerTitle.find(lowerQuery) != std::wstring::npos ||
+        source.lowerPreview.find(lowerQuery) != std::wstring::npos) {
+        return true;
+    }
+    if (source.previewIsComplete || !m_loader) {
+        return false;
+    }
+
+    NoteContentPtr content = m_loader(source.id);
+    if (!content) return false;
+
+    // Reuse one buffer for the folded copy instead of allocating per note
+    buffer.assign(*content);
+    ToLowerInPlace(buffer);
+    return buffer.find(lowerQuery) != std::wstring::npos;
+}
+
+//------------------------------------------------------------------------------
+// Hand a batch to the UI; only the first batch after TakeResults() (and the
+// end of the search) notifies
+//------------------------------------------------------------------------------
+void NoteSearch::Publish(uint64_t generation, std::vector<NoteSearchMatch>& batch, bool finished) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (generation != m_resultsGeneration || !IsCurrent(generation)) {
+            batch.clear();
+            return;
+        }
+        m_results.insert(m_results.end(), std::make_move_iterator(batch.begin()),
+                         std::make_move_iterator(batch.end()));
+        if (finished) m_finished = true;
+        if (!m_notifyPending && (finished || !m_results.empty())) {
+            m_notifyPending = true;
+            notify = true;
+        }
+    }
+    batch.clear();
+    if (notify && m_notify) {
+        m_notify();
+    }
+}
+
+} // namespace QNote
@@ -0,0 +1,145 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearch.h - Cancellable background search over the note store
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include "NoteContentCache.h"
+#include "TaskScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// One note to search, snapshotted on the UI thread.  Title and preview are
+// lower-cased when the snapshot is taken, so a query typed one key at a
+// time does not fold them again for every key.
+//------------------------------------------------------------------------------
+struct NoteSearchSource {
+    std::wstring id;
+    std::wstring lowerTitle;
+    std::wstring lowerPreview;
+    bool previewIsComplete = false;        // The preview holds the whole note
+};
+
+using NoteSearchSources = std::shared_ptr<const std::vector<NoteSearchSource>>;
+
+//------------------------------------------------------------------------------
+// One note found by a ranked search
+//------------------------------------------------------------------------------
+struct NoteRankedHit {
+    std::wstring id;
+    double score = 0.0;
+    std::wstring snippet;                  // Text around the best match
+};
+
+//------------------------------------------------------------------------------
+// One match: the note's position in the source list and, for a ranked
+// match, the text around it
+//------------------------------------------------------------------------------
+struct NoteSearchMatch {
+    size_t index = 0;
+    std::wstring snippet;                  // Empty for a substring match
+};
+
+//------------------------------------------------------------------------------
+// Runs case-insensitive note searches as high-priority tasks on the
+// application's TaskScheduler, checking each note's title, then its preview,
+// then (if the preview is not the whole note) its content.  Every Start()
+// gets a new generation and cancellation token; the search it replaces
+// stops at the next note, or is dropped if it has not started.
+//
+// If the ranked search has its index ready, the notes it finds come first,
+// best first and with snippets; the scan then adds the notes it missed
+// (such as a word still being typed), in source order.  The first match is published at once and later ones every
+// PUBLISH_INTERVAL, so a long search shows results while it runs.  'notify'
+// is called on the worker when results are waiting and the previous
+// notification has been consumed, and once more when a search ends.
+//------------------------------------------------------------------------------
+class NoteSearch {
+public:
+    // Content of one note; called on a worker thread
+    using ContentLoader = std::function<NoteContentPtr(const std::wstring& id)>;
+    // Up to 'limit' notes, best first; called on a worker thread.  False
+    // while the index behind it is not ready.
+    using RankedSearch = std::function<bool(const std::wstring& query, size_t limit,
+                                            std::vector<NoteRankedHit>& hits)>;
+    using NotifyCallback = std::function<void()>;
+
+    NoteSearch(TaskScheduler& scheduler, ContentLoader loader, RankedSearch ranked,
+               NotifyCallback notify);
+    ~NoteSearch();
+
+    NoteSearch(const NoteSearch&) = delete;
+    NoteSearch& operator=(const NoteSearch&) = delete;
+
+    // Search 'sources' for 'query', replacing any running search; returns
+    // the new search's generation
+    uint64_t Start(NoteSearchSources sources, const std::wstring& query);
+
+    // Drop the running search, if any
+    void Cancel();
+
+    // Cancel, and wait for a search already running on a worker to return
+    void Stop() noexcept;
+
+    // Matches found by search 'generation' since the last call.  False if
+    // that search has been replaced; its results are then discarded.
+    [[nodiscard]] bool TakeResults(uint64_t generation, std::vector<NoteSearchMatch>& matches,
+                                   bool& finished);
+
+    static constexpr auto PUBLISH_INTERVAL = std::chrono::milliseconds(50);
+    static constexpr size_t RANKED_LIMIT = 500;    // Ranked matches asked for
+
+private:
+    struct Request {
+        NoteSearchSources sources;
+        std::wstring query;
+        std::wstring lowerQuery;
+        uint64_t generation = 0;
+    };
+
+    // Shared with queued tasks, which may outlive this object: a task runs
+    // the search only if its token is still live, checked under 'mutex'
+    struct TaskGate {
+        std::mutex mutex;
+        std::condition_variable idle;
+        CancellationToken token;           // The latest search's
+        size_t running = 0;                // Searches inside RunTask()
+    };
+
+    void RunTask(const Request& request);
+    void RunSearch(const Request& request);
+    [[nodiscard]] bool Matches(const NoteSearchSource& source, const std::wstring& lowerQuery,
+                               std::wstring& buffer) const;
+    void Publish(uint64_t generation, std::vector<NoteSearchMatch>& batch, bool finished);
+    [[nodiscard]] bool IsCurrent(uint64_t generation) const noexcept {
+        return m_generation.load(std::memory_order_relaxed) == generation;
+    }
+
+    TaskScheduler& m_scheduler;
+    ContentLoader m_loader;
+    RankedSearch m_ranked;
+    NotifyCallback m_notify;
+    std::atomic<uint64_t> m_generation{ 0 };
+    std::shared_ptr<TaskGate> m_gate;
+
+    // Guarded by m_mutex
+    mutable std::mutex m_mutex;
+    uint64_t m_resultsGeneration = 0;      // Search that m_results belong to
+    std::vector<NoteSearchMatch> m_results;
+    bool m_finished = false;
+    bool m_notifyPending = false;
+};
+
+} // namespace QNote
@@ -0,0 +1,392 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearchIndex.cpp - Positional inverted index with BM25 ranking for notes
+//==============================================================================
+
+#include "NoteSearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cwctype>
+#include <utility>
+
+namespace QNote {
+
+void NoteSearchIndex::Clear() {
+    m_docs.clear();
+    m_freeDocs.clear();
+    m_docIds.clear();
+    m_postings.clear();
+    m_totalTitleWords = 0;
+    m_totalBodyWords = 0;
+}
+
+//------------------------------------------------------------------------------
+// Indexing
+//------------------------------------------------------------------------------
+void NoteSearchIndex::SetDocument(const std::wstring& id, uint64_t tag, const std::wstring& title,
+                                  const std::wstring& content) {
+    RemoveDocument(id);
+
+    uint32_t doc;
+    if (!m_freeDocs.empty()) {
+        doc = m_freeDocs.back();
+        m_freeDocs.pop_back();
+    } else {
+        doc = static_cast<uint32_t>(m_docs.size());
+        m_docs.emplace_back();
+    }
+    Document& document = m_docs[doc];
+    document.id = id;
+    document.tag = tag;
+
+    std::vector<Word> titleWords;
+    std::vector<Word> bodyWords;
+    Tokenize(title, true, titleWords);
+    Tokenize(content, true, bodyWords);
+    document.titleWords = static_cast<uint32_t>(titleWords.size());
+    document.bodyWords = static_cast<uint32_t>(bodyWords.size());
+    document.bodyChars = static_cast<uint32_t>(content.size());
+
+    // Group the note's words by term, so each term's posting list is
+    // touched once
+    struct Occurrence {
+        const std::wstring* term;
+        uint32_t field;                        // 0 title, 1 body
+        uint32_t position;
+        uint32_t offset;
+    };
+    std::vector<Occurrence> occurrences;
+    occurrences.reserve(titleWords.size() + bodyWords.size());
+    for (size_t i = 0; i < titleWords.size(); ++i) {
+        occurrences.push_back({ &titleWords[i].term, 0, static_cast<uint32_t>(i), 0 });
+    }
+    for (size_t i = 0; i < bodyWords.size(); ++i) {
+        occurrences.push_back({ &bodyWords[i].term, 1, static_cast<uint32_t>(i), bodyWords[i].offset });
+    }
+    std::sort(occurrences.begin(), occurrences.end(), [](const Occurrence& a, const Occurrence& b) {
+        int order = a.term->compare(*b.term);
+        if (order != 0) return order < 0;
+        if (a.field != b.field) return a.field < b.field;
+        return a.position < b.position;
+    });
+
+    for (size_t first = 0; first < occurrences.size();) {
+        size_t last = first;
+        Posting posting;
+        posting.doc = doc;
+        while (last < occurrences.size() && *occurrences[last].term == *occurrences[first].term) {
+            (occurrences[last].field == 0 ? posting.titleCount : posting.bodyCount)++;
+            ++last;
+        }
+        posting.data.reserve(posting.titleCount + 2 * static_cast<size_t>(posting.bodyCount));
+        for (size_t i = first; i < last; ++i) {
+            posting.data.push_back(occurrences[i].position);
+        }
+        for (size_t i = first + posting.titleCount; i < last; ++i) {
+            posting.data.push_back(occurrences[i].offset);
+        }
+
+        const std::wstring& term = *occurrences[first].term;
+        PostingList& list = m_postings[term];
+        if (list.empty() || list.back().doc < doc) {
+            list.push_back(std::move(posting));
+        } else {
+            auto at = std::lower_bound(list.begin(), list.end(), doc,
+                [](const Posting& p, uint32_t d) { return p.doc < d; });
+            list.insert(at, std::move(posting));
+        }
+        document.terms.push_back(term);
+        first = last;
+    }
+
+    m_totalTitleWords += document.titleWords;
+    m_totalBodyWords += document.bodyWords;
+    m_docIds[id] = doc;
+}
+
+void NoteSearchIndex::RemoveDocument(const std::wstring& id) {
+    auto it = m_docIds.find(id);
+    if (it == m_docIds.end()) return;
+
+    uint32_t doc = it->second;
+    Document& document = m_docs[doc];
+    for (const auto& term : document.terms) {
+        auto list = m_postings.find(term);
+        if (list == m_postings.end()) continue;
+
+        auto at = std::lower_bound(list->second.begin(), list->second.end(), doc,
+            [](const Posting& p, uint32_t d) { return p.doc < d; });
+        if (at != list->second.end() && at->doc == doc) {
+            list->second.erase(at);
+        }
+        if (list->second.empty()) {
+            m_postings.erase(list);
+        }
+    }
+
+    m_totalTitleWords -= document.titleWords;
+    m_totalBodyWords -= document.bodyWords;
+    document = Document();
+    m_freeDocs.push_back(doc);
+    m_docIds.erase(it);
+}
+
+//------------------------------------------------------------------------------
+// Ranking.  Candidates come from the rarest term's postings; every other
+// term is a binary search per candidate.  The heap holds at most 'limit'
+// notes, worst on top.
+//------------------------------------------------------------------------------
+std::vector<NoteSearchHit> NoteSearchIndex::Search(const std::wstring& query, size_t limit) const {
+    std::vector<NoteSearchHit> hits;
+    Query parsed = ParseQuery(query);
+    if (parsed.terms.empty() || limit == 0 || m_docIds.empty()) return hits;
+
+    const size_t termCount = parsed.terms.size();
+    std::vector<const PostingList*> lists(termCount);
+    size_t driver = 0;
+    for (size_t i = 0; i < termCount; ++i) {
+        auto it = m_postings.find(parsed.terms[i]);
+        if (it == m_postings.end()) return hits;
+        lists[i] = &it->second;
+        if (lists[i]->size() < lists[driver]->size()) {
+            driver = i;
+        }
+    }
+
+    const double docCount = static_cast<double>(m_docIds.size());
+    const double avgTitle = std::max(1.0, static_cast<double>(m_totalTitleWords) / docCount);
+    const double avgBody = std::max(1.0, static_cast<double>(m_totalBodyWords) / docCount);
+    std::vector<double> idf(termCount);
+    for (size_t i = 0; i < termCount; ++i) {
+        double df = static_cast<double>(lists[i]->size());
+        idf[i] = std::log(1.0 + (docCount - df + 0.5) / (df + 0.5));
+    }
+
+    // Phrase words as term numbers
+    std::vector<std::vector<size_t>> phraseTerms;
+    for (const auto& phrase : parsed.phrases) {
+        std::vector<size_t> indices;
+        for (const auto& word : phrase) {
+            indices.push_back(static_cast<size_t>(
+                std::find(parsed.terms.begin(), parsed.terms.end(), word) - parsed.terms.begin()));
+        }
+        phraseTerms.push_back(std::move(indices));
+    }
+
+    using Ranked = std::pair<double, uint32_t>;
+    auto ranksAbove = [this](const Ranked& a, const Ranked& b) {
+        if (a.first != b.first) return a.first > b.first;
+        return m_docs[a.second].id < m_docs[b.second].id;
+    };
+    std::vector<Ranked> heap;
+    heap.reserve(std::min(limit, lists[driver]->size()));
+
+    std::vector<const Posting*> postings(termCount);
+    std::vector<const Posting*> phrasePostings;
+    for (const Posting& driverPosting : *lists[driver]) {
+        const uint32_t doc = driverPosting.doc;
+        bool found = true;
+        for (size_t i = 0; i < termCount && found; ++i) {
+            postings[i] = (i == driver) ? &driverPosting : FindPosting(*lists[i], doc);
+            found = (postings[i] != nullptr);
+        }
+        for (size_t p = 0; p < phraseTerms.size() && found; ++p) {
+            phrasePostings.clear();
+            for (size_t index : phraseTerms[p]) {
+                phrasePostings.push_back(postings[index]);
+            }
+            found = HasPhrase(phrasePostings);
+        }
+        if (!found) continue;
+
+        // BM25 with the title's term frequency weighted and both fields
+        // normalized by their own average length
+        const Document& document = m_docs[doc];
+        const double titleNorm = 1.0 - B + B * document.titleWords / avgTitle;
+        const double bodyNorm = 1.0 - B + B * document.bodyWords / avgBody;
+        double score = 0.0;
+        for (size_t i = 0; i < termCount; ++i) {
+            double tf = TITLE_BOOST * postings[i]->titleCount / titleNorm +
+                        postings[i]->bodyCount / bodyNorm;
+            score += idf[i] * tf * (K1 + 1.0) / (tf + K1);
+        }
+
+        Ranked ranked(score, doc);
+        if (heap.size() < limit) {
+            heap.push_back(ranked);
+            std::push_heap(heap.begin(), heap.end(), ranksAbove);
+        } else if (ranksAbove(ranked, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), ranksAbove);
+            heap.back() = ranked;
+            std::push_heap(heap.begin(), heap.end(), ranksAbove);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), ranksAbove);
+
+    // Snippets only for the notes returned
+    hits.reserve(heap.size());
+    for (const auto& [score, doc] : heap) {
+        const Document& document = m_docs[doc];
+        for (size_t i = 0; i < termCount; ++i) {
+            postings[i] = FindPosting(*lists[i], doc);
+        }
+
+        NoteSearchHit hit;
+        hit.id = document.id;
+        hit.tag = document.tag;
+        hit.score = score;
+        PlaceSnippet(document, parsed.terms, postings, hit);
+        hits.push_back(std::move(hit));
+    }
+    return hits;
+}
+
+const NoteSearchIndex::Posting* NoteSearchIndex::FindPosting(const PostingList& list, uint32_t doc) {
+    auto it = std::lower_bound(list.begin(), list.end(), doc,
+        [](const Posting& p, uint32_t d) { return p.doc < d; });
+    return (it != list.end() && it->doc == doc) ? &*it : nullptr;
+}
+
+// True if the words occur in order, next to each other, in the title or
+// the body
+bool NoteSearchIndex::HasPhrase(const std::vector<const Posting*>& postings) {
+    if (postings.empty()) return true;
+
+    auto findIn = [&postings](bool title) {
+        auto range = [title](const Posting* p) {
+            const uint32_t* first = title ? p->TitlePositions() : p->BodyPositions();
+            return std::make_pair(first, first + (title ? p->titleCount : p->bodyCount));
+        };
+        auto [start, end] = range(postings[0]);
+        for (; start != end; ++start) {
+            bool all = true;
+            for (size_t k = 1; k < postings.size() && all; ++k) {
+                auto [first, last] = range(postings[k]);
+                all = std::binary_search(first, last, *start + static_cast<uint32_t>(k));
+            }
+            if (all) return true;
+        }
+        return false;
+    };
+    return findIn(true) || findIn(false);
+}
+
+//------------------------------------------------------------------------------
+// Centre the snippet on the SNIPPET_WINDOW characters of the body that
+// hold the most query words
+//------------------------------------------------------------------------------
+void NoteSearchIndex::PlaceSnippet(const Document& doc, const std::vector<std::wstring>& terms,
+                                   const std::vector<const Posting*>& postings, NoteSearchHit& hit) {
+    std::vector<std::pair<uint32_t, uint32_t>> matches;    // Offset, length
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const uint32_t* offsets = postings[i]->BodyOffsets();
+        for (uint32_t k = 0; k < postings[i]->bodyCount; ++k) {
+            matches.emplace_back(offsets[k], static_cast<uint32_t>(terms[i].size()));
+        }
+    }
+    if (matches.empty()) {
+        hit.bodyMatch = false;
+        hit.snippetStart = 0;
+        hit.snippetLength = std::min<size_t>(doc.bodyChars, SNIPPET_WINDOW);
+        return;
+    }
+    std::sort(matches.begin(), matches.end());
+
+    size_t best = 0;
+    size_t bestCount = 0;
+    for (size_t first = 0, last = 0; first < matches.size(); ++first) {
+        while (last < matches.size() && matches[last].first < matches[first].first + SNIPPET_WINDOW) {
+            ++last;
+        }
+        if (last - first > bestCount) {
+            bestCount = last - first;
+            best = first;
+        }
+    }
+    const auto& lastMatch = matches[best + bestCount - 1];
+
+    hit.bodyMatch = true;
+    hit.matchStart = matches[best].first;
+    hit.matchLength = matches[best].second;
+    hit.snippetStart = (hit.matchStart > SNIPPET_BEFORE) ? hit.matchStart - SNIPPET_BEFORE : 0;
+    size_t end = std::min<size_t>(static_cast<size_t>(lastMatch.first) + lastMatch.second + SNIPPET_AFTER,
+                                  doc.bodyChars);
+    hit.snippetLength = end - hit.snippetStart;
+}
+
+//------------------------------------------------------------------------------
+// Words and phrases
+//------------------------------------------------------------------------------
+void NoteSearchIndex::Tokenize(const std::wstring& text, bool fold, std::vector<Word>& words) {
+    size_t i = 0;
+    while (i < text.size()) {
+        if (!std::iswalnum(text[i])) {
+            ++i;
+            continue;
+        }
+        size_t start = i;
+        while (i < text.size() && std::iswalnum(text[i])) {
+            ++i;
+        }
+
+        Word word;
+        word.term = text.substr(start, i - start);
+        word.offset = static_cast<uint32_t>(start);
+        if (fold) {
+            for (auto& ch : word.term) {
+                ch = static_cast<wchar_t>(std::towlower(ch));
+            }
+        }
+        words.push_back(std::move(word));
+    }
+}
+
+NoteSearchIndex::Query NoteSearchIndex::ParseQuery(const std::wstring& query) {
+    Query parsed;
+    auto addTerm = [&parsed](const std::wstring& term) {
+        if (std::find(parsed.terms.begin(), parsed.terms.end(), term) == parsed.terms.end()) {
+            parsed.terms.push_back(term);
+        }
+    };
+
+    // Text between double quotes is a phrase; an unclosed quote runs to the end
+    std::vector<Word> words;
+    bool inPhrase = false;
+    size_t start = 0;
+    while (start <= query.size()) {
+        size_t quote = query.find(L'"', start);
+        size_t end = (quote == std::wstring::npos) ? query.size() : quote;
+
+        words.clear();
+        Tokenize(query.substr(start, end - start), true, words);
+        for (const auto& word : words) {
+            addTerm(word.term);
+        }
+        if (inPhrase && words.size() > 1) {
+            std::vector<std::wstring> phrase;
+            for (auto& word : words) {
+                phrase.push_back(std::move(word.term));
+            }
+            parsed.phrases.push_back(std::move(phrase));
+        }
+
+        if (quote == std::wstring::npos) break;
+        inPhrase = !inPhrase;
+        start = quote + 1;
+    }
+    return parsed;
+}
+
+std::vector<std::wstring> NoteSearchIndex::GetQueryWords(const std::wstring& query) {
+    std::vector<Word> words;
+    Tokenize(query, false, words);
+
+    std::vector<std::wstring> result;
+    result.reserve(words.size());
+    for (auto& word : words) {
+        result.push_back(std::move(word.term));
+    }
+    return result;
+}
+
+} // namespace QNote
@@ -0,0 +1,122 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearchIndex.h - Positional inverted index with BM25 ranking for notes
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// One ranked note.  Offsets are in the note's content as it was indexed;
+// with no body match the snippet is the start of the content.
+//------------------------------------------------------------------------------
+struct NoteSearchHit {
+    std::wstring id;
+    uint64_t tag = 0;              // Caller's value given to SetDocument()
+    double score = 0.0;
+    bool bodyMatch = false;        // False when only the title matched
+    size_t matchStart = 0;         // First query word in the best snippet window
+    size_t matchLength = 0;
+    size_t snippetStart = 0;
+    size_t snippetLength = 0;
+};
+
+//------------------------------------------------------------------------------
+// Word index over note titles and contents.  Words are runs of letters and
+// digits, case-folded.  Each posting keeps the word's positions (for
+// phrases) and, in the body, its character offsets (for snippets), so
+// ranking and placing a snippet never read the notes.
+//
+// A query is words and "quoted phrases"; a note must contain all of them.
+// Notes are scored with BM25 over title and body, the title weighted
+// TITLE_BOOST times, and the best 'limit' are kept in a bounded heap.
+//
+// Not thread-safe; the note store guards it with a mutex.
+//------------------------------------------------------------------------------
+class NoteSearchIndex {
+public:
+    void Clear();
+
+    // Add or replace a note
+    void SetDocument(const std::wstring& id, uint64_t tag, const std::wstring& title,
+                     const std::wstring& content);
+    void RemoveDocument(const std::wstring& id);
+
+    [[nodiscard]] size_t GetDocumentCount() const noexcept { return m_docIds.size(); }
+    [[nodiscard]] size_t GetTermCount() const noexcept { return m_postings.size(); }
+
+    // Best matches, highest score first
+    [[nodiscard]] std::vector<NoteSearchHit> Search(const std::wstring& query, size_t limit) const;
+
+    // The query's words as typed (quotes dropped, case kept)
+    [[nodiscard]] static std::vector<std::wstring> GetQueryWords(const std::wstring& query);
+
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+    static constexpr double TITLE_BOOST = 3.0;
+
+    // Snippet: characters kept before the first match and after the last
+    // match inside the window
+    static constexpr size_t SNIPPET_BEFORE = 30;
+    static constexpr size_t SNIPPET_AFTER = 50;
+    static constexpr size_t SNIPPET_WINDOW = 80;
+
+private:
+    // One term in one note.  'data' holds the title positions, then the
+    // body positions, then the body offsets (parallel to the positions).
+    struct Posting {
+        uint32_t doc = 0;
+        uint32_t titleCount = 0;
+        uint32_t bodyCount = 0;
+        std::vector<uint32_t> data;
+
+        [[nodiscard]] const uint32_t* TitlePositions() const noexcept { return data.data(); }
+        [[nodiscard]] const uint32_t* BodyPositions() const noexcept { return data.data() + titleCount; }
+        [[nodiscard]] const uint32_t* BodyOffsets() const noexcept { return BodyPositions() + bodyCount; }
+    };
+    using PostingList = std::vector<Posting>;  // Sorted by document number
+
+    struct Document {
+        std::wstring id;
+        uint64_t tag = 0;
+        uint32_t titleWords = 0;
+        uint32_t bodyWords = 0;
+        uint32_t bodyChars = 0;
+        std::vector<std::wstring> terms;       // Distinct terms, for removal
+    };
+
+    struct Word {
+        std::wstring term;
+        uint32_t offset = 0;
+    };
+
+    struct Query {
+        std::vector<std::wstring> terms;       // Every distinct term, phrases included
+        std::vector<std::vector<std::wstring>> phrases;
+    };
+
+    static void Tokenize(const std::wstring& text, bool fold, std::vector<Word>& words);
+    [[nodiscard]] static Query ParseQuery(const std::wstring& query);
+
+    [[nodiscard]] static const Posting* FindPosting(const PostingList& list, uint32_t doc);
+    [[nodiscard]] static bool HasPhrase(const std::vector<const Posting*>& postings);
+    static void PlaceSnippet(const Document& doc, const std::vector<std::wstring>& terms,
+                             const std::vector<const Posting*>& postings, NoteSearchHit& hit);
+
+    std::vector<Document> m_docs;              // By document number; free ones have no id
+    std::vector<uint32_t> m_freeDocs;
+    std::unordered_map<std::wstring, uint32_t> m_docIds;
+    std::unordered_map<std::wstring, PostingList> m_postings;
+    uint64_t m_totalTitleWords = 0;
+    uint64_t m_totalBodyWords = 0;
+};
+
+} // namespace QNote
@@ -0,0 +1,61 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSortIndex.cpp - Maintained update-time and title orders over note slots
+//==============================================================================
+
+#include "NoteSortIndex.h"
+#include <cwctype>
+
+namespace QNote {
+
+void NoteSortIndex::Clear() {
+    m_byUpdated.clear();
+    m_byTitle.clear();
+}
+
+void NoteSortIndex::Insert(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id,
+                           size_t slot) {
+    m_byUpdated[std::make_pair(updatedAt, id)] = slot;
+    m_byTitle[std::make_pair(titleKey, id)] = slot;
+}
+
+void NoteSortIndex::Erase(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id) {
+    m_byUpdated.erase(std::make_pair(updatedAt, id));
+    m_byTitle.erase(std::make_pair(titleKey, id));
+}
+
+void NoteSortIndex::Move(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id,
+                         size_t slot) {
+    auto updated = m_byUpdated.find(std::make_pair(updatedAt, id));
+    if (updated != m_byUpdated.end()) {
+        updated->second = slot;
+    }
+    auto title = m_byTitle.find(std::make_pair(titleKey, id));
+    if (title != m_byTitle.end()) {
+        title->second = slot;
+    }
+}
+
+void NoteSortIndex::ByUpdated(std::vector<size_t>& slots) const {
+    slots.reserve(slots.size() + m_byUpdated.size());
+    for (const auto& entry : m_byUpdated) {
+        slots.push_back(entry.second);
+    }
+}
+
+void NoteSortIndex::ByTitle(std::vector<size_t>& slots) const {
+    slots.reserve(slots.size() + m_byTitle.size());
+    for (const auto& entry : m_byTitle) {
+        slots.push_back(entry.second);
+    }
+}
+
+std::wstring NoteSortIndex::MakeTitleKey(const std::wstring& displayTitle) {
+    std::wstring key = displayTitle;
+    for (auto& ch : key) {
+        ch = static_cast<wchar_t>(std::towlower(ch));
+    }
+    return key;
+}
+
+} // namespace QNote
@@ -0,0 +1,49 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSortIndex.h - Maintained update-time and title orders over note slots
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// The note store's summaries ordered by last update and by title, each
+// entry pointing at the summary's slot.  Kept up to date as notes change,
+// so listing them in either order needs no sort.  Creation order lives in
+// NoteTimeline.
+//
+// An entry is found again by the values it was inserted with, so Erase()
+// must be given the summary's fields from before they changed.  Not
+// thread-safe; the note store uses it on one thread.
+//------------------------------------------------------------------------------
+class NoteSortIndex {
+public:
+    void Clear();
+
+    // 'titleKey' comes from MakeTitleKey()
+    void Insert(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id, size_t slot);
+    void Erase(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id);
+    void Move(time_t updatedAt, const std::wstring& titleKey, const std::wstring& id, size_t slot);
+
+    // All slots, least recently updated / alphabetically first
+    void ByUpdated(std::vector<size_t>& slots) const;
+    void ByTitle(std::vector<size_t>& slots) const;
+
+    // Case-folded display title
+    [[nodiscard]] static std::wstring MakeTitleKey(const std::wstring& displayTitle);
+
+private:
+    std::map<std::pair<time_t, std::wstring>, size_t> m_byUpdated;        // (updatedAt, id)
+    std::map<std::pair<std::wstring, std::wstring>, size_t> m_byTitle;    // (title key, id)
+};
+
+} // namespace QNote
@@ -5,14 +5,63 @@
 
 #include "NoteStore.h"
 #include "FileIO.h"
+#include "Trace.h"
 #include <ShlObj.h>
 #include <algorithm>
+#include <cwchar>
 #include <sstream>
 #include <iomanip>
+#include <limits>
+#include <new>
 #include <unordered_set>
 
 namespace QNote {
 
+namespace {
+
+// UTF-8 conversions for note ids and contents stored in the packed log
+std::string ToUtf8(const std::wstring& text) {
+    if (text.empty()) return std::string();
+    int length = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                     nullptr, 0, nullptr, nullptr);
+    std::string utf8(length > 0 ? length : 0, '\0');
+    if (length > 0) {
+        WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                            &utf8[0], length, nullptr, nullptr);
+    }
+    return utf8;
+}
+
+size_t Utf8Length(const std::wstring& text) {
+    if (text.empty()) return 0;
+    int length = WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                                     nullptr, 0, nullptr, nullptr);
+    return length > 0 ? static_cast<size_t>(length) : 0;
+}
+
+std::wstring FromUtf8(const std::string& utf8) {
+    if (utf8.empty()) return std::wstring();
+    int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+    std::wstring text(length > 0 ? length : 0, L'\0');
+    if (length > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), &text[0], length);
+    }
+    return text;
+}
+
+// Text of [start, start + length), clamped; "..." marks text cut off on
+// either side
+std::wstring MakeSnippet(const std::wstring& text, size_t start, size_t length, bool more) {
+    start = std::min(start, text.length());
+    size_t end = std::min(start + length, text.length());
+    std::wstring snippet = (start > 0) ? L"..." : L"";
+    snippet += text.substr(start, end - start);
+    if (end < text.length() || more) snippet += L"...";
+    return snippet;
+}
+
+} // anonymous namespace
+
 //------------------------------------------------------------------------------
 // NoteSummary methods
 //------------------------------------------------------------------------------
@@ -36,7 +85,11 @@ std::wstring NoteSummary::GetUpdatedDateString() const {
 // NoteStore methods
 //------------------------------------------------------------------------------
 
-NoteStore::NoteStore() {
+NoteStore::NoteStore()
+    : m_searchGate(std::make_shared<SearchIndexGate>()),
+      m_writeQueue([this](const std::wstring& id, const NoteContentPtr& content, uint64_t& bytesWritten) {
+          return WriteQueuedContent(id, content, bytesWritten);
+      }) {
     // Get AppData path for note storage
     wchar_t appDataPath[MAX_PATH] = {};
     if (SUCCEEDED(SHGetFolderPathW(nullptr, CSIDL_APPDATA, nullptr, 0, appDataPath))) {
@@ -45,14 +98,21 @@ NoteStore::NoteStore() {
         m_notesDir = m_storeDir + L"\\notes";
         m_storePath = m_storeDir + L"\\notes_index.json";
         m_legacyStorePath = m_storeDir + L"\\notes.json";
+        m_logDir = m_storeDir + L"\\notelog";
     }
 }
 
 NoteStore::~NoteStore() {
-    // Auto-save on destruction if dirty
-    if (m_dirty) {
-        (void)Save();
-    }
+    Shutdown();
+}
+
+//------------------------------------------------------------------------------
+// Queue the index if dirty, then write everything still queued
+//------------------------------------------------------------------------------
+void NoteStore::Shutdown() {
+    StopSearchIndex();
+    (void)Save();
+    m_writeQueue.Stop();
 }
 
 bool NoteStore::Initialize() {
@@ -81,6 +141,22 @@ bool NoteStore::Initialize() {
         if (!LoadFromFile()) {
             return false;
         }
+        
+        // Open the content storage the index was written with, then convert
+        // it if the requested layout differs.  A failed conversion keeps the
+        // current layout.
+        if (m_indexIsPacked) {
+            if (!OpenNoteLog(m_indexCheckpoint)) {
+                return false;
+            }
+            if (!m_packedStorage) {
+                (void)ConvertContentStorage(false);
+            }
+        } else if (m_packedStorage) {
+            (void)ConvertContentStorage(true);
+        }
+        m_indexCheckpoint = NoteLogCheckpoint();
+        
         // Backfill content previews for notes saved before preview support
         bool needsSave = false;
         for (auto& summary : m_notes) {
@@ -88,23 +164,36 @@ bool NoteStore::Initialize() {
                 std::wstring content = LoadNoteContentFromDisk(summary.id);
                 if (!content.empty()) {
                     summary.contentPreview = MakeContentPreview(content);
+                    summary.contentHash = HashContent(content);
                     needsSave = true;
                 }
             }
         }
         if (needsSave) {
             m_dirty = true;
-            (void)Save();
         }
+        (void)Save();
+        m_writeQueue.Start();
         return true;
     }
     
+    // Without an index any log left behind is stale
+    if (m_packedStorage) {
+        NoteLog::Destroy(m_logDir);
+        if (!OpenNoteLog(NoteLogCheckpoint())) {
+            return false;
+        }
+    }
+    
     // Check for legacy format and migrate
     if (GetFileAttributesW(m_legacyStorePath.c_str()) != INVALID_FILE_ATTRIBUTES) {
-        return MigrateFromLegacyFormat();
+        if (!MigrateFromLegacyFormat()) {
+            return false;
+        }
     }
     
     // No notes file yet, start fresh
+    m_writeQueue.Start();
     return true;
 }
 
@@ -134,17 +223,18 @@ Note NoteStore::CreateNote(const std::wstring& content) {
     }
     
     // Save content to individual file
-    (void)SaveNoteContent(note.id, content);
+    SaveNoteContent(note.id, content);
     
     // Add only metadata to in-memory index
     NoteSummary summary;
     summary.id = note.id;
     summary.title = note.title;
     summary.contentPreview = MakeContentPreview(content);
+    summary.contentHash = HashContent(content);
     summary.createdAt = note.createdAt;
     summary.updatedAt = note.updatedAt;
     summary.isPinned = note.isPinned;
-    m_notes.push_back(summary);
+    AddSummary(std::move(summary));
     
     m_dirty = true;
     (void)Save();  // Autosave index
@@ -161,7 +251,7 @@ std::optional<Note> NoteStore::GetNote(const std::wstring& id) const {
         // Copy metadata from summary
         static_cast<NoteSummary&>(note) = *it;
         // Load content from individual file
-        note.content = LoadNoteContent(id);
+        note.content = *LoadNoteContent(id);
         return note;
     }
     return std::nullopt;
@@ -182,6 +272,34 @@ bool NoteStore::UpdateNote(const Note& note) {
         [&note](const NoteSummary& n) { return n.id == note.id; });
     
     if (it != m_notes.end()) {
+        // Compare with the current content by digest.  Notes saved before
+        // digests were kept get one from the cache, if it holds them.
+        uint64_t newHash = HashContent(note.content);
+        NoteContentPtr previous = m_contentCache.Find(note.id, CacheAccess::Scan);
+        if (it->contentHash == 0 && previous) {
+            it->contentHash = HashContent(*previous);
+        }
+        bool contentChanged = (it->contentHash != newHash);
+        
+        if (!contentChanged) {
+            // Only the index can have changed: an explicit title or the pin
+            bool titleChanged = !note.title.empty() && note.title != it->title;
+            if (titleChanged || it->isPinned != note.isPinned) {
+                if (titleChanged) {
+                    DetachSortKeys(*it);
+                    it->title = note.title;
+                    AttachSortKeys(*it);
+                    MarkSearchStale(*it);
+                }
+                it->isPinned = note.isPinned;
+                m_dirty = true;
+                (void)Save();  // Autosave index
+            } else {
+                m_writeQueue.RecordUnchanged();
+            }
+            return true;
+        }
+        
         // Update title from content if not explicitly set
         std::wstring newTitle = note.title;
         if (newTitle.empty() && !note.content.empty()) {
@@ -200,12 +318,14 @@ bool NoteStore::UpdateNote(const Note& note) {
             }
         }
         
+        DetachSortKeys(*it);
         it->title = newTitle;
         it->updatedAt = std::time(nullptr);
         it->isPinned = note.isPinned;
+        AttachSortKeys(*it);
         
         // Save content to individual file
-        (void)SaveNoteContent(note.id, note.content);
+        SaveNoteContent(note.id, note.content, previous.get());
         
         m_dirty = true;
         (void)Save();  // Autosave index
@@ -219,7 +339,7 @@ bool NoteStore::DeleteNote(const std::wstring& id) {
         [&id](const NoteSummary& n) { return n.id == id; });
     
     if (it != m_notes.end()) {
-        m_notes.erase(it);
+        RemoveSummary(it);
         DeleteNoteContent(id);  // Remove content file
         m_dirty = true;
         (void)Save();  // Autosave index
@@ -233,8 +353,10 @@ bool NoteStore::TogglePin(const std::wstring& id) {
         [&id](const NoteSummary& n) { return n.id == id; });
     
     if (it != m_notes.end()) {
+        DetachSortKeys(*it);
         it->isPinned = !it->isPinned;
         it->updatedAt = std::time(nullptr);
+        AttachSortKeys(*it);
         m_dirty = true;
         (void)Save();  // Autosave index
         return true;
@@ -246,108 +368,386 @@ std::vector<NoteSummary> NoteStore::GetNotes(const NoteFilter& filter) const {
     return FilterAndSort(filter);
 }
 
+std::vector<NoteSummary> NoteStore::GetNotes(const NoteFilter& filter, size_t offset, size_t limit,
+                                             size_t* totalCount) const {
+    std::vector<size_t> slots = FilterSlots(filter);
+    if (totalCount) {
+        *totalCount = slots.size();
+    }
+    
+    std::vector<NoteSummary> page;
+    if (offset >= slots.size()) {
+        return page;
+    }
+    size_t end = offset + std::min(limit, slots.size() - offset);
+    page.reserve(end - offset);
+    for (size_t i = offset; i < end; ++i) {
+        page.push_back(m_notes[slots[i]]);
+    }
+    return page;
+}
+
+NoteView NoteStore::GetNoteView(const NoteFilter& filter) const {
+    NoteView view;
+    view.slots = FilterSlots(filter);
+    view.layoutVersion = m_layoutVersion;
+    return view;
+}
+
+const NoteSummary* NoteStore::GetViewNote(const NoteView& view, size_t index) const {
+    if (!IsViewCurrent(view) || index >= view.slots.size()) {
+        return nullptr;
+    }
+    return &m_notes[view.slots[index]];
+}
+
+NoteSearchSources NoteStore::MakeSearchSources(const NoteView& view) const {
+    auto sources = std::make_shared<std::vector<NoteSearchSource>>();
+    if (!IsViewCurrent(view)) {
+        return sources;
+    }
+    
+    sources->reserve(view.slots.size());
+    for (size_t slot : view.slots) {
+        const NoteSummary& summary = m_notes[slot];
+        NoteSearchSource source;
+        source.id = summary.id;
+        source.lowerTitle = summary.title;
+        std::transform(source.lowerTitle.begin(), source.lowerTitle.end(), source.lowerTitle.begin(), ::towlower);
+        source.lowerPreview = summary.contentPreview;
+        std::transform(source.lowerPreview.begin(), source.lowerPreview.end(), source.lowerPreview.begin(), ::towlower);
+        source.previewIsComplete = summary.contentPreview.length() < PREVIEW_LENGTH;
+        sources->push_back(std::move(source));
+    }
+    return sources;
+}
+
 std::vector<NoteSummary> NoteStore::GetPinnedNotes() const {
     NoteFilter filter;
     filter.pinnedOnly = true;
     return FilterAndSort(filter);
 }
 
-std::vector<NoteSearchResult> NoteStore::SearchNotes(const std::wstring& query, bool matchCase) const {
+std::vector<NoteSearchResult> NoteStore::SearchNotes(const std::wstring& query, bool matchCase,
+                                                     size_t limit) const {
+    QNOTE_TRACE_SCOPE("NoteStore::SearchNotes");
     std::vector<NoteSearchResult> results;
     
-    if (query.empty()) {
+    if (query.empty() || limit == 0) {
         return results;
     }
+    TrackSearchIndex();
+    DrainSearchIndex(CancellationToken(), false);
     
-    std::wstring searchQuery = query;
-    if (!matchCase) {
-        std::transform(searchQuery.begin(), searchQuery.end(), searchQuery.begin(), ::towlower);
+    // The index ignores case, so an exact-case search ranks every match and
+    // keeps the best that also match as typed
+    std::vector<std::wstring> words;
+    if (matchCase) {
+        words = NoteSearchIndex::GetQueryWords(query);
+    }
+    std::vector<NoteSearchHit> hits;
+    {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        hits = m_searchIndex.Search(query, matchCase ? m_notes.size() : limit);
     }
     
-    for (const auto& summary : m_notes) {
-        // Quick pre-filter: check title and preview before loading full content
-        std::wstring titleText = summary.title;
-        std::wstring previewText = summary.contentPreview;
-        if (!matchCase) {
-            std::transform(titleText.begin(), titleText.end(), titleText.begin(), ::towlower);
-            std::transform(previewText.begin(), previewText.end(), previewText.begin(), ::towlower);
-        }
+    for (const auto& hit : hits) {
+        if (results.size() >= limit) break;
         
-        bool mightMatch = (titleText.find(searchQuery) != std::wstring::npos) ||
-                          (previewText.find(searchQuery) != std::wstring::npos);
+        size_t slot = 0;
+        if (!m_timeline.Find(static_cast<time_t>(hit.tag), hit.id, slot)) continue;
+        const NoteSummary& summary = m_notes[slot];
         
-        // If preview didn't match and the note is longer than the preview, still check full content
-        if (!mightMatch && summary.contentPreview.length() < PREVIEW_LENGTH) {
-            continue;  // Short note — preview IS the full content, no match
+        NoteContentPtr content;
+        if (hit.bodyMatch || matchCase) {
+            content = LoadNoteContent(summary.id, CacheAccess::Scan);
         }
-        
-        // Load full content (needed for match position and snippet, uses LRU cache)
-        std::wstring content = LoadNoteContent(summary.id);
-        
-        std::wstring searchText = content;
-        if (!matchCase) {
-            std::transform(searchText.begin(), searchText.end(), searchText.begin(), ::towlower);
+        if (matchCase) {
+            bool all = std::all_of(words.begin(), words.end(), [&](const std::wstring& word) {
+                return summary.title.find(word) != std::wstring::npos ||
+                       content->find(word) != std::wstring::npos;
+            });
+            if (!all) continue;
         }
         
-        size_t pos = searchText.find(searchQuery);
-        if (pos != std::wstring::npos) {
-            NoteSearchResult result;
-            result.summary = summary;
-            result.matchStart = pos;
-            result.matchLength = query.length();
-            
-            // Create context snippet
-            size_t snippetStart = (pos > 30) ? pos - 30 : 0;
-            size_t snippetEnd = std::min(pos + query.length() + 50, content.length());
-            result.contextSnippet = L"";
-            if (snippetStart > 0) result.contextSnippet = L"...";
-            result.contextSnippet += content.substr(snippetStart, snippetEnd - snippetStart);
-            if (snippetEnd < content.length()) result.contextSnippet += L"...";
-            
-            results.push_back(result);
+        NoteSearchResult result;
+        result.summary = summary;
+        result.score = hit.score;
+        if (hit.bodyMatch) {
+            result.matchStart = hit.matchStart;
+            result.matchLength = hit.matchLength;
+            result.contextSnippet = MakeSnippet(*content, hit.snippetStart, hit.snippetLength, false);
+        } else {
+            // Matched on the title: show the start of the note from the preview
+            result.contextSnippet = MakeSnippet(summary.contentPreview, 0, hit.snippetLength,
+                                                summary.contentPreview.length() >= PREVIEW_LENGTH);
         }
+        results.push_back(std::move(result));
     }
     
     return results;
 }
 
+void NoteStore::StartSearchIndex(TaskScheduler& scheduler) {
+    {
+        std::lock_guard<std::mutex> lock(m_searchGate->mutex);
+        m_searchGate->token = CancellationToken::Create();
+    }
+    m_searchScheduler = &scheduler;
+    TrackSearchIndex();
+    QueueSearchIndexTask();
+}
+
+bool NoteStore::SearchIndexed(const std::wstring& query, size_t limit,
+                              std::vector<NoteRankedHit>& hits) const {
+    QNOTE_TRACE_SCOPE("NoteStore::SearchIndexed");
+    hits.clear();
+    
+    std::vector<NoteSearchHit> found;
+    {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        if (!m_searchIndexBuilt) return false;
+        if (query.empty() || limit == 0) return true;
+        found = m_searchIndex.Search(query, limit);
+    }
+    
+    // Offsets are into the content as it was indexed; a note edited since
+    // is re-indexed shortly, and until then its snippet is only misplaced
+    hits.reserve(found.size());
+    for (const auto& hit : found) {
+        NoteContentPtr content = LoadNoteContent(hit.id, CacheAccess::Scan);
+        NoteRankedHit ranked;
+        ranked.id = hit.id;
+        ranked.score = hit.score;
+        ranked.snippet = MakeSnippet(*content, hit.bodyMatch ? hit.snippetStart : 0,
+                                     hit.snippetLength, false);
+        hits.push_back(std::move(ranked));
+    }
+    return true;
+}
+
 std::vector<NoteSummary> NoteStore::GetNotesForDate(int year, int month, int day) const {
-    std::vector<NoteSummary> result;
-    
     struct tm targetDate = {};
     targetDate.tm_year = year - 1900;
     targetDate.tm_mon = month - 1;
     targetDate.tm_mday = day;
+    targetDate.tm_isdst = -1;
     time_t targetStart = mktime(&targetDate);
-    time_t targetEnd = targetStart + 24 * 60 * 60;  // Next day
-    
-    for (const auto& summary : m_notes) {
-        if (summary.createdAt >= targetStart && summary.createdAt < targetEnd) {
-            result.push_back(summary);
-        }
-    }
+    targetDate.tm_mday = day + 1;
+    targetDate.tm_isdst = -1;
+    time_t targetEnd = mktime(&targetDate);  // Next day (not always 24h away)
     
     // Sort by creation time descending
-    std::sort(result.begin(), result.end(),
-        [](const NoteSummary& a, const NoteSummary& b) { return a.createdAt > b.createdAt; });
+    return GetNotesInRange(targetStart, targetEnd, true);
+}
+
+std::vector<NoteSummary> NoteStore::GetNotesForMonth(int year, int month) const {
+    struct tm targetDate = {};
+    targetDate.tm_year = year - 1900;
+    targetDate.tm_mon = month - 1;
+    targetDate.tm_mday = 1;
+    targetDate.tm_isdst = -1;
+    time_t targetStart = mktime(&targetDate);
+    targetDate.tm_mon = month;
+    targetDate.tm_isdst = -1;
+    time_t targetEnd = mktime(&targetDate);
     
+    return GetNotesInRange(targetStart, targetEnd, true);
+}
+
+std::vector<NoteSummary> NoteStore::GetNotesInRange(time_t from, time_t to, bool newestFirst) const {
+    std::vector<size_t> slots;
+    m_timeline.Range(from, to, slots);
+    if (newestFirst) {
+        std::reverse(slots.begin(), slots.end());
+    }
+    
+    std::vector<NoteSummary> result;
+    result.reserve(slots.size());
+    for (size_t slot : slots) {
+        result.push_back(m_notes[slot]);
+    }
     return result;
 }
 
 std::vector<time_t> NoteStore::GetNoteDates() const {
-    std::unordered_set<time_t> uniqueDates;
-    uniqueDates.reserve(m_notes.size());
+    // Most recent first
+    return m_timeline.GetDays();
+}
+
+//------------------------------------------------------------------------------
+// Summary vector maintenance, keeping the timeline in step.  Removal moves
+// the last summary into the freed slot, so only one timeline entry changes.
+//------------------------------------------------------------------------------
+void NoteStore::AddSummary(NoteSummary summary) {
+    m_notes.push_back(std::move(summary));
+    const NoteSummary& added = m_notes.back();
+    m_timeline.Insert(added.createdAt, GetMidnight(added.createdAt), added.id, m_notes.size() - 1);
+    AttachSortKeys(added);
+    MarkSearchStale(added);
+    m_layoutVersion++;
+}
+
+void NoteStore::RemoveSummary(std::vector<NoteSummary>::iterator it) {
+    m_timeline.Erase(it->createdAt, it->id);
+    DetachSortKeys(*it);
+    MarkSearchStale(*it, true);
+    
+    size_t slot = static_cast<size_t>(it - m_notes.begin());
+    if (slot + 1 != m_notes.size()) {
+        m_notes[slot] = std::move(m_notes.back());
+        const NoteSummary& moved = m_notes[slot];
+        m_timeline.Move(moved.createdAt, moved.id, slot);
+        m_sortIndex.Move(moved.updatedAt, NoteSortIndex::MakeTitleKey(moved.GetDisplayTitle()), moved.id, slot);
+    }
+    m_notes.pop_back();
+    m_layoutVersion++;
+}
+
+void NoteStore::ClearSummaries() {
+    m_notes.clear();
+    m_timeline.Clear();
+    m_sortIndex.Clear();
+    m_layoutVersion++;
+    
+    // The notes that replace these are queued as they are added
+    {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        if (!m_searchIndexTracked) return;
+        m_searchIndexPending.clear();
+        m_searchIndexPending.push_back({ SearchIndexWork::Kind::Clear, {}, {}, 0 });
+    }
+    QueueSearchIndexTask();
+}
+
+//------------------------------------------------------------------------------
+// Search index upkeep.  Once tracked, every change queues the note's id and
+// title; the drain reads the content and updates the index, so typing
+// costs nothing here.  A drain that empties the queue leaves the index
+// holding every note.
+//------------------------------------------------------------------------------
+void NoteStore::TrackSearchIndex() const {
+    if (m_searchIndexTracked) return;
+    m_searchIndexTracked = true;
     
-    for (const auto& note : m_notes) {
-        time_t midnight = GetMidnight(note.createdAt);
-        uniqueDates.insert(midnight);
+    std::lock_guard<std::mutex> lock(m_searchMutex);
+    m_searchIndexPending.clear();
+    m_searchIndexPending.push_back({ SearchIndexWork::Kind::Clear, {}, {}, 0 });
+    for (const auto& summary : m_notes) {
+        m_searchIndexPending.push_back({ SearchIndexWork::Kind::Set, summary.id, summary.title,
+                                         summary.createdAt });
     }
+}
+
+void NoteStore::MarkSearchStale(const NoteSummary& summary, bool removed) {
+    if (!m_searchIndexTracked) return;
+    {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        m_searchIndexPending.push_back({ removed ? SearchIndexWork::Kind::Remove : SearchIndexWork::Kind::Set,
+                                         summary.id, summary.title, summary.createdAt });
+    }
+    QueueSearchIndexTask();
+}
+
+// Queue a low-priority drain unless one is already queued
+void NoteStore::QueueSearchIndexTask() const {
+    if (!m_searchScheduler) return;
+    {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        if (m_searchIndexTaskQueued || m_searchIndexPending.empty()) return;
+        m_searchIndexTaskQueued = true;
+    }
+    
+    std::shared_ptr<SearchIndexGate> gate = m_searchGate;
+    CancellationToken token;
+    {
+        std::lock_guard<std::mutex> lock(gate->mutex);
+        token = gate->token;
+    }
+    auto task = [this, gate, token]() {
+        {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            if (token.IsCancelled()) return;
+            gate->running++;
+        }
+        try {
+            DrainSearchIndex(token, true);
+        } catch (const std::bad_alloc&) {
+            // The rest stays queued for the next change or SearchNotes()
+            std::lock_guard<std::mutex> lock(m_searchMutex);
+            m_searchIndexTaskQueued = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(gate->mutex);
+            gate->running--;
+        }
+        gate->idle.notify_all();
+    };
+    if (!m_searchScheduler->Submit(task, TaskPriority::Low, token)) {
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        m_searchIndexTaskQueued = false;
+    }
+}
+
+// Apply queued work in order until the queue is empty or 'token' is
+// cancelled.  Content is read without holding m_searchMutex, so searches
+// go on meanwhile.
+void NoteStore::DrainSearchIndex(const CancellationToken& token, bool fromTask) const {
+    QNOTE_TRACE_SCOPE("NoteStore::DrainSearchIndex");
+    std::lock_guard<std::mutex> drain(m_searchDrainMutex);
+    
+    for (;;) {
+        SearchIndexWork work;
+        {
+            std::lock_guard<std::mutex> lock(m_searchMutex);
+            if (m_searchIndexPending.empty() || token.IsCancelled()) {
+                if (m_searchIndexPending.empty()) m_searchIndexBuilt = true;
+                if (fromTask) m_searchIndexTaskQueued = false;
+                return;
+            }
+            work = std::move(m_searchIndexPending.front());
+            m_searchIndexPending.pop_front();
+        }
+        
+        NoteContentPtr content;
+        if (work.kind == SearchIndexWork::Kind::Set) {
+            content = LoadNoteContent(work.id, CacheAccess::Scan);
+        }
+        
+        std::lock_guard<std::mutex> lock(m_searchMutex);
+        switch (work.kind) {
+            case SearchIndexWork::Kind::Set:
+                m_searchIndex.SetDocument(work.id, static_cast<uint64_t>(work.createdAt), work.title, *content);
+                break;
+            case SearchIndexWork::Kind::Remove:
+                m_searchIndex.RemoveDocument(work.id);
+                break;
+            case SearchIndexWork::Kind::Clear:
+                m_searchIndex.Clear();
+                m_searchIndexBuilt = false;
+                break;
+        }
+    }
+}
+
+// Cancel the index task and wait for a running drain to return
+void NoteStore::StopSearchIndex() noexcept {
+    m_searchScheduler = nullptr;
     
-    // Convert to vector and sort descending (most recent first)
-    std::vector<time_t> dates(uniqueDates.begin(), uniqueDates.end());
-    std::sort(dates.begin(), dates.end(), std::greater<time_t>());
-    
-    return dates;
+    std::unique_lock<std::mutex> lock(m_searchGate->mutex);
+    m_searchGate->token.Cancel();
+    m_searchGate->idle.wait(lock, [this]() { return m_searchGate->running == 0; });
+}
+
+// Call before changing a summary's title or updatedAt, and AttachSortKeys
+// after; 'summary' must be in m_notes
+void NoteStore::DetachSortKeys(const NoteSummary& summary) {
+    m_sortIndex.Erase(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.GetDisplayTitle()), summary.id);
+}
+
+void NoteStore::AttachSortKeys(const NoteSummary& summary) {
+    size_t slot = static_cast<size_t>(&summary - m_notes.data());
+    m_sortIndex.Insert(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.GetDisplayTitle()), summary.id, slot);
 }
 
 std::optional<Note> NoteStore::GetActiveNote() const {
@@ -362,17 +762,28 @@ void NoteStore::SetActiveNote(const std::wstring& id) {
 }
 
 bool NoteStore::Save() {
-    if (!m_dirty) {
+    // With packed storage a new checkpoint also lets dead log segments go
+    if (!m_dirty && !(m_log && m_log->NeedsCheckpoint())) {
         return true;
     }
-    bool result = SaveToFile();
-    if (result) {
-        m_dirty = false;
-    }
-    return result;
+    
+    // The writer saves a snapshot of the index as it is now; before it is
+    // started (while loading or converting) this happens right here
+    auto snapshot = std::make_shared<const std::vector<NoteSummary>>(m_notes);
+    uint64_t generation = m_writeQueue.WriteIndex([this, snapshot](uint64_t& bytesWritten) {
+        return SaveToFile(*snapshot, bytesWritten);
+    });
+    m_dirty = false;
+    return m_writeQueue.IsRunning() || m_writeQueue.GetFlushedGeneration() >= generation;
+}
+
+bool NoteStore::Flush() {
+    (void)Save();
+    return m_writeQueue.Flush();
 }
 
 bool NoteStore::LoadFromFile() {
+    QNOTE_TRACE_SCOPE("NoteStore::LoadFromFile");
     // Check if file exists
     if (GetFileAttributesW(m_storePath.c_str()) == INVALID_FILE_ATTRIBUTES) {
         // No notes file yet, start fresh
@@ -407,8 +818,15 @@ bool NoteStore::LoadFromFile() {
     return ParseJson(json);
 }
 
-bool NoteStore::SaveToFile() {
-    std::wstring json = ToJson();
+bool NoteStore::SaveToFile(const std::vector<NoteSummary>& notes, uint64_t& indexBytes) const {
+    QNOTE_TRACE_SCOPE("NoteStore::SaveToFile");
+    
+    // The index may only refer to log records that are already durable
+    NoteLogCheckpoint checkpoint;
+    if (m_log && !m_log->Checkpoint(checkpoint)) {
+        return false;
+    }
+    std::wstring json = ToJson(notes, m_log ? &checkpoint : nullptr);
     
     // Convert to UTF-8
     int utf8Len = WideCharToMultiByte(CP_UTF8, 0, json.c_str(), -1, nullptr, 0, nullptr, nullptr);
@@ -443,6 +861,10 @@ bool NoteStore::SaveToFile() {
         return false;
     }
     
+    if (m_log) {
+        m_log->CheckpointSaved(checkpoint);
+    }
+    indexBytes = static_cast<uint64_t>(utf8Len - 1);
     return true;
 }
 
@@ -459,7 +881,7 @@ std::wstring NoteStore::GenerateNoteId() const {
 
 bool NoteStore::ParseJson(const std::wstring& json) {
     // Simple JSON parser for note index (metadata only, no content)
-    m_notes.clear();
+    ClearSummaries();
     
     if (json.empty() || json.find(L"[") == std::wstring::npos) {
         return true;  // Empty or invalid, start fresh
@@ -472,6 +894,25 @@ bool NoteStore::ParseJson(const std::wstring& json) {
         return true;
     }
     
+    // Packed storage wraps the array in an object whose "log" member holds
+    // the log checkpoint
+    m_indexIsPacked = false;
+    m_indexCheckpoint = NoteLogCheckpoint();
+    size_t logPos = json.find(L"\"log\"");
+    if (logPos != std::wstring::npos && logPos < arrStart) {
+        m_indexIsPacked = true;
+        auto parseField = [&json, logPos, arrStart](const wchar_t* name) -> unsigned long long {
+            size_t fieldPos = json.find(name, logPos);
+            if (fieldPos == std::wstring::npos || fieldPos > arrStart) return 0;
+            size_t colonPos = json.find(L":", fieldPos);
+            return (colonPos < arrStart) ? std::wcstoull(json.c_str() + colonPos + 1, nullptr, 10) : 0;
+        };
+        m_indexCheckpoint.segment = static_cast<uint32_t>(parseField(L"\"segment\""));
+        m_indexCheckpoint.offset = parseField(L"\"offset\"");
+        m_indexCheckpoint.nextSegment = static_cast<uint32_t>(parseField(L"\"nextSegment\""));
+        m_indexCheckpoint.nextSequence = parseField(L"\"nextSequence\"");
+    }
+    
     // Parse each note object
     size_t pos = arrStart + 1;
     while (pos < arrEnd) {
@@ -575,8 +1016,37 @@ bool NoteStore::ParseJson(const std::wstring& json) {
             }
         }
         
+        // Parse contentHash (hex, optional)
+        size_t hashPos = noteJson.find(L"\"contentHash\"");
+        if (hashPos != std::wstring::npos) {
+            size_t valStart = noteJson.find(L"\"", hashPos + 13) + 1;
+            summary.contentHash = std::wcstoull(noteJson.c_str() + valStart, nullptr, 16);
+        }
+        
+        // Parse logRecord ("segment:offset:length:sequence", packed storage only)
+        size_t recordPos = noteJson.find(L"\"logRecord\"");
+        if (m_indexIsPacked && recordPos != std::wstring::npos && !summary.id.empty()) {
+            size_t valStart = noteJson.find(L"\"", recordPos + 11) + 1;
+            const wchar_t* field = noteJson.c_str() + valStart;
+            wchar_t* fieldEnd = nullptr;
+            unsigned long long values[4] = {};
+            bool valid = true;
+            for (int i = 0; i < 4 && valid; i++) {
+                values[i] = std::wcstoull(field, &fieldEnd, 10);
+                valid = fieldEnd != field && *fieldEnd == (i < 3 ? L':' : L'"');
+                field = fieldEnd + 1;
+            }
+            if (valid) {
+                NoteLogRecordRef& ref = m_indexCheckpoint.table[ToUtf8(summary.id)];
+                ref.segment = static_cast<uint32_t>(values[0]);
+                ref.offset = values[1];
+                ref.length = static_cast<uint32_t>(values[2]);
+                ref.sequence = values[3];
+            }
+        }
+        
         if (!summary.id.empty()) {
-            m_notes.push_back(summary);
+            AddSummary(std::move(summary));
         }
         
         pos = objEnd;
@@ -585,28 +1055,52 @@ bool NoteStore::ParseJson(const std::wstring& json) {
     return true;
 }
 
-std::wstring NoteStore::ToJson() const {
+std::wstring NoteStore::ToJson(const std::vector<NoteSummary>& notes,
+                              const NoteLogCheckpoint* checkpoint) const {
     // Serialize index only (metadata, no content)
     std::wstringstream ss;
+    if (checkpoint) {
+        ss << L"{\n";
+        ss << L"  \"log\": { \"segment\": " << checkpoint->segment
+           << L", \"offset\": " << checkpoint->offset
+           << L", \"nextSegment\": " << checkpoint->nextSegment
+           << L", \"nextSequence\": " << checkpoint->nextSequence << L" },\n";
+        ss << L"  \"notes\": ";
+    }
     ss << L"[\n";
     
-    for (size_t i = 0; i < m_notes.size(); ++i) {
-        const NoteSummary& summary = m_notes[i];
+    for (size_t i = 0; i < notes.size(); ++i) {
+        const NoteSummary& summary = notes[i];
         ss << L"  {\n";
         ss << L"    \"id\": \"" << JsonEscape(summary.id) << L"\",\n";
         ss << L"    \"title\": \"" << JsonEscape(summary.title) << L"\",\n";
         ss << L"    \"contentPreview\": \"" << JsonEscape(summary.contentPreview) << L"\",\n";
         ss << L"    \"createdAt\": " << summary.createdAt << L",\n";
         ss << L"    \"updatedAt\": " << summary.updatedAt << L",\n";
+        if (summary.contentHash != 0) {
+            ss << L"    \"contentHash\": \"" << std::hex << std::setw(16) << std::setfill(L'0')
+               << summary.contentHash << std::dec << std::setfill(L' ') << L"\",\n";
+        }
+        if (checkpoint) {
+            auto record = checkpoint->table.find(ToUtf8(summary.id));
+            if (record != checkpoint->table.end()) {
+                const NoteLogRecordRef& ref = record->second;
+                ss << L"    \"logRecord\": \"" << ref.segment << L":" << ref.offset << L":"
+                   << ref.length << L":" << ref.sequence << L"\",\n";
+            }
+        }
         ss << L"    \"isPinned\": " << (summary.isPinned ? L"true" : L"false") << L"\n";
         ss << L"  }";
-        if (i < m_notes.size() - 1) {
+        if (i < notes.size() - 1) {
             ss << L",";
         }
         ss << L"\n";
     }
     
     ss << L"]\n";
+    if (checkpoint) {
+        ss << L"}\n";
+    }
     return ss.str();
 }
 
@@ -741,31 +1235,6 @@ bool NoteStore::ParseLegacyJson(const std::wstring& json,
     return true;
 }
 
-std::wstring NoteStore::ToFullJson(const std::vector<Note>& notes) const {
-    // Serialize with content (for export)
-    std::wstringstream ss;
-    ss << L"[\n";
-    
-    for (size_t i = 0; i < notes.size(); ++i) {
-        const Note& note = notes[i];
-        ss << L"  {\n";
-        ss << L"    \"id\": \"" << JsonEscape(note.id) << L"\",\n";
-        ss << L"    \"title\": \"" << JsonEscape(note.title) << L"\",\n";
-        ss << L"    \"content\": \"" << JsonEscape(note.content) << L"\",\n";
-        ss << L"    \"createdAt\": " << note.createdAt << L",\n";
-        ss << L"    \"updatedAt\": " << note.updatedAt << L",\n";
-        ss << L"    \"isPinned\": " << (note.isPinned ? L"true" : L"false") << L"\n";
-        ss << L"  }";
-        if (i < notes.size() - 1) {
-            ss << L",";
-        }
-        ss << L"\n";
-    }
-    
-    ss << L"]\n";
-    return ss.str();
-}
-
 std::wstring NoteStore::JsonEscape(const std::wstring& str) {
     std::wstring result;
     result.reserve(str.length() * 2);
@@ -835,33 +1304,72 @@ std::wstring NoteStore::JsonUnescape(const std::wstring& str) {
 }
 
 std::vector<NoteSummary> NoteStore::FilterAndSort(const NoteFilter& filter) const {
+    std::vector<size_t> slots = FilterSlots(filter);
+    
     std::vector<NoteSummary> result;
-    result.reserve(m_notes.size());
+    result.reserve(slots.size());
+    for (size_t slot : slots) {
+        result.push_back(m_notes[slot]);
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Slots of the notes matching 'filter', in its order.  Every order is kept
+// up to date by m_timeline or m_sortIndex, so nothing is sorted here.
+//------------------------------------------------------------------------------
+std::vector<size_t> NoteStore::FilterSlots(const NoteFilter& filter) const {
+    bool byCreated = filter.sortBy == NoteFilter::SortBy::CreatedDesc ||
+                     filter.sortBy == NoteFilter::SortBy::CreatedAsc;
+    bool dateBounded = filter.fromDate != 0 || filter.toDate != 0;
+    time_t from = (filter.fromDate != 0) ? filter.fromDate : std::numeric_limits<time_t>::min();
+    time_t to = (filter.toDate != 0) ? filter.toDate + 1 : std::numeric_limits<time_t>::max();
+    
+    std::vector<size_t> ordered;
+    switch (filter.sortBy) {
+        case NoteFilter::SortBy::CreatedDesc:
+        case NoteFilter::SortBy::CreatedAsc:
+            m_timeline.Range(from, to, ordered);
+            break;
+        case NoteFilter::SortBy::UpdatedDesc:
+        case NoteFilter::SortBy::UpdatedAsc:
+            m_sortIndex.ByUpdated(ordered);
+            break;
+        case NoteFilter::SortBy::TitleAsc:
+        case NoteFilter::SortBy::TitleDesc:
+            m_sortIndex.ByTitle(ordered);
+            break;
+    }
+    if (filter.sortBy == NoteFilter::SortBy::CreatedDesc ||
+        filter.sortBy == NoteFilter::SortBy::UpdatedDesc ||
+        filter.sortBy == NoteFilter::SortBy::TitleDesc) {
+        std::reverse(ordered.begin(), ordered.end());
+    }
     
-    for (const auto& summary : m_notes) {
-        // Apply filters
-        if (filter.pinnedOnly && !summary.isPinned) {
-            continue;
-        }
+    std::wstring lowerQuery = filter.searchQuery;
+    std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::towlower);
+    
+    std::vector<size_t> slots;
+    slots.reserve(ordered.size());
+    for (size_t slot : ordered) {
+        const NoteSummary& summary = m_notes[slot];
         
-        if (filter.fromDate != 0 && summary.createdAt < filter.fromDate) {
+        // Apply filters
+        if (dateBounded && !byCreated && (summary.createdAt < from || summary.createdAt >= to)) {
             continue;
         }
         
-        if (filter.toDate != 0 && summary.createdAt > filter.toDate) {
+        if (filter.pinnedOnly && !summary.isPinned) {
             continue;
         }
         
-        if (!filter.searchQuery.empty()) {
-            std::wstring lowerQuery = filter.searchQuery;
-            std::transform(lowerQuery.begin(), lowerQuery.end(), lowerQuery.begin(), ::towlower);
-            
+        if (!lowerQuery.empty()) {
             // 1) Quick check: title match (no disk I/O)
             std::wstring lowerTitle = summary.title;
             std::transform(lowerTitle.begin(), lowerTitle.end(), lowerTitle.begin(), ::towlower);
             if (lowerTitle.find(lowerQuery) != std::wstring::npos) {
                 // Title matched — include without loading full content
-                result.push_back(summary);
+                slots.push_back(slot);
                 continue;
             }
             
@@ -870,18 +1378,17 @@ std::vector<NoteSummary> NoteStore::FilterAndSort(const NoteFilter& filter) cons
             std::transform(lowerPreview.begin(), lowerPreview.end(), lowerPreview.begin(), ::towlower);
             if (lowerPreview.find(lowerQuery) != std::wstring::npos) {
                 // Preview matched — include without loading full content
-                result.push_back(summary);
+                slots.push_back(slot);
                 continue;
             }
             
             // 3) Preview didn't match but note may be longer — load full content
             //    (skip if preview IS the full content, i.e. note is short)
             if (summary.contentPreview.length() >= PREVIEW_LENGTH) {
-                std::wstring content = LoadNoteContent(summary.id);
-                std::wstring lowerContent = content;
+                std::wstring lowerContent = *LoadNoteContent(summary.id, CacheAccess::Scan);
                 std::transform(lowerContent.begin(), lowerContent.end(), lowerContent.begin(), ::towlower);
                 if (lowerContent.find(lowerQuery) != std::wstring::npos) {
-                    result.push_back(summary);
+                    slots.push_back(slot);
                     continue;
                 }
             }
@@ -890,42 +1397,10 @@ std::vector<NoteSummary> NoteStore::FilterAndSort(const NoteFilter& filter) cons
             continue;
         }
         
-        result.push_back(summary);
-    }
-    
-    // Apply sorting
-    switch (filter.sortBy) {
-        case NoteFilter::SortBy::UpdatedDesc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { return a.updatedAt > b.updatedAt; });
-            break;
-        case NoteFilter::SortBy::UpdatedAsc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { return a.updatedAt < b.updatedAt; });
-            break;
-        case NoteFilter::SortBy::CreatedDesc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { return a.createdAt > b.createdAt; });
-            break;
-        case NoteFilter::SortBy::CreatedAsc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { return a.createdAt < b.createdAt; });
-            break;
-        case NoteFilter::SortBy::TitleAsc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { 
-                    return _wcsicmp(a.GetDisplayTitle().c_str(), b.GetDisplayTitle().c_str()) < 0; 
-                });
-            break;
-        case NoteFilter::SortBy::TitleDesc:
-            std::sort(result.begin(), result.end(),
-                [](const NoteSummary& a, const NoteSummary& b) { 
-                    return _wcsicmp(a.GetDisplayTitle().c_str(), b.GetDisplayTitle().c_str()) > 0; 
-                });
-            break;
+        slots.push_back(slot);
     }
     
-    return result;
+    return slots;
 }
 
 size_t NoteStore::FindCaseInsensitive(const std::wstring& haystack, 
@@ -983,121 +1458,140 @@ time_t ParseDate(const std::wstring& dateStr) {
 }
 
 //------------------------------------------------------------------------------
-// Export all notes to a JSON file (loads content from individual files)
+// Export all notes to a JSON file.  Notes are loaded and written one at a
+// time, so memory use does not depend on the size of the export.
 //------------------------------------------------------------------------------
 bool NoteStore::ExportNotes(const std::wstring& filePath) {
-    // Build full notes with content for export
-    std::vector<Note> fullNotes;
-    fullNotes.reserve(m_notes.size());
-    for (const auto& summary : m_notes) {
-        Note note;
-        static_cast<NoteSummary&>(note) = summary;
-        note.content = LoadNoteContent(summary.id);
-        fullNotes.push_back(std::move(note));
-    }
-    
-    std::wstring json = ToFullJson(fullNotes);
-    
-    // Convert to UTF-8
-    int utf8Len = WideCharToMultiByte(CP_UTF8, 0, json.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (utf8Len <= 0) return false;
-    
-    std::vector<char> utf8Data(utf8Len);
-    WideCharToMultiByte(CP_UTF8, 0, json.c_str(), -1, utf8Data.data(), utf8Len, nullptr, nullptr);
-    
     HandleGuard hFile(CreateFileW(filePath.c_str(), GENERIC_WRITE, 0,
-                               nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+                               nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
     if (!hFile.valid()) return false;
     
-    DWORD bytesWritten;
-    BOOL result = WriteFile(hFile.get(), utf8Data.data(), static_cast<DWORD>(utf8Len - 1), &bytesWritten, nullptr);
+    NoteArchiveWriter writer([&hFile](const char* data, size_t size) {
+        DWORD bytesWritten = 0;
+        return WriteFile(hFile.get(), data, static_cast<DWORD>(size), &bytesWritten, nullptr) != FALSE &&
+               bytesWritten == size;
+    });
+    
+    // One record is reused so its buffers are allocated once
+    NoteArchiveRecord record;
+    bool ok = true;
+    for (const auto& summary : m_notes) {
+        record.id = summary.id;
+        record.title = summary.title;
+        record.content = *LoadNoteContent(summary.id, CacheAccess::Scan);
+        record.createdAt = summary.createdAt;
+        record.updatedAt = summary.updatedAt;
+        record.isPinned = summary.isPinned;
+        if (!writer.WriteNote(record)) {
+            ok = false;
+            break;
+        }
+    }
+    ok = ok && writer.Finish();
+    hFile = HandleGuard();
     
-    return result != FALSE;
+    // Do not leave a truncated export behind
+    if (!ok) {
+        DeleteFileW(filePath.c_str());
+    }
+    return ok;
 }
 
 //------------------------------------------------------------------------------
-// Import notes from a JSON file (merges with existing)
+// Import notes from a JSON file (merges with existing).  The file is parsed
+// one note at a time; content is queued for writing as each note is read
+// and flushed every IMPORT_BATCH_BYTES, so a large archive never has to be
+// held in memory.
 //------------------------------------------------------------------------------
-bool NoteStore::ImportNotes(const std::wstring& filePath) {
-    // Read file
+NoteImportResult NoteStore::ImportNotes(const std::wstring& filePath) {
+    NoteImportResult result;
     HandleGuard hFile(CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
-                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
-    if (!hFile.valid()) return false;
-    
-    LARGE_INTEGER fileSize;
-    if (!GetFileSizeEx(hFile.get(), &fileSize)) {
-        return false;
-    }
-    
-    std::vector<char> buffer(static_cast<size_t>(fileSize.QuadPart) + 1, 0);
-    DWORD bytesRead;
-    if (!ReadFile(hFile.get(), buffer.data(), static_cast<DWORD>(fileSize.QuadPart), &bytesRead, nullptr)) {
-        return false;
+                               nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    if (!hFile.valid()) {
+        result.failed = true;
+        return result;
     }
-    hFile = HandleGuard();
     
-    // Convert UTF-8 to wstring
-    int wideLen = MultiByteToWideChar(CP_UTF8, 0, buffer.data(), bytesRead, nullptr, 0);
-    std::wstring json(wideLen, 0);
-    MultiByteToWideChar(CP_UTF8, 0, buffer.data(), bytesRead, &json[0], wideLen);
+    NoteArchiveReader reader([&hFile](char* buffer, size_t capacity, size_t& bytesRead) {
+        DWORD read = 0;
+        if (!ReadFile(hFile.get(), buffer, static_cast<DWORD>(capacity), &read, nullptr)) {
+            return false;
+        }
+        bytesRead = read;
+        return true;
+    });
     
-    // Parse imported notes (with content)
-    std::vector<Note> importedNotes;
-    if (!ParseLegacyJson(json, importedNotes)) {
-        return false;
+    // Skip notes whose IDs already exist, in the store or earlier in the file
+    std::unordered_set<std::wstring> knownIds;
+    knownIds.reserve(m_notes.size());
+    for (const auto& existing : m_notes) {
+        knownIds.insert(existing.id);
     }
     
-    // Merge: add imported notes whose IDs don't already exist
-    int addedCount = 0;
-    for (const auto& imported : importedNotes) {
-        bool exists = false;
-        for (const auto& existing : m_notes) {
-            if (existing.id == imported.id) {
-                exists = true;
-                break;
-            }
+    NoteArchiveRecord imported;
+    uint64_t batchBytes = 0;
+    bool written = true;
+    while (reader.Next(imported)) {
+        if (!knownIds.insert(imported.id).second) {
+            continue;
         }
-        if (!exists) {
-            // Save content to individual file
-            (void)SaveNoteContent(imported.id, imported.content);
-            
-            // Generate title if empty
-            std::wstring title = imported.title;
-            if (title.empty() && !imported.content.empty()) {
-                size_t newlinePos = imported.content.find_first_of(L"\r\n");
-                std::wstring firstLine = (newlinePos != std::wstring::npos) 
-                    ? imported.content.substr(0, newlinePos) 
-                    : imported.content;
-                size_t start = firstLine.find_first_not_of(L" \t");
-                if (start != std::wstring::npos) {
-                    size_t end = firstLine.find_last_not_of(L" \t");
-                    firstLine = firstLine.substr(start, end - start + 1);
-                    if (firstLine.length() > 50) {
-                        firstLine = firstLine.substr(0, 47) + L"...";
-                    }
-                    title = firstLine;
+        
+        // Generate title if empty
+        std::wstring title = imported.title;
+        if (title.empty() && !imported.content.empty()) {
+            size_t newlinePos = imported.content.find_first_of(L"\r\n");
+            std::wstring firstLine = (newlinePos != std::wstring::npos) 
+                ? imported.content.substr(0, newlinePos) 
+                : imported.content;
+            size_t start = firstLine.find_first_not_of(L" \t");
+            if (start != std::wstring::npos) {
+                size_t end = firstLine.find_last_not_of(L" \t");
+                firstLine = firstLine.substr(start, end - start + 1);
+                if (firstLine.length() > 50) {
+                    firstLine = firstLine.substr(0, 47) + L"...";
                 }
+                title = firstLine;
+            }
+        }
+        
+        // Add summary to index
+        NoteSummary summary;
+        summary.id = imported.id;
+        summary.title = title;
+        summary.contentPreview = MakeContentPreview(imported.content);
+        summary.contentHash = HashContent(imported.content);
+        summary.createdAt = imported.createdAt;
+        summary.updatedAt = imported.updatedAt;
+        summary.isPinned = imported.isPinned;
+        
+        // Queue the content without going through the cache, which would
+        // otherwise fill with notes nobody has opened
+        uint64_t contentBytes = Utf8Length(imported.content);
+        (void)m_writeQueue.WriteContent(summary.id,
+                                        std::make_shared<const std::wstring>(std::move(imported.content)),
+                                        contentBytes);
+        AddSummary(std::move(summary));
+        result.imported++;
+        
+        batchBytes += contentBytes;
+        if (batchBytes >= IMPORT_BATCH_BYTES) {
+            batchBytes = 0;
+            if (!m_writeQueue.Flush()) {
+                // Stop reading rather than pile up content that cannot be
+                // written; what is queued is retried later
+                written = false;
+                break;
             }
-            
-            // Add summary to index
-            NoteSummary summary;
-            summary.id = imported.id;
-            summary.title = title;
-            summary.contentPreview = MakeContentPreview(imported.content);
-            summary.createdAt = imported.createdAt;
-            summary.updatedAt = imported.updatedAt;
-            summary.isPinned = imported.isPinned;
-            m_notes.push_back(summary);
-            addedCount++;
         }
     }
     
-    if (addedCount > 0) {
+    if (result.imported > 0) {
         m_dirty = true;
         (void)Save();
     }
     
-    return true;
+    result.failed = !written || reader.HasError();
+    return result;
 }
 
 //------------------------------------------------------------------------------
@@ -1108,40 +1602,6 @@ std::wstring NoteStore::GetNoteContentPath(const std::wstring& id) const {
     return m_notesDir + L"\\" + id + L".txt";
 }
 
-//------------------------------------------------------------------------------
-// LRU content cache helpers
-//------------------------------------------------------------------------------
-
-void NoteStore::CacheContent(const std::wstring& id, const std::wstring& content) const {
-    auto it = m_contentCache.find(id);
-    if (it != m_contentCache.end()) {
-        // Move to front (most recently used)
-        m_cacheOrder.erase(it->second.first);
-        m_cacheOrder.push_front(id);
-        it->second.first = m_cacheOrder.begin();
-        it->second.second = content;
-        return;
-    }
-    
-    // Evict LRU entry if at capacity
-    if (m_contentCache.size() >= MAX_CACHE_ENTRIES) {
-        const std::wstring& evictId = m_cacheOrder.back();
-        m_contentCache.erase(evictId);
-        m_cacheOrder.pop_back();
-    }
-    
-    m_cacheOrder.push_front(id);
-    m_contentCache[id] = { m_cacheOrder.begin(), content };
-}
-
-void NoteStore::InvalidateCache(const std::wstring& id) const {
-    auto it = m_contentCache.find(id);
-    if (it != m_contentCache.end()) {
-        m_cacheOrder.erase(it->second.first);
-        m_contentCache.erase(it);
-    }
-}
-
 std::wstring NoteStore::MakeContentPreview(const std::wstring& content, size_t maxLen) {
     if (content.length() <= maxLen) {
         return content;
@@ -1155,30 +1615,123 @@ std::wstring NoteStore::MakeContentPreview(const std::wstring& content, size_t m
 }
 
 //------------------------------------------------------------------------------
-// Content loading with LRU cache
+// FNV-1a, 64-bit, over UTF-16 code units.  Never 0, which means "unknown".
 //------------------------------------------------------------------------------
+uint64_t NoteStore::HashContent(const std::wstring& content) noexcept {
+    uint64_t hash = 14695981039346656037ULL;
+    for (wchar_t ch : content) {
+        hash ^= static_cast<uint16_t>(ch);
+        hash *= 1099511628211ULL;
+    }
+    return hash != 0 ? hash : 1;
+}
 
-std::wstring NoteStore::LoadNoteContent(const std::wstring& id) const {
+// UTF-8 size of the span that differs between two revisions, taken from
+// the longer one after trimming their common prefix and suffix
+uint64_t NoteStore::ChangedBytes(const std::wstring& before, const std::wstring& after) {
+    size_t shorter = std::min(before.size(), after.size());
+    size_t prefix = 0;
+    while (prefix < shorter && before[prefix] == after[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < shorter - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix]) {
+        suffix++;
+    }
+    
+    const std::wstring& longer = (after.size() >= before.size()) ? after : before;
+    size_t spanLength = longer.size() - prefix - suffix;
+    return ToUtf8(longer.substr(prefix, spanLength)).size();
+}
+
+//------------------------------------------------------------------------------
+// Content loading with cache
+//------------------------------------------------------------------------------
+
+NoteContentPtr NoteStore::LoadNoteContent(const std::wstring& id, CacheAccess access) const {
     // Check cache first
-    auto cacheIt = m_contentCache.find(id);
-    if (cacheIt != m_contentCache.end()) {
-        // Move to front (most recently used)
-        m_cacheOrder.erase(cacheIt->second.first);
-        m_cacheOrder.push_front(id);
-        cacheIt->second.first = m_cacheOrder.begin();
-        return cacheIt->second.second;
+    if (NoteContentPtr cached = m_contentCache.Find(id, access)) {
+        return cached;
+    }
+    
+    // Content not written yet is newer than what is on disk
+    NoteContentPtr content;
+    if (m_writeQueue.FindPending(id, content)) {
+        return content ? content : std::make_shared<const std::wstring>();
     }
     
     // Cache miss — load from disk
-    std::wstring content = LoadNoteContentFromDisk(id);
+    content = std::make_shared<const std::wstring>(LoadNoteContentFromDisk(id));
     
     // Cache the result
-    CacheContent(id, content);
+    m_contentCache.Insert(id, content, access);
     
     return content;
 }
 
 std::wstring NoteStore::LoadNoteContentFromDisk(const std::wstring& id) const {
+    if (m_log) {
+        std::string payload;
+        if (!m_log->Read(ToUtf8(id), payload)) {
+            return L"";
+        }
+        return FromUtf8(payload);
+    }
+    return ReadContentFile(id);
+}
+
+void NoteStore::SaveNoteContent(const std::wstring& id, const std::wstring& content,
+                                const std::wstring* previous) {
+    uint64_t bytesChanged = previous ? ChangedBytes(*previous, content) : ToUtf8(content).size();
+    
+    // Readers see the new content at once; the write happens in the background
+    NoteContentPtr shared = std::make_shared<const std::wstring>(content);
+    m_contentCache.Update(id, shared);
+    (void)m_writeQueue.WriteContent(id, std::move(shared), bytesChanged);
+    
+    // Update content preview and digest in the index
+    auto it = std::find_if(m_notes.begin(), m_notes.end(),
+        [&id](const NoteSummary& n) { return n.id == id; });
+    if (it != m_notes.end()) {
+        it->contentPreview = MakeContentPreview(content);
+        it->contentHash = HashContent(content);
+        MarkSearchStale(*it);
+    }
+}
+
+void NoteStore::DeleteNoteContent(const std::wstring& id) {
+    m_contentCache.Erase(id);
+    (void)m_writeQueue.DeleteContent(id);
+}
+
+//------------------------------------------------------------------------------
+// Runs on the write queue's thread.  m_log is only replaced while the
+// queue is stopped.
+//------------------------------------------------------------------------------
+bool NoteStore::WriteQueuedContent(const std::wstring& id, const NoteContentPtr& content,
+                                   uint64_t& bytesWritten) const {
+    QNOTE_TRACE_SCOPE("NoteStore::WriteQueuedContent");
+    
+    if (!content) {
+        if (m_log) {
+            return m_log->Remove(ToUtf8(id));
+        }
+        std::wstring path = GetNoteContentPath(id);
+        return DeleteFileW(path.c_str()) || GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+    
+    std::string utf8 = ToUtf8(*content);
+    bytesWritten = utf8.size();
+    
+    // The log makes the write durable with its next group commit
+    if (m_log) {
+        return m_log->Append(ToUtf8(id), utf8, static_cast<uint64_t>(std::time(nullptr)));
+    }
+    return WriteContentFile(id, utf8);
+}
+
+std::wstring NoteStore::ReadContentFile(const std::wstring& id) const {
     std::wstring path = GetNoteContentPath(id);
     
     HandleGuard hFile(CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
@@ -1213,16 +1766,9 @@ std::wstring NoteStore::LoadNoteContentFromDisk(const std::wstring& id) const {
     return content;
 }
 
-bool NoteStore::SaveNoteContent(const std::wstring& id, const std::wstring& content) {
+bool NoteStore::WriteContentFile(const std::wstring& id, const std::string& utf8) const {
     std::wstring path = GetNoteContentPath(id);
     
-    // Convert to UTF-8
-    int utf8Len = WideCharToMultiByte(CP_UTF8, 0, content.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (utf8Len <= 0) return false;
-    
-    std::vector<char> utf8Data(utf8Len);
-    WideCharToMultiByte(CP_UTF8, 0, content.c_str(), -1, utf8Data.data(), utf8Len, nullptr, nullptr);
-    
     // Atomic write: write to temp file, then rename
     std::wstring tempPath = path + L".tmp";
     
@@ -1233,7 +1779,7 @@ bool NoteStore::SaveNoteContent(const std::wstring& id, const std::wstring& cont
     }
     
     DWORD bytesWritten;
-    BOOL result = WriteFile(hFile.get(), utf8Data.data(), static_cast<DWORD>(utf8Len - 1), &bytesWritten, nullptr);
+    BOOL result = WriteFile(hFile.get(), utf8.data(), static_cast<DWORD>(utf8.size()), &bytesWritten, nullptr);
     FlushFileBuffers(hFile.get());
     hFile = HandleGuard();  // Close before rename
     
@@ -1247,27 +1793,131 @@ bool NoteStore::SaveNoteContent(const std::wstring& id, const std::wstring& cont
         return false;
     }
     
-    result = TRUE;  // Rename succeeded
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Packed storage
+//------------------------------------------------------------------------------
+
+bool NoteStore::OpenNoteLog(const NoteLogCheckpoint& checkpoint) {
+    auto log = std::make_unique<NoteLog>();
+    std::vector<NoteLogChange> changes;
+    std::wstring errorMessage;
+    if (!log->Open(m_logDir, checkpoint, changes, errorMessage)) {
+        return false;
+    }
+    m_log = std::move(log);
     
-    if (result) {
-        // Update cache with new content
-        CacheContent(id, content);
-        
-        // Update content preview in the index
+    // Bring the index up to date with revisions saved after its checkpoint
+    for (const auto& change : changes) {
+        std::wstring id = FromUtf8(change.key);
         auto it = std::find_if(m_notes.begin(), m_notes.end(),
             [&id](const NoteSummary& n) { return n.id == id; });
-        if (it != m_notes.end()) {
-            it->contentPreview = MakeContentPreview(content);
+        
+        if (change.removed) {
+            if (it != m_notes.end()) {
+                RemoveSummary(it);
+            }
+        } else {
+            std::wstring content = LoadNoteContentFromDisk(id);
+            time_t timestamp = static_cast<time_t>(change.timestamp);
+            if (it != m_notes.end()) {
+                it->contentPreview = MakeContentPreview(content);
+                it->contentHash = HashContent(content);
+                DetachSortKeys(*it);
+                it->updatedAt = timestamp;
+                AttachSortKeys(*it);
+            } else {
+                // Created after the index was last saved
+                NoteSummary summary;
+                summary.id = id;
+                size_t newlinePos = content.find_first_of(L"\r\n");
+                std::wstring firstLine = (newlinePos != std::wstring::npos)
+                    ? content.substr(0, newlinePos)
+                    : content;
+                size_t start = firstLine.find_first_not_of(L" \t");
+                if (start != std::wstring::npos) {
+                    size_t end = firstLine.find_last_not_of(L" \t");
+                    firstLine = firstLine.substr(start, end - start + 1);
+                    if (firstLine.length() > 50) {
+                        firstLine = firstLine.substr(0, 47) + L"...";
+                    }
+                    summary.title = firstLine;
+                }
+                summary.contentPreview = MakeContentPreview(content);
+                summary.contentHash = HashContent(content);
+                summary.createdAt = timestamp;
+                summary.updatedAt = timestamp;
+                AddSummary(std::move(summary));
+            }
         }
+        m_dirty = true;
     }
-    
-    return result != FALSE;
+    return true;
 }
 
-void NoteStore::DeleteNoteContent(const std::wstring& id) {
-    std::wstring path = GetNoteContentPath(id);
-    DeleteFileW(path.c_str());
-    InvalidateCache(id);
+//------------------------------------------------------------------------------
+// Switch content storage layout.  Every note is copied first and the index
+// is saved in the new layout before the old copies are removed, so a crash
+// part way leaves the previous layout intact.
+//------------------------------------------------------------------------------
+bool NoteStore::ConvertContentStorage(bool toPacked) {
+    QNOTE_TRACE_SCOPE("NoteStore::ConvertContentStorage");
+    if (toPacked == (m_log != nullptr)) {
+        return true;
+    }
+    
+    if (toPacked) {
+        // Anything in the log directory predates this index
+        NoteLog::Destroy(m_logDir);
+        auto log = std::make_unique<NoteLog>();
+        std::vector<NoteLogChange> changes;
+        std::wstring errorMessage;
+        if (!log->Open(m_logDir, NoteLogCheckpoint(), changes, errorMessage)) {
+            return false;
+        }
+        for (const auto& summary : m_notes) {
+            std::wstring content = ReadContentFile(summary.id);
+            if (!log->Append(ToUtf8(summary.id), ToUtf8(content),
+                             static_cast<uint64_t>(summary.updatedAt))) {
+                log->Close();
+                NoteLog::Destroy(m_logDir);
+                return false;
+            }
+        }
+        
+        m_log = std::move(log);
+        m_dirty = true;
+        if (!Save()) {
+            m_log->Close();
+            m_log.reset();
+            NoteLog::Destroy(m_logDir);
+            return false;
+        }
+        
+        for (const auto& summary : m_notes) {
+            std::wstring path = GetNoteContentPath(summary.id);
+            DeleteFileW(path.c_str());
+        }
+        return true;
+    }
+    
+    for (const auto& summary : m_notes) {
+        if (!WriteContentFile(summary.id, ToUtf8(LoadNoteContentFromDisk(summary.id)))) {
+            return false;
+        }
+    }
+    
+    std::unique_ptr<NoteLog> log = std::move(m_log);
+    m_dirty = true;
+    if (!Save()) {
+        m_log = std::move(log);
+        return false;
+    }
+    log->Close();
+    NoteLog::Destroy(m_logDir);
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -1314,10 +1964,10 @@ bool NoteStore::MigrateFromLegacyFormat() {
     }
     
     // Migrate each note: save content to individual file, keep summary in index
-    m_notes.clear();
+    ClearSummaries();
     for (const auto& note : legacyNotes) {
         // Save content to individual file
-        (void)SaveNoteContent(note.id, note.content);
+        SaveNoteContent(note.id, note.content);
         
         // Generate title from content if not set
         std::wstring title = note.title;
@@ -1342,10 +1992,11 @@ bool NoteStore::MigrateFromLegacyFormat() {
         summary.id = note.id;
         summary.title = title;
         summary.contentPreview = MakeContentPreview(note.content);
+        summary.contentHash = HashContent(note.content);
         summary.createdAt = note.createdAt;
         summary.updatedAt = note.updatedAt;
         summary.isPinned = note.isPinned;
-        m_notes.push_back(summary);
+        AddSummary(std::move(summary));
     }
     
     // Save the new index
@@ -16,9 +16,18 @@
 #include <vector>
 #include <memory>
 #include <ctime>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <optional>
-#include <list>
-#include <unordered_map>
+#include "NoteArchive.h"
+#include "NoteContentCache.h"
+#include "NoteLog.h"
+#include "NoteSearch.h"
+#include "NoteSearchIndex.h"
+#include "NoteSortIndex.h"
+#include "NoteTimeline.h"
+#include "NoteWriteQueue.h"
 
 namespace QNote {
 
@@ -32,6 +41,7 @@ struct NoteSummary {
     time_t createdAt = 0;      // Creation timestamp
     time_t updatedAt = 0;      // Last modification timestamp
     bool isPinned = false;     // Whether the note is starred/pinned
+    uint64_t contentHash = 0;  // Digest of the saved content (0 = not known yet)
 
     // Generate a display title
     [[nodiscard]] std::wstring GetDisplayTitle() const;
@@ -53,6 +63,7 @@ struct Note : NoteSummary {
 //------------------------------------------------------------------------------
 struct NoteSearchResult {
     NoteSummary summary;
+    double score = 0.0;        // Relevance (BM25); results come best first
     size_t matchStart = 0;     // Start position of match in content
     size_t matchLength = 0;    // Length of match
     std::wstring contextSnippet; // Text snippet around the match
@@ -79,6 +90,27 @@ struct NoteFilter {
     SortBy sortBy = SortBy::UpdatedDesc;
 };
 
+//------------------------------------------------------------------------------
+// A filtered, ordered list of notes that can be read one row at a time.
+// Valid until a note is added or removed; GetViewNote() returns nullptr
+// once it is stale.
+//------------------------------------------------------------------------------
+struct NoteView {
+    std::vector<size_t> slots;     // Positions in the store's summary list
+    uint64_t layoutVersion = 0;
+    
+    [[nodiscard]] size_t size() const noexcept { return slots.size(); }
+};
+
+//------------------------------------------------------------------------------
+// Outcome of an import.  Notes read before an error are kept, so 'failed'
+// can come with a non-zero count.
+//------------------------------------------------------------------------------
+struct NoteImportResult {
+    size_t imported = 0;           // New notes added to the store
+    bool failed = false;           // File unreadable, cut short or malformed
+};
+
 //------------------------------------------------------------------------------
 // Note store class - manages all notes with autosave
 //------------------------------------------------------------------------------
@@ -91,6 +123,12 @@ public:
     NoteStore(const NoteStore&) = delete;
     NoteStore& operator=(const NoteStore&) = delete;
     
+    // Keep note contents in one append-only log (NoteLog) instead of one
+    // file per note.  Call before Initialize(); existing notes are
+    // converted to the chosen layout when the store is opened.
+    void SetPackedStorage(bool enabled) { m_packedStorage = enabled; }
+    [[nodiscard]] bool IsPackedStorage() const { return m_log != nullptr; }
+    
     // Initialize the store (load from disk)
     [[nodiscard]] bool Initialize();
     
@@ -115,17 +153,56 @@ public:
     // Get note summaries with optional filtering (no content loaded)
     [[nodiscard]] std::vector<NoteSummary> GetNotes(const NoteFilter& filter = NoteFilter()) const;
     
+    // One page of the filtered notes; 'totalCount' receives the full count
+    [[nodiscard]] std::vector<NoteSummary> GetNotes(const NoteFilter& filter, size_t offset, size_t limit,
+                                                    size_t* totalCount = nullptr) const;
+    
+    // Filtered notes without copying any summaries
+    [[nodiscard]] NoteView GetNoteView(const NoteFilter& filter = NoteFilter()) const;
+    [[nodiscard]] const NoteSummary* GetViewNote(const NoteView& view, size_t index) const;
+    [[nodiscard]] bool IsViewCurrent(const NoteView& view) const { return view.layoutVersion == m_layoutVersion; }
+    
+    // Snapshot of a view's notes for a background NoteSearch; match
+    // positions index into 'view'
+    [[nodiscard]] NoteSearchSources MakeSearchSources(const NoteView& view) const;
+    
+    // Content of one note for a bulk pass such as a search.  Unlike the
+    // summary methods, safe to call from any thread once initialized.
+    [[nodiscard]] NoteContentPtr ReadNoteContent(const std::wstring& id) const {
+        return LoadNoteContent(id, CacheAccess::Scan);
+    }
+    
     // Get pinned note summaries
     [[nodiscard]] std::vector<NoteSummary> GetPinnedNotes() const;
     
-    // Search notes (loads content on demand during search)
+    // Ranked search: words and "quoted phrases", all required.  Content is
+    // read only for the results returned (and every match if 'matchCase').
+    // Brings the index up to date on this thread first.
     [[nodiscard]] std::vector<NoteSearchResult> SearchNotes(const std::wstring& query, 
-                                                            bool matchCase = false) const;
+                                                            bool matchCase = false,
+                                                            size_t limit = SEARCH_RESULT_LIMIT) const;
     
-    // Get notes for a specific date (timeline view)
+    // Build the search index on 'scheduler' and keep it up to date there as
+    // notes change.  Call once, after Initialize().
+    void StartSearchIndex(TaskScheduler& scheduler);
+    
+    // SearchNotes() from any thread, using the index as it is: up to 'limit'
+    // notes, best first, with the text around each match.  False until the
+    // index holds every note.
+    [[nodiscard]] bool SearchIndexed(const std::wstring& query, size_t limit,
+                                     std::vector<NoteRankedHit>& hits) const;
+    
+    // Get notes for a specific date (timeline view), newest first
     [[nodiscard]] std::vector<NoteSummary> GetNotesForDate(int year, int month, int day) const;
     
-    // Get unique dates that have notes (for timeline)
+    // Get notes created in a calendar month, newest first
+    [[nodiscard]] std::vector<NoteSummary> GetNotesForMonth(int year, int month) const;
+    
+    // Get notes created in [from, to)
+    [[nodiscard]] std::vector<NoteSummary> GetNotesInRange(time_t from, time_t to,
+                                                           bool newestFirst = true) const;
+    
+    // Get unique dates that have notes (for timeline), most recent first
     [[nodiscard]] std::vector<time_t> GetNoteDates() const;
     
     // Get the current "active" note (the one being edited in main window)
@@ -137,37 +214,73 @@ public:
     // Get note count
     [[nodiscard]] size_t GetNoteCount() const { return m_notes.size(); }
     
-    // Force save (normally auto-saved)
+    // Queue the index for saving if it changed (normally auto-saved)
     [[nodiscard]] bool Save();
     
-    // Export all notes to a file
+    // Save, then wait until every change made so far is on disk
+    [[nodiscard]] bool Flush();
+    
+    // Save and write everything still queued; later changes are written
+    // on the calling thread.  Also done on destruction.
+    void Shutdown();
+    
+    // Export all notes to a file, streamed one note at a time
     [[nodiscard]] bool ExportNotes(const std::wstring& filePath);
     
-    // Import notes from a file (merges with existing)
-    [[nodiscard]] bool ImportNotes(const std::wstring& filePath);
+    // Import notes from a file (merges with existing), streamed one note at
+    // a time.  Content is written in batches as it is read; notes read
+    // before a malformed part of the file are kept and counted.
+    [[nodiscard]] NoteImportResult ImportNotes(const std::wstring& filePath);
     
     // Get the store directory path
     [[nodiscard]] const std::wstring& GetStorePath() const { return m_storePath; }
     
+    // Content cache hit/miss counters and memory use
+    [[nodiscard]] NoteContentCacheStats GetContentCacheStats() const { return m_contentCache.GetStats(); }
+    
+    // Background writer progress: queued vs. flushed generation, coalescing,
+    // skipped updates and write amplification
+    [[nodiscard]] NoteWriteQueueStats GetWriteQueueStats() const { return m_writeQueue.GetStats(); }
+    
 private:
     // Load note index from JSON file (metadata only)
     [[nodiscard]] bool LoadFromFile();
     
-    // Save note index to JSON file (metadata only)
-    [[nodiscard]] bool SaveToFile();
+    // Save an index snapshot to JSON file (metadata only).  Runs on the
+    // write queue's thread once it is started.
+    [[nodiscard]] bool SaveToFile(const std::vector<NoteSummary>& notes, uint64_t& indexBytes) const;
     
-    // Load note content from individual file (uses cache)
-    [[nodiscard]] std::wstring LoadNoteContent(const std::wstring& id) const;
+    // Load note content from individual file (uses cache).  Bulk passes over
+    // many notes pass CacheAccess::Scan.
+    [[nodiscard]] NoteContentPtr LoadNoteContent(const std::wstring& id,
+                                                 CacheAccess access = CacheAccess::Normal) const;
     
     // Load note content bypassing cache (direct disk read)
     [[nodiscard]] std::wstring LoadNoteContentFromDisk(const std::wstring& id) const;
     
-    // Save note content to individual file
-    [[nodiscard]] bool SaveNoteContent(const std::wstring& id, const std::wstring& content);
+    // Per-note content files (when packed storage is off)
+    [[nodiscard]] std::wstring ReadContentFile(const std::wstring& id) const;
+    [[nodiscard]] bool WriteContentFile(const std::wstring& id, const std::string& utf8) const;
+    
+    // Open the packed log at the checkpoint read with the index and apply
+    // revisions written after it
+    [[nodiscard]] bool OpenNoteLog(const NoteLogCheckpoint& checkpoint);
     
-    // Delete note content file
+    // Move every note's content into the packed log, or back to per-note files
+    [[nodiscard]] bool ConvertContentStorage(bool toPacked);
+    
+    // Cache note content and queue it for writing.  'previous' (if known)
+    // sizes the edit for the write amplification stats.
+    void SaveNoteContent(const std::wstring& id, const std::wstring& content,
+                         const std::wstring* previous = nullptr);
+    
+    // Drop note content from the cache and queue its deletion
     void DeleteNoteContent(const std::wstring& id);
     
+    // Write or delete (null content) one note's content; called by m_writeQueue
+    [[nodiscard]] bool WriteQueuedContent(const std::wstring& id, const NoteContentPtr& content,
+                                          uint64_t& bytesWritten) const;
+    
     // Get the file path for a note's content
     [[nodiscard]] std::wstring GetNoteContentPath(const std::wstring& id) const;
     
@@ -180,40 +293,80 @@ private:
     // Parse JSON index (metadata only)
     [[nodiscard]] bool ParseJson(const std::wstring& json);
     
-    // Serialize note index to JSON (metadata only)
-    [[nodiscard]] std::wstring ToJson() const;
+    // Serialize note index to JSON (metadata only; with packed storage,
+    // also the log checkpoint and each note's record)
+    [[nodiscard]] std::wstring ToJson(const std::vector<NoteSummary>& notes,
+                                      const NoteLogCheckpoint* checkpoint) const;
     
     // Parse legacy JSON format (with embedded content) for migration
     [[nodiscard]] bool ParseLegacyJson(const std::wstring& json,
                                         std::vector<Note>& outNotes) const;
     
-    // Serialize notes with content to JSON (for export)
-    [[nodiscard]] std::wstring ToFullJson(const std::vector<Note>& notes) const;
-    
     // Escape string for JSON
     [[nodiscard]] static std::wstring JsonEscape(const std::wstring& str);
     
     // Unescape JSON string
     [[nodiscard]] static std::wstring JsonUnescape(const std::wstring& str);
     
+    // Add or remove a summary, keeping m_timeline and m_sortIndex in step
+    void AddSummary(NoteSummary summary);
+    void RemoveSummary(std::vector<NoteSummary>::iterator it);
+    void ClearSummaries();
+    
+    // Bracket changes to a summary's title or updatedAt
+    void DetachSortKeys(const NoteSummary& summary);
+    void AttachSortKeys(const NoteSummary& summary);
+    
+    // Search index upkeep.  Changes are queued in order and applied by
+    // one drain at a time, either a task on m_searchScheduler or
+    // SearchNotes() itself.
+    struct SearchIndexWork {
+        enum class Kind { Set, Remove, Clear };
+        Kind kind = Kind::Set;
+        std::wstring id;
+        std::wstring title;
+        time_t createdAt = 0;
+    };
+    
+    // Shared with a queued index task, which may outlive this object: it
+    // drains only if its token is still live, checked under 'mutex'
+    struct SearchIndexGate {
+        std::mutex mutex;
+        std::condition_variable idle;
+        CancellationToken token;
+        size_t running = 0;
+    };
+    
+    void TrackSearchIndex() const;
+    void MarkSearchStale(const NoteSummary& summary, bool removed = false);
+    void QueueSearchIndexTask() const;
+    void DrainSearchIndex(const CancellationToken& token, bool fromTask) const;
+    void StopSearchIndex() noexcept;
+    
     // Apply filter and sort to note summaries
     [[nodiscard]] std::vector<NoteSummary> FilterAndSort(const NoteFilter& filter) const;
+    [[nodiscard]] std::vector<size_t> FilterSlots(const NoteFilter& filter) const;
     
     // Case-insensitive string search
     [[nodiscard]] static size_t FindCaseInsensitive(const std::wstring& haystack, 
                                                     const std::wstring& needle,
                                                     size_t startPos = 0);
     
+    // Content digest stored in NoteSummary::contentHash
+    [[nodiscard]] static uint64_t HashContent(const std::wstring& content) noexcept;
+    
+    // Size of the edit between two revisions of a note
+    [[nodiscard]] static uint64_t ChangedBytes(const std::wstring& before, const std::wstring& after);
+    
     // Generate a content preview from full content
     [[nodiscard]] static std::wstring MakeContentPreview(const std::wstring& content,
                                                          size_t maxLen = PREVIEW_LENGTH);
     
-    // Update cached content and invalidate stale entry
-    void CacheContent(const std::wstring& id, const std::wstring& content) const;
-    void InvalidateCache(const std::wstring& id) const;
-    
 private:
     std::vector<NoteSummary> m_notes;      // Only metadata in RAM
+    NoteTimeline m_timeline;               // m_notes slots by creation time
+    NoteSortIndex m_sortIndex;             // m_notes slots by update time and title
+    uint64_t m_layoutVersion = 0;          // Bumped when m_notes slots change
     std::wstring m_storeDir;               // Base directory (AppData/QNote)
     std::wstring m_notesDir;               // Per-note content directory (AppData/QNote/notes)
     std::wstring m_storePath;              // Index file path (notes_index.json)
@@ -221,17 +374,37 @@ private:
     std::wstring m_activeNoteId;
     bool m_dirty = false;
     
-    // LRU content cache: avoids redundant disk reads for recently-accessed notes
-    // Key = note id, Value = full content string
-    // m_cacheOrder front = most recently used, back = least recently used
-    mutable std::list<std::wstring> m_cacheOrder;  // LRU order (note ids)
-    mutable std::unordered_map<std::wstring, 
-        std::pair<std::list<std::wstring>::iterator, std::wstring>> m_contentCache;
+    // Packed storage
+    std::unique_ptr<NoteLog> m_log;        // Open when contents live in the log
+    std::wstring m_logDir;                 // AppData/QNote/notelog
+    bool m_packedStorage = false;          // Requested layout
+    bool m_indexIsPacked = false;          // Layout of the index file that was loaded
+    NoteLogCheckpoint m_indexCheckpoint;   // Read with the index, used until the log is open
+    
+    // Content cache: avoids redundant disk reads for recently-accessed notes
+    mutable NoteContentCache m_contentCache;
+    
+    // Word index for ranked search, built by StartSearchIndex() or the
+    // first SearchNotes().  m_searchMutex guards the index and its queue;
+    // m_searchDrainMutex is held while queued work is applied.
+    mutable std::mutex m_searchMutex;
+    mutable NoteSearchIndex m_searchIndex;
+    mutable bool m_searchIndexBuilt = false;          // Holds every note
+    mutable std::deque<SearchIndexWork> m_searchIndexPending;
+    mutable bool m_searchIndexTaskQueued = false;
+    mutable std::mutex m_searchDrainMutex;
+    mutable bool m_searchIndexTracked = false;        // UI thread: changes are queued
+    TaskScheduler* m_searchScheduler = nullptr;
+    std::shared_ptr<SearchIndexGate> m_searchGate;
+    
+    // Content and index writes, off the UI thread
+    NoteWriteQueue m_writeQueue;
     
     // Auto-save timer related
     static constexpr DWORD AUTOSAVE_INTERVAL_MS = 3000;  // 3 seconds
-    static constexpr size_t MAX_CACHE_ENTRIES = 32;       // Max cached note contents
     static constexpr size_t PREVIEW_LENGTH = 200;         // Chars stored in contentPreview
+    static constexpr size_t SEARCH_RESULT_LIMIT = 100;    // Default SearchNotes() result count
+    static constexpr uint64_t IMPORT_BATCH_BYTES = 16 << 20;  // Imported content written per flush
 };
 
 //------------------------------------------------------------------------------
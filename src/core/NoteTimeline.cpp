@@ -0,0 +1,74 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteTimeline.cpp - Creation-date index over the note store's summaries
+//==============================================================================
+
+#include "NoteTimeline.h"
+
+namespace QNote {
+
+void NoteTimeline::Clear() {
+    m_entries.clear();
+    m_days.clear();
+}
+
+void NoteTimeline::Insert(time_t createdAt, time_t day, const std::wstring& id, size_t slot) {
+    auto [it, inserted] = m_entries.try_emplace(Key(createdAt, id));
+    if (!inserted) {
+        // Already indexed (duplicate id): keep the day counts right
+        if (--m_days[it->second.day] == 0) {
+            m_days.erase(it->second.day);
+        }
+    }
+    it->second.slot = slot;
+    it->second.day = day;
+    m_days[day]++;
+}
+
+void NoteTimeline::Erase(time_t createdAt, const std::wstring& id) {
+    auto it = m_entries.find(Key(createdAt, id));
+    if (it == m_entries.end()) return;
+
+    auto day = m_days.find(it->second.day);
+    if (day != m_days.end() && --day->second == 0) {
+        m_days.erase(day);
+    }
+    m_entries.erase(it);
+}
+
+void NoteTimeline::Move(time_t createdAt, const std::wstring& id, size_t slot) {
+    auto it = m_entries.find(Key(createdAt, id));
+    if (it != m_entries.end()) {
+        it->second.slot = slot;
+    }
+}
+
+bool NoteTimeline::Find(time_t createdAt, const std::wstring& id, size_t& slot) const {
+    auto it = m_entries.find(Key(createdAt, id));
+    if (it == m_entries.end()) return false;
+
+    slot = it->second.slot;
+    return true;
+}
+
+void NoteTimeline::Range(time_t from, time_t to, std::vector<size_t>& slots) const {
+    if (from >= to) return;
+
+    // The empty id sorts before every other id with the same time
+    auto first = m_entries.lower_bound(Key(from, std::wstring()));
+    auto last = m_entries.lower_bound(Key(to, std::wstring()));
+    for (auto it = first; it != last; ++it) {
+        slots.push_back(it->second.slot);
+    }
+}
+
+std::vector<time_t> NoteTimeline::GetDays() const {
+    std::vector<time_t> days;
+    days.reserve(m_days.size());
+    for (auto it = m_days.rbegin(); it != m_days.rend(); ++it) {
+        days.push_back(it->first);
+    }
+    return days;
+}
+
+} // namespace QNote
@@ -0,0 +1,60 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteTimeline.h - Creation-date index over the note store's summaries
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <cstddef>
+#include <ctime>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Notes ordered by creation time, each pointing at its slot in the owner's
+// summary vector, plus a count of notes per local day.  Range queries cost
+// O(log n + k); the list of days costs O(days).
+//
+// Day starts are supplied by the caller, so the index itself does no time
+// zone conversion.  Not thread-safe; the note store uses it on one thread.
+//------------------------------------------------------------------------------
+class NoteTimeline {
+public:
+    void Clear();
+
+    // 'day' is the start of the local day containing 'createdAt'
+    void Insert(time_t createdAt, time_t day, const std::wstring& id, size_t slot);
+    void Erase(time_t createdAt, const std::wstring& id);
+
+    // The note now lives in another slot
+    void Move(time_t createdAt, const std::wstring& id, size_t slot);
+
+    // Slot of a note, if indexed
+    [[nodiscard]] bool Find(time_t createdAt, const std::wstring& id, size_t& slot) const;
+
+    // Slots of notes created in [from, to), oldest first
+    void Range(time_t from, time_t to, std::vector<size_t>& slots) const;
+
+    // Start of every day with at least one note, most recent first
+    [[nodiscard]] std::vector<time_t> GetDays() const;
+
+    [[nodiscard]] size_t GetCount() const noexcept { return m_entries.size(); }
+
+private:
+    using Key = std::pair<time_t, std::wstring>;   // createdAt, id
+
+    struct Entry {
+        size_t slot = 0;
+        time_t day = 0;
+    };
+
+    std::map<Key, Entry> m_entries;
+    std::map<time_t, size_t> m_days;               // Day start -> notes created that day
+};
+
+} // namespace QNote
@@ -0,0 +1,326 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteWriteQueue.cpp - Background writer for note contents and the note index
+//==============================================================================
+
+#include "NoteWriteQueue.h"
+#include "Trace.h"
+#include <algorithm>
+#include <system_error>
+#include <vector>
+
+namespace QNote {
+
+NoteWriteQueue::NoteWriteQueue(ContentWriter contentWriter)
+    : m_contentWriter(std::move(contentWriter)) {
+}
+
+NoteWriteQueue::~NoteWriteQueue() {
+    Stop();
+}
+
+void NoteWriteQueue::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return;
+
+    m_running = true;
+    m_stopping = false;
+    try {
+        m_writer = std::thread(&NoteWriteQueue::WriterMain, this);
+    } catch (const std::system_error&) {
+        // Keep writing on the calling thread
+        m_running = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Drain and stop.  Requests that still fail on this last attempt are kept
+// and written by the next Flush() or Start().
+//------------------------------------------------------------------------------
+void NoteWriteQueue::Stop() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_stopping = true;
+    }
+    m_wakeWriter.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+    m_stopping = false;
+    m_passDone.notify_all();
+}
+
+bool NoteWriteQueue::IsRunning() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+//------------------------------------------------------------------------------
+// Queueing.  A request replaces any queued one for the same target but
+// keeps its first generation, which is not flushed until the newer one is.
+//------------------------------------------------------------------------------
+uint64_t NoteWriteQueue::WriteContent(const std::wstring& id, NoteContentPtr content, uint64_t bytesChanged) {
+    if (!content) {
+        content = std::make_shared<const std::wstring>();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.bytesChanged += bytesChanged;
+    }
+    return QueueContent(id, std::move(content));
+}
+
+uint64_t NoteWriteQueue::DeleteContent(const std::wstring& id) {
+    return QueueContent(id, nullptr);
+}
+
+uint64_t NoteWriteQueue::QueueContent(const std::wstring& id, NoteContentPtr content) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t generation = ++m_generation;
+    m_stats.queued++;
+    if (m_pending.empty() && !m_pendingIndex.write) {
+        m_batchStarted = std::chrono::steady_clock::now();
+    }
+
+    auto it = m_pending.find(id);
+    if (it != m_pending.end()) {
+        it->second.content = std::move(content);
+        it->second.generation = generation;
+        m_stats.coalesced++;
+    } else {
+        ContentRequest request;
+        request.content = std::move(content);
+        request.firstGeneration = generation;
+        request.generation = generation;
+        m_pending.emplace(id, std::move(request));
+    }
+
+    NoteQueued(lock);
+    return generation;
+}
+
+uint64_t NoteWriteQueue::WriteIndex(IndexWriter writer) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t generation = ++m_generation;
+    m_stats.queued++;
+    if (m_pending.empty() && !m_pendingIndex.write) {
+        m_batchStarted = std::chrono::steady_clock::now();
+    }
+
+    if (m_pendingIndex.write) {
+        m_stats.coalesced++;
+    } else {
+        m_pendingIndex.firstGeneration = generation;
+    }
+    m_pendingIndex.write = std::move(writer);
+    m_pendingIndex.generation = generation;
+
+    NoteQueued(lock);
+    return generation;
+}
+
+// Wake the writer, or write right away when it is not running
+void NoteWriteQueue::NoteQueued(std::unique_lock<std::mutex>& lock) {
+    if (m_running) {
+        m_wakeWriter.notify_one();
+    } else {
+        (void)RunPass(lock);
+    }
+}
+
+void NoteWriteQueue::RecordUnchanged() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.unchanged++;
+}
+
+void NoteWriteQueue::SetCoalesceDelay(std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_coalesceDelay = delay;
+    m_wakeWriter.notify_one();
+}
+
+//------------------------------------------------------------------------------
+// Readers check here before going to disk, which may still hold an older
+// revision
+//------------------------------------------------------------------------------
+bool NoteWriteQueue::FindPending(const std::wstring& id, NoteContentPtr& content) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) {
+        it = m_writing.find(id);
+        if (it == m_writing.end()) return false;
+    }
+    content = it->second.content;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Wait for a pass that starts after this call, or run one here if the
+// writer is not running
+//------------------------------------------------------------------------------
+bool NoteWriteQueue::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t target = m_generation;
+    if (m_flushedGeneration >= target) return true;
+
+    if (!m_running) {
+        (void)RunPass(lock);
+        return m_flushedGeneration >= target;
+    }
+
+    const uint64_t targetPass = m_passesStarted + 1;
+    m_flushThroughPass = std::max(m_flushThroughPass, targetPass);
+    m_wakeWriter.notify_one();
+    m_passDone.wait(lock, [this, target, targetPass]() {
+        return m_flushedGeneration >= target || m_passesFinished >= targetPass || !m_running;
+    });
+    return m_flushedGeneration >= target;
+}
+
+uint64_t NoteWriteQueue::GetFlushedGeneration() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_flushedGeneration;
+}
+
+NoteWriteQueueStats NoteWriteQueue::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    NoteWriteQueueStats stats = m_stats;
+    stats.queuedGeneration = m_generation;
+    stats.flushedGeneration = m_flushedGeneration;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+// Writer loop.  Requests arriving during a pass wait for the next one, so
+// a note edited faster than it can be written costs one write per pass.
+//------------------------------------------------------------------------------
+void NoteWriteQueue::WriterMain() {
+    Trace::SetThreadName("Note writer");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        const bool hasWork = !m_pending.empty() || m_pendingIndex.write;
+
+        if (m_stopping) {
+            // One more attempt at whatever is left, then give up
+            if (!hasWork || !RunPass(lock)) break;
+            continue;
+        }
+
+        if (!hasWork) {
+            m_wakeWriter.wait(lock);
+            continue;
+        }
+        // Let a batch gather, and back off after a failure, unless a
+        // Flush() is waiting
+        auto startAt = std::max(m_retryAt, m_batchStarted + m_coalesceDelay);
+        if (m_passesStarted >= m_flushThroughPass && std::chrono::steady_clock::now() < startAt) {
+            m_wakeWriter.wait_until(lock, startAt);
+            continue;
+        }
+        (void)RunPass(lock);
+    }
+    m_passDone.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Write everything queued, contents first.  The index waits for the next
+// pass if any content failed.  Called with the lock held; it is released
+// while writing.  Returns false if anything failed.
+//------------------------------------------------------------------------------
+bool NoteWriteQueue::RunPass(std::unique_lock<std::mutex>& lock) {
+    QNOTE_TRACE_SCOPE("NoteWriteQueue::RunPass");
+
+    m_passesStarted++;
+    m_writing.swap(m_pending);
+    std::swap(m_writingIndex, m_pendingIndex);
+    lock.unlock();
+
+    // m_writing and m_writingIndex are only changed by the pass, so they
+    // can be read without the lock
+    std::vector<std::wstring> failed;
+    uint64_t contentBytes = 0;
+    uint64_t indexBytes = 0;
+    for (const auto& [id, request] : m_writing) {
+        bool written = false;
+        uint64_t bytes = 0;
+        try {
+            written = m_contentWriter(id, request.content, bytes);
+        } catch (...) {
+            // Counted as a failure; retried later
+        }
+        contentBytes += bytes;
+        if (!written) {
+            failed.push_back(id);
+        }
+    }
+
+    bool indexWritten = !m_writingIndex.write;
+    if (!indexWritten && failed.empty()) {
+        try {
+            indexWritten = m_writingIndex.write(indexBytes);
+        } catch (...) {
+            // Counted as a failure; retried later
+        }
+    }
+
+    lock.lock();
+
+    // Requeue failures unless a newer request already replaced them
+    for (const auto& id : failed) {
+        ContentRequest& request = m_writing[id];
+        auto it = m_pending.find(id);
+        if (it == m_pending.end()) {
+            m_pending.emplace(id, std::move(request));
+        } else {
+            it->second.firstGeneration = std::min(it->second.firstGeneration, request.firstGeneration);
+        }
+    }
+    if (!indexWritten) {
+        if (!m_pendingIndex.write) {
+            m_pendingIndex = std::move(m_writingIndex);
+        } else {
+            m_pendingIndex.firstGeneration =
+                std::min(m_pendingIndex.firstGeneration, m_writingIndex.firstGeneration);
+        }
+    }
+
+    const size_t attempted = m_writing.size() + (m_writingIndex.write ? 1 : 0);
+    const size_t failures = failed.size() + (indexWritten ? 0 : 1);
+    m_writing.clear();
+    m_writingIndex = IndexRequest();
+
+    m_stats.written += attempted - failures;
+    m_stats.contentBytesWritten += contentBytes;
+    m_stats.indexBytesWritten += indexBytes;
+    m_stats.failed += failures;
+    m_stats.passes++;
+    if (failures > 0) {
+        m_retryAt = std::chrono::steady_clock::now() + RETRY_DELAY;
+    }
+
+    UpdateFlushedGeneration();
+    m_passesFinished++;
+    m_passDone.notify_all();
+    return failures == 0;
+}
+
+// Everything before the oldest generation still queued is flushed
+// (m_mutex held)
+void NoteWriteQueue::UpdateFlushedGeneration() {
+    uint64_t oldest = m_generation + 1;
+    for (const auto& [id, request] : m_pending) {
+        oldest = std::min(oldest, request.firstGeneration);
+    }
+    if (m_pendingIndex.write) {
+        oldest = std::min(oldest, m_pendingIndex.firstGeneration);
+    }
+    m_flushedGeneration = oldest - 1;
+}
+
+} // namespace QNote
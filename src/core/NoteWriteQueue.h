@@ -0,0 +1,146 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteWriteQueue.h - Background writer for note contents and the note index
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include "NoteContentCache.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace QNote {
+
+struct NoteWriteQueueStats {
+    uint64_t queued = 0;           // Requests accepted
+    uint64_t coalesced = 0;        // Replaced by a newer request before being written
+    uint64_t unchanged = 0;        // Updates the caller skipped because nothing changed
+    uint64_t written = 0;          // Content writes, deletes and index writes done
+    uint64_t failed = 0;           // Attempts that failed (retried later)
+    uint64_t passes = 0;
+
+    // Write amplification is (contentBytesWritten + indexBytesWritten) / bytesChanged
+    uint64_t bytesChanged = 0;     // Size of the edited spans, as reported when queued
+    uint64_t contentBytesWritten = 0;
+    uint64_t indexBytesWritten = 0;
+
+    uint64_t queuedGeneration = 0;
+    uint64_t flushedGeneration = 0;
+};
+
+//------------------------------------------------------------------------------
+// Moves note store disk writes off the UI thread.  Every request gets a
+// generation number.  Pending requests are coalesced: only the latest
+// content (or delete) per note id and the latest index snapshot are kept.
+// A writer thread applies them in passes, contents before the index, so the
+// saved index never refers to content that was not written yet.  A pass
+// starts CoalesceDelay after the first request of a batch, so a burst of
+// quick updates costs one write.
+//
+// The flushed generation is the highest N for which every request up to N
+// has been written (or replaced by a later request that has).  Failed
+// writes stay queued and are retried after RETRY_DELAY.
+//------------------------------------------------------------------------------
+class NoteWriteQueue {
+public:
+    // Write or delete (null content) one note's content and report the
+    // bytes written; true on success
+    using ContentWriter = std::function<bool(const std::wstring& id, const NoteContentPtr& content,
+                                             uint64_t& bytesWritten)>;
+
+    // Write an index snapshot captured when it was queued; true on success
+    using IndexWriter = std::function<bool(uint64_t& bytesWritten)>;
+
+    explicit NoteWriteQueue(ContentWriter contentWriter);
+    ~NoteWriteQueue();
+
+    NoteWriteQueue(const NoteWriteQueue&) = delete;
+    NoteWriteQueue& operator=(const NoteWriteQueue&) = delete;
+
+    // Start the writer thread.  Until then, and after Stop(), requests are
+    // written on the calling thread; ones that fail stay queued.
+    void Start();
+
+    // Write everything still queued, then stop the writer thread
+    void Stop() noexcept;
+
+    [[nodiscard]] bool IsRunning() const;
+
+    // Queue requests; each returns its generation.  'bytesChanged' is the
+    // size of the edit that made the write necessary.
+    uint64_t WriteContent(const std::wstring& id, NoteContentPtr content, uint64_t bytesChanged);
+    uint64_t DeleteContent(const std::wstring& id);
+    uint64_t WriteIndex(IndexWriter writer);
+
+    // Count an update that needed no write
+    void RecordUnchanged();
+
+    // Content queued for 'id' but not yet written.  False if nothing is
+    // queued; true with null 'content' if a delete is.
+    [[nodiscard]] bool FindPending(const std::wstring& id, NoteContentPtr& content) const;
+
+    // Write everything queued so far without waiting for a retry delay
+    // (on the calling thread when the writer is not running).  False if
+    // some of it could not be written.
+    [[nodiscard]] bool Flush();
+
+    [[nodiscard]] uint64_t GetFlushedGeneration() const;
+    [[nodiscard]] NoteWriteQueueStats GetStats() const;
+
+    void SetCoalesceDelay(std::chrono::milliseconds delay);
+
+    static constexpr std::chrono::milliseconds RETRY_DELAY{ 1000 };
+
+private:
+    struct ContentRequest {
+        NoteContentPtr content;        // Null for a delete
+        uint64_t firstGeneration = 0;  // Oldest request it stands for
+        uint64_t generation = 0;
+    };
+
+    struct IndexRequest {
+        IndexWriter write;
+        uint64_t firstGeneration = 0;
+        uint64_t generation = 0;
+    };
+
+    uint64_t QueueContent(const std::wstring& id, NoteContentPtr content);
+    void NoteQueued(std::unique_lock<std::mutex>& lock);
+    void WriterMain();
+    bool RunPass(std::unique_lock<std::mutex>& lock);
+    void UpdateFlushedGeneration();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_passDone;
+    std::thread m_writer;
+    ContentWriter m_contentWriter;
+
+    // Queued requests, and those the current pass is writing
+    std::unordered_map<std::wstring, ContentRequest> m_pending;
+    std::unordered_map<std::wstring, ContentRequest> m_writing;
+    IndexRequest m_pendingIndex;
+    IndexRequest m_writingIndex;
+
+    uint64_t m_generation = 0;
+    uint64_t m_flushedGeneration = 0;
+    uint64_t m_passesStarted = 0;
+    uint64_t m_passesFinished = 0;
+    uint64_t m_flushThroughPass = 0;       // Passes up to this one skip the retry delay
+    std::chrono::steady_clock::time_point m_batchStarted;
+    std::chrono::steady_clock::time_point m_retryAt;
+    std::chrono::milliseconds m_coalesceDelay{ 250 };
+    bool m_running = false;
+    bool m_stopping = false;
+
+    NoteWriteQueueStats m_stats;
+};
+
+} // namespace QNote
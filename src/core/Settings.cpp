@@ -133,6 +133,8 @@ bool SettingsManager::Load() {
     m_settings.rightToLeft = ParseBool(L"Editor", L"RightToLeft", false);
     m_settings.scrollLines = ParseInt(L"Editor", L"ScrollLines", 0);
     m_settings.autoCompleteBraces = ParseBool(L"Editor", L"AutoCompleteBraces", true);
+    m_settings.largeFileViewerMB = ParseInt(L"Editor", L"LargeFileViewerMB", 256);
+    m_settings.lineIndexCache = ParseBool(L"Editor", L"LineIndexCache", true);
     
     // Validate zoom level (25-500%)
     if (m_settings.zoomLevel < 25) m_settings.zoomLevel = 25;
@@ -146,6 +148,11 @@ bool SettingsManager::Load() {
     if (m_settings.scrollLines < 0) m_settings.scrollLines = 0;
     if (m_settings.scrollLines > 20) m_settings.scrollLines = 20;
     
+    // Validate large file viewer threshold (0 = never, otherwise 16 MB-1 TB)
+    if (m_settings.largeFileViewerMB < 0) m_settings.largeFileViewerMB = 0;
+    if (m_settings.largeFileViewerMB > 0 && m_settings.largeFileViewerMB < 16) m_settings.largeFileViewerMB = 16;
+    if (m_settings.largeFileViewerMB > 1024 * 1024) m_settings.largeFileViewerMB = 1024 * 1024;
+    
     // Encoding section
     std::wstring encodingStr = ParseString(L"Encoding", L"Default", L"UTF8");
     m_settings.defaultEncoding = StringToEncoding(encodingStr);
@@ -167,6 +174,9 @@ bool SettingsManager::Load() {
     if (m_settings.autoSaveDelayMs < 1000) m_settings.autoSaveDelayMs = 1000;
     if (m_settings.autoSaveDelayMs > 60000) m_settings.autoSaveDelayMs = 60000;
     
+    // Notes section
+    m_settings.notePackedStorage = ParseBool(L"Notes", L"PackedStorage", false);
+    
     // View state
     m_settings.alwaysOnTop = ParseBool(L"View", L"AlwaysOnTop", false);
     m_settings.menuBarVisible = ParseBool(L"View", L"MenuBarVisible", true);
@@ -241,6 +251,8 @@ bool SettingsManager::Save() {
     WriteBool(L"Editor", L"RightToLeft", m_settings.rightToLeft);
     WriteInt(L"Editor", L"ScrollLines", m_settings.scrollLines);
     WriteBool(L"Editor", L"AutoCompleteBraces", m_settings.autoCompleteBraces);
+    WriteInt(L"Editor", L"LargeFileViewerMB", m_settings.largeFileViewerMB);
+    WriteBool(L"Editor", L"LineIndexCache", m_settings.lineIndexCache);
     
     // Encoding section
     WriteString(L"Encoding", L"Default", EncodingToString(m_settings.defaultEncoding));
@@ -255,6 +267,9 @@ bool SettingsManager::Save() {
     WriteInt(L"Behavior", L"SaveStyle", (m_settings.saveStyle == SaveStyle::AutoSave) ? 1 : 0);
     WriteInt(L"Behavior", L"AutoSaveDelayMs", m_settings.autoSaveDelayMs);
     
+    // Notes section
+    WriteBool(L"Notes", L"PackedStorage", m_settings.notePackedStorage);
+    
     // View state
     WriteBool(L"View", L"AlwaysOnTop", m_settings.alwaysOnTop);
     WriteBool(L"View", L"MenuBarVisible", m_settings.menuBarVisible);
@@ -336,6 +351,10 @@ const wchar_t* EncodingToString(TextEncoding encoding) {
         case TextEncoding::UTF8_BOM:  return L"UTF-8 BOM";
         case TextEncoding::UTF16_LE:  return L"UTF-16 LE";
         case TextEncoding::UTF16_BE:  return L"UTF-16 BE";
+        case TextEncoding::Windows1251: return L"Windows-1251";
+        case TextEncoding::Windows1252: return L"Windows-1252";
+        case TextEncoding::ShiftJIS:  return L"Shift-JIS";
+        case TextEncoding::GB18030:   return L"GB18030";
         default:                      return L"UTF-8";
     }
 }
@@ -359,6 +378,10 @@ TextEncoding StringToEncoding(const std::wstring& str) {
     if (_wcsicmp(str.c_str(), L"UTF-16 LE") == 0) return TextEncoding::UTF16_LE;
     if (_wcsicmp(str.c_str(), L"UTF16BE") == 0) return TextEncoding::UTF16_BE;
     if (_wcsicmp(str.c_str(), L"UTF-16 BE") == 0) return TextEncoding::UTF16_BE;
+    if (_wcsicmp(str.c_str(), L"Windows-1251") == 0) return TextEncoding::Windows1251;
+    if (_wcsicmp(str.c_str(), L"Windows-1252") == 0) return TextEncoding::Windows1252;
+    if (_wcsicmp(str.c_str(), L"Shift-JIS") == 0) return TextEncoding::ShiftJIS;
+    if (_wcsicmp(str.c_str(), L"GB18030") == 0) return TextEncoding::GB18030;
     return TextEncoding::UTF8;
 }
 
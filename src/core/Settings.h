@@ -43,7 +43,11 @@ enum class TextEncoding {
     UTF8,
     UTF8_BOM,
     UTF16_LE,
-    UTF16_BE
+    UTF16_BE,
+    Windows1251,    // Legacy code pages found by the charset detector
+    Windows1252,
+    ShiftJIS,
+    GB18030
 };
 
 //------------------------------------------------------------------------------
@@ -75,6 +79,8 @@ struct AppSettings {
     bool rightToLeft = false;  // Right-to-left reading order
     int scrollLines = 0;          // Lines per scroll wheel notch (0 = system default)
     bool autoCompleteBraces = true;  // Auto-complete braces, brackets, and quotes
+    int largeFileViewerMB = 256;  // Files this large open in the read-only viewer (0 = never)
+    bool lineIndexCache = true;   // Keep viewer line indexes in AppData for fast reopen
     
     // Default encoding for new files
     TextEncoding defaultEncoding = TextEncoding::UTF8;
@@ -89,6 +95,9 @@ struct AppSettings {
     SaveStyle saveStyle = SaveStyle::Manual;  // Manual or AutoSave
     int autoSaveDelayMs = 5000;        // Auto-save delay in milliseconds (1000-60000)
     
+    // Note storage
+    bool notePackedStorage = false;    // Note contents in an append-only log instead of one file each
+    
     // Search settings (persistent across sessions)
     bool searchMatchCase = false;
     bool searchWrapAround = true;
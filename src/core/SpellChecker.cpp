@@ -10,6 +10,7 @@
 #include <spellcheck.h>
 #include <algorithm>
 #include "SpellChecker.h"
+#include "Trace.h"
 
 #pragma comment(lib, "ole32.lib")
 #pragma comment(lib, "oleaut32.lib")
@@ -140,6 +141,7 @@ bool SpellChecker::IgnoreWord(const std::wstring& word) {
 //------------------------------------------------------------------------------
 std::vector<MisspelledWord> SpellChecker::CheckText(const std::wstring& text,
                                                       DWORD baseOffset) const {
+    QNOTE_TRACE_SCOPE("SpellChecker::CheckText");
     std::vector<MisspelledWord> results;
     if (!m_checker || text.empty()) return results;
 
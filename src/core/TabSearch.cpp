@@ -0,0 +1,187 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TabSearch.cpp - Parallel search of the open documents implementation
+//==============================================================================
+
+#include "TabSearch.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+TabSearch::~TabSearch() {
+    Cancel();
+}
+
+//------------------------------------------------------------------------------
+// Compile the pattern and queue one task per document
+//------------------------------------------------------------------------------
+bool TabSearch::Start(std::vector<TabSearchSource> sources, const std::wstring& pattern,
+                      const TextSearchOptions& options, NotifyCallback notify,
+                      std::wstring& errorMessage) {
+    if (m_tasks) {
+        errorMessage = L"A search is already running.";
+        return false;
+    }
+    if (pattern.empty()) {
+        errorMessage = L"Enter text to find.";
+        return false;
+    }
+    if (!m_matcher.Compile(pattern, options)) {
+        errorMessage = L"The regular expression is not valid.";
+        return false;
+    }
+
+    m_sources = std::move(sources);
+    m_notify = std::move(notify);
+    m_tasks = std::make_shared<TaskGroup>();
+    m_token = CancellationToken::Create();
+
+    if (m_sources.empty()) {
+        Publish(TabSearchResult{}, true);
+        return true;
+    }
+
+    // Queued tasks hold the group, not this object: Cancel() closes it
+    m_pendingSources = m_sources.size();
+    size_t queued = 0;
+    for (size_t i = 0; i < m_sources.size(); i++) {
+        auto task = [this, tasks = m_tasks, i]() {
+            tasks->Run([this, i]() { RunSource(i); });
+        };
+        if (!m_scheduler.Submit(task, TaskPriority::High, m_token)) break;
+        queued++;
+    }
+
+    // The scheduler has shut down: what was not queued counts as done
+    size_t missing = m_sources.size() - queued;
+    if (missing > 0 && m_pendingSources.fetch_sub(missing) == missing) {
+        Publish(TabSearchResult{}, true);
+    }
+    if (queued == 0) {
+        errorMessage = L"Could not start the search.";
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Drop the queued documents and wait for the ones being searched.  The
+// search counts as finished, so the window stops waiting for it.
+//------------------------------------------------------------------------------
+void TabSearch::Cancel() noexcept {
+    m_cancel = true;
+    m_token.Cancel();
+    if (m_tasks) {
+        m_tasks->Close();
+    }
+
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    m_finished = true;
+}
+
+//------------------------------------------------------------------------------
+// Results found since the last call
+//------------------------------------------------------------------------------
+std::vector<TabSearchResult> TabSearch::TakeResults() {
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    std::vector<TabSearchResult> results;
+    results.swap(m_results);
+    m_notifyPending = false;
+    return results;
+}
+
+bool TabSearch::IsFinished() const {
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    return m_finished;
+}
+
+TabSearchStats TabSearch::GetStats() const {
+    TabSearchStats stats;
+    stats.documentsSearched = m_searched.load();
+    stats.documentsSkipped = m_skipped.load();
+    std::lock_guard<std::mutex> lock(m_resultMutex);
+    stats.documentsMatched = m_matched;
+    stats.matches = m_matchCount;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+// One document's task; the last one to finish ends the search
+//------------------------------------------------------------------------------
+void TabSearch::RunSource(size_t index) {
+    if (!m_cancel.load()) {
+        try {
+            SearchSource(index);
+        } catch (const std::bad_alloc&) {
+            m_skipped.fetch_add(1);
+        }
+    }
+
+    if (m_pendingSources.fetch_sub(1) == 1) {
+        Publish(TabSearchResult{}, true);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Search one document, reading its content first if it is not in memory
+//------------------------------------------------------------------------------
+void TabSearch::SearchSource(size_t index) {
+    QNOTE_TRACE_SCOPE("TabSearch::SearchSource");
+    TabSearchSource& source = m_sources[index];
+
+    std::shared_ptr<const std::wstring> text = std::move(source.text);
+    if (!text) {
+        std::wstring loaded;
+        if (!source.load || !source.load(loaded)) {
+            m_skipped.fetch_add(1);
+            return;
+        }
+        text = std::make_shared<const std::wstring>(std::move(loaded));
+    }
+
+    TabSearchResult result;
+    result.tabId = source.tabId;
+    result.order = index;
+    result.matchCount = CollectLineHits(m_matcher, *text, MAX_HITS_PER_DOCUMENT, true,
+                                        result.hits, &m_cancel);
+    m_searched.fetch_add(1);
+
+    // Drop the snapshot as soon as it has been searched
+    text.reset();
+    source.load = nullptr;
+
+    if (result.matchCount > 0 && !m_cancel.load()) {
+        result.title = std::move(source.title);
+        Publish(std::move(result), false);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Hand results to the UI; only the first batch after TakeResults() (and the
+// end of the search) notifies
+//------------------------------------------------------------------------------
+void TabSearch::Publish(TabSearchResult&& result, bool finished) {
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(m_resultMutex);
+        if (result.matchCount > 0) {
+            m_matched++;
+            m_matchCount += result.matchCount;
+            m_results.push_back(std::move(result));
+        }
+        if (finished) m_finished = true;
+        if (!m_notifyPending && (finished || !m_results.empty())) {
+            m_notifyPending = true;
+            notify = true;
+        }
+    }
+    if (notify && m_notify) {
+        m_notify();
+    }
+}
+
+} // namespace QNote
@@ -0,0 +1,112 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TabSearch.h - Parallel search of the open documents
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "TaskScheduler.h"
+#include "TextSearch.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// One document to search.  'text' is a snapshot taken on the UI thread; a
+// document whose content has not been read yet has no text and a 'load'
+// function that reads it on the worker instead.
+//------------------------------------------------------------------------------
+struct TabSearchSource {
+    int tabId = -1;
+    std::wstring title;
+    std::shared_ptr<const std::wstring> text;
+    std::function<bool(std::wstring& text)> load;
+};
+
+//------------------------------------------------------------------------------
+// Matches in one document.  'matchCount' counts every match; only the first
+// ones are kept in 'hits'.  'order' is the document's index in the source
+// list, for showing results in tab order.
+//------------------------------------------------------------------------------
+struct TabSearchResult {
+    int tabId = -1;
+    size_t order = 0;
+    std::wstring title;
+    size_t matchCount = 0;
+    std::vector<TextLineHit> hits;
+};
+
+struct TabSearchStats {
+    size_t documentsSearched = 0;
+    size_t documentsMatched = 0;
+    size_t documentsSkipped = 0;           // Content could not be read
+    size_t matches = 0;
+};
+
+//------------------------------------------------------------------------------
+// A running search over document snapshots.  Each document is its own
+// task on the scheduler, so one large document does not hold up the rest.
+// Results are drained with TakeResults(); 'notify' is called on a worker
+// when results are waiting and the previous notification has been
+// consumed, and once more when the search ends.
+//------------------------------------------------------------------------------
+class TabSearch {
+public:
+    using NotifyCallback = std::function<void()>;
+
+    explicit TabSearch(TaskScheduler& scheduler) : m_scheduler(scheduler) {}
+    ~TabSearch();
+
+    TabSearch(const TabSearch&) = delete;
+    TabSearch& operator=(const TabSearch&) = delete;
+
+    // Start searching (once per object); false (with a message) if the pattern is invalid
+    [[nodiscard]] bool Start(std::vector<TabSearchSource> sources, const std::wstring& pattern,
+                             const TextSearchOptions& options, NotifyCallback notify,
+                             std::wstring& errorMessage);
+
+    // Stop the search and wait for the documents being searched
+    void Cancel() noexcept;
+
+    // Results found since the last call (resets the notification)
+    [[nodiscard]] std::vector<TabSearchResult> TakeResults();
+
+    [[nodiscard]] bool IsFinished() const;
+    [[nodiscard]] bool WasCancelled() const noexcept { return m_cancel.load(); }
+    [[nodiscard]] TabSearchStats GetStats() const;
+
+    // Hits kept per document
+    static constexpr size_t MAX_HITS_PER_DOCUMENT = 1000;
+
+private:
+    void RunSource(size_t index);
+    void SearchSource(size_t index);
+    void Publish(TabSearchResult&& result, bool finished);
+
+    TaskScheduler& m_scheduler;
+    std::shared_ptr<TaskGroup> m_tasks;
+    CancellationToken m_token;
+    std::vector<TabSearchSource> m_sources;
+    TextMatcher m_matcher;
+    std::atomic<size_t> m_pendingSources{ 0 };     // Not yet searched or skipped
+    std::atomic<size_t> m_searched{ 0 };
+    std::atomic<size_t> m_skipped{ 0 };
+    std::atomic<bool> m_cancel{ false };
+
+    // Guarded by m_resultMutex
+    mutable std::mutex m_resultMutex;
+    std::vector<TabSearchResult> m_results;
+    size_t m_matched = 0;
+    size_t m_matchCount = 0;
+    bool m_notifyPending = false;
+    bool m_finished = false;
+    NotifyCallback m_notify;
+};
+
+} // namespace QNote
@@ -0,0 +1,349 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TaskScheduler.cpp - Application-wide worker pool implementation
+//==============================================================================
+
+#include "TaskScheduler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <exception>
+#include <system_error>
+
+namespace QNote {
+
+namespace {
+
+// The scheduler and queue index of the current worker thread, if any
+struct WorkerIdentity {
+    const TaskScheduler* scheduler = nullptr;
+    size_t index = 0;
+};
+thread_local WorkerIdentity t_worker;
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Create the worker queues; the workers themselves wait for the first task
+//------------------------------------------------------------------------------
+TaskScheduler::TaskScheduler(size_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 16);
+    }
+
+    // Every queue exists before the first worker can look for work
+    for (size_t i = 0; i < workerCount; i++) {
+        m_local.push_back(std::make_unique<TaskQueues>());
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    Shutdown();
+}
+
+//------------------------------------------------------------------------------
+// Queue a task: on the current worker's own queue, or the shared one
+//------------------------------------------------------------------------------
+bool TaskScheduler::Submit(Task task, TaskPriority priority, CancellationToken token) {
+    if (!task || m_stopping.load()) return false;
+
+    if (!m_started.load(std::memory_order_acquire)) {
+        StartWorkers();
+    }
+    if (m_workers.empty()) {
+        QueuedTask inlineTask{ std::move(task), std::move(token) };
+        m_outstanding.fetch_add(1);
+        RunTask(inlineTask);
+        return true;
+    }
+
+    TaskQueues& target = (t_worker.scheduler == this) ? *m_local[t_worker.index] : m_shared;
+    size_t level = static_cast<size_t>(priority);
+
+    m_outstanding.fetch_add(1);
+    {
+        // Checked again under the queue lock: Shutdown() sets m_stopping
+        // before it clears the queues, so a task pushed here is either
+        // refused or dropped by it, never left queued with no workers
+        std::lock_guard<std::mutex> lock(target.mutex);
+        if (m_stopping.load()) {
+            FinishTask();
+            return false;
+        }
+        target.queues[level].push_back(QueuedTask{ std::move(task), std::move(token) });
+        m_queued.fetch_add(1);
+    }
+
+    // A worker that saw no work holds m_sleepMutex until it waits, so
+    // taking it here means the notification cannot be missed
+    if (m_sleepers.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wakeWorkers.notify_one();
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Start every worker, once.  Not after Shutdown(), which holds m_startMutex
+// while it joins.
+//------------------------------------------------------------------------------
+void TaskScheduler::StartWorkers() {
+    std::lock_guard<std::mutex> lock(m_startMutex);
+    if (m_started.load() || m_stopping.load()) return;
+
+    try {
+        for (size_t i = 0; i < m_local.size(); i++) {
+            m_workers.emplace_back(&TaskScheduler::WorkerMain, this, i);
+        }
+    } catch (const std::system_error&) {
+        // Run with the workers that did start; with none, Submit() runs
+        // tasks on the calling thread
+    }
+    m_started.store(true, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Queue a continuation for the UI thread; wake it if it is not already due
+// to drain the queue
+//------------------------------------------------------------------------------
+void TaskScheduler::PostToUi(Task continuation, CancellationToken token) {
+    if (!continuation) return;
+
+    WakeCallback wake;
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        m_uiQueue.push_back(QueuedTask{ std::move(continuation), std::move(token) });
+        if (!m_uiWakePending && m_uiWake) {
+            m_uiWakePending = true;
+            wake = m_uiWake;
+        }
+    }
+    if (wake) {
+        wake();
+    }
+}
+
+void TaskScheduler::SetUiWakeCallback(WakeCallback wake) {
+    bool wakeNow = false;
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        m_uiWake = std::move(wake);
+        m_uiWakePending = false;
+        if (m_uiWake && !m_uiQueue.empty()) {
+            m_uiWakePending = true;
+            wakeNow = true;
+        }
+    }
+    if (wakeNow) {
+        m_uiWake();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Run the queued continuations.  Ones posted meanwhile wait for the next
+// wake, so a continuation that posts another cannot starve the UI.
+//------------------------------------------------------------------------------
+size_t TaskScheduler::RunUiContinuations() {
+    std::vector<QueuedTask> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        batch.swap(m_uiQueue);
+        m_uiWakePending = false;
+    }
+
+    size_t ran = 0;
+    for (auto& continuation : batch) {
+        if (continuation.token.IsCancelled()) continue;
+        continuation.run();
+        ran++;
+    }
+    return ran;
+}
+
+//------------------------------------------------------------------------------
+// Block until nothing is queued or running
+//------------------------------------------------------------------------------
+void TaskScheduler::WaitIdle() {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_idle.wait(lock, [this]() { return m_outstanding.load() == 0; });
+}
+
+//------------------------------------------------------------------------------
+// Fork/join over 'count' items.  Items are claimed from a shared counter by
+// the caller and by up to one helper task per worker; helpers that start
+// after the last item was claimed return at once.  The loop state is
+// shared, as a helper may still be queued when this returns.
+//------------------------------------------------------------------------------
+void TaskScheduler::ParallelFor(size_t count, const std::function<void(size_t)>& body,
+                                TaskPriority priority) {
+    if (count == 0) return;
+
+    struct Loop {
+        const std::function<void(size_t)>* body = nullptr;
+        size_t count = 0;
+        std::atomic<size_t> next{ 0 };
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t finished = 0;               // Guarded by mutex
+        std::exception_ptr error;          // Guarded by mutex
+
+        void Run() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                std::exception_ptr thrown;
+                try {
+                    (*body)(i);
+                } catch (...) {
+                    thrown = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (thrown && !error) error = thrown;
+                if (++finished == count) done.notify_all();
+            }
+        }
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->body = &body;
+    loop->count = count;
+
+    const size_t helpers = (std::min)(count - 1, m_local.size());
+    for (size_t i = 0; i < helpers; i++) {
+        if (!Submit([loop]() { loop->Run(); }, priority)) break;
+    }
+    loop->Run();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&loop]() { return loop->finished == loop->count; });
+    if (loop->error) std::rethrow_exception(loop->error);
+}
+
+//------------------------------------------------------------------------------
+// Stop the workers, then drop whatever is still queued
+//------------------------------------------------------------------------------
+void TaskScheduler::Shutdown() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeWorkers.notify_all();
+
+    {
+        std::lock_guard<std::mutex> lock(m_startMutex);
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    size_t dropped = 0;
+    auto clearQueues = [&dropped](TaskQueues& queues) {
+        std::lock_guard<std::mutex> lock(queues.mutex);
+        for (auto& queue : queues.queues) {
+            dropped += queue.size();
+            queue.clear();
+        }
+    };
+    clearQueues(m_shared);
+    for (auto& local : m_local) {
+        clearQueues(*local);
+    }
+    m_queued -= dropped;
+    for (size_t i = 0; i < dropped; i++) {
+        FinishTask();
+    }
+
+    std::lock_guard<std::mutex> lock(m_uiMutex);
+    m_uiQueue.clear();
+    m_uiWake = nullptr;
+}
+
+bool TaskScheduler::IsWorkerThread() const noexcept {
+    return t_worker.scheduler == this;
+}
+
+//------------------------------------------------------------------------------
+// Worker loop: run tasks until shutdown, sleeping while there are none
+//------------------------------------------------------------------------------
+void TaskScheduler::WorkerMain(size_t index) {
+    t_worker.scheduler = this;
+    t_worker.index = index;
+    Trace::SetThreadName("Task worker");
+
+    QueuedTask task;
+    while (!m_stopping.load()) {
+        if (TryTakeTask(index, task)) {
+            RunTask(task);
+            task = QueuedTask{};
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepers.fetch_add(1);
+        m_wakeWorkers.wait(lock, [this]() { return m_stopping.load() || m_queued.load() > 0; });
+        m_sleepers.fetch_sub(1);
+    }
+
+    t_worker = WorkerIdentity{};
+}
+
+//------------------------------------------------------------------------------
+// Most urgent task first.  Within a priority: newest on the worker's own
+// queue, then oldest on the shared queue, then oldest on another worker's.
+//------------------------------------------------------------------------------
+bool TaskScheduler::TryTakeTask(size_t index, QueuedTask& task) {
+    if (m_queued.load() == 0) return false;
+
+    const size_t workerCount = m_local.size();
+    for (size_t level = 0; level < PRIORITY_COUNT; level++) {
+        {
+            TaskQueues& own = *m_local[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            auto& queue = own.queues[level];
+            if (!queue.empty()) {
+                task = std::move(queue.back());
+                queue.pop_back();
+                m_queued.fetch_sub(1);
+                return true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_shared.mutex);
+            auto& queue = m_shared.queues[level];
+            if (!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                m_queued.fetch_sub(1);
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < workerCount; offset++) {
+            TaskQueues& victim = *m_local[(index + offset) % workerCount];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            auto& queue = victim.queues[level];
+            if (!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                m_queued.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::RunTask(QueuedTask& task) {
+    if (!task.token.IsCancelled()) {
+        try {
+            task.run();
+        } catch (...) {
+            // A failing task must not take its worker down with it
+        }
+    }
+    FinishTask();
+}
+
+void TaskScheduler::FinishTask() noexcept {
+    if (m_outstanding.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idle.notify_all();
+    }
+}
+
+} // namespace QNote
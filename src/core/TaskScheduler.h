@@ -0,0 +1,209 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TaskScheduler.h - Application-wide worker pool with UI continuations
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Task priority.  Workers always take the most urgent task they can find.
+//------------------------------------------------------------------------------
+enum class TaskPriority {
+    High = 0,       // The user is waiting for it (opening a file, a search)
+    Normal = 1,
+    Low = 2         // Housekeeping (prefetch, indexing, cleanup)
+};
+
+//------------------------------------------------------------------------------
+// Shared cancellation flag.  Copies refer to the same flag.  A default
+// constructed token can never be cancelled and allocates nothing; use
+// Create() for one that can.
+//------------------------------------------------------------------------------
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    [[nodiscard]] static CancellationToken Create() {
+        CancellationToken token;
+        token.m_state = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void Cancel() const noexcept {
+        if (m_state) m_state->store(true, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool IsCancelled() const noexcept {
+        return m_state && m_state->load(std::memory_order_acquire);
+    }
+
+    // For APIs that poll a plain flag; null for a token that cannot be cancelled
+    [[nodiscard]] const std::atomic<bool>* Flag() const noexcept { return m_state.get(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_state;
+};
+
+//------------------------------------------------------------------------------
+// Work-stealing thread pool.  Tasks submitted from a worker go to that
+// worker's own queue (newest first, while its data is still in cache);
+// tasks from other threads go to a shared queue.  An idle worker takes
+// from its own queue, then the shared queue, then steals the oldest task
+// of another worker, one priority level at a time.  Cancelled tasks are
+// dropped without running.
+//
+// The workers are started by the first Submit(), so a scheduler nothing
+// submits to costs no threads.
+//
+// Continuations for the UI thread are queued with PostToUi().  The first
+// continuation after each RunUiContinuations() calls the wake callback,
+// which on Windows posts a message to the main window whose handler calls
+// RunUiContinuations(); without a wake callback the owner drains the
+// queue itself.
+//------------------------------------------------------------------------------
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+    using WakeCallback = std::function<void()>;
+
+    // workerCount 0 picks one per hardware thread (2 to 16)
+    explicit TaskScheduler(size_t workerCount = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Queue a task; false once the scheduler has been shut down
+    bool Submit(Task task, TaskPriority priority = TaskPriority::Normal,
+                CancellationToken token = {});
+
+    // Queue a continuation for the UI thread (any thread may call this)
+    void PostToUi(Task continuation, CancellationToken token = {});
+    void SetUiWakeCallback(WakeCallback wake);
+
+    // Run the continuations queued so far, on the calling (UI) thread.
+    // Returns how many ran.
+    size_t RunUiContinuations();
+
+    // Block until every submitted task has run or been dropped.  Not for
+    // use from a task.
+    void WaitIdle();
+
+    // Run body(0) .. body(count - 1) on the workers and the calling thread,
+    // returning when every call has finished.  The caller takes items like
+    // the workers do, so it never waits for a task that has not started:
+    // this may be called from a task, and after Shutdown() the caller runs
+    // them all.  The first exception thrown by 'body' is rethrown here.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body,
+                     TaskPriority priority = TaskPriority::Normal);
+
+    // Drop queued tasks and continuations and join the workers; tasks
+    // already running finish first.  Called by the destructor.
+    void Shutdown() noexcept;
+
+    // Workers the pool runs once started
+    [[nodiscard]] size_t GetWorkerCount() const noexcept { return m_local.size(); }
+
+    // True on one of this scheduler's worker threads
+    [[nodiscard]] bool IsWorkerThread() const noexcept;
+
+private:
+    static constexpr size_t PRIORITY_COUNT = 3;
+
+    struct QueuedTask {
+        Task run;
+        CancellationToken token;
+    };
+
+    // Per-priority queues, each guarded by its own mutex
+    struct TaskQueues {
+        std::mutex mutex;
+        std::deque<QueuedTask> queues[PRIORITY_COUNT];
+    };
+
+    void StartWorkers();
+    void WorkerMain(size_t index);
+    bool TryTakeTask(size_t index, QueuedTask& task);
+    void RunTask(QueuedTask& task);
+    void FinishTask() noexcept;
+
+    std::vector<std::thread> m_workers;                 // Guarded by m_startMutex
+    std::mutex m_startMutex;
+    std::atomic<bool> m_started{ false };               // m_workers is final
+    std::vector<std::unique_ptr<TaskQueues>> m_local;   // One per worker
+    TaskQueues m_shared;                                // Submitted from outside
+    std::atomic<size_t> m_queued{ 0 };                  // Tasks waiting in any queue
+    std::atomic<size_t> m_outstanding{ 0 };             // Queued or running
+    std::atomic<bool> m_stopping{ false };
+
+    // Sleeping workers
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeWorkers;
+    std::atomic<size_t> m_sleepers{ 0 };
+
+    // WaitIdle()
+    std::mutex m_idleMutex;
+    std::condition_variable m_idle;
+
+    // UI continuations, guarded by m_uiMutex
+    std::mutex m_uiMutex;
+    std::vector<QueuedTask> m_uiQueue;
+    WakeCallback m_uiWake;
+    bool m_uiWakePending = false;
+};
+
+//------------------------------------------------------------------------------
+// Lets an object submit tasks that may still be queued when it goes away.
+// Each task does its work through Run(); Close() refuses any further work
+// and waits for the work already running, so once it returns no task
+// touches the owner.  Tasks hold the group by shared_ptr.
+//------------------------------------------------------------------------------
+class TaskGroup {
+public:
+    // Run 'work' unless the group is closed; false if it did not run
+    template <typename Work>
+    bool Run(Work&& work) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) return false;
+            m_running++;
+        }
+        struct Leave {
+            TaskGroup& group;
+            ~Leave() {
+                std::lock_guard<std::mutex> lock(group.m_mutex);
+                if (--group.m_running == 0) group.m_idle.notify_all();
+            }
+        } leave{ *this };
+        work();
+        return true;
+    }
+
+    // Not from inside Run(), which would wait for itself
+    void Close() noexcept {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_idle.wait(lock, [this]() { return m_running == 0; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    size_t m_running = 0;
+    bool m_closed = false;
+};
+
+} // namespace QNote
@@ -0,0 +1,197 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TextSearch.cpp - Compiled plain-text / regex matcher shared by the searches
+//==============================================================================
+
+#include "TextSearch.h"
+#include <algorithm>
+#include <cwchar>
+#include <cwctype>
+
+namespace QNote {
+
+namespace {
+
+// Longest preview; longer lines are cut around the match
+constexpr size_t MAX_PREVIEW_CHARS = 240;
+constexpr size_t PREVIEW_LEAD_CHARS = 80;
+
+bool IsWordChar(wchar_t ch) noexcept {
+    return ch == L'_' || std::iswalnum(static_cast<wint_t>(ch));
+}
+
+//------------------------------------------------------------------------------
+// Preview text for a hit: the line, or a window of it, with tabs as spaces
+//------------------------------------------------------------------------------
+std::wstring MakePreview(std::wstring_view line, size_t column) {
+    size_t start = 0;
+    size_t length = line.size();
+    if (length > MAX_PREVIEW_CHARS) {
+        start = (column > PREVIEW_LEAD_CHARS) ? column - PREVIEW_LEAD_CHARS : 0;
+        length = std::min(MAX_PREVIEW_CHARS, line.size() - start);
+    }
+    std::wstring preview;
+    preview.reserve(length + 2);
+    if (start > 0) preview += L'\x2026';
+    for (size_t i = start; i < start + length; i++) {
+        preview += (line[i] == L'\t') ? L' ' : line[i];
+    }
+    if (start + length < line.size()) preview += L'\x2026';
+    return preview;
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Compile the pattern.  Whole-word regexes are wrapped in \b...\b; plain
+// whole-word matches are checked at the boundaries instead.
+//------------------------------------------------------------------------------
+bool TextMatcher::Compile(std::wstring_view pattern, const TextSearchOptions& options) {
+    m_options = options;
+    m_pattern.assign(pattern);
+    m_regex.reset();
+    m_valid = false;
+    if (pattern.empty()) return false;
+
+    if (options.useRegex) {
+        std::wstring source = options.wholeWord ? L"\\b(?:" + m_pattern + L")\\b" : m_pattern;
+        std::wregex::flag_type flags = std::regex::ECMAScript;
+        if (!options.matchCase) {
+            flags |= std::regex::icase;
+        }
+        try {
+            m_regex = std::make_shared<const std::wregex>(source, flags);
+        } catch (const std::regex_error&) {
+            return false;
+        }
+    } else if (!options.matchCase) {
+        for (auto& c : m_pattern) c = static_cast<wchar_t>(std::towlower(static_cast<wint_t>(c)));
+    }
+
+    m_firstLower = m_pattern[0];
+    m_firstUpper = options.matchCase ? m_pattern[0]
+                                     : static_cast<wchar_t>(std::towupper(static_cast<wint_t>(m_pattern[0])));
+    m_valid = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Find the next match at or after 'from'
+//------------------------------------------------------------------------------
+bool TextMatcher::FindNext(std::wstring_view text, size_t from, TextMatch& match) const {
+    if (!m_valid || from > text.size()) return false;
+    return m_regex ? FindRegex(text, from, match) : FindPlain(text, from, match);
+}
+
+//------------------------------------------------------------------------------
+// Plain search: scan for the first character (either case) with wmemchr or
+// a two-way compare, then verify the rest
+//------------------------------------------------------------------------------
+bool TextMatcher::FindPlain(std::wstring_view text, size_t from, TextMatch& match) const {
+    const size_t patternLength = m_pattern.size();
+    if (text.size() < patternLength) return false;
+
+    const wchar_t* data = text.data();
+    const size_t last = text.size() - patternLength;   // Last possible start
+    size_t pos = from;
+
+    while (pos <= last) {
+        // Next candidate start
+        if (m_firstLower == m_firstUpper) {
+            const wchar_t* hit = std::wmemchr(data + pos, m_firstLower, last - pos + 1);
+            if (!hit) return false;
+            pos = static_cast<size_t>(hit - data);
+        } else {
+            while (pos <= last && data[pos] != m_firstLower && data[pos] != m_firstUpper) pos++;
+            if (pos > last) return false;
+        }
+
+        bool equal;
+        if (m_options.matchCase) {
+            equal = std::wmemcmp(data + pos + 1, m_pattern.data() + 1, patternLength - 1) == 0;
+        } else {
+            equal = true;
+            for (size_t i = 1; i < patternLength; i++) {
+                if (static_cast<wchar_t>(std::towlower(static_cast<wint_t>(data[pos + i]))) != m_pattern[i]) {
+                    equal = false;
+                    break;
+                }
+            }
+        }
+
+        if (equal && (!m_options.wholeWord || IsWholeWord(text, pos, patternLength))) {
+            match.position = pos;
+            match.length = patternLength;
+            return true;
+        }
+        pos++;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Regex search.  Text before 'from' stays visible to \b and lookbehind-like
+// anchors through match_prev_avail.
+//------------------------------------------------------------------------------
+bool TextMatcher::FindRegex(std::wstring_view text, size_t from, TextMatch& match) const {
+    const wchar_t* begin = text.data();
+    const wchar_t* end = begin + text.size();
+    auto flags = (from > 0) ? std::regex_constants::match_prev_avail
+                            : std::regex_constants::match_default;
+    std::wcmatch result;
+    try {
+        if (!std::regex_search(begin + from, end, result, *m_regex, flags)) return false;
+    } catch (const std::regex_error&) {
+        // Too complex for this input (e.g. stack exhaustion on a huge line)
+        return false;
+    }
+    match.position = from + static_cast<size_t>(result.position(0));
+    match.length = static_cast<size_t>(result.length(0));
+    return true;
+}
+
+bool TextMatcher::IsWholeWord(std::wstring_view text, size_t position, size_t length) const noexcept {
+    if (position > 0 && IsWordChar(text[position - 1])) return false;
+    size_t end = position + length;
+    return end >= text.size() || !IsWordChar(text[end]);
+}
+
+//------------------------------------------------------------------------------
+// Collect line hits.  Line breaks are counted incrementally between
+// matches, so the whole text is scanned once however many matches it has.
+//------------------------------------------------------------------------------
+size_t CollectLineHits(const TextMatcher& matcher, std::wstring_view text, size_t maxHits,
+                       bool countAll, std::vector<TextLineHit>& hits,
+                       const std::atomic<bool>* cancel) {
+    size_t scanned = 0;        // Characters checked for line breaks so far
+    size_t line = 0;
+    size_t lineStart = 0;
+    size_t kept = 0;
+
+    return matcher.ForEachMatch(text, [&](const TextMatch& match) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+        if (kept >= maxHits) return countAll;
+
+        for (; scanned < match.position; scanned++) {
+            wchar_t ch = text[scanned];
+            if (ch == L'\n' || (ch == L'\r' && (scanned + 1 >= text.size() || text[scanned + 1] != L'\n'))) {
+                line++;
+                lineStart = scanned + 1;
+            }
+        }
+
+        size_t lineEnd = text.find_first_of(L"\r\n", match.position);
+        if (lineEnd == std::wstring_view::npos) lineEnd = text.size();
+
+        TextLineHit hit;
+        hit.line = static_cast<uint32_t>(line);
+        hit.column = static_cast<uint32_t>(match.position - lineStart);
+        hit.length = static_cast<uint32_t>(std::min(match.length, lineEnd - match.position));
+        hit.preview = MakePreview(text.substr(lineStart, lineEnd - lineStart), hit.column);
+        hits.push_back(std::move(hit));
+        kept++;
+        return kept < maxHits || countAll;
+    });
+}
+
+} // namespace QNote
@@ -0,0 +1,98 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TextSearch.h - Compiled plain-text / regex matcher shared by the searches
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace QNote {
+
+struct TextSearchOptions {
+    bool matchCase = false;
+    bool wholeWord = false;
+    bool useRegex = false;
+};
+
+struct TextMatch {
+    size_t position = 0;
+    size_t length = 0;
+};
+
+//------------------------------------------------------------------------------
+// A match as shown in a result list.  'line' is 0-based; lines end at LF,
+// CR LF or a lone CR, the way the editor counts them.  'column' and
+// 'length' are in UTF-16 units of the line.  'preview' is the line (or the
+// part of a long line around the match) with tabs shown as spaces.
+//------------------------------------------------------------------------------
+struct TextLineHit {
+    uint32_t line = 0;
+    uint32_t column = 0;
+    uint32_t length = 0;
+    std::wstring preview;
+};
+
+//------------------------------------------------------------------------------
+// A search pattern compiled once and run over many texts.  Const member
+// functions may be called from several threads at the same time, so one
+// matcher can be shared by every worker of a search.
+//------------------------------------------------------------------------------
+class TextMatcher {
+public:
+    // False if the pattern is empty or not a valid regular expression
+    bool Compile(std::wstring_view pattern, const TextSearchOptions& options);
+
+    [[nodiscard]] bool IsValid() const noexcept { return m_valid; }
+    [[nodiscard]] const TextSearchOptions& GetOptions() const noexcept { return m_options; }
+
+    // First match starting at or after 'from'
+    [[nodiscard]] bool FindNext(std::wstring_view text, size_t from, TextMatch& match) const;
+
+    // Call visit(const TextMatch&) for every non-overlapping match, in
+    // order, until it returns false.  Returns the number of matches visited.
+    template <typename Visitor>
+    size_t ForEachMatch(std::wstring_view text, Visitor&& visit) const {
+        size_t count = 0;
+        size_t from = 0;
+        TextMatch match;
+        while (from <= text.size() && FindNext(text, from, match)) {
+            count++;
+            if (!visit(static_cast<const TextMatch&>(match))) break;
+            // Empty regex matches must still make progress
+            from = match.position + (match.length ? match.length : 1);
+        }
+        return count;
+    }
+
+private:
+    [[nodiscard]] bool FindPlain(std::wstring_view text, size_t from, TextMatch& match) const;
+    [[nodiscard]] bool FindRegex(std::wstring_view text, size_t from, TextMatch& match) const;
+    [[nodiscard]] bool IsWholeWord(std::wstring_view text, size_t position, size_t length) const noexcept;
+
+    TextSearchOptions m_options;
+    std::wstring m_pattern;                 // Lowercased unless matchCase
+    wchar_t m_firstLower = 0;               // First pattern character, both cases
+    wchar_t m_firstUpper = 0;
+    std::shared_ptr<const std::wregex> m_regex;
+    bool m_valid = false;
+};
+
+//------------------------------------------------------------------------------
+// Append up to 'maxHits' line hits for 'text' to 'hits'.  Returns the number
+// of matches seen: with 'countAll' the scan goes on past maxHits to count
+// the rest, otherwise it stops there.  A set 'cancel' flag stops the scan.
+//------------------------------------------------------------------------------
+size_t CollectLineHits(const TextMatcher& matcher, std::wstring_view text, size_t maxHits,
+                       bool countAll, std::vector<TextLineHit>& hits,
+                       const std::atomic<bool>* cancel = nullptr);
+
+} // namespace QNote
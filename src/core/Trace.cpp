@@ -0,0 +1,304 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// Trace.cpp - Low-overhead scoped timers implementation
+//==============================================================================
+
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+
+namespace QNote {
+
+namespace {
+
+// One ring buffer entry.  'sequence' is odd while the entry is being
+// written and 2 * (event index + 1) once it is complete, so a reader can
+// tell a finished entry from one that is being overwritten.
+struct TraceSlot {
+    std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint64_t> startNs{ 0 };
+    std::atomic<uint64_t> durationNs{ 0 };
+};
+
+struct ThreadBuffer {
+    uint32_t threadId = 0;
+    std::string threadName;                    // Guarded by the registry mutex
+    std::atomic<bool> inUse{ true };
+    std::atomic<uint64_t> written{ 0 };        // Only the owning thread writes
+    std::unique_ptr<TraceSlot[]> slots{ new TraceSlot[Trace::EVENTS_PER_THREAD] };
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint32_t nextThreadId = 1;
+};
+
+// Never destroyed: threads may still record while the process exits.
+// Created during static initialization, before any worker can record: a
+// function-local static is not initialized thread-safely in release builds.
+TraceRegistry* const s_registry = new TraceRegistry();
+
+TraceRegistry& GetRegistry() {
+    return *s_registry;
+}
+
+// Hands the thread's buffer back for reuse when the thread exits
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferHolder() {
+        if (buffer) buffer->inUse.store(false, std::memory_order_release);
+    }
+};
+thread_local ThreadBufferHolder t_buffer;
+
+// Name given before the thread recorded anything; applied to its buffer
+thread_local const char* t_threadName = nullptr;
+
+const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+std::atomic<uint64_t> s_clearedAtNs{ 0 };
+
+ThreadBuffer* AcquireThreadBuffer() {
+    if (t_buffer.buffer) return t_buffer.buffer;
+
+    TraceRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& buffer : registry.buffers) {
+        bool expected = false;
+        if (buffer->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            buffer->threadName = t_threadName ? t_threadName : "";
+            t_buffer.buffer = buffer.get();
+            return t_buffer.buffer;
+        }
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->threadId = registry.nextThreadId++;
+    if (t_threadName) buffer->threadName = t_threadName;
+    registry.buffers.push_back(std::move(buffer));
+    t_buffer.buffer = registry.buffers.back().get();
+    return t_buffer.buffer;
+}
+
+// Copy the complete entries of one buffer, skipping any being overwritten
+void ReadBuffer(const ThreadBuffer& buffer, uint64_t clearedAt, std::vector<TraceEvent>& events) {
+    const uint64_t written = buffer.written.load(std::memory_order_acquire);
+    const uint64_t first = written > Trace::EVENTS_PER_THREAD ? written - Trace::EVENTS_PER_THREAD : 0;
+
+    for (uint64_t index = first; index < written; index++) {
+        const TraceSlot& slot = buffer.slots[index % Trace::EVENTS_PER_THREAD];
+        const uint64_t expected = 2 * (index + 1);
+        if (slot.sequence.load(std::memory_order_acquire) != expected) continue;
+
+        TraceEvent event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.startNs = slot.startNs.load(std::memory_order_relaxed);
+        event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        event.threadId = buffer.threadId;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) continue;
+        if (!event.name || event.startNs < clearedAt) continue;
+        events.push_back(event);
+    }
+}
+
+void AppendJsonString(std::string& out, const char* text) {
+    out += '"';
+    for (const char* p = text; *p; p++) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+std::wstring Widen(const char* text) {
+    return std::wstring(text, text + std::strlen(text));
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Enable or disable recording
+//------------------------------------------------------------------------------
+void Trace::SetEnabled(bool enabled) noexcept {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name) {
+    // Threads that never record never get a buffer
+    t_threadName = name;
+    if (t_buffer.buffer) {
+        std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+        t_buffer.buffer->threadName = name ? name : "";
+    }
+}
+
+uint64_t Trace::Now() noexcept {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - s_epoch).count());
+}
+
+//------------------------------------------------------------------------------
+// Append to the calling thread's ring buffer
+//------------------------------------------------------------------------------
+void Trace::Record(const char* name, uint64_t startNs, uint64_t endNs) noexcept {
+    ThreadBuffer* buffer = nullptr;
+    try {
+        buffer = AcquireThreadBuffer();
+    } catch (const std::bad_alloc&) {
+        return;
+    } catch (const std::system_error&) {
+        // The registry mutex could not be locked; drop the event
+        return;
+    }
+
+    const uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceSlot& slot = buffer->slots[index % EVENTS_PER_THREAD];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs > startNs ? endNs - startNs : 0, std::memory_order_relaxed);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Events of every thread, oldest first
+//------------------------------------------------------------------------------
+std::vector<TraceEvent> Trace::Snapshot() {
+    const uint64_t clearedAt = s_clearedAtNs.load(std::memory_order_relaxed);
+    std::vector<TraceEvent> events;
+
+    TraceRegistry& registry = GetRegistry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            ReadBuffer(*buffer, clearedAt, events);
+        }
+    }
+
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+//------------------------------------------------------------------------------
+// Complete ("X") events plus thread name metadata, timestamps in microseconds
+//------------------------------------------------------------------------------
+std::string Trace::FormatChromeTrace() {
+    std::vector<TraceEvent> events = Snapshot();
+
+    std::string json = "{\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"QNote\"}}";
+
+    {
+        TraceRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto& buffer : registry.buffers) {
+            if (buffer->threadName.empty()) continue;
+            char prefix[96];
+            std::snprintf(prefix, sizeof(prefix),
+                          ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                          buffer->threadId);
+            json += prefix;
+            AppendJsonString(json, buffer->threadName.c_str());
+            json += "}}";
+        }
+    }
+
+    for (const auto& event : events) {
+        json += ",\n{\"name\":";
+        AppendJsonString(json, event.name);
+        char fields[128];
+        std::snprintf(fields, sizeof(fields),
+                      ",\"cat\":\"qnote\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                      event.threadId, event.startNs / 1000.0, event.durationNs / 1000.0);
+        json += fields;
+    }
+
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+//------------------------------------------------------------------------------
+// Totals per operation (largest total first) and the slowest single events
+//------------------------------------------------------------------------------
+std::wstring Trace::FormatSummary(size_t maxEntries) {
+    std::vector<TraceEvent> events = Snapshot();
+    if (events.empty()) {
+        return L"No trace events recorded.";
+    }
+
+    struct OperationTotals {
+        size_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+    };
+    std::map<std::string, OperationTotals> totals;
+    for (const auto& event : events) {
+        OperationTotals& entry = totals[event.name];
+        entry.count++;
+        entry.totalNs += event.durationNs;
+        entry.maxNs = std::max(entry.maxNs, event.durationNs);
+    }
+
+    std::vector<std::pair<std::string, OperationTotals>> byTotal(totals.begin(), totals.end());
+    std::sort(byTotal.begin(), byTotal.end(),
+              [](const auto& a, const auto& b) { return a.second.totalNs > b.second.totalNs; });
+
+    size_t slowestCount = std::min(maxEntries, events.size());
+    std::partial_sort(events.begin(), events.begin() + slowestCount, events.end(),
+                      [](const TraceEvent& a, const TraceEvent& b) { return a.durationNs > b.durationNs; });
+
+    auto ms = [](uint64_t ns) { return ns / 1e6; };
+
+    std::wostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << events.size() << L" events\r\n\r\n";
+
+    ss << L"Total ms / count / max ms, by operation:\r\n";
+    for (size_t i = 0; i < byTotal.size() && i < maxEntries; i++) {
+        const auto& [name, entry] = byTotal[i];
+        ss << L"  " << ms(entry.totalNs) << L" / " << entry.count << L" / " << ms(entry.maxNs)
+           << L"  " << Widen(name.c_str()) << L"\r\n";
+    }
+
+    ss << L"\r\nSlowest operations (ms):\r\n";
+    for (size_t i = 0; i < slowestCount; i++) {
+        const TraceEvent& event = events[i];
+        ss << L"  " << ms(event.durationNs) << L"  " << Widen(event.name)
+           << L" (thread " << event.threadId << L", at " << ms(event.startNs) / 1000.0 << L" s)\r\n";
+    }
+    return ss.str();
+}
+
+//------------------------------------------------------------------------------
+// Events recorded before now are left out of later snapshots
+//------------------------------------------------------------------------------
+void Trace::Clear() noexcept {
+    s_clearedAtNs.store(Now(), std::memory_order_relaxed);
+}
+
+} // namespace QNote
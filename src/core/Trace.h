@@ -0,0 +1,97 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// Trace.h - Low-overhead scoped timers with Chrome trace export
+//==============================================================================
+
+#pragma once
+
+// Portable: no Windows dependencies.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// One timed operation.  'name' is a string literal.
+//------------------------------------------------------------------------------
+struct TraceEvent {
+    const char* name = nullptr;
+    uint32_t threadId = 0;
+    uint64_t startNs = 0;          // Since the trace clock's epoch
+    uint64_t durationNs = 0;
+};
+
+//------------------------------------------------------------------------------
+// Tracing.  Off by default; while off a scope costs one relaxed load.
+// While on, each thread appends to its own ring buffer with no locks, so
+// the newest EVENTS_PER_THREAD events of every thread are kept.  Buffers
+// of threads that have exited are reused by new ones.
+//------------------------------------------------------------------------------
+class Trace {
+public:
+    static void SetEnabled(bool enabled) noexcept;
+    [[nodiscard]] static bool IsEnabled() noexcept {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Label the calling thread in exported traces ('name' is a string literal)
+    static void SetThreadName(const char* name);
+
+    // Monotonic clock in nanoseconds
+    [[nodiscard]] static uint64_t Now() noexcept;
+
+    // Append an event for the calling thread
+    static void Record(const char* name, uint64_t startNs, uint64_t endNs) noexcept;
+
+    // Events of every thread, oldest first.  Safe while other threads record.
+    [[nodiscard]] static std::vector<TraceEvent> Snapshot();
+
+    // Chrome trace_event JSON (chrome://tracing, Perfetto)
+    [[nodiscard]] static std::string FormatChromeTrace();
+
+    // Per-operation totals and the slowest single operations, as text
+    [[nodiscard]] static std::wstring FormatSummary(size_t maxEntries = 12);
+
+    // Forget recorded events
+    static void Clear() noexcept;
+
+    static constexpr size_t EVENTS_PER_THREAD = 8192;
+
+private:
+    static inline std::atomic<bool> s_enabled{ false };
+};
+
+//------------------------------------------------------------------------------
+// Times the enclosing scope.  Use through QNOTE_TRACE_SCOPE so builds
+// without QNOTE_TRACING compile it away entirely.
+//------------------------------------------------------------------------------
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) noexcept
+        : m_name(Trace::IsEnabled() ? name : nullptr) {
+        if (m_name) m_start = Trace::Now();
+    }
+    ~TraceScope() {
+        if (m_name) Trace::Record(m_name, m_start, Trace::Now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start = 0;
+};
+
+} // namespace QNote
+
+#ifdef QNOTE_TRACING
+#define QNOTE_TRACE_CONCAT_INNER(a, b) a##b
+#define QNOTE_TRACE_CONCAT(a, b) QNOTE_TRACE_CONCAT_INNER(a, b)
+#define QNOTE_TRACE_SCOPE(name) ::QNote::TraceScope QNOTE_TRACE_CONCAT(qnoteTraceScope, __LINE__)(name)
+#else
+#define QNOTE_TRACE_SCOPE(name) ((void)0)
+#endif
@@ -69,6 +69,10 @@
 #define IDM_ENCODING_UTF16LE            5003
 #define IDM_ENCODING_UTF16BE            5004
 #define IDM_ENCODING_ANSI               5005
+#define IDM_ENCODING_CP1251             5006
+#define IDM_ENCODING_CP1252             5007
+#define IDM_ENCODING_SHIFTJIS           5008
+#define IDM_ENCODING_GB18030            5009
 
 // Help menu
 #define IDM_HELP_ABOUT                  6001
@@ -111,6 +115,10 @@
 #define IDM_ENCODING_REOPEN_UTF16LE     5103
 #define IDM_ENCODING_REOPEN_UTF16BE     5104
 #define IDM_ENCODING_REOPEN_ANSI        5105
+#define IDM_ENCODING_REOPEN_CP1251      5106
+#define IDM_ENCODING_REOPEN_CP1252      5107
+#define IDM_ENCODING_REOPEN_SHIFTJIS    5108
+#define IDM_ENCODING_REOPEN_GB18030     5109
 
 // View menu (additional)
 #define IDM_VIEW_HIGHLIGHTLINE          4006
@@ -158,6 +166,10 @@
 #define IDM_EDIT_NUMBERLINES            2028
 #define IDM_EDIT_TOGGLECOMMENT          2029
 #define IDM_EDIT_REVERSESELECTION       2034
+#define IDM_EDIT_SORTLINES_CUSTOM       2035
+#define IDM_EDIT_DEDUPELINES_CUSTOM     2036
+#define IDM_EDIT_FINDINFILES            2037
+#define IDM_EDIT_FINDINTABS             2038
 
 // View menu (additional 2)
 #define IDM_VIEW_ALWAYSONTOP            4008
@@ -177,6 +189,9 @@
 #define IDM_TOOLS_CHARMAP               10030
 #define IDM_TOOLS_CLIPHISTORY           10031
 
+// Tools (hidden: accelerator only)
+#define IDM_TOOLS_DUMPTRACE             10032
+
 // Tools menu (Settings)
 #define IDM_TOOLS_SETTINGS              10020
 
@@ -409,6 +424,23 @@
 #define IDD_SPLITLINES                  206
 #define IDC_SPLITLINES_WIDTH            1022
 
+// Sort lines dialog controls
+#define IDD_SORTLINES                   214
+#define IDC_SORT_DESCENDING             1500
+#define IDC_SORT_CASESENSITIVE          1501
+#define IDC_SORT_NATURAL                1502
+#define IDC_SORT_UNIQUE                 1503
+#define IDC_SORT_COLUMN                 1504
+#define IDC_SORT_DELIMITER              1505
+
+// Duplicate lines dialog controls
+#define IDD_DEDUPELINES                 215
+#define IDC_DEDUPE_REMOVE               1510
+#define IDC_DEDUPE_SHOW                 1511
+#define IDC_DEDUPE_COUNT                1512
+#define IDC_DEDUPE_IGNORECASE           1513
+#define IDC_DEDUPE_IGNORESPACE          1514
+
 // Status bar parts
 #define SB_PART_POSITION                0
 #define SB_PART_ENCODING                1
@@ -422,6 +454,12 @@
 #define WM_APP_FILECHANGED              (WM_APP + 3)
 #define WM_APP_OPENNOTE                 (WM_APP + 4)
 #define WM_APP_TRAYICON                 (WM_APP + 5)
+#define WM_APP_PREFETCHDONE             (WM_APP + 6)
+#define WM_APP_FILELOAD                 (WM_APP + 7)
+#define WM_APP_FINDINFILES              (WM_APP + 8)
+#define WM_APP_RUNTASKS                 (WM_APP + 9)
+#define WM_APP_REFRESHNOTES             (WM_APP + 10)
+#define WM_APP_NOTESEARCH               (WM_APP + 11)
 
 // Timer IDs
 #define TIMER_STATUSUPDATE              1
@@ -6,8 +6,14 @@
 #include "DocumentManager.h"
 #include "Editor.h"
 #include "TabBar.h"
+#include "FileIO.h"
+#include "resource.h"
 #include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <mutex>
+#include <new>
+#include <system_error>
 
 namespace {
 
@@ -39,6 +45,16 @@ std::wstring NormalizeForRichEdit(const std::wstring& text) {
 
 namespace QNote {
 
+//------------------------------------------------------------------------------
+// Destructor - stop the prefetch thread before documents go away
+//------------------------------------------------------------------------------
+DocumentManager::~DocumentManager() {
+    CancelPrefetch();
+    while (!m_fileLoads.empty()) {
+        CancelFileLoad(m_fileLoads.back()->tabId);
+    }
+}
+
 //------------------------------------------------------------------------------
 // Initialize with parent window info and tab bar reference
 //------------------------------------------------------------------------------
@@ -118,6 +134,7 @@ int DocumentManager::NewDocument() {
 
     // Record clean hash for undo-to-clean detection
     newDoc.cleanTextHash = std::hash<std::wstring>{}(editor->GetText());
+    MarkActivated(newDoc);
     editor->SetEncoding(newDoc.encoding);
     editor->SetLineEnding(newDoc.lineEnding);
     editor->SetSelection(0, 0);
@@ -126,6 +143,9 @@ int DocumentManager::NewDocument() {
     ShowWindow(editor->GetHandle(), SW_SHOW);
     editor->SetFocus();
 
+    TouchResident(tabId);
+    EnforceResidentLimit();
+
     return tabId;
 }
 
@@ -185,7 +205,6 @@ int DocumentManager::OpenDocument(const std::wstring& filePath,
     Editor* editor = newDoc.editor.get();
 
     // Load into editor – use streamed path for large content to keep UI responsive
-    static constexpr size_t LARGE_TEXT_THRESHOLD = 100ULL * 1024 * 1024 / sizeof(wchar_t);
     if (content.size() > LARGE_TEXT_THRESHOLD) {
         editor->SetTextStreamed(content);
     } else {
@@ -202,6 +221,10 @@ int DocumentManager::OpenDocument(const std::wstring& filePath,
 
     // Record clean hash for undo-to-clean detection
     newDoc.cleanTextHash = std::hash<std::wstring>{}(editor->GetText());
+    MarkActivated(newDoc);
+
+    TouchResident(tabId);
+    EnforceResidentLimit();
 
     return tabId;
 }
@@ -215,8 +238,18 @@ void DocumentManager::CloseDocument(int tabId) {
 
     bool wasActive = (tabId == m_activeTabId);
 
+    // Stop streaming into an editor that is about to be destroyed
+    CancelFileLoad(tabId);
+
+    // A tab closed before its lazy content was read still owns its sidecar
+    const auto& hibernated = m_documents[idx].hibernated;
+    if (hibernated && !hibernated->sidecarPath.empty()) {
+        DeleteFileW(hibernated->sidecarPath.c_str());
+    }
+
     // The document's unique_ptr<Editor> will be destroyed when erased
     m_documents.erase(m_documents.begin() + idx);
+    m_residentOrder.remove(tabId);
 
     // Remove from tab bar
     m_tabBar->RemoveTab(tabId);
@@ -256,6 +289,9 @@ bool DocumentManager::SwitchToDocument(int tabId) {
     // Show and restore the new document's editor
     RestoreState(tabId);
 
+    // Release the least recently used editors if over the resident limits
+    EnforceResidentLimit();
+
     return true;
 }
 
@@ -268,8 +304,12 @@ void DocumentManager::SaveCurrentState() {
 
     Editor* editor = doc->editor.get();
 
-    const std::wstring currentText = editor->GetText();
-    doc->isModified = (std::hash<std::wstring>{}(currentText) != doc->cleanTextHash);
+    // A tab still streaming in or shown in the large file viewer is never
+    // modified (its editor is read-only)
+    if (!doc->isLoading && !doc->largeView) {
+        const std::wstring currentText = editor->GetText();
+        doc->isModified = (std::hash<std::wstring>{}(currentText) != doc->cleanTextHash);
+    }
     doc->encoding = editor->GetEncoding();
     doc->lineEnding = editor->GetLineEnding();
 
@@ -292,12 +332,18 @@ void DocumentManager::SaveCurrentState() {
 //------------------------------------------------------------------------------
 // Restore a document's state into the editor
 // With per-tab editors, the RichEdit control already holds the content and
-// undo/redo history.  We just need to show the HWND and focus it.
+// undo/redo history.  We just need to show the HWND and focus it.  A
+// hibernated document gets a fresh editor rebuilt from its snapshot first.
 //------------------------------------------------------------------------------
 void DocumentManager::RestoreState(int tabId) {
     DocumentState* doc = GetDocument(tabId);
-    if (!doc || !doc->editor) return;
+    if (!doc) return;
 
+    if (doc->IsHibernated() && !WakeDocument(tabId)) return;
+    if (!doc->editor) return;
+
+    TouchResident(tabId);
+    MarkActivated(*doc);
     Editor* editor = doc->editor.get();
 
     // Show the editor for this tab
@@ -305,6 +351,462 @@ void DocumentManager::RestoreState(int tabId) {
     editor->SetFocus();
 }
 
+//------------------------------------------------------------------------------
+// Add a lazily restored tab.  The document starts hibernated with no text;
+// its file and/or session sidecar is read on first activation or prefetch.
+//------------------------------------------------------------------------------
+int DocumentManager::AddPlaceholderDocument(DocumentState&& doc, const std::wstring& sidecarPath) {
+    if (!m_tabBar) return -1;
+
+    doc.editor.reset();
+    doc.hibernated = std::make_unique<HibernatedDocument>();
+    doc.hibernated->contentPending = true;
+    doc.hibernated->sidecarPath = sidecarPath;
+    doc.hibernated->editorModified = doc.isModified;
+
+    // Keep activation order continuous with the previous session
+    m_activationCounter = (std::max)(m_activationCounter, doc.lastActivated);
+
+    int tabId = m_tabBar->AddTab(doc.GetDisplayTitle(), doc.filePath);
+    doc.tabId = tabId;
+    if (doc.isModified) m_tabBar->SetTabModified(tabId, true);
+    if (doc.isPinned) m_tabBar->SetTabPinned(tabId, true);
+
+    m_documents.push_back(std::move(doc));
+    return tabId;
+}
+
+//------------------------------------------------------------------------------
+// Check whether a lazily restored document still has to read its content
+//------------------------------------------------------------------------------
+bool DocumentManager::IsContentPending(int tabId) const {
+    const DocumentState* doc = GetDocument(tabId);
+    return doc && doc->hibernated && doc->hibernated->contentPending;
+}
+
+//------------------------------------------------------------------------------
+// Read the content of a lazily restored document.  Safe to call from any
+// thread: touches only the file system, and never pumps messages, even for
+// a file over 100 MB.
+//------------------------------------------------------------------------------
+PendingContentResult DocumentManager::ReadPendingContent(const std::wstring& filePath,
+                                                         const std::wstring& sidecarPath,
+                                                         bool isNewFile, bool isModified) {
+    PendingContentResult result;
+    const bool fileBacked = !isNewFile && !filePath.empty();
+
+    if (fileBacked) {
+        FileReadResult fileResult = FileIO::ReadFileInBackground(filePath);
+        if (fileResult.success) {
+            result.cleanContent = std::move(fileResult.content);
+            result.encoding = fileResult.detectedEncoding;
+            result.lineEnding = fileResult.detectedLineEnding;
+            result.hasFileFormat = true;
+
+            // Tabs with unsaved modifications load from the sidecar instead
+            if (isModified && !sidecarPath.empty()) {
+                FileReadResult sidecarResult = FileIO::ReadFileInBackground(sidecarPath);
+                result.content = sidecarResult.success ? std::move(sidecarResult.content)
+                                                       : result.cleanContent;
+            } else {
+                result.content = result.cleanContent;
+            }
+            result.success = true;
+            return result;
+        }
+        // The file is gone; keep any unsaved text rather than losing it
+        if (sidecarPath.empty()) return result;
+    }
+
+    if (!sidecarPath.empty()) {
+        FileReadResult sidecarResult = FileIO::ReadFileInBackground(sidecarPath);
+        if (!sidecarResult.success) return result;
+        result.content = std::move(sidecarResult.content);
+
+        // Untitled tabs have no clean text, and neither does a file-backed
+        // tab whose file could not be read: all of the sidecar is unsaved
+        if (!isNewFile && !fileBacked) {
+            result.cleanContent = result.content;
+        }
+    }
+    result.success = true;
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Read a pending document's content on the UI thread.  WakeDocument() sends
+// unmodified files over ASYNC_LOAD_THRESHOLD through BeginFileLoad() instead.
+//------------------------------------------------------------------------------
+bool DocumentManager::LoadPendingContent(DocumentState& doc) {
+    if (!doc.hibernated || !doc.hibernated->contentPending) return true;
+
+    PendingContentResult result;
+    try {
+        result = ReadPendingContent(doc.filePath, doc.hibernated->sidecarPath,
+                                    doc.isNewFile, doc.isModified);
+    } catch (const std::bad_alloc&) {
+        result = PendingContentResult();
+    }
+    ApplyPendingContent(doc, result);
+    return result.success;
+}
+
+//------------------------------------------------------------------------------
+// Store read content in a pending document's snapshot
+//------------------------------------------------------------------------------
+void DocumentManager::ApplyPendingContent(DocumentState& doc, PendingContentResult& result) {
+    HibernatedDocument& snapshot = *doc.hibernated;
+
+    if (result.hasFileFormat) {
+        doc.encoding = result.encoding;
+        doc.lineEnding = result.lineEnding;
+    }
+
+    // Hash and store the RichEdit-normalized forms so they match what the
+    // editor returns once the document is woken
+    doc.cleanTextHash = std::hash<std::wstring>{}(NormalizeForRichEdit(result.cleanContent));
+    snapshot.text = NormalizeForRichEdit(result.content);
+    if (result.success && !doc.isNewFile && !doc.filePath.empty() && !result.hasFileFormat) {
+        // The backing file could not be read; the sidecar text is unsaved
+        doc.isModified = true;
+        if (m_tabBar) m_tabBar->SetTabModified(doc.tabId, true);
+    }
+    snapshot.editorModified = doc.isModified;
+    snapshot.contentPending = false;
+
+    if (!snapshot.sidecarPath.empty()) {
+        DeleteFileW(snapshot.sidecarPath.c_str());
+        snapshot.sidecarPath.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Read pending documents on a background thread.  Each result is posted to
+// the parent window as WM_APP_PREFETCHDONE with an allocated
+// PendingContentResult in lParam.
+//------------------------------------------------------------------------------
+void DocumentManager::PrefetchPendingDocuments(const std::vector<int>& tabIds) {
+    CancelPrefetch();
+
+    struct PrefetchJob {
+        int tabId;
+        std::wstring filePath;
+        std::wstring sidecarPath;
+        bool isNewFile;
+        bool isModified;
+    };
+
+    std::vector<PrefetchJob> jobs;
+    for (int id : tabIds) {
+        const DocumentState* doc = GetDocument(id);
+        if (!doc || !doc->hibernated || !doc->hibernated->contentPending) continue;
+        jobs.push_back({ id, doc->filePath, doc->hibernated->sidecarPath,
+                         doc->isNewFile, doc->isModified });
+    }
+    if (jobs.empty() || !m_parentHwnd) return;
+
+    m_prefetchCancel = false;
+    HWND hwndNotify = m_parentHwnd;
+    std::atomic<bool>* cancel = &m_prefetchCancel;
+
+    m_prefetchThread = std::thread([jobs = std::move(jobs), hwndNotify, cancel]() {
+        // Large files are left for on-demand loading to bound memory use
+        // (they stream in through BeginFileLoad() when activated)
+        static constexpr ULONGLONG PREFETCH_MAX_FILE_BYTES = ASYNC_LOAD_THRESHOLD;
+
+        for (const auto& job : jobs) {
+            if (cancel->load()) break;
+
+            if (!job.isNewFile && !job.filePath.empty()) {
+                WIN32_FILE_ATTRIBUTE_DATA fad = {};
+                if (!GetFileAttributesExW(job.filePath.c_str(), GetFileExInfoStandard, &fad)) continue;
+                ULONGLONG size = (static_cast<ULONGLONG>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+                if (size > PREFETCH_MAX_FILE_BYTES) continue;
+            }
+
+            try {
+                auto result = std::make_unique<PendingContentResult>(
+                    ReadPendingContent(job.filePath, job.sidecarPath, job.isNewFile, job.isModified));
+                result->tabId = job.tabId;
+                if (!result->success || cancel->load()) continue;
+                if (PostMessageW(hwndNotify, WM_APP_PREFETCHDONE, 0,
+                                 reinterpret_cast<LPARAM>(result.get()))) {
+                    (void)result.release();
+                }
+            } catch (const std::bad_alloc&) {
+                break;
+            }
+        }
+    });
+}
+
+//------------------------------------------------------------------------------
+// Apply a prefetched result on the UI thread (takes ownership of result)
+//------------------------------------------------------------------------------
+void DocumentManager::OnPrefetchComplete(PendingContentResult* result) {
+    std::unique_ptr<PendingContentResult> owned(result);
+    if (!owned) return;
+
+    // Ignore results for tabs that were closed or loaded on demand meanwhile
+    DocumentState* doc = GetDocument(owned->tabId);
+    if (!doc || !doc->hibernated || !doc->hibernated->contentPending) return;
+
+    ApplyPendingContent(*doc, *owned);
+}
+
+//------------------------------------------------------------------------------
+// Stop the prefetch thread and wait for it to exit
+//------------------------------------------------------------------------------
+void DocumentManager::CancelPrefetch() {
+    m_prefetchCancel = true;
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Start streaming a file into an existing tab.  The editor is cleared and
+// made read-only; chunks are appended as they arrive on the UI thread.
+//------------------------------------------------------------------------------
+bool DocumentManager::BeginFileLoad(int tabId, const std::wstring& filePath, bool restoreView) {
+    FileLoadSource source;
+    source.filePath = filePath;
+    source.keepBytes = FileIO::GetFileSizeBytes(filePath) <= GetRawCacheBudget();
+    return StartFileLoad(tabId, std::move(source), restoreView);
+}
+
+bool DocumentManager::BeginFileReopen(int tabId, TextEncoding encoding) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || doc->filePath.empty()) return false;
+
+    FileLoadSource source;
+    source.filePath = doc->filePath;
+    source.forceEncoding = true;
+    source.encoding = encoding;
+    if (doc->rawBytes && doc->rawBytes->MatchesFile(doc->filePath)) {
+        source.rawBytes = doc->rawBytes;
+    }
+    return StartFileLoad(tabId, std::move(source), false);
+}
+
+bool DocumentManager::StartFileLoad(int tabId, FileLoadSource source, bool restoreView) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || !doc->editor || !m_parentHwnd) return false;
+
+    CancelFileLoad(tabId);
+
+    auto job = std::make_unique<FileLoadJob>();
+    job->tabId = tabId;
+    job->loadId = ++m_nextLoadId;
+    job->restoreView = restoreView;
+
+    Editor* editor = doc->editor.get();
+    editor->SetText(L"");
+    editor->SetReadOnly(true);
+    doc->isLoading = true;
+    doc->isModified = false;
+    doc->rawBytes.reset();                 // The load hands back the bytes it decodes
+
+    try {
+        job->thread = std::thread(RunFileLoad, m_parentHwnd, std::move(source), job.get());
+    } catch (const std::system_error&) {
+        editor->SetReadOnly(false);
+        doc->isLoading = false;
+        return false;
+    }
+    m_fileLoads.push_back(std::move(job));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Worker: read and decode the file, posting each chunk to the UI thread.
+// The final update carries the bytes decoded when they were kept.
+//------------------------------------------------------------------------------
+void DocumentManager::RunFileLoad(HWND hwndNotify, const FileLoadSource& source, FileLoadJob* job) {
+    const int tabId = job->tabId;
+    const unsigned int loadId = job->loadId;
+    const std::atomic<bool>* cancel = &job->cancel;
+    size_t chunksPosted = 0;
+
+    auto post = [hwndNotify](std::unique_ptr<FileLoadUpdate>& update) {
+        if (!PostMessageW(hwndNotify, WM_APP_FILELOAD, 0, reinterpret_cast<LPARAM>(update.get()))) {
+            return false;
+        }
+        (void)update.release();
+        return true;
+    };
+
+    try {
+        bool delivered = true;
+        auto onChunk = [&](std::wstring& chunk, const FileReadProgress& progress) {
+            {
+                // Wait for the UI thread to catch up before queuing more
+                std::unique_lock<std::mutex> lock(job->flowMutex);
+                job->flowChanged.wait(lock, [&] {
+                    return cancel->load() ||
+                           chunksPosted - job->chunksApplied < FILE_LOAD_CHUNKS_IN_FLIGHT;
+                });
+            }
+            if (cancel->load()) return false;
+            auto update = std::make_unique<FileLoadUpdate>();
+            update->tabId = tabId;
+            update->loadId = loadId;
+            update->text = std::move(chunk);
+            update->encoding = progress.encoding;
+            update->lineEnding = progress.lineEnding;
+            update->bytesRead = progress.bytesRead;
+            update->totalBytes = progress.totalBytes;
+            // A lost chunk would silently truncate the document
+            delivered = post(update);
+            if (delivered) chunksPosted++;
+            return delivered;
+        };
+
+        std::shared_ptr<RawFileBytes> raw = source.rawBytes;
+        FileReadResult result;
+        if (source.forceEncoding) {
+            if (!raw) {
+                raw = FileIO::ReadRawFile(source.filePath, result.errorMessage);
+            }
+            if (raw) {
+                result = FileIO::DecodeStreamed(*raw, source.encoding, onChunk);
+            }
+        } else {
+            std::shared_ptr<RawFileBytes> kept;
+            if (source.keepBytes) {
+                kept = std::make_shared<RawFileBytes>();
+            }
+            result = FileIO::ReadFileStreamed(source.filePath, onChunk, kept.get());
+            if (kept && !kept->data.empty() && kept->data.size() == kept->fileSize) {
+                raw = std::move(kept);
+            }
+        }
+        if (cancel->load()) return;
+
+        auto update = std::make_unique<FileLoadUpdate>();
+        update->tabId = tabId;
+        update->loadId = loadId;
+        update->done = true;
+        update->success = result.success && delivered;
+        update->errorMessage = delivered ? result.errorMessage
+                                         : std::wstring(L"The file could not be loaded completely.");
+        update->encoding = result.detectedEncoding;
+        update->lineEnding = result.detectedLineEnding;
+        if (update->success) {
+            update->rawBytes = std::move(raw);
+        }
+        (void)post(update);
+    } catch (const std::bad_alloc&) {
+        if (cancel->load()) return;
+        try {
+            auto update = std::make_unique<FileLoadUpdate>();
+            update->tabId = tabId;
+            update->loadId = loadId;
+            update->done = true;
+            update->errorMessage = L"Not enough memory to open this file";
+            (void)post(update);
+        } catch (const std::bad_alloc&) {
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Apply a chunk or completion from a file load on the UI thread
+//------------------------------------------------------------------------------
+bool DocumentManager::ApplyFileLoadUpdate(FileLoadUpdate& update) {
+    FileLoadJob* job = FindFileLoad(update.tabId);
+    if (!job || job->loadId != update.loadId || job->cancel.load()) return false;
+
+    // Loading tabs are never hibernated, so the editor is live
+    DocumentState* doc = GetDocument(update.tabId);
+    if (!doc || !doc->editor) return false;
+    Editor* editor = doc->editor.get();
+
+    doc->encoding = update.encoding;
+    doc->lineEnding = update.lineEnding;
+    editor->SetEncoding(update.encoding);
+    editor->SetLineEnding(update.lineEnding);
+
+    if (!update.done) {
+        editor->AppendText(update.text);
+        {
+            std::lock_guard<std::mutex> lock(job->flowMutex);
+            job->chunksApplied++;
+        }
+        job->flowChanged.notify_one();
+        return true;
+    }
+
+    // The worker posts its final update last; it is exiting now
+    if (job->thread.joinable()) {
+        job->thread.join();
+    }
+    const bool restoreView = job->restoreView;
+    m_fileLoads.erase(std::find_if(m_fileLoads.begin(), m_fileLoads.end(),
+        [job](const std::unique_ptr<FileLoadJob>& p) { return p.get() == job; }));
+
+    doc->isLoading = false;
+    editor->SetReadOnly(false);
+    if (update.success) {
+        editor->ClearUndoHistory();
+        editor->SetModified(false);
+        doc->isModified = false;
+        doc->cleanTextHash = std::hash<std::wstring>{}(editor->GetText());
+        if (m_tabBar) {
+            m_tabBar->SetTabModified(doc->tabId, false);
+        }
+        if (update.rawBytes) {
+            doc->rawBytes = std::move(update.rawBytes);
+            TrimRawByteCache(doc->tabId);
+        }
+        if (restoreView) {
+            editor->SetBookmarks(doc->bookmarks);
+            editor->SetSelection(doc->cursorStart, doc->cursorEnd);
+            editor->SetFirstVisibleLine(doc->firstVisibleLine);
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Stop a tab's file load and wait for its worker to exit.  Updates it
+// already posted are dropped by ApplyFileLoadUpdate().
+//------------------------------------------------------------------------------
+void DocumentManager::CancelFileLoad(int tabId) {
+    FileLoadJob* job = FindFileLoad(tabId);
+    if (!job) return;
+
+    {
+        // Wakes a worker waiting for its chunks to be applied
+        std::lock_guard<std::mutex> lock(job->flowMutex);
+        job->cancel = true;
+    }
+    job->flowChanged.notify_one();
+    if (job->thread.joinable()) {
+        job->thread.join();
+    }
+    m_fileLoads.erase(std::find_if(m_fileLoads.begin(), m_fileLoads.end(),
+        [job](const std::unique_ptr<FileLoadJob>& p) { return p.get() == job; }));
+
+    if (DocumentState* doc = GetDocument(tabId)) {
+        doc->isLoading = false;
+        if (doc->editor) {
+            doc->editor->SetReadOnly(false);
+        }
+    }
+}
+
+bool DocumentManager::IsLoading(int tabId) const {
+    return FindFileLoad(tabId) != nullptr;
+}
+
+DocumentManager::FileLoadJob* DocumentManager::FindFileLoad(int tabId) const {
+    for (const auto& job : m_fileLoads) {
+        if (job->tabId == tabId) return job.get();
+    }
+    return nullptr;
+}
+
 //------------------------------------------------------------------------------
 // Query methods
 //------------------------------------------------------------------------------
@@ -337,6 +839,265 @@ std::vector<int> DocumentManager::GetAllTabIds() const {
     return ids;
 }
 
+//------------------------------------------------------------------------------
+// Get a document's current text from its editor or hibernation snapshot
+//------------------------------------------------------------------------------
+std::wstring DocumentManager::GetDocumentText(int tabId) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc) return L"";
+    if (doc->editor) return doc->editor->GetText();
+    if (doc->hibernated) {
+        if (doc->hibernated->contentPending) {
+            (void)LoadPendingContent(*doc);
+        }
+        return doc->hibernated->text;
+    }
+    return L"";
+}
+
+//------------------------------------------------------------------------------
+// Snapshot documents for TabSearch.  Only live editors have to be read
+// here; hibernated text is copied, and content that is still on disk is
+// read on the search's worker threads.
+//------------------------------------------------------------------------------
+std::vector<TabSearchSource> DocumentManager::GetSearchSources() {
+    std::vector<TabSearchSource> sources;
+    sources.reserve(m_documents.size());
+
+    for (const auto& doc : m_documents) {
+        if (doc.largeView || doc.isLoading) continue;
+
+        TabSearchSource source;
+        source.tabId = doc.tabId;
+        source.title = doc.GetDisplayTitle();
+        try {
+            if (doc.editor) {
+                source.text = std::make_shared<const std::wstring>(doc.editor->GetText());
+            } else if (doc.hibernated && !doc.hibernated->contentPending) {
+                source.text = std::make_shared<const std::wstring>(doc.hibernated->text);
+            } else if (doc.hibernated) {
+                // The sidecar may be consumed by the tab being opened meanwhile;
+                // the read then falls back to the file or skips the tab
+                source.load = [filePath = doc.filePath, sidecarPath = doc.hibernated->sidecarPath,
+                               isNewFile = doc.isNewFile, isModified = doc.isModified](std::wstring& text) {
+                    PendingContentResult result = ReadPendingContent(filePath, sidecarPath, isNewFile, isModified);
+                    if (!result.success) return false;
+                    text = std::move(result.content);
+                    return true;
+                };
+            } else {
+                continue;
+            }
+        } catch (const std::bad_alloc&) {
+            // Search what fits rather than nothing
+            break;
+        }
+        sources.push_back(std::move(source));
+    }
+    return sources;
+}
+
+//------------------------------------------------------------------------------
+// Hibernate an inactive document: snapshot the editor's text, selection,
+// scroll position, bookmarks and undo history, then destroy its RichEdit
+// control.  The active document is never hibernated.
+//------------------------------------------------------------------------------
+bool DocumentManager::HibernateDocument(int tabId) {
+    if (tabId == m_activeTabId) return false;
+
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || !doc->editor || doc->hibernated || doc->isLoading || doc->largeView) return false;
+
+    Editor* editor = doc->editor.get();
+
+    std::unique_ptr<HibernatedDocument> snapshot;
+    try {
+        snapshot = std::make_unique<HibernatedDocument>();
+        snapshot->text = editor->GetText();
+    } catch (const std::bad_alloc&) {
+        // Keep the live editor rather than lose content
+        return false;
+    }
+    snapshot->editorModified = editor->IsModified();
+    editor->TakeUndoHistory(snapshot->undoStack, snapshot->redoStack);
+
+    DWORD start = 0, end = 0;
+    editor->GetSelection(start, end);
+    doc->cursorStart = start;
+    doc->cursorEnd = end;
+    doc->firstVisibleLine = editor->GetFirstVisibleLine();
+    doc->bookmarks = editor->GetBookmarks();
+    doc->encoding = editor->GetEncoding();
+    doc->lineEnding = editor->GetLineEnding();
+
+    // Destroys the RichEdit HWND, font and spell-check state
+    doc->editor.reset();
+    doc->hibernated = std::move(snapshot);
+    m_residentOrder.remove(tabId);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Wake a hibernated document: recreate its editor (hidden) and restore the
+// snapshot taken by HibernateDocument()
+//------------------------------------------------------------------------------
+bool DocumentManager::WakeDocument(int tabId) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || !doc->hibernated) return false;
+
+    if (doc->hibernated->contentPending && WakeWithoutReading(*doc)) return true;
+
+    // A lazily restored tab reads its content now; on failure it opens empty
+    if (doc->hibernated->contentPending) {
+        (void)LoadPendingContent(*doc);
+    }
+
+    auto editor = CreateEditorForDocument();
+    if (!editor) return false;
+
+    HibernatedDocument& snapshot = *doc->hibernated;
+    if (snapshot.text.size() > LARGE_TEXT_THRESHOLD) {
+        editor->SetTextStreamed(snapshot.text);
+    } else {
+        editor->SetText(snapshot.text);
+    }
+    editor->SetEncoding(doc->encoding);
+    editor->SetLineEnding(doc->lineEnding);
+    editor->RestoreUndoHistory(std::move(snapshot.undoStack), std::move(snapshot.redoStack));
+    editor->SetModified(snapshot.editorModified);
+    editor->SetBookmarks(doc->bookmarks);
+    editor->SetSelection(doc->cursorStart, doc->cursorEnd);
+    editor->SetFirstVisibleLine(doc->firstVisibleLine);
+
+    doc->editor = std::move(editor);
+    doc->hibernated.reset();
+    TouchResident(tabId);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Wake a lazily restored, unmodified large file without reading it on this
+// thread: a file for the viewer goes back to it, and one the viewer does not
+// take (or cannot open) streams into the editor through BeginFileLoad(),
+// whose completion records the clean text and restores the cursor.  False
+// if neither applies or starts; the document is then still hibernated.
+//------------------------------------------------------------------------------
+bool DocumentManager::WakeWithoutReading(DocumentState& doc) {
+    if (doc.isNewFile || doc.isModified || doc.filePath.empty()) return false;
+    const bool openInViewer = UsesLargeFileViewer(doc.filePath);
+    if (!openInViewer && FileIO::GetFileSizeBytes(doc.filePath) <= ASYNC_LOAD_THRESHOLD) return false;
+
+    auto editor = CreateEditorForDocument();
+    if (!editor) return false;
+    editor->SetEncoding(doc.encoding);
+    editor->SetLineEnding(doc.lineEnding);
+    doc.editor = std::move(editor);
+
+    std::wstring errorMessage;
+    if (!(openInViewer && AttachLargeFileView(doc.tabId, doc.filePath, errorMessage)) &&
+        !BeginFileLoad(doc.tabId, doc.filePath, true)) {
+        doc.editor.reset();
+        return false;
+    }
+
+    // An unmodified tab has no unsaved text to keep
+    if (!doc.hibernated->sidecarPath.empty()) {
+        DeleteFileW(doc.hibernated->sidecarPath.c_str());
+    }
+    doc.hibernated.reset();
+    TouchResident(doc.tabId);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Check whether a file is large enough to open in the large file viewer
+//------------------------------------------------------------------------------
+bool DocumentManager::UsesLargeFileViewer(const std::wstring& filePath) const {
+    if (!m_settings || filePath.empty()) return false;
+
+    int thresholdMB = m_settings->GetSettings().largeFileViewerMB;
+    if (thresholdMB <= 0) return false;
+
+    WIN32_FILE_ATTRIBUTE_DATA fad = {};
+    if (!GetFileAttributesExW(filePath.c_str(), GetFileExInfoStandard, &fad)) return false;
+    ULONGLONG size = (static_cast<ULONGLONG>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+    return size >= static_cast<ULONGLONG>(thresholdMB) * 1024 * 1024;
+}
+
+//------------------------------------------------------------------------------
+// Show a file in a read-only viewer over the tab's editor.  The editor is
+// emptied and made read-only; it keeps the encoding and line ending so the
+// status bar and session code see the document as usual.
+//------------------------------------------------------------------------------
+bool DocumentManager::AttachLargeFileView(int tabId, const std::wstring& filePath,
+                                          std::wstring& errorMessage) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || !doc->editor) return false;
+
+    CancelFileLoad(tabId);
+    DetachLargeFileView(tabId);
+    Editor* editor = doc->editor.get();
+
+    auto view = std::make_unique<LargeFileView>();
+    if (m_settings && m_settings->GetSettings().lineIndexCache && !m_settings->GetSettingsDir().empty()) {
+        view->SetIndexCacheDirectory(m_settings->GetSettingsDir() + L"\\LineIndex");
+    }
+    if (!view->Open(editor->GetHandle(), m_hInstance, filePath, errorMessage)) {
+        return false;
+    }
+    view->SetFont(editor->GetFont());
+    if (m_settings) {
+        const AppSettings& settings = m_settings->GetSettings();
+        view->SetTabSize(settings.tabSize);
+        view->SetScrollLines(settings.scrollLines);
+        view->SetShowLineNumbers(settings.showLineNumbers);
+    }
+    view->SetStateCallback(m_largeViewCallback, m_largeViewCallbackData);
+
+    editor->Clear();
+    editor->SetBookmarks({});
+    editor->SetEncoding(view->GetEncoding());
+    editor->SetLineEnding(view->GetLineEnding());
+    editor->SetReadOnly(true);
+    editor->SetOverlay(view->GetHandle());
+
+    doc->encoding = view->GetEncoding();
+    doc->lineEnding = view->GetLineEnding();
+    doc->cleanTextHash = std::hash<std::wstring>{}(std::wstring());
+    doc->isModified = false;
+    doc->bookmarks.clear();
+    doc->rawBytes.reset();
+    doc->largeView = std::move(view);
+    if (m_tabBar) {
+        m_tabBar->SetTabModified(tabId, false);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Close a tab's large file viewer and make its editor editable again
+//------------------------------------------------------------------------------
+void DocumentManager::DetachLargeFileView(int tabId) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc || !doc->largeView) return;
+
+    if (doc->editor) {
+        doc->editor->SetOverlay(nullptr);
+        doc->editor->SetReadOnly(false);
+    }
+    doc->largeView.reset();
+}
+
+LargeFileView* DocumentManager::GetLargeFileView(int tabId) {
+    DocumentState* doc = GetDocument(tabId);
+    return doc ? doc->largeView.get() : nullptr;
+}
+
+void DocumentManager::SetLargeFileViewCallback(LargeFileView::StateCallback callback, void* userData) noexcept {
+    m_largeViewCallback = callback;
+    m_largeViewCallbackData = userData;
+}
+
 //------------------------------------------------------------------------------
 // Find document by file path
 //------------------------------------------------------------------------------
@@ -361,6 +1122,14 @@ void DocumentManager::SetDocumentModified(int tabId, bool modified) {
         doc->isModified = modified;
         if (!modified && doc->editor) {
             doc->cleanTextHash = std::hash<std::wstring>{}(doc->editor->GetText());
+        } else if (doc->hibernated) {
+            if (doc->hibernated->contentPending) {
+                (void)LoadPendingContent(*doc);
+            }
+            doc->hibernated->editorModified = modified;
+            if (!modified) {
+                doc->cleanTextHash = std::hash<std::wstring>{}(doc->hibernated->text);
+            }
         }
         if (m_tabBar) {
             m_tabBar->SetTabModified(tabId, modified);
@@ -371,6 +1140,7 @@ void DocumentManager::SetDocumentModified(int tabId, bool modified) {
 void DocumentManager::SetDocumentFilePath(int tabId, const std::wstring& filePath) {
     DocumentState* doc = GetDocument(tabId);
     if (doc) {
+        if (doc->filePath != filePath) doc->rawBytes.reset();
         doc->filePath = filePath;
         doc->isNewFile = filePath.empty();
         if (m_tabBar) {
@@ -383,6 +1153,21 @@ void DocumentManager::SetDocumentFilePath(int tabId, const std::wstring& filePat
     }
 }
 
+//------------------------------------------------------------------------------
+// Cache the raw bytes a document was decoded from
+//------------------------------------------------------------------------------
+void DocumentManager::SetDocumentRawBytes(int tabId, std::shared_ptr<RawFileBytes> rawBytes) {
+    DocumentState* doc = GetDocument(tabId);
+    if (!doc) return;
+    doc->rawBytes = std::move(rawBytes);
+    TrimRawByteCache(tabId);
+}
+
+std::shared_ptr<RawFileBytes> DocumentManager::GetDocumentRawBytes(int tabId) const {
+    const DocumentState* doc = GetDocument(tabId);
+    return doc ? doc->rawBytes : nullptr;
+}
+
 void DocumentManager::SetDocumentTitle(int tabId, const std::wstring& title) {
     DocumentState* doc = GetDocument(tabId);
     if (doc) {
@@ -443,6 +1228,8 @@ void DocumentManager::ResetActiveDocument() {
 
     int tabId = doc->tabId;
     Editor* editor = doc->editor.get();
+    CancelFileLoad(tabId);
+    DetachLargeFileView(tabId);
 
     // Reset all document state
     doc->cleanTextHash = 0;
@@ -459,6 +1246,7 @@ void DocumentManager::ResetActiveDocument() {
     doc->isNoteMode = false;
     doc->noteId.clear();
     doc->bookmarks.clear();
+    doc->rawBytes.reset();
     ApplyDefaults(*doc);
 
     // Update tab bar
@@ -559,6 +1347,13 @@ void DocumentManager::ApplySettingsToAllEditors(const AppSettings& settings) {
         editor->SetShowWhitespace(settings.showWhitespace);
         editor->SetSpellCheck(settings.spellCheckEnabled);
         editor->ApplyZoom(settings.zoomLevel);
+
+        if (doc.largeView) {
+            doc.largeView->SetFont(editor->GetFont());
+            doc.largeView->SetTabSize(settings.tabSize);
+            doc.largeView->SetScrollLines(settings.scrollLines);
+            doc.largeView->SetShowLineNumbers(settings.showLineNumbers);
+        }
     }
 }
 
@@ -583,4 +1378,100 @@ int DocumentManager::FindDocumentIndex(int tabId) const {
     return -1;
 }
 
+//------------------------------------------------------------------------------
+// Move a tab to the front (most recently used) of the resident list
+//------------------------------------------------------------------------------
+void DocumentManager::TouchResident(int tabId) {
+    m_residentOrder.remove(tabId);
+    m_residentOrder.push_front(tabId);
+}
+
+//------------------------------------------------------------------------------
+// Record that a tab was just shown
+//------------------------------------------------------------------------------
+void DocumentManager::MarkActivated(DocumentState& doc) {
+    doc.lastActivated = ++m_activationCounter;
+}
+
+//------------------------------------------------------------------------------
+// Hibernate least recently used editors until both the live editor count
+// and the total live text size are within their limits
+//------------------------------------------------------------------------------
+void DocumentManager::EnforceResidentLimit() {
+    size_t residentBytes = 0;
+    for (int id : m_residentOrder) {
+        const DocumentState* doc = GetDocument(id);
+        if (doc && doc->editor) {
+            residentBytes += static_cast<size_t>(doc->editor->GetTextLength()) * sizeof(wchar_t);
+        }
+    }
+
+    size_t residentCount = m_residentOrder.size();
+    TrimRawByteCache(m_activeTabId);
+    if (residentCount <= MAX_RESIDENT_EDITORS && residentBytes <= MAX_RESIDENT_TEXT_BYTES) return;
+
+    // Walk from least to most recently used
+    std::vector<int> candidates(m_residentOrder.rbegin(), m_residentOrder.rend());
+    for (int id : candidates) {
+        if (residentCount <= MAX_RESIDENT_EDITORS && residentBytes <= MAX_RESIDENT_TEXT_BYTES) break;
+        if (id == m_activeTabId) continue;
+
+        const DocumentState* doc = GetDocument(id);
+        size_t bytes = (doc && doc->editor)
+            ? static_cast<size_t>(doc->editor->GetTextLength()) * sizeof(wchar_t) : 0;
+        if (HibernateDocument(id)) {
+            residentCount--;
+            residentBytes -= (std::min)(bytes, residentBytes);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Raw byte cache budget: a share of physical memory, so the bytes of a file
+// near the viewer threshold fit.  Nothing is kept when the system is short
+// of memory, since the cache only saves a disk read.
+//------------------------------------------------------------------------------
+size_t DocumentManager::GetRawCacheBudget() {
+    MEMORYSTATUSEX status = { sizeof(status) };
+    if (!GlobalMemoryStatusEx(&status)) return MIN_RAW_CACHE_BYTES;
+    if (status.dwMemoryLoad >= RAW_CACHE_MAX_MEMORY_LOAD) return 0;
+
+    ULONGLONG budget = (std::max)(static_cast<ULONGLONG>(MIN_RAW_CACHE_BYTES),
+                                  status.ullTotalPhys / RAW_CACHE_MEMORY_DIVISOR);
+    return static_cast<size_t>((std::min)(budget, static_cast<ULONGLONG>(SIZE_MAX)));
+}
+
+//------------------------------------------------------------------------------
+// Keep cached raw file bytes within the budget, dropping the least recently
+// activated tabs first.  'keepTabId' (the tab just cached, or the active
+// one) keeps its bytes even alone over the budget, unless memory is short.
+//------------------------------------------------------------------------------
+void DocumentManager::TrimRawByteCache(int keepTabId) {
+    const size_t budget = GetRawCacheBudget();
+
+    std::vector<DocumentState*> cached;
+    size_t totalBytes = 0;
+    for (auto& doc : m_documents) {
+        if (!doc.rawBytes) continue;
+        if (budget == 0) {
+            doc.rawBytes.reset();
+            continue;
+        }
+        totalBytes += doc.rawBytes->data.size();
+        if (doc.tabId != keepTabId) {
+            cached.push_back(&doc);
+        }
+    }
+    if (totalBytes <= budget) return;
+
+    std::sort(cached.begin(), cached.end(), [](const DocumentState* a, const DocumentState* b) {
+        return a->lastActivated < b->lastActivated;
+    });
+    for (DocumentState* doc : cached) {
+        if (totalBytes <= budget) break;
+        totalBytes -= doc->rawBytes->data.size();
+        doc->rawBytes.reset();
+    }
+}
+
 } // namespace QNote
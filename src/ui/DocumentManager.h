@@ -15,15 +15,69 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <list>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 
 #include "Settings.h"  // Needed for TextEncoding, LineEnding enums
 #include "Editor.h"    // Needed for per-tab Editor instances
+#include "LargeFileView.h"
+#include "TabSearch.h"
 #include <memory>
 
 namespace QNote {
 
 // Forward declarations to reduce include dependencies
 class TabBar;
+struct RawFileBytes;
+
+//------------------------------------------------------------------------------
+// Hibernated document - editor content kept after its RichEdit control has
+// been destroyed to free memory and GDI/USER handles for an inactive tab
+//------------------------------------------------------------------------------
+struct HibernatedDocument {
+    std::wstring text;                     // Editor text (RichEdit-normalized)
+    bool editorModified = false;           // EM_GETMODIFY flag at hibernation
+    std::vector<UndoCheckpoint> undoStack; // Undo/redo history
+    std::vector<UndoCheckpoint> redoStack;
+
+    // Lazy session restore: text has not been read from disk yet
+    bool contentPending = false;
+    std::wstring sidecarPath;              // Session sidecar with unsaved content (may be empty)
+};
+
+//------------------------------------------------------------------------------
+// Content read for a lazily restored document, either on first activation
+// or by the background prefetch thread
+//------------------------------------------------------------------------------
+struct PendingContentResult {
+    int tabId = -1;
+    bool success = false;
+    bool hasFileFormat = false;            // encoding/lineEnding detected from the file
+    std::wstring content;                  // Text to show in the editor
+    std::wstring cleanContent;             // Last saved text (for modified detection)
+    TextEncoding encoding = TextEncoding::UTF8;
+    LineEnding lineEnding = LineEnding::CRLF;
+};
+
+//------------------------------------------------------------------------------
+// Chunk or completion posted by an asynchronous file load (WM_APP_FILELOAD)
+//------------------------------------------------------------------------------
+struct FileLoadUpdate {
+    int tabId = -1;
+    unsigned int loadId = 0;               // Load that posted it (stale updates are dropped)
+    bool done = false;                     // Final update: success/errorMessage are valid
+    bool success = false;
+    std::wstring text;                     // Decoded chunk to append
+    std::wstring errorMessage;
+    TextEncoding encoding = TextEncoding::UTF8;
+    LineEnding lineEnding = LineEnding::CRLF;
+    long long bytesRead = 0;
+    long long totalBytes = 0;
+    std::shared_ptr<RawFileBytes> rawBytes; // Final update: the bytes decoded, if kept
+};
 
 //------------------------------------------------------------------------------
 // Document state - everything needed to save/restore a document in the editor
@@ -42,6 +96,7 @@ struct DocumentState {
     bool isNewFile = true;                 // Whether the file has never been saved
     bool isModified = false;               // Has unsaved changes
     bool isPinned = false;                 // Tab is pinned
+    bool isLoading = false;                // File still streaming in (editor read-only)
 
     // Encoding/format
     TextEncoding encoding = TextEncoding::UTF8;
@@ -59,9 +114,26 @@ struct DocumentState {
     // Bookmarks
     std::set<int> bookmarks;
 
-    // Per-tab editor instance (owns its own RichEdit HWND and undo/redo stack)
+    // Bytes the file was decoded from, for Reopen with Encoding (may be null;
+    // dropped under memory pressure)
+    std::shared_ptr<RawFileBytes> rawBytes;
+
+    // Activation counter value when the tab was last shown (higher = more recent)
+    unsigned long long lastActivated = 0;
+
+    // Per-tab editor instance (owns its own RichEdit HWND and undo/redo stack).
+    // Null while the document is hibernated.
     std::unique_ptr<Editor> editor;
 
+    // Snapshot of the editor while hibernated (null when the editor is live)
+    std::unique_ptr<HibernatedDocument> hibernated;
+
+    // Read-only viewer covering the (empty) editor for very large files.
+    // Declared after 'editor' so it is destroyed before its parent window.
+    std::unique_ptr<LargeFileView> largeView;
+
+    [[nodiscard]] bool IsHibernated() const noexcept { return hibernated != nullptr; }
+
     // Get the display title for this document
     [[nodiscard]] std::wstring GetDisplayTitle() const {
         if (!customTitle.empty()) {
@@ -85,7 +157,7 @@ struct DocumentState {
 class DocumentManager {
 public:
     DocumentManager() noexcept = default;
-    ~DocumentManager() = default;
+    ~DocumentManager();
 
     // Prevent copying
     DocumentManager(const DocumentManager&) = delete;
@@ -123,6 +195,55 @@ public:
     [[nodiscard]] int GetDocumentCount() const noexcept { return static_cast<int>(m_documents.size()); }
     [[nodiscard]] std::vector<int> GetAllTabIds() const;
 
+    // Get a document's current text, whether its editor is live or hibernated.
+    // Reads the content of a lazily restored document if it is still pending.
+    [[nodiscard]] std::wstring GetDocumentText(int tabId);
+    
+    // Snapshot every document for a background search (see TabSearchSource).
+    // Pending documents are read by the search itself, not here; documents
+    // shown by the large file viewer are left out.
+    [[nodiscard]] std::vector<TabSearchSource> GetSearchSources();
+
+    // Tab hibernation: release/recreate the RichEdit control of a document
+    bool HibernateDocument(int tabId);
+    bool WakeDocument(int tabId);
+
+    // Lazy session restore: add a tab whose content is read on first use.
+    // The sidecar (if any) is owned by the document and deleted once read.
+    int AddPlaceholderDocument(DocumentState&& doc, const std::wstring& sidecarPath);
+    [[nodiscard]] bool IsContentPending(int tabId) const;
+
+    // Read pending documents on a background thread, in the given order.
+    // Results arrive as WM_APP_PREFETCHDONE and go to OnPrefetchComplete().
+    void PrefetchPendingDocuments(const std::vector<int>& tabIds);
+    void OnPrefetchComplete(PendingContentResult* result);
+    void CancelPrefetch();
+    
+    // Asynchronous file open: stream a file into an existing tab from a
+    // worker thread.  Decoded chunks arrive as WM_APP_FILELOAD and go to
+    // ApplyFileLoadUpdate(), which returns false for cancelled loads.  With
+    // 'restoreView' the document's saved cursor, scroll position and
+    // bookmarks are applied once the file is in.
+    bool BeginFileLoad(int tabId, const std::wstring& filePath, bool restoreView = false);
+    
+    // The same for Reopen with Encoding: decode the tab's file with
+    // 'encoding', from its cached bytes if they still match the file
+    bool BeginFileReopen(int tabId, TextEncoding encoding);
+    [[nodiscard]] bool ApplyFileLoadUpdate(FileLoadUpdate& update);
+    void CancelFileLoad(int tabId);
+    [[nodiscard]] bool IsLoading(int tabId) const;
+
+    // Files larger than this (bytes) are opened on a worker thread
+    static constexpr ULONGLONG ASYNC_LOAD_THRESHOLD = 16ULL * 1024 * 1024;
+
+    // Large file viewer: files at or above AppSettings::largeFileViewerMB
+    // are shown read-only by a LargeFileView instead of the editor
+    [[nodiscard]] bool UsesLargeFileViewer(const std::wstring& filePath) const;
+    bool AttachLargeFileView(int tabId, const std::wstring& filePath, std::wstring& errorMessage);
+    void DetachLargeFileView(int tabId);
+    [[nodiscard]] LargeFileView* GetLargeFileView(int tabId);
+    void SetLargeFileViewCallback(LargeFileView::StateCallback callback, void* userData) noexcept;
+
     // Check if a file is already open; returns tab id or -1
     [[nodiscard]] int FindDocumentByPath(const std::wstring& filePath) const;
 
@@ -133,6 +254,10 @@ public:
     void SetDocumentPinned(int tabId, bool pinned);
     void SetDocumentNoteMode(int tabId, bool isNoteMode, const std::wstring& noteId = L"");
 
+    // Cached raw file bytes (see DocumentState::rawBytes)
+    void SetDocumentRawBytes(int tabId, std::shared_ptr<RawFileBytes> rawBytes);
+    [[nodiscard]] std::shared_ptr<RawFileBytes> GetDocumentRawBytes(int tabId) const;
+
     // Update the active document's modified state from the editor
     void SyncModifiedState();
 
@@ -157,6 +282,58 @@ private:
     // Find document by tab id (internal)
     int FindDocumentIndex(int tabId) const;
 
+    // Move a tab to the front of the resident-editor LRU list
+    void TouchResident(int tabId);
+
+    // Hibernate least recently used editors beyond the resident limits
+    void EnforceResidentLimit();
+
+    // Bytes the raw byte cache may hold now (none under memory pressure)
+    [[nodiscard]] static size_t GetRawCacheBudget();
+    
+    // Drop cached raw file bytes beyond the budget, sparing 'keepTabId's
+    void TrimRawByteCache(int keepTabId = -1);
+
+    // Record that a tab was just shown
+    void MarkActivated(DocumentState& doc);
+
+    // Lazy session restore helpers
+    static PendingContentResult ReadPendingContent(const std::wstring& filePath,
+                                                   const std::wstring& sidecarPath,
+                                                   bool isNewFile, bool isModified);
+    bool LoadPendingContent(DocumentState& doc);
+    void ApplyPendingContent(DocumentState& doc, PendingContentResult& result);
+    bool WakeWithoutReading(DocumentState& doc);
+    
+    // What a file load decodes: the file itself, or with 'forceEncoding'
+    // its bytes (already read, or read first) in that encoding
+    struct FileLoadSource {
+        std::wstring filePath;
+        bool keepBytes = false;                // Hand the bytes read to the raw byte cache
+        bool forceEncoding = false;
+        TextEncoding encoding = TextEncoding::UTF8;
+        std::shared_ptr<RawFileBytes> rawBytes;
+    };
+    bool StartFileLoad(int tabId, FileLoadSource source, bool restoreView);
+    
+    // Asynchronous file load worker state.  The worker waits for the UI
+    // thread to apply its chunks once FILE_LOAD_CHUNKS_IN_FLIGHT are
+    // queued, so a file is never held decoded in the message queue; a
+    // cancel wakes it.
+    struct FileLoadJob {
+        int tabId = -1;
+        unsigned int loadId = 0;
+        bool restoreView = false;
+        std::thread thread;
+        std::atomic<bool> cancel{false};
+        std::mutex flowMutex;
+        std::condition_variable flowChanged;
+        size_t chunksApplied = 0;          // Guarded by flowMutex
+    };
+    static constexpr size_t FILE_LOAD_CHUNKS_IN_FLIGHT = 4;   // Chunks are up to 8 MB of file
+    FileLoadJob* FindFileLoad(int tabId) const;
+    static void RunFileLoad(HWND hwndNotify, const FileLoadSource& source, FileLoadJob* job);
+
 private:
     HWND m_parentHwnd = nullptr;
     HINSTANCE m_hInstance = nullptr;
@@ -165,6 +342,35 @@ private:
 
     std::vector<DocumentState> m_documents;
     int m_activeTabId = -1;
+
+    // Tabs with a live editor, most recently used first
+    std::list<int> m_residentOrder;
+    unsigned long long m_activationCounter = 0;
+
+    // Background prefetch of lazily restored tabs
+    std::thread m_prefetchThread;
+    std::atomic<bool> m_prefetchCancel{false};
+    
+    // Files streaming into tabs on worker threads
+    std::vector<std::unique_ptr<FileLoadJob>> m_fileLoads;
+    unsigned int m_nextLoadId = 0;
+
+    // State callback given to every large file viewer
+    LargeFileView::StateCallback m_largeViewCallback = nullptr;
+    void* m_largeViewCallbackData = nullptr;
+
+    // Hibernation limits: live editor count and total live text size
+    static constexpr size_t MAX_RESIDENT_EDITORS = 16;
+    static constexpr size_t MAX_RESIDENT_TEXT_BYTES = 128ULL * 1024 * 1024;
+
+    // Raw byte cache limits: total cached bytes (a share of physical memory,
+    // but at least the minimum) and system memory load (%)
+    static constexpr size_t MIN_RAW_CACHE_BYTES = 256ULL * 1024 * 1024;
+    static constexpr ULONGLONG RAW_CACHE_MEMORY_DIVISOR = 4;
+    static constexpr DWORD RAW_CACHE_MAX_MEMORY_LOAD = 85;
+
+    // Content above this size is loaded with the streamed (pumped) path
+    static constexpr size_t LARGE_TEXT_THRESHOLD = 100ULL * 1024 * 1024 / sizeof(wchar_t);
 };
 
 } // namespace QNote
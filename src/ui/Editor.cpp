@@ -5,6 +5,7 @@
 
 #include "Editor.h"
 #include "resource.h"
+#include "Trace.h"
 #include <CommCtrl.h>
 #include <Richedit.h>
 #include <regex>
@@ -164,6 +165,25 @@ void Editor::SetFocus() noexcept {
     }
 }
 
+//------------------------------------------------------------------------------
+// Set the overlay window
+//------------------------------------------------------------------------------
+void Editor::SetOverlay(HWND overlay) noexcept {
+    m_hwndOverlay = overlay;
+    if (m_hwndEdit && overlay) {
+        // The edit control must not paint over the overlay
+        LONG_PTR style = GetWindowLongPtrW(m_hwndEdit, GWL_STYLE);
+        SetWindowLongPtrW(m_hwndEdit, GWL_STYLE, style | WS_CLIPCHILDREN);
+        
+        RECT rc;
+        GetClientRect(m_hwndEdit, &rc);
+        MoveWindow(overlay, 0, 0, rc.right, rc.bottom, TRUE);
+        if (GetFocus() == m_hwndEdit) {
+            ::SetFocus(overlay);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 // Get text from edit control
 //------------------------------------------------------------------------------
@@ -207,6 +227,7 @@ void Editor::SetText(std::wstring_view text) {
 // message-loop pumping between each slice.
 //------------------------------------------------------------------------------
 void Editor::SetTextStreamed(const std::wstring& text, HWND hwndStatus) {
+    QNOTE_TRACE_SCOPE("Editor::SetTextStreamed");
     if (!m_hwndEdit) return;
 
     // Suppress EN_CHANGE for the entire load
@@ -268,6 +289,56 @@ void Editor::SetTextStreamed(const std::wstring& text, HWND hwndStatus) {
     ClearUndoHistory();
 }
 
+//------------------------------------------------------------------------------
+// Append text at the end, keeping the user's selection and scroll position.
+// Read-only is lifted for the insertion so streaming works while the user
+// is locked out of editing.
+//------------------------------------------------------------------------------
+void Editor::AppendText(std::wstring_view text) {
+    if (!m_hwndEdit || text.empty()) return;
+
+    DWORD oldMask = static_cast<DWORD>(SendMessageW(m_hwndEdit, EM_GETEVENTMASK, 0, 0));
+    SendMessageW(m_hwndEdit, EM_SETEVENTMASK, 0, oldMask & ~(ENM_CHANGE | ENM_SELCHANGE));
+    SendMessageW(m_hwndEdit, WM_SETREDRAW, FALSE, 0);
+
+    bool readOnly = IsReadOnly();
+    bool modified = IsModified();
+    if (readOnly) SendMessageW(m_hwndEdit, EM_SETREADONLY, FALSE, 0);
+
+    DWORD selStart = 0, selEnd = 0;
+    GetSelection(selStart, selEnd);
+    int firstVisible = GetFirstVisibleLine();
+
+    CHARRANGE cr;
+    cr.cpMin = -1;
+    cr.cpMax = -1;
+    SendMessageW(m_hwndEdit, EM_EXSETSEL, 0, reinterpret_cast<LPARAM>(&cr));
+    SendMessageW(m_hwndEdit, EM_REPLACESEL, FALSE,
+                 reinterpret_cast<LPARAM>(std::wstring(text).c_str()));
+
+    SetSelection(selStart, selEnd);
+    SetFirstVisibleLine(firstVisible);
+
+    SetModified(modified);
+    if (readOnly) SendMessageW(m_hwndEdit, EM_SETREADONLY, TRUE, 0);
+    SendMessageW(m_hwndEdit, WM_SETREDRAW, TRUE, 0);
+    InvalidateRect(m_hwndEdit, nullptr, FALSE);
+    SendMessageW(m_hwndEdit, EM_SETEVENTMASK, 0, oldMask);
+}
+
+//------------------------------------------------------------------------------
+// Read-only state
+//------------------------------------------------------------------------------
+void Editor::SetReadOnly(bool readOnly) noexcept {
+    if (m_hwndEdit) {
+        SendMessageW(m_hwndEdit, EM_SETREADONLY, readOnly ? TRUE : FALSE, 0);
+    }
+}
+
+bool Editor::IsReadOnly() const noexcept {
+    return m_hwndEdit && (GetWindowLongW(m_hwndEdit, GWL_STYLE) & ES_READONLY) != 0;
+}
+
 //------------------------------------------------------------------------------
 // Clear text
 //------------------------------------------------------------------------------
@@ -554,6 +625,32 @@ void Editor::ClearUndoHistory() {
     m_lastEditTime = 0;
 }
 
+//------------------------------------------------------------------------------
+// Move the undo/redo history out of the editor (used by tab hibernation)
+//------------------------------------------------------------------------------
+void Editor::TakeUndoHistory(std::vector<UndoCheckpoint>& undoStack,
+                             std::vector<UndoCheckpoint>& redoStack) {
+    undoStack = std::move(m_undoStack);
+    redoStack = std::move(m_redoStack);
+    ClearUndoHistory();
+}
+
+//------------------------------------------------------------------------------
+// Replace the undo/redo history (used when a hibernated tab is woken)
+//------------------------------------------------------------------------------
+void Editor::RestoreUndoHistory(std::vector<UndoCheckpoint>&& undoStack,
+                                std::vector<UndoCheckpoint>&& redoStack) {
+    ClearUndoHistory();
+    m_undoStack = std::move(undoStack);
+    m_redoStack = std::move(redoStack);
+    for (const auto& cp : m_undoStack) {
+        m_undoMemoryUsage += cp.text.size() * sizeof(wchar_t);
+    }
+    for (const auto& cp : m_redoStack) {
+        m_redoMemoryUsage += cp.text.size() * sizeof(wchar_t);
+    }
+}
+
 //------------------------------------------------------------------------------
 // Cut (VS Code: cuts entire line when no selection)
 //------------------------------------------------------------------------------
@@ -812,6 +909,7 @@ void Editor::SetModified(bool modified) noexcept {
 //------------------------------------------------------------------------------
 void Editor::SetLineEnding(LineEnding lineEnding) noexcept {
     m_lineEnding = lineEnding;
+    m_mixedLineEndings = false;
 }
 
 //------------------------------------------------------------------------------
@@ -919,6 +1017,17 @@ int Editor::GetFirstVisibleLine() const noexcept {
     return 0;
 }
 
+//------------------------------------------------------------------------------
+// Scroll so that the given line is the first visible line
+//------------------------------------------------------------------------------
+void Editor::SetFirstVisibleLine(int line) noexcept {
+    if (!m_hwndEdit) return;
+    int currentFirst = GetFirstVisibleLine();
+    if (line != currentFirst) {
+        SendMessageW(m_hwndEdit, EM_LINESCROLL, 0, line - currentFirst);
+    }
+}
+
 //------------------------------------------------------------------------------
 // Set scroll notification callback
 //------------------------------------------------------------------------------
@@ -114,6 +114,11 @@ public:
     // Focus the edit control
     void SetFocus() noexcept;
     
+    // Child window covering the edit control (large file viewer).  It is
+    // kept sized to the client area and takes the focus.
+    void SetOverlay(HWND overlay) noexcept;
+    [[nodiscard]] HWND GetOverlay() const noexcept { return m_hwndOverlay; }
+    
     // Text operations
     [[nodiscard]] std::wstring GetText() const;
     void SetText(std::wstring_view text);
@@ -122,6 +127,14 @@ public:
     // chunks so the UI stays responsive.  Use for content >100 MB.
     void SetTextStreamed(const std::wstring& text, HWND hwndStatus = nullptr);
     
+    // Append text at the end without moving the caret or scroll position,
+    // recording undo or marking the document modified (asynchronous loads)
+    void AppendText(std::wstring_view text);
+    
+    // Read-only state (set while a file is still streaming in)
+    void SetReadOnly(bool readOnly) noexcept;
+    [[nodiscard]] bool IsReadOnly() const noexcept;
+    
     void Clear() noexcept;
     
     // Selection
@@ -139,6 +152,12 @@ public:
     void PushUndoCheckpoint(EditAction action, wchar_t ch = 0);
     void ClearUndoHistory();
     void SealUndoGroup();
+    
+    // Move undo/redo history out of / back into the editor (tab hibernation)
+    void TakeUndoHistory(std::vector<UndoCheckpoint>& undoStack,
+                         std::vector<UndoCheckpoint>& redoStack);
+    void RestoreUndoHistory(std::vector<UndoCheckpoint>&& undoStack,
+                            std::vector<UndoCheckpoint>&& redoStack);
     void Cut() noexcept;
     void Copy() noexcept;
     void Paste() noexcept;
@@ -180,6 +199,11 @@ public:
     void SetLineEnding(LineEnding lineEnding) noexcept;
     [[nodiscard]] LineEnding GetLineEnding() const noexcept { return m_lineEnding; }
     
+    // The loaded file had more than one kind of line ending (cleared by
+    // SetLineEnding and once the file is saved with uniform endings)
+    void SetMixedLineEndings(bool mixed) noexcept { m_mixedLineEndings = mixed; }
+    [[nodiscard]] bool HasMixedLineEndings() const noexcept { return m_mixedLineEndings; }
+    
     // Encoding (for display purposes)
     void SetEncoding(TextEncoding encoding) noexcept;
     [[nodiscard]] TextEncoding GetEncoding() const noexcept { return m_encoding; }
@@ -202,6 +226,7 @@ public:
     
     // Get first visible line (for line numbers sync)
     [[nodiscard]] int GetFirstVisibleLine() const noexcept;
+    void SetFirstVisibleLine(int line) noexcept;
     
     // Scroll lines per wheel notch (0 = system default)
     void SetScrollLines(int lines) noexcept;
@@ -271,6 +296,7 @@ private:
 private:
     HWND m_hwndEdit = nullptr;
     HWND m_hwndParent = nullptr;
+    HWND m_hwndOverlay = nullptr;
     HINSTANCE m_hInstance = nullptr;
     
     FontGuard m_font;
@@ -284,6 +310,7 @@ private:
     int m_tabSize = 4;
     
     LineEnding m_lineEnding = LineEnding::CRLF;
+    bool m_mixedLineEndings = false;
     TextEncoding m_encoding = TextEncoding::UTF8;
     
     bool m_rtl = false;
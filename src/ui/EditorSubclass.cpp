@@ -22,6 +22,24 @@ LRESULT CALLBACK Editor::EditSubclassProc(HWND hwnd, UINT msg, WPARAM wParam,
     Editor* editor = reinterpret_cast<Editor*>(refData);
     
     switch (msg) {
+        case WM_SIZE: {
+            // Keep the overlay (large file viewer) covering the client area
+            LRESULT result = DefSubclassProc(hwnd, msg, wParam, lParam);
+            if (editor->m_hwndOverlay) {
+                RECT rc;
+                GetClientRect(hwnd, &rc);
+                MoveWindow(editor->m_hwndOverlay, 0, 0, rc.right, rc.bottom, TRUE);
+            }
+            return result;
+        }
+
+        case WM_SETFOCUS:
+            if (editor->m_hwndOverlay && IsWindow(editor->m_hwndOverlay)) {
+                ::SetFocus(editor->m_hwndOverlay);
+                return 0;
+            }
+            break;
+
         case WM_PAINT: {
             LRESULT result = DefSubclassProc(hwnd, msg, wParam, lParam);
             if (editor->m_showWhitespace || editor->m_spellCheckEnabled) {
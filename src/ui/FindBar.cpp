@@ -5,6 +5,7 @@
 
 #include "FindBar.h"
 #include "Editor.h"
+#include "Trace.h"
 #include <CommCtrl.h>
 #include <regex>
 #include <windowsx.h>
@@ -110,6 +111,7 @@ void FindBar::Destroy() noexcept {
     m_hwndCaseBtn = nullptr;
     m_hwndWholeWordBtn = nullptr;
     m_hwndRegexBtn = nullptr;
+    m_hwndAllTabsBtn = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -271,6 +273,13 @@ bool FindBar::IsDialogMessage(MSG* pMsg) noexcept {
         }
     }
     
+    // Alt+Enter searches all open documents
+    if (pMsg->message == WM_SYSKEYDOWN && pMsg->wParam == VK_RETURN &&
+        GetFocus() == m_hwndSearchEdit && m_findAllHandler) {
+        FindInAllDocuments();
+        return true;
+    }
+    
     // Handle Enter for search
     if (pMsg->message == WM_KEYDOWN) {
         HWND hwndFocus = GetFocus();
@@ -329,14 +338,19 @@ bool FindBar::DoFind(bool forward) {
         pattern = L"\\b" + std::wstring(searchText) + L"\\b";
     }
     
-    bool found = m_editor->SearchText(
-        m_options.wholeWord ? pattern : searchText,
-        m_options.matchCase,
-        true,  // wrap around
-        !forward,  // searchUp
-        m_options.useRegex || m_options.wholeWord,  // use regex if whole word
-        true   // select match
-    );
+    bool found = false;
+    if (m_findHandler) {
+        found = m_findHandler(m_findHandlerData, searchText, m_options, forward);
+    } else {
+        found = m_editor->SearchText(
+            m_options.wholeWord ? pattern : searchText,
+            m_options.matchCase,
+            true,  // wrap around
+            !forward,  // searchUp
+            m_options.useRegex || m_options.wholeWord,  // use regex if whole word
+            true   // select match
+        );
+    }
     
     UpdateMatchCount();
     
@@ -458,6 +472,16 @@ void FindBar::ReplaceAll() {
     }
 }
 
+//------------------------------------------------------------------------------
+// Hand the search text to the all-documents search
+//------------------------------------------------------------------------------
+void FindBar::FindInAllDocuments() {
+    std::wstring searchText = GetSearchText();
+    if (searchText.empty() || !m_findAllHandler) return;
+    
+    m_findAllHandler(m_findAllHandlerData, searchText, m_options);
+}
+
 //------------------------------------------------------------------------------
 // Get current search text
 //------------------------------------------------------------------------------
@@ -641,6 +665,12 @@ void FindBar::OnCommand(WORD id, WORD code, HWND hwndCtl) {
                 UpdateMatchCount();
             }
             break;
+            
+        case ID_ALLTABS_BTN:
+            if (code == BN_CLICKED) {
+                FindInAllDocuments();
+            }
+            break;
     }
 }
 
@@ -690,6 +720,10 @@ void FindBar::CreateControls() {
     m_hwndRegexBtn = CreateButton(x, y, 32, CONTROL_HEIGHT, L".*", ID_REGEX_BTN, true);
     x += 32 + SPACING * 2;
     
+    // Search all open documents
+    m_hwndAllTabsBtn = CreateButton(x, y, 32, CONTROL_HEIGHT, L"All", ID_ALLTABS_BTN);
+    x += 32 + SPACING * 2;
+    
     // Close button (positioned at right edge, will be handled in LayoutControls)
     m_hwndCloseBtn = CreateButton(0, y, BUTTON_WIDTH, CONTROL_HEIGHT, L"\x2715", ID_CLOSE_BTN);
     
@@ -789,10 +823,13 @@ void FindBar::LayoutControls() {
 // Update match count display
 //------------------------------------------------------------------------------
 void FindBar::UpdateMatchCount() {
+    QNOTE_TRACE_SCOPE("FindBar::UpdateMatchCount");
     if (!m_hwndMatchCount || !m_editor) return;
     
     std::wstring searchText = GetSearchText();
-    if (searchText.empty()) {
+    
+    // Matches are not counted for a custom search engine (large files)
+    if (searchText.empty() || m_findHandler) {
         SetWindowTextW(m_hwndMatchCount, L"");
         m_lastMatchCount = 0;
         return;
@@ -54,6 +54,25 @@ public:
     // Update the editor reference (called on tab switch)
     void SetEditor(Editor* editor) noexcept { m_editor = editor; }
     
+    // Route Find Next/Previous to another search engine (the large file
+    // viewer) instead of the editor; null restores the editor.  The handler
+    // returns true if a match was found.
+    using FindHandler = bool(*)(void* userData, const std::wstring& text,
+                                const FindOptions& options, bool forward);
+    void SetFindHandler(FindHandler handler, void* userData) noexcept {
+        m_findHandler = handler;
+        m_findHandlerData = userData;
+    }
+    
+    // Search every open document for the current text (the "All" button
+    // and Alt+Enter)
+    using FindAllHandler = void(*)(void* userData, const std::wstring& text,
+                                   const FindOptions& options);
+    void SetFindAllHandler(FindAllHandler handler, void* userData) noexcept {
+        m_findAllHandler = handler;
+        m_findAllHandlerData = userData;
+    }
+    
     // Destroy the find bar
     void Destroy() noexcept;
     
@@ -88,6 +107,7 @@ public:
     void FindPrevious();
     void ReplaceNext();
     void ReplaceAll();
+    void FindInAllDocuments();
     
     // Get current search text
     [[nodiscard]] std::wstring GetSearchText() const;
@@ -135,6 +155,10 @@ private:
     HWND m_hwndContainer = nullptr;
     HINSTANCE m_hInstance = nullptr;
     Editor* m_editor = nullptr;
+    FindHandler m_findHandler = nullptr;
+    void* m_findHandlerData = nullptr;
+    FindAllHandler m_findAllHandler = nullptr;
+    void* m_findAllHandlerData = nullptr;
     
     // Child controls
     HWND m_hwndSearchEdit = nullptr;
@@ -148,6 +172,7 @@ private:
     HWND m_hwndCaseBtn = nullptr;
     HWND m_hwndWholeWordBtn = nullptr;
     HWND m_hwndRegexBtn = nullptr;
+    HWND m_hwndAllTabsBtn = nullptr;
     
     // Labels
     HWND m_hwndSearchLabel = nullptr;
@@ -187,6 +212,7 @@ private:
     static constexpr int ID_CASE_BTN = 10008;
     static constexpr int ID_WHOLEWORD_BTN = 10009;
     static constexpr int ID_REGEX_BTN = 10010;
+    static constexpr int ID_ALLTABS_BTN = 10011;
     
     // Window class name
     static constexpr wchar_t FINDBAR_CLASS[] = L"QNoteFindBar";
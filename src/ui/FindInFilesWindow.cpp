@@ -0,0 +1,745 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// FindInFilesWindow.cpp - Find in Files tool window implementation
+//==============================================================================
+
+#include "FindInFilesWindow.h"
+#include "resource.h"
+#include <dwmapi.h>
+#include <shobjidl.h>
+#include <algorithm>
+#include <sstream>
+
+#pragma comment(lib, "comctl32.lib")
+#pragma comment(lib, "dwmapi.lib")
+
+// DWM dark title bar (Windows 10 1809+) - fallback for older SDKs
+#ifndef DWMWA_USE_IMMERSIVE_DARK_MODE
+#define DWMWA_USE_IMMERSIVE_DARK_MODE 20
+#endif
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// FindInFilesWindow Implementation
+//------------------------------------------------------------------------------
+
+FindInFilesWindow::FindInFilesWindow() = default;
+
+FindInFilesWindow::~FindInFilesWindow() {
+    // Join the workers before the window they post to goes away
+    m_search.reset();
+    m_tabSearch.reset();
+    if (m_hwnd) {
+        DestroyWindow(m_hwnd);
+        m_hwnd = nullptr;
+    }
+    if (m_hFont) {
+        DeleteObject(m_hFont);
+    }
+}
+
+bool FindInFilesWindow::Create(HINSTANCE hInstance, HWND parentWindow, TaskScheduler& scheduler) {
+    m_hInstance = hInstance;
+    m_hwndParent = parentWindow;
+    m_scheduler = &scheduler;
+
+    // Initialize common controls
+    INITCOMMONCONTROLSEX icc = {};
+    icc.dwSize = sizeof(icc);
+    icc.dwICC = ICC_LISTVIEW_CLASSES;
+    InitCommonControlsEx(&icc);
+
+    // Register window class
+    WNDCLASSEXW wc = {};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = WindowProc;
+    wc.hInstance = hInstance;
+    wc.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+    wc.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1);
+    wc.lpszClassName = WINDOW_CLASS;
+
+    if (!RegisterClassExW(&wc)) {
+        if (GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+            return false;
+        }
+    }
+
+    // Open below the top edge of the main window
+    RECT parentRect;
+    GetWindowRect(parentWindow, &parentRect);
+    int x = parentRect.left + 40;
+    int y = parentRect.top + 60;
+
+    m_hwnd = CreateWindowExW(
+        WS_EX_TOOLWINDOW,
+        WINDOW_CLASS,
+        L"Find in Files - QNote",
+        WS_OVERLAPPEDWINDOW,
+        x, y, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+        nullptr,  // No parent - independent window
+        nullptr,
+        hInstance,
+        this
+    );
+
+    if (!m_hwnd) {
+        return false;
+    }
+
+    // Round corners on Windows 11
+    DWM_WINDOW_CORNER_PREFERENCE cornerPref = DWMWCP_ROUND;
+    DwmSetWindowAttribute(m_hwnd, DWMWA_WINDOW_CORNER_PREFERENCE, &cornerPref, sizeof(cornerPref));
+
+    // Dark title bar
+    BOOL useDarkTitleBar = TRUE;
+    DwmSetWindowAttribute(m_hwnd, DWMWA_USE_IMMERSIVE_DARK_MODE, &useDarkTitleBar, sizeof(useDarkTitleBar));
+
+    return true;
+}
+
+void FindInFilesWindow::Show(const std::wstring& pattern, const std::wstring& folder) {
+    if (!m_hwnd) return;
+
+    if (!pattern.empty()) {
+        SetWindowTextW(m_hwndPattern, pattern.c_str());
+    }
+    if (!folder.empty() && !m_searching) {
+        SetWindowTextW(m_hwndFolder, folder.c_str());
+    }
+
+    ShowWindow(m_hwnd, SW_SHOW);
+    SetForegroundWindow(m_hwnd);
+    SetFocus(m_hwndPattern);
+    SendMessageW(m_hwndPattern, EM_SETSEL, 0, -1);
+}
+
+void FindInFilesWindow::SearchOpenDocuments(const std::wstring& pattern, const TextSearchOptions& options) {
+    if (!m_hwnd) return;
+
+    SendMessageW(m_hwndOpenDocs, BM_SETCHECK, BST_CHECKED, 0);
+    SendMessageW(m_hwndMatchCase, BM_SETCHECK, options.matchCase ? BST_CHECKED : BST_UNCHECKED, 0);
+    SendMessageW(m_hwndWholeWord, BM_SETCHECK, options.wholeWord ? BST_CHECKED : BST_UNCHECKED, 0);
+    SendMessageW(m_hwndRegex, BM_SETCHECK, options.useRegex ? BST_CHECKED : BST_UNCHECKED, 0);
+    UpdateScopeControls();
+
+    Show(pattern, L"");
+    StartSearch();
+}
+
+void FindInFilesWindow::Hide() {
+    if (m_hwnd) {
+        ShowWindow(m_hwnd, SW_HIDE);
+    }
+}
+
+bool FindInFilesWindow::IsVisible() const {
+    return m_hwnd && IsWindowVisible(m_hwnd);
+}
+
+//------------------------------------------------------------------------------
+// Enter in a text field starts a search; Esc stops it, or hides the window
+//------------------------------------------------------------------------------
+bool FindInFilesWindow::IsDialogMessage(MSG* pMsg) noexcept {
+    if (!m_hwnd || !IsWindowVisible(m_hwnd)) return false;
+    if (pMsg->hwnd != m_hwnd && !IsChild(m_hwnd, pMsg->hwnd)) return false;
+
+    if (pMsg->message == WM_KEYDOWN) {
+        HWND hwndFocus = GetFocus();
+        if (pMsg->wParam == VK_RETURN && hwndFocus != m_hwndList) {
+            StartSearch();
+            return true;
+        }
+        if (pMsg->wParam == VK_ESCAPE) {
+            if (m_searching) {
+                StopSearch();
+            } else {
+                Hide();
+            }
+            return true;
+        }
+    }
+
+    return ::IsDialogMessageW(m_hwnd, pMsg) != FALSE;
+}
+
+LRESULT CALLBACK FindInFilesWindow::WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    FindInFilesWindow* pThis = nullptr;
+
+    if (msg == WM_NCCREATE) {
+        CREATESTRUCTW* cs = reinterpret_cast<CREATESTRUCTW*>(lParam);
+        pThis = static_cast<FindInFilesWindow*>(cs->lpCreateParams);
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pThis));
+        pThis->m_hwnd = hwnd;
+    } else {
+        pThis = reinterpret_cast<FindInFilesWindow*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    }
+
+    if (pThis) {
+        return pThis->HandleMessage(msg, wParam, lParam);
+    }
+
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+LRESULT FindInFilesWindow::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+        case WM_CREATE:
+            OnCreate();
+            return 0;
+
+        case WM_SIZE:
+            OnSize(LOWORD(lParam), HIWORD(lParam));
+            return 0;
+
+        case WM_COMMAND:
+            OnCommand(LOWORD(wParam), HIWORD(wParam), reinterpret_cast<HWND>(lParam));
+            return 0;
+
+        case WM_NOTIFY:
+            OnNotify(reinterpret_cast<NMHDR*>(lParam));
+            return 0;
+
+        case WM_APP_FINDINFILES:
+            if (m_tabSearch) {
+                OnTabSearchResults();
+            } else {
+                OnSearchResults();
+            }
+            return 0;
+
+        case WM_CLOSE:
+            Hide();
+            return 0;
+    }
+
+    return DefWindowProcW(m_hwnd, msg, wParam, lParam);
+}
+
+void FindInFilesWindow::OnCreate() {
+    m_hFont = CreateFontW(
+        -13, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Segoe UI"
+    );
+
+    CreateControls();
+}
+
+void FindInFilesWindow::OnSize(int width, int height) {
+    const int labelGap = PADDING / 2;
+    const int fieldX = PADDING + LABEL_WIDTH + labelGap;
+    const int buttonX = width - PADDING - BUTTON_WIDTH;
+    const int fieldWidth = buttonX - PADDING - fieldX;
+    int y = PADDING;
+
+    auto placeLabel = [&](size_t index, int x, int rowY) {
+        if (index < m_labels.size()) {
+            SetWindowPos(m_labels[index], nullptr, x, rowY + 4, LABEL_WIDTH, ROW_HEIGHT - 4, SWP_NOZORDER);
+        }
+    };
+
+    // Find row
+    placeLabel(0, PADDING, y);
+    SetWindowPos(m_hwndPattern, nullptr, fieldX, y, fieldWidth, ROW_HEIGHT, SWP_NOZORDER);
+    SetWindowPos(m_hwndSearchBtn, nullptr, buttonX, y, BUTTON_WIDTH, ROW_HEIGHT, SWP_NOZORDER);
+    y += ROW_HEIGHT + PADDING / 2;
+
+    // Folder row
+    const int browseWidth = 32;
+    placeLabel(1, PADDING, y);
+    SetWindowPos(m_hwndFolder, nullptr, fieldX, y, fieldWidth - browseWidth - labelGap, ROW_HEIGHT, SWP_NOZORDER);
+    SetWindowPos(m_hwndBrowseBtn, nullptr, fieldX + fieldWidth - browseWidth, y, browseWidth, ROW_HEIGHT, SWP_NOZORDER);
+    SetWindowPos(m_hwndStopBtn, nullptr, buttonX, y, BUTTON_WIDTH, ROW_HEIGHT, SWP_NOZORDER);
+    y += ROW_HEIGHT + PADDING / 2;
+
+    // Include / exclude row
+    const int halfWidth = (fieldWidth - LABEL_WIDTH - labelGap - PADDING) / 2;
+    placeLabel(2, PADDING, y);
+    SetWindowPos(m_hwndInclude, nullptr, fieldX, y, halfWidth, ROW_HEIGHT, SWP_NOZORDER);
+    const int excludeLabelX = fieldX + halfWidth + PADDING;
+    placeLabel(3, excludeLabelX, y);
+    SetWindowPos(m_hwndExclude, nullptr, excludeLabelX + LABEL_WIDTH + labelGap, y,
+                 fieldX + fieldWidth - (excludeLabelX + LABEL_WIDTH + labelGap), ROW_HEIGHT, SWP_NOZORDER);
+    y += ROW_HEIGHT + PADDING / 2;
+
+    // Options row
+    const int checkWidth = 110;
+    int x = fieldX;
+    for (HWND check : { m_hwndMatchCase, m_hwndWholeWord, m_hwndRegex, m_hwndSubfolders, m_hwndOpenDocs }) {
+        SetWindowPos(check, nullptr, x, y, checkWidth, ROW_HEIGHT, SWP_NOZORDER);
+        x += checkWidth + PADDING;
+    }
+    y += ROW_HEIGHT + PADDING;
+
+    // Results
+    int listHeight = height - y - STATUS_HEIGHT - PADDING;
+    if (listHeight < 0) listHeight = 0;
+    SetWindowPos(m_hwndList, nullptr, PADDING, y, width - PADDING * 2, listHeight, SWP_NOZORDER);
+
+    // Status bar
+    y += listHeight + PADDING / 2;
+    SetWindowPos(m_hwndStatus, nullptr, PADDING, y, width - PADDING * 2, STATUS_HEIGHT, SWP_NOZORDER);
+}
+
+void FindInFilesWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
+    (void)code;
+    (void)hwndCtl;
+    switch (id) {
+        case IDC_SEARCH_BTN:
+            StartSearch();
+            break;
+
+        case IDC_STOP_BTN:
+            StopSearch();
+            break;
+
+        case IDC_BROWSE_BTN:
+            BrowseFolder();
+            break;
+
+        case IDC_OPENDOCS_CHECK:
+            UpdateScopeControls();
+            break;
+    }
+}
+
+void FindInFilesWindow::OnNotify(NMHDR* pnmh) {
+    if (pnmh->hwndFrom != m_hwndList) return;
+
+    switch (pnmh->code) {
+        case LVN_GETDISPINFOW: {
+            NMLVDISPINFOW* pdi = reinterpret_cast<NMLVDISPINFOW*>(pnmh);
+            if (!(pdi->item.mask & LVIF_TEXT)) break;
+            int index = pdi->item.iItem;
+            if (index < 0 || index >= static_cast<int>(m_rows.size())) break;
+
+            const ResultRow& row = m_rows[index];
+            if (m_tabSearch) {
+                const TabSearchResult& tab = m_tabs[row.fileIndex];
+                if (row.hitIndex == GROUP_ROW) {
+                    if (pdi->item.iSubItem == 0) {
+                        m_displayText = tab.title;
+                    } else if (pdi->item.iSubItem == 2) {
+                        m_displayText = std::to_wstring(tab.matchCount) +
+                                        (tab.matchCount == 1 ? L" match" : L" matches");
+                        if (tab.matchCount > tab.hits.size()) {
+                            m_displayText += L" (first " + std::to_wstring(tab.hits.size()) + L" listed)";
+                        }
+                    } else {
+                        m_displayText.clear();
+                    }
+                } else {
+                    const TextLineHit& hit = tab.hits[row.hitIndex];
+                    if (pdi->item.iSubItem == 0) {
+                        m_displayText.clear();
+                    } else if (pdi->item.iSubItem == 1) {
+                        m_displayText = std::to_wstring(hit.line + 1);
+                    } else {
+                        m_displayText = hit.preview;
+                    }
+                }
+                pdi->item.pszText = const_cast<LPWSTR>(m_displayText.c_str());
+                break;
+            }
+
+            const FindInFilesFileResult& file = m_files[row.fileIndex];
+            const FindInFilesHit& hit = file.hits[row.hitIndex];
+
+            switch (pdi->item.iSubItem) {
+                case 0: {
+                    // Path relative to the searched folder
+                    size_t prefix = m_searchFolder.size();
+                    if (prefix > 0 && m_searchFolder.back() != L'\\') prefix++;
+                    m_displayText = (file.filePath.size() > prefix) ? file.filePath.substr(prefix)
+                                                                     : file.filePath;
+                    break;
+                }
+                case 1:
+                    m_displayText = std::to_wstring(hit.line + 1);
+                    break;
+                default:
+                    m_displayText = hit.preview;
+                    break;
+            }
+            pdi->item.pszText = const_cast<LPWSTR>(m_displayText.c_str());
+            break;
+        }
+
+        case NM_DBLCLK: {
+            NMITEMACTIVATE* pnmia = reinterpret_cast<NMITEMACTIVATE*>(pnmh);
+            if (pnmia->iItem >= 0) {
+                OnListItemActivated(pnmia->iItem);
+            }
+            break;
+        }
+
+        case LVN_KEYDOWN: {
+            NMLVKEYDOWN* pnkd = reinterpret_cast<NMLVKEYDOWN*>(pnmh);
+            if (pnkd->wVKey == VK_RETURN) {
+                int sel = ListView_GetNextItem(m_hwndList, -1, LVNI_SELECTED);
+                if (sel >= 0) {
+                    OnListItemActivated(sel);
+                }
+            }
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Append the results the workers have queued since the last message
+//------------------------------------------------------------------------------
+void FindInFilesWindow::OnSearchResults() {
+    if (!m_search) return;
+
+    std::vector<FindInFilesFileResult> batch = m_search->TakeResults();
+    bool finished = m_search->IsFinished();
+
+    for (auto& file : batch) {
+        uint32_t fileIndex = static_cast<uint32_t>(m_files.size());
+        for (uint32_t hit = 0; hit < static_cast<uint32_t>(file.hits.size()); hit++) {
+            m_rows.push_back({ fileIndex, hit });
+        }
+        m_files.push_back(std::move(file));
+    }
+    if (!batch.empty()) {
+        ListView_SetItemCountEx(m_hwndList, static_cast<int>(m_rows.size()),
+                                LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+    }
+
+    if (finished && m_searching) {
+        m_searching = false;
+        m_searchElapsed = GetTickCount() - m_searchStartTick;
+        UpdateButtons();
+    }
+    UpdateStatusText();
+}
+
+//------------------------------------------------------------------------------
+// Append open-document results: a heading row per tab, then its hits.  When
+// the search ends the tabs are put back in tab order.
+//------------------------------------------------------------------------------
+void FindInFilesWindow::OnTabSearchResults() {
+    if (!m_tabSearch) return;
+
+    std::vector<TabSearchResult> batch = m_tabSearch->TakeResults();
+    bool finished = m_tabSearch->IsFinished();
+
+    for (auto& tab : batch) {
+        uint32_t tabIndex = static_cast<uint32_t>(m_tabs.size());
+        m_rows.push_back({ tabIndex, GROUP_ROW });
+        for (uint32_t hit = 0; hit < static_cast<uint32_t>(tab.hits.size()); hit++) {
+            m_rows.push_back({ tabIndex, hit });
+        }
+        m_tabs.push_back(std::move(tab));
+    }
+
+    if (finished && m_searching) {
+        m_searching = false;
+        m_searchElapsed = GetTickCount() - m_searchStartTick;
+        RebuildTabRows();
+        UpdateButtons();
+    } else if (!batch.empty()) {
+        ListView_SetItemCountEx(m_hwndList, static_cast<int>(m_rows.size()),
+                                LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+    }
+    UpdateStatusText();
+}
+
+void FindInFilesWindow::RebuildTabRows() {
+    std::sort(m_tabs.begin(), m_tabs.end(),
+              [](const TabSearchResult& a, const TabSearchResult& b) { return a.order < b.order; });
+
+    m_rows.clear();
+    for (uint32_t tabIndex = 0; tabIndex < static_cast<uint32_t>(m_tabs.size()); tabIndex++) {
+        m_rows.push_back({ tabIndex, GROUP_ROW });
+        for (uint32_t hit = 0; hit < static_cast<uint32_t>(m_tabs[tabIndex].hits.size()); hit++) {
+            m_rows.push_back({ tabIndex, hit });
+        }
+    }
+    ListView_SetItemCountEx(m_hwndList, static_cast<int>(m_rows.size()), LVSICF_NOSCROLL);
+    InvalidateRect(m_hwndList, nullptr, FALSE);
+}
+
+//------------------------------------------------------------------------------
+// Start a new search with the current field values
+//------------------------------------------------------------------------------
+void FindInFilesWindow::StartSearch() {
+    FindInFilesQuery query;
+    query.pattern = GetControlText(m_hwndPattern);
+    query.directory = GetControlText(m_hwndFolder);
+    query.include = GetControlText(m_hwndInclude);
+    query.exclude = GetControlText(m_hwndExclude);
+    query.options.matchCase = SendMessageW(m_hwndMatchCase, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    query.options.wholeWord = SendMessageW(m_hwndWholeWord, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    query.options.useRegex = SendMessageW(m_hwndRegex, BM_GETCHECK, 0, 0) == BST_CHECKED;
+    query.recursive = SendMessageW(m_hwndSubfolders, BM_GETCHECK, 0, 0) == BST_CHECKED;
+
+    // Drop the previous search and its results
+    m_search.reset();
+    m_tabSearch.reset();
+    m_searching = false;
+    m_files.clear();
+    m_tabs.clear();
+    m_rows.clear();
+    ListView_SetItemCountEx(m_hwndList, 0, 0);
+
+    HWND hwnd = m_hwnd;
+    auto notify = [hwnd]() { PostMessageW(hwnd, WM_APP_FINDINFILES, 0, 0); };
+    std::wstring error;
+
+    if (IsOpenDocumentsScope()) {
+        auto tabSearch = std::make_unique<TabSearch>(*m_scheduler);
+        std::vector<TabSearchSource> sources;
+        if (m_tabSourceCallback) sources = m_tabSourceCallback();
+        if (!tabSearch->Start(std::move(sources), query.pattern, query.options, notify, error)) {
+            SetWindowTextW(m_hwndStatus, error.c_str());
+            UpdateButtons();
+            return;
+        }
+        m_tabSearch = std::move(tabSearch);
+    } else {
+        auto search = std::make_unique<FindInFilesSearch>(*m_scheduler);
+        if (!search->Start(query, notify, error)) {
+            SetWindowTextW(m_hwndStatus, error.c_str());
+            UpdateButtons();
+            return;
+        }
+        m_search = std::move(search);
+        m_searchFolder = query.directory;
+    }
+
+    m_searching = true;
+    m_searchStartTick = GetTickCount();
+    UpdateButtons();
+    UpdateStatusText();
+}
+
+void FindInFilesWindow::StopSearch() {
+    if (!m_searching) return;
+    if (m_tabSearch) {
+        m_tabSearch->Cancel();
+        OnTabSearchResults();
+    } else if (m_search) {
+        m_search->Cancel();
+        OnSearchResults();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Pick the folder to search
+//------------------------------------------------------------------------------
+void FindInFilesWindow::BrowseFolder() {
+    IFileOpenDialog* dialog = nullptr;
+    if (FAILED(CoCreateInstance(CLSID_FileOpenDialog, nullptr, CLSCTX_INPROC_SERVER,
+                                IID_PPV_ARGS(&dialog)))) {
+        return;
+    }
+
+    DWORD options = 0;
+    dialog->GetOptions(&options);
+    dialog->SetOptions(options | FOS_PICKFOLDERS | FOS_FORCEFILESYSTEM | FOS_PATHMUSTEXIST);
+    dialog->SetTitle(L"Search in Folder");
+
+    if (SUCCEEDED(dialog->Show(m_hwnd))) {
+        IShellItem* item = nullptr;
+        if (SUCCEEDED(dialog->GetResult(&item))) {
+            PWSTR path = nullptr;
+            if (SUCCEEDED(item->GetDisplayName(SIGDN_FILESYSPATH, &path))) {
+                SetWindowTextW(m_hwndFolder, path);
+                CoTaskMemFree(path);
+            }
+            item->Release();
+        }
+    }
+    dialog->Release();
+}
+
+void FindInFilesWindow::OnListItemActivated(int index) {
+    if (index < 0 || index >= static_cast<int>(m_rows.size())) return;
+
+    const ResultRow& row = m_rows[index];
+    if (m_tabSearch) {
+        // A heading row opens the tab at its first hit
+        const TabSearchResult& tab = m_tabs[row.fileIndex];
+        if (tab.hits.empty() || !m_tabOpenCallback) return;
+        const TextLineHit& hit = tab.hits[row.hitIndex == GROUP_ROW ? 0 : row.hitIndex];
+        m_tabOpenCallback(tab.tabId, static_cast<int>(hit.line),
+                          static_cast<int>(hit.column), static_cast<int>(hit.length));
+        return;
+    }
+
+    const FindInFilesFileResult& file = m_files[row.fileIndex];
+    const FindInFilesHit& hit = file.hits[row.hitIndex];
+    if (m_openCallback) {
+        m_openCallback(file.filePath, static_cast<int>(hit.line),
+                       static_cast<int>(hit.column), static_cast<int>(hit.length));
+    }
+}
+
+void FindInFilesWindow::CreateControls() {
+    auto createLabel = [this](const wchar_t* text) {
+        HWND label = CreateWindowExW(
+            0, L"STATIC", text,
+            WS_CHILD | WS_VISIBLE | SS_LEFT,
+            0, 0, LABEL_WIDTH, ROW_HEIGHT,
+            m_hwnd, nullptr, m_hInstance, nullptr
+        );
+        m_labels.push_back(label);
+    };
+    auto createEdit = [this](int id, const wchar_t* text, const wchar_t* cue) {
+        HWND edit = CreateWindowExW(
+            WS_EX_CLIENTEDGE, L"EDIT", text,
+            WS_CHILD | WS_VISIBLE | WS_TABSTOP | ES_AUTOHSCROLL,
+            0, 0, 200, ROW_HEIGHT,
+            m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(id)), m_hInstance, nullptr
+        );
+        if (cue) {
+            SendMessageW(edit, EM_SETCUEBANNER, FALSE, reinterpret_cast<LPARAM>(cue));
+        }
+        return edit;
+    };
+    auto createButton = [this](int id, const wchar_t* text, DWORD style) {
+        return CreateWindowExW(
+            0, L"BUTTON", text,
+            WS_CHILD | WS_VISIBLE | WS_TABSTOP | style,
+            0, 0, BUTTON_WIDTH, ROW_HEIGHT,
+            m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(id)), m_hInstance, nullptr
+        );
+    };
+
+    // Created in tab order
+    createLabel(L"Find:");
+    m_hwndPattern = createEdit(IDC_PATTERN_EDIT, L"", L"Text or regular expression");
+    createLabel(L"Folder:");
+    m_hwndFolder = createEdit(IDC_FOLDER_EDIT, L"", nullptr);
+    m_hwndBrowseBtn = createButton(IDC_BROWSE_BTN, L"...", BS_PUSHBUTTON);
+    createLabel(L"Include:");
+    m_hwndInclude = createEdit(IDC_INCLUDE_EDIT, L"", L"*.cpp;*.h (all files if empty)");
+    createLabel(L"Exclude:");
+    m_hwndExclude = createEdit(IDC_EXCLUDE_EDIT, DEFAULT_EXCLUDE, nullptr);
+
+    m_hwndMatchCase = createButton(IDC_MATCHCASE_CHECK, L"Match case", BS_AUTOCHECKBOX);
+    m_hwndWholeWord = createButton(IDC_WHOLEWORD_CHECK, L"Whole word", BS_AUTOCHECKBOX);
+    m_hwndRegex = createButton(IDC_REGEX_CHECK, L"Regex", BS_AUTOCHECKBOX);
+    m_hwndSubfolders = createButton(IDC_SUBFOLDERS_CHECK, L"Subfolders", BS_AUTOCHECKBOX);
+    SendMessageW(m_hwndSubfolders, BM_SETCHECK, BST_CHECKED, 0);
+    m_hwndOpenDocs = createButton(IDC_OPENDOCS_CHECK, L"Open documents", BS_AUTOCHECKBOX);
+
+    m_hwndSearchBtn = createButton(IDC_SEARCH_BTN, L"Search", BS_DEFPUSHBUTTON);
+    m_hwndStopBtn = createButton(IDC_STOP_BTN, L"Stop", BS_PUSHBUTTON);
+
+    // Results: owner-data list, rows are produced on demand from m_rows
+    m_hwndList = CreateWindowExW(
+        WS_EX_CLIENTEDGE,
+        WC_LISTVIEWW, L"",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | LVS_REPORT | LVS_SHOWSELALWAYS | LVS_SINGLESEL | LVS_OWNERDATA,
+        0, 0, 400, 300,
+        m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_RESULT_LIST)), m_hInstance, nullptr
+    );
+    ListView_SetExtendedListViewStyle(m_hwndList, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER);
+
+    LVCOLUMNW lvc = {};
+    lvc.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
+
+    lvc.iSubItem = 0;
+    lvc.pszText = const_cast<LPWSTR>(L"File");
+    lvc.cx = 220;
+    ListView_InsertColumn(m_hwndList, 0, &lvc);
+
+    lvc.iSubItem = 1;
+    lvc.pszText = const_cast<LPWSTR>(L"Line");
+    lvc.cx = 60;
+    ListView_InsertColumn(m_hwndList, 1, &lvc);
+
+    lvc.iSubItem = 2;
+    lvc.pszText = const_cast<LPWSTR>(L"Text");
+    lvc.cx = 400;
+    ListView_InsertColumn(m_hwndList, 2, &lvc);
+
+    // Status label
+    m_hwndStatus = CreateWindowExW(
+        0, L"STATIC", L"",
+        WS_CHILD | WS_VISIBLE | SS_LEFT | SS_ENDELLIPSIS,
+        0, 0, 300, STATUS_HEIGHT,
+        m_hwnd, nullptr, m_hInstance, nullptr
+    );
+
+    // Set fonts
+    if (m_hFont) {
+        for (HWND child : m_labels) {
+            SendMessageW(child, WM_SETFONT, reinterpret_cast<WPARAM>(m_hFont), TRUE);
+        }
+        for (HWND child : { m_hwndPattern, m_hwndFolder, m_hwndBrowseBtn, m_hwndInclude, m_hwndExclude,
+                            m_hwndMatchCase, m_hwndWholeWord, m_hwndRegex, m_hwndSubfolders, m_hwndOpenDocs,
+                            m_hwndSearchBtn, m_hwndStopBtn, m_hwndList, m_hwndStatus }) {
+            SendMessageW(child, WM_SETFONT, reinterpret_cast<WPARAM>(m_hFont), TRUE);
+        }
+    }
+
+    UpdateButtons();
+}
+
+void FindInFilesWindow::UpdateButtons() {
+    EnableWindow(m_hwndStopBtn, m_searching);
+}
+
+// The folder fields do not apply when searching the open documents
+void FindInFilesWindow::UpdateScopeControls() {
+    BOOL folderScope = IsOpenDocumentsScope() ? FALSE : TRUE;
+    for (HWND control : { m_hwndFolder, m_hwndBrowseBtn, m_hwndInclude, m_hwndExclude, m_hwndSubfolders }) {
+        EnableWindow(control, folderScope);
+    }
+}
+
+bool FindInFilesWindow::IsOpenDocumentsScope() const {
+    return SendMessageW(m_hwndOpenDocs, BM_GETCHECK, 0, 0) == BST_CHECKED;
+}
+
+void FindInFilesWindow::UpdateStatusText() {
+    if (!m_hwndStatus || (!m_search && !m_tabSearch)) return;
+
+    std::wstringstream ss;
+    bool cancelled = false;
+    if (m_tabSearch) {
+        TabSearchStats stats = m_tabSearch->GetStats();
+        ss << stats.matches << L" match(es) in " << stats.documentsMatched << L" of "
+           << stats.documentsSearched << L" document(s)";
+        if (stats.documentsSkipped > 0) {
+            ss << L", " << stats.documentsSkipped << L" could not be read";
+        }
+        cancelled = m_tabSearch->WasCancelled();
+    } else {
+        FindInFilesStats stats = m_search->GetStats();
+        ss << stats.hits << L" match(es) in " << stats.filesMatched << L" file(s), "
+           << stats.filesSearched << L" file(s) searched";
+        if (stats.filesSkipped > 0) {
+            ss << L", " << stats.filesSkipped << L" skipped";
+        }
+        if (stats.truncated) {
+            ss << L" | Stopped at " << stats.hits << L" matches";
+        }
+        cancelled = m_search->WasCancelled();
+    }
+
+    if (m_searching) {
+        ss << L" | Searching...";
+    } else if (cancelled) {
+        ss << L" | Stopped";
+    } else {
+        ss << L" | " << (m_searchElapsed / 1000) << L'.' << ((m_searchElapsed % 1000) / 100) << L" s";
+    }
+    SetWindowTextW(m_hwndStatus, ss.str().c_str());
+}
+
+std::wstring FindInFilesWindow::GetControlText(HWND hwnd) const {
+    int len = GetWindowTextLengthW(hwnd);
+    if (len <= 0) return std::wstring();
+    std::wstring text(len + 1, L'\0');
+    GetWindowTextW(hwnd, &text[0], len + 1);
+    text.resize(len);
+    return text;
+}
+
+} // namespace QNote
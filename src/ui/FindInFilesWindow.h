@@ -0,0 +1,179 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// FindInFilesWindow.h - Find in Files tool window
+//==============================================================================
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <CommCtrl.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FindInFiles.h"
+#include "TabSearch.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Callback when the user opens a hit: file, 0-based line, column and length
+//------------------------------------------------------------------------------
+using FindInFilesOpenCallback =
+    std::function<void(const std::wstring& filePath, int line, int column, int length)>;
+
+// Open documents scope: snapshot the tabs, and open a hit in a tab
+using FindInTabsSourceCallback = std::function<std::vector<TabSearchSource>()>;
+using FindInTabsOpenCallback = std::function<void(int tabId, int line, int column, int length)>;
+
+//------------------------------------------------------------------------------
+// Find in Files window.  Searches a folder (FindInFilesSearch) or the open
+// documents (TabSearch) on worker threads; results are appended to a
+// virtual list view as they arrive, so the window stays responsive however
+// many files, tabs or hits there are.  Open-document results are grouped
+// under one row per tab with its match count.
+//------------------------------------------------------------------------------
+class FindInFilesWindow {
+public:
+    FindInFilesWindow();
+    ~FindInFilesWindow();
+
+    // Prevent copying
+    FindInFilesWindow(const FindInFilesWindow&) = delete;
+    FindInFilesWindow& operator=(const FindInFilesWindow&) = delete;
+
+    // Initialize and create the window; searches run on 'scheduler'
+    [[nodiscard]] bool Create(HINSTANCE hInstance, HWND parentWindow, TaskScheduler& scheduler);
+
+    // Show the window, optionally prefilling the pattern and folder
+    void Show(const std::wstring& pattern, const std::wstring& folder);
+    void Hide();
+    [[nodiscard]] bool IsVisible() const;
+
+    // Show the window and search the open documents right away
+    void SearchOpenDocuments(const std::wstring& pattern, const TextSearchOptions& options);
+
+    // Keyboard handling for the message loop (Tab, Enter, Esc)
+    [[nodiscard]] bool IsDialogMessage(MSG* pMsg) noexcept;
+
+    // Set callbacks
+    void SetOpenCallback(FindInFilesOpenCallback callback) { m_openCallback = std::move(callback); }
+    void SetTabCallbacks(FindInTabsSourceCallback sourceCallback, FindInTabsOpenCallback openCallback) {
+        m_tabSourceCallback = std::move(sourceCallback);
+        m_tabOpenCallback = std::move(openCallback);
+    }
+
+    // Get window handle
+    [[nodiscard]] HWND GetHandle() const { return m_hwnd; }
+
+private:
+    // One list row: a hit inside one of m_files (or m_tabs), or with
+    // GROUP_ROW the heading of a tab's hits
+    struct ResultRow {
+        uint32_t fileIndex;
+        uint32_t hitIndex;
+    };
+    static constexpr uint32_t GROUP_ROW = 0xFFFFFFFF;
+
+    // Window procedure
+    static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    LRESULT HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam);
+
+    // Message handlers
+    void OnCreate();
+    void OnSize(int width, int height);
+    void OnCommand(WORD id, WORD code, HWND hwndCtl);
+    void OnNotify(NMHDR* pnmh);
+    void OnSearchResults();
+    void OnTabSearchResults();
+
+    // Search control
+    void StartSearch();
+    void StopSearch();
+    void BrowseFolder();
+    void OnListItemActivated(int index);
+
+    // UI helpers
+    void CreateControls();
+    void UpdateButtons();
+    void UpdateScopeControls();
+    void RebuildTabRows();
+    [[nodiscard]] bool IsOpenDocumentsScope() const;
+    void UpdateStatusText();
+    [[nodiscard]] std::wstring GetControlText(HWND hwnd) const;
+
+private:
+    HWND m_hwnd = nullptr;
+    HWND m_hwndParent = nullptr;
+    HWND m_hwndPattern = nullptr;
+    HWND m_hwndFolder = nullptr;
+    HWND m_hwndBrowseBtn = nullptr;
+    HWND m_hwndInclude = nullptr;
+    HWND m_hwndExclude = nullptr;
+    HWND m_hwndMatchCase = nullptr;
+    HWND m_hwndWholeWord = nullptr;
+    HWND m_hwndRegex = nullptr;
+    HWND m_hwndSubfolders = nullptr;
+    HWND m_hwndOpenDocs = nullptr;
+    HWND m_hwndSearchBtn = nullptr;
+    HWND m_hwndStopBtn = nullptr;
+    HWND m_hwndList = nullptr;
+    HWND m_hwndStatus = nullptr;
+    std::vector<HWND> m_labels;
+    HINSTANCE m_hInstance = nullptr;
+    HFONT m_hFont = nullptr;
+    TaskScheduler* m_scheduler = nullptr;
+
+    std::unique_ptr<FindInFilesSearch> m_search;
+    std::unique_ptr<TabSearch> m_tabSearch;
+    std::wstring m_searchFolder;                 // Folder of the current results
+    std::vector<FindInFilesFileResult> m_files;
+    std::vector<TabSearchResult> m_tabs;
+    std::vector<ResultRow> m_rows;
+    std::wstring m_displayText;                  // Backs LVN_GETDISPINFO text
+    DWORD m_searchStartTick = 0;
+    DWORD m_searchElapsed = 0;
+    bool m_searching = false;
+
+    FindInFilesOpenCallback m_openCallback;
+    FindInTabsSourceCallback m_tabSourceCallback;
+    FindInTabsOpenCallback m_tabOpenCallback;
+
+    // Window dimensions
+    static constexpr int DEFAULT_WIDTH = 720;
+    static constexpr int DEFAULT_HEIGHT = 520;
+    static constexpr int ROW_HEIGHT = 24;
+    static constexpr int LABEL_WIDTH = 56;
+    static constexpr int BUTTON_WIDTH = 76;
+    static constexpr int STATUS_HEIGHT = 22;
+    static constexpr int PADDING = 8;
+
+    // Window class name
+    static constexpr wchar_t WINDOW_CLASS[] = L"QNoteFindInFilesWindow";
+
+    // Default folders and files to skip
+    static constexpr wchar_t DEFAULT_EXCLUDE[] = L".git;.svn;.hg;node_modules;*.exe;*.dll;*.obj;*.pdb";
+
+    // Control IDs
+    static constexpr int IDC_PATTERN_EDIT = 2101;
+    static constexpr int IDC_FOLDER_EDIT = 2102;
+    static constexpr int IDC_BROWSE_BTN = 2103;
+    static constexpr int IDC_INCLUDE_EDIT = 2104;
+    static constexpr int IDC_EXCLUDE_EDIT = 2105;
+    static constexpr int IDC_MATCHCASE_CHECK = 2106;
+    static constexpr int IDC_WHOLEWORD_CHECK = 2107;
+    static constexpr int IDC_REGEX_CHECK = 2108;
+    static constexpr int IDC_SUBFOLDERS_CHECK = 2109;
+    static constexpr int IDC_SEARCH_BTN = 2110;
+    static constexpr int IDC_STOP_BTN = 2111;
+    static constexpr int IDC_RESULT_LIST = 2112;
+    static constexpr int IDC_OPENDOCS_CHECK = 2113;
+};
+
+} // namespace QNote
@@ -0,0 +1,1103 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LargeFileView.cpp - Read-only virtualized viewer for very large files
+//==============================================================================
+
+#include "LargeFileView.h"
+#include "FileIO.h"
+#include "LineIndexCache.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cwchar>
+
+namespace QNote {
+
+// Static member initialization
+bool LargeFileView::s_classRegistered = false;
+
+namespace {
+
+// Bytes examined to detect the encoding and line ending
+constexpr uint64_t FORMAT_PROBE_BYTES = 64 * 1024;
+
+// Colors
+constexpr COLORREF CURRENT_LINE_COLOR = RGB(232, 242, 254);
+constexpr COLORREF MATCH_COLOR = RGB(255, 225, 120);
+constexpr COLORREF GUTTER_BG_COLOR = RGB(240, 240, 240);
+constexpr COLORREF GUTTER_TEXT_COLOR = RGB(100, 100, 100);
+constexpr COLORREF GUTTER_BORDER_COLOR = RGB(200, 200, 200);
+constexpr COLORREF GUTTER_CURRENT_COLOR = RGB(30, 30, 30);
+constexpr COLORREF PLACEHOLDER_COLOR = RGB(128, 128, 128);
+
+// Length of the byte order mark at the start of 'data', if it matches 'encoding'
+uint64_t BomLength(const uint8_t* data, uint64_t size, TextEncoding encoding) noexcept {
+    switch (encoding) {
+        case TextEncoding::UTF8_BOM:
+            return (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) ? 3 : 0;
+        case TextEncoding::UTF16_LE:
+            return (size >= 2 && data[0] == 0xFF && data[1] == 0xFE) ? 2 : 0;
+        case TextEncoding::UTF16_BE:
+            return (size >= 2 && data[0] == 0xFE && data[1] == 0xFF) ? 2 : 0;
+        default:
+            return 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Index worker: resume from the file's sidecar when it still matches, scan
+// the rest, and save the finished scan for the next open
+//------------------------------------------------------------------------------
+void RunIndexTask(LineOffsetIndex* index, const std::atomic<bool>* cancel,
+                  const uint8_t* data, const LineIndexSnapshot& current,
+                  const std::wstring& cacheDir) {
+    LineIndexReuse reuse = LineIndexReuse::None;
+    std::wstring sidecarPath;
+    if (!cacheDir.empty()) {
+        sidecarPath = LineIndexCache::GetSidecarPath(cacheDir, current.filePath);
+        LineIndexSnapshot saved;
+        if (LineIndexCache::Load(sidecarPath, saved)) {
+            reuse = LineIndexCache::Validate(saved, current, data);
+            if (reuse != LineIndexReuse::None &&
+                !index->Restore(saved.scannedBytes, saved.newlines, std::move(saved.checkpoints))) {
+                reuse = LineIndexReuse::None;
+            }
+        }
+    }
+
+    if (!index->Build(cancel) || sidecarPath.empty() || reuse == LineIndexReuse::Full) {
+        return;
+    }
+
+    LineIndexSnapshot snapshot = current;
+    index->GetScanState(snapshot.scannedBytes, snapshot.newlines, snapshot.checkpoints);
+    LineIndexCache::ComputeFingerprint(snapshot, data);
+    CreateDirectoryW(cacheDir.c_str(), nullptr);
+    LineIndexCache::Save(sidecarPath, snapshot);
+}
+
+} // anonymous namespace
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+LargeFileView::~LargeFileView() {
+    Close();
+}
+
+//------------------------------------------------------------------------------
+// Map the file, create the view window and start indexing
+//------------------------------------------------------------------------------
+bool LargeFileView::Open(HWND parent, HINSTANCE hInstance, const std::wstring& filePath,
+                         std::wstring& errorMessage) {
+    Close();
+    m_hwndParent = parent;
+    m_hInstance = hInstance;
+    m_filePath = filePath;
+
+    // Other readers may open the file; writers are refused while it is mapped
+    m_hFile = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                          nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE) {
+        errorMessage = FileIO::FormatLastError(GetLastError());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_hFile, &fileSize)) {
+        errorMessage = FileIO::FormatLastError(GetLastError());
+        Close();
+        return false;
+    }
+    if (fileSize.QuadPart == 0) {
+        errorMessage = L"The file is empty.";
+        Close();
+        return false;
+    }
+    m_size = static_cast<uint64_t>(fileSize.QuadPart);
+
+    FILETIME writeTime = {};
+    GetFileTime(m_hFile, nullptr, nullptr, &writeTime);
+    m_lastWriteTime = (static_cast<uint64_t>(writeTime.dwHighDateTime) << 32) | writeTime.dwLowDateTime;
+
+    // The whole file is mapped as one view; a 32-bit process may not have
+    // the address space for it
+    if (m_size > static_cast<uint64_t>(SIZE_MAX)) {
+        errorMessage = L"The file is too large to map into memory.";
+        Close();
+        return false;
+    }
+    m_hMapping = CreateFileMappingW(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping) {
+        errorMessage = FileIO::FormatLastError(GetLastError());
+        Close();
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        DWORD error = GetLastError();
+        errorMessage = (error == ERROR_NOT_ENOUGH_MEMORY)
+            ? L"The file is too large to map into memory."
+            : FileIO::FormatLastError(error);
+        Close();
+        return false;
+    }
+
+    // Register window class if not already done
+    if (!s_classRegistered) {
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.style = 0;
+        wc.lpfnWndProc = ViewWndProc;
+        wc.hInstance = hInstance;
+        wc.hCursor = LoadCursorW(nullptr, IDC_IBEAM);
+        wc.hbrBackground = nullptr;  // We'll paint the background ourselves
+        wc.lpszClassName = VIEW_CLASS;
+
+        if (!RegisterClassExW(&wc)) {
+            errorMessage = FileIO::FormatLastError(GetLastError());
+            Close();
+            return false;
+        }
+        s_classRegistered = true;
+    }
+
+    RECT rc = {};
+    GetClientRect(parent, &rc);
+    m_hwnd = CreateWindowExW(
+        0,
+        VIEW_CLASS,
+        L"",
+        WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL,
+        0, 0, rc.right, rc.bottom,
+        parent,
+        nullptr,
+        hInstance,
+        nullptr
+    );
+    if (!m_hwnd) {
+        errorMessage = FileIO::FormatLastError(GetLastError());
+        Close();
+        return false;
+    }
+
+    // Set the this pointer for the window
+    SetWindowLongPtrW(m_hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+    ApplyEncoding(DetectEncoding());
+    StartIndexing();
+    UpdateScrollBars();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Unmap the file and destroy the window
+//------------------------------------------------------------------------------
+void LargeFileView::Close() noexcept {
+    StopIndexing();
+    m_index.reset();
+
+    if (m_hwnd) {
+        SetWindowLongPtrW(m_hwnd, GWLP_USERDATA, 0);
+        DestroyWindow(m_hwnd);
+        m_hwnd = nullptr;
+    }
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_hMapping) {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    if (m_font) {
+        DeleteObject(m_font);
+        m_font = nullptr;
+    }
+    m_size = 0;
+    m_topLine = 0;
+    m_caretLine = 0;
+    m_scrollX = 0;
+    m_maxLineWidth = 0;
+    m_hasMatch = false;
+}
+
+//------------------------------------------------------------------------------
+// Re-read the mapped bytes with another encoding
+//------------------------------------------------------------------------------
+void LargeFileView::SetEncoding(TextEncoding encoding) {
+    if (!m_data || !m_hwnd) return;
+
+    StopIndexing();
+    m_index.reset();
+    ApplyEncoding(encoding);
+
+    m_topLine = 0;
+    m_caretLine = 0;
+    m_scrollX = 0;
+    m_maxLineWidth = 0;
+    m_hasMatch = false;
+
+    StartIndexing();
+    UpdateScrollBars();
+    InvalidateRect(m_hwnd, nullptr, FALSE);
+    NotifyState();
+}
+
+//------------------------------------------------------------------------------
+// Use a copy of the editor font
+//------------------------------------------------------------------------------
+void LargeFileView::SetFont(HFONT font) {
+    if (!font) return;
+
+    LOGFONTW lf = {};
+    if (GetObjectW(font, sizeof(lf), &lf) == 0) return;
+
+    HFONT newFont = CreateFontIndirectW(&lf);
+    if (!newFont) return;
+    if (m_font) {
+        DeleteObject(m_font);
+    }
+    m_font = newFont;
+
+    if (m_hwnd) {
+        HDC hdc = GetDC(m_hwnd);
+        HFONT oldFont = static_cast<HFONT>(SelectObject(hdc, m_font));
+        TEXTMETRICW tm = {};
+        GetTextMetricsW(hdc, &tm);
+        SelectObject(hdc, oldFont);
+        ReleaseDC(m_hwnd, hdc);
+
+        m_lineHeight = (std::max)(1, static_cast<int>(tm.tmHeight));
+        m_charWidth = (std::max)(1, static_cast<int>(tm.tmAveCharWidth));
+        m_maxLineWidth = 0;
+        UpdateScrollBars();
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Set tab width in characters
+//------------------------------------------------------------------------------
+void LargeFileView::SetTabSize(int tabSize) noexcept {
+    m_tabSize = (std::max)(1, (std::min)(tabSize, 16));
+    if (m_hwnd) {
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Show or hide the built-in line number gutter
+//------------------------------------------------------------------------------
+void LargeFileView::SetShowLineNumbers(bool show) noexcept {
+    m_showLineNumbers = show;
+    if (m_hwnd) {
+        UpdateScrollBars();
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Percentage of the file indexed so far
+//------------------------------------------------------------------------------
+int LargeFileView::GetIndexPercent() const noexcept {
+    if (!m_index) return 0;
+    if (m_index->IsComplete()) return 100;
+
+    uint64_t total = m_size - m_textStart;
+    if (total == 0) return 100;
+    uint64_t done = m_index->GetIndexedBytes();
+    done = (done > m_textStart) ? done - m_textStart : 0;
+    return static_cast<int>((done * 100) / total);
+}
+
+//------------------------------------------------------------------------------
+// Move the current line, centering it if it is off screen
+//------------------------------------------------------------------------------
+void LargeFileView::GoToLine(uint64_t line) {
+    uint64_t total = GetLineCount();
+    if (total == 0 || !m_hwnd) return;
+    line = (std::min)(line, total - 1);
+
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+    if (line < m_topLine || line >= m_topLine + page) {
+        ScrollTo(line - (std::min)(line, page / 2));
+    }
+    m_hasMatch = false;
+    SetCaretLine(line);
+    InvalidateRect(m_hwnd, nullptr, FALSE);
+}
+
+//------------------------------------------------------------------------------
+// Find the next/previous occurrence (wraps around)
+//------------------------------------------------------------------------------
+bool LargeFileView::Find(const std::wstring& text, bool matchCase, bool searchUp) {
+    if (!m_index || !m_hwnd || text.empty()) return false;
+
+    std::string needle = EncodeNeedle(text);
+    if (needle.empty()) return false;
+
+    // The search runs on the UI thread; large files take a while
+    HCURSOR oldCursor = SetCursor(LoadCursorW(nullptr, IDC_WAIT));
+
+    uint64_t hit = LineOffsetIndex::NPOS;
+    if (!searchUp) {
+        uint64_t from = m_hasMatch ? m_matchOffset + 1 : GetCaretLineStart();
+        hit = m_index->Find(needle, from, matchCase);
+        if (hit == LineOffsetIndex::NPOS && from > 0) {
+            hit = m_index->Find(needle, 0, matchCase);
+        }
+    } else {
+        uint64_t before = m_hasMatch ? m_matchOffset + needle.size() - 1 : GetCaretLineStart();
+        hit = m_index->FindLast(needle, before, matchCase);
+        if (hit == LineOffsetIndex::NPOS) {
+            hit = m_index->FindLast(needle, LineOffsetIndex::NPOS, matchCase);
+        }
+    }
+
+    SetCursor(oldCursor);
+    if (hit == LineOffsetIndex::NPOS) return false;
+
+    m_hasMatch = true;
+    m_matchOffset = hit;
+    m_matchLength = needle.size();
+
+    uint64_t line = m_index->LineFromOffset(hit);
+    if (line != LineOffsetIndex::NPOS) {
+        uint64_t page = static_cast<uint64_t>(GetPageLines());
+        if (line < m_topLine || line >= m_topLine + page) {
+            ScrollTo(line - (std::min)(line, page / 2));
+        }
+        SetCaretLine(line);
+    }
+    EnsureMatchVisible();
+    InvalidateRect(m_hwnd, nullptr, FALSE);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Copy the current line to the clipboard
+//------------------------------------------------------------------------------
+void LargeFileView::Copy() {
+    std::vector<LineSpan> spans;
+    if (!m_index || m_index->FetchLines(m_caretLine, 1, spans) == 0) return;
+
+    std::wstring text = DecodeSpan(spans[0].begin, spans[0].end);
+
+    if (!OpenClipboard(m_hwnd)) return;
+    EmptyClipboard();
+
+    size_t len = (text.size() + 1) * sizeof(wchar_t);
+    HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, len);
+    if (hMem) {
+        wchar_t* pMem = static_cast<wchar_t*>(GlobalLock(hMem));
+        if (pMem) {
+            wcscpy_s(pMem, text.size() + 1, text.c_str());
+            GlobalUnlock(hMem);
+            SetClipboardData(CF_UNICODETEXT, hMem);
+        }
+    }
+    CloseClipboard();
+}
+
+//------------------------------------------------------------------------------
+// Set the state-change callback
+//------------------------------------------------------------------------------
+void LargeFileView::SetStateCallback(StateCallback callback, void* userData) noexcept {
+    m_stateCallback = callback;
+    m_stateCallbackData = userData;
+}
+
+//------------------------------------------------------------------------------
+// Window procedure
+//------------------------------------------------------------------------------
+LRESULT CALLBACK LargeFileView::ViewWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    LargeFileView* view = reinterpret_cast<LargeFileView*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+
+    if (view) {
+        return view->HandleMessage(msg, wParam, lParam);
+    }
+
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+//------------------------------------------------------------------------------
+// Handle messages
+//------------------------------------------------------------------------------
+LRESULT LargeFileView::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam) {
+    switch (msg) {
+        case WM_PAINT:
+            OnPaint();
+            return 0;
+
+        case WM_ERASEBKGND:
+            return 1;  // We handle background in WM_PAINT
+
+        case WM_SIZE:
+            UpdateScrollBars();
+            InvalidateRect(m_hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_VSCROLL:
+            OnVScroll(LOWORD(wParam));
+            return 0;
+
+        case WM_HSCROLL:
+            OnHScroll(LOWORD(wParam));
+            return 0;
+
+        case WM_MOUSEWHEEL:
+            OnMouseWheel(static_cast<short>(HIWORD(wParam)));
+            return 0;
+
+        case WM_KEYDOWN:
+            OnKeyDown(wParam);
+            return 0;
+
+        case WM_GETDLGCODE:
+            return DLGC_WANTARROWS | DLGC_WANTCHARS;
+
+        case WM_LBUTTONDOWN: {
+            SetFocus(m_hwnd);
+            int y = static_cast<short>(HIWORD(lParam));
+            if (y >= 0) {
+                m_hasMatch = false;
+                SetCaretLine(m_topLine + static_cast<uint64_t>(y / m_lineHeight));
+                InvalidateRect(m_hwnd, nullptr, FALSE);
+            }
+            return 0;
+        }
+
+        case WM_SETFOCUS:
+        case WM_KILLFOCUS:
+            InvalidateRect(m_hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_TIMER:
+            if (wParam == INDEX_TIMER_ID) {
+                OnIndexTimer();
+                return 0;
+            }
+            break;
+
+        case WM_DESTROY: {
+            // Destroyed along with the parent editor; later messages go
+            // straight to DefWindowProcW
+            HWND hwnd = m_hwnd;
+            KillTimer(hwnd, INDEX_TIMER_ID);
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+            m_hwnd = nullptr;
+            return DefWindowProcW(hwnd, msg, wParam, lParam);
+        }
+    }
+
+    return DefWindowProcW(m_hwnd, msg, wParam, lParam);
+}
+
+//------------------------------------------------------------------------------
+// Paint the visible lines
+//------------------------------------------------------------------------------
+void LargeFileView::OnPaint() {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(m_hwnd, &ps);
+
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+
+    // Skip painting if client area is empty (e.g. window minimized)
+    if (rc.right <= 0 || rc.bottom <= 0) {
+        EndPaint(m_hwnd, &ps);
+        return;
+    }
+
+    // Create double buffer
+    HDC memDC = CreateCompatibleDC(hdc);
+    HBITMAP memBitmap = CreateCompatibleBitmap(hdc, rc.right, rc.bottom);
+    HBITMAP oldBitmap = static_cast<HBITMAP>(SelectObject(memDC, memBitmap));
+
+    FillRect(memDC, &rc, GetSysColorBrush(COLOR_WINDOW));
+
+    HFONT oldFont = nullptr;
+    if (m_font) {
+        oldFont = static_cast<HFONT>(SelectObject(memDC, m_font));
+    }
+    SetBkMode(memDC, TRANSPARENT);
+
+    int gutterWidth = GetGutterWidth();
+    int textLeft = gutterWidth + m_charWidth / 2 - m_scrollX;
+    int tabStop = m_tabSize * m_charWidth;
+    int widest = m_maxLineWidth;
+
+    m_spans.clear();
+    if (m_index) {
+        m_index->FetchLines(m_topLine, static_cast<size_t>(GetPageLines()) + 1, m_spans);
+    }
+
+    // Text area, clipped so scrolled text never covers the gutter
+    int savedDC = SaveDC(memDC);
+    IntersectClipRect(memDC, gutterWidth, 0, rc.right, rc.bottom);
+    for (size_t i = 0; i < m_spans.size(); i++) {
+        const LineSpan& span = m_spans[i];
+        uint64_t line = m_topLine + i;
+        int y = static_cast<int>(i) * m_lineHeight;
+
+        if (line == m_caretLine) {
+            RECT lineRect = { gutterWidth, y, rc.right, y + m_lineHeight };
+            HBRUSH lineBrush = CreateSolidBrush(CURRENT_LINE_COLOR);
+            FillRect(memDC, &lineRect, lineBrush);
+            DeleteObject(lineBrush);
+        }
+
+        std::wstring text = DecodeSpan(span.begin, span.end);
+
+        // Highlight the last search match
+        if (m_hasMatch && m_matchOffset >= span.begin && m_matchOffset < span.end) {
+            std::wstring before = DecodeSpan(span.begin, m_matchOffset);
+            std::wstring through = DecodeSpan(span.begin,
+                (std::min)(m_matchOffset + m_matchLength, span.end));
+            DWORD startExtent = GetTabbedTextExtentW(memDC, before.c_str(),
+                static_cast<int>(before.size()), 1, &tabStop);
+            DWORD endExtent = GetTabbedTextExtentW(memDC, through.c_str(),
+                static_cast<int>(through.size()), 1, &tabStop);
+            RECT matchRect = { textLeft + LOWORD(startExtent), y,
+                               textLeft + LOWORD(endExtent), y + m_lineHeight };
+            HBRUSH matchBrush = CreateSolidBrush(MATCH_COLOR);
+            FillRect(memDC, &matchRect, matchBrush);
+            DeleteObject(matchBrush);
+        }
+
+        SetTextColor(memDC, GetSysColor(COLOR_WINDOWTEXT));
+        LONG extent = TabbedTextOutW(memDC, textLeft, y, text.c_str(),
+                                     static_cast<int>(text.size()), 1, &tabStop, textLeft);
+
+        // Extents are 16-bit; estimate very long lines from their length
+        size_t estimate = text.size() * static_cast<size_t>(m_charWidth);
+        int width = (estimate < 0xFFFF)
+            ? static_cast<int>(LOWORD(extent))
+            : static_cast<int>((std::min)(estimate, static_cast<size_t>(INT_MAX / 2)));
+        widest = (std::max)(widest, width);
+    }
+    RestoreDC(memDC, savedDC);
+
+    // Nothing indexed yet
+    if (m_spans.empty() && m_index && !m_index->IsComplete()) {
+        RECT textRect = { gutterWidth, 0, rc.right, rc.bottom };
+        SetTextColor(memDC, PLACEHOLDER_COLOR);
+        DrawTextW(memDC, L"Indexing...", -1, &textRect, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+    }
+
+    // Line number gutter
+    if (gutterWidth > 0) {
+        RECT gutterRect = { 0, 0, gutterWidth, rc.bottom };
+        HBRUSH bgBrush = CreateSolidBrush(GUTTER_BG_COLOR);
+        FillRect(memDC, &gutterRect, bgBrush);
+        DeleteObject(bgBrush);
+
+        HPEN borderPen = CreatePen(PS_SOLID, 1, GUTTER_BORDER_COLOR);
+        HPEN oldPen = static_cast<HPEN>(SelectObject(memDC, borderPen));
+        MoveToEx(memDC, gutterWidth - 1, 0, nullptr);
+        LineTo(memDC, gutterWidth - 1, rc.bottom);
+        SelectObject(memDC, oldPen);
+        DeleteObject(borderPen);
+
+        for (size_t i = 0; i < m_spans.size(); i++) {
+            uint64_t line = m_topLine + i;
+            int y = static_cast<int>(i) * m_lineHeight;
+
+            SetTextColor(memDC, line == m_caretLine ? GUTTER_CURRENT_COLOR : GUTTER_TEXT_COLOR);
+
+            wchar_t buffer[24];
+            swprintf_s(buffer, L"%llu", static_cast<unsigned long long>(line + 1));
+
+            RECT textRect = { 0, y, gutterWidth - m_charWidth, y + m_lineHeight };
+            DrawTextW(memDC, buffer, -1, &textRect, DT_RIGHT | DT_VCENTER | DT_SINGLELINE);
+        }
+    }
+
+    if (oldFont) {
+        SelectObject(memDC, oldFont);
+    }
+
+    // Copy to screen
+    BitBlt(hdc, 0, 0, rc.right, rc.bottom, memDC, 0, 0, SRCCOPY);
+
+    // Cleanup
+    SelectObject(memDC, oldBitmap);
+    DeleteObject(memBitmap);
+    DeleteDC(memDC);
+
+    EndPaint(m_hwnd, &ps);
+
+    // Grow the horizontal range as longer lines come into view
+    if (widest > m_maxLineWidth) {
+        m_maxLineWidth = widest;
+        UpdateScrollBars();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Vertical scroll bar
+//------------------------------------------------------------------------------
+void LargeFileView::OnVScroll(WORD code) {
+    uint64_t top = m_topLine;
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+
+    switch (code) {
+        case SB_LINEUP:     top -= (std::min<uint64_t>)(top, 1); break;
+        case SB_LINEDOWN:   top += 1; break;
+        case SB_PAGEUP:     top -= (std::min)(top, page); break;
+        case SB_PAGEDOWN:   top += page; break;
+        case SB_TOP:        top = 0; break;
+        case SB_BOTTOM:     top = LineOffsetIndex::NPOS; break;
+        case SB_THUMBTRACK:
+        case SB_THUMBPOSITION: {
+            SCROLLINFO si = {};
+            si.cbSize = sizeof(si);
+            si.fMask = SIF_TRACKPOS;
+            GetScrollInfo(m_hwnd, SB_VERT, &si);
+            top = static_cast<uint64_t>(si.nTrackPos) * m_scrollScale;
+            break;
+        }
+        default:
+            return;
+    }
+    ScrollTo(top);
+}
+
+//------------------------------------------------------------------------------
+// Horizontal scroll bar
+//------------------------------------------------------------------------------
+void LargeFileView::OnHScroll(WORD code) {
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+    int page = (std::max)(m_charWidth, static_cast<int>(rc.right) - GetGutterWidth());
+    int x = m_scrollX;
+
+    switch (code) {
+        case SB_LINELEFT:   x -= m_charWidth * 4; break;
+        case SB_LINERIGHT:  x += m_charWidth * 4; break;
+        case SB_PAGELEFT:   x -= page; break;
+        case SB_PAGERIGHT:  x += page; break;
+        case SB_LEFT:       x = 0; break;
+        case SB_RIGHT:      x = m_maxLineWidth; break;
+        case SB_THUMBTRACK:
+        case SB_THUMBPOSITION: {
+            SCROLLINFO si = {};
+            si.cbSize = sizeof(si);
+            si.fMask = SIF_TRACKPOS;
+            GetScrollInfo(m_hwnd, SB_HORZ, &si);
+            x = si.nTrackPos;
+            break;
+        }
+        default:
+            return;
+    }
+    SetScrollX(x);
+}
+
+//------------------------------------------------------------------------------
+// Mouse wheel
+//------------------------------------------------------------------------------
+void LargeFileView::OnMouseWheel(short delta) {
+    int linesPerNotch = m_scrollLines;
+    if (linesPerNotch <= 0) {
+        UINT systemLines = 3;
+        SystemParametersInfoW(SPI_GETWHEELSCROLLLINES, 0, &systemLines, 0);
+        linesPerNotch = (systemLines == WHEEL_PAGESCROLL) ? GetPageLines() : static_cast<int>(systemLines);
+    }
+
+    m_wheelRemainder += delta;
+    int notches = m_wheelRemainder / WHEEL_DELTA;
+    m_wheelRemainder %= WHEEL_DELTA;
+    if (notches == 0) return;
+
+    uint64_t lines = static_cast<uint64_t>(std::abs(notches)) * static_cast<uint64_t>(linesPerNotch);
+    if (notches > 0) {
+        ScrollTo(m_topLine - (std::min)(m_topLine, lines));
+    } else {
+        ScrollTo(m_topLine + lines);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Keyboard navigation
+//------------------------------------------------------------------------------
+void LargeFileView::OnKeyDown(WPARAM vKey) {
+    bool ctrl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+
+    switch (vKey) {
+        case VK_UP:
+            if (m_caretLine > 0) SetCaretLine(m_caretLine - 1);
+            break;
+        case VK_DOWN:
+            SetCaretLine(m_caretLine + 1);
+            break;
+        case VK_PRIOR:
+            ScrollTo(m_topLine - (std::min)(m_topLine, page));
+            SetCaretLine(m_caretLine - (std::min)(m_caretLine, page));
+            break;
+        case VK_NEXT:
+            ScrollTo(m_topLine + page);
+            SetCaretLine(m_caretLine + page);
+            break;
+        case VK_HOME:
+            if (ctrl) SetCaretLine(0);
+            SetScrollX(0);
+            break;
+        case VK_END:
+            if (ctrl) SetCaretLine(LineOffsetIndex::NPOS);
+            break;
+        case VK_LEFT:
+            OnHScroll(SB_LINELEFT);
+            break;
+        case VK_RIGHT:
+            OnHScroll(SB_LINERIGHT);
+            break;
+        case 'C':
+        case VK_INSERT:
+            if (ctrl) Copy();
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Refresh while the index is being built
+//------------------------------------------------------------------------------
+void LargeFileView::OnIndexTimer() {
+    if (!m_index) {
+        KillTimer(m_hwnd, INDEX_TIMER_ID);
+        return;
+    }
+
+    bool complete = m_index->IsComplete();
+    uint64_t count = m_index->GetLineCount();
+    if (count != m_lastLineCount || complete) {
+        m_lastLineCount = count;
+        UpdateScrollBars();
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+    if (complete) {
+        KillTimer(m_hwnd, INDEX_TIMER_ID);
+    }
+    NotifyState();
+}
+
+//------------------------------------------------------------------------------
+// Detect the encoding.  Detection samples the mapping itself, with a cost
+// that does not grow with the file.
+//------------------------------------------------------------------------------
+TextEncoding LargeFileView::DetectEncoding() const {
+    return FileIO::DetectEncoding(m_data, static_cast<size_t>(m_size));
+}
+
+//------------------------------------------------------------------------------
+// Skip the BOM and detect the line ending for an encoding
+//------------------------------------------------------------------------------
+void LargeFileView::ApplyEncoding(TextEncoding encoding) {
+    m_encoding = encoding;
+    m_textStart = BomLength(m_data, m_size, encoding);
+
+    uint64_t probeEnd = (std::min)(m_size, m_textStart + FORMAT_PROBE_BYTES);
+    m_lineEnding = FileIO::DetectLineEnding(DecodeSpan(m_textStart, probeEnd));
+}
+
+//------------------------------------------------------------------------------
+// Build the line index on a worker thread
+//------------------------------------------------------------------------------
+void LargeFileView::StartIndexing() {
+    LineUnit unit = LineUnit::Byte;
+    if (m_encoding == TextEncoding::UTF16_LE) {
+        unit = LineUnit::UTF16LE;
+    } else if (m_encoding == TextEncoding::UTF16_BE) {
+        unit = LineUnit::UTF16BE;
+    }
+    char16_t newline = (m_lineEnding == LineEnding::CR) ? u'\r' : u'\n';
+
+    m_index = std::make_unique<LineOffsetIndex>(m_data, m_size, m_textStart, unit, newline);
+    m_cancelIndex = false;
+    m_lastLineCount = 0;
+
+    LineIndexSnapshot current;
+    current.filePath = m_filePath;
+    current.fileSize = m_size;
+    current.lastWriteTime = m_lastWriteTime;
+    current.textStart = m_textStart;
+    current.unit = unit;
+    current.newline = newline;
+
+    LineOffsetIndex* index = m_index.get();
+    std::atomic<bool>* cancel = &m_cancelIndex;
+    const uint8_t* data = m_data;
+    m_indexThread = std::thread([index, cancel, data, current, cacheDir = m_indexCacheDir]() {
+        RunIndexTask(index, cancel, data, current, cacheDir);
+    });
+
+    if (m_hwnd) {
+        SetTimer(m_hwnd, INDEX_TIMER_ID, INDEX_TIMER_INTERVAL, nullptr);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Cancel and wait for the index worker
+//------------------------------------------------------------------------------
+void LargeFileView::StopIndexing() noexcept {
+    m_cancelIndex = true;
+    if (m_indexThread.joinable()) {
+        m_indexThread.join();
+    }
+    if (m_hwnd) {
+        KillTimer(m_hwnd, INDEX_TIMER_ID);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Decode a byte span of the mapped file
+//------------------------------------------------------------------------------
+std::wstring LargeFileView::DecodeSpan(uint64_t begin, uint64_t end) const {
+    if (!m_data || begin >= end) return std::wstring();
+    end = (std::min)(end, m_size);
+
+    // Very long lines are shown truncated; back off to a character boundary
+    if (end - begin > MAX_LINE_BYTES) {
+        end = begin + MAX_LINE_BYTES;
+        if (m_encoding == TextEncoding::UTF8 || m_encoding == TextEncoding::UTF8_BOM) {
+            while (end > begin && (m_data[end] & 0xC0) == 0x80) end--;
+        }
+    }
+
+    const uint8_t* data = m_data + begin;
+    int size = static_cast<int>(end - begin);
+    std::wstring result;
+
+    switch (m_encoding) {
+        case TextEncoding::UTF16_LE:
+        case TextEncoding::UTF16_BE: {
+            int count = size / 2;
+            result.resize(count);
+            bool bigEndian = (m_encoding == TextEncoding::UTF16_BE);
+            for (int i = 0; i < count; i++) {
+                uint8_t lo = data[i * 2 + (bigEndian ? 1 : 0)];
+                uint8_t hi = data[i * 2 + (bigEndian ? 0 : 1)];
+                result[i] = static_cast<wchar_t>(lo | (hi << 8));
+            }
+            break;
+        }
+
+        default: {
+            UINT codePage = FileIO::GetCodePage(m_encoding);
+            const char* chars = reinterpret_cast<const char*>(data);
+            int count = MultiByteToWideChar(codePage, 0, chars, size, nullptr, 0);
+            if (count > 0) {
+                result.resize(count);
+                MultiByteToWideChar(codePage, 0, chars, size, result.data(), count);
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Encode search text in the file's encoding
+//------------------------------------------------------------------------------
+std::string LargeFileView::EncodeNeedle(const std::wstring& text) const {
+    std::string result;
+
+    switch (m_encoding) {
+        case TextEncoding::UTF16_LE:
+        case TextEncoding::UTF16_BE: {
+            bool bigEndian = (m_encoding == TextEncoding::UTF16_BE);
+            result.reserve(text.size() * 2);
+            for (wchar_t ch : text) {
+                char lo = static_cast<char>(ch & 0xFF);
+                char hi = static_cast<char>((ch >> 8) & 0xFF);
+                result.push_back(bigEndian ? hi : lo);
+                result.push_back(bigEndian ? lo : hi);
+            }
+            break;
+        }
+
+        default: {
+            UINT codePage = FileIO::GetCodePage(m_encoding);
+            int size = WideCharToMultiByte(codePage, 0, text.c_str(), static_cast<int>(text.size()),
+                                           nullptr, 0, nullptr, nullptr);
+            if (size > 0) {
+                result.resize(size);
+                WideCharToMultiByte(codePage, 0, text.c_str(), static_cast<int>(text.size()),
+                                    result.data(), size, nullptr, nullptr);
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Scroll so 'topLine' is the first visible line
+//------------------------------------------------------------------------------
+void LargeFileView::ScrollTo(uint64_t topLine) {
+    uint64_t total = GetLineCount();
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+    uint64_t maxTop = (total > page) ? total - page : 0;
+    topLine = (std::min)(topLine, maxTop);
+
+    if (topLine != m_topLine) {
+        m_topLine = topLine;
+        UpdateScrollBars();
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Set the horizontal scroll offset in pixels
+//------------------------------------------------------------------------------
+void LargeFileView::SetScrollX(int x) {
+    x = (std::max)(0, (std::min)(x, m_maxLineWidth));
+    if (x != m_scrollX) {
+        m_scrollX = x;
+        UpdateScrollBars();
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Move the current line and keep it visible
+//------------------------------------------------------------------------------
+void LargeFileView::SetCaretLine(uint64_t line) {
+    uint64_t total = GetLineCount();
+    if (total == 0) return;
+    line = (std::min)(line, total - 1);
+
+    if (line != m_caretLine) {
+        m_caretLine = line;
+        InvalidateRect(m_hwnd, nullptr, FALSE);
+        NotifyState();
+    }
+    EnsureCaretVisible();
+}
+
+//------------------------------------------------------------------------------
+// Scroll vertically so the current line is visible
+//------------------------------------------------------------------------------
+void LargeFileView::EnsureCaretVisible() {
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+    if (m_caretLine < m_topLine) {
+        ScrollTo(m_caretLine);
+    } else if (m_caretLine >= m_topLine + page) {
+        ScrollTo(m_caretLine - page + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Scroll horizontally so the search match is visible
+//------------------------------------------------------------------------------
+void LargeFileView::EnsureMatchVisible() {
+    if (!m_hasMatch || !m_hwnd) return;
+
+    uint64_t lineStart = GetCaretLineStart();
+    if (m_matchOffset < lineStart) return;
+
+    std::wstring before = DecodeSpan(lineStart, m_matchOffset);
+    std::wstring through = DecodeSpan(lineStart, m_matchOffset + m_matchLength);
+    int tabStop = m_tabSize * m_charWidth;
+
+    HDC hdc = GetDC(m_hwnd);
+    HFONT oldFont = m_font ? static_cast<HFONT>(SelectObject(hdc, m_font)) : nullptr;
+    int left = LOWORD(GetTabbedTextExtentW(hdc, before.c_str(), static_cast<int>(before.size()), 1, &tabStop));
+    int right = LOWORD(GetTabbedTextExtentW(hdc, through.c_str(), static_cast<int>(through.size()), 1, &tabStop));
+    if (oldFont) SelectObject(hdc, oldFont);
+    ReleaseDC(m_hwnd, hdc);
+
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+    int textWidth = (std::max)(m_charWidth, static_cast<int>(rc.right) - GetGutterWidth() - m_charWidth);
+
+    m_maxLineWidth = (std::max)(m_maxLineWidth, right);
+    if (left < m_scrollX) {
+        SetScrollX(left - m_charWidth * 4);
+    } else if (right > m_scrollX + textWidth) {
+        SetScrollX(right - textWidth + m_charWidth * 4);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Byte offset where the current line starts
+//------------------------------------------------------------------------------
+uint64_t LargeFileView::GetCaretLineStart() {
+    std::vector<LineSpan> spans;
+    if (m_index && m_index->FetchLines(m_caretLine, 1, spans) > 0) {
+        return spans[0].begin;
+    }
+    return m_textStart;
+}
+
+//------------------------------------------------------------------------------
+// Update scroll bar ranges and positions
+//------------------------------------------------------------------------------
+void LargeFileView::UpdateScrollBars() {
+    if (!m_hwnd) return;
+
+    uint64_t total = GetLineCount();
+    uint64_t page = static_cast<uint64_t>(GetPageLines());
+    m_scrollScale = (total > MAX_SCROLL_UNITS) ? (total + MAX_SCROLL_UNITS - 1) / MAX_SCROLL_UNITS : 1;
+
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    si.nMin = 0;
+    si.nMax = (total > 0) ? static_cast<int>((total - 1) / m_scrollScale) : 0;
+    si.nPage = static_cast<UINT>((std::max<uint64_t>)(1, page / m_scrollScale));
+    si.nPos = static_cast<int>(m_topLine / m_scrollScale);
+    SetScrollInfo(m_hwnd, SB_VERT, &si, TRUE);
+
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+    int textWidth = (std::max)(0, static_cast<int>(rc.right) - GetGutterWidth());
+    si.nMax = m_maxLineWidth + m_charWidth * 2;
+    si.nPage = static_cast<UINT>(textWidth);
+    si.nPos = m_scrollX;
+    SetScrollInfo(m_hwnd, SB_HORZ, &si, TRUE);
+}
+
+//------------------------------------------------------------------------------
+// Fully visible lines
+//------------------------------------------------------------------------------
+int LargeFileView::GetPageLines() const noexcept {
+    if (!m_hwnd) return 1;
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+    return (std::max)(1, static_cast<int>(rc.bottom) / m_lineHeight);
+}
+
+//------------------------------------------------------------------------------
+// Width of the line number gutter (0 when hidden)
+//------------------------------------------------------------------------------
+int LargeFileView::GetGutterWidth() const noexcept {
+    if (!m_showLineNumbers) return 0;
+
+    uint64_t lineCount = GetLineCount();
+    int digits = 1;
+    while (lineCount >= 10) {
+        lineCount /= 10;
+        digits++;
+    }
+
+    // Minimum 3 digits, plus padding
+    digits = (std::max)(digits, 3);
+    return (digits + 2) * m_charWidth;
+}
+
+//------------------------------------------------------------------------------
+// Tell the owner the current line or index state changed
+//------------------------------------------------------------------------------
+void LargeFileView::NotifyState() {
+    if (m_stateCallback) {
+        m_stateCallback(m_stateCallbackData);
+    }
+}
+
+} // namespace QNote
@@ -0,0 +1,188 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LargeFileView.h - Read-only virtualized viewer for very large files
+//==============================================================================
+
+#pragma once
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Settings.h"
+#include "LineOffsetIndex.h"
+
+namespace QNote {
+
+//------------------------------------------------------------------------------
+// Read-only viewer for files too large for the RichEdit control.  The file
+// is memory-mapped, a LineOffsetIndex is built over it on a worker thread,
+// and only the visible lines are decoded and painted.  The view is created
+// as a child of the tab's (empty) editor control so it shows, hides and
+// moves with the tab.
+//------------------------------------------------------------------------------
+class LargeFileView {
+public:
+    LargeFileView() noexcept = default;
+    ~LargeFileView();
+
+    // Prevent copying
+    LargeFileView(const LargeFileView&) = delete;
+    LargeFileView& operator=(const LargeFileView&) = delete;
+
+    // Directory for persisted line indexes (empty = don't persist).  Set
+    // before Open().
+    void SetIndexCacheDirectory(const std::wstring& dir) { m_indexCacheDir = dir; }
+
+    // Map the file, create the view window and start indexing
+    [[nodiscard]] bool Open(HWND parent, HINSTANCE hInstance, const std::wstring& filePath,
+                            std::wstring& errorMessage);
+
+    // Unmap the file and destroy the window
+    void Close() noexcept;
+
+    [[nodiscard]] HWND GetHandle() const noexcept { return m_hwnd; }
+    [[nodiscard]] const std::wstring& GetFilePath() const noexcept { return m_filePath; }
+
+    // Re-read the mapped bytes with another encoding (rebuilds the index)
+    void SetEncoding(TextEncoding encoding);
+    [[nodiscard]] TextEncoding GetEncoding() const noexcept { return m_encoding; }
+    [[nodiscard]] LineEnding GetLineEnding() const noexcept { return m_lineEnding; }
+
+    // Appearance
+    void SetFont(HFONT font);
+    void SetTabSize(int tabSize) noexcept;
+    void SetScrollLines(int lines) noexcept { m_scrollLines = lines; }
+    void SetShowLineNumbers(bool show) noexcept;
+
+    // Index state
+    [[nodiscard]] uint64_t GetLineCount() const noexcept { return m_index ? m_index->GetLineCount() : 0; }
+    [[nodiscard]] bool IsIndexComplete() const noexcept { return m_index && m_index->IsComplete(); }
+    [[nodiscard]] int GetIndexPercent() const noexcept;
+
+    // Navigation (0-based lines)
+    [[nodiscard]] uint64_t GetCurrentLine() const noexcept { return m_caretLine; }
+    void GoToLine(uint64_t line);
+
+    // Find the next/previous occurrence of 'text' (wraps around).  Only the
+    // part of the file indexed so far is searched.
+    [[nodiscard]] bool Find(const std::wstring& text, bool matchCase, bool searchUp);
+
+    // Copy the current line to the clipboard
+    void Copy();
+
+    // Called when the current line or the index state changes
+    using StateCallback = void(*)(void* userData);
+    void SetStateCallback(StateCallback callback, void* userData) noexcept;
+
+private:
+    // Window procedure
+    static LRESULT CALLBACK ViewWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    LRESULT HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam);
+
+    // Message handlers
+    void OnPaint();
+    void OnVScroll(WORD code);
+    void OnHScroll(WORD code);
+    void OnMouseWheel(short delta);
+    void OnKeyDown(WPARAM vKey);
+    void OnIndexTimer();
+
+    // Encoding detection and index (re)build
+    [[nodiscard]] TextEncoding DetectEncoding() const;
+    void ApplyEncoding(TextEncoding encoding);
+    void StartIndexing();
+    void StopIndexing() noexcept;
+
+    // Decode a byte span of the mapped file (capped at MAX_LINE_BYTES)
+    std::wstring DecodeSpan(uint64_t begin, uint64_t end) const;
+
+    // Encode search text in the file's encoding
+    std::string EncodeNeedle(const std::wstring& text) const;
+
+    // Scrolling
+    void ScrollTo(uint64_t topLine);
+    void SetScrollX(int x);
+    void SetCaretLine(uint64_t line);
+    void EnsureCaretVisible();
+    void EnsureMatchVisible();
+    [[nodiscard]] uint64_t GetCaretLineStart();
+    void UpdateScrollBars();
+    [[nodiscard]] int GetPageLines() const noexcept;
+    [[nodiscard]] int GetGutterWidth() const noexcept;
+    void NotifyState();
+
+private:
+    HWND m_hwnd = nullptr;
+    HWND m_hwndParent = nullptr;
+    HINSTANCE m_hInstance = nullptr;
+    std::wstring m_filePath;
+
+    // Mapped file
+    HANDLE m_hFile = INVALID_HANDLE_VALUE;
+    HANDLE m_hMapping = nullptr;
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+    uint64_t m_lastWriteTime = 0;          // FILETIME as a 64-bit value
+
+    // Format
+    TextEncoding m_encoding = TextEncoding::UTF8;
+    LineEnding m_lineEnding = LineEnding::CRLF;
+    uint64_t m_textStart = 0;              // Bytes of BOM skipped
+
+    // Line index, built on m_indexThread
+    std::unique_ptr<LineOffsetIndex> m_index;
+    std::thread m_indexThread;
+    std::atomic<bool> m_cancelIndex{false};
+    uint64_t m_lastLineCount = 0;
+    std::wstring m_indexCacheDir;          // Sidecar directory for LineIndexCache
+
+    // Font and metrics
+    HFONT m_font = nullptr;                // Owned copy of the editor font
+    int m_lineHeight = 16;
+    int m_charWidth = 8;
+    int m_tabSize = 4;
+    int m_scrollLines = 0;                 // Lines per wheel notch (0 = system default)
+    bool m_showLineNumbers = false;
+
+    // View state
+    uint64_t m_topLine = 0;
+    uint64_t m_caretLine = 0;
+    int m_scrollX = 0;
+    int m_maxLineWidth = 0;
+    uint64_t m_scrollScale = 1;            // Lines per scroll bar unit
+    int m_wheelRemainder = 0;
+
+    // Last search match (byte range in the file)
+    bool m_hasMatch = false;
+    uint64_t m_matchOffset = 0;
+    uint64_t m_matchLength = 0;
+
+    StateCallback m_stateCallback = nullptr;
+    void* m_stateCallbackData = nullptr;
+
+    std::vector<LineSpan> m_spans;         // Scratch for painting
+
+    // Longest part of a line that is decoded and drawn
+    static constexpr uint64_t MAX_LINE_BYTES = 64 * 1024;
+
+    // Scroll bar positions are ints; larger line counts are scaled
+    static constexpr uint64_t MAX_SCROLL_UNITS = 1u << 30;
+
+    static constexpr UINT_PTR INDEX_TIMER_ID = 1;
+    static constexpr UINT INDEX_TIMER_INTERVAL = 200;
+
+    // Window class name
+    static constexpr wchar_t VIEW_CLASS[] = L"QNoteLargeFileView";
+    static bool s_classRegistered;
+};
+
+} // namespace QNote
@@ -4,6 +4,7 @@
 //==============================================================================
 
 #include "NoteListWindow.h"
+#include "resource.h"
 #include <dwmapi.h>
 #include <algorithm>
 #include <sstream>
@@ -40,7 +41,8 @@ NoteListWindow::~NoteListWindow() {
     }
 }
 
-bool NoteListWindow::Create(HINSTANCE hInstance, HWND parentWindow, NoteStore* noteStore) {
+bool NoteListWindow::Create(HINSTANCE hInstance, HWND parentWindow, NoteStore* noteStore,
+                            TaskScheduler& scheduler) {
     m_hInstance = hInstance;
     m_hwndParent = parentWindow;
     m_noteStore = noteStore;
@@ -90,6 +92,18 @@ bool NoteListWindow::Create(HINSTANCE hInstance, HWND parentWindow, NoteStore* n
         return false;
     }
     
+    // Searches run on the task pool, ranked by the store's index once it is
+    // built; results are picked up on this thread
+    HWND hwnd = m_hwnd;
+    NoteStore* store = m_noteStore;
+    m_search = std::make_unique<NoteSearch>(
+        scheduler,
+        [store](const std::wstring& id) { return store->ReadNoteContent(id); },
+        [store](const std::wstring& query, size_t limit, std::vector<NoteRankedHit>& hits) {
+            return store->SearchIndexed(query, limit, hits);
+        },
+        [hwnd]() { PostMessageW(hwnd, WM_APP_NOTESEARCH, 0, 0); });
+    
     // Round corners on Windows 11
     DWM_WINDOW_CORNER_PREFERENCE cornerPref = DWMWCP_ROUND;
     DwmSetWindowAttribute(m_hwnd, DWMWA_WINDOW_CORNER_PREFERENCE, &cornerPref, sizeof(cornerPref));
@@ -135,6 +149,8 @@ void NoteListWindow::SetViewMode(NoteListViewMode mode) {
 }
 
 void NoteListWindow::RefreshList() {
+    // Notes may have changed since the search snapshot was taken
+    m_searchSources.reset();
     PopulateList();
     UpdateStatusText();
 }
@@ -145,10 +161,18 @@ void NoteListWindow::Search(const std::wstring& query) {
         m_viewMode = NoteListViewMode::Search;
     }
     UpdateViewModeUI();
-    RefreshList();
+    
+    // Keeps the search snapshot, so each key typed only restarts the search
+    PopulateList();
+    UpdateStatusText();
 }
 
 void NoteListWindow::ClearSearch() {
+    if (m_search) {
+        m_search->Cancel();
+    }
+    m_searching = false;
+    m_searchSources.reset();
     m_currentSearch.clear();
     if (m_hwndSearch) {
         SetWindowTextW(m_hwndSearch, L"");
@@ -207,6 +231,15 @@ LRESULT NoteListWindow::HandleMessage(UINT msg, WPARAM wParam, LPARAM lParam) {
         case WM_CTLCOLORSTATIC:
             return OnCtlColorStatic(reinterpret_cast<HDC>(wParam), reinterpret_cast<HWND>(lParam));
             
+        case WM_APP_REFRESHNOTES:
+            m_refreshPosted = false;
+            RefreshList();
+            return 0;
+            
+        case WM_APP_NOTESEARCH:
+            OnNoteSearchResults();
+            return 0;
+            
         case WM_CLOSE:
             Hide();
             return 0;
@@ -233,7 +266,10 @@ void NoteListWindow::OnCreate() {
 }
 
 void NoteListWindow::OnDestroy() {
-    // Cleanup handled in destructor
+    // No more results can be delivered
+    if (m_search) {
+        m_search->Stop();
+    }
 }
 
 void NoteListWindow::OnSize(int width, int height) {
@@ -295,17 +331,13 @@ void NoteListWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
             SetViewMode(NoteListViewMode::Timeline);
             break;
             
-        case IDC_SEARCH_BTN:
-            if (m_hwndSearch) {
-                int len = GetWindowTextLengthW(m_hwndSearch);
-                if (len > 0) {
-                    std::wstring query(len + 1, L'\0');
-                    GetWindowTextW(m_hwndSearch, &query[0], len + 1);
-                    query.resize(len);
-                    Search(query);
-                }
+        case IDC_SEARCH_BTN: {
+            std::wstring query = GetSearchText();
+            if (!query.empty()) {
+                Search(query);
             }
             break;
+        }
             
         case IDC_CLEAR_BTN:
             ClearSearch();
@@ -313,7 +345,15 @@ void NoteListWindow::OnCommand(WORD id, WORD code, HWND hwndCtl) {
             
         case IDC_SEARCH_EDIT:
             if (code == EN_CHANGE) {
-                // Could implement real-time search here
+                // Search as the query is typed
+                std::wstring query = GetSearchText();
+                if (query.empty()) {
+                    if (!m_currentSearch.empty()) {
+                        ClearSearch();
+                    }
+                } else if (query != m_currentSearch) {
+                    Search(query);
+                }
             }
             break;
     }
@@ -367,6 +407,25 @@ void NoteListWindow::OnNotify(NMHDR* pnmh) {
                 }
                 break;
             }
+            
+            case LVN_ODSTATECHANGED: {
+                // Selection of a range of rows (shift-click)
+                NMLVODSTATECHANGE* pnmsc = reinterpret_cast<NMLVODSTATECHANGE*>(pnmh);
+                if ((pnmsc->uOldState ^ pnmsc->uNewState) & LVIS_SELECTED) {
+                    UpdateStatusText();
+                }
+                break;
+            }
+            
+            case LVN_GETDISPINFOW:
+                OnGetDispInfo(reinterpret_cast<NMLVDISPINFOW*>(pnmh));
+                break;
+                
+            case LVN_ODCACHEHINT: {
+                NMLVCACHEHINT* pnmch = reinterpret_cast<NMLVCACHEHINT*>(pnmh);
+                OnCacheHint(pnmch->iFrom, pnmch->iTo);
+                break;
+            }
         }
     }
 }
@@ -384,10 +443,6 @@ LRESULT NoteListWindow::OnCtlColorStatic(HDC hdc, HWND hwndStatic) {
 void NoteListWindow::PopulateList() {
     if (!m_hwndList || !m_noteStore) return;
     
-    // Clear current items
-    ListView_DeleteAllItems(m_hwndList);
-    m_displayedNotes.clear();
-    
     // Get notes based on view mode
     NoteFilter filter;
     
@@ -411,53 +466,181 @@ void NoteListWindow::PopulateList() {
             break;
     }
     
-    m_displayedNotes = m_noteStore->GetNotes(filter);
+    // Only the row order is fetched here; row text is formatted as rows
+    // come into view.  Search results are filled in as they are found.
+    if (m_viewMode == NoteListViewMode::Search && !m_currentSearch.empty() && m_search) {
+        StartNoteSearch();
+    } else {
+        if (m_search) {
+            m_search->Cancel();
+        }
+        m_searching = false;
+        m_view = m_noteStore->GetNoteView(filter);
+        m_searchSnippets.clear();
+    }
+    m_rowCache.clear();
+    m_rowCacheFirst = 0;
+    
+    ListView_SetItemState(m_hwndList, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+    ListView_SetItemCountEx(m_hwndList, static_cast<int>(m_view.size()), LVSICF_NOSCROLL);
+    InvalidateRect(m_hwndList, nullptr, FALSE);
+}
+
+void NoteListWindow::OnGetDispInfo(NMLVDISPINFOW* pdi) {
+    LVITEMW& item = pdi->item;
+    if (!(item.mask & LVIF_TEXT) || !item.pszText || item.cchTextMax <= 0) return;
+    item.pszText[0] = L'\0';
     
-    // Add to list view
-    for (size_t i = 0; i < m_displayedNotes.size(); ++i) {
-        AddNoteToList(m_displayedNotes[i], static_cast<int>(i));
+    int offset = item.iItem - m_rowCacheFirst;
+    if (offset < 0 || offset >= static_cast<int>(m_rowCache.size())) {
+        // Outside the last cache hint (e.g. a lookup by the control itself)
+        FillRowCache(item.iItem - PREFETCH_ROWS, item.iItem + PREFETCH_ROWS);
+        offset = item.iItem - m_rowCacheFirst;
+        if (offset < 0 || offset >= static_cast<int>(m_rowCache.size())) return;
     }
+    
+    const CachedRow& row = m_rowCache[offset];
+    const std::wstring& text = (item.iSubItem == 0) ? row.title : row.date;
+    wcsncpy_s(item.pszText, item.cchTextMax, text.c_str(), _TRUNCATE);
 }
 
-void NoteListWindow::AddNoteToList(const NoteSummary& note, int index) {
-    if (!m_hwndList) return;
+void NoteListWindow::OnCacheHint(int from, int to) {
+    int cachedEnd = m_rowCacheFirst + static_cast<int>(m_rowCache.size());
+    if (from >= m_rowCacheFirst && to < cachedEnd) return;
     
-    LVITEMW lvi = {};
-    lvi.mask = LVIF_TEXT | LVIF_PARAM;
-    lvi.iItem = index;
-    lvi.iSubItem = 0;
+    FillRowCache(from - PREFETCH_ROWS, to + 1 + PREFETCH_ROWS);
+}
+
+//------------------------------------------------------------------------------
+// Format rows [from, to), clamped to the list.  In the timeline the first
+// note of each day carries the day's group header.  A view made stale by
+// notes added or removed elsewhere leaves the cache empty and schedules a
+// refresh.
+//------------------------------------------------------------------------------
+void NoteListWindow::FillRowCache(int from, int to) {
+    m_rowCache.clear();
+    from = std::max(from, 0);
+    to = std::min(to, static_cast<int>(m_view.size()));
+    m_rowCacheFirst = from;
+    if (from >= to) return;
+    
+    const bool timeline = (m_viewMode == NoteListViewMode::Timeline);
+    time_t previousDay = 0;
+    if (timeline && from > 0) {
+        if (const NoteSummary* previous = GetNoteAt(from - 1)) {
+            previousDay = GetMidnight(previous->createdAt);
+        }
+    }
     
-    // Title with pin indicator
-    std::wstring title = note.GetDisplayTitle();
-    if (note.isPinned) {
-        title = L"\u2605 " + title;  // Star symbol
+    m_rowCache.reserve(static_cast<size_t>(to - from));
+    for (int i = from; i < to; ++i) {
+        const NoteSummary* note = GetNoteAt(i);
+        if (!note) {
+            m_rowCache.clear();
+            if (!m_refreshPosted && m_hwnd) {
+                m_refreshPosted = PostMessageW(m_hwnd, WM_APP_REFRESHNOTES, 0, 0) != FALSE;
+            }
+            return;
+        }
+        
+        CachedRow row;
+        
+        // Title with pin indicator
+        row.title = note->GetDisplayTitle();
+        if (note->isPinned) {
+            row.title = L"\u2605 " + row.title;  // Star symbol
+        }
+        
+        const size_t index = static_cast<size_t>(i);
+        if (m_viewMode == NoteListViewMode::Search && index < m_searchSnippets.size() &&
+            !m_searchSnippets[index].empty()) {
+            // Ranked match: the text around it, on one line
+            row.date = m_searchSnippets[index];
+            std::replace_if(row.date.begin(), row.date.end(),
+                            [](wchar_t ch) { return ch < L' '; }, L' ');
+        } else if (timeline) {
+            row.date = FormatTimestamp(note->createdAt);
+            time_t day = GetMidnight(note->createdAt);
+            if (i == 0 || day != previousDay) {
+                row.date = GetDateGroupHeader(note->createdAt) + L", " + row.date;
+            }
+            previousDay = day;
+        } else {
+            row.date = FormatTimestamp(note->updatedAt);
+        }
+        m_rowCache.push_back(std::move(row));
+    }
+}
+
+const NoteSummary* NoteListWindow::GetNoteAt(int index) const {
+    if (!m_noteStore || index < 0) return nullptr;
+    return m_noteStore->GetViewNote(m_view, static_cast<size_t>(index));
+}
+
+//------------------------------------------------------------------------------
+// Restart the search with the current query, starting from an empty list.
+// The snapshot is retaken only when notes were added or removed or
+// RefreshList() dropped it.
+//------------------------------------------------------------------------------
+void NoteListWindow::StartNoteSearch() {
+    if (!m_searchSources || !m_noteStore->IsViewCurrent(m_searchBase)) {
+        NoteFilter filter;
+        filter.sortBy = NoteFilter::SortBy::UpdatedDesc;
+        m_searchBase = m_noteStore->GetNoteView(filter);
+        m_searchSources = m_noteStore->MakeSearchSources(m_searchBase);
     }
-    lvi.pszText = const_cast<LPWSTR>(title.c_str());
-    lvi.lParam = reinterpret_cast<LPARAM>(&m_displayedNotes[index]);
     
-    int itemIndex = ListView_InsertItem(m_hwndList, &lvi);
+    m_view.slots.clear();
+    m_view.layoutVersion = m_searchBase.layoutVersion;
+    m_searchSnippets.clear();
+    m_searching = true;
+    m_searchGeneration = m_search->Start(m_searchSources, m_currentSearch);
+}
+
+void NoteListWindow::OnNoteSearchResults() {
+    std::vector<NoteSearchMatch> matches;
+    bool finished = false;
+    if (!m_search || !m_search->TakeResults(m_searchGeneration, matches, finished)) return;
     
-    // Set date column
-    std::wstring dateStr;
-    if (m_viewMode == NoteListViewMode::Timeline) {
-        dateStr = FormatTimestamp(note.createdAt);
-    } else {
-        dateStr = FormatTimestamp(note.updatedAt);
+    for (auto& match : matches) {
+        m_view.slots.push_back(m_searchBase.slots[match.index]);
+        m_searchSnippets.push_back(std::move(match.snippet));
     }
-    ListView_SetItemText(m_hwndList, itemIndex, 1, const_cast<LPWSTR>(dateStr.c_str()));
+    m_searching = !finished;
+    
+    // Rows already shown keep their place; new ones are appended
+    if (!matches.empty() && m_hwndList) {
+        ListView_SetItemCountEx(m_hwndList, static_cast<int>(m_view.size()),
+                                LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+    }
+    UpdateStatusText();
+}
+
+std::wstring NoteListWindow::GetSearchText() const {
+    if (!m_hwndSearch) return std::wstring();
+    
+    int len = GetWindowTextLengthW(m_hwndSearch);
+    if (len <= 0) return std::wstring();
+    
+    std::wstring text(len + 1, L'\0');
+    GetWindowTextW(m_hwndSearch, &text[0], len + 1);
+    text.resize(len);
+    return text;
 }
 
 void NoteListWindow::OnListItemActivated(int index) {
-    if (index < 0 || index >= static_cast<int>(m_displayedNotes.size())) return;
+    const NoteSummary* note = GetNoteAt(index);
+    if (!note) return;
     
-    const NoteSummary& note = m_displayedNotes[index];
+    // The callback may change the store, so hand it a copy
+    NoteSummary summary = *note;
     if (m_openCallback) {
-        m_openCallback(note);
+        m_openCallback(summary);
     }
 }
 
 void NoteListWindow::OnListItemRightClick(int index, POINT pt) {
-    if (index < 0 || index >= static_cast<int>(m_displayedNotes.size())) return;
+    if (!GetNoteAt(index)) return;
     
     // Convert to screen coordinates
     ClientToScreen(m_hwndList, &pt);
@@ -472,9 +655,9 @@ void NoteListWindow::ShowContextMenu(int index, POINT pt) {
     bool multiSelect = selected.size() > 1;
     
     if (!multiSelect) {
-        const NoteSummary& note = m_displayedNotes[index];
+        const NoteSummary* note = GetNoteAt(index);
         AppendMenuW(hMenu, MF_STRING, IDM_CTX_OPEN, L"&Open");
-        AppendMenuW(hMenu, MF_STRING, IDM_CTX_PIN, note.isPinned ? L"&Unpin" : L"&Pin");
+        AppendMenuW(hMenu, MF_STRING, IDM_CTX_PIN, (note && note->isPinned) ? L"&Unpin" : L"&Pin");
         AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
         AppendMenuW(hMenu, MF_STRING, IDM_CTX_DELETE, L"&Delete");
     } else {
@@ -512,9 +695,10 @@ void NoteListWindow::ShowContextMenu(int index, POINT pt) {
 }
 
 void NoteListWindow::OnContextMenuPin(int index) {
-    if (index < 0 || index >= static_cast<int>(m_displayedNotes.size())) return;
+    const NoteSummary* note = GetNoteAt(index);
+    if (!note) return;
     
-    const std::wstring& noteId = m_displayedNotes[index].id;
+    std::wstring noteId = note->id;
     if (m_noteStore) {
         (void)m_noteStore->TogglePin(noteId);
         RefreshList();
@@ -522,9 +706,11 @@ void NoteListWindow::OnContextMenuPin(int index) {
 }
 
 void NoteListWindow::OnContextMenuDelete(int index) {
-    if (index < 0 || index >= static_cast<int>(m_displayedNotes.size())) return;
+    const NoteSummary* found = GetNoteAt(index);
+    if (!found) return;
     
-    const NoteSummary& note = m_displayedNotes[index];
+    // Copied: deleting moves summaries within the store
+    NoteSummary note = *found;
     
     // Confirm deletion
     std::wstring msg = L"Delete \"" + note.GetDisplayTitle() + L"\"?";
@@ -557,10 +743,8 @@ std::vector<int> NoteListWindow::GetSelectedIndices() const {
 void NoteListWindow::SelectAllItems() {
     if (!m_hwndList) return;
     
-    int count = ListView_GetItemCount(m_hwndList);
-    for (int i = 0; i < count; ++i) {
-        ListView_SetItemState(m_hwndList, i, LVIS_SELECTED, LVIS_SELECTED);
-    }
+    // Index -1 selects every row in one call
+    ListView_SetItemState(m_hwndList, -1, LVIS_SELECTED, LVIS_SELECTED);
 }
 
 void NoteListWindow::DeleteSelectedNotes() {
@@ -572,7 +756,9 @@ void NoteListWindow::DeleteSelectedNotes() {
     // Confirm deletion
     std::wstring msg;
     if (selected.size() == 1) {
-        msg = L"Delete \"" + m_displayedNotes[selected[0]].GetDisplayTitle() + L"\"?";
+        const NoteSummary* note = GetNoteAt(selected[0]);
+        if (!note) return;
+        msg = L"Delete \"" + note->GetDisplayTitle() + L"\"?";
     } else {
         msg = L"Delete " + std::to_wstring(selected.size()) + L" selected notes?";
     }
@@ -581,8 +767,8 @@ void NoteListWindow::DeleteSelectedNotes() {
         // Collect IDs first (indices will become invalid during deletion)
         std::vector<std::wstring> idsToDelete;
         for (int idx : selected) {
-            if (idx >= 0 && idx < static_cast<int>(m_displayedNotes.size())) {
-                idsToDelete.push_back(m_displayedNotes[idx].id);
+            if (const NoteSummary* note = GetNoteAt(idx)) {
+                idsToDelete.push_back(note->id);
             }
         }
         
@@ -606,8 +792,8 @@ void NoteListWindow::PinSelectedNotes() {
     
     // Toggle pin state for all selected notes
     for (int idx : selected) {
-        if (idx >= 0 && idx < static_cast<int>(m_displayedNotes.size())) {
-            (void)m_noteStore->TogglePin(m_displayedNotes[idx].id);
+        if (const NoteSummary* note = GetNoteAt(idx)) {
+            (void)m_noteStore->TogglePin(note->id);
         }
     }
     
@@ -666,7 +852,7 @@ void NoteListWindow::CreateControls() {
     m_hwndList = CreateWindowExW(
         WS_EX_CLIENTEDGE,
         WC_LISTVIEWW, L"",
-        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SHOWSELALWAYS,
+        WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SHOWSELALWAYS | LVS_OWNERDATA,
         0, 0, 400, 300,
         m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_NOTE_LIST)), m_hInstance, nullptr
     );
@@ -729,6 +915,14 @@ void NoteListWindow::UpdateViewModeUI() {
             break;
     }
     SetWindowTextW(m_hwnd, windowTitle.c_str());
+    
+    // Search results show the text around each ranked match
+    if (m_hwndList) {
+        LVCOLUMNW lvc = {};
+        lvc.mask = LVCF_TEXT;
+        lvc.pszText = const_cast<LPWSTR>(m_viewMode == NoteListViewMode::Search ? L"Match" : L"Date");
+        ListView_SetColumn(m_hwndList, 1, &lvc);
+    }
 }
 
 void NoteListWindow::UpdateStatusText() {
@@ -741,10 +935,13 @@ void NoteListWindow::UpdateStatusText() {
         ss << selected.size() << L" selected | ";
     }
     
-    ss << m_displayedNotes.size() << L" note(s)";
+    ss << m_view.size() << L" note(s)";
     
     if (!m_currentSearch.empty()) {
         ss << L" matching \"" << m_currentSearch << L"\"";
+        if (m_searching) {
+            ss << L" (searching...)";
+        }
     }
     
     ss << L" | Ctrl+A: Select All, Ctrl+P: Pin, Del: Delete";
@@ -15,7 +15,9 @@
 #include <CommCtrl.h>
 #include <string>
 #include <functional>
+#include <memory>
 #include <vector>
+#include "NoteSearch.h"
 #include "NoteStore.h"
 
 namespace QNote {
@@ -48,8 +50,9 @@ public:
     NoteListWindow(const NoteListWindow&) = delete;
     NoteListWindow& operator=(const NoteListWindow&) = delete;
     
-    // Initialize and create the window
-    [[nodiscard]] bool Create(HINSTANCE hInstance, HWND parentWindow, NoteStore* noteStore);
+    // Initialize and create the window; searches run on 'scheduler'
+    [[nodiscard]] bool Create(HINSTANCE hInstance, HWND parentWindow, NoteStore* noteStore,
+                              TaskScheduler& scheduler);
     
     // Show/hide
     void Show();
@@ -64,7 +67,7 @@ public:
     // Refresh the list
     void RefreshList();
     
-    // Perform search
+    // Perform search (as the query is typed; runs in the background)
     void Search(const std::wstring& query);
     void ClearSearch();
     
@@ -89,9 +92,20 @@ private:
     LRESULT OnCtlColorEdit(HDC hdc, HWND hwndEdit);
     LRESULT OnCtlColorStatic(HDC hdc, HWND hwndStatic);
     
-    // List operations
+    // List operations.  The list view is virtual (LVS_OWNERDATA): rows are
+    // read from m_view when shown, and only rows near the visible ones
+    // have their text formatted.
     void PopulateList();
-    void AddNoteToList(const NoteSummary& note, int index);
+    void OnGetDispInfo(NMLVDISPINFOW* pdi);
+    void OnCacheHint(int from, int to);
+    void FillRowCache(int from, int to);
+    [[nodiscard]] const NoteSummary* GetNoteAt(int index) const;
+    
+    // Background search.  Matches stream into m_view as WM_APP_NOTESEARCH
+    // arrives, ranked ones first.
+    void StartNoteSearch();
+    void OnNoteSearchResults();
+    [[nodiscard]] std::wstring GetSearchText() const;
     void OnListItemActivated(int index);
     void OnListItemRightClick(int index, POINT pt);
     
@@ -134,7 +148,25 @@ private:
     NoteStore* m_noteStore = nullptr;
     NoteListViewMode m_viewMode = NoteListViewMode::AllNotes;
     std::wstring m_currentSearch;
-    std::vector<NoteSummary> m_displayedNotes;
+    NoteView m_view;                       // Rows of the list, in order
+    bool m_refreshPosted = false;          // WM_APP_REFRESHNOTES pending
+    
+    // Search runs over a snapshot of m_searchBase, which is kept while the
+    // query is being typed and retaken by RefreshList()
+    std::unique_ptr<NoteSearch> m_search;
+    NoteView m_searchBase;
+    NoteSearchSources m_searchSources;
+    std::vector<std::wstring> m_searchSnippets;   // Per row of m_view; empty if not ranked
+    uint64_t m_searchGeneration = 0;
+    bool m_searching = false;
+    
+    // Formatted text of rows [m_rowCacheFirst, m_rowCacheFirst + size)
+    struct CachedRow {
+        std::wstring title;
+        std::wstring date;
+    };
+    std::vector<CachedRow> m_rowCache;
+    int m_rowCacheFirst = 0;
     
     NoteOpenCallback m_openCallback;
     NoteDeleteCallback m_deleteCallback;
@@ -147,6 +179,9 @@ private:
     static constexpr int STATUS_HEIGHT = 22;
     static constexpr int PADDING = 8;
     
+    // Rows formatted on each side of the visible ones
+    static constexpr int PREFETCH_ROWS = 64;
+    
     // Window class name
     static constexpr wchar_t WINDOW_CLASS[] = L"QNoteListWindow";
     
@@ -6,6 +6,7 @@
 #include "PrintPreviewWindow.h"
 #include "FileIO.h"
 #include "resource.h"
+#include "Trace.h"
 #include <CommCtrl.h>
 #include <Commdlg.h>
 #include <algorithm>
@@ -952,6 +953,7 @@ std::wstring PrintPreviewWindow::ExpandTokens(const std::wstring& tmpl,
 // (new pages copy page-0; existing per-page overrides are preserved).
 //------------------------------------------------------------------------------
 void PrintPreviewWindow::Paginate() {
+    QNOTE_TRACE_SCOPE("PrintPreviewWindow::Paginate");
     if (m_pageSettings.empty()) return;
 
     const PageSettings& base = m_pageSettings[0];
@@ -290,6 +290,7 @@ void SettingsWindow::InitControlsFromSettings() {
         case TextEncoding::UTF8_BOM: encIdx = 2; break;
         case TextEncoding::UTF16_LE: encIdx = 3; break;
         case TextEncoding::UTF16_BE: encIdx = 4; break;
+        default: break;
     }
     SendMessageW(hwndEnc, CB_SETCURSEL, encIdx, 0);
     
@@ -0,0 +1,241 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// CharsetDetectorTest.cpp - Accuracy of the legacy code page detector
+//==============================================================================
+
+// Portable: runs wherever CharsetDetector does.  The corpus directory
+// (tests/charset) holds prose in each supported code page; every file is
+// named after the code page it is encoded in ("cp1251-russian.txt").
+// Whole files, short windows cut at arbitrary byte offsets, files repeated
+// past the sampling threshold and files buried in ASCII are all checked.
+#include "CharsetDetector.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+namespace fs = std::filesystem;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+struct CorpusFile {
+    std::string name;
+    Charset charset = Charset::Windows1252;
+    std::vector<uint8_t> bytes;
+};
+
+bool CharsetFromName(const std::string& name, Charset& charset) {
+    static const struct {
+        const char* prefix;
+        Charset charset;
+    } PREFIXES[] = {
+        { "cp1252-", Charset::Windows1252 },
+        { "cp1251-", Charset::Windows1251 },
+        { "cp932-", Charset::ShiftJIS },
+        { "gb18030-", Charset::GB18030 },
+    };
+    for (const auto& entry : PREFIXES) {
+        if (name.compare(0, std::strlen(entry.prefix), entry.prefix) == 0) {
+            charset = entry.charset;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<CorpusFile> LoadCorpus(const fs::path& directory) {
+    std::vector<CorpusFile> corpus;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        CorpusFile file;
+        file.name = entry.path().filename().string();
+        if (!entry.is_regular_file() || !CharsetFromName(file.name, file.charset)) continue;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        file.bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        corpus.push_back(std::move(file));
+    }
+    return corpus;
+}
+
+CharsetDetection Detect(const std::vector<uint8_t>& bytes, size_t offset = 0,
+                        size_t size = SIZE_MAX) {
+    size = std::min(size, bytes.size() - offset);
+    return DetectCharset(bytes.data() + offset, size);
+}
+
+// The ranking is complete, ordered, and its confidences sum to 1
+bool IsWellFormed(const CharsetDetection& detection) {
+    double sum = 0.0;
+    bool seen[CHARSET_COUNT] = {};
+    for (size_t i = 0; i < CHARSET_COUNT; i++) {
+        const CharsetScore& score = detection.ranked[i];
+        if (score.confidence < 0.0 || score.confidence > 1.0) return false;
+        if (i > 0 && score.confidence > detection.ranked[i - 1].confidence) return false;
+        size_t index = static_cast<size_t>(score.charset);
+        if (index >= CHARSET_COUNT || seen[index]) return false;
+        seen[index] = true;
+        sum += score.confidence;
+    }
+    return sum > 0.999 && sum < 1.001;
+}
+
+void ReportMiss(const CorpusFile& file, const char* what, const CharsetDetection& detection) {
+    std::fprintf(stderr, "  %s (%s): detected code page %u at %.2f\n", file.name.c_str(), what,
+                 CharsetCodePage(detection.Best().charset), detection.Best().confidence);
+}
+
+// Every whole file is detected, with a clear margin
+void TestWholeFiles(const std::vector<CorpusFile>& corpus) {
+    for (const auto& file : corpus) {
+        CharsetDetection detection = Detect(file.bytes);
+        CHECK(IsWellFormed(detection));
+        CHECK(detection.sampledBytes == file.bytes.size());
+        CHECK(detection.highBytes > 0);
+        if (detection.Best().charset != file.charset || detection.Best().confidence < 0.9) {
+            ReportMiss(file, "whole file", detection);
+            g_failures++;
+        }
+    }
+}
+
+// Windows cut at every few bytes, so multi-byte characters are split at
+// both ends.  Short windows carry little evidence; the rate, not every
+// window, has to be right.
+void TestWindows(const std::vector<CorpusFile>& corpus) {
+    struct Rate {
+        size_t window;
+        double minimum;
+    };
+    const Rate RATES[] = { { 256, 0.99 }, { 96, 0.95 }, { 32, 0.80 } };
+
+    for (const auto& rate : RATES) {
+        for (size_t c = 0; c < CHARSET_COUNT; c++) {
+            size_t tried = 0;
+            size_t right = 0;
+            for (const auto& file : corpus) {
+                if (static_cast<size_t>(file.charset) != c || file.bytes.size() < rate.window) continue;
+                for (size_t offset = 0; offset + rate.window <= file.bytes.size(); offset += 7) {
+                    CharsetDetection detection = Detect(file.bytes, offset, rate.window);
+                    CHECK(IsWellFormed(detection));
+                    // Windows with no high bytes carry no evidence at all
+                    if (detection.highBytes == 0) continue;
+                    tried++;
+                    if (detection.Best().charset == file.charset) right++;
+                }
+            }
+            CHECK(tried > 0);
+            double accuracy = tried ? static_cast<double>(right) / static_cast<double>(tried) : 0.0;
+            if (accuracy < rate.minimum) {
+                std::fprintf(stderr, "  code page %u, %zu-byte windows: %.3f < %.2f\n",
+                             CharsetCodePage(static_cast<Charset>(c)), rate.window, accuracy,
+                             rate.minimum);
+                g_failures++;
+            }
+        }
+    }
+}
+
+// Past the sampling threshold only part of the input is read, and the
+// answer must not change
+void TestLargeInputs(const std::vector<CorpusFile>& corpus) {
+    for (const auto& file : corpus) {
+        std::vector<uint8_t> large;
+        while (large.size() < 16u * 1024 * 1024) {
+            large.insert(large.end(), file.bytes.begin(), file.bytes.end());
+        }
+        CharsetDetection detection = Detect(large);
+        CHECK(IsWellFormed(detection));
+        CHECK(detection.sampledBytes < 1024u * 1024);
+        if (detection.Best().charset != file.charset) {
+            ReportMiss(file, "repeated to 16 MB", detection);
+            g_failures++;
+        }
+    }
+}
+
+// A little legacy text in a large ASCII file (a log with one accented
+// paragraph) is found in the prefix, middle or suffix window, or in one of
+// the extra windows read when those are all ASCII
+void TestSparseText(const std::vector<CorpusFile>& corpus) {
+    const size_t SIZE = 8u * 1024 * 1024;
+    for (const auto& file : corpus) {
+        for (size_t position : { size_t(0), SIZE * 5 / 16, SIZE / 2, SIZE - file.bytes.size() }) {
+            std::vector<uint8_t> log(SIZE);
+            for (size_t i = 0; i < SIZE; i++) {
+                log[i] = static_cast<uint8_t>(i % 64 == 63 ? '\n' : 'a' + i % 26);
+            }
+            std::copy(file.bytes.begin(), file.bytes.end(), log.begin() + position);
+
+            CharsetDetection detection = Detect(log);
+            CHECK(IsWellFormed(detection));
+            CHECK(detection.highBytes > 0);
+            if (detection.Best().charset != file.charset) {
+                ReportMiss(file, "inside ASCII", detection);
+                g_failures++;
+            }
+        }
+    }
+}
+
+// Degenerate inputs still give a well-formed ranking
+void TestEdgeCases() {
+    const uint8_t ascii[] = "plain ASCII text\r\n";
+    CharsetDetection detection = DetectCharset(ascii, sizeof(ascii) - 1);
+    CHECK(IsWellFormed(detection));
+    CHECK(detection.highBytes == 0);
+
+    detection = DetectCharset(nullptr, 0);
+    CHECK(IsWellFormed(detection));
+    CHECK(detection.sampledBytes == 0);
+
+    std::vector<uint8_t> noise(4096);
+    for (size_t i = 0; i < noise.size(); i++) noise[i] = static_cast<uint8_t>(i * 131 + 7);
+    CHECK(IsWellFormed(DetectCharset(noise.data(), noise.size())));
+
+    CHECK(CharsetCodePage(Charset::Windows1252) == 1252);
+    CHECK(CharsetCodePage(Charset::Windows1251) == 1251);
+    CHECK(CharsetCodePage(Charset::ShiftJIS) == 932);
+    CHECK(CharsetCodePage(Charset::GB18030) == 54936);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: CharsetDetectorTest <corpus directory>\n");
+        return 2;
+    }
+    std::vector<CorpusFile> corpus = LoadCorpus(argv[1]);
+    CHECK(corpus.size() >= CHARSET_COUNT);
+
+    TestWholeFiles(corpus);
+    TestWindows(corpus);
+    TestLargeInputs(corpus);
+    TestSparseText(corpus);
+    TestEdgeCases();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("CharsetDetector tests passed (%zu corpus files)\n", corpus.size());
+    return 0;
+}
@@ -0,0 +1,189 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineDedupeTest.cpp - Remove Duplicate Lines compared against a map model
+//==============================================================================
+
+// Portable: runs wherever LineDedupe does.  The hash table is checked
+// against a std::map keyed by the normalized line, with enough distinct
+// lines to make the table grow several times.
+#include "LineDedupe.h"
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// Trim, collapse blank runs to one space, fold case, as the options say
+std::wstring ModelKey(const std::wstring& line, const LineDedupeOptions& options) {
+    std::wstring key;
+    bool pendingSpace = false;
+    for (wchar_t ch : line) {
+        if (options.ignoreWhitespace && (ch == L' ' || ch == L'\t')) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace) key.push_back(L' ');
+        pendingSpace = false;
+        key.push_back(options.ignoreCase ? static_cast<wchar_t>(std::towlower(ch)) : ch);
+    }
+    return key;
+}
+
+std::vector<std::wstring> ModelDedupe(const std::vector<std::wstring>& lines,
+                                      const LineDedupeOptions& options) {
+    struct Entry {
+        size_t firstLine;
+        size_t count;
+    };
+    std::map<std::wstring, size_t> positions;
+    std::vector<Entry> entries;
+    for (size_t i = 0; i < lines.size(); i++) {
+        auto inserted = positions.emplace(ModelKey(lines[i], options), entries.size());
+        if (inserted.second) {
+            entries.push_back({ i, 1 });
+        } else {
+            entries[inserted.first->second].count++;
+        }
+    }
+
+    size_t maxCount = 0;
+    for (const auto& entry : entries) maxCount = std::max(maxCount, entry.count);
+    const size_t width = std::to_wstring(maxCount).size();
+
+    std::vector<std::wstring> result;
+    for (const auto& entry : entries) {
+        const std::wstring& line = lines[entry.firstLine];
+        switch (options.mode) {
+            case DedupeMode::RemoveDuplicates:
+                result.push_back(line);
+                break;
+            case DedupeMode::ShowDuplicates:
+                if (entry.count > 1) result.push_back(line);
+                break;
+            case DedupeMode::CountOccurrences: {
+                std::wstring count = std::to_wstring(entry.count);
+                result.push_back(std::wstring(width - count.size(), L' ') + count + L"  " + line);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+bool DedupeMatchesModel(const std::vector<std::wstring>& lines, const LineDedupeOptions& options) {
+    std::vector<std::wstring_view> views(lines.begin(), lines.end());
+    TextArena arena;
+    DedupeLines(views, options, arena);
+
+    std::vector<std::wstring> expected = ModelDedupe(lines, options);
+    if (views.size() != expected.size()) return false;
+    for (size_t i = 0; i < views.size(); i++) {
+        if (views[i] != expected[i]) return false;
+    }
+    return true;
+}
+
+// Lines drawn from a vocabulary of 'distinct' base lines, with random
+// case and blank variations of each
+std::vector<std::wstring> RandomLines(std::mt19937& random, size_t count, size_t distinct) {
+    std::vector<std::wstring> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t word = random() % distinct;
+        std::wstring line;
+        if (random() % 4 == 0) line += (random() % 2) ? L"  " : L"\t";
+        line += (random() % 3 == 0) ? L"Line" : L"line";
+        line += (random() % 4 == 0) ? L" \t " : L" ";
+        line += std::to_wstring(word);
+        if (random() % 5 == 0) line += L" ";
+        if (word % 7 == 0) line += L" \x416\x65e5";
+        lines.push_back(std::move(line));
+    }
+    // Blank and whitespace-only lines
+    lines.push_back(L"");
+    lines.push_back(L" \t ");
+    lines.push_back(L"");
+    return lines;
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(31337);
+    const DedupeMode modes[] = { DedupeMode::RemoveDuplicates, DedupeMode::ShowDuplicates,
+                                 DedupeMode::CountOccurrences };
+    for (DedupeMode mode : modes) {
+        for (int flags = 0; flags < 4; flags++) {
+            LineDedupeOptions options;
+            options.mode = mode;
+            options.ignoreCase = (flags & 1) != 0;
+            options.ignoreWhitespace = (flags & 2) != 0;
+            for (size_t distinct : { size_t(1), size_t(10), size_t(1000), size_t(100000) }) {
+                CHECK(DedupeMatchesModel(RandomLines(random, 20000, distinct), options));
+            }
+        }
+    }
+    CHECK(DedupeMatchesModel({}, LineDedupeOptions()));
+}
+
+// Unchanged lines stay views of the source text
+void TestKeepsSourceViews() {
+    std::wstring text = L"b\na\nb\nc\na";
+    LineSet set = SplitLines(text);
+    TextArena arena;
+    DedupeLines(set.lines, LineDedupeOptions(), arena);
+    CHECK(set.lines.size() == 3);
+    CHECK(set.lines.size() == 3 && set.lines[0].data() == text.data() &&
+          set.lines[1].data() == text.data() + 2 && set.lines[2].data() == text.data() + 6);
+}
+
+void TestCountFormat() {
+    std::vector<std::wstring_view> lines;
+    for (int i = 0; i < 12; i++) lines.push_back(L"x");
+    lines.push_back(L"y");
+    TextArena arena;
+    LineDedupeOptions options;
+    options.mode = DedupeMode::CountOccurrences;
+    DedupeLines(lines, options, arena);
+    std::vector<std::wstring_view> expected = { L"12  x", L" 1  y" };
+    CHECK(lines == expected);
+}
+
+void TestPipelineStage() {
+    LineDedupeOptions options;
+    options.ignoreCase = true;
+    LinePipeline pipeline;
+    pipeline.Apply(LineTransforms::Dedupe(options));
+    CHECK(pipeline.Run(L"One\r\ntwo\r\nONE\r\nTwo\r\n") == L"One\r\ntwo\r\n");
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestKeepsSourceViews();
+    TestCountFormat();
+    TestPipelineStage();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("LineDedupe tests passed\n");
+    return 0;
+}
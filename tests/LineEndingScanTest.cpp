@@ -0,0 +1,177 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineEndingScanTest.cpp - Line break counting and conversion tests
+//==============================================================================
+
+// Portable: runs wherever LineEndingScan does.  The 16-character scan is
+// compared with a one-character-at-a-time model on random texts, with
+// breaks placed on and across the block boundaries.
+#include "LineEndingScan.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+LineEndingCounts ModelCount(const std::wstring& text) {
+    LineEndingCounts counts;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n') {
+            counts.crlf++;
+            i++;
+        } else if (text[i] == L'\r') {
+            counts.cr++;
+        } else if (text[i] == L'\n') {
+            counts.lf++;
+        }
+    }
+    return counts;
+}
+
+std::wstring ModelConvert(const std::wstring& text, const std::wstring& newline) {
+    std::wstring out;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == L'\r' && i + 1 < text.size() && text[i + 1] == L'\n') {
+            out += newline;
+            i++;
+        } else if (text[i] == L'\r' || text[i] == L'\n') {
+            out += newline;
+        } else {
+            out.push_back(text[i]);
+        }
+    }
+    return out;
+}
+
+bool SameCounts(const LineEndingCounts& a, const LineEndingCounts& b) {
+    return a.crlf == b.crlf && a.lf == b.lf && a.cr == b.cr;
+}
+
+// Mostly text, with runs of every kind of break; characters that differ
+// from CR/LF only in high bits catch a scan that compares too little
+std::wstring RandomText(std::mt19937& random, size_t length, int breakPercent) {
+    static const wchar_t OTHER[] = { L'a', L' ', L'\t', L'\x10d', L'\x10a', L'\x20d',
+                                     L'\xff0a', L'\x0c', L'\x0b' };
+    std::wstring text;
+    text.reserve(length);
+    while (text.size() < length) {
+        if (static_cast<int>(random() % 100) < breakPercent) {
+            switch (random() % 3) {
+                case 0: text += L"\r\n"; break;
+                case 1: text += L"\n"; break;
+                default: text += L"\r"; break;
+            }
+        } else {
+            text.push_back(OTHER[random() % (sizeof(OTHER) / sizeof(OTHER[0]))]);
+        }
+    }
+    return text;
+}
+
+void CheckText(const std::wstring& text) {
+    LineEndingCounts expected = ModelCount(text);
+    LineEndingCounts counts = CountLineEndings(text);
+    CHECK(SameCounts(counts, expected));
+
+    for (const wchar_t* newline : { L"\r\n", L"\n", L"\r" }) {
+        std::wstring converted = ModelConvert(text, newline);
+        CHECK(ConvertedLength(counts, text.size(), newline) == converted.size());
+
+        std::vector<wchar_t> out(converted.size() + 1, L'#');
+        size_t written = WriteConvertedLineEndings(text, newline, out.data());
+        CHECK(written == converted.size());
+        CHECK(std::wstring(out.data(), written) == converted);
+        CHECK(out[written] == L'#');
+
+        std::wstring inPlace = text;
+        ConvertLineEndingsInPlace(inPlace, newline);
+        CHECK(inPlace == converted);
+    }
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(4242);
+    for (size_t length = 0; length <= 80; length++) {
+        for (int breakPercent : { 0, 5, 30, 90, 100 }) {
+            CheckText(RandomText(random, length, breakPercent));
+        }
+    }
+    for (int round = 0; round < 20; round++) {
+        CheckText(RandomText(random, 100000 + random() % 1000, 10));
+    }
+}
+
+// A CR as the last character of one 16-character block and an LF as the
+// first of the next still make one CRLF
+void TestBlockBoundaries() {
+    for (size_t position = 0; position < 48; position++) {
+        std::wstring text(50, L'x');
+        text[position] = L'\r';
+        text[position + 1] = L'\n';
+        LineEndingCounts counts = CountLineEndings(text);
+        CHECK(counts.crlf == 1 && counts.lf == 0 && counts.cr == 0);
+        CHECK(!counts.IsMixed() && counts.Total() == 1);
+        CheckText(text);
+
+        // A lone CR at the end of a block, followed by text
+        text[position + 1] = L'y';
+        counts = CountLineEndings(text);
+        CHECK(counts.crlf == 0 && counts.cr == 1);
+    }
+
+    std::wstring runs = std::wstring(33, L'\r') + std::wstring(33, L'\n');
+    LineEndingCounts counts = CountLineEndings(runs);
+    CHECK(counts.cr == 32 && counts.crlf == 1 && counts.lf == 32);
+    CHECK(counts.IsMixed());
+    CheckText(runs);
+}
+
+// Converting to one-character breaks never grows the text, so it is done
+// in the string's own buffer
+void TestInPlaceWhenShrinking() {
+    std::wstring text;
+    for (int i = 0; i < 1000; i++) text += L"line\r\n";
+    const wchar_t* buffer = text.data();
+    ConvertLineEndingsInPlace(text, L"\n");
+    CHECK(text.data() == buffer);
+    CHECK(text.size() == 5000);
+    CHECK(CountLineEndings(text).lf == 1000);
+
+    ConvertLineEndingsInPlace(text, L"\r\n");
+    CHECK(text.size() == 6000);
+    CHECK(CountLineEndings(text).crlf == 1000);
+
+    std::wstring empty;
+    ConvertLineEndingsInPlace(empty, L"\r\n");
+    CHECK(empty.empty());
+    CHECK(CountLineEndings(empty).Total() == 0);
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestBlockBoundaries();
+    TestInPlaceWhenShrinking();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("LineEndingScan tests passed\n");
+    return 0;
+}
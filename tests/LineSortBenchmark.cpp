@@ -0,0 +1,87 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineSortBenchmark.cpp - Sort Lines timing on a large generated CSV
+//==============================================================================
+
+// Portable: runs wherever LineSort does.  Not part of ctest; run it by hand
+// after changing LineSort:
+//   LineSortBenchmark [lines] [workers]
+// Lines default to 10 million and workers to one per hardware thread.  Each
+// option set is timed on a fresh copy of the same lines.
+#include "LineSort.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+// CSV rows: a mixed-case name with a numeric suffix, a number and a word,
+// so plain, natural and by-column sorts all see realistic collisions
+std::wstring MakeText(size_t count) {
+    static const wchar_t* const WORDS[] = { L"alpha", L"Beta", L"gamma", L"DELTA", L"epsilon",
+                                            L"Zeta", L"eta", L"theta" };
+    std::mt19937 random(42);
+    std::wstring text;
+    text.reserve(count * 32);
+    for (size_t i = 0; i < count; i++) {
+        text += (random() % 2) ? L"Item" : L"item";
+        text += std::to_wstring(random() % 100000);
+        text += L',';
+        text += std::to_wstring(random() % 1000000);
+        text += L',';
+        text += WORDS[random() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+        text += L'\n';
+    }
+    return text;
+}
+
+double TimeSort(const LineSet& set, const LineSortOptions& options, TaskScheduler* scheduler) {
+    std::vector<std::wstring_view> lines = set.lines;
+    auto start = std::chrono::steady_clock::now();
+    SortLines(lines, options, scheduler);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t workers = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                              : (std::max)(1u, std::thread::hardware_concurrency());
+
+    std::wstring text = MakeText(count);
+    LineSet set = SplitLines(text);
+    TaskScheduler scheduler(workers);
+    std::printf("%zu lines, %zu worker(s)\n", set.lines.size(), scheduler.GetWorkerCount());
+
+    struct Case {
+        const char* name;
+        LineSortOptions options;
+    };
+    std::vector<Case> cases(5);
+    cases[0].name = "case-insensitive";
+    cases[1].name = "case-sensitive";
+    cases[1].options.caseSensitive = true;
+    cases[2].name = "natural";
+    cases[2].options.natural = true;
+    cases[3].name = "natural, column 2";
+    cases[3].options.natural = true;
+    cases[3].options.column = 2;
+    cases[3].options.delimiter = L',';
+    cases[4].name = "descending, unique";
+    cases[4].options.descending = true;
+    cases[4].options.unique = true;
+
+    for (const auto& sortCase : cases) {
+        std::printf("  %-20s %7.2f s\n", sortCase.name, TimeSort(set, sortCase.options, &scheduler));
+    }
+    return 0;
+}
@@ -0,0 +1,327 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineSortTest.cpp - Sort Lines compared against a straightforward model
+//==============================================================================
+
+// Portable: runs wherever LineSort does.  Every option combination is
+// checked against std::stable_sort with a comparison written out from the
+// documented rules, on inputs small enough to stay on one thread and large
+// enough to be split across workers.
+#include "LineSort.h"
+#include <algorithm>
+#include <cstdio>
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+//------------------------------------------------------------------------------
+// Model
+//------------------------------------------------------------------------------
+
+bool IsBlank(wchar_t ch) {
+    return ch == L' ' || ch == L'\t';
+}
+
+// 1-based field; fields are split on 'delimiter', or on runs of blanks
+std::wstring ModelField(const std::wstring& line, int column, wchar_t delimiter) {
+    if (column <= 0) return line;
+
+    std::vector<std::wstring> fields;
+    std::wstring field;
+    if (delimiter != 0) {
+        for (wchar_t ch : line) {
+            if (ch == delimiter) {
+                fields.push_back(field);
+                field.clear();
+            } else {
+                field.push_back(ch);
+            }
+        }
+        fields.push_back(field);
+    } else {
+        for (wchar_t ch : line) {
+            if (IsBlank(ch)) {
+                if (!field.empty()) fields.push_back(field);
+                field.clear();
+            } else {
+                field.push_back(ch);
+            }
+        }
+        if (!field.empty()) fields.push_back(field);
+    }
+    return static_cast<size_t>(column) <= fields.size() ? fields[column - 1] : std::wstring();
+}
+
+std::wstring ModelKey(const std::wstring& line, const LineSortOptions& options) {
+    std::wstring key = ModelField(line, options.column, options.delimiter);
+    if (!options.caseSensitive) {
+        for (auto& ch : key) ch = static_cast<wchar_t>(std::towlower(ch));
+    }
+    return key;
+}
+
+// Digit runs compare by value, then fewer leading zeros first; everything
+// else by code unit
+int ModelNatural(const std::wstring& a, const std::wstring& b) {
+    auto digit = [](wchar_t ch) { return ch >= L'0' && ch <= L'9'; };
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (!digit(a[i]) || !digit(b[j])) {
+            if (a[i] != b[j]) return a[i] < b[j] ? -1 : 1;
+            i++;
+            j++;
+            continue;
+        }
+        size_t endA = i, endB = j;
+        while (endA < a.size() && digit(a[endA])) endA++;
+        while (endB < b.size() && digit(b[endB])) endB++;
+        std::wstring runA = a.substr(i, endA - i);
+        std::wstring runB = b.substr(j, endB - j);
+        size_t zerosA = std::min(runA.find_first_not_of(L'0'), runA.size());
+        size_t zerosB = std::min(runB.find_first_not_of(L'0'), runB.size());
+        std::wstring valueA = runA.substr(zerosA);
+        std::wstring valueB = runB.substr(zerosB);
+        if (valueA.size() != valueB.size()) return valueA.size() < valueB.size() ? -1 : 1;
+        if (valueA != valueB) return valueA < valueB ? -1 : 1;
+        if (zerosA != zerosB) return zerosA < zerosB ? -1 : 1;
+        i = endA;
+        j = endB;
+    }
+    if (i < a.size()) return 1;
+    if (j < b.size()) return -1;
+    return 0;
+}
+
+// Indices of the input lines in sorted order
+std::vector<size_t> ModelSort(const std::vector<std::wstring>& lines,
+                              const LineSortOptions& options) {
+    std::vector<std::pair<std::wstring, size_t>> keyed;
+    for (size_t i = 0; i < lines.size(); i++) {
+        keyed.emplace_back(ModelKey(lines[i], options), i);
+    }
+    auto compare = [&options](const std::wstring& a, const std::wstring& b) {
+        if (options.natural) return ModelNatural(a, b);
+        return a < b ? -1 : (b < a ? 1 : 0);
+    };
+    std::stable_sort(keyed.begin(), keyed.end(), [&](const auto& x, const auto& y) {
+        int cmp = compare(x.first, y.first);
+        return options.descending ? cmp > 0 : cmp < 0;
+    });
+
+    std::vector<size_t> sorted;
+    for (size_t i = 0; i < keyed.size(); i++) {
+        if (options.unique && i > 0 && compare(keyed[i - 1].first, keyed[i].first) == 0) continue;
+        sorted.push_back(keyed[i].second);
+    }
+    return sorted;
+}
+
+//------------------------------------------------------------------------------
+// Inputs
+//------------------------------------------------------------------------------
+
+// Short lines over a small alphabet, so keys collide often: digit runs
+// with leading zeros, mixed case, blanks, commas and a few non-ASCII letters
+std::vector<std::wstring> RandomLines(std::mt19937& random, size_t count) {
+    static const wchar_t ALPHABET[] = L"aAbBzZ0012345679  \t,,-_\xe9\xc9\x430\x410";
+    const size_t alphabetSize = sizeof(ALPHABET) / sizeof(ALPHABET[0]) - 1;
+
+    std::vector<std::wstring> lines(count);
+    for (auto& line : lines) {
+        size_t length = random() % 12;
+        for (size_t k = 0; k < length; k++) {
+            line.push_back(ALPHABET[random() % alphabetSize]);
+        }
+    }
+    return lines;
+}
+
+bool SortMatchesModel(const std::vector<std::wstring>& lines, const LineSortOptions& options,
+                      TaskScheduler* scheduler = nullptr) {
+    std::vector<std::wstring_view> views(lines.begin(), lines.end());
+    SortLines(views, options, scheduler);
+
+    std::vector<size_t> expected = ModelSort(lines, options);
+    if (views.size() != expected.size()) return false;
+    for (size_t i = 0; i < views.size(); i++) {
+        // Compare addresses: equal lines must keep their input order too
+        const std::wstring& line = lines[expected[i]];
+        if (views[i].data() != line.data() || views[i].size() != line.size()) return false;
+    }
+    return true;
+}
+
+std::vector<LineSortOptions> AllOptions() {
+    std::vector<LineSortOptions> all;
+    for (int mask = 0; mask < 16; mask++) {
+        for (int column = 0; column <= 2; column++) {
+            for (wchar_t delimiter : { wchar_t(0), L',' }) {
+                if (column == 0 && delimiter != 0) continue;
+                LineSortOptions options;
+                options.descending = (mask & 1) != 0;
+                options.caseSensitive = (mask & 2) != 0;
+                options.natural = (mask & 4) != 0;
+                options.unique = (mask & 8) != 0;
+                options.column = column;
+                options.delimiter = delimiter;
+                all.push_back(options);
+            }
+        }
+    }
+    return all;
+}
+
+//------------------------------------------------------------------------------
+// Tests
+//------------------------------------------------------------------------------
+
+void TestAgainstModel() {
+    std::mt19937 random(2024);
+    for (const auto& options : AllOptions()) {
+        for (size_t count : { size_t(0), size_t(1), size_t(2), size_t(50), size_t(3000) }) {
+            CHECK(SortMatchesModel(RandomLines(random, count), options));
+        }
+    }
+}
+
+// Enough lines to be chunk-sorted and merged on several workers; five
+// chunks leave an odd run out in the first merge round
+void TestLargeInput() {
+    std::mt19937 random(77);
+    std::vector<std::wstring> lines = RandomLines(random, 400000);
+
+    for (size_t workers : { size_t(4), size_t(5) }) {
+        TaskScheduler scheduler(workers);
+
+        LineSortOptions plain;
+        CHECK(SortMatchesModel(lines, plain, &scheduler));
+
+        LineSortOptions natural;
+        natural.natural = true;
+        natural.descending = true;
+        CHECK(SortMatchesModel(lines, natural, &scheduler));
+
+        LineSortOptions column;
+        column.column = 2;
+        column.caseSensitive = true;
+        column.unique = true;
+        CHECK(SortMatchesModel(lines, column, &scheduler));
+    }
+}
+
+// Lines sharing a long prefix (log timestamps) stay in one run of equal
+// sort key prefixes for several rounds, which are refined across workers;
+// a clamped code unit in the shared part sends the run to a text sort
+void TestSharedPrefixes() {
+    std::mt19937 random(91);
+    for (const wchar_t* shared : { L"2024-01-01 12:00:00 ", L"log \xffff\x0001 entry " }) {
+        std::vector<std::wstring> lines = RandomLines(random, 100000);
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (i % 10 != 0) lines[i] = shared + lines[i];
+        }
+        TaskScheduler scheduler(3);
+
+        LineSortOptions plain;
+        CHECK(SortMatchesModel(lines, plain, &scheduler));
+        CHECK(SortMatchesModel(lines, plain));
+
+        LineSortOptions natural;
+        natural.natural = true;
+        natural.descending = true;
+        CHECK(SortMatchesModel(lines, natural, &scheduler));
+
+        LineSortOptions unique;
+        unique.caseSensitive = true;
+        unique.unique = true;
+        CHECK(SortMatchesModel(lines, unique, &scheduler));
+    }
+}
+
+void TestNaturalOrder() {
+    std::vector<std::wstring> lines = { L"file10", L"file2", L"file01", L"file1", L"File3",
+                                        L"file", L"file2a", L"file2 ", L"99", L"100", L"0099" };
+    std::vector<std::wstring_view> views(lines.begin(), lines.end());
+    LineSortOptions options;
+    options.natural = true;
+    SortLines(views, options);
+
+    std::vector<std::wstring_view> expected = { L"99", L"0099", L"100", L"file", L"file1",
+                                                L"file01", L"file2", L"file2 ", L"file2a",
+                                                L"File3", L"file10" };
+    CHECK(views == expected);
+
+    // Numbers longer than any integer type still compare by value
+    std::vector<std::wstring_view> big = { L"x123456789012345678901234567890",
+                                           L"x99999999999999999999999999999" };
+    SortLines(big, options);
+    CHECK(big[0] == L"x99999999999999999999999999999");
+}
+
+void TestColumnsAndUnique() {
+    std::vector<std::wstring_view> lines = { L"b,3,x", L"a,1", L"c,2,y", L"d", L"e,1,z" };
+    LineSortOptions options;
+    options.column = 2;
+    options.delimiter = L',';
+    SortLines(lines, options);
+    std::vector<std::wstring_view> expected = { L"d", L"a,1", L"e,1,z", L"c,2,y", L"b,3,x" };
+    CHECK(lines == expected);
+
+    std::vector<std::wstring_view> words = { L"Beta", L"alpha", L"ALPHA", L"beta", L"gamma" };
+    LineSortOptions unique;
+    unique.unique = true;
+    SortLines(words, unique);
+    std::vector<std::wstring_view> first = { L"alpha", L"Beta", L"gamma" };
+    CHECK(words == first);
+
+    // Blank-separated fields skip leading and repeated blanks
+    std::vector<std::wstring_view> blanks = { L"  x\t\t20", L"y 3", L"z    100" };
+    LineSortOptions numeric;
+    numeric.column = 2;
+    numeric.natural = true;
+    SortLines(blanks, numeric);
+    std::vector<std::wstring_view> byValue = { L"y 3", L"  x\t\t20", L"z    100" };
+    CHECK(blanks == byValue);
+}
+
+void TestPipelineStage() {
+    LineSortOptions options;
+    options.descending = true;
+    LinePipeline pipeline;
+    TaskScheduler scheduler(2);
+    pipeline.Apply(LineTransforms::Sort(options, &scheduler));
+    CHECK(pipeline.Run(L"b\r\na\r\nc\r\n") == L"c\r\nb\r\na\r\n");
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestLargeInput();
+    TestSharedPrefixes();
+    TestNaturalOrder();
+    TestColumnsAndUnique();
+    TestPipelineStage();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("LineSort tests passed\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// LineTransformTest.cpp - Line splitting, pipeline and stock transform tests
+//==============================================================================
+
+// Portable: runs wherever LineTransform does.
+#include "LineTransform.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+std::wstring RunOne(LinePipeline::LineFn fn, const std::wstring& text) {
+    LinePipeline pipeline;
+    pipeline.Map(std::move(fn));
+    return pipeline.Run(text);
+}
+
+std::wstring RunOne(LinePipeline::ListFn fn, const std::wstring& text) {
+    LinePipeline pipeline;
+    pipeline.Apply(std::move(fn));
+    return pipeline.Run(text);
+}
+
+// Splitting and joining a text with one kind of break gives it back
+void TestSplitJoin() {
+    std::mt19937 random(5);
+    for (const wchar_t* eol : { L"\r\n", L"\n", L"\r" }) {
+        for (int round = 0; round < 200; round++) {
+            std::wstring text;
+            size_t lines = random() % 20;
+            for (size_t i = 0; i < lines; i++) {
+                text += std::wstring(random() % 5, static_cast<wchar_t>(L'a' + i % 26));
+                if (i + 1 < lines || random() % 2) text += eol;
+            }
+            LineSet set = SplitLines(text);
+            CHECK(JoinLines(set) == text);
+            if (text.find(eol) != std::wstring::npos) CHECK(set.eol == eol);
+        }
+    }
+
+    LineSet set = SplitLines(L"a\r\nb\nc\rd\n");
+    std::vector<std::wstring_view> expected = { L"a", L"b", L"c", L"d" };
+    CHECK(set.lines == expected);
+    CHECK(set.eol == L"\r\n" && set.trailingEol);
+    CHECK(JoinLines(set) == L"a\r\nb\r\nc\r\nd\r\n");
+
+    CHECK(SplitLines(L"").lines.empty());
+    CHECK(SplitLines(L"\n").lines.size() == 1 && SplitLines(L"\n").trailingEol);
+    CHECK(SplitLines(L"x").lines.size() == 1 && !SplitLines(L"x").trailingEol);
+}
+
+// The edit turns 'before' into 'after' and touches as little as possible
+void TestMinimalEdit() {
+    std::mt19937 random(6);
+    for (int round = 0; round < 2000; round++) {
+        std::wstring before, after;
+        for (size_t i = random() % 12; i > 0; i--) before.push_back(L"abc"[random() % 3]);
+        for (size_t i = random() % 12; i > 0; i--) after.push_back(L"abc"[random() % 3]);
+
+        TextEdit edit = ComputeMinimalEdit(before, after);
+        std::wstring applied = before;
+        applied.replace(edit.start, edit.removeLength, edit.insert);
+        CHECK(applied == after);
+        CHECK(edit.IsNoOp() == (before == after));
+        CHECK(edit.insert.empty() || (edit.insert.data() >= after.data() &&
+                                      edit.insert.data() + edit.insert.size() <= after.data() + after.size()));
+    }
+
+    TextEdit edit = ComputeMinimalEdit(L"hello world", L"hello there world");
+    CHECK(edit.start == 6 && edit.removeLength == 0 && edit.insert == L"there ");
+}
+
+// Consecutive Map() stages run in one pass; each sees its own line count
+void TestFusedStages() {
+    std::vector<std::wstring> seen;
+    LinePipeline pipeline;
+    pipeline.Map(LineTransforms::RemoveBlankLines())
+            .Map([&seen](std::wstring_view& line, size_t index, TextArena& arena) {
+                seen.push_back(std::to_wstring(index) + L":" + std::wstring(line));
+                line = arena.Concat({ L"<", line, L">" });
+                return index % 2 == 0;
+            })
+            .Apply(LineTransforms::Reverse())
+            .Map([](std::wstring_view& line, size_t index, TextArena& arena) {
+                line = arena.Concat({ std::to_wstring(index), line });
+                return true;
+            });
+    CHECK(!pipeline.IsEmpty());
+    CHECK(LinePipeline().IsEmpty());
+
+    CHECK(pipeline.Run(L"a\n\nb\n  \nc\nd\n") == L"0<c>\n1<a>\n");
+    std::vector<std::wstring> expected = { L"0:a", L"1:b", L"2:c", L"3:d" };
+    CHECK(seen == expected);
+}
+
+void TestStockTransforms() {
+    using namespace LineTransforms;
+
+    CHECK(RunOne(TrimTrailingWhitespace(), L"a  \n b\t\n \t\n") == L"a\n b\n\n");
+    CHECK(RunOne(RemoveBlankLines(), L"a\n\n \t\nb") == L"a\nb");
+    CHECK(RunOne(LeadingSpacesToTabs(4), L"        x\n      y\n   z\n    \n") ==
+          L"\t\tx\n\t  y\n   z\n\t\n");
+    CHECK(RunOne(Reverse(), L"1\r\n2\r\n3") == L"3\r\n2\r\n1");
+
+    std::wstring ten;
+    for (int i = 0; i < 10; i++) ten += L"x\n";
+    std::wstring numbered = RunOne(NumberLines(), ten);
+    CHECK(numbered.compare(0, 6, L" 1: x\n") == 0);
+    CHECK(numbered.compare(numbered.size() - 6, 6, L"10: x\n") == 0);
+
+    CHECK(RunOne(WrapAt(10), L"aaaa bbbb cccc dddd\n0123456789abc") ==
+          L"aaaa bbbb \ncccc dddd\n0123456789\nabc");
+    CHECK(RunOne(JoinWithSpaces(), L"a\n\nb\nc\n") == L"a b c\n");
+
+    std::wstring code = L"  int x;\n\n  // already\n";
+    std::wstring commented = RunOne(ToggleComment(L"// "), code);
+    CHECK(commented == L"  // int x;\n\n  // // already\n");
+    CHECK(RunOne(ToggleComment(L"// "), commented) == L"  int x;\n\n  // already\n");
+    CHECK(RunOne(ToggleComment(L"# "), L"#a\n# b\n") == L"a\nb\n");
+}
+
+// Views handed out by the arena stay valid while it grows
+void TestArena() {
+    TextArena arena(16);
+    std::vector<std::wstring_view> views;
+    std::vector<std::wstring> copies;
+    for (int i = 0; i < 1000; i++) {
+        std::wstring text(static_cast<size_t>(i % 40), static_cast<wchar_t>(L'a' + i % 26));
+        copies.push_back(text);
+        std::wstring_view whole = copies.back();
+        size_t split = whole.size() / 2;
+        views.push_back(i % 2 ? arena.Store(whole)
+                              : arena.Concat({ whole.substr(0, split), whole.substr(split) }));
+    }
+    bool intact = true;
+    for (size_t i = 0; i < views.size(); i++) intact = intact && views[i] == copies[i];
+    CHECK(intact);
+
+    arena.Clear();
+    CHECK(arena.Store(L"after clear") == L"after clear");
+    CHECK(arena.Store(L"").empty());
+}
+
+} // anonymous namespace
+
+int main() {
+    TestSplitJoin();
+    TestMinimalEdit();
+    TestFusedStages();
+    TestStockTransforms();
+    TestArena();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("LineTransform tests passed\n");
+    return 0;
+}
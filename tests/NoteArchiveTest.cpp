@@ -0,0 +1,304 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteArchiveTest.cpp - Round-trip and large-archive tests for note export
+//==============================================================================
+
+// Portable: runs wherever NoteArchive does.  Archives are written to and
+// read from memory; the large-archive test only checks that both sides
+// stay within their buffer sizes whatever the number of notes.
+#include "NoteArchive.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+bool SameRecord(const NoteArchiveRecord& a, const NoteArchiveRecord& b) {
+    return a.id == b.id && a.title == b.title && a.content == b.content &&
+           a.createdAt == b.createdAt && a.updatedAt == b.updatedAt && a.isPinned == b.isPinned;
+}
+
+// Serve 'data' to a reader 'chunk' bytes at a time
+NoteArchiveReader::Source MemorySource(const std::string& data, size_t chunk) {
+    auto offset = std::make_shared<size_t>(0);
+    return [&data, chunk, offset](char* buffer, size_t capacity, size_t& bytesRead) {
+        bytesRead = std::min({ capacity, chunk, data.size() - *offset });
+        std::memcpy(buffer, data.data() + *offset, bytesRead);
+        *offset += bytesRead;
+        return true;
+    };
+}
+
+std::string WriteArchive(const std::vector<NoteArchiveRecord>& notes) {
+    std::string out;
+    NoteArchiveWriter writer([&out](const char* data, size_t size) {
+        out.append(data, size);
+        return true;
+    });
+    for (const auto& note : notes) {
+        CHECK(writer.WriteNote(note));
+    }
+    CHECK(writer.Finish());
+    CHECK(writer.GetBytesWritten() == out.size());
+    return out;
+}
+
+std::vector<NoteArchiveRecord> ReadArchive(const std::string& data, size_t chunk, bool& error) {
+    std::vector<NoteArchiveRecord> notes;
+    NoteArchiveReader reader(MemorySource(data, chunk));
+    NoteArchiveRecord note;
+    while (reader.Next(note)) {
+        notes.push_back(note);
+    }
+    error = reader.HasError();
+    return notes;
+}
+
+// Text with everything the writer has to escape or encode
+std::wstring RandomText(std::mt19937& random, size_t length) {
+    static const wchar_t SPECIAL[] = { L'"', L'\\', L'\n', L'\r', L'\t', L'\b', L'\f',
+                                       L'\x01', L'\x1f', L'/', L'\x7f', L'\xe9', L'\x416',
+                                       L'\x65e5', L'\xfeff', L'\xffff' };
+    std::wstring text;
+    text.reserve(length + 2);
+    while (text.size() < length) {
+        uint32_t kind = random() % 10;
+        if (kind < 6) {
+            text.push_back(static_cast<wchar_t>(L' ' + random() % 95));
+        } else if (kind < 9) {
+            text.push_back(SPECIAL[random() % (sizeof(SPECIAL) / sizeof(SPECIAL[0]))]);
+        } else if (sizeof(wchar_t) == 2) {
+            // A supplementary character as a surrogate pair
+            uint32_t cp = 0x10000 + random() % 0x100000;
+            text.push_back(static_cast<wchar_t>(0xD800 + ((cp - 0x10000) >> 10)));
+            text.push_back(static_cast<wchar_t>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+        } else {
+            text.push_back(static_cast<wchar_t>(0x10000 + random() % 0x100000));
+        }
+    }
+    return text;
+}
+
+NoteArchiveRecord RandomRecord(std::mt19937& random, size_t index) {
+    NoteArchiveRecord note;
+    note.id = L"note-" + std::to_wstring(index);
+    note.title = RandomText(random, random() % 40);
+    note.content = RandomText(random, random() % 2000);
+    note.createdAt = static_cast<time_t>(random());
+    note.updatedAt = note.createdAt + static_cast<time_t>(random() % 100000);
+    note.isPinned = random() % 4 == 0;
+    return note;
+}
+
+// Whatever the writer produces the reader returns unchanged, however the
+// input is split into reads
+void TestRoundTrip() {
+    std::mt19937 random(1234);
+    std::vector<NoteArchiveRecord> notes;
+    for (size_t i = 0; i < 500; i++) {
+        notes.push_back(RandomRecord(random, i));
+    }
+    notes.push_back(NoteArchiveRecord{ L"empty", L"", L"", 0, 0, false });
+
+    const std::string archive = WriteArchive(notes);
+    for (size_t chunk : { size_t(1), size_t(7), size_t(4093), NoteArchiveReader::READ_CHUNK }) {
+        bool error = true;
+        std::vector<NoteArchiveRecord> read = ReadArchive(archive, chunk, error);
+        CHECK(!error);
+        CHECK(read.size() == notes.size());
+        bool same = read.size() == notes.size();
+        for (size_t i = 0; same && i < notes.size(); i++) {
+            same = SameRecord(read[i], notes[i]);
+        }
+        CHECK(same);
+    }
+
+    bool error = true;
+    CHECK(ReadArchive(WriteArchive({}), 16, error).empty());
+    CHECK(!error);
+}
+
+// A large export streams through both sides: the writer hands over about
+// BUFFER_SIZE at a time and the reader never asks for more than READ_CHUNK
+void TestLargeArchive() {
+    constexpr size_t NOTE_COUNT = 20000;
+
+    std::mt19937 random(99);
+    std::vector<std::wstring> contents;
+    for (size_t i = 0; i < 64; i++) {
+        contents.push_back(RandomText(random, 1000 + random() % 3000));
+    }
+    auto makeNote = [&contents](size_t index) {
+        NoteArchiveRecord note;
+        note.id = L"large-" + std::to_wstring(index);
+        note.title = L"Note " + std::to_wstring(index);
+        note.content = contents[index % contents.size()];
+        note.createdAt = static_cast<time_t>(1600000000 + index);
+        note.updatedAt = note.createdAt + 1;
+        note.isPinned = index % 10 == 0;
+        return note;
+    };
+
+    std::string archive;
+    size_t largestWrite = 0;
+    size_t sinkCalls = 0;
+    NoteArchiveWriter writer([&](const char* data, size_t size) {
+        archive.append(data, size);
+        largestWrite = std::max(largestWrite, size);
+        sinkCalls++;
+        return true;
+    });
+    for (size_t i = 0; i < NOTE_COUNT; i++) {
+        CHECK(writer.WriteNote(makeNote(i)));
+    }
+    CHECK(writer.Finish());
+    CHECK(archive.size() > 32u * 1024 * 1024);
+    CHECK(largestWrite <= NoteArchiveWriter::BUFFER_SIZE + 64 * 1024);
+    CHECK(sinkCalls >= archive.size() / (NoteArchiveWriter::BUFFER_SIZE + 64 * 1024));
+
+    size_t largestRead = 0;
+    size_t offset = 0;
+    NoteArchiveReader reader([&](char* buffer, size_t capacity, size_t& bytesRead) {
+        largestRead = std::max(largestRead, capacity);
+        bytesRead = std::min(capacity, archive.size() - offset);
+        std::memcpy(buffer, archive.data() + offset, bytesRead);
+        offset += bytesRead;
+        return true;
+    });
+
+    NoteArchiveRecord note;
+    size_t count = 0;
+    bool same = true;
+    while (reader.Next(note)) {
+        same = same && SameRecord(note, makeNote(count));
+        count++;
+    }
+    CHECK(!reader.HasError());
+    CHECK(count == NOTE_COUNT);
+    CHECK(same);
+    CHECK(reader.GetBytesRead() == archive.size());
+    CHECK(largestRead <= NoteArchiveReader::READ_CHUNK);
+}
+
+// Inputs the old parser accepted, and ones the reader must reject
+void TestReaderInputs() {
+    bool error = true;
+
+    // UTF-8 BOM, whitespace, members in any order, unknown members
+    std::string bom = "\xEF\xBB\xBF [ {\"isPinned\": true, \"extra\": [1, {\"a\": null}],"
+                      " \"content\": \"x\\u00e9\\ud83d\\ude00\", \"id\": \"a\","
+                      " \"createdAt\": 5, \"updatedAt\": -3, \"title\": \"T\"} ]";
+    std::vector<NoteArchiveRecord> notes = ReadArchive(bom, 3, error);
+    CHECK(!error);
+    CHECK(notes.size() == 1);
+    if (notes.size() == 1) {
+        std::wstring expected = L"x\xe9";
+        if (sizeof(wchar_t) == 2) {
+            expected += L"\xd83d\xde00";
+        } else {
+            expected.push_back(static_cast<wchar_t>(0x1F600));
+        }
+        CHECK(notes[0].id == L"a" && notes[0].title == L"T" && notes[0].content == expected);
+        CHECK(notes[0].createdAt == 5 && notes[0].updatedAt == -3 && notes[0].isPinned);
+    }
+
+    // The note index layout, notes without an id, non-object elements
+    std::string index = "{\"version\": 2, \"notes\": [1, \"s\", null, {\"title\": \"no id\"},"
+                        " {\"id\": \"b\"}, [[]], {\"id\": \"c\", \"isPinned\": false}],"
+                        " \"after\": {}}";
+    notes = ReadArchive(index, 5, error);
+    CHECK(!error);
+    CHECK(notes.size() == 2);
+    CHECK(notes.size() == 2 && notes[0].id == L"b" && notes[1].id == L"c");
+
+    // Invalid UTF-8 is read as U+FFFD
+    notes = ReadArchive("[{\"id\": \"x\xff\xc3\"}]", 64, error);
+    CHECK(!error);
+    CHECK(notes.size() == 1 && notes[0].id == L"x\xfffd\xfffd");
+
+    // An empty file holds no notes and is not an error
+    CHECK(ReadArchive("", 64, error).empty() && !error);
+    CHECK(ReadArchive("{\"other\": 1}", 64, error).empty() && !error);
+
+    // Malformed input stops with an error, keeping the notes before it
+    notes = ReadArchive("[{\"id\": \"ok\"} {\"id\": \"lost\"}]", 64, error);
+    CHECK(error && notes.size() == 1);
+    CHECK(ReadArchive("[{\"id\": \"a\"", 64, error).empty() && error);
+    CHECK(ReadArchive("[{\"id\": \"a\\u12\"}]", 64, error).empty() && error);
+
+    // Unknown escapes are kept as written, as the old parser did
+    notes = ReadArchive("[{\"id\": \"a\\q\"}]", 64, error);
+    CHECK(!error && notes.size() == 1 && notes[0].id == L"a\\q");
+    CHECK(ReadArchive("nonsense", 64, error).empty() && error);
+
+    // Skipped values may nest only so deep
+    std::string deep = "[" + std::string(NoteArchiveReader::MAX_DEPTH + 10, '[') +
+                       std::string(NoteArchiveReader::MAX_DEPTH + 10, ']') + "]";
+    CHECK(ReadArchive(deep, 64, error).empty() && error);
+    std::string shallow = "[" + std::string(10, '[') + std::string(10, ']') + ", {\"id\": \"d\"}]";
+    notes = ReadArchive(shallow, 64, error);
+    CHECK(!error && notes.size() == 1);
+}
+
+// Read and write failures are reported, not mistaken for the end
+void TestFailures() {
+    size_t calls = 0;
+    NoteArchiveReader reader([&calls](char* buffer, size_t, size_t& bytesRead) {
+        if (calls++ > 0) return false;
+        static const char START[] = "[{\"id\": \"a\"}, {\"id\": ";
+        std::memcpy(buffer, START, sizeof(START) - 1);
+        bytesRead = sizeof(START) - 1;
+        return true;
+    });
+    NoteArchiveRecord note;
+    CHECK(reader.Next(note) && note.id == L"a");
+    CHECK(!reader.Next(note));
+    CHECK(reader.HasError());
+
+    std::mt19937 random(7);
+    size_t accepted = 0;
+    NoteArchiveWriter writer([&accepted](const char*, size_t) {
+        return accepted++ < 2;
+    });
+    bool ok = true;
+    for (size_t i = 0; ok && i < 10000; i++) {
+        ok = writer.WriteNote(RandomRecord(random, i));
+    }
+    CHECK(!ok);
+    CHECK(!writer.Finish());
+    CHECK(!writer.WriteNote(RandomRecord(random, 0)));
+    CHECK(accepted == 3);
+}
+
+} // anonymous namespace
+
+int main() {
+    TestRoundTrip();
+    TestLargeArchive();
+    TestReaderInputs();
+    TestFailures();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteArchive tests passed\n");
+    return 0;
+}
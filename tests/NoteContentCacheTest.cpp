@@ -0,0 +1,240 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteContentCacheTest.cpp - Budget, scan resistance and concurrency tests
+//==============================================================================
+
+// Portable: runs wherever NoteContentCache does.
+#include "NoteContentCache.h"
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+std::mutex g_failuresMutex;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::lock_guard<std::mutex> failuresLock(g_failuresMutex);          \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// About 'kilobytes' KB of content that names its note and version
+NoteContentPtr MakeContent(const std::wstring& id, uint64_t version, size_t kilobytes) {
+    std::wstring text = id + L"#" + std::to_wstring(version) + L"#";
+    text.resize(kilobytes * 512, L'x');
+    return std::make_shared<const std::wstring>(std::move(text));
+}
+
+bool Belongs(const NoteContentPtr& content, const std::wstring& id) {
+    return content && content->compare(0, id.size() + 1, id + L"#") == 0;
+}
+
+std::wstring NoteId(size_t n) {
+    return L"note-" + std::to_wstring(n);
+}
+
+// Random single-threaded use: the budget holds and every hit is the newest
+// content given for the note
+void TestAgainstModel() {
+    std::mt19937 random(41);
+    NoteContentCache cache(256 * 1024);
+    std::map<std::wstring, NoteContentPtr> newest;
+    uint64_t finds = 0;
+
+    for (int round = 0; round < 20000; round++) {
+        std::wstring id = NoteId(random() % 200);
+        CacheAccess access = (random() % 3 == 0) ? CacheAccess::Scan : CacheAccess::Normal;
+        switch (random() % 6) {
+            case 0: {
+                NoteContentPtr content = MakeContent(id, round, 1 + random() % 16);
+                cache.Update(id, content);
+                newest[id] = content;
+                break;
+            }
+            case 1:
+                cache.Erase(id);
+                newest.erase(id);
+                break;
+            default: {
+                finds++;
+                NoteContentPtr found = cache.Find(id, access);
+                if (found) {
+                    CHECK(newest.count(id) && found == newest[id]);
+                } else if (!newest.count(id)) {
+                    // Loaded from "disk" after the miss
+                    newest[id] = MakeContent(id, round, 1 + random() % 16);
+                    cache.Insert(id, newest[id], access);
+                } else {
+                    cache.Insert(id, newest[id], access);
+                }
+                break;
+            }
+        }
+
+        NoteContentCacheStats stats = cache.GetStats();
+        CHECK(stats.bytes <= stats.capacityBytes);
+        CHECK(stats.probationBytes <= stats.bytes);
+        CHECK(stats.entries <= newest.size());
+    }
+    NoteContentCacheStats stats = cache.GetStats();
+    CHECK(stats.hits + stats.misses == finds);
+    CHECK(stats.hits > 0 && stats.misses > 0 && stats.evictions > 0);
+
+    // An Insert() racing an Update() must not bring back older content
+    NoteContentPtr written = MakeContent(L"raced", 2, 1);
+    cache.Update(L"raced", written);
+    cache.Insert(L"raced", MakeContent(L"raced", 1, 1));
+    CHECK(cache.Find(L"raced") == written);
+}
+
+// Notes in use survive a scan over many times the budget
+void TestScanResistance() {
+    const size_t CAPACITY = 1024 * 1024;
+    NoteContentCache cache(CAPACITY);
+
+    // 16 notes of about 8 KB each, each read twice: the main queue
+    for (size_t i = 0; i < 16; i++) {
+        CHECK(!cache.Find(NoteId(i)));
+        cache.Insert(NoteId(i), MakeContent(NoteId(i), 0, 8));
+        CHECK(cache.Find(NoteId(i)));
+    }
+    CHECK(cache.GetStats().probationBytes == 0);
+
+    for (size_t i = 1000; i < 2000; i++) {
+        if (!cache.Find(NoteId(i), CacheAccess::Scan)) {
+            cache.Insert(NoteId(i), MakeContent(NoteId(i), 0, 8), CacheAccess::Scan);
+        }
+    }
+    NoteContentCacheStats stats = cache.GetStats();
+    CHECK(stats.evictions > 0);
+    CHECK(stats.probationBytes <= CAPACITY);
+
+    for (size_t i = 0; i < 16; i++) {
+        CHECK(Belongs(cache.Find(NoteId(i), CacheAccess::Scan), NoteId(i)));
+    }
+}
+
+// A note loaded again soon after leaving probation goes to the main queue
+void TestGhosts() {
+    NoteContentCache cache(64 * 1024);
+    for (size_t i = 0; i < 40; i++) {
+        cache.Insert(NoteId(i), MakeContent(NoteId(i), 0, 4));
+    }
+    CHECK(!cache.Find(NoteId(0)));
+
+    auto mainBytes = [&cache]() {
+        NoteContentCacheStats stats = cache.GetStats();
+        return stats.bytes - stats.probationBytes;
+    };
+    CHECK(mainBytes() == 0);
+    cache.Insert(NoteId(0), MakeContent(NoteId(0), 1, 4));
+    CHECK(mainBytes() > 0);
+
+    // Unless it comes back through a scan
+    size_t mainBefore = mainBytes();
+    CHECK(!cache.Find(NoteId(1), CacheAccess::Scan));
+    cache.Insert(NoteId(1), MakeContent(NoteId(1), 1, 4), CacheAccess::Scan);
+    CHECK(mainBytes() == mainBefore);
+    CHECK(cache.Find(NoteId(1), CacheAccess::Scan));
+}
+
+void TestBudget() {
+    NoteContentCache cache(64 * 1024);
+
+    // Content over the whole budget is not cached
+    cache.Insert(L"huge", MakeContent(L"huge", 0, 128));
+    CHECK(!cache.Find(L"huge"));
+
+    // Readers keep their buffer after the entry is evicted
+    cache.Insert(L"kept", MakeContent(L"kept", 0, 4));
+    NoteContentPtr held = cache.Find(L"kept");
+    cache.SetCapacity(0);
+    CHECK(cache.GetStats().entries == 0 && cache.GetStats().bytes == 0);
+    CHECK(Belongs(held, L"kept") && held->size() == 4 * 512);
+
+    cache.SetCapacity(64 * 1024);
+    cache.Update(L"a", MakeContent(L"a", 0, 1));
+    cache.Insert(L"b", MakeContent(L"b", 0, 1));
+    cache.Clear();
+    CHECK(cache.GetStats().entries == 0 && cache.GetStats().bytes == 0);
+    CHECK(!cache.Find(L"a") && !cache.Find(L"b"));
+    cache.Insert(L"null", nullptr);
+    CHECK(!cache.Find(L"null"));
+}
+
+// Readers, loaders and writers on shared notes
+void TestConcurrentUse() {
+    NoteContentCache cache(512 * 1024);
+    std::atomic<uint64_t> finds{ 0 };
+    std::vector<std::thread> threads;
+
+    for (unsigned t = 0; t < 8; t++) {
+        threads.emplace_back([&cache, &finds, t]() {
+            std::mt19937 random(t);
+            for (int i = 0; i < 20000; i++) {
+                std::wstring id = NoteId(random() % 300);
+                switch (random() % 8) {
+                    case 0:
+                        cache.Update(id, MakeContent(id, i, 1 + random() % 8));
+                        break;
+                    case 1:
+                        cache.Erase(id);
+                        break;
+                    case 2:
+                        if (t == 0 && i % 1000 == 0) cache.SetCapacity(256 * 1024 + random() % (512 * 1024));
+                        break;
+                    default: {
+                        CacheAccess access = (t % 2) ? CacheAccess::Scan : CacheAccess::Normal;
+                        finds++;
+                        NoteContentPtr found = cache.Find(id, access);
+                        if (found) {
+                            CHECK(Belongs(found, id));
+                        } else {
+                            cache.Insert(id, MakeContent(id, i, 1 + random() % 8), access);
+                        }
+                        break;
+                    }
+                }
+                if (i % 500 == 0) {
+                    NoteContentCacheStats stats = cache.GetStats();
+                    CHECK(stats.bytes <= stats.capacityBytes);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    NoteContentCacheStats stats = cache.GetStats();
+    CHECK(stats.hits + stats.misses == finds.load());
+    CHECK(stats.bytes <= stats.capacityBytes);
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestScanResistance();
+    TestGhosts();
+    TestBudget();
+    TestConcurrentUse();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteContentCache tests passed\n");
+    return 0;
+}
@@ -0,0 +1,230 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteLogTest.cpp - Crash/reopen consistency tests for the packed note log
+//==============================================================================
+
+// Portable: runs wherever NoteLog does.  A "crash" is simulated by reopening
+// the log from the last checkpoint that was saved, with the segment files
+// left as the crash would leave them.
+#include "NoteLog.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+namespace fs = std::filesystem;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// A fresh directory, removed afterwards
+class TempDir {
+public:
+    TempDir() {
+        std::random_device random;
+        m_path = fs::temp_directory_path() / ("qnote-notelog-" + std::to_string(random()));
+        fs::create_directories(m_path);
+    }
+    ~TempDir() {
+        std::error_code ignored;
+        fs::remove_all(m_path, ignored);
+    }
+    [[nodiscard]] std::wstring Get() const { return m_path.wstring(); }
+    [[nodiscard]] fs::path Segment(uint32_t number) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%08x.qnlog", number);
+        return m_path / name;
+    }
+
+private:
+    fs::path m_path;
+};
+
+std::string Key(int note) {
+    return "note" + std::to_string(note);
+}
+
+// Recognizable content for one revision of one note
+std::string Payload(int note, int revision, size_t size) {
+    std::string payload = Key(note) + " revision " + std::to_string(revision) + " ";
+    payload.reserve(size);
+    while (payload.size() < size) {
+        payload.push_back(static_cast<char>('a' + (payload.size() + note + revision) % 26));
+    }
+    return payload;
+}
+
+bool OpenLog(NoteLog& log, const TempDir& dir, const NoteLogCheckpoint& checkpoint,
+             std::vector<NoteLogChange>& changes) {
+    std::wstring error;
+    return log.Open(dir.Get(), checkpoint, changes, error);
+}
+
+bool HasPayload(const NoteLog& log, const std::string& key, const std::string& expected) {
+    std::string payload;
+    return log.Read(key, payload) && payload == expected;
+}
+
+//------------------------------------------------------------------------------
+// A checkpoint taken while compaction is copying records still points at the
+// old segments.  Saving it must not delete them, and reopening from it must
+// find every note, whether or not the compaction's moves were replayed.
+//------------------------------------------------------------------------------
+void TestCheckpointDuringCompaction() {
+    constexpr int NOTES = 14;
+    constexpr int OVERWRITTEN = 10;
+    constexpr size_t NOTE_BYTES = 300 * 1024;     // 14 notes fill one segment
+    constexpr int ATTEMPTS = 20;
+
+    bool exercised = false;
+    for (int attempt = 0; attempt < ATTEMPTS && !exercised; attempt++) {
+        TempDir dir;
+        std::vector<NoteLogChange> changes;
+        NoteLogCheckpoint checkpoint;
+        {
+            NoteLog log;
+            if (!OpenLog(log, dir, NoteLogCheckpoint(), changes)) {
+                CHECK(false);
+                return;
+            }
+            // Compaction follows a group commit; hold the commit back until
+            // every append is done and the poll below is running
+            log.SetSyncLatency(std::chrono::milliseconds(200));
+            for (int note = 0; note < NOTES; note++) {
+                CHECK(log.Append(Key(note), Payload(note, 0, NOTE_BYTES), note));
+            }
+            for (int note = 0; note < OVERWRITTEN; note++) {
+                CHECK(log.Append(Key(note), Payload(note, 1, NOTE_BYTES), NOTES + note));
+            }
+
+            // Take the checkpoint as soon as the compaction is seen running
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!log.GetStats().compacting && log.GetStats().compactions == 0 &&
+                   std::chrono::steady_clock::now() < deadline) {
+            }
+            CHECK(log.Checkpoint(checkpoint));
+
+            while (log.GetStats().compactions == 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            CHECK(log.GetStats().compactions > 0);
+
+            // The checkpoint predates the moves if it still refers to the
+            // first segment, which the compaction emptied
+            for (const auto& entry : checkpoint.table) {
+                if (entry.second.segment == 1) exercised = true;
+            }
+
+            // The index holding the checkpoint is now durable
+            log.CheckpointSaved(checkpoint);
+            log.Close();
+        }
+
+        // Crash: the index on disk holds 'checkpoint'
+        NoteLog reopened;
+        CHECK(OpenLog(reopened, dir, checkpoint, changes));
+        for (int note = 0; note < NOTES; note++) {
+            int revision = note < OVERWRITTEN ? 1 : 0;
+            CHECK(HasPayload(reopened, Key(note), Payload(note, revision, NOTE_BYTES)));
+        }
+    }
+    if (!exercised) {
+        std::fprintf(stderr, "TestCheckpointDuringCompaction: no checkpoint landed inside a compaction\n");
+        g_failures++;
+    }
+}
+
+//------------------------------------------------------------------------------
+// A record torn by a crash is cut off; records before it, including ones
+// newer than the checkpoint, are recovered, and appends continue cleanly
+//------------------------------------------------------------------------------
+void TestTornTail() {
+    TempDir dir;
+    std::vector<NoteLogChange> changes;
+    NoteLogCheckpoint checkpoint;
+    {
+        NoteLog log;
+        CHECK(OpenLog(log, dir, NoteLogCheckpoint(), changes));
+        CHECK(log.Append(Key(1), Payload(1, 0, 1000), 1));
+        CHECK(log.Checkpoint(checkpoint));
+        CHECK(log.Append(Key(2), Payload(2, 0, 1000), 2));
+        CHECK(log.Append(Key(3), Payload(3, 0, 1000), 3));
+        log.Close();
+    }
+
+    // Tear the last record
+    const fs::path segment = dir.Segment(checkpoint.segment);
+    fs::resize_file(segment, fs::file_size(segment) - 10);
+
+    {
+        NoteLog log;
+        CHECK(OpenLog(log, dir, checkpoint, changes));
+        CHECK(changes.size() == 1 && changes[0].key == Key(2) && !changes[0].removed);
+        CHECK(HasPayload(log, Key(1), Payload(1, 0, 1000)));
+        CHECK(HasPayload(log, Key(2), Payload(2, 0, 1000)));
+        std::string payload;
+        CHECK(!log.Read(Key(3), payload));
+
+        CHECK(log.Append(Key(4), Payload(4, 0, 1000), 4));
+        log.Close();
+    }
+
+    NoteLog log;
+    CHECK(OpenLog(log, dir, checkpoint, changes));
+    CHECK(HasPayload(log, Key(2), Payload(2, 0, 1000)));
+    CHECK(HasPayload(log, Key(4), Payload(4, 0, 1000)));
+}
+
+//------------------------------------------------------------------------------
+// A removal written after the checkpoint is replayed
+//------------------------------------------------------------------------------
+void TestRemovalAfterCheckpoint() {
+    TempDir dir;
+    std::vector<NoteLogChange> changes;
+    NoteLogCheckpoint checkpoint;
+    {
+        NoteLog log;
+        CHECK(OpenLog(log, dir, NoteLogCheckpoint(), changes));
+        CHECK(log.Append(Key(1), Payload(1, 0, 100), 1));
+        CHECK(log.Append(Key(2), Payload(2, 0, 100), 2));
+        CHECK(log.Checkpoint(checkpoint));
+        CHECK(log.Remove(Key(1)));
+        log.Close();
+    }
+
+    NoteLog log;
+    CHECK(OpenLog(log, dir, checkpoint, changes));
+    CHECK(changes.size() == 1 && changes[0].key == Key(1) && changes[0].removed);
+    std::string payload;
+    CHECK(!log.Read(Key(1), payload));
+    CHECK(HasPayload(log, Key(2), Payload(2, 0, 100)));
+}
+
+} // anonymous namespace
+
+int main() {
+    TestCheckpointDuringCompaction();
+    TestTornTail();
+    TestRemovalAfterCheckpoint();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteLog tests passed\n");
+    return 0;
+}
@@ -0,0 +1,319 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearchIndexTest.cpp - Ranked note search compared against a scan model
+//==============================================================================
+
+// Portable: runs wherever NoteSearchIndex does.  Random notes are added,
+// replaced and removed; after each batch every query's hits are checked
+// against a model that tokenizes every note again: which notes match,
+// their BM25 scores and order, and where the snippets fall.
+#include "NoteSearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cwctype>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+struct ModelNote {
+    uint64_t tag = 0;
+    std::wstring title;
+    std::wstring content;
+};
+
+std::vector<std::wstring> Words(const std::wstring& text) {
+    std::vector<std::wstring> words;
+    std::wstring word;
+    for (wchar_t ch : text) {
+        if (std::iswalnum(ch)) {
+            word.push_back(static_cast<wchar_t>(std::towlower(ch)));
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(word);
+    return words;
+}
+
+size_t Count(const std::vector<std::wstring>& words, const std::wstring& term) {
+    return static_cast<size_t>(std::count(words.begin(), words.end(), term));
+}
+
+bool ContainsRun(const std::vector<std::wstring>& words, const std::vector<std::wstring>& run) {
+    if (run.empty()) return true;
+    return std::search(words.begin(), words.end(), run.begin(), run.end()) != words.end();
+}
+
+// A query as the model sees it: the words outside quotes, and each quoted
+// part of more than one word as a phrase
+struct ModelQuery {
+    std::vector<std::wstring> terms;
+    std::vector<std::vector<std::wstring>> phrases;
+};
+
+ModelQuery ParseModelQuery(const std::wstring& query) {
+    ModelQuery parsed;
+    size_t start = 0;
+    bool inPhrase = false;
+    while (true) {
+        size_t quote = query.find(L'"', start);
+        std::vector<std::wstring> words =
+            Words(query.substr(start, quote == std::wstring::npos ? std::wstring::npos : quote - start));
+        for (const auto& word : words) {
+            if (std::find(parsed.terms.begin(), parsed.terms.end(), word) == parsed.terms.end()) {
+                parsed.terms.push_back(word);
+            }
+        }
+        if (inPhrase && words.size() > 1) parsed.phrases.push_back(words);
+        if (quote == std::wstring::npos) break;
+        inPhrase = !inPhrase;
+        start = quote + 1;
+    }
+    return parsed;
+}
+
+struct ModelHit {
+    std::wstring id;
+    double score = 0.0;
+};
+
+std::vector<ModelHit> ModelSearch(const std::map<std::wstring, ModelNote>& notes,
+                                  const std::wstring& query) {
+    std::vector<ModelHit> hits;
+    ModelQuery parsed = ParseModelQuery(query);
+    if (parsed.terms.empty() || notes.empty()) return hits;
+
+    std::map<std::wstring, std::pair<std::vector<std::wstring>, std::vector<std::wstring>>> words;
+    double totalTitle = 0.0, totalBody = 0.0;
+    for (const auto& [id, note] : notes) {
+        auto& entry = words[id];
+        entry.first = Words(note.title);
+        entry.second = Words(note.content);
+        totalTitle += static_cast<double>(entry.first.size());
+        totalBody += static_cast<double>(entry.second.size());
+    }
+    const double count = static_cast<double>(notes.size());
+    const double avgTitle = std::max(1.0, totalTitle / count);
+    const double avgBody = std::max(1.0, totalBody / count);
+
+    std::vector<double> idf;
+    for (const auto& term : parsed.terms) {
+        double df = 0.0;
+        for (const auto& [id, entry] : words) {
+            if (Count(entry.first, term) + Count(entry.second, term) > 0) df += 1.0;
+        }
+        idf.push_back(std::log(1.0 + (count - df + 0.5) / (df + 0.5)));
+    }
+
+    for (const auto& [id, entry] : words) {
+        const auto& [title, body] = entry;
+        bool match = true;
+        for (const auto& term : parsed.terms) {
+            match = match && Count(title, term) + Count(body, term) > 0;
+        }
+        for (const auto& phrase : parsed.phrases) {
+            match = match && (ContainsRun(title, phrase) || ContainsRun(body, phrase));
+        }
+        if (!match) continue;
+
+        const double k1 = NoteSearchIndex::K1, b = NoteSearchIndex::B;
+        const double titleNorm = 1.0 - b + b * static_cast<double>(title.size()) / avgTitle;
+        const double bodyNorm = 1.0 - b + b * static_cast<double>(body.size()) / avgBody;
+        double score = 0.0;
+        for (size_t i = 0; i < parsed.terms.size(); i++) {
+            double tf = NoteSearchIndex::TITLE_BOOST * static_cast<double>(Count(title, parsed.terms[i])) / titleNorm +
+                        static_cast<double>(Count(body, parsed.terms[i])) / bodyNorm;
+            score += idf[i] * tf * (k1 + 1.0) / (tf + k1);
+        }
+        hits.push_back({ id, score });
+    }
+    std::sort(hits.begin(), hits.end(), [](const ModelHit& a, const ModelHit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.id < b.id;
+    });
+    return hits;
+}
+
+const wchar_t* const VOCABULARY[] = {
+    L"alpha", L"beta", L"gamma", L"delta", L"note", L"meeting", L"Project", L"plan",
+    L"draft", L"review", L"budget", L"2024", L"q3", L"TODO", L"call", L"email",
+    L"report", L"idea", L"list", L"shopping", L"milk", L"bread", L"\x43a\x43e\x442",
+    L"\x65e5\x672c", L"caf\xe9", L"x", L"the", L"a", L"of", L"and"
+};
+constexpr size_t VOCABULARY_SIZE = sizeof(VOCABULARY) / sizeof(VOCABULARY[0]);
+
+std::wstring RandomText(std::mt19937& random, size_t words) {
+    static const wchar_t* const SEPARATORS[] = { L" ", L"  ", L", ", L". ", L"\r\n", L" - ", L"\t" };
+    std::wstring text;
+    for (size_t i = 0; i < words; i++) {
+        if (i > 0) text += SEPARATORS[random() % 7];
+        text += VOCABULARY[random() % VOCABULARY_SIZE];
+    }
+    return text;
+}
+
+std::wstring RandomQuery(std::mt19937& random) {
+    auto word = [&random]() { return std::wstring(VOCABULARY[random() % VOCABULARY_SIZE]); };
+    switch (random() % 5) {
+        case 0: return word();
+        case 1: return word() + L" " + word();
+        case 2: return L"\"" + word() + L" " + word() + L"\"";
+        case 3: return word() + L" \"" + word() + L" " + word() + L"\" " + word();
+        default: return L"  " + word() + L"-" + word() + L" \"" + word();   // Unclosed quote
+    }
+}
+
+// The snippet lies in the content and holds its first match, which is a
+// query word
+bool SnippetIsSound(const NoteSearchHit& hit, const ModelNote& note, const std::wstring& query) {
+    const std::wstring& content = note.content;
+    if (hit.snippetStart > content.size() ||
+        hit.snippetLength > content.size() - hit.snippetStart) {
+        return false;
+    }
+    if (!hit.bodyMatch) {
+        return hit.snippetStart == 0 &&
+               hit.snippetLength == std::min(content.size(), NoteSearchIndex::SNIPPET_WINDOW);
+    }
+    if (hit.matchStart < hit.snippetStart ||
+        hit.matchStart + hit.matchLength > hit.snippetStart + hit.snippetLength) {
+        return false;
+    }
+    std::vector<std::wstring> matched = Words(content.substr(hit.matchStart, hit.matchLength));
+    ModelQuery parsed = ParseModelQuery(query);
+    return matched.size() == 1 &&
+           std::find(parsed.terms.begin(), parsed.terms.end(), matched[0]) != parsed.terms.end();
+}
+
+void CheckQuery(const NoteSearchIndex& index, const std::map<std::wstring, ModelNote>& notes,
+                const std::wstring& query) {
+    std::vector<ModelHit> expected = ModelSearch(notes, query);
+    std::vector<NoteSearchHit> hits = index.Search(query, notes.size() + 1);
+
+    bool same = hits.size() == expected.size();
+    for (size_t i = 0; same && i < hits.size(); i++) {
+        same = hits[i].id == expected[i].id &&
+               std::fabs(hits[i].score - expected[i].score) <= 1e-9 * std::max(1.0, expected[i].score);
+    }
+    if (!same) {
+        std::fprintf(stderr, "  query \"%ls\": %zu hits, model %zu\n", query.c_str(), hits.size(),
+                     expected.size());
+        g_failures++;
+        return;
+    }
+
+    for (const auto& hit : hits) {
+        const ModelNote& note = notes.at(hit.id);
+        CHECK(hit.tag == note.tag);
+        CHECK(SnippetIsSound(hit, note, query));
+    }
+
+    // A smaller limit keeps the best hits, in the same order
+    size_t limit = hits.size() / 2;
+    std::vector<NoteSearchHit> top = index.Search(query, limit);
+    bool prefix = top.size() == limit;
+    for (size_t i = 0; prefix && i < limit; i++) prefix = top[i].id == hits[i].id;
+    CHECK(prefix);
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(49);
+    NoteSearchIndex index;
+    std::map<std::wstring, ModelNote> notes;
+
+    for (int round = 0; round < 30; round++) {
+        for (int change = 0; change < 40; change++) {
+            std::wstring id = L"n" + std::to_wstring(random() % 150);
+            if (random() % 5 == 0) {
+                index.RemoveDocument(id);
+                notes.erase(id);
+            } else {
+                ModelNote note;
+                note.tag = random();
+                note.title = RandomText(random, random() % 5);
+                note.content = RandomText(random, random() % 60);
+                index.SetDocument(id, note.tag, note.title, note.content);
+                notes[id] = note;
+            }
+        }
+        CHECK(index.GetDocumentCount() == notes.size());
+        for (int q = 0; q < 25; q++) {
+            CheckQuery(index, notes, RandomQuery(random));
+        }
+    }
+
+    // Removing everything leaves no terms behind
+    for (const auto& [id, note] : notes) index.RemoveDocument(id);
+    CHECK(index.GetDocumentCount() == 0);
+    CHECK(index.GetTermCount() == 0);
+    CHECK(index.Search(L"alpha", 10).empty());
+}
+
+void TestRankingAndSnippets() {
+    NoteSearchIndex index;
+    index.SetDocument(L"title", 1, L"Budget review", L"Numbers for next year.");
+    index.SetDocument(L"body", 2, L"Misc", L"We should review the budget before the call.");
+    index.SetDocument(L"other", 3, L"Shopping", L"milk, bread");
+
+    std::vector<NoteSearchHit> hits = index.Search(L"budget review", 10);
+    CHECK(hits.size() == 2);
+    if (hits.size() == 2) {
+        // Title matches are boosted
+        CHECK(hits[0].id == L"title" && !hits[0].bodyMatch);
+        CHECK(hits[1].id == L"body" && hits[1].bodyMatch);
+        CHECK(hits[1].matchStart == 10 && hits[1].matchLength == 6);
+    }
+
+    // Phrases must be adjacent and in order
+    CHECK(index.Search(L"\"review the budget\"", 10).size() == 1);
+    CHECK(index.Search(L"\"budget the review\"", 10).empty());
+    CHECK(index.Search(L"\"Budget Review\"", 10).size() == 1);
+
+    // The snippet window with the most matches wins
+    std::wstring content = L"alpha " + std::wstring(200, L'.') + L" beta gamma beta " +
+                           std::wstring(200, L'.');
+    index.SetDocument(L"dense", 4, L"", content);
+    hits = index.Search(L"alpha beta gamma", 10);
+    CHECK(hits.size() == 1 && hits[0].bodyMatch && hits[0].matchStart == 207);
+    CHECK(hits.size() == 1 && hits[0].snippetStart == 207 - NoteSearchIndex::SNIPPET_BEFORE);
+
+    std::vector<std::wstring> words = NoteSearchIndex::GetQueryWords(L"  Foo \"bar-Baz\" ");
+    std::vector<std::wstring> expected = { L"Foo", L"bar", L"Baz" };
+    CHECK(words == expected);
+    CHECK(index.Search(L"", 10).empty());
+    CHECK(index.Search(L"\"\"", 10).empty());
+    CHECK(index.Search(L"budget", 0).empty());
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestRankingAndSnippets();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteSearchIndex tests passed\n");
+    return 0;
+}
@@ -0,0 +1,266 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSearchTest.cpp - Background note search: results, ranking, replacement
+//==============================================================================
+
+// Portable: runs wherever NoteSearch and TaskScheduler do.  Results are
+// compared with a scan of the sources; searches are replaced while they
+// run, and Stop() must not return while one is still reading notes.
+#include "NoteSearch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cwctype>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+std::mutex g_failuresMutex;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::lock_guard<std::mutex> failuresLock(g_failuresMutex);          \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+std::wstring Lower(std::wstring text) {
+    for (auto& ch : text) ch = static_cast<wchar_t>(std::towlower(ch));
+    return text;
+}
+
+// Notes with the content the loader hands out
+struct Corpus {
+    std::vector<NoteSearchSource> sources;
+    std::map<std::wstring, std::wstring> contents;
+
+    NoteSearchSources Snapshot() const {
+        return std::make_shared<const std::vector<NoteSearchSource>>(sources);
+    }
+};
+
+Corpus MakeCorpus(std::mt19937& random, size_t count) {
+    static const wchar_t* const WORDS[] = { L"Alpha", L"beta", L"GAMMA", L"delta", L"milk",
+                                            L"Bread", L"plan", L"\x416\x443\x440" };
+    auto text = [&random](size_t words) {
+        std::wstring result;
+        for (size_t i = 0; i < words; i++) {
+            if (i > 0) result += L' ';
+            result += WORDS[random() % 8];
+        }
+        return result;
+    };
+
+    Corpus corpus;
+    for (size_t i = 0; i < count; i++) {
+        NoteSearchSource source;
+        source.id = L"note-" + std::to_wstring(i);
+        std::wstring content = text(random() % 40);
+        source.lowerTitle = Lower(text(random() % 3));
+        source.previewIsComplete = content.size() <= 40;
+        source.lowerPreview = Lower(content.substr(0, 40));
+        corpus.contents[source.id] = content;
+        corpus.sources.push_back(std::move(source));
+    }
+    return corpus;
+}
+
+std::vector<size_t> ModelMatches(const Corpus& corpus, const std::wstring& query) {
+    std::wstring lowerQuery = Lower(query);
+    std::vector<size_t> matches;
+    for (size_t i = 0; i < corpus.sources.size(); i++) {
+        const NoteSearchSource& source = corpus.sources[i];
+        if (source.lowerTitle.find(lowerQuery) != std::wstring::npos ||
+            Lower(corpus.contents.at(source.id)).find(lowerQuery) != std::wstring::npos) {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+NoteSearch::ContentLoader LoaderFor(const Corpus& corpus) {
+    return [&corpus](const std::wstring& id) -> NoteContentPtr {
+        auto it = corpus.contents.find(id);
+        if (it == corpus.contents.end()) return nullptr;
+        return std::make_shared<const std::wstring>(it->second);
+    };
+}
+
+// Everything search 'generation' found, once it has finished
+bool Collect(NoteSearch& search, TaskScheduler& scheduler, uint64_t generation,
+             std::vector<NoteSearchMatch>& all) {
+    all.clear();
+    scheduler.WaitIdle();
+    std::vector<NoteSearchMatch> matches;
+    bool finished = false;
+    if (!search.TakeResults(generation, matches, finished)) return false;
+    all = std::move(matches);
+    return finished;
+}
+
+std::vector<size_t> Indices(const std::vector<NoteSearchMatch>& matches) {
+    std::vector<size_t> indices;
+    for (const auto& match : matches) indices.push_back(match.index);
+    return indices;
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(48);
+    Corpus corpus = MakeCorpus(random, 3000);
+    TaskScheduler scheduler(4);
+    std::atomic<int> notifications{ 0 };
+    NoteSearch search(scheduler, LoaderFor(corpus), nullptr, [&notifications]() { notifications++; });
+
+    for (const wchar_t* query : { L"alpha", L"MILK BREAD", L"a", L"\x436\x443", L"", L"nothing",
+                                  L"ta gam" }) {
+        notifications = 0;
+        uint64_t generation = search.Start(corpus.Snapshot(), query);
+        std::vector<NoteSearchMatch> matches;
+        CHECK(Collect(search, scheduler, generation, matches));
+        CHECK(Indices(matches) == ModelMatches(corpus, query));
+        CHECK(notifications.load() >= 1);
+    }
+
+    // No sources at all still finishes
+    uint64_t generation = search.Start(nullptr, L"alpha");
+    std::vector<NoteSearchMatch> matches;
+    CHECK(Collect(search, scheduler, generation, matches) && matches.empty());
+}
+
+// Ranked hits come first, in their order, each note once; the scan adds the
+// rest in source order
+void TestRankedFirst() {
+    std::mt19937 random(480);
+    Corpus corpus = MakeCorpus(random, 500);
+    TaskScheduler scheduler(2);
+    bool ready = true;
+    auto ranked = [&ready](const std::wstring&, size_t limit, std::vector<NoteRankedHit>& hits) {
+        CHECK(limit == NoteSearch::RANKED_LIMIT);
+        if (!ready) return false;
+        hits.push_back({ L"note-42", 3.0, L"forty-two" });
+        hits.push_back({ L"missing", 2.5, L"not a source" });
+        hits.push_back({ L"note-7", 2.0, L"seven" });
+        hits.push_back({ L"note-42", 1.0, L"again" });
+        return true;
+    };
+    NoteSearch search(scheduler, LoaderFor(corpus), ranked, nullptr);
+
+    uint64_t generation = search.Start(corpus.Snapshot(), L"beta");
+    std::vector<NoteSearchMatch> matches;
+    CHECK(Collect(search, scheduler, generation, matches));
+    CHECK(matches.size() >= 2);
+    if (matches.size() >= 2) {
+        CHECK(matches[0].index == 42 && matches[0].snippet == L"forty-two");
+        CHECK(matches[1].index == 7 && matches[1].snippet == L"seven");
+    }
+    std::vector<size_t> rest;
+    for (size_t i : ModelMatches(corpus, L"beta")) {
+        if (i != 42 && i != 7) rest.push_back(i);
+    }
+    std::vector<size_t> indices = Indices(matches);
+    CHECK(indices.size() >= 2 && std::vector<size_t>(indices.begin() + 2, indices.end()) == rest);
+
+    // Index not ready: a plain scan
+    ready = false;
+    generation = search.Start(corpus.Snapshot(), L"beta");
+    CHECK(Collect(search, scheduler, generation, matches));
+    CHECK(Indices(matches) == ModelMatches(corpus, L"beta"));
+}
+
+// A search typed one key at a time: only the last one's results are taken
+void TestReplacement() {
+    std::mt19937 random(4800);
+    Corpus corpus = MakeCorpus(random, 2000);
+    TaskScheduler scheduler(4);
+    std::atomic<int> loads{ 0 };
+    auto loader = [&corpus, &loads](const std::wstring& id) -> NoteContentPtr {
+        loads++;
+        std::this_thread::yield();
+        return std::make_shared<const std::wstring>(corpus.contents.at(id));
+    };
+    NoteSearch search(scheduler, loader, nullptr, nullptr);
+
+    NoteSearchSources sources = corpus.Snapshot();
+    std::wstring query;
+    std::vector<uint64_t> generations;
+    for (const wchar_t* key : { L"m", L"i", L"l", L"k", L" ", L"b" }) {
+        query += key;
+        generations.push_back(search.Start(sources, query));
+    }
+    std::vector<NoteSearchMatch> matches;
+    CHECK(Collect(search, scheduler, generations.back(), matches));
+    CHECK(Indices(matches) == ModelMatches(corpus, query));
+    for (size_t i = 0; i + 1 < generations.size(); i++) {
+        bool finished = true;
+        CHECK(!search.TakeResults(generations[i], matches, finished) && matches.empty() && !finished);
+    }
+
+    // Cancel drops the running search and its results
+    uint64_t generation = search.Start(sources, L"plan");
+    search.Cancel();
+    scheduler.WaitIdle();
+    bool finished = true;
+    CHECK(!search.TakeResults(generation, matches, finished) && matches.empty());
+}
+
+// Stop() waits for a search that is reading notes, and none reads after it
+void TestStopWaits() {
+    std::mt19937 random(48000);
+    Corpus corpus = MakeCorpus(random, 200);
+    for (auto& source : corpus.sources) source.previewIsComplete = false;
+    TaskScheduler scheduler(2);
+    std::atomic<bool> reading{ false };
+    std::atomic<bool> stopped{ false };
+    auto loader = [&](const std::wstring& id) -> NoteContentPtr {
+        reading = true;
+        CHECK(!stopped.load());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return std::make_shared<const std::wstring>(corpus.contents.at(id));
+    };
+
+    {
+        NoteSearch search(scheduler, loader, nullptr, nullptr);
+        search.Start(corpus.Snapshot(), L"no such words");
+        while (!reading.load()) std::this_thread::yield();
+        search.Stop();
+        stopped = true;
+    }
+    scheduler.WaitIdle();
+
+    // Once the scheduler has shut down, the search runs on the caller
+    scheduler.Shutdown();
+    stopped = false;
+    NoteSearch search(scheduler, LoaderFor(corpus), nullptr, nullptr);
+    uint64_t generation = search.Start(corpus.Snapshot(), L"delta");
+    std::vector<NoteSearchMatch> matches;
+    bool finished = false;
+    CHECK(search.TakeResults(generation, matches, finished) && finished);
+    CHECK(Indices(matches) == ModelMatches(corpus, L"delta"));
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestRankedFirst();
+    TestReplacement();
+    TestStopWaits();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteSearch tests passed\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteSortIndexTest.cpp - Update-time and title orders against a sort model
+//==============================================================================
+
+// Portable: runs wherever NoteSortIndex does.  Summaries are added,
+// retitled, touched and removed the way the note store does it (erase with
+// the old fields, insert with the new; removal moves the last summary into
+// the hole), and both orders are compared with sorting the summaries.
+#include "NoteSortIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+struct Summary {
+    time_t updatedAt = 0;
+    std::wstring title;
+    std::wstring id;
+};
+
+std::wstring RandomTitle(std::mt19937& random) {
+    static const wchar_t* const TITLES[] = { L"Groceries", L"groceries", L"TODO", L"todo list",
+                                             L"Meeting", L"", L"\x416urnal", L"\x436urnal", L"2024" };
+    return TITLES[random() % (sizeof(TITLES) / sizeof(TITLES[0]))];
+}
+
+template <typename Less>
+std::vector<size_t> ModelOrder(const std::vector<Summary>& summaries, Less less) {
+    std::vector<size_t> slots(summaries.size());
+    for (size_t i = 0; i < slots.size(); i++) slots[i] = i;
+    std::sort(slots.begin(), slots.end(), [&](size_t a, size_t b) {
+        return less(summaries[a], summaries[b]);
+    });
+    return slots;
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(46);
+    NoteSortIndex index;
+    std::vector<Summary> summaries;
+    int nextId = 0;
+
+    for (int round = 0; round < 3000; round++) {
+        unsigned action = random() % 4;
+        if (summaries.empty() || action == 0) {
+            Summary summary;
+            summary.updatedAt = static_cast<time_t>(random() % 50);
+            summary.title = RandomTitle(random);
+            summary.id = L"note-" + std::to_wstring(nextId++);
+            index.Insert(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.title), summary.id,
+                         summaries.size());
+            summaries.push_back(summary);
+        } else if (action == 1) {
+            size_t slot = random() % summaries.size();
+            Summary& summary = summaries[slot];
+            index.Erase(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.title), summary.id);
+            if (slot + 1 != summaries.size()) {
+                summary = summaries.back();
+                index.Move(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.title), summary.id, slot);
+            }
+            summaries.pop_back();
+        } else {
+            // Saved: touched, and sometimes retitled
+            Summary& summary = summaries[random() % summaries.size()];
+            size_t slot = static_cast<size_t>(&summary - summaries.data());
+            index.Erase(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.title), summary.id);
+            summary.updatedAt += static_cast<time_t>(random() % 10);
+            if (action == 3) summary.title = RandomTitle(random);
+            index.Insert(summary.updatedAt, NoteSortIndex::MakeTitleKey(summary.title), summary.id, slot);
+        }
+
+        if (round % 100 != 0) continue;
+
+        std::vector<size_t> slots;
+        index.ByUpdated(slots);
+        CHECK(slots == ModelOrder(summaries, [](const Summary& a, const Summary& b) {
+            if (a.updatedAt != b.updatedAt) return a.updatedAt < b.updatedAt;
+            return a.id < b.id;
+        }));
+
+        slots.clear();
+        index.ByTitle(slots);
+        CHECK(slots == ModelOrder(summaries, [](const Summary& a, const Summary& b) {
+            std::wstring keyA = NoteSortIndex::MakeTitleKey(a.title);
+            std::wstring keyB = NoteSortIndex::MakeTitleKey(b.title);
+            if (keyA != keyB) return keyA < keyB;
+            return a.id < b.id;
+        }));
+    }
+}
+
+void TestEdgeCases() {
+    CHECK(NoteSortIndex::MakeTitleKey(L"Hello World") == L"hello world");
+    CHECK(NoteSortIndex::MakeTitleKey(L"") == L"");
+
+    NoteSortIndex index;
+    index.Insert(5, L"b", L"1", 0);
+    index.Insert(5, L"a", L"2", 1);
+
+    // Orders are appended to what the caller already has
+    std::vector<size_t> slots = { 7 };
+    index.ByTitle(slots);
+    CHECK((slots == std::vector<size_t>{ 7, 1, 0 }));
+
+    // Erasing or moving a note that was never inserted changes nothing
+    index.Erase(5, L"b", L"3");
+    index.Move(5, L"a", L"3", 9);
+    slots.clear();
+    index.ByUpdated(slots);
+    CHECK((slots == std::vector<size_t>{ 0, 1 }));
+    slots.clear();
+    index.ByTitle(slots);
+    CHECK((slots == std::vector<size_t>{ 1, 0 }));
+
+    index.Clear();
+    slots.clear();
+    index.ByUpdated(slots);
+    index.ByTitle(slots);
+    CHECK(slots.empty());
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestEdgeCases();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteSortIndex tests passed\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteTimelineTest.cpp - Creation-date index compared against a scan model
+//==============================================================================
+
+// Portable: runs wherever NoteTimeline does.  A summary vector is kept the
+// way the note store keeps it (removal moves the last summary into the
+// hole), and ranges and days are checked against a scan of that vector.
+#include "NoteTimeline.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+constexpr time_t DAY = 86400;
+
+struct Summary {
+    time_t createdAt = 0;
+    std::wstring id;
+};
+
+time_t DayOf(time_t createdAt) {
+    return createdAt - createdAt % DAY;
+}
+
+std::vector<size_t> ModelRange(const std::vector<Summary>& summaries, time_t from, time_t to) {
+    std::vector<size_t> slots;
+    for (size_t i = 0; i < summaries.size(); i++) {
+        if (summaries[i].createdAt >= from && summaries[i].createdAt < to) slots.push_back(i);
+    }
+    std::sort(slots.begin(), slots.end(), [&summaries](size_t a, size_t b) {
+        if (summaries[a].createdAt != summaries[b].createdAt) {
+            return summaries[a].createdAt < summaries[b].createdAt;
+        }
+        return summaries[a].id < summaries[b].id;
+    });
+    return slots;
+}
+
+void TestAgainstModel() {
+    std::mt19937 random(45);
+    NoteTimeline timeline;
+    std::vector<Summary> summaries;
+    int nextId = 0;
+
+    for (int round = 0; round < 2000; round++) {
+        if (summaries.empty() || random() % 3 != 0) {
+            // Several notes share a second, and many share a day
+            Summary summary;
+            summary.createdAt = static_cast<time_t>(random() % (30 * DAY)) / 600 * 600;
+            summary.id = L"note-" + std::to_wstring(nextId++);
+            timeline.Insert(summary.createdAt, DayOf(summary.createdAt), summary.id, summaries.size());
+            summaries.push_back(summary);
+        } else {
+            size_t slot = random() % summaries.size();
+            timeline.Erase(summaries[slot].createdAt, summaries[slot].id);
+            if (slot + 1 != summaries.size()) {
+                summaries[slot] = summaries.back();
+                timeline.Move(summaries[slot].createdAt, summaries[slot].id, slot);
+            }
+            summaries.pop_back();
+        }
+        CHECK(timeline.GetCount() == summaries.size());
+
+        if (round % 50 != 0) continue;
+
+        for (size_t i = 0; i < summaries.size(); i++) {
+            size_t slot = SIZE_MAX;
+            CHECK(timeline.Find(summaries[i].createdAt, summaries[i].id, slot) && slot == i);
+        }
+
+        for (int query = 0; query < 20; query++) {
+            time_t from = static_cast<time_t>(random() % (32 * DAY)) - DAY;
+            time_t to = from + static_cast<time_t>(random() % (5 * DAY));
+            if (query == 0) to = from;
+            std::vector<size_t> slots;
+            timeline.Range(from, to, slots);
+            CHECK(slots == ModelRange(summaries, from, to));
+        }
+
+        std::set<time_t> days;
+        for (const auto& summary : summaries) days.insert(DayOf(summary.createdAt));
+        CHECK(timeline.GetDays() == std::vector<time_t>(days.rbegin(), days.rend()));
+    }
+}
+
+void TestEdgeCases() {
+    NoteTimeline timeline;
+    timeline.Insert(100, 0, L"b", 0);
+    timeline.Insert(100, 0, L"a", 1);
+    timeline.Insert(DAY, DAY, L"c", 2);
+
+    // Notes created in the same second come out by id; the end is open
+    std::vector<size_t> slots;
+    timeline.Range(100, DAY, slots);
+    CHECK((slots == std::vector<size_t>{ 1, 0 }));
+    slots.clear();
+    timeline.Range(DAY, 100, slots);
+    CHECK(slots.empty());
+
+    // Inserting an indexed note again moves it to its new day
+    timeline.Insert(100, DAY, L"a", 3);
+    CHECK(timeline.GetCount() == 3);
+    CHECK((timeline.GetDays() == std::vector<time_t>{ DAY, 0 }));
+    timeline.Insert(100, DAY, L"b", 0);
+    CHECK((timeline.GetDays() == std::vector<time_t>{ DAY }));
+
+    size_t slot = 0;
+    CHECK(!timeline.Find(101, L"a", slot));
+    timeline.Erase(101, L"a");
+    timeline.Move(101, L"a", 9);
+    CHECK(timeline.GetCount() == 3);
+
+    timeline.Clear();
+    CHECK(timeline.GetCount() == 0 && timeline.GetDays().empty());
+}
+
+} // anonymous namespace
+
+int main() {
+    TestAgainstModel();
+    TestEdgeCases();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteTimeline tests passed\n");
+    return 0;
+}
@@ -0,0 +1,340 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// NoteWriteQueueTest.cpp - Concurrency tests for the note write queue
+//==============================================================================
+
+// Portable: runs wherever NoteWriteQueue does.  The "disk" is a map the
+// content writer updates; producers on several threads write and delete
+// notes against it while writes fail at random.  Meant to be run under
+// ThreadSanitizer as well.
+#include "NoteWriteQueue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+std::mutex g_failuresMutex;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::lock_guard<std::mutex> failuresLock(g_failuresMutex);          \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// Note contents as the content writer left them
+class FakeDisk {
+public:
+    bool Write(const std::wstring& id, const NoteContentPtr& content, uint64_t& bytes) {
+        if (m_failEvery > 0 && m_calls.fetch_add(1) % m_failEvery == 0) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (content) {
+            m_notes[id] = *content;
+            bytes = content->size() * sizeof(wchar_t);
+        } else {
+            m_notes.erase(id);
+        }
+        m_writes[id]++;
+        return true;
+    }
+
+    bool Read(const std::wstring& id, std::wstring& content) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_notes.find(id);
+        if (it == m_notes.end()) return false;
+        content = it->second;
+        return true;
+    }
+
+    [[nodiscard]] std::map<std::wstring, std::wstring> Snapshot() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_notes;
+    }
+
+    [[nodiscard]] int Writes(const std::wstring& id) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_writes.find(id);
+        return it == m_writes.end() ? 0 : it->second;
+    }
+
+    // Fail one call in 'every'; 0 turns failures off
+    void FailEvery(uint32_t every) { m_failEvery = every; }
+
+private:
+    mutable std::mutex m_mutex;
+    std::map<std::wstring, std::wstring> m_notes;
+    std::map<std::wstring, int> m_writes;
+    std::atomic<uint32_t> m_failEvery{ 0 };
+    std::atomic<uint32_t> m_calls{ 0 };
+};
+
+NoteWriteQueue::ContentWriter WriterFor(FakeDisk& disk) {
+    return [&disk](const std::wstring& id, const NoteContentPtr& content, uint64_t& bytes) {
+        return disk.Write(id, content, bytes);
+    };
+}
+
+NoteContentPtr Content(const std::wstring& text) {
+    return std::make_shared<const std::wstring>(text);
+}
+
+// "<sequence>:<producer>" so a reader can tell which write it sees
+std::wstring Revision(int producer, int sequence) {
+    return std::to_wstring(sequence) + L":" + std::to_wstring(producer);
+}
+
+int SequenceOf(const std::wstring& revision) {
+    return std::stoi(revision.substr(0, revision.find(L':')));
+}
+
+// One queued request, as the producer saw it
+struct LoggedRequest {
+    std::wstring id;
+    uint64_t generation = 0;
+    bool isDelete = false;
+    std::wstring content;
+};
+
+// Producers with private and shared notes, random deletes, failing writes,
+// index snapshots and a concurrent stats reader.  Afterwards the disk holds
+// exactly the latest request per note.
+void TestConcurrentProducers() {
+    constexpr int PRODUCERS = 4;
+    constexpr int REQUESTS = 3000;
+    constexpr int OWN_NOTES = 8;
+    constexpr int SHARED_NOTES = 6;
+
+    FakeDisk disk;
+    disk.FailEvery(11);
+    NoteWriteQueue queue(WriterFor(disk));
+    queue.SetCoalesceDelay(std::chrono::milliseconds(1));
+    queue.Start();
+
+    std::atomic<bool> producing{ true };
+    std::atomic<int> indexWrites{ 0 };
+    std::thread statsReader([&]() {
+        uint64_t lastFlushed = 0;
+        while (producing.load()) {
+            NoteWriteQueueStats stats = queue.GetStats();
+            CHECK(stats.flushedGeneration <= stats.queuedGeneration);
+            CHECK(stats.flushedGeneration >= lastFlushed);
+            lastFlushed = stats.flushedGeneration;
+            std::this_thread::yield();
+        }
+    });
+
+    std::vector<std::vector<LoggedRequest>> logs(PRODUCERS);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p]() {
+            std::mt19937 random(static_cast<uint32_t>(p) * 7919u + 1u);
+            std::vector<int> ownSequence(OWN_NOTES, 0);
+            auto ownId = [p](int note) {
+                return L"own-" + std::to_wstring(p) + L"-" + std::to_wstring(note);
+            };
+
+            for (int i = 1; i <= REQUESTS; i++) {
+                LoggedRequest request;
+                int choice = static_cast<int>(random() % 100);
+                if (choice < 60) {
+                    int note = static_cast<int>(random() % OWN_NOTES);
+                    ownSequence[note] = i;
+                    request.id = ownId(note);
+                    request.content = Revision(p, i);
+                    request.generation = queue.WriteContent(request.id, Content(request.content),
+                                                            request.content.size());
+
+                    // Not written yet means still queued, and never older
+                    NoteContentPtr pending;
+                    std::wstring onDisk;
+                    if (queue.FindPending(request.id, pending)) {
+                        CHECK(pending && SequenceOf(*pending) >= i);
+                    } else {
+                        CHECK(disk.Read(request.id, onDisk) && SequenceOf(onDisk) >= i);
+                    }
+                } else if (choice < 85) {
+                    request.id = L"shared-" + std::to_wstring(random() % SHARED_NOTES);
+                    request.content = Revision(p, i);
+                    request.generation = queue.WriteContent(request.id, Content(request.content),
+                                                            request.content.size());
+                } else if (choice < 95) {
+                    request.id = L"shared-" + std::to_wstring(random() % SHARED_NOTES);
+                    request.isDelete = true;
+                    request.generation = queue.DeleteContent(request.id);
+                } else {
+                    // The index must never be written before the contents
+                    // queued ahead of it
+                    std::vector<std::pair<std::wstring, int>> expected;
+                    for (int note = 0; note < OWN_NOTES; note++) {
+                        if (ownSequence[note] != 0) {
+                            expected.emplace_back(ownId(note), ownSequence[note]);
+                        }
+                    }
+                    queue.WriteIndex([&disk, &indexWrites, expected](uint64_t& bytes) {
+                        for (const auto& [id, sequence] : expected) {
+                            std::wstring onDisk;
+                            CHECK(disk.Read(id, onDisk) && SequenceOf(onDisk) >= sequence);
+                        }
+                        bytes = expected.size();
+                        indexWrites++;
+                        return true;
+                    });
+                    continue;
+                }
+                logs[p].push_back(std::move(request));
+
+                if (i % 500 == 0) {
+                    uint64_t generation = logs[p].back().generation;
+                    if (queue.Flush()) {
+                        CHECK(queue.GetFlushedGeneration() >= generation);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    producing = false;
+    statsReader.join();
+
+    // Stop the failures and drain whatever is still queued
+    disk.FailEvery(0);
+    CHECK(queue.Flush());
+    queue.Stop();
+    CHECK(!queue.IsRunning());
+
+    std::map<std::wstring, const LoggedRequest*> latest;
+    uint64_t lastGeneration = 0;
+    for (const auto& log : logs) {
+        for (const auto& request : log) {
+            const LoggedRequest*& slot = latest[request.id];
+            if (!slot || request.generation > slot->generation) slot = &request;
+            lastGeneration = std::max(lastGeneration, request.generation);
+        }
+    }
+    std::map<std::wstring, std::wstring> expected;
+    for (const auto& [id, request] : latest) {
+        if (!request->isDelete) expected[id] = request->content;
+    }
+    CHECK(disk.Snapshot() == expected);
+
+    NoteWriteQueueStats stats = queue.GetStats();
+    CHECK(stats.flushedGeneration == stats.queuedGeneration);
+    CHECK(stats.queuedGeneration >= lastGeneration);
+    CHECK(stats.failed > 0);
+    CHECK(stats.written > 0);
+    CHECK(indexWrites.load() > 0);
+}
+
+// A burst of updates to one note within the coalescing delay costs one write
+void TestCoalescing() {
+    FakeDisk disk;
+    NoteWriteQueue queue(WriterFor(disk));
+    queue.SetCoalesceDelay(std::chrono::milliseconds(500));
+    queue.Start();
+
+    uint64_t generation = 0;
+    for (int i = 1; i <= 100; i++) {
+        generation = queue.WriteContent(L"note", Content(Revision(0, i)), 1);
+    }
+    queue.RecordUnchanged();
+    CHECK(queue.Flush());
+    CHECK(queue.GetFlushedGeneration() >= generation);
+
+    std::wstring onDisk;
+    CHECK(disk.Read(L"note", onDisk) && onDisk == Revision(0, 100));
+    CHECK(disk.Writes(L"note") < 10);
+
+    NoteWriteQueueStats stats = queue.GetStats();
+    CHECK(stats.queued == 100);
+    CHECK(stats.unchanged == 1);
+    CHECK(stats.bytesChanged == 100);
+    CHECK(stats.coalesced + stats.written == 100);
+    queue.Stop();
+}
+
+// Without a writer thread requests are written on the calling thread;
+// failures stay queued until a Flush() succeeds, and the index waits for
+// the contents
+void TestWithoutWriterThread() {
+    FakeDisk disk;
+    disk.FailEvery(1);
+    NoteWriteQueue queue(WriterFor(disk));
+
+    uint64_t written = queue.WriteContent(L"a", Content(L"first"), 5);
+    bool indexRan = false;
+    uint64_t index = queue.WriteIndex([&indexRan](uint64_t&) {
+        indexRan = true;
+        return true;
+    });
+    CHECK(index > written);
+    CHECK(!indexRan);
+    CHECK(queue.GetFlushedGeneration() < written);
+
+    NoteContentPtr pending;
+    CHECK(queue.FindPending(L"a", pending) && pending && *pending == L"first");
+    CHECK(!queue.Flush());
+
+    disk.FailEvery(0);
+    CHECK(queue.Flush());
+    CHECK(indexRan);
+    CHECK(queue.GetFlushedGeneration() == index);
+    CHECK(!queue.FindPending(L"a", pending));
+
+    queue.DeleteContent(L"a");
+    std::wstring onDisk;
+    CHECK(!disk.Read(L"a", onDisk));
+    CHECK(queue.GetStats().failed >= 2);
+}
+
+// Stop() drains what is queued; a later Start() picks up again
+void TestStopDrains() {
+    FakeDisk disk;
+    NoteWriteQueue queue(WriterFor(disk));
+    queue.SetCoalesceDelay(std::chrono::milliseconds(10000));
+    for (int round = 0; round < 3; round++) {
+        queue.Start();
+        CHECK(queue.IsRunning());
+        for (int i = 0; i < 50; i++) {
+            queue.WriteContent(L"n" + std::to_wstring(i), Content(Revision(round, i)), 1);
+        }
+        queue.Stop();
+        CHECK(!queue.IsRunning());
+
+        std::map<std::wstring, std::wstring> notes = disk.Snapshot();
+        CHECK(notes.size() == 50);
+        CHECK(notes[L"n49"] == Revision(round, 49));
+        CHECK(queue.GetFlushedGeneration() == queue.GetStats().queuedGeneration);
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    TestConcurrentProducers();
+    TestCoalescing();
+    TestWithoutWriterThread();
+    TestStopDrains();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("NoteWriteQueue tests passed\n");
+    return 0;
+}
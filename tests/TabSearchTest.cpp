@@ -0,0 +1,214 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TabSearchTest.cpp - Open-document search on the task scheduler
+//==============================================================================
+
+// Portable: runs wherever TabSearch and TaskScheduler do.  Matching itself
+// is TextSearch's; these check that every document is searched once, in
+// any order, that the end is reported once, and that Cancel() leaves no
+// document being read.
+#include "TabSearch.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+std::mutex g_failuresMutex;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::lock_guard<std::mutex> failuresLock(g_failuresMutex);          \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// Counts notifications and lets the test wait for the end of a search
+struct Notifier {
+    std::mutex mutex;
+    std::condition_variable changed;
+    int count = 0;
+
+    TabSearch::NotifyCallback Callback() {
+        return [this]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+            changed.notify_all();
+        };
+    }
+};
+
+// Drain results until the search reports its end
+std::vector<TabSearchResult> RunToEnd(TabSearch& search, Notifier& notifier) {
+    std::vector<TabSearchResult> all;
+    while (true) {
+        bool finished = search.IsFinished();
+        for (auto& result : search.TakeResults()) all.push_back(std::move(result));
+        if (finished) return all;
+
+        std::unique_lock<std::mutex> lock(notifier.mutex);
+        notifier.changed.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+std::wstring RandomText(std::mt19937& random) {
+    static const wchar_t* const WORDS[] = { L"alpha", L"Beta", L"needle", L"NEEDLE", L"gamma" };
+    std::wstring text;
+    for (size_t i = random() % 3000; i > 0; i--) {
+        text += WORDS[random() % 5];
+        text += (random() % 8 == 0) ? L"\r\n" : L" ";
+    }
+    return text;
+}
+
+void TestEveryDocumentOnce() {
+    std::mt19937 random(39);
+    TaskScheduler scheduler(4);
+    TextSearchOptions options;
+    TextMatcher matcher;
+    CHECK(matcher.Compile(L"needle", options));
+
+    std::vector<TabSearchSource> sources;
+    std::vector<size_t> expected;
+    std::atomic<int> loads{ 0 };
+    size_t unreadable = 0;
+    for (int i = 0; i < 300; i++) {
+        auto text = std::make_shared<const std::wstring>(RandomText(random));
+        std::vector<TextLineHit> hits;
+        expected.push_back(CollectLineHits(matcher, *text, TabSearch::MAX_HITS_PER_DOCUMENT, true, hits));
+
+        TabSearchSource source;
+        source.tabId = 1000 + i;
+        source.title = L"Tab " + std::to_wstring(i);
+        switch (i % 3) {
+            case 0:
+                source.text = text;
+                break;
+            case 1:
+                source.load = [text, &loads](std::wstring& loaded) {
+                    loads++;
+                    loaded = *text;
+                    return true;
+                };
+                break;
+            default:
+                if (i % 2 == 0) {
+                    source.load = [](std::wstring&) { return false; };
+                    expected.back() = 0;
+                    unreadable++;
+                } else {
+                    source.text = text;
+                }
+                break;
+        }
+        sources.push_back(std::move(source));
+    }
+
+    Notifier notifier;
+    TabSearch search(scheduler);
+    std::wstring error;
+    CHECK(search.Start(std::move(sources), L"needle", options, notifier.Callback(), error));
+    std::vector<TabSearchResult> results = RunToEnd(search, notifier);
+
+    std::vector<int> seen(expected.size(), 0);
+    bool right = true;
+    for (const auto& result : results) {
+        right = right && result.order < expected.size() &&
+                result.tabId == static_cast<int>(1000 + result.order) &&
+                result.title == L"Tab " + std::to_wstring(result.order) &&
+                result.matchCount == expected[result.order] &&
+                result.hits.size() == std::min(result.matchCount, TabSearch::MAX_HITS_PER_DOCUMENT);
+        if (result.order < seen.size()) seen[result.order]++;
+    }
+    CHECK(right);
+    for (size_t i = 0; i < expected.size(); i++) {
+        CHECK(seen[i] == (expected[i] > 0 ? 1 : 0));
+    }
+    CHECK(loads.load() == 100);
+
+    TabSearchStats stats = search.GetStats();
+    CHECK(stats.documentsSearched + stats.documentsSkipped == expected.size());
+    CHECK(stats.documentsSkipped == unreadable);
+    CHECK(stats.documentsMatched == results.size());
+    CHECK(!search.WasCancelled());
+    CHECK(!search.Start({}, L"needle", options, nullptr, error));
+}
+
+// Cancel() returns only when no document is being read, and none is read
+// after it
+void TestCancel() {
+    TaskScheduler scheduler(3);
+    std::atomic<bool> cancelled{ false };
+    std::atomic<int> started{ 0 };
+    std::vector<TabSearchSource> sources(200);
+    for (auto& source : sources) {
+        source.load = [&cancelled, &started](std::wstring& text) {
+            CHECK(!cancelled.load());
+            started++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            text = L"needle";
+            return true;
+        };
+    }
+
+    TabSearch search(scheduler);
+    std::wstring error;
+    CHECK(search.Start(std::move(sources), L"needle", TextSearchOptions(), nullptr, error));
+    while (started.load() == 0) std::this_thread::yield();
+    search.Cancel();
+    cancelled = true;
+    CHECK(search.IsFinished() && search.WasCancelled());
+    scheduler.WaitIdle();
+    CHECK(started.load() < 200);
+}
+
+void TestEdgeCases() {
+    TaskScheduler scheduler(2);
+    std::wstring error;
+    TabSearch empty(scheduler);
+    CHECK(!empty.Start({}, L"", TextSearchOptions(), nullptr, error) && !error.empty());
+
+    TextSearchOptions regex;
+    regex.useRegex = true;
+    TabSearch invalid(scheduler);
+    CHECK(!invalid.Start({}, L"(", regex, nullptr, error));
+
+    // No documents: finished at once
+    TabSearch none(scheduler);
+    CHECK(none.Start({}, L"x", TextSearchOptions(), nullptr, error));
+    CHECK(none.IsFinished() && none.TakeResults().empty());
+
+    // With the scheduler shut down nothing can be searched
+    scheduler.Shutdown();
+    std::vector<TabSearchSource> sources(3);
+    TabSearch stopped(scheduler);
+    CHECK(!stopped.Start(std::move(sources), L"x", TextSearchOptions(), nullptr, error));
+    CHECK(stopped.IsFinished());
+}
+
+} // anonymous namespace
+
+int main() {
+    TestEveryDocumentOnce();
+    TestCancel();
+    TestEdgeCases();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("TabSearch tests passed\n");
+    return 0;
+}
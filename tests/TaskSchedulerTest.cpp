@@ -0,0 +1,356 @@
+//==============================================================================
+// QNote - A Lightweight Notepad Clone
+// TaskSchedulerTest.cpp - Stress tests for the work-stealing task scheduler
+//==============================================================================
+
+// Portable: runs wherever TaskScheduler does.  Meant to be run under
+// ThreadSanitizer as well (-fsanitize=thread) to catch races the checks
+// below cannot see.
+#include "TaskScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace QNote;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__,         \
+                         __LINE__, #condition);                                 \
+            g_failures++;                                                       \
+        }                                                                       \
+    } while (0)
+
+// Several outside threads submit at once; every task runs exactly once
+void TestConcurrentSubmit() {
+    constexpr int PRODUCERS = 8;
+    constexpr int TASKS_PER_PRODUCER = 20000;
+
+    TaskScheduler scheduler(4);
+    std::vector<std::atomic<int>> runs(PRODUCERS * TASKS_PER_PRODUCER);
+    for (auto& run : runs) run = 0;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < TASKS_PER_PRODUCER; i++) {
+                auto priority = static_cast<TaskPriority>(i % 3);
+                size_t slot = static_cast<size_t>(p) * TASKS_PER_PRODUCER + i;
+                CHECK(scheduler.Submit([&runs, slot]() { runs[slot]++; }, priority));
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    scheduler.WaitIdle();
+
+    int wrong = 0;
+    for (auto& run : runs) {
+        if (run.load() != 1) wrong++;
+    }
+    CHECK(wrong == 0);
+}
+
+// Tasks that fan out from workers land on local queues and get stolen
+void TestNestedFanOut() {
+    constexpr int ROOTS = 64;
+    constexpr int DEPTH = 4;
+    constexpr int FAN = 4;
+
+    TaskScheduler scheduler(4);
+    std::atomic<int> leaves{ 0 };
+    std::atomic<int> onWorker{ 0 };
+    std::mutex threadsMutex;
+    std::vector<std::thread::id> threads;
+
+    std::function<void(int)> spawn = [&](int depth) {
+        if (scheduler.IsWorkerThread()) onWorker++;
+        {
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            auto id = std::this_thread::get_id();
+            bool seen = false;
+            for (auto& known : threads) seen = seen || known == id;
+            if (!seen) threads.push_back(id);
+        }
+        if (depth == DEPTH) {
+            // Enough work per leaf that idle workers go looking for more
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            leaves++;
+            return;
+        }
+        for (int i = 0; i < FAN; i++) {
+            scheduler.Submit([&spawn, depth]() { spawn(depth + 1); });
+        }
+    };
+    for (int i = 0; i < ROOTS; i++) {
+        scheduler.Submit([&spawn]() { spawn(0); });
+    }
+    scheduler.WaitIdle();
+
+    int expectedLeaves = ROOTS;
+    int expectedTasks = ROOTS;
+    for (int d = 0; d < DEPTH; d++) {
+        expectedLeaves *= FAN;
+        expectedTasks += expectedLeaves;
+    }
+    CHECK(leaves.load() == expectedLeaves);
+    CHECK(onWorker.load() == expectedTasks);
+    CHECK(threads.size() > 1);
+    CHECK(threads.size() <= scheduler.GetWorkerCount());
+}
+
+// Cancelled tasks are dropped, and WaitIdle() still returns
+void TestCancellation() {
+    TaskScheduler scheduler(2);
+    std::atomic<bool> release{ false };
+    std::atomic<int> ran{ 0 };
+
+    // Keep both workers busy so the rest stays queued
+    for (int i = 0; i < 2; i++) {
+        scheduler.Submit([&release]() {
+            while (!release.load()) std::this_thread::yield();
+        }, TaskPriority::High);
+    }
+
+    CancellationToken token = CancellationToken::Create();
+    for (int i = 0; i < 1000; i++) {
+        scheduler.Submit([&ran]() { ran++; }, TaskPriority::Low, token);
+    }
+    std::atomic<int> kept{ 0 };
+    for (int i = 0; i < 100; i++) {
+        scheduler.Submit([&kept]() { kept++; }, TaskPriority::Low);
+    }
+    token.Cancel();
+    release = true;
+    scheduler.WaitIdle();
+
+    CHECK(ran.load() == 0);
+    CHECK(kept.load() == 100);
+    CHECK(token.IsCancelled());
+    CHECK(CancellationToken().Flag() == nullptr);
+    CHECK(!CancellationToken().IsCancelled());
+}
+
+// Higher priority work queued behind lower priority work runs first
+void TestPriorityOrder() {
+    TaskScheduler scheduler(2);
+    std::atomic<bool> release{ false };
+    std::atomic<int> blocked{ 0 };
+    for (int i = 0; i < 2; i++) {
+        scheduler.Submit([&]() {
+            blocked++;
+            while (!release.load()) std::this_thread::yield();
+        }, TaskPriority::High);
+    }
+    while (blocked.load() < 2) std::this_thread::yield();
+
+    std::mutex orderMutex;
+    std::vector<TaskPriority> order;
+    const TaskPriority submitted[] = { TaskPriority::Low, TaskPriority::Normal,
+                                       TaskPriority::High };
+    for (int round = 0; round < 10; round++) {
+        for (TaskPriority priority : submitted) {
+            scheduler.Submit([&, priority]() {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(priority);
+            }, priority);
+        }
+    }
+    release = true;
+    scheduler.WaitIdle();
+
+    // Two workers can finish a High and a Normal task out of order, but
+    // no Low task is taken while a Normal one is still queued
+    CHECK(order.size() == 30);
+    size_t firstLow = order.size();
+    size_t lastHigh = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (order[i] == TaskPriority::Low && firstLow == order.size()) firstLow = i;
+        if (order[i] == TaskPriority::High) lastHigh = i;
+    }
+    CHECK(firstLow > lastHigh);
+}
+
+// Continuations posted from workers run on the draining thread, and the
+// wake callback fires once per drain
+void TestUiContinuations() {
+    TaskScheduler scheduler(4);
+    std::atomic<int> wakes{ 0 };
+    scheduler.SetUiWakeCallback([&wakes]() { wakes++; });
+
+    const auto uiThread = std::this_thread::get_id();
+    int onUi = 0;
+    int total = 0;
+    for (int i = 0; i < 5000; i++) {
+        scheduler.Submit([&]() {
+            scheduler.PostToUi([&]() {
+                if (std::this_thread::get_id() == uiThread) onUi++;
+                total++;
+            });
+        });
+    }
+    scheduler.WaitIdle();
+    CHECK(wakes.load() == 1);
+    CHECK(scheduler.RunUiContinuations() == 5000);
+    CHECK(onUi == 5000);
+    CHECK(total == 5000);
+
+    CancellationToken token = CancellationToken::Create();
+    scheduler.PostToUi([&total]() { total++; }, token);
+    CHECK(wakes.load() == 2);
+    token.Cancel();
+    scheduler.RunUiContinuations();
+    CHECK(total == 5000);
+}
+
+// Shutdown while producers are still submitting: nothing runs after it
+// returns, WaitIdle() does not hang, and later submits are refused
+void TestShutdownUnderLoad() {
+    for (int attempt = 0; attempt < 20; attempt++) {
+        TaskScheduler scheduler(4);
+        std::atomic<bool> stop{ false };
+        std::atomic<int> ran{ 0 };
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; p++) {
+            producers.emplace_back([&]() {
+                while (!stop.load()) {
+                    if (!scheduler.Submit([&ran]() { ran++; })) break;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        scheduler.Shutdown();
+        int afterShutdown = ran.load();
+        stop = true;
+        for (auto& producer : producers) producer.join();
+
+        scheduler.WaitIdle();
+        CHECK(ran.load() == afterShutdown);
+        CHECK(!scheduler.Submit([&ran]() { ran++; }));
+        CHECK(ran.load() == afterShutdown);
+    }
+}
+
+// A scheduler that never gets work starts no threads, and destroying one
+// with queued work drops it
+void TestLazyStartAndDestroy() {
+    {
+        TaskScheduler idle(4);
+        CHECK(idle.GetWorkerCount() == 4);
+        CHECK(!idle.IsWorkerThread());
+    }
+
+    std::atomic<int> ran{ 0 };
+    std::atomic<bool> release{ false };
+    {
+        TaskScheduler scheduler(1);
+        scheduler.Submit([&release]() {
+            while (!release.load()) std::this_thread::yield();
+        });
+        for (int i = 0; i < 100; i++) {
+            scheduler.Submit([&ran]() { ran++; });
+        }
+        std::thread releaser([&release]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            release = true;
+        });
+        scheduler.Shutdown();
+        releaser.join();
+    }
+    CHECK(ran.load() == 0);
+}
+
+// Every item runs once, from outside, from inside tasks, and with no
+// workers left
+void TestParallelFor() {
+    TaskScheduler scheduler(4);
+    std::vector<std::atomic<int>> runs(100000);
+    for (auto& run : runs) run = 0;
+    scheduler.ParallelFor(runs.size(), [&runs](size_t i) { runs[i]++; });
+    bool once = true;
+    for (auto& run : runs) once = once && run.load() == 1;
+    CHECK(once);
+
+    // Nested loops from every worker at once cannot starve each other
+    std::atomic<size_t> inner{ 0 };
+    scheduler.ParallelFor(16, [&scheduler, &inner](size_t) {
+        scheduler.ParallelFor(1000, [&inner](size_t) { inner++; }, TaskPriority::High);
+    });
+    CHECK(inner.load() == 16000);
+
+    // The first exception reaches the caller after the other items ran
+    std::atomic<size_t> ran{ 0 };
+    bool caught = false;
+    try {
+        scheduler.ParallelFor(1000, [&ran](size_t i) {
+            ran++;
+            if (i == 500) throw std::runtime_error("item failed");
+        });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    CHECK(caught && ran.load() == 1000);
+
+    scheduler.Shutdown();
+    size_t count = 0;
+    scheduler.ParallelFor(100, [&count](size_t) { count++; });
+    CHECK(count == 100);
+    scheduler.ParallelFor(0, [&count](size_t) { count++; });
+    CHECK(count == 100);
+}
+
+// Tasks still queued when their owner closes the group do nothing, and
+// Close() waits for the ones running
+void TestTaskGroup() {
+    TaskScheduler scheduler(2);
+    auto group = std::make_shared<TaskGroup>();
+    std::atomic<bool> closed{ false };
+    std::atomic<int> ran{ 0 };
+    std::atomic<int> lateRuns{ 0 };
+    for (int i = 0; i < 1000; i++) {
+        scheduler.Submit([group, &closed, &ran, &lateRuns]() {
+            group->Run([&]() {
+                if (closed.load()) lateRuns++;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                ran++;
+            });
+        });
+    }
+    while (ran.load() == 0) std::this_thread::yield();
+    group->Close();
+    closed = true;
+    scheduler.WaitIdle();
+    CHECK(lateRuns.load() == 0);
+    CHECK(ran.load() > 0 && ran.load() < 1000);
+    CHECK(!group->Run([]() {}));
+}
+
+} // anonymous namespace
+
+int main() {
+    TestConcurrentSubmit();
+    TestNestedFanOut();
+    TestCancellation();
+    TestPriorityOrder();
+    TestUiContinuations();
+    TestShutdownUnderLoad();
+    TestLazyStartAndDestroy();
+    TestParallelFor();
+    TestTaskGroup();
+
+    if (g_failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("TaskScheduler tests passed\n");
+    return 0;
+}